@@ -27,6 +27,7 @@
 #define ___VBox_vmm_dbgftrace_h
 
 #include <iprt/trace.h>
+#include <iprt/assert.h>
 #include <VBox/types.h>
 
 RT_C_DECLS_BEGIN
@@ -137,6 +138,119 @@ VMMDECL(int) DBGFR3TraceConfig(PVM pVM, const char *pszConfig);
 /** @} */
 
 
+/** @name Exit Tracing
+ *
+ * Binary per virtual CPU ring buffers recording VM exits and their handling
+ * (HM exits, IEM execution, IOM port and MMIO accesses).  Enabled by the
+ * /DBGF/ExitTrace/Enabled CFGM key, toggled at runtime using the 'exit' trace
+ * point group and dumped to a file by DBGFR3ExitTraceDump.
+ * @{
+ */
+
+/**
+ * Exit trace event source.
+ */
+typedef enum DBGFEXITSRC
+{
+    DBGFEXITSRC_INVALID = 0,
+    /** VT-x VM-exit, uReason is the basic exit reason. */
+    DBGFEXITSRC_HM_VMX,
+    /** AMD-V \#VMEXIT, uReason is the (truncated) exit code. */
+    DBGFEXITSRC_HM_SVM,
+    /** IEM instruction execution, uReason is the number of instructions. */
+    DBGFEXITSRC_IEM,
+    /** I/O port read, uAddr is the port, uReason the access size. */
+    DBGFEXITSRC_IOM_PORT_READ,
+    /** I/O port write, uAddr is the port, uReason the access size. */
+    DBGFEXITSRC_IOM_PORT_WRITE,
+    /** MMIO read, uAddr is the guest physical address, uReason the access size. */
+    DBGFEXITSRC_IOM_MMIO_READ,
+    /** MMIO write, uAddr is the guest physical address, uReason the access size. */
+    DBGFEXITSRC_IOM_MMIO_WRITE,
+    /** The end of valid sources. */
+    DBGFEXITSRC_END
+} DBGFEXITSRC;
+
+/**
+ * Exit trace entry.
+ */
+typedef struct DBGFEXITTRACEENTRY
+{
+    /** The host TSC when the handling started. */
+    uint64_t        u64Tsc;
+    /** The guest RIP (best effort, it may be stale for IOM events in HM). */
+    uint64_t        uRip;
+    /** Source specific address: I/O port or guest physical MMIO address. */
+    uint64_t        uAddr;
+    /** The number of host TSC ticks spent handling it. */
+    uint32_t        cTicks;
+    /** Source specific reason, see DBGFEXITSRC. */
+    uint16_t        uReason;
+    /** The source (DBGFEXITSRC). */
+    uint8_t         enmSrc;
+    /** Reserved, MBZ. */
+    uint8_t         bReserved;
+    /** The PDM tracing ID of the device handling the access (IOM events), 0 if
+     * not applicable.  See the 'pdmtracingids' info item. */
+    uint32_t        idHandler;
+    /** Reserved, MBZ. */
+    uint32_t        u32Reserved;
+} DBGFEXITTRACEENTRY;
+AssertCompileSize(DBGFEXITTRACEENTRY, 40);
+/** Pointer to an exit trace entry. */
+typedef DBGFEXITTRACEENTRY *PDBGFEXITTRACEENTRY;
+/** Pointer to a const exit trace entry. */
+typedef DBGFEXITTRACEENTRY const *PCDBGFEXITTRACEENTRY;
+
+/**
+ * Exit trace dump file header.
+ *
+ * The header is followed by a DBGFEXITTRACEFILECPU record for each virtual
+ * CPU, each of which is followed by its entries in the order they completed,
+ * oldest first.  Nested events (e.g. IOM accesses made while handling a VM
+ * exit) thus precede their parent.  All fields are in host byte order.
+ */
+typedef struct DBGFEXITTRACEFILEHDR
+{
+    /** DBGFEXITTRACEFILEHDR_MAGIC. */
+    uint32_t        u32Magic;
+    /** DBGFEXITTRACEFILEHDR_VERSION. */
+    uint32_t        u32Version;
+    /** The host TSC frequency. */
+    uint64_t        u64TscHz;
+    /** The number of DBGFEXITTRACEFILECPU records. */
+    uint32_t        cCpus;
+    /** The size of an entry (sizeof(DBGFEXITTRACEENTRY)). */
+    uint32_t        cbEntry;
+    /** The VM name, zero terminated. */
+    char            szName[48];
+} DBGFEXITTRACEFILEHDR;
+AssertCompileSize(DBGFEXITTRACEFILEHDR, 72);
+/** DBGFEXITTRACEFILEHDR::u32Magic value ('DXTR'). */
+#define DBGFEXITTRACEFILEHDR_MAGIC      UINT32_C(0x52545844)
+/** DBGFEXITTRACEFILEHDR::u32Version value. */
+#define DBGFEXITTRACEFILEHDR_VERSION    UINT32_C(2)
+
+/**
+ * Per virtual CPU record in an exit trace dump file.
+ */
+typedef struct DBGFEXITTRACEFILECPU
+{
+    /** The virtual CPU ID. */
+    uint32_t        idCpu;
+    /** The number of entries following this record. */
+    uint32_t        cEntries;
+    /** The number of entries lost because the ring wrapped around. */
+    uint64_t        cLost;
+} DBGFEXITTRACEFILECPU;
+AssertCompileSize(DBGFEXITTRACEFILECPU, 16);
+
+VMM_INT_DECL(void)  DBGFExitTraceAdd(PVMCPU pVCpu, DBGFEXITSRC enmSrc, uint32_t uReason, uint64_t uRip, uint64_t uAddr,
+                                     uint32_t idHandler, uint64_t u64TscStart);
+VMMR3DECL(int)      DBGFR3ExitTraceDump(PVM pVM, const char *pszFilename);
+/** @} */
+
+
 /** @} */
 RT_C_DECLS_END
 
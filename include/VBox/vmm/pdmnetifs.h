@@ -320,6 +320,33 @@ typedef struct PDMINETWORKUP
      */
     DECLR3CALLBACKMEMBER(void, pfnNotifyLinkChanged,(PPDMINETWORKUP pInterface, PDMNETWORKLINKSTATE enmLinkState));
 
+    /**
+     * Send a frame described by a caller owned scatter/gather buffer.
+     *
+     * Optional, NULL if not implemented.  This lets a device pass a frame with
+     * segments pointing straight at guest memory instead of copying it into a
+     * buffer from PDMINETWORKUP::pfnAllocBuf.  The segments are read-only and
+     * only valid for the duration of the call.  For GSO frames
+     * (PDMSCATTERGATHER::pvUser points to the GSO context) the first segment
+     * holds all the headers (PDMNETWORKGSO::cbHdrsTotal).
+     *
+     * @retval  VINF_SUCCESS on success.
+     * @retval  VERR_TRY_AGAIN if the frame cannot be taken right now, the caller
+     *          should fall back on PDMINETWORKUP::pfnAllocBuf.  Nothing has been
+     *          sent.
+     * @retval  VERR_NET_DOWN if the NIC is not connected to a network.
+     *
+     * @param   pInterface      Pointer to the interface structure containing the
+     *                          called function pointer.
+     * @param   pSgBuf          The frame.  Stays owned by the caller.
+     * @param   fOnWorkerThread Set if we're being called on a work thread.  Clear
+     *                          if an EMT.
+     *
+     * @thread  Any, but normally EMT or the XMIT thread.  Must be called within a
+     *          PDMINETWORKUP::pfnBeginXmit / PDMINETWORKUP::pfnEndXmit session.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnSendSg,(PPDMINETWORKUP pInterface, PPDMSCATTERGATHER pSgBuf, bool fOnWorkerThread));
+
     /** @todo Add a callback that informs the driver chain about MAC address changes if we ever implement that.  */
 
 } PDMINETWORKUP;
@@ -340,6 +367,8 @@ typedef struct PDMINETWORKUPR0
     DECLR0CALLBACKMEMBER(void, pfnEndXmit,(PPDMINETWORKUPR0 pInterface));
     /** @copydoc PDMINETWORKUP::pfnSetPromiscuousMode */
     DECLR0CALLBACKMEMBER(void, pfnSetPromiscuousMode,(PPDMINETWORKUPR0 pInterface, bool fPromiscuous));
+    /** @copydoc PDMINETWORKUP::pfnSendSg */
+    DECLR0CALLBACKMEMBER(int,  pfnSendSg,(PPDMINETWORKUPR0 pInterface, PPDMSCATTERGATHER pSgBuf, bool fOnWorkerThread));
 } PDMINETWORKUPR0;
 
 /** Raw-mode context edition of PDMINETWORKUP. */
@@ -358,12 +387,187 @@ typedef struct PDMINETWORKUPRC
     DECLRCCALLBACKMEMBER(void, pfnEndXmit,(PPDMINETWORKUPRC pInterface));
     /** @copydoc PDMINETWORKUP::pfnSetPromiscuousMode */
     DECLRCCALLBACKMEMBER(void, pfnSetPromiscuousMode,(PPDMINETWORKUPRC pInterface, bool fPromiscuous));
+    /** @copydoc PDMINETWORKUP::pfnSendSg */
+    DECLRCCALLBACKMEMBER(int,  pfnSendSg,(PPDMINETWORKUPRC pInterface, PPDMSCATTERGATHER pSgBuf, bool fOnWorkerThread));
 } PDMINETWORKUPRC;
 
 /** PDMINETWORKUP interface ID. */
-#define PDMINETWORKUP_IID                       "67e7e7a8-2594-4649-a1e3-7cee680c6083"
+#define PDMINETWORKUP_IID                       "2cd34a16-874b-451b-bd44-22b69a497595"
 /** PDMINETWORKUP interface method names. */
-#define PDMINETWORKUP_SYM_LIST                  "BeginXmit;AllocBuf;FreeBuf;SendBuf;EndXmit;SetPromiscuousMode"
+#define PDMINETWORKUP_SYM_LIST                  "BeginXmit;AllocBuf;FreeBuf;SendBuf;EndXmit;SetPromiscuousMode;SendSg"
+
+
+/**
+ * Guest memory translation for PDMINETWORKVHOST::pfnStart.
+ */
+typedef struct PDMNETVHOSTMEMREGION
+{
+    /** The guest physical address of the region. */
+    RTGCPHYS        GCPhys;
+    /** The size of the region in bytes. */
+    uint64_t        cb;
+    /** Where the region is mapped in the VM process. */
+    RTR3PTR         pvR3;
+} PDMNETVHOSTMEMREGION;
+/** Pointer to a guest memory region description. */
+typedef PDMNETVHOSTMEMREGION *PPDMNETVHOSTMEMREGION;
+/** Pointer to a const guest memory region description. */
+typedef PDMNETVHOSTMEMREGION const *PCPDMNETVHOSTMEMREGION;
+
+/**
+ * Virtqueue description for PDMINETWORKVHOST::pfnStart.
+ */
+typedef struct PDMNETVHOSTRING
+{
+    /** The number of descriptors in the ring. */
+    uint32_t        cEntries;
+    /** The index of the next available descriptor to process. */
+    uint16_t        idxAvail;
+    uint16_t        u16Reserved;
+    /** The guest physical address of the descriptor table. */
+    RTGCPHYS        GCPhysDesc;
+    /** The guest physical address of the available ring. */
+    RTGCPHYS        GCPhysAvail;
+    /** The guest physical address of the used ring. */
+    RTGCPHYS        GCPhysUsed;
+} PDMNETVHOSTRING;
+/** Pointer to a virtqueue description. */
+typedef PDMNETVHOSTRING *PPDMNETVHOSTRING;
+/** Pointer to a const virtqueue description. */
+typedef PDMNETVHOSTRING const *PCPDMNETVHOSTRING;
+
+/** Pointer to a kernel virtqueue offload interface. */
+typedef struct PDMINETWORKVHOST *PPDMINETWORKVHOST;
+/**
+ * Kernel virtqueue offload interface (up), e.g. Linux vhost-net.
+ *
+ * Optionally exported by network transport drivers that can hand the data
+ * rings of a virtio network device to the host kernel.  While the offload is
+ * active the driver does not deliver frames through PDMINETWORKDOWN and the
+ * device does not touch the data rings itself; it only forwards guest queue
+ * notifications (pfnKick) and turns completions (pfnWaitInterrupt) into guest
+ * interrupts.
+ *
+ * The kernel addresses guest memory by guest physical address and asks for
+ * translations as it goes (pfnWaitInterrupt returns a miss, the device answers
+ * with pfnMap), so the device only has to keep the pages mapped which the
+ * kernel actually uses.
+ */
+typedef struct PDMINETWORKVHOST
+{
+    /**
+     * Gets the virtio feature bits the kernel side can handle.
+     *
+     * @returns VBox status code.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   pfFeatures      Where to return the feature bits.
+     * @thread  EMT
+     */
+    DECLR3CALLBACKMEMBER(int, pfnGetFeatures,(PPDMINETWORKVHOST pInterface, uint64_t *pfFeatures));
+
+    /**
+     * Hands the rings to the kernel.
+     *
+     * The driver stops delivering received frames before this returns.  The
+     * virtio-net header is added and stripped by the kernel side, so frames
+     * exchanged with the host carry no offload information.
+     *
+     * @returns VBox status code.  On failure the offload is not active and the
+     *          caller continues to service the rings itself.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   fFeatures       The negotiated feature bits, a subset of what
+     *                          pfnGetFeatures returned.
+     * @param   paRegions       Initial translations, must cover the rings.  Must
+     *                          remain mapped until pfnStop returns or they are
+     *                          withdrawn by pfnUnmap.
+     * @param   cRegions        Number of translations.
+     * @param   paRings         The rings (receive queue first, then transmit).
+     * @param   cRings          Number of rings.
+     * @thread  EMT
+     */
+    DECLR3CALLBACKMEMBER(int, pfnStart,(PPDMINETWORKVHOST pInterface, uint64_t fFeatures,
+                                        PCPDMNETVHOSTMEMREGION paRegions, uint32_t cRegions,
+                                        PCPDMNETVHOSTRING paRings, uint32_t cRings));
+
+    /**
+     * Takes the rings back from the kernel and resumes normal operation.
+     *
+     * @returns VBox status code.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   paidxAvail      Where to return the index of the next available
+     *                          descriptor for each ring.
+     * @param   cRings          Number of rings, same as passed to pfnStart.
+     * @thread  EMT
+     */
+    DECLR3CALLBACKMEMBER(int, pfnStop,(PPDMINETWORKVHOST pInterface, uint16_t *paidxAvail, uint32_t cRings));
+
+    /**
+     * Forwards a guest queue notification to the kernel.
+     *
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   iRing           The ring index.
+     * @thread  EMT
+     */
+    DECLR3CALLBACKMEMBER(void, pfnKick,(PPDMINETWORKVHOST pInterface, uint32_t iRing));
+
+    /**
+     * Gives the kernel a translation, usually in answer to a miss reported by
+     * pfnWaitInterrupt.
+     *
+     * @returns VBox status code.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   GCPhys          The guest physical address, page aligned.
+     * @param   cb              The size of the range, page aligned.
+     * @param   pvR3            Where the range is mapped in the VM process.  Must
+     *                          remain mapped until withdrawn by pfnUnmap or until
+     *                          pfnStop returns.
+     * @thread  Any, while the offload is active.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnMap,(PPDMINETWORKVHOST pInterface, RTGCPHYS GCPhys, uint64_t cb, RTR3PTR pvR3));
+
+    /**
+     * Withdraws translations given by pfnStart or pfnMap.
+     *
+     * The kernel no longer uses the range when this returns.
+     *
+     * @returns VBox status code.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   GCPhys          The guest physical address, page aligned.
+     * @param   cb              The size of the range, page aligned.
+     * @thread  Any, while the offload is active.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnUnmap,(PPDMINETWORKVHOST pInterface, RTGCPHYS GCPhys, uint64_t cb));
+
+    /**
+     * Waits for the kernel to signal that it has put buffers into a used ring
+     * or that it needs a translation.
+     *
+     * @returns VBox status code.
+     * @retval  VERR_TIMEOUT if nothing happened within the given time.
+     * @retval  VERR_INTERRUPTED if woken up by pfnWakeupWait.
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @param   cMillies        How long to wait.
+     * @param   pfRings         Where to return the bitmap of rings needing an
+     *                          interrupt.
+     * @param   pGCPhysMiss     Where to return the guest physical address the
+     *                          kernel needs a translation for (pfnMap), set to
+     *                          NIL_RTGCPHYS if none.
+     * @thread  Any, only one at a time.
+     */
+    DECLR3CALLBACKMEMBER(int, pfnWaitInterrupt,(PPDMINETWORKVHOST pInterface, RTMSINTERVAL cMillies, uint32_t *pfRings,
+                                                PRTGCPHYS pGCPhysMiss));
+
+    /**
+     * Wakes up a thread blocking in pfnWaitInterrupt.
+     *
+     * @param   pInterface      Pointer to the interface structure containing the called function pointer.
+     * @thread  Any.
+     */
+    DECLR3CALLBACKMEMBER(void, pfnWakeupWait,(PPDMINETWORKVHOST pInterface));
+
+} PDMINETWORKVHOST;
+/** PDMINETWORKVHOST interface ID. */
+#define PDMINETWORKVHOST_IID                    "3d6b2e0a-7c41-4f1e-b5a8-92e4c07d1b6f"
 
 
 /** Pointer to a network config port interface */
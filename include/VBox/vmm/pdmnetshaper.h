@@ -58,6 +58,8 @@ typedef struct PDMNSFILTER
     bool                                afPadding[HC_ARCH_BITS == 32 ? 3 : 7];
     /** The driver this filter is aggregated into (ring-3). */
     R3PTRTYPE(PPDMINETWORKDOWN)         pIDrvNetR3;
+    /** Timestamp (RTTimeSystemNanoTS) of when the filter got choked. */
+    volatile uint64_t                   tsChoked;
 } PDMNSFILTER;
 
 /** Pointer to a PDM filter handle. */
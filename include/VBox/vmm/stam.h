@@ -28,6 +28,7 @@
 
 #include <VBox/types.h>
 #include <iprt/stdarg.h>
+#include <iprt/assert.h>
 #ifdef _MSC_VER
 # if _MSC_VER >= 1400
 #  include <intrin.h>
@@ -1232,6 +1233,99 @@ typedef FNSTAMR3ENUM *PFNSTAMR3ENUM;
 
 VMMR3DECL(int)  STAMR3Enum(PUVM pUVM, const char *pszPat, PFNSTAMR3ENUM pfnEnum, void *pvUser);
 VMMR3DECL(const char *) STAMR3GetUnit(STAMUNIT enmUnit);
+VMMR3_INT_DECL(int) STAMR3InitCompleted(PVM pVM);
+
+
+/** @defgroup grp_stam_r3_bin   Binary Snapshots and Export
+ * @ingroup grp_stam_r3
+ *
+ * A binary snapshot is a flat array of 64-bit sample values laid out once
+ * for a sample pattern.  Taking a snapshot just copies the values, so it is
+ * cheap enough to be done every second on every VM.  Counters, U8-U64, X8-X64
+ * and booleans take one value, ratios two (A, B) and profiles four (cPeriods,
+ * cTicks, cTicksMin, cTicksMax).  Callback samples are not included.
+ *
+ * The layout is redone transparently when samples are registered or
+ * deregistered, the caller can detect this by checking the layout
+ * generation returned by STAMR3BinSnapshotGetLayout.
+ * @{ */
+
+/** Pointer to a binary snapshot. */
+typedef struct STAMBINSNAPSHOT *PSTAMBINSNAPSHOT;
+
+/**
+ * Binary snapshot sample layout entry.
+ */
+typedef struct STAMBINSAMPLE
+{
+    /** The sample name. */
+    const char     *pszName;
+    /** The sample type. */
+    STAMTYPE        enmType;
+    /** The sample unit. */
+    STAMUNIT        enmUnit;
+    /** Index of the first value in the value array. */
+    uint32_t        iFirstValue;
+    /** Number of values. */
+    uint32_t        cValues;
+} STAMBINSAMPLE;
+/** Pointer to a const binary snapshot sample layout entry. */
+typedef STAMBINSAMPLE const *PCSTAMBINSAMPLE;
+
+VMMR3DECL(int)      STAMR3BinSnapshotCreate(PUVM pUVM, const char *pszPat, PSTAMBINSNAPSHOT *ppSnapshot);
+VMMR3DECL(int)      STAMR3BinSnapshotDestroy(PSTAMBINSNAPSHOT pSnapshot);
+VMMR3DECL(int)      STAMR3BinSnapshotTake(PSTAMBINSNAPSHOT pSnapshot, bool fUpdateRing0);
+VMMR3DECL(uint32_t) STAMR3BinSnapshotGetLayout(PSTAMBINSNAPSHOT pSnapshot, PCSTAMBINSAMPLE *ppaSamples, uint32_t *pcSamples);
+VMMR3DECL(uint64_t const *) STAMR3BinSnapshotGetValues(PSTAMBINSNAPSHOT pSnapshot, uint32_t *pcValues, uint64_t *pu64NanoTS);
+
+
+/** Magic of the STAMEXPORTHDR records ('STMX'). */
+#define STAMEXPORT_MAGIC            UINT32_C(0x584d5453)
+/** The current export stream version. */
+#define STAMEXPORT_VERSION          1
+
+/**
+ * Export stream record types.
+ */
+typedef enum STAMEXPORTREC
+{
+    /** Invalid zero value. */
+    STAMEXPORTREC_INVALID = 0,
+    /** Layout record: uint32_t cSamples, uint32_t cValues, then for each
+     * sample uint8_t enmType, uint8_t enmUnit, uint16_t cValues,
+     * uint16_t cchName and the name without a terminator. */
+    STAMEXPORTREC_LAYOUT,
+    /** Values record: uint32_t cChanged followed by cChanged pairs of
+     * uint32_t iValue and uint64_t u64Value (unaligned).  The first values
+     * record after a layout record contains all values, the following ones
+     * only those which changed. */
+    STAMEXPORTREC_VALUES
+} STAMEXPORTREC;
+
+/**
+ * Export stream record header (little endian).
+ */
+typedef struct STAMEXPORTHDR
+{
+    /** STAMEXPORT_MAGIC. */
+    uint32_t        u32Magic;
+    /** STAMEXPORT_VERSION. */
+    uint16_t        uVersion;
+    /** The record type (STAMEXPORTREC). */
+    uint16_t        uType;
+    /** The record size including this header. */
+    uint32_t        cbRecord;
+    /** Record sequence number. */
+    uint32_t        uSeq;
+    /** RTTimeNanoTS() when the values were taken. */
+    uint64_t        u64NanoTS;
+} STAMEXPORTHDR;
+AssertCompileSize(STAMEXPORTHDR, 24);
+
+VMMR3DECL(int)      STAMR3ExportStart(PUVM pUVM, const char *pszDest, const char *pszPat, uint32_t cMsInterval);
+VMMR3DECL(int)      STAMR3ExportStop(PUVM pUVM);
+
+/** @} */
 
 /** @} */
 
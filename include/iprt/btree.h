@@ -0,0 +1,98 @@
+/** @file
+ * IPRT - B+ Trees.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+#ifndef ___iprt_btree_h
+#define ___iprt_btree_h
+
+#include <iprt/cdefs.h>
+#include <iprt/types.h>
+#include <iprt/avl.h>
+
+RT_C_DECLS_BEGIN
+
+/** @defgroup grp_rt_btree  RTBTree - B+ Trees
+ * @ingroup grp_rt
+ *
+ * The B+ trees are an alternative to the AVL trees for large and hot
+ * collections.  The keys, the key ranges and the node pointers are kept in
+ * wide leaf nodes, so a lookup touches a handful of cache lines per level
+ * and never the user nodes it doesn't return, unlike the AVL trees where
+ * every step of the search dereferences another user node.
+ *
+ * The user nodes are the same as for the corresponding AVL trees, so a
+ * collection can be switched over by changing the tree member and the
+ * function prefix.  The differences are that the tree must be initialized
+ * and destroyed, and that insertion can fail for lack of memory as the
+ * tree allocates its own interior and leaf nodes.
+ *
+ * The trees are not thread safe, the caller must serialize access.
+ *
+ * @{
+ */
+
+
+/** B+ tree of uint64_t ranges.
+ * @{
+ */
+
+/**
+ * B+ tree of uint64_t ranges, a drop-in alternative to AVLRU64TREE.
+ */
+typedef struct RTBTREERU64
+{
+    /** The root node (leaf if cHeight is zero), NULL if empty. */
+    void           *pvRoot;
+    /** The number of interior node levels above the leaves. */
+    uint32_t        cHeight;
+    /** The number of user nodes in the tree. */
+    uint32_t        cNodes;
+} RTBTREERU64;
+/** Pointer to a B+ tree of uint64_t ranges. */
+typedef RTBTREERU64 *PRTBTREERU64;
+
+/** Static initializer for RTBTREERU64. */
+#define RTBTREERU64_INITIALIZER     { NULL, 0, 0 }
+
+/*
+ * Functions.
+ */
+RTDECL(void)             RTBTreeRU64Init(PRTBTREERU64 pTree);
+RTDECL(bool)             RTBTreeRU64Insert(PRTBTREERU64 pTree, PAVLRU64NODECORE pNode);
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64Remove(PRTBTREERU64 pTree, AVLRU64KEY Key);
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64Get(PRTBTREERU64 pTree, AVLRU64KEY Key);
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64RangeGet(PRTBTREERU64 pTree, AVLRU64KEY Key);
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64RangeRemove(PRTBTREERU64 pTree, AVLRU64KEY Key);
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64GetBestFit(PRTBTREERU64 pTree, AVLRU64KEY Key, bool fAbove);
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64RemoveBestFit(PRTBTREERU64 pTree, AVLRU64KEY Key, bool fAbove);
+RTDECL(int)              RTBTreeRU64DoWithAll(PRTBTREERU64 pTree, int fFromLeft, PAVLRU64CALLBACK pfnCallBack, void *pvParam);
+RTDECL(int)              RTBTreeRU64Destroy(PRTBTREERU64 pTree, PAVLRU64CALLBACK pfnCallBack, void *pvParam);
+
+/** @} */
+
+/** @} */
+
+RT_C_DECLS_END
+
+#endif
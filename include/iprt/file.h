@@ -1039,6 +1039,90 @@ RTDECL(void) RTFileReadAllFree(void *pvFile, size_t cbFile);
 
 #ifdef IN_RING3
 
+/** @name RTFileMap flags
+ * @{ */
+/** Read-only mapping, the file must be open for reading. */
+#define RTFILEMAP_F_READ                    RT_BIT_32(0)
+/** Private copy-on-write mapping.  The memory is writable, but the changes
+ * are never written back to the file nor seen by other mappings of it. */
+#define RTFILEMAP_F_COPY_ON_WRITE           RT_BIT_32(1)
+/** Mask of valid flags. */
+#define RTFILEMAP_F_VALID_MASK              UINT32_C(0x00000003)
+/** @} */
+
+/**
+ * Access pattern advice for RTFileMapAdvise.
+ */
+typedef enum RTFILEMAPADVICE
+{
+    /** Invalid zero value. */
+    RTFILEMAPADVICE_INVALID = 0,
+    /** No particular pattern, the default read-ahead. */
+    RTFILEMAPADVICE_NORMAL,
+    /** The range will be accessed sequentially, read ahead aggressively and
+     * drop pages soon after they've been accessed. */
+    RTFILEMAPADVICE_SEQUENTIAL,
+    /** The range will be accessed randomly, don't read ahead. */
+    RTFILEMAPADVICE_RANDOM,
+    /** The range will be accessed soon, start reading it in. */
+    RTFILEMAPADVICE_WILL_NEED,
+    /** The range won't be accessed for a while, the pages can be dropped.
+     * Note that this discards any changes made to copy-on-write mappings. */
+    RTFILEMAPADVICE_DONT_NEED,
+    /** End of valid values. */
+    RTFILEMAPADVICE_END,
+    /** Blow the type up to 32-bit. */
+    RTFILEMAPADVICE_32BIT_HACK = 0x7fffffff
+} RTFILEMAPADVICE;
+
+/**
+ * Maps a part of a file into memory.
+ *
+ * Unlike RTFileReadAllByHandleEx this doesn't copy anything, the pages are
+ * read in on demand as they're touched and shared with the page cache.  The
+ * file handle can be closed after the call, the mapping keeps its own
+ * reference to the file.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_OUT_OF_RANGE if the range extends beyond the end of the file.
+ * @retval  VERR_NOT_SUPPORTED if the host or file doesn't support mapping.
+ *
+ * @param   hFile           The file handle.
+ * @param   off             The file offset of the range.  No alignment
+ *                          requirements, the mapping is done at the page (or
+ *                          allocation granularity) below it.
+ * @param   cb              The size of the range, must be non-zero.
+ * @param   fFlags          Either RTFILEMAP_F_READ or
+ *                          RTFILEMAP_F_COPY_ON_WRITE.
+ * @param   ppv             Where to return the address corresponding to @a off.
+ *
+ * @remarks Touching mapped memory beyond the end of a file that was truncated
+ *          after the call will raise a signal / exception, so only map files
+ *          that won't be changing under your feet.
+ */
+RTDECL(int) RTFileMap(RTFILE hFile, RTFOFF off, size_t cb, uint32_t fFlags, void **ppv);
+
+/**
+ * Unmaps a range mapped by RTFileMap.
+ *
+ * @returns IPRT status code.
+ * @param   pv              The address returned by RTFileMap.  NULL is ignored.
+ * @param   cb              The size passed to RTFileMap.
+ */
+RTDECL(int) RTFileUnmap(void *pv, size_t cb);
+
+/**
+ * Tells the host how a mapped range is going to be accessed.
+ *
+ * This is a hint only, hosts without the facility return VINF_SUCCESS.
+ *
+ * @returns IPRT status code.
+ * @param   pv              Address within a range returned by RTFileMap.
+ * @param   cb              The size of the range to advise about.
+ * @param   enmAdvice       The advice.
+ */
+RTDECL(int) RTFileMapAdvise(void *pv, size_t cb, RTFILEMAPADVICE enmAdvice);
+
 /** @page pg_rt_asyncio RT File async I/O API
  *
  * File operations are usually blocking the calling thread until
@@ -1132,7 +1216,11 @@ RTDECL(void) RTFileReadAllFree(void *pvFile, size_t cbFile);
  * Furthermore there is no filesystem independent way to discover the restrictions at least
  * for the 2.4 kernel series. Since 2.6 the 512 byte boundary seems to be used by all
  * file systems. So Linus comment about this flag is comprehensible but Linux
- * lacks an alternative at the moment.
+ * lacks an alternative at the moment. RTFILE_O_ASYNC_IO therefore implies O_DIRECT
+ * on Linux. Kernels with io_uring support (5.4 and later) also handle files opened
+ * without it (and without RTFILE_O_NO_CACHE) asynchronously, which is reported by
+ * RTFILEAIOLIMITS_F_BUFFERED. Such files go through the host cache and have no
+ * alignment restrictions.
  *
  * The next limitation applies only to Windows. Requests are not associated with the
  * I/O context they are associated with but with the file the request is for.
@@ -1159,10 +1247,22 @@ typedef struct RTFILEAIOLIMITS
     /** The alignment data buffers need to have.
      * 0 means no alignment restrictions. */
     uint32_t cbBufferAlignment;
+    /** Combination of RTFILEAIOLIMITS_F_XXX. */
+    uint32_t fFlags;
 } RTFILEAIOLIMITS;
 /** A pointer to a AIO limits structure. */
 typedef RTFILEAIOLIMITS *PRTFILEAIOLIMITS;
 
+/** @name RTFILEAIOLIMITS::fFlags
+ * @{ */
+/** Files opened without RTFILE_O_ASYNC_IO are processed asynchronously too,
+ * using the host cache and without alignment restrictions.  Only set on hosts
+ * where RTFILE_O_ASYNC_IO implies bypassing the cache (Linux with io_uring).
+ * A context whose setup has to fall back to the legacy interface still
+ * completes such requests, but synchronously during submit. */
+#define RTFILEAIOLIMITS_F_BUFFERED      RT_BIT_32(0)
+/** @} */
+
 /**
  * Returns the global limits for the AIO API.
  *
@@ -1225,6 +1325,46 @@ RTDECL(int) RTFileAioReqPrepareRead(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
 RTDECL(int) RTFileAioReqPrepareWrite(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
                                      void const *pvBuf, size_t cbWrite, void *pvUser);
 
+/**
+ * Prepares an async scatter read request.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_FILE_AIO_IN_PROGRESS if the request is still in progress.
+ * @retval  VERR_NOT_SUPPORTED if the host can't do vectored async I/O and more
+ *          than one segment was given.
+ *
+ * @param   hReq            The request handle.
+ * @param   hFile           The file to read from.
+ * @param   off             The offset to start reading at.
+ * @param   paSegs          The segments to read into.  The array is copied, the
+ *                          buffers must stay valid until the request completed.
+ * @param   cSegs           Number of segments.
+ * @param   pvUser          Opaque user data associated with this request which
+ *                          can be retrieved with RTFileAioReqGetUser().
+ */
+RTDECL(int) RTFileAioReqPrepareReadSg(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
+                                      PCRTSGSEG paSegs, unsigned cSegs, void *pvUser);
+
+/**
+ * Prepares an async gather write request.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_FILE_AIO_IN_PROGRESS if the request is still in progress.
+ * @retval  VERR_NOT_SUPPORTED if the host can't do vectored async I/O and more
+ *          than one segment was given.
+ *
+ * @param   hReq            The request handle.
+ * @param   hFile           The file to write to.
+ * @param   off             The offset to start writing at.
+ * @param   paSegs          The segments to write.  The array is copied, the
+ *                          buffers must stay valid until the request completed.
+ * @param   cSegs           Number of segments.
+ * @param   pvUser          Opaque user data associated with this request which
+ *                          can be retrieved with RTFileAioReqGetUser().
+ */
+RTDECL(int) RTFileAioReqPrepareWriteSg(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
+                                       PCRTSGSEG paSegs, unsigned cSegs, void *pvUser);
+
 /**
  * Prepares an async flush of all cached data associated with a file handle.
  *
@@ -1260,6 +1400,10 @@ RTDECL(void *) RTFileAioReqGetUser(RTFILEAIOREQ hReq);
  * @retval  VERR_FILE_AIO_COMPLETED   If the request could not be canceled because it already completed.
  *
  * @param   hReq            The request to cancel.
+ *
+ * @remarks Requests submitted to an io_uring context on Linux can't be
+ *          canceled, VERR_FILE_AIO_IN_PROGRESS is always returned for them and
+ *          the request completes normally through RTFileAioCtxWait().
  */
 RTDECL(int) RTFileAioReqCancel(RTFILEAIOREQ hReq);
 
@@ -1422,4 +1566,3 @@ RTDECL(int) RTFileAioCtxWakeup(RTFILEAIOCTX hAioCtx);
 RT_C_DECLS_END
 
 #endif
-
@@ -360,6 +360,9 @@ typedef enum RTLOGFLAGS
     RTLOGFLAGS_FLUSH                = 0x00000200,
     /** Restrict the number of log entries per group. */
     RTLOGFLAGS_RESTRICT_GROUPS      = 0x00000400,
+    /** Hand formatted messages to a background writer thread instead of
+     * writing them out on the calling thread (ring-3 only). */
+    RTLOGFLAGS_ASYNC                = 0x00000800,
     /** New lines should be prefixed with the write and read lock counts. */
     RTLOGFLAGS_PREFIX_LOCK_COUNTS   = 0x00008000,
     /** New lines should be prefixed with the CPU id (ApicID on intel/amd). */
@@ -1733,11 +1736,43 @@ RTDECL(int) RTLogDestinations(PRTLOGGER pLogger, char const *pszValue);
  *                              than 0.
  */
 RTDECL(int) RTLogGetDestinations(PRTLOGGER pLogger, char *pszBuf, size_t cchBuf);
+
+/**
+ * Statistics for a logger running in asynchronous mode (RTLOGFLAGS_ASYNC).
+ */
+typedef struct RTLOGASYNCSTATS
+{
+    /** Number of messages queued to the writer thread. */
+    uint64_t        cQueued;
+    /** Number of queued messages the writer has passed on to the destinations. */
+    uint64_t        cWritten;
+    /** Number of messages dropped because the producer buffer was full. */
+    uint64_t        cDropped;
+    /** Number of messages which had to take the synchronous path while
+     * asynchronous mode was enabled (too large, restricted groups, ...). */
+    uint64_t        cSynchronous;
+} RTLOGASYNCSTATS;
+/** Pointer to asynchronous logging statistics. */
+typedef RTLOGASYNCSTATS *PRTLOGASYNCSTATS;
+
+/**
+ * Queries the asynchronous logging statistics of a logger.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_NOT_SUPPORTED if not in ring-3.
+ * @param   pLogger             Logger instance (NULL for default logger).
+ * @param   pStats              Where to return the statistics.  All zero if
+ *                              asynchronous mode was never activated.
+ */
+RTDECL(int) RTLogQueryAsyncStats(PRTLOGGER pLogger, PRTLOGASYNCSTATS pStats);
 #endif /* !IN_RC */
 
 /**
  * Flushes the specified logger.
  *
+ * In asynchronous mode this also writes out everything queued for the
+ * background writer before returning.
+ *
  * @param   pLogger     The logger instance to flush.
  *                      If NULL the default instance is used. The default instance
  *                      will not be initialized by this call.
@@ -272,6 +272,16 @@
 # define RTAvlULInsert                                  RT_MANGLER(RTAvlULInsert)
 # define RTAvlULRemove                                  RT_MANGLER(RTAvlULRemove)
 # define RTAvlULRemoveBestFit                           RT_MANGLER(RTAvlULRemoveBestFit)
+# define RTBTreeRU64Destroy                             RT_MANGLER(RTBTreeRU64Destroy)
+# define RTBTreeRU64DoWithAll                           RT_MANGLER(RTBTreeRU64DoWithAll)
+# define RTBTreeRU64Get                                 RT_MANGLER(RTBTreeRU64Get)
+# define RTBTreeRU64GetBestFit                          RT_MANGLER(RTBTreeRU64GetBestFit)
+# define RTBTreeRU64Init                                RT_MANGLER(RTBTreeRU64Init)
+# define RTBTreeRU64Insert                              RT_MANGLER(RTBTreeRU64Insert)
+# define RTBTreeRU64RangeGet                            RT_MANGLER(RTBTreeRU64RangeGet)
+# define RTBTreeRU64RangeRemove                         RT_MANGLER(RTBTreeRU64RangeRemove)
+# define RTBTreeRU64Remove                              RT_MANGLER(RTBTreeRU64Remove)
+# define RTBTreeRU64RemoveBestFit                       RT_MANGLER(RTBTreeRU64RemoveBestFit)
 # define RTBase64Decode                                 RT_MANGLER(RTBase64Decode)
 # define RTBase64DecodeEx                               RT_MANGLER(RTBase64DecodeEx)
 # define RTBase64DecodedSize                            RT_MANGLER(RTBase64DecodedSize)
@@ -546,7 +556,9 @@
 # define RTFileAioReqGetUser                            RT_MANGLER(RTFileAioReqGetUser)
 # define RTFileAioReqPrepareFlush                       RT_MANGLER(RTFileAioReqPrepareFlush)
 # define RTFileAioReqPrepareRead                        RT_MANGLER(RTFileAioReqPrepareRead)
+# define RTFileAioReqPrepareReadSg                      RT_MANGLER(RTFileAioReqPrepareReadSg)
 # define RTFileAioReqPrepareWrite                       RT_MANGLER(RTFileAioReqPrepareWrite)
+# define RTFileAioReqPrepareWriteSg                     RT_MANGLER(RTFileAioReqPrepareWriteSg)
 # define RTFileChangeLock                               RT_MANGLER(RTFileChangeLock)
 # define RTFileClose                                    RT_MANGLER(RTFileClose)
 # define RTFileCompare                                  RT_MANGLER(RTFileCompare)
@@ -569,6 +581,8 @@
 # define RTFileIoCtl                                    RT_MANGLER(RTFileIoCtl)
 # define RTFileIsValid                                  RT_MANGLER(RTFileIsValid)
 # define RTFileLock                                     RT_MANGLER(RTFileLock)
+# define RTFileMap                                      RT_MANGLER(RTFileMap)
+# define RTFileMapAdvise                                RT_MANGLER(RTFileMapAdvise)
 # define RTFileModeToFlags                              RT_MANGLER(RTFileModeToFlags)
 # define RTFileModeToFlagsEx                            RT_MANGLER(RTFileModeToFlagsEx)
 # define RTFileMove                                     RT_MANGLER(RTFileMove)
@@ -598,6 +612,7 @@
 # define RTFileTell                                     RT_MANGLER(RTFileTell)
 # define RTFileToNative                                 RT_MANGLER(RTFileToNative)
 # define RTFileUnlock                                   RT_MANGLER(RTFileUnlock)
+# define RTFileUnmap                                    RT_MANGLER(RTFileUnmap)
 # define RTFileWrite                                    RT_MANGLER(RTFileWrite)
 # define RTFileWriteAt                                  RT_MANGLER(RTFileWriteAt)
 # define RTFilesystemVfsFromFile                        RT_MANGLER(RTFilesystemVfsFromFile)
@@ -794,6 +809,7 @@
 # define RTLogLoggerV                                   RT_MANGLER(RTLogLoggerV)
 # define RTLogPrintf                                    RT_MANGLER(RTLogPrintf)
 # define RTLogPrintfV                                   RT_MANGLER(RTLogPrintfV)
+# define RTLogQueryAsyncStats                           RT_MANGLER(RTLogQueryAsyncStats)
 # define RTLogDumpPrintfV                               RT_MANGLER(RTLogDumpPrintfV)
 # define RTLogRelDefaultInstance                        RT_MANGLER(RTLogRelDefaultInstance)
 # define RTLogRelLogger                                 RT_MANGLER(RTLogRelLogger)
@@ -888,13 +904,16 @@
 # define RTMemEfTmpFreeNP                               RT_MANGLER(RTMemEfTmpFreeNP)
 # define RTMemExecAllocTag                              RT_MANGLER(RTMemExecAllocTag)
 # define RTMemExecFree                                  RT_MANGLER(RTMemExecFree)
+# define RTMemFirstNonZero                              RT_MANGLER(RTMemFirstNonZero)
 # define RTMemFree                                      RT_MANGLER(RTMemFree)
 # define RTMemFreeEx                                    RT_MANGLER(RTMemFreeEx)
+# define RTMemIsZero                                    RT_MANGLER(RTMemIsZero)
 # define RTMemLockedAllocExTag                          RT_MANGLER(RTMemLockedAllocExTag)
 # define RTMemLockedAllocZExTag                         RT_MANGLER(RTMemLockedAllocZExTag)
 # define RTMemLockedAllocTag                            RT_MANGLER(RTMemLockedAllocTag)
 # define RTMemLockedAllocZTag                           RT_MANGLER(RTMemLockedAllocZTag)
 # define RTMemLockedFree                                RT_MANGLER(RTMemLockedFree)
+# define RTMemPageAllocExTag                            RT_MANGLER(RTMemPageAllocExTag)
 # define RTMemPageAllocTag                              RT_MANGLER(RTMemPageAllocTag)
 # define RTMemPageAllocZTag                             RT_MANGLER(RTMemPageAllocZTag)
 # define RTMemPageFree                                  RT_MANGLER(RTMemPageFree)
@@ -1173,6 +1192,8 @@
 # define RTRandU64                                      RT_MANGLER(RTRandU64)
 # define RTRandU64Ex                                    RT_MANGLER(RTRandU64Ex)
 # define RTReqPoolAlloc                                 RT_MANGLER(RTReqPoolAlloc)
+# define RTReqPoolCallBatch                             RT_MANGLER(RTReqPoolCallBatch)
+# define RTReqPoolCallBatchWait                         RT_MANGLER(RTReqPoolCallBatchWait)
 # define RTReqPoolCallEx                                RT_MANGLER(RTReqPoolCallEx)
 # define RTReqPoolCallExV                               RT_MANGLER(RTReqPoolCallExV)
 # define RTReqPoolCallWait                              RT_MANGLER(RTReqPoolCallWait)
@@ -1309,6 +1330,7 @@
 # define RTSha1Init                                     RT_MANGLER(RTSha1Init)
 # define RTSha1ToString                                 RT_MANGLER(RTSha1ToString)
 # define RTSha1Update                                   RT_MANGLER(RTSha1Update)
+# define RTSha1UpdateMulti                              RT_MANGLER(RTSha1UpdateMulti)
 # define RTSha224                                       RT_MANGLER(RTSha224)
 # define RTSha224Final                                  RT_MANGLER(RTSha224Final)
 # define RTSha224FromString                             RT_MANGLER(RTSha224FromString)
@@ -1323,6 +1345,7 @@
 # define RTSha256Init                                   RT_MANGLER(RTSha256Init)
 # define RTSha256ToString                               RT_MANGLER(RTSha256ToString)
 # define RTSha256Update                                 RT_MANGLER(RTSha256Update)
+# define RTSha256UpdateMulti                            RT_MANGLER(RTSha256UpdateMulti)
 # define RTSha256Digest                                 RT_MANGLER(RTSha256Digest)
 # define RTSha256DigestFromFile                         RT_MANGLER(RTSha256DigestFromFile)
 # define RTSha384                                       RT_MANGLER(RTSha384)
@@ -1374,9 +1397,16 @@
 # define RTSocketWrite                                  RT_MANGLER(RTSocketWrite)
 # define RTSocketWriteNB                                RT_MANGLER(RTSocketWriteNB)
 # define RTSocketWriteTo                                RT_MANGLER(RTSocketWriteTo)
+# define RTSort                                         RT_MANGLER(RTSort)
+# define RTSortApv                                      RT_MANGLER(RTSortApv)
 # define RTSortApvIsSorted                              RT_MANGLER(RTSortApvIsSorted)
+# define RTSortApvParallel                              RT_MANGLER(RTSortApvParallel)
 # define RTSortApvShell                                 RT_MANGLER(RTSortApvShell)
+# define RTSortApvStable                                RT_MANGLER(RTSortApvStable)
 # define RTSortIsSorted                                 RT_MANGLER(RTSortIsSorted)
+# define RTSortParallel                                 RT_MANGLER(RTSortParallel)
+# define RTSortShell                                    RT_MANGLER(RTSortShell)
+# define RTSortStable                                   RT_MANGLER(RTSortStable)
 # define RTSpinlockAcquire                              RT_MANGLER(RTSpinlockAcquire)
 # define RTSpinlockAcquireNoInts                        RT_MANGLER(RTSpinlockAcquireNoInts)
 # define RTSpinlockCreate                               RT_MANGLER(RTSpinlockCreate)
@@ -462,8 +462,54 @@ RTDECL(void *) RTMemPageAllocTag(size_t cb, const char *pszTag) RT_NO_THROW;
  */
 RTDECL(void *) RTMemPageAllocZTag(size_t cb, const char *pszTag) RT_NO_THROW;
 
+/** @name RTMemPageAllocEx and RTMemPageAllocExTag flags.
+ * @{ */
+/** The returned memory should be zeroed. */
+#define RTMEMPAGEALLOC_F_ZERO                   RT_BIT_32(0)
+/** Advise the host to back the block with large pages (transparent huge
+ * pages on Linux).  This is a hint only and is silently ignored where it
+ * isn't supported or for blocks too small to benefit from it. */
+#define RTMEMPAGEALLOC_F_ADVISE_LARGE_PAGES     RT_BIT_32(1)
+/** The block must be backed by large pages (hugetlbfs pages on Linux).  The
+ * allocation fails if the host has no large pages reserved or if the size
+ * isn't a multiple of RTMEMPAGEALLOC_LARGE_PAGE_SIZE. */
+#define RTMEMPAGEALLOC_F_LARGE_PAGES            RT_BIT_32(2)
+/** Mask of valid flags. */
+#define RTMEMPAGEALLOC_F_VALID_MASK             UINT32_C(0x00000007)
+/** @} */
+
+/** The large page size assumed by RTMEMPAGEALLOC_F_LARGE_PAGES and
+ * RTMEMPAGEALLOC_F_ADVISE_LARGE_PAGES. */
+#define RTMEMPAGEALLOC_LARGE_PAGE_SIZE          _2M
+
+/**
+ * Allocate page aligned memory with extended options and default tag.
+ *
+ * @returns Pointer to the allocated memory.
+ * @returns NULL if we're out of memory or if RTMEMPAGEALLOC_F_LARGE_PAGES
+ *          couldn't be satisfied.
+ * @param   cb      Size of the memory block. Will be rounded up to page size.
+ * @param   fFlags  A combination of the RTMEMPAGEALLOC_F_XXX defines.
+ */
+#define RTMemPageAllocEx(cb, fFlags)    RTMemPageAllocExTag((cb), (fFlags), RTMEM_TAG)
+
+/**
+ * Allocate page aligned memory with extended options and custom tag.
+ *
+ * The memory is freed by RTMemPageFree() like any other page allocation.
+ *
+ * @returns Pointer to the allocated memory.
+ * @returns NULL if we're out of memory or if RTMEMPAGEALLOC_F_LARGE_PAGES
+ *          couldn't be satisfied.
+ * @param   cb      Size of the memory block. Will be rounded up to page size.
+ * @param   fFlags  A combination of the RTMEMPAGEALLOC_F_XXX defines.
+ * @param   pszTag  Allocation tag used for statistics and such.
+ */
+RTDECL(void *) RTMemPageAllocExTag(size_t cb, uint32_t fFlags, const char *pszTag) RT_NO_THROW;
+
 /**
- * Free a memory block allocated with RTMemPageAlloc() or RTMemPageAllocZ().
+ * Free a memory block allocated with RTMemPageAlloc(), RTMemPageAllocZ() or
+ * RTMemPageAllocEx().
  *
  * @param   pv      Pointer to the block as it was returned by the allocation function.
  *                  NULL will be ignored.
@@ -505,6 +551,33 @@ RTDECL(int) RTMemProtect(void *pv, size_t cb, unsigned fProtect) RT_NO_THROW;
  */
 RTDECL(void) RTMemWipeThoroughly(void *pv, size_t cb, size_t cMinPasses) RT_NO_THROW;
 
+/**
+ * Scans a memory block for the first non-zero byte.
+ *
+ * In ring-3 on x86 and AMD64 this will use SSE2 or AVX2 when available, so it
+ * is considerably faster than ASMMemIsAll8 and ASMBitFirstSet for large
+ * blocks.  There are no alignment requirements.
+ *
+ * @returns Pointer to the first non-zero byte.
+ * @returns NULL if all zero.
+ *
+ * @param   pv          The start of the memory block.
+ * @param   cb          The size of the memory block.
+ */
+RTDECL(void *) RTMemFirstNonZero(void const *pv, size_t cb) RT_NO_THROW;
+
+/**
+ * Checks if a memory block is all zeros.
+ *
+ * @returns true if all zero, false if not.
+ *
+ * @param   pv          The start of the memory block.
+ * @param   cb          The size of the memory block.
+ *
+ * @sa      RTMemFirstNonZero, ASMMemIsZeroPage
+ */
+RTDECL(bool) RTMemIsZero(void const *pv, size_t cb) RT_NO_THROW;
+
 /**
  * Allocate locked memory with default tag - extended version.
  *
@@ -1022,4 +1095,3 @@ RT_C_DECLS_END
 
 
 #endif
-
@@ -92,6 +92,18 @@ typedef DECLCALLBACK(void) FNMEMCACHEDTOR(RTMEMCACHE hMemCache, void *pvObj, voi
 typedef FNMEMCACHEDTOR *PFNMEMCACHEDTOR;
 
 
+/** @name RTMemCacheCreate flags
+ * @{ */
+/** Don't keep per-thread magazines of free objects.
+ * By default, caches that may hold more than a few dozen objects keep small
+ * magazines of free objects that threads allocate from and free to without
+ * touching shared state.  Objects sitting in magazines count as allocated
+ * until they are handed out again or the cache runs out of space. */
+#define RTMEMCACHE_FLAGS_NO_MAGAZINES   RT_BIT_32(0)
+/** Valid flags. */
+#define RTMEMCACHE_FLAGS_VALID_MASK     UINT32_C(0x00000001)
+/** @} */
+
 /**
  * Create an allocation cache for fixed size memory objects.
  *
@@ -106,7 +118,7 @@ typedef FNMEMCACHEDTOR *PFNMEMCACHEDTOR;
  * @param   pfnCtor             Object constructor callback.  Optional.
  * @param   pfnDtor             Object destructor callback.  Optional.
  * @param   pvUser              User argument for the two callbacks.
- * @param   fFlags              Flags reserved for future use.  Must be zero.
+ * @param   fFlags              RTMEMCACHE_FLAGS_XXX.
  */
 RTDECL(int)     RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbAlignment, uint32_t cMaxObjects,
                                  PFNMEMCACHECTOR pfnCtor, PFNMEMCACHEDTOR pfnDtor, void *pvUser, uint32_t fFlags);
@@ -396,6 +396,25 @@ typedef enum RTREQPOOLSTAT
     /** Average time the requests had to wait in the queue before being
      * scheduled. */
     RTREQPOOLSTAT_NS_AVERAGE_REQ_QUEUED,
+    /** The total number of requests a worker thread took from the queue of
+     * another worker thread. */
+    RTREQPOOLSTAT_REQUESTS_STOLEN,
+    /** The highest number of requests seen pending on a single worker
+     * queue. */
+    RTREQPOOLSTAT_REQUESTS_PENDING_MAX,
+    /** The longest time a request took to process. */
+    RTREQPOOLSTAT_NS_MAX_REQ_PROCESSING,
+    /** The longest time a request had to wait in the queue. */
+    RTREQPOOLSTAT_NS_MAX_REQ_QUEUED,
+    /** The median time requests had to wait in the queue.  This is an upper
+     * bound with power of two granularity. */
+    RTREQPOOLSTAT_NS_P50_REQ_QUEUED,
+    /** The 90th percentile of the time requests had to wait in the queue,
+     * see RTREQPOOLSTAT_NS_P50_REQ_QUEUED. */
+    RTREQPOOLSTAT_NS_P90_REQ_QUEUED,
+    /** The 99th percentile of the time requests had to wait in the queue,
+     * see RTREQPOOLSTAT_NS_P50_REQ_QUEUED. */
+    RTREQPOOLSTAT_NS_P99_REQ_QUEUED,
     /** The end of the valid statistics value names. */
     RTREQPOOLSTAT_END,
     /** Blow the type up to 32-bit. */
@@ -524,6 +543,52 @@ RTDECL(int) RTReqPoolCallVoidWait(RTREQPOOL hPool, PFNRT pfnFunction, unsigned c
  */
 RTDECL(int) RTReqPoolCallVoidNoWait(RTREQPOOL hPool, PFNRT pfnFunction, unsigned cArgs, ...);
 
+/**
+ * Calls a function on worker threads once for each entry in an argument
+ * array, submitting all the requests in one go.
+ *
+ * This is cheaper than calling RTReqPoolCallEx in a loop as the requests are
+ * handed to the worker queues in chunks and idle workers are woken up once.
+ * The submitter is not pushed back.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_TIMEOUT if the requests didn't all complete within
+ *          @a cMillies.
+ * @param   hPool           The request thread pool handle.
+ * @param   cMillies        The number of milliseconds to wait for all the
+ *                          requests to be processed.  Ignored if
+ *                          RTREQFLAGS_NO_WAIT is used.
+ * @param   pahReqs         Where to return the requests, @a cCalls entries.
+ *                          Can be NULL if the RTREQFLAGS_NO_WAIT flag is
+ *                          used.  The caller must release all entries that
+ *                          aren't NIL_RTREQ, also on failure.
+ * @param   fFlags          A combination of RTREQFLAGS values.
+ * @param   pfnFunction     The function to be called.  Must be declared by a
+ *                          DECL macro because of calling conventions and
+ *                          take a single pointer argument.
+ * @param   cCalls          The number of calls to make.
+ * @param   papvArgs        The argument for each call, @a cCalls entries.
+ */
+RTDECL(int) RTReqPoolCallBatch(RTREQPOOL hPool, RTMSINTERVAL cMillies, PRTREQ *pahReqs, uint32_t fFlags,
+                               PFNRT pfnFunction, size_t cCalls, void * const *papvArgs);
+
+/**
+ * Calls a function on worker threads once for each entry in an argument
+ * array and waits for all of them to return.
+ *
+ * @returns IPRT status code, the first failure status returned by
+ *          @a pfnFunction or a request pool error.
+ * @param   hPool           The request thread pool handle.
+ * @param   pfnFunction     The function to be called.  Must be declared by a
+ *                          DECL macro because of calling conventions, take a
+ *                          single pointer argument and return an int value
+ *                          compatible with the IPRT status code convention.
+ * @param   cCalls          The number of calls to make.
+ * @param   papvArgs        The argument for each call, @a cCalls entries.
+ * @remarks See remarks on RTReqPoolCallBatch.
+ */
+RTDECL(int) RTReqPoolCallBatchWait(RTREQPOOL hPool, PFNRT pfnFunction, size_t cCalls, void * const *papvArgs);
+
 
 /**
  * Retainsa reference to a request.
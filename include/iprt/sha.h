@@ -83,6 +83,20 @@ RTDECL(void) RTSha1Init(PRTSHA1CONTEXT pCtx);
  */
 RTDECL(void) RTSha1Update(PRTSHA1CONTEXT pCtx, const void *pvBuf, size_t cbBuf);
 
+/**
+ * Feed data into several independent SHA-1 computations at once.
+ *
+ * This is equivalent to calling RTSha1Update for each context, but the
+ * implementation may interleave the streams to make better use of wide vector
+ * units.  Useful when hashing many files or chunks in parallel.
+ *
+ * @param   cCtxs       Number of contexts.
+ * @param   papCtxs     Array of @a cCtxs context pointers.  No duplicates.
+ * @param   papvBufs    Array of @a cCtxs data pointers.
+ * @param   pacbBufs    Array of @a cCtxs data lengths (in bytes).
+ */
+RTDECL(void) RTSha1UpdateMulti(uint32_t cCtxs, PRTSHA1CONTEXT *papCtxs, void const * const *papvBufs, size_t const *pacbBufs);
+
 /**
  * Compute the SHA-1 hash of the data.
  *
@@ -191,6 +205,20 @@ RTDECL(void) RTSha256Init(PRTSHA256CONTEXT pCtx);
  */
 RTDECL(void) RTSha256Update(PRTSHA256CONTEXT pCtx, const void *pvBuf, size_t cbBuf);
 
+/**
+ * Feed data into several independent SHA-256 computations at once.
+ *
+ * This is equivalent to calling RTSha256Update for each context, but the
+ * implementation may interleave the streams to make better use of wide vector
+ * units.  Useful when hashing many files or chunks in parallel.
+ *
+ * @param   cCtxs       Number of contexts.
+ * @param   papCtxs     Array of @a cCtxs context pointers.  No duplicates.
+ * @param   papvBufs    Array of @a cCtxs data pointers.
+ * @param   pacbBufs    Array of @a cCtxs data lengths (in bytes).
+ */
+RTDECL(void) RTSha256UpdateMulti(uint32_t cCtxs, PRTSHA256CONTEXT *papCtxs, void const * const *papvBufs, size_t const *pacbBufs);
+
 /**
  * Compute the SHA-256 hash of the data.
  *
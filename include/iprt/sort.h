@@ -27,6 +27,7 @@
 #define ___iprt_sort_h
 
 #include <iprt/types.h>
+#include <iprt/req.h>
 
 /** @defgroup grp_rt_sort       RTSort - Sorting Algorithms
  * @ingroup grp_rt
@@ -74,6 +75,97 @@ typedef DECLCALLBACK(void) FNRTSORTAPV(void **papvArray, size_t cElements, PFNRT
 /** Pointer to a pointer array sorter function. */
 typedef FNRTSORTAPV *PFNRTSORTAPV;
 
+/**
+ * Sorts an array of variable sized elements.
+ *
+ * This is an introsort, i.e. a quick sort which falls back on heap sort when
+ * the partitioning goes bad, so it is O(n log n) in the worst case.  It is not
+ * stable, use RTSortStable if the order of equal elements matters.
+ *
+ * @param   pvArray         The array to sort.
+ * @param   cElements       The number of elements in the array.
+ * @param   cbElement       The size of an array element.
+ * @param   pfnCmp          Callback function comparing two elements.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(void) RTSort(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser);
+
+/**
+ * Same as RTSort but speciallized for an array containing element pointers.
+ *
+ * @param   papvArray       The array to sort.
+ * @param   cElements       The number of elements in the array.
+ * @param   pfnCmp          Callback function comparing two elements.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(void) RTSortApv(void **papvArray, size_t cElements, PFNRTSORTCMP pfnCmp, void *pvUser);
+
+/**
+ * Stable sort of an array of variable sized elements.
+ *
+ * Merge sort, equal elements keep their relative order.  Needs a temporary
+ * buffer the size of the array.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_NO_TMP_MEMORY if the temporary buffer couldn't be allocated,
+ *          the array is left untouched.
+ * @param   pvArray         The array to sort.
+ * @param   cElements       The number of elements in the array.
+ * @param   cbElement       The size of an array element.
+ * @param   pfnCmp          Callback function comparing two elements.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(int) RTSortStable(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser);
+
+/**
+ * Same as RTSortStable but speciallized for an array containing element
+ * pointers.
+ *
+ * @returns IPRT status code, see RTSortStable.
+ * @param   papvArray       The array to sort.
+ * @param   cElements       The number of elements in the array.
+ * @param   pfnCmp          Callback function comparing two elements.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(int) RTSortApvStable(void **papvArray, size_t cElements, PFNRTSORTCMP pfnCmp, void *pvUser);
+
+/**
+ * Stable sort of an array of variable sized elements using the threads of a
+ * request pool.
+ *
+ * The array is split into chunks which are sorted on the pool threads and
+ * then merged, again on the pool threads.  Small arrays, or a NIL pool, are
+ * sorted on the calling thread by RTSortStable.  If the pool cannot take the
+ * work the calling thread does it.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_NO_MEMORY or VERR_NO_TMP_MEMORY if the temporary buffer
+ *          couldn't be allocated, the array is left untouched.
+ * @param   hPool           The request pool, NIL_RTREQPOOL is fine.
+ * @param   pvArray         The array to sort.
+ * @param   cElements       The number of elements in the array.
+ * @param   cbElement       The size of an array element.
+ * @param   pfnCmp          Callback function comparing two elements.  Called
+ *                          concurrently on several threads.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(int) RTSortParallel(RTREQPOOL hPool, void *pvArray, size_t cElements, size_t cbElement,
+                           PFNRTSORTCMP pfnCmp, void *pvUser);
+
+/**
+ * Same as RTSortParallel but speciallized for an array containing element
+ * pointers.
+ *
+ * @returns IPRT status code, see RTSortParallel.
+ * @param   hPool           The request pool, NIL_RTREQPOOL is fine.
+ * @param   papvArray       The array to sort.
+ * @param   cElements       The number of elements in the array.
+ * @param   pfnCmp          Callback function comparing two elements.  Called
+ *                          concurrently on several threads.
+ * @param   pvUser          User argument for the callback.
+ */
+RTDECL(int) RTSortApvParallel(RTREQPOOL hPool, void **papvArray, size_t cElements, PFNRTSORTCMP pfnCmp, void *pvUser);
+
 /**
  * Shell sort an array of variable sized elementes.
  *
@@ -526,6 +526,17 @@ typedef const X86CPUIDFEATEDX *PCX86CPUIDFEATEDX;
 /** @} */
 
 
+/** @name CPUID Structured Extended Feature information.
+ * CPUID query with EAX=7, ECX=0.
+ * @{
+ */
+/** EBX Bit 5 - AVX2 - Advanced Vector Extensions 2. */
+#define X86_CPUID_STEXT_FEATURE_EBX_AVX2       RT_BIT(5)
+/** EBX Bit 29 - SHA - Supports the SHA-1 and SHA-256 extensions. */
+#define X86_CPUID_STEXT_FEATURE_EBX_SHA        RT_BIT(29)
+/** @} */
+
+
 /** @name CPUID Extended Feature information.
  *  CPUID query with EAX=0x80000001.
  *  @{
@@ -740,6 +751,18 @@ typedef const X86CPUIDFEATEDX *PCX86CPUIDFEATEDX;
 /** @} */
 
 
+/** @name XCR0 - Extended control register 0 (XFEATURE_ENABLED_MASK).
+ * Read with XGETBV when CR4.OSXSAVE is set.
+ * @{ */
+/** Bit 0 - x87 - The x87 FPU state, always set. */
+#define XSAVE_C_X87                         RT_BIT(0)
+/** Bit 1 - SSE - The SSE (XMM) state. */
+#define XSAVE_C_SSE                         RT_BIT(1)
+/** Bit 2 - YMM - The upper halves of the AVX (YMM) registers. */
+#define XSAVE_C_YMM                         RT_BIT(2)
+/** @} */
+
+
 /** @name DR6
  * @{ */
 /** Bit 0 - B0 - Breakpoint 0 condition detected. */
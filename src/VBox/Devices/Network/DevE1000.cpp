@@ -252,6 +252,17 @@ static const struct E1kChips
 #define E1K_MAX_TX_PKT_SIZE    16288
 #define E1K_MAX_RX_PKT_SIZE    16384
 
+/** The largest frame assembled by receive coalescing, leaves room for FCS. */
+#define E1K_RXCOAL_MAX_FRAME   (E1K_MAX_RX_PKT_SIZE - 8)
+/** The maximum number of TCP segments merged into a single frame. */
+#define E1K_RXCOAL_MAX_SEGS    64
+/** The default for how long a frame may be held back (microseconds). */
+#define E1K_RXCOAL_DEF_TIMEOUT 100
+/** Offset of the IPv4 header in an untagged frame. */
+#define E1K_RXCOAL_IP_OFF      14
+/** Offset of the TCP header in an untagged IPv4 frame without options. */
+#define E1K_RXCOAL_TCP_OFF     (E1K_RXCOAL_IP_OFF + 20)
+
 /*****************************************************************************/
 
 /** Gets the specfieid bits from the register. */
@@ -1025,6 +1036,15 @@ struct E1kState_st
     PTMTIMERR3              pLUTimerR3;               /**< Link Up(/Restore) Timer. */
     /** The scatter / gather buffer used for the current outgoing packet - R3. */
     R3PTRTYPE(PPDMSCATTERGATHER) pTxSgR3;
+    PTMTIMERR3              pRxCoalTimerR3;    /**< Receive Coalescing Timer - R3. */
+    /** RX coalescing: The frame being assembled (E1K_MAX_RX_PKT_SIZE bytes) - R3. */
+    R3PTRTYPE(uint8_t *)    pbRxCoalFrameR3;
+    /** Zero-copy transmit state, NULL if disabled - R3. */
+    R3PTRTYPE(struct E1kTxZeroCopy *) pTxZcR3;
+#if HC_ARCH_BITS == 32
+    /** Pads the odd number of ring-3 pointers on 32-bit hosts. */
+    uint32_t                Alignment0;
+#endif
 
     PPDMDEVINSR0            pDevInsR0;                   /**< Device instance - R0. */
     R0PTRTYPE(PPDMQUEUE)    pTxQueueR0;                   /**< Transmit queue - R0. */
@@ -1063,6 +1083,7 @@ struct E1kState_st
 #ifdef E1K_WITH_TX_CS
     PDMCRITSECT csTx;                                     /**< TX Critical section. */
 #endif /* E1K_WITH_TX_CS */
+    PDMCRITSECT csRxCoal;                      /**< RX coalescing critical section. */
     /** Base address of memory-mapped registers. */
     RTGCPHYS    addrMMReg;
     /** MAC address obtained from the configuration. */
@@ -1083,8 +1104,12 @@ struct E1kState_st
     bool        fRCEnabled;
     /** EMT: Compute Ethernet CRC for RX packets. */
     bool        fEthernetCRC;
+    /** EMT: Coalesce in-order TCP segments before passing them to the guest. */
+    bool        fRxCoalescing;
+    /** EMT: Pass frames to the driver straight from guest memory if possible. */
+    bool        fTxZeroCopy;
 
-    bool        Alignment2[3];
+    bool        Alignment2[1];
     /** Link up delay (in milliseconds). */
     uint32_t    cMsLinkUpDelay;
 
@@ -1180,6 +1205,20 @@ struct E1kState_st
     /** ?: Emulated controller type. */
     E1KCHIP     eChip;
 
+    /** RX coalescing: Status bits of the frame being assembled. */
+    E1KRXDST    RxCoalStatus;
+    /** RX coalescing: Size of the frame being assembled, 0 if none. */
+    uint32_t    cbRxCoal;
+    /** RX coalescing: TCP sequence number the next segment must have to be merged. */
+    uint32_t    uRxCoalNextSeq;
+    /** RX coalescing: How long a frame may be held back (in microseconds). */
+    uint32_t    cUsRxCoalTimeout;
+    /** RX coalescing: Size of Ethernet, IP and TCP headers of the frame being assembled. */
+    uint16_t    cbRxCoalHdrs;
+    /** RX coalescing: Number of segments merged into the frame being assembled. */
+    uint16_t    cRxCoalSegs;
+    uint32_t    u32RxCoalAlignment;
+
     /** EMT: EEPROM emulation */
     E1kEEPROM   eeprom;
     /** EMT: Physical interface emulation. */
@@ -1225,7 +1264,16 @@ struct E1kState_st
     STAMCOUNTER                         StatTxPathFallback;
     STAMCOUNTER                         StatTxPathGSO;
     STAMCOUNTER                         StatTxPathRegular;
+    STAMCOUNTER                         StatTxZeroCopy;
+    STAMCOUNTER                         StatTxZeroCopyFallback;
     STAMCOUNTER                         StatPHYAccesses;
+    STAMCOUNTER                         StatRxCoalSegments;
+    STAMCOUNTER                         StatRxCoalFrames;
+    STAMCOUNTER                         StatRxCoalFlushTimer;
+    STAMCOUNTER                         StatRxCoalFlushMismatch;
+    STAMCOUNTER                         StatRxCoalFlushLimit;
+    STAMCOUNTER                         StatRxCoalFlushPush;
+    STAMCOUNTER                         StatRxCoalFlushFailed;
     STAMCOUNTER                         aStatRegWrites[E1K_NUM_OF_REGS];
     STAMCOUNTER                         aStatRegReads[E1K_NUM_OF_REGS];
 #endif /* VBOX_WITH_STATISTICS */
@@ -3774,6 +3822,45 @@ DECLINLINE(void) e1kWriteBackDesc(PE1KSTATE pThis, E1KTXDESC* pDesc, RTGCPHYS ad
     PDMDevHlpPCIPhysWrite(pThis->CTX_SUFF(pDevIns), addr, pDesc, sizeof(E1KTXDESC));
 }
 
+/**
+ * Update the transmit statistics registers for a frame that is about to be
+ * sent.
+ *
+ * @param   pThis       The device state structure.
+ * @param   pbFrame     Pointer to the beginning of the frame (at least the
+ *                      destination MAC address), NULL if not available.
+ * @param   cbFrame     The size of the frame including the VLAN tag.
+ * @thread  E1000_TX
+ */
+static void e1kXmitUpdateStats(PE1KSTATE pThis, uint8_t const *pbFrame, uint32_t cbFrame)
+{
+    E1K_INC_CNT32(TPT);
+    E1K_ADD_CNT64(TOTL, TOTH, cbFrame);
+    E1K_INC_CNT32(GPTC);
+    if (pbFrame && e1kIsBroadcast(pbFrame))
+        E1K_INC_CNT32(BPTC);
+    else if (pbFrame && e1kIsMulticast(pbFrame))
+        E1K_INC_CNT32(MPTC);
+    /* Update octet transmit counter */
+    E1K_ADD_CNT64(GOTCL, GOTCH, cbFrame);
+    if (pThis->CTX_SUFF(pDrv))
+        STAM_REL_COUNTER_ADD(&pThis->StatTransmitBytes, cbFrame);
+    if (cbFrame == 64)
+        E1K_INC_CNT32(PTC64);
+    else if (cbFrame < 128)
+        E1K_INC_CNT32(PTC127);
+    else if (cbFrame < 256)
+        E1K_INC_CNT32(PTC255);
+    else if (cbFrame < 512)
+        E1K_INC_CNT32(PTC511);
+    else if (cbFrame < 1024)
+        E1K_INC_CNT32(PTC1023);
+    else
+        E1K_INC_CNT32(PTC1522);
+
+    E1K_INC_ISTAT_CNT(pThis->uStatTxFrm);
+}
+
 /**
  * Transmit complete frame.
  *
@@ -3832,31 +3919,7 @@ static void e1kTransmitFrame(PE1KSTATE pThis, bool fOnWorkerThread)
             pThis->szPrf, cbFrame, pSg->aSegs[0].pvSeg, pThis->szPrf));*/
 
     /* Update the stats */
-    E1K_INC_CNT32(TPT);
-    E1K_ADD_CNT64(TOTL, TOTH, cbFrame);
-    E1K_INC_CNT32(GPTC);
-    if (pSg && e1kIsBroadcast(pSg->aSegs[0].pvSeg))
-        E1K_INC_CNT32(BPTC);
-    else if (pSg && e1kIsMulticast(pSg->aSegs[0].pvSeg))
-        E1K_INC_CNT32(MPTC);
-    /* Update octet transmit counter */
-    E1K_ADD_CNT64(GOTCL, GOTCH, cbFrame);
-    if (pThis->CTX_SUFF(pDrv))
-        STAM_REL_COUNTER_ADD(&pThis->StatTransmitBytes, cbFrame);
-    if (cbFrame == 64)
-        E1K_INC_CNT32(PTC64);
-    else if (cbFrame < 128)
-        E1K_INC_CNT32(PTC127);
-    else if (cbFrame < 256)
-        E1K_INC_CNT32(PTC255);
-    else if (cbFrame < 512)
-        E1K_INC_CNT32(PTC511);
-    else if (cbFrame < 1024)
-        E1K_INC_CNT32(PTC1023);
-    else
-        E1K_INC_CNT32(PTC1522);
-
-    E1K_INC_ISTAT_CNT(pThis->uStatTxFrm);
+    e1kXmitUpdateStats(pThis, pSg ? (uint8_t const *)pSg->aSegs[0].pvSeg : NULL, cbFrame);
 
     /*
      * Dump and send the packet.
@@ -5019,6 +5082,415 @@ static int e1kXmitPacket(PE1KSTATE pThis, bool fOnWorkerThread)
     return rc;
 }
 
+#ifdef IN_RING3
+
+/** Maximum number of guest memory segments in a zero-copy frame. */
+# define E1K_TXZC_MAX_SEGS      64
+/** Maximum number of header bytes copied out of guest memory (plus room for
+ *  the VLAN tag). */
+# define E1K_TXZC_MAX_HDR       (256 + 8)
+/** Frames smaller than this are not worth mapping guest pages for. */
+# define E1K_TXZC_MIN_FRAME     1024
+
+/**
+ * Zero-copy transmit state, allocated from the MM heap when TxZeroCopy is
+ * enabled.
+ */
+typedef struct E1kTxZeroCopy
+{
+    /** Number of page mapping locks held in aLocks. */
+    uint32_t            cLocks;
+    /** Number of guest memory segments in aSegs. */
+    uint32_t            cSegs;
+    /** Page mapping locks for the guest buffers. */
+    PGMPAGEMAPLOCK      aLocks[E1K_TXZC_MAX_SEGS];
+    /** The guest buffers of the frame, in order. */
+    PDMDATASEG          aSegs[E1K_TXZC_MAX_SEGS];
+    /** Private copy of the headers, receives checksums and the VLAN tag. */
+    uint8_t             abHdr[E1K_TXZC_MAX_HDR];
+    /** The S/G buffer handed to the driver, header copy first. */
+    union
+    {
+        PDMSCATTERGATHER    Sg;
+        uint8_t             abPadding[RT_OFFSETOF(PDMSCATTERGATHER, aSegs[E1K_TXZC_MAX_SEGS + 1])];
+    } u;
+} E1KTXZC;
+/** Pointer to the zero-copy transmit state. */
+typedef E1KTXZC *PE1KTXZC;
+
+/**
+ * Release all guest page mappings held by the zero-copy state.
+ *
+ * @param   pThis       The device state structure.
+ * @param   pZc         The zero-copy state.
+ * @thread  E1000_TX
+ */
+static void e1kXmitZcUnmap(PE1KSTATE pThis, PE1KTXZC pZc)
+{
+    while (pZc->cLocks > 0)
+        PDMDevHlpPhysReleasePageMappingLock(pThis->pDevInsR3, &pZc->aLocks[--pZc->cLocks]);
+    pZc->cSegs = 0;
+}
+
+/**
+ * Map a guest buffer and append it to the zero-copy segment list, merging
+ * segments that happen to be contiguous in our address space.
+ *
+ * @returns true on success, false if the buffer cannot be mapped (MMIO,
+ *          access handlers) or there are too many segments.
+ * @param   pThis       The device state structure.
+ * @param   pZc         The zero-copy state.
+ * @param   GCPhys      Guest physical address of the buffer.
+ * @param   cb          Size of the buffer.
+ * @thread  E1000_TX
+ */
+static bool e1kXmitZcAddBuf(PE1KSTATE pThis, PE1KTXZC pZc, RTGCPHYS GCPhys, uint32_t cb)
+{
+    while (cb > 0)
+    {
+        if (pZc->cLocks >= E1K_TXZC_MAX_SEGS)
+            return false;
+        void const *pv;
+        int rc = PDMDevHlpPhysGCPhys2CCPtrReadOnly(pThis->pDevInsR3, GCPhys, 0, &pv, &pZc->aLocks[pZc->cLocks]);
+        if (RT_FAILURE(rc))
+            return false;
+        pZc->cLocks++;
+
+        uint32_t cbChunk = RT_MIN(cb, PAGE_SIZE - (uint32_t)(GCPhys & PAGE_OFFSET_MASK));
+        if (   pZc->cSegs > 0
+            && (uint8_t const *)pZc->aSegs[pZc->cSegs - 1].pvSeg + pZc->aSegs[pZc->cSegs - 1].cbSeg == (uint8_t const *)pv)
+            pZc->aSegs[pZc->cSegs - 1].cbSeg += cbChunk;
+        else
+        {
+            pZc->aSegs[pZc->cSegs].pvSeg = (void *)pv;
+            pZc->aSegs[pZc->cSegs].cbSeg = cbChunk;
+            pZc->cSegs++;
+        }
+        GCPhys += cbChunk;
+        cb     -= cbChunk;
+    }
+    return true;
+}
+
+/**
+ * Compute and write internet checksum at the specified offset of a
+ * zero-copy frame, see e1kInsertChecksum() for the semantics.
+ *
+ * The checksum field always lives in the header copy, the data being summed
+ * may be spread over any number of segments.
+ *
+ * @param   pThis       The device state structure.
+ * @param   pSg         The S/G buffer describing the frame.
+ * @param   cbFrame     Total length of the frame.
+ * @param   cso         Offset in frame to write checksum at.
+ * @param   css         Offset in frame to start computing checksum from.
+ * @param   cse         Offset in frame to stop computing checksum at.
+ * @thread  E1000_TX
+ */
+static void e1kXmitZcInsertChecksum(PE1KSTATE pThis, PPDMSCATTERGATHER pSg, uint32_t cbFrame,
+                                    uint8_t cso, uint8_t css, uint16_t cse)
+{
+    if (css >= cbFrame || cso >= cbFrame - 1)
+    {
+        E1kLog2(("%s css(%X)/cso(%X) beyond packet length(%X), checksum is not inserted\n",
+                 pThis->szPrf, css, cso, cbFrame));
+        return;
+    }
+    if (cse == 0 || cse >= cbFrame)
+        cse = cbFrame - 1;
+
+    uint32_t csum  = 0;
+    uint32_t off   = 0;    /* Offset of the current segment within the frame. */
+    uint32_t offCs = css;  /* Next frame offset to be summed. */
+    for (uint32_t iSeg = 0; iSeg < pSg->cSegs && offCs <= cse; off += (uint32_t)pSg->aSegs[iSeg++].cbSeg)
+    {
+        uint32_t const cbSeg = (uint32_t)pSg->aSegs[iSeg].cbSeg;
+        if (offCs >= off + cbSeg)
+            continue;
+        uint8_t const *pb  = (uint8_t const *)pSg->aSegs[iSeg].pvSeg + (offCs - off);
+        uint32_t       cb  = RT_MIN(off + cbSeg, (uint32_t)cse + 1) - offCs;
+        /* Odd position relative to css: this byte is the high half of a word. */
+        if ((offCs - css) & 1)
+        {
+            csum += RT_MAKE_U16(0, *pb++);
+            offCs++;
+            cb--;
+        }
+        offCs += cb;
+        while (cb > 1)
+        {
+            csum += *(uint16_t const *)pb;
+            pb   += 2;
+            cb   -= 2;
+        }
+        if (cb)
+            csum += RT_MAKE_U16(*pb, 0);
+        while (csum >> 16)
+            csum = (csum >> 16) + (csum & 0xFFFF);
+    }
+
+    Assert(pSg->aSegs[0].pvSeg == RT_FROM_MEMBER(pSg, E1KTXZC, u.Sg)->abHdr && cso + 2U <= pSg->aSegs[0].cbSeg);
+    uint16_t u16ChkSum = (uint16_t)~csum;
+    E1kLog2(("%s Inserting csum: %04X at %02X (zero-copy)\n", pThis->szPrf, u16ChkSum, cso));
+    *(uint16_t *)((uint8_t *)pSg->aSegs[0].pvSeg + cso) = u16ChkSum;
+}
+
+/**
+ * Complete the descriptors of a packet that was sent by e1kXmitZeroCopy().
+ *
+ * Does what e1kXmitPacket() does for each descriptor, minus the copying.
+ *
+ * @param   pThis       The device state structure.
+ * @thread  E1000_TX
+ */
+static void e1kXmitZcComplete(PE1KSTATE pThis)
+{
+    while (pThis->iTxDCurrent < pThis->nTxDFetched)
+    {
+        E1KTXDESC *pDesc = &pThis->aTxDescriptors[pThis->iTxDCurrent];
+        e1kPrintTDesc(pThis, pDesc, "vvv");
+        switch (e1kGetDescType(pDesc))
+        {
+            case E1K_DTYP_CONTEXT:
+                E1K_INC_ISTAT_CNT(pThis->uStatDescCtx);
+                break;
+            case E1K_DTYP_DATA:
+                STAM_COUNTER_INC(pDesc->data.cmd.fTSE?
+                                 &pThis->StatTxDescTSEData:
+                                 &pThis->StatTxDescData);
+                E1K_INC_ISTAT_CNT(pThis->uStatDescDat);
+                break;
+            case E1K_DTYP_LEGACY:
+                STAM_COUNTER_INC(&pThis->StatTxDescLegacy);
+                E1K_INC_ISTAT_CNT(pThis->uStatDescLeg);
+                break;
+        }
+        e1kDescReport(pThis, pDesc, e1kDescAddr(TDBAH, TDBAL, TDH));
+        if (++TDH * sizeof(E1KTXDESC) >= TDLEN)
+            TDH = 0;
+        uint32_t uLowThreshold = GET_BITS(TXDCTL, LWTHRESH)*8;
+        if (uLowThreshold != 0 && e1kGetTxLen(pThis) <= uLowThreshold)
+        {
+            E1kLog2(("%s Low on transmit descriptors, raise ICR.TXD_LOW, len=%x thresh=%x\n",
+                     pThis->szPrf, e1kGetTxLen(pThis), GET_BITS(TXDCTL, LWTHRESH)*8));
+            e1kRaiseInterrupt(pThis, VERR_SEM_BUSY, ICR_TXD_LOW);
+        }
+        ++pThis->iTxDCurrent;
+        if (e1kGetDescType(pDesc) != E1K_DTYP_CONTEXT && pDesc->legacy.cmd.fEOP)
+            break;
+    }
+    pThis->cbTxAlloc   = 0;
+    pThis->u16TxPktLen = 0;
+}
+
+/**
+ * Try to send the packet located by e1kLocateTxPacket() straight from guest
+ * memory.
+ *
+ * The guest buffers are mapped read-only and passed to the driver via
+ * PDMINETWORKUP::pfnSendSg. Only the headers are copied, so that checksums
+ * and the VLAN tag can be inserted without touching guest memory. The
+ * descriptors are written back only after the driver is done with the frame.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_NOT_SUPPORTED if the packet has to take the regular path, in
+ *          which case nothing has been consumed.
+ * @param   pThis           The device state structure.
+ * @param   fOnWorkerThread Whether we're on a worker thread or an EMT.
+ * @thread  E1000_TX
+ */
+static int e1kXmitZeroCopy(PE1KSTATE pThis, bool fOnWorkerThread)
+{
+    PE1KTXZC       pZc  = pThis->pTxZcR3;
+    PPDMINETWORKUP pDrv = pThis->pDrvR3;
+    if (   !pDrv
+        || !pDrv->pfnSendSg
+        || pThis->cbTxAlloc < E1K_TXZC_MIN_FRAME
+        || GET_BITS(RCTL, LBM) == RCTL_LBM_TCVR
+        || pThis->CTX_SUFF(pTxSg))
+        return VERR_NOT_SUPPORTED;
+
+    /*
+     * Map the buffers of all descriptors up to and including EOP.
+     */
+    Assert(pZc->cLocks == 0);
+    pZc->cSegs = 0;
+    bool         fOk       = true;
+    bool         fTSE      = false;
+    E1KTXDESC   *pEop      = NULL;
+    uint32_t     cbFrame   = 0;
+    for (int i = pThis->iTxDCurrent; i < pThis->nTxDFetched && fOk && !pEop; ++i)
+    {
+        E1KTXDESC *pDesc = &pThis->aTxDescriptors[i];
+        switch (e1kGetDescType(pDesc))
+        {
+            case E1K_DTYP_CONTEXT:
+                continue;
+            case E1K_DTYP_LEGACY:
+                if (pDesc->legacy.u64BufAddr && pDesc->legacy.cmd.u16Length)
+                {
+                    fOk = e1kXmitZcAddBuf(pThis, pZc, pDesc->legacy.u64BufAddr, pDesc->legacy.cmd.u16Length);
+                    cbFrame += pDesc->legacy.cmd.u16Length;
+                }
+                break;
+            case E1K_DTYP_DATA:
+                if (pDesc->data.u64BufAddr && pDesc->data.cmd.u20DTALEN)
+                {
+                    if (cbFrame == 0)
+                        fTSE = pDesc->data.cmd.fTSE;
+                    fOk = e1kXmitZcAddBuf(pThis, pZc, pDesc->data.u64BufAddr, pDesc->data.cmd.u20DTALEN);
+                    cbFrame += pDesc->data.cmd.u20DTALEN;
+                }
+                break;
+        }
+        if (pDesc->legacy.cmd.fEOP)
+            pEop = pDesc;
+    }
+
+    /*
+     * Work out how much of the frame goes into the header copy.  Frames we
+     * would have to segment ourselves, oversized ones and GSO frames with a
+     * VLAN tag (the GSO context does not account for it) take the regular path.
+     */
+    uint32_t cbHdr = 14;
+    if (fOk && pEop)
+    {
+        if (pThis->fGSO)
+        {
+            fOk   = !pThis->fVTag
+                 && cbFrame == (uint32_t)pThis->contextTSE.dw3.u8HDRLEN + pThis->contextTSE.dw2.u20PAYLEN;
+            cbHdr = pThis->GsoCtx.cbHdrsTotal;
+        }
+        else if (fTSE || cbFrame > E1K_MAX_TX_PKT_SIZE - 4)
+            fOk = false;
+        else if (e1kGetDescType(pEop) == E1K_DTYP_LEGACY)
+        {
+            if (pEop->legacy.cmd.fIC)
+                cbHdr = RT_MAX(cbHdr, pEop->legacy.cmd.u8CSO + 2U);
+        }
+        else
+        {
+            if (pThis->fIPcsum)
+                cbHdr = RT_MAX(cbHdr, pThis->contextNormal.ip.u8CSO + 2U);
+            if (pThis->fTCPcsum)
+                cbHdr = RT_MAX(cbHdr, pThis->contextNormal.tu.u8CSO + 2U);
+        }
+        cbHdr = RT_MIN(cbHdr, cbFrame);
+        fOk = fOk && cbHdr >= 14 && cbHdr + 4 <= sizeof(pZc->abHdr);
+    }
+    if (!fOk || !pEop)
+    {
+        e1kXmitZcUnmap(pThis, pZc);
+        STAM_COUNTER_INC(&pThis->StatTxZeroCopyFallback);
+        return VERR_NOT_SUPPORTED;
+    }
+
+    /*
+     * Build the S/G buffer: a private copy of the headers followed by the
+     * remainder of the guest buffers.
+     */
+    PPDMSCATTERGATHER pSg = &pZc->u.Sg;
+    pSg->fFlags      = PDMSCATTERGATHER_FLAGS_MAGIC | PDMSCATTERGATHER_FLAGS_OWNER_1;
+    pSg->cbUsed      = cbFrame;
+    pSg->cbAvailable = cbFrame;
+    pSg->pvAllocator = pZc;
+    pSg->pvUser      = pThis->fGSO ? &pThis->GsoCtx : NULL;
+    pSg->aSegs[0].pvSeg = pZc->abHdr;
+    pSg->aSegs[0].cbSeg = cbHdr;
+    pSg->cSegs       = 1;
+    uint32_t offHdr = 0;
+    for (uint32_t iSeg = 0; iSeg < pZc->cSegs; iSeg++)
+    {
+        uint8_t const *pb = (uint8_t const *)pZc->aSegs[iSeg].pvSeg;
+        size_t         cb = pZc->aSegs[iSeg].cbSeg;
+        if (offHdr < cbHdr)
+        {
+            size_t cbCopy = RT_MIN(cb, cbHdr - offHdr);
+            memcpy(&pZc->abHdr[offHdr], pb, cbCopy);
+            offHdr += (uint32_t)cbCopy;
+            pb     += cbCopy;
+            cb     -= cbCopy;
+        }
+        if (cb)
+        {
+            pSg->aSegs[pSg->cSegs].pvSeg = (void *)pb;
+            pSg->aSegs[pSg->cSegs].cbSeg = cb;
+            pSg->cSegs++;
+        }
+    }
+
+    if (!pThis->fGSO)
+    {
+        if (e1kGetDescType(pEop) == E1K_DTYP_LEGACY)
+        {
+            if (pEop->legacy.cmd.fIC)
+                e1kXmitZcInsertChecksum(pThis, pSg, cbFrame, pEop->legacy.cmd.u8CSO, pEop->legacy.dw3.u8CSS, 0);
+        }
+        else
+        {
+            if (pThis->fIPcsum)
+                e1kXmitZcInsertChecksum(pThis, pSg, cbFrame,
+                                        pThis->contextNormal.ip.u8CSO,
+                                        pThis->contextNormal.ip.u8CSS,
+                                        pThis->contextNormal.ip.u16CSE);
+            if (pThis->fTCPcsum)
+                e1kXmitZcInsertChecksum(pThis, pSg, cbFrame,
+                                        pThis->contextNormal.tu.u8CSO,
+                                        pThis->contextNormal.tu.u8CSS,
+                                        pThis->contextNormal.tu.u16CSE);
+        }
+    }
+
+    /* Add VLAN tag */
+    if (pThis->fVTag)
+    {
+        E1kLog3(("%s Inserting VLAN tag %08x\n",
+            pThis->szPrf, RT_BE2H_U16(VET) | (RT_BE2H_U16(pThis->u16VTagTCI) << 16)));
+        memmove(&pZc->abHdr[16], &pZc->abHdr[12], cbHdr - 12);
+        *((uint32_t*)pZc->abHdr + 3) = RT_BE2H_U16(VET) | (RT_BE2H_U16(pThis->u16VTagTCI) << 16);
+        pSg->aSegs[0].cbSeg += 4;
+        pSg->cbUsed         += 4;
+        pSg->cbAvailable    += 4;
+        cbFrame             += 4;
+    }
+
+    /*
+     * Send it.
+     */
+    pThis->led.Asserted.s.fWriting = pThis->led.Actual.s.fWriting = 1;
+    e1kPacketDump(pThis, pZc->abHdr, pSg->aSegs[0].cbSeg, "--> Outgoing (zero-copy headers)");
+
+    STAM_PROFILE_START(&pThis->CTX_SUFF_Z(StatTransmitSend), a);
+    int rc = pDrv->pfnSendSg(pDrv, pSg, fOnWorkerThread);
+    STAM_PROFILE_STOP(&pThis->CTX_SUFF_Z(StatTransmitSend), a);
+    e1kXmitZcUnmap(pThis, pZc);
+    if (rc == VERR_TRY_AGAIN)
+    {
+        /* The driver wants a buffer of its own, copy it after all. */
+        pThis->led.Actual.s.fWriting = 0;
+        STAM_COUNTER_INC(&pThis->StatTxZeroCopyFallback);
+        return VERR_NOT_SUPPORTED;
+    }
+    if (RT_FAILURE(rc))
+        E1kLogRel(("E1000: ERROR! pfnSendSg returned %Rrc\n", rc));
+
+    e1kXmitUpdateStats(pThis, pZc->abHdr, cbFrame);
+    if (pThis->fGSO)
+    {
+        STAM_COUNTER_INC(&pThis->StatTxPathGSO);
+        E1K_INC_CNT32(TSCTC);
+    }
+    else
+        STAM_COUNTER_INC(&pThis->StatTxPathRegular);
+    STAM_COUNTER_INC(&pThis->StatTxZeroCopy);
+    pThis->led.Actual.s.fWriting = 0;
+
+    e1kXmitZcComplete(pThis);
+    return VINF_SUCCESS;
+}
+
+#endif /* IN_RING3 */
+
 #endif /* E1K_WITH_TXD_CACHE */
 #ifndef E1K_WITH_TXD_CACHE
 
@@ -5170,6 +5642,19 @@ static int e1kXmitPending(PE1KSTATE pThis, bool fOnWorkerThread)
             while (e1kLocateTxPacket(pThis))
             {
                 fIncomplete = false;
+#ifdef IN_RING3
+                /* Try sending it straight from guest memory first. */
+                if (pThis->pTxZcR3)
+                {
+                    rc = e1kXmitZeroCopy(pThis, fOnWorkerThread);
+                    if (rc != VERR_NOT_SUPPORTED)
+                    {
+                        if (RT_FAILURE(rc))
+                            goto out;
+                        continue;
+                    }
+                }
+#endif /* IN_RING3 */
                 /* Found a complete packet, allocate it. */
                 rc = e1kXmitAllocBuf(pThis, pThis->fGSO);
                 /* If we're out of bandwidth we'll come back later. */
@@ -6372,6 +6857,331 @@ static bool e1kAddressFilter(PE1KSTATE pThis, const void *pvBuf, size_t cb, E1KR
     return false;
 }
 
+/**
+ * Calculates the TCP checksum of an IPv4 frame considered for receive
+ * coalescing, including the pseudo header.
+ *
+ * @returns The checksum, 0 when verifying a segment with a correct checksum.
+ * @param   pbFrame         The frame (Ethernet header, IPv4 header without
+ *                          options, TCP header and payload).
+ * @param   cbFrame         The size of the frame trimmed to the IP length.
+ */
+static uint16_t e1kRxCoalTcpCSum(const uint8_t *pbFrame, size_t cbFrame)
+{
+    struct E1kIpHeader const *pIpHdr = (struct E1kIpHeader const *)(pbFrame + E1K_RXCOAL_IP_OFF);
+    size_t   cbTcp  = cbFrame - E1K_RXCOAL_TCP_OFF;
+    uint32_t u32Sum = (pIpHdr->src  & 0xffff) + (pIpHdr->src  >> 16)
+                    + (pIpHdr->dest & 0xffff) + (pIpHdr->dest >> 16)
+                    + RT_H2N_U16(6 /* TCP */) + RT_H2N_U16((uint16_t)cbTcp);
+    u32Sum += (uint16_t)~e1kCSum16(pbFrame + E1K_RXCOAL_TCP_OFF, cbTcp);
+    while (u32Sum >> 16)
+        u32Sum = (u32Sum >> 16) + (u32Sum & 0xFFFF);
+    return ~u32Sum;
+}
+
+/**
+ * Checks if a received frame can take part in receive coalescing.
+ *
+ * Only untagged IPv4 TCP segments without IP options and fragmentation that
+ * carry payload and have no flags other than ACK and PSH set qualify. Since
+ * the checksums of a merged frame are recalculated both checksums of the
+ * segment are verified here, so a corrupted segment still reaches the guest
+ * as it is.
+ *
+ * @returns Size of all headers (offset of the TCP payload), 0 if the frame
+ *          does not qualify.
+ * @param   pbFrame         The frame.
+ * @param   cb              The size of the frame.
+ * @param   pcbFrame        Where to return the size of the frame without
+ *                          any padding following the IP datagram.
+ * @param   pfPush          Where to return whether the PSH flag is set.
+ */
+static size_t e1kRxCoalParse(const uint8_t *pbFrame, size_t cb, size_t *pcbFrame, bool *pfPush)
+{
+    if (cb < E1K_RXCOAL_TCP_OFF + sizeof(struct E1kTcpHeader))
+        return 0;
+    if (*(uint16_t *)(pbFrame + 12) != RT_H2N_U16_C(0x0800))
+        return 0;
+
+    struct E1kIpHeader const *pIpHdr = (struct E1kIpHeader const *)(pbFrame + E1K_RXCOAL_IP_OFF);
+    if (pbFrame[E1K_RXCOAL_IP_OFF] != 0x45 /* IPv4, no options */)
+        return 0;
+    size_t cbIp = RT_BE2H_U16(pIpHdr->total_len);
+    if (   cbIp < sizeof(struct E1kIpHeader) + sizeof(struct E1kTcpHeader)
+        || cbIp > cb - E1K_RXCOAL_IP_OFF)
+        return 0;
+    if (RT_BE2H_U16(pIpHdr->offset) & (E1K_IP_MF | E1K_IP_OFFMASK))
+        return 0;
+    if (pbFrame[E1K_RXCOAL_IP_OFF + 9] != 6 /* TCP */)
+        return 0;
+
+    struct E1kTcpHeader const *pTcpHdr = (struct E1kTcpHeader const *)(pbFrame + E1K_RXCOAL_TCP_OFF);
+    uint16_t fFlags = RT_BE2H_U16(pTcpHdr->hdrlen_flags);
+    size_t   cbTcpHdr = (fFlags >> 12) * 4;
+    if (   cbTcpHdr < sizeof(struct E1kTcpHeader)
+        || cbTcpHdr >= cbIp - sizeof(struct E1kIpHeader))
+        return 0;
+    if ((fFlags & 0xff) & ~(E1K_TCP_ACK | E1K_TCP_PSH) || !(fFlags & E1K_TCP_ACK))
+        return 0;
+
+    size_t cbFrame = E1K_RXCOAL_IP_OFF + cbIp;
+    if (   e1kCSum16(pIpHdr, sizeof(*pIpHdr)) != 0
+        || e1kRxCoalTcpCSum(pbFrame, cbFrame) != 0)
+        return 0;
+
+    *pcbFrame = cbFrame;
+    *pfPush   = RT_BOOL(fFlags & E1K_TCP_PSH);
+    return E1K_RXCOAL_TCP_OFF + cbTcpHdr;
+}
+
+/**
+ * Returns the largest frame the receive coalescing may assemble.
+ *
+ * The guest sizes its receive buffers after its MTU, so a coalesced frame must
+ * not exceed one buffer (less the FCS we append) even though RCTL.LPE would let
+ * us pass up to E1K_MAX_RX_PKT_SIZE bytes.
+ *
+ * @returns Maximum frame size in bytes.
+ * @param   pThis           The device state structure.
+ */
+DECLINLINE(size_t) e1kRxCoalMaxFrame(PE1KSTATE pThis)
+{
+    size_t cbMax = pThis->u16RxBSize - (RCTL & RCTL_SECRC ? 0 : sizeof(uint32_t));
+    return RT_MIN(cbMax, E1K_RXCOAL_MAX_FRAME);
+}
+
+/**
+ * Checks if a qualifying segment continues the frame being assembled.
+ *
+ * @returns true if the payload can be appended.
+ * @param   pThis           The device state structure.
+ * @param   pbFrame         The segment.
+ * @param   cbFrame         The size of the segment.
+ * @param   cbHdrs          The size of the segment headers.
+ * @param   status          The status bits of the segment.
+ */
+static bool e1kRxCoalCanMerge(PE1KSTATE pThis, const uint8_t *pbFrame, size_t cbFrame, size_t cbHdrs, E1KRXDST status)
+{
+    const uint8_t *pbCoal = pThis->pbRxCoalFrameR3;
+
+    if (   cbHdrs != pThis->cbRxCoalHdrs
+        || status.fPIF != pThis->RxCoalStatus.fPIF
+        || pThis->cbRxCoal + cbFrame - cbHdrs > e1kRxCoalMaxFrame(pThis))
+        return false;
+
+    /* Same addresses, TOS, TTL and DF flag. */
+    struct E1kIpHeader const *pIpHdr     = (struct E1kIpHeader const *)(pbFrame + E1K_RXCOAL_IP_OFF);
+    struct E1kIpHeader const *pIpHdrCoal = (struct E1kIpHeader const *)(pbCoal + E1K_RXCOAL_IP_OFF);
+    if (   memcmp(pbFrame, pbCoal, E1K_RXCOAL_IP_OFF)
+        || pIpHdr->tos_ver_hl != pIpHdrCoal->tos_ver_hl
+        || pIpHdr->offset     != pIpHdrCoal->offset
+        || pIpHdr->ttl_proto  != pIpHdrCoal->ttl_proto
+        || pIpHdr->src        != pIpHdrCoal->src
+        || pIpHdr->dest       != pIpHdrCoal->dest)
+        return false;
+
+    /* Same connection, next in sequence, nothing new acknowledged or
+       advertised, identical options (timestamps included). */
+    struct E1kTcpHeader const *pTcpHdr     = (struct E1kTcpHeader const *)(pbFrame + E1K_RXCOAL_TCP_OFF);
+    struct E1kTcpHeader const *pTcpHdrCoal = (struct E1kTcpHeader const *)(pbCoal + E1K_RXCOAL_TCP_OFF);
+    if (   pTcpHdr->src   != pTcpHdrCoal->src
+        || pTcpHdr->dest  != pTcpHdrCoal->dest
+        || pTcpHdr->ackno != pTcpHdrCoal->ackno
+        || pTcpHdr->wnd   != pTcpHdrCoal->wnd
+        || RT_BE2H_U32(pTcpHdr->seqno) != pThis->uRxCoalNextSeq)
+        return false;
+    return memcmp(pTcpHdr + 1, pTcpHdrCoal + 1, cbHdrs - E1K_RXCOAL_TCP_OFF - sizeof(struct E1kTcpHeader)) == 0;
+}
+
+/**
+ * Passes the frame being assembled, if any, to the guest.
+ *
+ * Fixes up the IP length and both checksums if more than one segment went
+ * into the frame.
+ *
+ * @returns VBox status code.
+ * @param   pThis           The device state structure.
+ * @thread  RX, EMT
+ */
+static int e1kRxCoalFlush(PE1KSTATE pThis)
+{
+    Assert(PDMCritSectIsOwner(&pThis->csRxCoal));
+    size_t cbFrame = pThis->cbRxCoal;
+    if (!cbFrame)
+        return VINF_SUCCESS;
+    pThis->cbRxCoal = 0;
+    e1kCancelTimer(pThis, pThis->pRxCoalTimerR3);
+
+    uint8_t *pbFrame = pThis->pbRxCoalFrameR3;
+    if (pThis->cRxCoalSegs > 1)
+    {
+        struct E1kIpHeader  *pIpHdr  = (struct E1kIpHeader *)(pbFrame + E1K_RXCOAL_IP_OFF);
+        struct E1kTcpHeader *pTcpHdr = (struct E1kTcpHeader *)(pbFrame + E1K_RXCOAL_TCP_OFF);
+        pIpHdr->total_len = RT_H2BE_U16((uint16_t)(cbFrame - E1K_RXCOAL_IP_OFF));
+        pIpHdr->chksum    = 0;
+        pIpHdr->chksum    = e1kCSum16(pIpHdr, sizeof(*pIpHdr));
+        pTcpHdr->chksum   = 0;
+        pTcpHdr->chksum   = e1kRxCoalTcpCSum(pbFrame, cbFrame);
+        STAM_COUNTER_INC(&pThis->StatRxCoalFrames);
+    }
+    E1kLog2(("%s e1kRxCoalFlush: cb=%u segments=%u\n", pThis->szPrf, cbFrame, pThis->cRxCoalSegs));
+    int rc = e1kHandleRxPacket(pThis, pbFrame, cbFrame, pThis->RxCoalStatus);
+    if (RT_FAILURE(rc))
+    {
+        E1kLog(("%s e1kRxCoalFlush: Dropped %u coalesced segments, rc=%Rrc\n", pThis->szPrf, pThis->cRxCoalSegs, rc));
+        STAM_COUNTER_INC(&pThis->StatRxCoalFlushFailed);
+    }
+    return rc;
+}
+
+/**
+ * Drops the frame being assembled, if any.
+ *
+ * @param   pThis           The device state structure.
+ */
+static void e1kRxCoalDiscard(PE1KSTATE pThis)
+{
+    Assert(PDMCritSectIsOwner(&pThis->csRxCoal));
+    if (pThis->cbRxCoal)
+    {
+        E1kLog(("%s Discarding %u coalesced segments\n", pThis->szPrf, pThis->cRxCoalSegs));
+        pThis->cbRxCoal = 0;
+        e1kCancelTimer(pThis, pThis->pRxCoalTimerR3);
+    }
+}
+
+/**
+ * Receive Coalescing Timer handler.
+ *
+ * @remarks We only get here when a frame was held back longer than
+ *          cUsRxCoalTimeout, i.e. the flow has paused.
+ *
+ * @param   pDevIns     Pointer to device instance structure.
+ * @param   pTimer      Pointer to the timer.
+ * @param   pvUser      Pointer to the device state structure.
+ * @thread  EMT
+ */
+static DECLCALLBACK(void) e1kRxCoalTimer(PPDMDEVINS pDevIns, PTMTIMER pTimer, void *pvUser)
+{
+    PE1KSTATE pThis = (PE1KSTATE)pvUser;
+    Assert(PDMCritSectIsOwner(&pThis->csRxCoal));
+
+    if (!pThis->cbRxCoal)
+        return;
+    if (!(RCTL & RCTL_EN) || pThis->fLocked || !(STATUS & STATUS_LU))
+        e1kRxCoalDiscard(pThis);
+    else if (e1kCanReceive(pThis) == VINF_SUCCESS)
+    {
+        STAM_COUNTER_INC(&pThis->StatRxCoalFlushTimer);
+        int rc = e1kRxCoalFlush(pThis);
+        AssertLogRelMsg(RT_SUCCESS(rc) || rc == VERR_SEM_BUSY, ("%Rrc\n", rc)); NOREF(rc);
+    }
+    else
+    {
+        /* Do not drop the frame just because the guest is a bit behind. */
+        TMTimerSetMicro(pTimer, pThis->cUsRxCoalTimeout);
+    }
+}
+
+/**
+ * Coalescing variant of e1kHandleRxPacket.
+ *
+ * In-order TCP segments of the same connection are merged into a single large
+ * frame as long as the guest accepts long frames (RCTL.LPE), which cuts down on
+ * descriptors, interrupts and guest stack work for bulk transfers. A frame is
+ * passed on when the next segment does not continue it, when it is about to
+ * become too large, when a segment with PSH set is appended or when the timer
+ * expires. Everything else is passed to e1kHandleRxPacket right away, after the
+ * frame being assembled so the guest sees all frames in order.
+ *
+ * @returns VBox status code.
+ * @param   pThis           The device state structure.
+ * @param   pvBuf           The received frame.
+ * @param   cb              The size of the frame.
+ * @param   status          Bit fields containing status info.
+ * @thread  RX
+ */
+static int e1kRxCoalReceive(PE1KSTATE pThis, const void *pvBuf, size_t cb, E1KRXDST status)
+{
+    int rc = PDMCritSectEnter(&pThis->csRxCoal, VERR_SEM_BUSY);
+    if (RT_UNLIKELY(rc != VINF_SUCCESS))
+        return rc;
+
+    const uint8_t *pbFrame = (const uint8_t *)pvBuf;
+    size_t         cbFrame = 0;
+    bool           fPush   = false;
+    size_t         cbHdrs  = 0;
+    if (!status.fVP && (RCTL & RCTL_LPE))
+        cbHdrs = e1kRxCoalParse(pbFrame, cb, &cbFrame, &fPush);
+    if (cbHdrs)
+    {
+        size_t cbPayload = cbFrame - cbHdrs;
+        if (pThis->cbRxCoal && e1kRxCoalCanMerge(pThis, pbFrame, cbFrame, cbHdrs, status))
+        {
+            memcpy(pThis->pbRxCoalFrameR3 + pThis->cbRxCoal, pbFrame + cbHdrs, cbPayload);
+            pThis->cbRxCoal       += (uint32_t)cbPayload;
+            pThis->uRxCoalNextSeq += (uint32_t)cbPayload;
+            pThis->cRxCoalSegs++;
+            STAM_COUNTER_INC(&pThis->StatRxCoalSegments);
+            if (fPush)
+            {
+                /* The sender wants the data delivered now. */
+                struct E1kTcpHeader *pTcpHdr = (struct E1kTcpHeader *)(pThis->pbRxCoalFrameR3 + E1K_RXCOAL_TCP_OFF);
+                pTcpHdr->hdrlen_flags |= RT_H2BE_U16_C(E1K_TCP_PSH);
+                STAM_COUNTER_INC(&pThis->StatRxCoalFlushPush);
+                rc = e1kRxCoalFlush(pThis);
+            }
+            else if (   pThis->cRxCoalSegs >= E1K_RXCOAL_MAX_SEGS
+                     || pThis->cbRxCoal + cbPayload > e1kRxCoalMaxFrame(pThis))
+            {
+                /* Another segment of this size would not fit anyway. */
+                STAM_COUNTER_INC(&pThis->StatRxCoalFlushLimit);
+                rc = e1kRxCoalFlush(pThis);
+            }
+            PDMCritSectLeave(&pThis->csRxCoal);
+            return rc;
+        }
+
+        if (pThis->cbRxCoal)
+        {
+            STAM_COUNTER_INC(&pThis->StatRxCoalFlushMismatch);
+            rc = e1kRxCoalFlush(pThis);
+            if (RT_FAILURE(rc))
+            {
+                PDMCritSectLeave(&pThis->csRxCoal);
+                return rc;
+            }
+        }
+        if (!fPush && cbFrame < e1kRxCoalMaxFrame(pThis))
+        {
+            struct E1kTcpHeader const *pTcpHdr = (struct E1kTcpHeader const *)(pbFrame + E1K_RXCOAL_TCP_OFF);
+            memcpy(pThis->pbRxCoalFrameR3, pbFrame, cbFrame);
+            pThis->cbRxCoal       = (uint32_t)cbFrame;
+            pThis->cbRxCoalHdrs   = (uint16_t)cbHdrs;
+            pThis->cRxCoalSegs    = 1;
+            pThis->uRxCoalNextSeq = RT_BE2H_U32(pTcpHdr->seqno) + (uint32_t)cbPayload;
+            pThis->RxCoalStatus   = status;
+            TMTimerSetMicro(pThis->pRxCoalTimerR3, pThis->cUsRxCoalTimeout);
+            PDMCritSectLeave(&pThis->csRxCoal);
+            return VINF_SUCCESS;
+        }
+    }
+    else if (pThis->cbRxCoal)
+    {
+        STAM_COUNTER_INC(&pThis->StatRxCoalFlushMismatch);
+        rc = e1kRxCoalFlush(pThis);
+        if (RT_FAILURE(rc))
+        {
+            PDMCritSectLeave(&pThis->csRxCoal);
+            return rc;
+        }
+    }
+
+    rc = e1kHandleRxPacket(pThis, pvBuf, cb, status);
+    PDMCritSectLeave(&pThis->csRxCoal);
+    return rc;
+}
+
 /**
  * @interface_method_impl{PDMINETWORKDOWN,pfnReceive}
  */
@@ -6419,7 +7229,10 @@ static DECLCALLBACK(int) e1kR3NetworkDown_Receive(PPDMINETWORKDOWN pInterface, c
     STAM_PROFILE_ADV_STOP(&pThis->StatReceiveFilter, a);
     if (fPassed)
     {
-        rc = e1kHandleRxPacket(pThis, pvBuf, cb, status);
+        if (pThis->fRxCoalescing)
+            rc = e1kRxCoalReceive(pThis, pvBuf, cb, status);
+        else
+            rc = e1kHandleRxPacket(pThis, pvBuf, cb, status);
     }
     //e1kCsLeave(pThis);
     STAM_PROFILE_ADV_STOP(&pThis->StatReceive, a);
@@ -6559,6 +7372,18 @@ static DECLCALLBACK(int) e1kSavePrep(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
 {
     PE1KSTATE pThis = PDMINS_2_DATA(pDevIns, E1KSTATE*);
 
+    /* The frame being assembled is not part of the saved state, hand it over.
+       If the guest cannot take it the frame is lost as it would be on the wire,
+       that is no reason to fail the save. */
+    if (pThis->fRxCoalescing)
+    {
+        PDMCritSectEnter(&pThis->csRxCoal, VERR_IGNORED);
+        int rc2 = e1kRxCoalFlush(pThis);
+        if (RT_FAILURE(rc2))
+            LogRel(("%s: Dropped the coalesced receive frame before saving, rc=%Rrc\n", pThis->szPrf, rc2));
+        PDMCritSectLeave(&pThis->csRxCoal);
+    }
+
     int rc = e1kCsEnter(pThis, VERR_SEM_BUSY);
     if (RT_UNLIKELY(rc != VINF_SUCCESS))
         return rc;
@@ -7225,6 +8050,12 @@ static DECLCALLBACK(void) e1kR3Reset(PPDMDEVINS pDevIns)
 #endif /* E1K_TX_DELAY */
     e1kCancelTimer(pThis, pThis->CTX_SUFF(pIntTimer));
     e1kCancelTimer(pThis, pThis->CTX_SUFF(pLUTimer));
+    if (pThis->fRxCoalescing)
+    {
+        PDMCritSectEnter(&pThis->csRxCoal, VERR_IGNORED);
+        e1kRxCoalDiscard(pThis);
+        PDMCritSectLeave(&pThis->csRxCoal);
+    }
     e1kXmitFreeBuf(pThis);
     pThis->u16TxPktLen  = 0;
     pThis->fIPcsum      = false;
@@ -7311,9 +8142,21 @@ static DECLCALLBACK(int) e1kR3Destruct(PPDMDEVINS pDevIns)
 #ifdef E1K_WITH_TX_CS
         PDMR3CritSectDelete(&pThis->csTx);
 #endif /* E1K_WITH_TX_CS */
+        if (PDMCritSectIsInitialized(&pThis->csRxCoal))
+            PDMR3CritSectDelete(&pThis->csRxCoal);
         PDMR3CritSectDelete(&pThis->csRx);
         PDMR3CritSectDelete(&pThis->cs);
     }
+    if (pThis->pbRxCoalFrameR3)
+    {
+        MMR3HeapFree(pThis->pbRxCoalFrameR3);
+        pThis->pbRxCoalFrameR3 = NULL;
+    }
+    if (pThis->pTxZcR3)
+    {
+        MMR3HeapFree(pThis->pTxZcR3);
+        pThis->pTxZcR3 = NULL;
+    }
     return VINF_SUCCESS;
 }
 
@@ -7450,7 +8293,8 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
      */
     if (!CFGMR3AreValuesValid(pCfg, "MAC\0" "CableConnected\0" "AdapterType\0"
                                     "LineSpeed\0" "GCEnabled\0" "R0Enabled\0"
-                                    "EthernetCRC\0" "GSOEnabled\0" "LinkUpDelay\0"))
+                                    "EthernetCRC\0" "GSOEnabled\0" "LinkUpDelay\0"
+                                    "RxCoalescing\0" "RxCoalescingTimeout\0" "TxZeroCopy\0"))
         return PDMDEV_SET_ERROR(pDevIns, VERR_PDM_DEVINS_UNKNOWN_CFG_VALUES,
                                 N_("Invalid configuration for E1000 device"));
 
@@ -7505,10 +8349,30 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
     else if (pThis->cMsLinkUpDelay == 0)
         LogRel(("%s WARNING! Link up delay is disabled!\n", pThis->szPrf));
 
-    E1kLog(("%s Chip=%s LinkUpDelay=%ums EthernetCRC=%s GSO=%s R0=%s GC=%s\n", pThis->szPrf,
+    rc = CFGMR3QueryBoolDef(pCfg, "RxCoalescing", &pThis->fRxCoalescing, false);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc,
+                                N_("Configuration error: Failed to get the value of 'RxCoalescing'"));
+
+    rc = CFGMR3QueryU32Def(pCfg, "RxCoalescingTimeout", &pThis->cUsRxCoalTimeout, E1K_RXCOAL_DEF_TIMEOUT); /* us */
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc,
+                                N_("Configuration error: Failed to get the value of 'RxCoalescingTimeout'"));
+    if (pThis->cUsRxCoalTimeout == 0 || pThis->cUsRxCoalTimeout > 10000)
+        return PDMDEV_SET_ERROR(pDevIns, VERR_OUT_OF_RANGE,
+                                N_("Configuration error: 'RxCoalescingTimeout' must be between 1 and 10000 microseconds"));
+
+    rc = CFGMR3QueryBoolDef(pCfg, "TxZeroCopy", &pThis->fTxZeroCopy, false);
+    if (RT_FAILURE(rc))
+        return PDMDEV_SET_ERROR(pDevIns, rc,
+                                N_("Configuration error: Failed to get the value of 'TxZeroCopy'"));
+
+    E1kLog(("%s Chip=%s LinkUpDelay=%ums EthernetCRC=%s GSO=%s RxCoalescing=%s TxZeroCopy=%s R0=%s GC=%s\n", pThis->szPrf,
             g_Chips[pThis->eChip].pcszName, pThis->cMsLinkUpDelay,
             pThis->fEthernetCRC ? "on" : "off",
             pThis->fGSOEnabled ? "enabled" : "disabled",
+            pThis->fRxCoalescing ? "enabled" : "disabled",
+            pThis->fTxZeroCopy ? "enabled" : "disabled",
             pThis->fR0Enabled ? "enabled" : "disabled",
             pThis->fRCEnabled ? "enabled" : "disabled"));
 
@@ -7534,6 +8398,23 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
     if (RT_FAILURE(rc))
         return rc;
 #endif /* E1K_WITH_TX_CS */
+    if (pThis->fRxCoalescing)
+    {
+        rc = PDMDevHlpCritSectInit(pDevIns, &pThis->csRxCoal, RT_SRC_POS, "E1000#%dRXC", iInstance);
+        if (RT_FAILURE(rc))
+            return rc;
+        pThis->pbRxCoalFrameR3 = (uint8_t *)PDMDevHlpMMHeapAlloc(pDevIns, E1K_MAX_RX_PKT_SIZE);
+        if (!pThis->pbRxCoalFrameR3)
+            return VERR_NO_MEMORY;
+    }
+#ifdef E1K_WITH_TXD_CACHE
+    if (pThis->fTxZeroCopy)
+    {
+        pThis->pTxZcR3 = (PE1KTXZC)PDMDevHlpMMHeapAllocZ(pDevIns, sizeof(E1KTXZC));
+        if (!pThis->pTxZcR3)
+            return VERR_NO_MEMORY;
+    }
+#endif /* E1K_WITH_TXD_CACHE */
 
     /* Saved state registration. */
     rc = PDMDevHlpSSMRegisterEx(pDevIns, E1K_SAVEDSTATE_VERSION, sizeof(E1KSTATE), NULL,
@@ -7598,6 +8479,17 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
     TMR3TimerSetCritSect(pThis->pTXDTimerR3, &pThis->csTx);
 #endif /* E1K_TX_DELAY */
 
+    if (pThis->fRxCoalescing)
+    {
+        /* Create Receive Coalescing Timer */
+        rc = PDMDevHlpTMTimerCreate(pDevIns, TMCLOCK_VIRTUAL, e1kRxCoalTimer, pThis,
+                                    TMTIMER_FLAGS_NO_CRIT_SECT,
+                                    "E1000 Receive Coalescing Timer", &pThis->pRxCoalTimerR3);
+        if (RT_FAILURE(rc))
+            return rc;
+        TMR3TimerSetCritSect(pThis->pRxCoalTimerR3, &pThis->csRxCoal);
+    }
+
 #ifdef E1K_USE_TX_TIMERS
     /* Create Transmit Interrupt Delay Timer */
     rc = PDMDevHlpTMTimerCreate(pDevIns, TMCLOCK_VIRTUAL, e1kTxIntDelayTimer, pThis,
@@ -7742,7 +8634,16 @@ static DECLCALLBACK(int) e1kR3Construct(PPDMDEVINS pDevIns, int iInstance, PCFGM
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatTxPathFallback,     STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,     "Fallback TSE descriptor path",       "/Devices/E1k%d/TxPath/Fallback", iInstance);
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatTxPathGSO,          STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,     "GSO TSE descriptor path",            "/Devices/E1k%d/TxPath/GSO", iInstance);
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatTxPathRegular,      STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,     "Regular descriptor path",            "/Devices/E1k%d/TxPath/Normal", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatTxZeroCopy,         STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,     "Frames sent from guest memory",      "/Devices/E1k%d/TxPath/ZeroCopy", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatTxZeroCopyFallback, STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,     "Frames that had to be copied after all", "/Devices/E1k%d/TxPath/ZeroCopyFallback", iInstance);
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatPHYAccesses,        STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,     "Number of PHY accesses",             "/Devices/E1k%d/PHYAccesses", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatRxCoalSegments,     STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,     "Segments merged into a preceding one", "/Devices/E1k%d/RxCoal/Segments", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatRxCoalFrames,       STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,     "Coalesced frames passed to the guest", "/Devices/E1k%d/RxCoal/Frames", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatRxCoalFlushTimer,   STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,     "Flushes on timer expiration",        "/Devices/E1k%d/RxCoal/FlushTimer", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatRxCoalFlushMismatch, STAMTYPE_COUNTER, STAMVISIBILITY_USED,  STAMUNIT_OCCURENCES,     "Flushes on a non-matching frame",    "/Devices/E1k%d/RxCoal/FlushMismatch", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatRxCoalFlushLimit,   STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,     "Flushes on reaching the size limit", "/Devices/E1k%d/RxCoal/FlushLimit", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatRxCoalFlushPush,    STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,     "Flushes on a segment with PSH set",  "/Devices/E1k%d/RxCoal/FlushPush", iInstance);
+    PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatRxCoalFlushFailed,  STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,     "Coalesced frames the guest did not take", "/Devices/E1k%d/RxCoal/FlushFailed", iInstance);
     for (unsigned iReg = 0; iReg < E1K_NUM_OF_REGS; iReg++)
     {
         PDMDevHlpSTAMRegisterF(pDevIns, &pThis->aStatRegReads[iReg],   STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
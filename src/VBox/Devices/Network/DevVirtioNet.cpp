@@ -32,6 +32,8 @@
 #ifdef IN_RING3
 # include <iprt/mem.h>
 # include <iprt/uuid.h>
+# include <VBox/param.h>
+# include <VBox/vmm/pgm.h>
 #endif /* IN_RING3 */
 #include "VBoxDD.h"
 #include "../VirtIO/Virtio.h"
@@ -93,6 +95,17 @@
 
 #define VNET_S_LINK_UP    1
 
+/** Host offloads that cannot be offered when the rings may be handed to the
+ * host kernel: the kernel strips the virtio-net header on transmit. */
+#define VNET_VHOST_HOST_OFFLOADS (VNET_F_CSUM | VNET_F_HOST_TSO4 | VNET_F_HOST_TSO6 | VNET_F_HOST_ECN | VNET_F_HOST_UFO)
+/** The PDMINETWORKVHOST ring index of the receive queue. */
+#define VNET_VHOST_RING_RX       0
+/** The PDMINETWORKVHOST ring index of the transmit queue. */
+#define VNET_VHOST_RING_TX       1
+/** The maximum number of guest pages kept mapped for the kernel, ring pages
+ * included.  Well below the default vhost IOTLB size (max_iotlb_entries). */
+#define VNET_VHOST_MAX_PAGES     1024
+
 
 /*******************************************************************************
 *   Structures and Typedefs                                                    *
@@ -108,6 +121,21 @@ struct __attribute__ ((__packed__)) VNetPCIConfig /** @todo r=bird: Use #pragma
 };
 AssertCompileMemberOffset(struct VNetPCIConfig, uStatus, 6);
 
+/**
+ * A guest page mapped for the host kernel while it owns the rings.
+ */
+typedef struct VNETVHOSTPAGE
+{
+    /** The guest physical address of the page. */
+    RTGCPHYS                GCPhys;
+    /** Where the page is mapped. */
+    RTR3PTR                 pvR3;
+    /** The mapping lock. */
+    PGMPAGEMAPLOCK          Lock;
+} VNETVHOSTPAGE;
+/** Pointer to a guest page mapped for the host kernel. */
+typedef VNETVHOSTPAGE *PVNETVHOSTPAGE;
+
 /**
  * Device state structure. Holds the current state of device.
  *
@@ -195,6 +223,37 @@ typedef struct VNetState_st
     /** EMT: Gets signalled when more RX descriptors become available. */
     RTSEMEVENT              hEventMoreRxDescAvail;
 
+    /* Kernel data path related fields **************************************/
+
+    /** The kernel virtqueue offload interface of the attached driver, if any. */
+    R3PTRTYPE(PPDMINETWORKVHOST) pDrvVhost;
+    /** Thread turning kernel completions into guest interrupts. */
+    R3PTRTYPE(PPDMTHREAD)   pVhostThread;
+    /** The guest pages the kernel has translations for, VNET_VHOST_MAX_PAGES
+     * entries.  The ring pages come first and stay until the rings are taken
+     * back, the others are replaced in FIFO order.  Protected by the device
+     * critical section. */
+    R3PTRTYPE(PVNETVHOSTPAGE) paVhostPages;
+    /** Number of used entries in paVhostPages. */
+    uint32_t                cVhostPages;
+    /** Number of ring pages at the start of paVhostPages. */
+    uint32_t                cVhostRingPages;
+    /** The entry to replace next once paVhostPages is full. */
+    uint32_t                iVhostPageNext;
+    /** The PGM RAM range generation the translations were made with. */
+    uint32_t                idVhostRamGen;
+    /** Whether the driver attached at construction offered the kernel data
+     * path.  Host offloads are not advertised to the guest if so. */
+    bool                    fVhostCapable;
+    /** Set while the kernel owns the RX and TX rings. */
+    bool volatile           fVhostActive;
+    /** Set when handing over the rings failed, cleared on reset. */
+    bool                    fVhostFailed;
+    bool                    afVhostAlignment[1];
+#if HC_ARCH_BITS == 64
+    uint32_t                u32VhostAlignment;
+#endif
+
     /** @name Statistic
      * @{ */
     STAMCOUNTER             StatReceiveBytes;
@@ -203,6 +262,9 @@ typedef struct VNetState_st
     STAMCOUNTER             StatTransmitPackets;
     STAMCOUNTER             StatTransmitGSO;
     STAMCOUNTER             StatTransmitCSum;
+    STAMCOUNTER             StatVhostKicks;
+    STAMCOUNTER             StatVhostInterrupts;
+    STAMCOUNTER             StatVhostMisses;
 #if defined(VBOX_WITH_STATISTICS)
     STAMPROFILE             StatReceive;
     STAMPROFILE             StatReceiveStore;
@@ -368,6 +430,7 @@ DECLINLINE(void) vnetPrintFeatures(PVNETSTATE pThis, uint32_t fFeatures, const c
 
 static DECLCALLBACK(uint32_t) vnetIoCb_GetHostFeatures(void *pvState)
 {
+    PVNETSTATE pThis = (PVNETSTATE)pvState;
     /* We support:
      * - Host-provided MAC address
      * - Link status reporting in config space
@@ -376,7 +439,7 @@ static DECLCALLBACK(uint32_t) vnetIoCb_GetHostFeatures(void *pvState)
      * - MAC filter table
      * - VLAN filter
      */
-    return VNET_F_MAC
+    uint32_t fFeatures = VNET_F_MAC
         | VNET_F_STATUS
         | VNET_F_CTRL_VQ
         | VNET_F_CTRL_RX
@@ -395,6 +458,9 @@ static DECLCALLBACK(uint32_t) vnetIoCb_GetHostFeatures(void *pvState)
         | VNET_F_MRG_RXBUF
 #endif
         ;
+    if (pThis->fVhostCapable)
+        fFeatures &= ~VNET_VHOST_HOST_OFFLOADS;
+    return fFeatures;
 }
 
 static DECLCALLBACK(uint32_t) vnetIoCb_GetHostMinimalFeatures(void *pvState)
@@ -437,6 +503,10 @@ static DECLCALLBACK(int) vnetIoCb_SetConfig(void *pvState, uint32_t offCfg, uint
     return VINF_SUCCESS;
 }
 
+#ifdef IN_RING3
+static void vnetVhostStop(PVNETSTATE pThis);
+#endif
+
 /**
  * Hardware reset. Revert all registers to initial values.
  *
@@ -447,6 +517,15 @@ static DECLCALLBACK(int) vnetIoCb_Reset(void *pvState)
     PVNETSTATE pThis = (PVNETSTATE)pvState;
     Log(("%s Reset triggered\n", INSTANCE(pThis)));
 
+#ifdef IN_RING3
+    /* The kernel has to let go of the rings before they are reset. */
+    vnetVhostStop(pThis);
+    pThis->fVhostFailed = false;
+#else
+    if (pThis->fVhostActive)
+        return VINF_IOM_R3_IOPORT_WRITE;
+#endif
+
     int rc = vnetCsRxEnter(pThis, VERR_SEM_BUSY);
     if (RT_UNLIKELY(rc != VINF_SUCCESS))
     {
@@ -630,6 +709,8 @@ static int vnetCanReceive(PVNETSTATE pThis)
     LogFlow(("%s vnetCanReceive\n", INSTANCE(pThis)));
     if (!(pThis->VPCI.uStatus & VPCI_STATUS_DRV_OK))
         rc = VERR_NET_NO_BUFFER_SPACE;
+    else if (pThis->fVhostActive)
+        rc = VERR_NET_NO_BUFFER_SPACE;
     else if (!vqueueIsReady(&pThis->VPCI, pThis->pRxQueue))
         rc = VERR_NET_NO_BUFFER_SPACE;
     else if (vqueueIsEmpty(&pThis->VPCI, pThis->pRxQueue))
@@ -670,6 +751,9 @@ static DECLCALLBACK(int) vnetNetworkDown_WaitReceiveAvail(PPDMINETWORKDOWN pInte
     while (RT_LIKELY(   (enmVMState = PDMDevHlpVMState(pThis->VPCI.CTX_SUFF(pDevIns))) == VMSTATE_RUNNING
                      ||  enmVMState == VMSTATE_RUNNING_LS))
     {
+        /* The driver must not sit in here while the kernel owns the rings. */
+        if (pThis->fVhostActive)
+            break;
         int rc2 = vnetCanReceive(pThis);
         if (RT_SUCCESS(rc2))
         {
@@ -1064,9 +1148,464 @@ static DECLCALLBACK(int) vnetSetLinkState(PPDMINETWORKCONFIG pInterface, PDMNETW
     return VINF_SUCCESS;
 }
 
+/* -=-=-=-=- Kernel data path -=-=-=-=- */
+
+/**
+ * Releases the mappings of the given guest pages.
+ *
+ * The kernel must not have translations for them any more.
+ *
+ * @param   pThis           The device state structure.
+ * @param   iFirst          The first entry in paVhostPages.
+ * @param   iEnd            The end of the range of entries.
+ */
+static void vnetVhostReleasePages(PVNETSTATE pThis, uint32_t iFirst, uint32_t iEnd)
+{
+    PPDMDEVINS pDevIns = pThis->VPCI.CTX_SUFF(pDevIns);
+    for (uint32_t i = iFirst; i < iEnd; i++)
+        PDMDevHlpPhysReleasePageMappingLock(pDevIns, &pThis->paVhostPages[i].Lock);
+}
+
+/**
+ * Withdraws all translations made on demand, keeping the ring pages.
+ *
+ * Called when PGM has changed the RAM ranges, as guest physical addresses
+ * may no longer refer to the pages we mapped.
+ *
+ * @param   pThis           The device state structure.
+ * @thread  Any, owns the device critical section.
+ */
+static void vnetVhostFlushPages(PVNETSTATE pThis)
+{
+    PPDMINETWORKVHOST pVhost = pThis->pDrvVhost;
+    for (uint32_t i = pThis->cVhostRingPages; i < pThis->cVhostPages; i++)
+        pVhost->pfnUnmap(pVhost, pThis->paVhostPages[i].GCPhys, PAGE_SIZE);
+    vnetVhostReleasePages(pThis, pThis->cVhostRingPages, pThis->cVhostPages);
+    pThis->cVhostPages    = pThis->cVhostRingPages;
+    pThis->iVhostPageNext = pThis->cVhostRingPages;
+    Log(("%s vnetVhostFlushPages: RAM ranges changed, %u ring pages kept\n", INSTANCE(pThis), pThis->cVhostRingPages));
+}
+
+/**
+ * Flushes the on-demand translations if PGM has changed the RAM ranges since
+ * they were made.
+ *
+ * @param   pThis           The device state structure.
+ * @thread  Any, owns the device critical section.
+ */
+static void vnetVhostCheckRamGen(PVNETSTATE pThis)
+{
+    uint32_t idRamGen = PGMR3PhysGetRamRangeGeneration(PDMDevHlpGetVM(pThis->VPCI.CTX_SUFF(pDevIns)));
+    if (idRamGen != pThis->idVhostRamGen)
+    {
+        vnetVhostFlushPages(pThis);
+        pThis->idVhostRamGen = idRamGen;
+    }
+}
+
+/**
+ * Maps the guest pages spanned by a ring structure and records them as ring
+ * pages.
+ *
+ * @returns VBox status code.
+ * @param   pThis           The device state structure.
+ * @param   GCPhys          The guest physical address of the structure.
+ * @param   cb              The size of the structure.
+ * @thread  EMT, owns the device critical section.
+ */
+static int vnetVhostMapRingPages(PVNETSTATE pThis, RTGCPHYS GCPhys, size_t cb)
+{
+    PPDMDEVINS pDevIns = pThis->VPCI.CTX_SUFF(pDevIns);
+    RTGCPHYS const GCPhysLast = GCPhys + cb - 1;
+    for (RTGCPHYS GCPhysPage = GCPhys & ~(RTGCPHYS)PAGE_OFFSET_MASK; GCPhysPage <= GCPhysLast; GCPhysPage += PAGE_SIZE)
+    {
+        bool fMapped = false;
+        for (uint32_t i = 0; i < pThis->cVhostPages && !fMapped; i++)
+            fMapped = pThis->paVhostPages[i].GCPhys == GCPhysPage;
+        if (fMapped)
+            continue;
+
+        if (pThis->cVhostPages >= VNET_VHOST_MAX_PAGES / 2)
+            return VERR_TOO_MUCH_DATA;
+        PVNETVHOSTPAGE pPage = &pThis->paVhostPages[pThis->cVhostPages];
+        void *pv;
+        int rc = PDMDevHlpPhysGCPhys2CCPtr(pDevIns, GCPhysPage, 0 /*fFlags*/, &pv, &pPage->Lock);
+        if (RT_FAILURE(rc))
+            return rc;
+        pPage->GCPhys = GCPhysPage;
+        pPage->pvR3   = pv;
+        pThis->cVhostPages++;
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * Hands the RX and TX rings to the host kernel if the attached driver
+ * supports it and nothing prevents it.
+ *
+ * This is attempted on every queue notification, so conditions that prevent
+ * it now (rings not set up, VM being saved) do not stop it for good.
+ *
+ * Only the ring pages are mapped up front, the kernel asks for the buffer
+ * pages as it comes across them (see vnetVhostHandleMiss).
+ *
+ * @param   pThis           The device state structure.
+ * @thread  EMT
+ */
+static void vnetVhostStart(PVNETSTATE pThis)
+{
+    PPDMINETWORKVHOST pVhost = pThis->pDrvVhost;
+    if (   pThis->fVhostActive
+        || pThis->fVhostFailed
+        || !pVhost
+        || !pThis->pVhostThread
+        || !(pThis->VPCI.uStatus & VPCI_STATUS_DRV_OK)
+        || !vqueueIsReady(&pThis->VPCI, pThis->pRxQueue)
+        || !vqueueIsReady(&pThis->VPCI, pThis->pTxQueue)
+        /* Pages written by the kernel escape the live save dirty tracking. */
+        || PDMDevHlpVMState(pThis->VPCI.CTX_SUFF(pDevIns)) != VMSTATE_RUNNING)
+        return;
+
+    int rc = vnetCsEnter(pThis, VERR_SEM_BUSY);
+    AssertRCReturnVoid(rc);
+    if (pThis->fVhostActive || pThis->fVhostFailed)
+    {
+        vnetCsLeave(pThis);
+        return;
+    }
+
+    uint64_t fVhostFeatures = 0;
+    rc = pVhost->pfnGetFeatures(pVhost, &fVhostFeatures);
+    if (RT_SUCCESS(rc) && (pThis->VPCI.uGuestFeatures & VNET_VHOST_HOST_OFFLOADS))
+        rc = VERR_NOT_SUPPORTED;
+
+    /* Take the transmit path away from user space and let the receive thread go. */
+    if (RT_SUCCESS(rc) && !ASMAtomicCmpXchgU32(&pThis->uIsTransmitting, 1, 0))
+    {
+        /* Try again on the next notification. */
+        vnetCsLeave(pThis);
+        return;
+    }
+    if (RT_SUCCESS(rc))
+    {
+#ifdef VNET_TX_DELAY
+        TMTimerStop(pThis->CTX_SUFF(pTxTimer));
+#endif
+        ASMAtomicWriteBool(&pThis->fVhostActive, true);
+        vnetWakeupReceive(pThis->VPCI.CTX_SUFF(pDevIns));
+
+        Assert(!pThis->cVhostPages);
+        pThis->idVhostRamGen = PGMR3PhysGetRamRangeGeneration(PDMDevHlpGetVM(pThis->VPCI.CTX_SUFF(pDevIns)));
+
+        PVQUEUE const   apQueues[] = { pThis->pRxQueue, pThis->pTxQueue };
+        PDMNETVHOSTRING aRings[RT_ELEMENTS(apQueues)];
+        AssertCompile(VNET_VHOST_RING_RX == 0 && VNET_VHOST_RING_TX == 1);
+        for (unsigned i = 0; i < RT_ELEMENTS(aRings) && RT_SUCCESS(rc); i++)
+        {
+            PVRING pVRing = &apQueues[i]->VRing;
+            aRings[i].cEntries    = pVRing->uSize;
+            aRings[i].idxAvail    = apQueues[i]->uNextAvailIndex;
+            aRings[i].u16Reserved = 0;
+            aRings[i].GCPhysDesc  = pVRing->addrDescriptors;
+            aRings[i].GCPhysAvail = pVRing->addrAvail;
+            aRings[i].GCPhysUsed  = pVRing->addrUsed;
+            rc = vnetVhostMapRingPages(pThis, pVRing->addrDescriptors, pVRing->uSize * sizeof(VRINGDESC));
+            if (RT_SUCCESS(rc))
+                rc = vnetVhostMapRingPages(pThis, pVRing->addrAvail,
+                                           RT_OFFSETOF(VRINGAVAIL, auRing) + pVRing->uSize * sizeof(uint16_t));
+            if (RT_SUCCESS(rc))
+                rc = vnetVhostMapRingPages(pThis, pVRing->addrUsed,
+                                           RT_OFFSETOF(VRINGUSED, aRing) + pVRing->uSize * sizeof(VRINGUSEDELEM));
+        }
+
+        if (RT_SUCCESS(rc))
+        {
+            PDMNETVHOSTMEMREGION aRegions[VNET_VHOST_MAX_PAGES / 2];
+            for (uint32_t i = 0; i < pThis->cVhostPages; i++)
+            {
+                aRegions[i].GCPhys = pThis->paVhostPages[i].GCPhys;
+                aRegions[i].cb     = PAGE_SIZE;
+                aRegions[i].pvR3   = pThis->paVhostPages[i].pvR3;
+            }
+            pThis->cVhostRingPages = pThis->cVhostPages;
+            pThis->iVhostPageNext  = pThis->cVhostPages;
+            rc = pVhost->pfnStart(pVhost, pThis->VPCI.uGuestFeatures & fVhostFeatures,
+                                  aRegions, pThis->cVhostPages, aRings, RT_ELEMENTS(aRings));
+        }
+        if (RT_FAILURE(rc))
+        {
+            vnetVhostReleasePages(pThis, 0, pThis->cVhostPages);
+            pThis->cVhostPages = pThis->cVhostRingPages = pThis->iVhostPageNext = 0;
+            ASMAtomicWriteBool(&pThis->fVhostActive, false);
+        }
+        ASMAtomicWriteU32(&pThis->uIsTransmitting, 0);
+    }
+
+    if (RT_SUCCESS(rc))
+        LogRel(("%s Kernel data path started (%u ring pages mapped)\n", INSTANCE(pThis), pThis->cVhostRingPages));
+    else
+    {
+        LogRel(("%s Cannot hand the rings to the kernel (%Rrc), using the user space data path until reset\n",
+                INSTANCE(pThis), rc));
+        pThis->fVhostFailed = true;
+    }
+    vnetCsLeave(pThis);
+}
+
+/**
+ * Takes the RX and TX rings back from the host kernel.
+ *
+ * @param   pThis           The device state structure.
+ * @thread  EMT
+ */
+static void vnetVhostStop(PVNETSTATE pThis)
+{
+    if (!pThis->fVhostActive)
+        return;
+
+    int rc = vnetCsEnter(pThis, VERR_SEM_BUSY);
+    AssertRCReturnVoid(rc);
+    if (pThis->fVhostActive)
+    {
+        PPDMINETWORKVHOST pVhost = pThis->pDrvVhost;
+        PVQUEUE const     apQueues[] = { pThis->pRxQueue, pThis->pTxQueue };
+        uint16_t          aidxAvail[RT_ELEMENTS(apQueues)];
+        rc = pVhost->pfnStop(pVhost, aidxAvail, RT_ELEMENTS(aidxAvail));
+        for (unsigned i = 0; i < RT_ELEMENTS(apQueues); i++)
+        {
+            PVQUEUE pQueue = apQueues[i];
+            pQueue->uNextUsedIndex = vringReadUsedIndex(&pThis->VPCI, &pQueue->VRing);
+            /* Should the kernel not tell, assume everything it picked up was completed. */
+            pQueue->uNextAvailIndex = RT_SUCCESS(rc) ? aidxAvail[i] : pQueue->uNextUsedIndex;
+            vringSetNotification(&pThis->VPCI, &pQueue->VRing, true);
+        }
+        /* The kernel is done with the pages once it has let go of the rings. */
+        vnetVhostReleasePages(pThis, 0, pThis->cVhostPages);
+        pThis->cVhostPages = pThis->cVhostRingPages = pThis->iVhostPageNext = 0;
+        ASMAtomicWriteBool(&pThis->fVhostActive, false);
+        Log(("%s vnetVhostStop: rx avail=%u used=%u, tx avail=%u used=%u (%Rrc)\n", INSTANCE(pThis),
+             pThis->pRxQueue->uNextAvailIndex, pThis->pRxQueue->uNextUsedIndex,
+             pThis->pTxQueue->uNextAvailIndex, pThis->pTxQueue->uNextUsedIndex, rc));
+    }
+    vnetCsLeave(pThis);
+}
+
+/**
+ * Gives the kernel the translation of a guest page it asked for.
+ *
+ * Once VNET_VHOST_MAX_PAGES pages are mapped the oldest non-ring page is
+ * withdrawn, so the number of pages kept mapped for the kernel is bounded
+ * no matter how much RAM the guest uses for buffers.
+ *
+ * @param   pThis           The device state structure.
+ * @param   GCPhysMiss      The address the kernel could not translate.
+ * @thread  The interrupt thread.
+ */
+static void vnetVhostHandleMiss(PVNETSTATE pThis, RTGCPHYS GCPhysMiss)
+{
+    PPDMDEVINS pDevIns = pThis->VPCI.CTX_SUFF(pDevIns);
+    PPDMINETWORKVHOST pVhost = pThis->pDrvVhost;
+    RTGCPHYS const GCPhysPage = GCPhysMiss & ~(RTGCPHYS)PAGE_OFFSET_MASK;
+    STAM_REL_COUNTER_INC(&pThis->StatVhostMisses);
+
+    /* Mapping may involve the EMT, so do it without holding the device lock. */
+    void *pv;
+    PGMPAGEMAPLOCK Lock;
+    int rc = PDMDevHlpPhysGCPhys2CCPtr(pDevIns, GCPhysPage, 0 /*fFlags*/, &pv, &Lock);
+    if (RT_FAILURE(rc))
+    {
+        /* The kernel stalls the ring until the guest kicks it again. */
+        Log(("%s vnetVhostHandleMiss: cannot map %RGp: %Rrc\n", INSTANCE(pThis), GCPhysMiss, rc));
+        return;
+    }
+
+    rc = vnetCsEnter(pThis, VERR_SEM_BUSY);
+    if (RT_FAILURE(rc))
+    {
+        PDMDevHlpPhysReleasePageMappingLock(pDevIns, &Lock);
+        return;
+    }
+    if (!pThis->fVhostActive)
+    {
+        vnetCsLeave(pThis);
+        PDMDevHlpPhysReleasePageMappingLock(pDevIns, &Lock);
+        return;
+    }
+    vnetVhostCheckRamGen(pThis);
+
+    /* The kernel may have dropped a translation we still hold, resend it. */
+    for (uint32_t i = 0; i < pThis->cVhostPages; i++)
+        if (pThis->paVhostPages[i].GCPhys == GCPhysPage)
+        {
+            pVhost->pfnMap(pVhost, GCPhysPage, PAGE_SIZE, pThis->paVhostPages[i].pvR3);
+            vnetCsLeave(pThis);
+            PDMDevHlpPhysReleasePageMappingLock(pDevIns, &Lock);
+            return;
+        }
+
+    PVNETVHOSTPAGE pPage;
+    if (pThis->cVhostPages < VNET_VHOST_MAX_PAGES)
+        pPage = &pThis->paVhostPages[pThis->cVhostPages++];
+    else
+    {
+        pPage = &pThis->paVhostPages[pThis->iVhostPageNext];
+        if (++pThis->iVhostPageNext >= VNET_VHOST_MAX_PAGES)
+            pThis->iVhostPageNext = pThis->cVhostRingPages;
+        pVhost->pfnUnmap(pVhost, pPage->GCPhys, PAGE_SIZE);
+        PDMDevHlpPhysReleasePageMappingLock(pDevIns, &pPage->Lock);
+    }
+    pPage->GCPhys = GCPhysPage;
+    pPage->pvR3   = pv;
+    pPage->Lock   = Lock;
+    rc = pVhost->pfnMap(pVhost, GCPhysPage, PAGE_SIZE, pv);
+    if (RT_FAILURE(rc))
+        LogRel(("%s Passing the translation of %RGp to the kernel failed: %Rrc\n", INSTANCE(pThis), GCPhysPage, rc));
+    vnetCsLeave(pThis);
+}
+
+/**
+ * Forwards a queue notification to the kernel, starting the kernel data
+ * path first if possible.
+ *
+ * @returns true if the kernel owns the rings and has been notified, false if
+ *          the notification is to be handled in user space.
+ * @param   pThis           The device state structure.
+ * @param   iRing           VNET_VHOST_RING_RX or VNET_VHOST_RING_TX.
+ */
+static bool vnetVhostKick(PVNETSTATE pThis, uint32_t iRing)
+{
+    if (!pThis->pDrvVhost)
+        return false;
+    vnetVhostStart(pThis);
+    if (!pThis->fVhostActive)
+        return false;
+    STAM_REL_COUNTER_INC(&pThis->StatVhostKicks);
+    pThis->pDrvVhost->pfnKick(pThis->pDrvVhost, iRing);
+    return true;
+}
+
+/**
+ * @callback_method_impl{FNPDMTHREADDEV, Raises the queue interrupt whenever
+ *                      the kernel has completed buffers and answers its
+ *                      translation requests.}
+ */
+static DECLCALLBACK(int) vnetVhostIrqThread(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    PVNETSTATE pThis = PDMINS_2_DATA(pDevIns, PVNETSTATE);
+    if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
+        return VINF_SUCCESS;
+
+    while (pThread->enmState == PDMTHREADSTATE_RUNNING)
+    {
+        PPDMINETWORKVHOST pVhost = pThis->pDrvVhost;
+        uint32_t fRings = 0;
+        RTGCPHYS GCPhysMiss = NIL_RTGCPHYS;
+        /* Wake up now and then to notice RAM range changes while idle. */
+        int rc = pVhost->pfnWaitInterrupt(pVhost, 1000, &fRings, &GCPhysMiss);
+        if (RT_SUCCESS(rc) && GCPhysMiss != NIL_RTGCPHYS)
+            vnetVhostHandleMiss(pThis, GCPhysMiss);
+        if (RT_SUCCESS(rc) && fRings)
+        {
+            STAM_REL_COUNTER_INC(&pThis->StatVhostInterrupts);
+            rc = vnetCsEnter(pThis, VERR_SEM_BUSY);
+            if (RT_SUCCESS(rc))
+            {
+                vpciRaiseInterrupt(&pThis->VPCI, VERR_SEM_BUSY, VPCI_ISR_QUEUE);
+                vnetCsLeave(pThis);
+            }
+        }
+        else if (rc == VERR_TIMEOUT)
+        {
+            if (   pThis->fVhostActive
+                && RT_SUCCESS(vnetCsEnter(pThis, VERR_SEM_BUSY)))
+            {
+                if (pThis->fVhostActive)
+                    vnetVhostCheckRamGen(pThis);
+                vnetCsLeave(pThis);
+            }
+        }
+        else if (RT_FAILURE(rc) && rc != VERR_INTERRUPTED)
+        {
+            Log(("%s vnetVhostIrqThread: pfnWaitInterrupt -> %Rrc\n", INSTANCE(pThis), rc));
+            PDMR3ThreadSleep(pThread, 10);
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+/**
+ * @callback_method_impl{FNPDMTHREADWAKEUPDEV}
+ */
+static DECLCALLBACK(int) vnetVhostIrqThreadWakeup(PPDMDEVINS pDevIns, PPDMTHREAD pThread)
+{
+    PVNETSTATE pThis = PDMINS_2_DATA(pDevIns, PVNETSTATE);
+    pThis->pDrvVhost->pfnWakeupWait(pThis->pDrvVhost);
+    return VINF_SUCCESS;
+}
+
+/**
+ * Picks up the kernel data path interface of a newly attached driver and
+ * creates the interrupt thread for it.
+ *
+ * @returns VBox status code.
+ * @param   pThis           The device state structure.
+ */
+static int vnetVhostAttach(PVNETSTATE pThis)
+{
+    PPDMDEVINS pDevIns = pThis->VPCI.CTX_SUFF(pDevIns);
+    Assert(!pThis->pVhostThread);
+
+    pThis->pDrvVhost = PDMIBASE_QUERY_INTERFACE(pThis->pDrvBase, PDMINETWORKVHOST);
+    if (!pThis->pDrvVhost)
+        return VINF_SUCCESS;
+
+    if (!pThis->paVhostPages)
+    {
+        pThis->paVhostPages = (PVNETVHOSTPAGE)RTMemAllocZ(VNET_VHOST_MAX_PAGES * sizeof(VNETVHOSTPAGE));
+        if (!pThis->paVhostPages)
+        {
+            pThis->pDrvVhost = NULL;
+            return VERR_NO_MEMORY;
+        }
+    }
+
+    int rc = PDMDevHlpThreadCreate(pDevIns, &pThis->pVhostThread, pThis, vnetVhostIrqThread,
+                                   vnetVhostIrqThreadWakeup, 0, RTTHREADTYPE_IO, "VNetVhost");
+    if (RT_FAILURE(rc))
+    {
+        pThis->pDrvVhost = NULL;
+        return rc;
+    }
+    /* New threads start out suspended, PDM only resumes them on power on and resume. */
+    VMSTATE enmVMState = PDMDevHlpVMState(pDevIns);
+    if (   enmVMState == VMSTATE_RUNNING
+        || enmVMState == VMSTATE_RUNNING_LS)
+        rc = PDMR3ThreadResume(pThis->pVhostThread);
+    return rc;
+}
+
+/**
+ * Stops the kernel data path and the interrupt thread before the driver goes
+ * away.
+ *
+ * @param   pThis           The device state structure.
+ */
+static void vnetVhostDetach(PVNETSTATE pThis)
+{
+    vnetVhostStop(pThis);
+    if (pThis->pVhostThread)
+    {
+        PDMR3ThreadDestroy(pThis->pVhostThread, NULL);
+        pThis->pVhostThread = NULL;
+    }
+    pThis->pDrvVhost = NULL;
+}
+
 static DECLCALLBACK(void) vnetQueueReceive(void *pvState, PVQUEUE pQueue)
 {
     PVNETSTATE pThis = (PVNETSTATE)pvState;
+    if (vnetVhostKick(pThis, VNET_VHOST_RING_RX))
+        return;
     Log(("%s Receive buffers has been added, waking up receive thread.\n", INSTANCE(pThis)));
     vnetWakeupReceive(pThis->VPCI.CTX_SUFF(pDevIns));
 }
@@ -1148,6 +1687,13 @@ static void vnetTransmitPendingPackets(PVNETSTATE pThis, PVQUEUE pQueue, bool fO
     if (!ASMAtomicCmpXchgU32(&pThis->uIsTransmitting, 1, 0))
         return;
 
+    if (pThis->fVhostActive)
+    {
+        /* The kernel owns the ring. */
+        ASMAtomicWriteU32(&pThis->uIsTransmitting, 0);
+        return;
+    }
+
     if ((pThis->VPCI.uStatus & VPCI_STATUS_DRV_OK) == 0)
     {
         Log(("%s Ignoring transmit requests from non-existent driver (status=0x%x).\n",
@@ -1318,6 +1864,8 @@ static DECLCALLBACK(void) vnetNetworkDown_XmitPending(PPDMINETWORKDOWN pInterfac
 static DECLCALLBACK(void) vnetQueueTransmit(void *pvState, PVQUEUE pQueue)
 {
     PVNETSTATE pThis = (PVNETSTATE)pvState;
+    if (vnetVhostKick(pThis, VNET_VHOST_RING_TX))
+        return;
 
     if (TMTimerIsActive(pThis->CTX_SUFF(pTxTimer)))
     {
@@ -1380,6 +1928,8 @@ static DECLCALLBACK(void) vnetTxTimer(PPDMDEVINS pDevIns, PTMTIMER pTimer, void
 static DECLCALLBACK(void) vnetQueueTransmit(void *pvState, PVQUEUE pQueue)
 {
     PVNETSTATE pThis = (PVNETSTATE)pvState;
+    if (vnetVhostKick(pThis, VNET_VHOST_RING_TX))
+        return;
 
     vnetTransmitPendingPackets(pThis, pQueue, false /*fOnWorkerThread*/);
 }
@@ -1610,6 +2160,18 @@ static void vnetSaveConfig(PVNETSTATE pThis, PSSMHANDLE pSSM)
 }
 
 
+/**
+ * @callback_method_impl{FNSSMDEVLIVEPREP}
+ */
+static DECLCALLBACK(int) vnetLivePrep(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
+{
+    PVNETSTATE pThis = PDMINS_2_DATA(pDevIns, PVNETSTATE);
+    /* Writes by the kernel would not show up in the dirty page tracking. */
+    vnetVhostStop(pThis);
+    return VINF_SUCCESS;
+}
+
+
 /**
  * @callback_method_impl{FNSSMDEVLIVEEXEC}
  */
@@ -1628,6 +2190,9 @@ static DECLCALLBACK(int) vnetSavePrep(PPDMDEVINS pDevIns, PSSMHANDLE pSSM)
 {
     PVNETSTATE pThis = PDMINS_2_DATA(pDevIns, PVNETSTATE);
 
+    /* Get the ring indexes back from the kernel. */
+    vnetVhostStop(pThis);
+
     int rc = vnetCsRxEnter(pThis, VERR_SEM_BUSY);
     if (RT_UNLIKELY(rc != VINF_SUCCESS))
         return rc;
@@ -1817,6 +2382,9 @@ static DECLCALLBACK(void) vnetDetach(PPDMDEVINS pDevIns, unsigned iLUN, uint32_t
 
     AssertLogRelReturnVoid(iLUN == 0);
 
+    /* Outside the critical section, the interrupt thread may be waiting for it. */
+    vnetVhostDetach(pThis);
+
     int rc = vnetCsEnter(pThis, VERR_SEM_BUSY);
     if (RT_FAILURE(rc))
     {
@@ -1870,6 +2438,13 @@ static DECLCALLBACK(int) vnetAttach(PPDMDEVINS pDevIns, unsigned iLUN, uint32_t
         pThis->pDrv = PDMIBASE_QUERY_INTERFACE(pThis->pDrvBase, PDMINETWORKUP);
         AssertMsgStmt(pThis->pDrv, ("Failed to obtain the PDMINETWORKUP interface!\n"),
                       rc = VERR_PDM_MISSING_INTERFACE_BELOW);
+        /* Only if the guest cannot have negotiated host offloads. */
+        if (RT_SUCCESS(rc) && pThis->fVhostCapable)
+        {
+            int rc2 = vnetVhostAttach(pThis);
+            if (RT_FAILURE(rc2))
+                LogRel(("%s Failed to set up the kernel data path: %Rrc\n", INSTANCE(pThis), rc2));
+        }
     }
     else if (   rc == VERR_PDM_NO_ATTACHED_DRIVER
              || rc == VERR_PDM_CFG_MISSING_DRIVER_NAME)
@@ -1898,16 +2473,32 @@ static DECLCALLBACK(int) vnetAttach(PPDMDEVINS pDevIns, unsigned iLUN, uint32_t
  */
 static DECLCALLBACK(void) vnetSuspend(PPDMDEVINS pDevIns)
 {
+    /* The kernel would keep going while the VM is suspended. */
+    vnetVhostStop(PDMINS_2_DATA(pDevIns, PVNETSTATE));
     /* Poke thread waiting for buffer space. */
     vnetWakeupReceive(pDevIns);
 }
 
 
+/**
+ * @interface_method_impl{PDMDEVREG,pfnReset}
+ */
+static DECLCALLBACK(void) vnetReset(PPDMDEVINS pDevIns)
+{
+    PVNETSTATE pThis = PDMINS_2_DATA(pDevIns, PVNETSTATE);
+    /* Don't let the kernel write into the memory of the rebooting guest. */
+    vnetVhostStop(pThis);
+    pThis->fVhostFailed = false;
+}
+
+
 /**
  * @interface_method_impl{PDMDEVREG,pfnPowerOff}
  */
 static DECLCALLBACK(void) vnetPowerOff(PPDMDEVINS pDevIns)
 {
+    /* The drivers are destroyed before us, take the rings back while possible. */
+    vnetVhostStop(PDMINS_2_DATA(pDevIns, PVNETSTATE));
     /* Poke thread waiting for buffer space. */
     vnetWakeupReceive(pDevIns);
 }
@@ -1939,6 +2530,10 @@ static DECLCALLBACK(int) vnetDestruct(PPDMDEVINS pDevIns)
     LogRel(("TxTimer stats (avg/min/max): %7d usec %7d usec %7d usec\n",
             pThis->u32AvgDiff, pThis->u32MinDiff, pThis->u32MaxDiff));
     Log(("%s Destroying instance\n", INSTANCE(pThis)));
+    /* Powered off already, so no pages are mapped for the kernel. */
+    Assert(!pThis->cVhostPages);
+    RTMemFree(pThis->paVhostPages);
+    pThis->paVhostPages = NULL;
     if (pThis->hEventMoreRxDescAvail != NIL_RTSEMEVENT)
     {
         RTSemEventSignal(pThis->hEventMoreRxDescAvail);
@@ -2047,7 +2642,7 @@ static DECLCALLBACK(int) vnetConstruct(PPDMDEVINS pDevIns, int iInstance, PCFGMN
 
     /* Register save/restore state handlers. */
     rc = PDMDevHlpSSMRegisterEx(pDevIns, VIRTIO_SAVEDSTATE_VERSION, sizeof(VNETSTATE), NULL,
-                                NULL,         vnetLiveExec, NULL,
+                                vnetLivePrep, vnetLiveExec, NULL,
                                 vnetSavePrep, vnetSaveExec, NULL,
                                 vnetLoadPrep, vnetLoadExec, vnetLoadDone);
     if (RT_FAILURE(rc))
@@ -2093,6 +2688,12 @@ static DECLCALLBACK(int) vnetConstruct(PPDMDEVINS pDevIns, int iInstance, PCFGMN
         pThis->pDrv = PDMIBASE_QUERY_INTERFACE(pThis->pDrvBase, PDMINETWORKUP);
         AssertMsgReturn(pThis->pDrv, ("Failed to obtain the PDMINETWORKUP interface!\n"),
                         VERR_PDM_MISSING_INTERFACE_BELOW);
+        rc = vnetVhostAttach(pThis);
+        if (RT_FAILURE(rc))
+            return PDMDEV_SET_ERROR(pDevIns, rc, N_("Failed to create the kernel data path interrupt thread"));
+        pThis->fVhostCapable = pThis->pDrvVhost != NULL;
+        if (pThis->fVhostCapable)
+            LogRel(("%s The attached driver supports the kernel data path, not offering host offloads\n", INSTANCE(pThis)));
     }
     else if (   rc == VERR_PDM_NO_ATTACHED_DRIVER
              || rc == VERR_PDM_CFG_MISSING_DRIVER_NAME )
@@ -2119,6 +2720,12 @@ static DECLCALLBACK(int) vnetConstruct(PPDMDEVINS pDevIns, int iInstance, PCFGMN
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatTransmitPackets,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,          "Number of sent packets",             "/Devices/VNet%d/Packets/Transmit", iInstance);
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatTransmitGSO,        STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,          "Number of sent GSO packets",         "/Devices/VNet%d/Packets/Transmit-Gso", iInstance);
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatTransmitCSum,       STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,          "Number of completed TX checksums",   "/Devices/VNet%d/Packets/Transmit-Csum", iInstance);
+    if (pThis->fVhostCapable)
+    {
+        PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatVhostKicks,     STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,     "Queue notifications passed to the kernel", "/Devices/VNet%d/Vhost/Kicks", iInstance);
+        PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatVhostInterrupts, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,    "Interrupts raised for the kernel",   "/Devices/VNet%d/Vhost/Interrupts", iInstance);
+        PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatVhostMisses,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,     "Guest pages mapped for the kernel",  "/Devices/VNet%d/Vhost/Misses", iInstance);
+    }
 #if defined(VBOX_WITH_STATISTICS)
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatReceive,            STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL, "Profiling receive",                  "/Devices/VNet%d/Receive/Total", iInstance);
     PDMDevHlpSTAMRegisterF(pDevIns, &pThis->StatReceiveStore,       STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_CALL, "Profiling receive storing",          "/Devices/VNet%d/Receive/Store", iInstance);
@@ -2174,7 +2781,7 @@ const PDMDEVREG g_DeviceVirtioNet =
     /* pfnPowerOn */
     NULL,
     /* pfnReset */
-    NULL,
+    vnetReset,
     /* pfnSuspend */
     vnetSuspend,
     /* pfnResume */
@@ -108,7 +108,9 @@ typedef struct DRVINTNET
     PDMINETWORKUPRC                 INetworkUpRC;
     /** Pointer to the driver instance. */
     PPDMDRVINSRC                    pDrvInsRC;
+#if R0_ARCH_BITS == 32
     RTRCPTR                         RCPtrAlignment;
+#endif
 
     /** The transmit lock. */
     PDMCRITSECT                     XmitLock;
@@ -553,6 +555,72 @@ PDMBOTHCBDECL(void) drvIntNetUp_SetPromiscuousMode(PPDMINETWORKUP pInterface, bo
     AssertRC(rc);
 }
 
+
+/**
+ * @interface_method_impl{PDMINETWORKUP,pfnSendSg}
+ */
+PDMBOTHCBDECL(int) drvIntNetUp_SendSg(PPDMINETWORKUP pInterface, PPDMSCATTERGATHER pSgBuf, bool fOnWorkerThread)
+{
+    PDRVINTNET      pThis   = RT_FROM_MEMBER(pInterface, DRVINTNET, CTX_SUFF(INetworkUp));
+    PCPDMNETWORKGSO pGso    = (PCPDMNETWORKGSO)pSgBuf->pvUser;
+    uint32_t const  cbFrame = (uint32_t)pSgBuf->cbUsed;
+    Assert((pSgBuf->fFlags & PDMSCATTERGATHER_FLAGS_MAGIC_MASK) == PDMSCATTERGATHER_FLAGS_MAGIC);
+    Assert(PDMCritSectIsOwner(&pThis->XmitLock));
+
+    /*
+     * Allocate room in the ring buffer, the same way drvIntNetUp_AllocBuf does.
+     */
+    PINTNETHDR pHdr    = NULL;
+    void      *pvFrame = NULL;
+    int        rc;
+    if (pGso)
+        rc = IntNetRingAllocateGsoFrame(&pThis->CTX_SUFF(pBuf)->Send, cbFrame, pGso, &pHdr, &pvFrame);
+    else
+        rc = IntNetRingAllocateFrame(&pThis->CTX_SUFF(pBuf)->Send, cbFrame, &pHdr, &pvFrame);
+    if (    RT_FAILURE(rc)
+        &&  pThis->CTX_SUFF(pBuf)->cbSend >= cbFrame * 2 + sizeof(INTNETHDR))
+    {
+        drvIntNetProcessXmit(pThis);
+        if (pGso)
+            rc = IntNetRingAllocateGsoFrame(&pThis->CTX_SUFF(pBuf)->Send, cbFrame, pGso, &pHdr, &pvFrame);
+        else
+            rc = IntNetRingAllocateFrame(&pThis->CTX_SUFF(pBuf)->Send, cbFrame, &pHdr, &pvFrame);
+    }
+    if (RT_FAILURE(rc))
+        return VERR_TRY_AGAIN;
+
+    STAM_PROFILE_START(&pThis->StatTransmit, a);
+    if (pGso)
+        STAM_COUNTER_INC(&pThis->StatSentGso);
+
+    /* Set an FTM checkpoint as this operation changes the state permanently. */
+    PDMDrvHlpFTSetCheckpoint(pThis->CTX_SUFF(pDrvIns), FTMCHECKPOINTTYPE_NETWORK);
+
+    /*
+     * Gather the segments straight into the ring, commit the frame and push
+     * it thru the switch.
+     */
+    uint8_t *pbDst  = (uint8_t *)pvFrame;
+    size_t   cbLeft = cbFrame;
+    for (size_t iSeg = 0; iSeg < pSgBuf->cSegs && cbLeft; iSeg++)
+    {
+        size_t cbSeg = RT_MIN(pSgBuf->aSegs[iSeg].cbSeg, cbLeft);
+        memcpy(pbDst, pSgBuf->aSegs[iSeg].pvSeg, cbSeg);
+        pbDst  += cbSeg;
+        cbLeft -= cbSeg;
+    }
+    Assert(!cbLeft);
+
+    IntNetRingCommitFrameEx(&pThis->CTX_SUFF(pBuf)->Send, pHdr, cbFrame);
+    rc = drvIntNetProcessXmit(pThis);
+    STAM_PROFILE_STOP(&pThis->StatTransmit, a);
+#ifndef IN_RING3
+    STAM_REL_COUNTER_INC(&pThis->StatSentR0);
+#endif
+    return rc;
+}
+
+
 #ifdef IN_RING3
 
 /**
@@ -1372,6 +1440,7 @@ static DECLCALLBACK(int) drvR3IntNetConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg
     pThis->INetworkUpR3.pfnEndXmit                  = drvIntNetUp_EndXmit;
     pThis->INetworkUpR3.pfnSetPromiscuousMode       = drvIntNetUp_SetPromiscuousMode;
     pThis->INetworkUpR3.pfnNotifyLinkChanged        = drvR3IntNetUp_NotifyLinkChanged;
+    pThis->INetworkUpR3.pfnSendSg                   = drvIntNetUp_SendSg;
 
     /*
      * Validate the config.
@@ -71,6 +71,9 @@ extern "C" {
 
 #define DRVNAT_MAXFRAMESIZE (16 * 1024)
 
+/** The maximum number of TX worker threads (see DRVNAT::aTxWorkers). */
+#define DRVNAT_MAX_TX_WORKERS   8
+
 /**
  * @todo: This is a bad hack to prevent freezing the guest during high network
  *        activity. Windows host only. This needs to be fixed properly.
@@ -134,6 +137,68 @@ do                                                      \
 /*******************************************************************************
 *   Structures and Typedefs                                                    *
 *******************************************************************************/
+/**
+ * NAT TX worker thread.
+ *
+ * The TX workers carve GSO frames in parallel with the NAT thread, straight
+ * into mbufs the NAT thread allocated for them.  They never call into slirp:
+ * the NAT thread feeds the carved batches to slirp in the order the frames
+ * were sent once the workers have woken it up thru the control pipe.
+ */
+typedef struct DRVNATTXWORKER
+{
+    /** Pointer to the NAT instance data. */
+    struct DRVNAT          *pThis;
+    /** The worker thread. */
+    PPDMTHREAD              pThread;
+    /** Queue of batches waiting to be carved by this worker. */
+    RTREQQUEUE              hReqQueue;
+    /** Event the worker thread waits on when idle. */
+    RTSEMEVENT              hEvent;
+    /** Number of batches queued to this worker but not yet carved. */
+    volatile uint32_t       cPending;
+    /** The worker index. */
+    uint32_t                iWorker;
+} DRVNATTXWORKER;
+/** Pointer to a NAT TX worker. */
+typedef DRVNATTXWORKER *PDRVNATTXWORKER;
+
+/**
+ * A frame on its way to slirp when there are TX workers.
+ *
+ * GSO frames get an mbuf per segment from the NAT thread and are then carved
+ * into those by a TX worker.  Frames sent while there are GSO frames being
+ * carved queue up behind them (cSegs is 0 for these), so the NAT thread can
+ * hand everything to slirp in the order it was sent (DRVNAT::pTxBatchHead).
+ */
+typedef struct DRVNATTXBATCH
+{
+    /** The next batch in send order.  NAT thread only. */
+    struct DRVNATTXBATCH   *pNext;
+    /** The frame.  Freed by the NAT thread. */
+    PPDMSCATTERGATHER       pSgBuf;
+    /** The worker carving it. */
+    PDRVNATTXWORKER         pWorker;
+    /** Set when the batch can be fed to slirp. */
+    bool volatile           fReady;
+    /** Number of segments in the GSO frame, 0 if the frame is sent as is. */
+    uint32_t                cSegs;
+    /** Number of segments we got mbufs for, the rest is dropped. */
+    uint32_t                cMbufs;
+    /** The mbufs, one per segment. */
+    struct
+    {
+        /** The mbuf. */
+        struct mbuf        *m;
+        /** The mbuf data buffer. */
+        void               *pvBuf;
+        /** The size of the carved segment, set by the worker. */
+        uint32_t            cb;
+    }                       aSegs[1];
+} DRVNATTXBATCH;
+/** Pointer to a TX worker batch. */
+typedef DRVNATTXBATCH *PDRVNATTXBATCH;
+
 /**
  * NAT network transport driver instance data.
  *
@@ -206,6 +271,16 @@ typedef struct DRVNAT
     /** Transmit lock taken by BeginXmit and released by EndXmit. */
     RTCRITSECT              XmitLock;
 
+    /** Number of TX worker threads, 0 if frames go straight to the NAT thread. */
+    uint32_t                cTxWorkers;
+    /** The TX worker threads. */
+    DRVNATTXWORKER          aTxWorkers[DRVNAT_MAX_TX_WORKERS];
+    /** The oldest frame not yet fed to slirp when there are TX workers.
+     *  NAT thread only. */
+    PDRVNATTXBATCH          pTxBatchHead;
+    /** The newest frame not yet fed to slirp.  NAT thread only. */
+    PDRVNATTXBATCH          pTxBatchTail;
+
 #ifdef RT_OS_DARWIN
     /* Handle of the DNS watcher runloop source. */
     CFRunLoopSourceRef      hRunLoopSrcDnsWatcher;
@@ -419,7 +494,10 @@ static void drvNATSendWorker(PDRVNAT pThis, PPDMSCATTERGATHER pSgBuf)
                 void  *pvSeg;
                 m = slirp_ext_m_get(pThis->pNATState, pGso->cbHdrsTotal + pGso->cbMaxSeg, &pvSeg, &cbSeg);
                 if (!m)
+                {
+                    STAM_COUNTER_ADD(&pThis->StatNATTxSegDropped, cSegs - iSeg);
                     break;
+                }
 
 #if 1
                 uint32_t cbPayload, cbHdrs;
@@ -444,6 +522,260 @@ static void drvNATSendWorker(PDRVNAT pThis, PPDMSCATTERGATHER pSgBuf)
     /** @todo Implement the VERR_TRY_AGAIN drvNATNetworkUp_AllocBuf semantics. */
 }
 
+/**
+ * Carves the segments of a GSO frame into the mbufs of the batch.
+ *
+ * @param   pBatch              The batch.
+ */
+static void drvNATTxBatchCarve(PDRVNATTXBATCH pBatch)
+{
+    PPDMSCATTERGATHER pSgBuf  = pBatch->pSgBuf;
+    uint8_t const    *pbFrame = (uint8_t const *)pSgBuf->aSegs[0].pvSeg;
+    PCPDMNETWORKGSO   pGso    = (PCPDMNETWORKGSO)pSgBuf->pvUser;
+    for (uint32_t iSeg = 0; iSeg < pBatch->cMbufs; iSeg++)
+    {
+        uint8_t *pbSeg = (uint8_t *)pBatch->aSegs[iSeg].pvBuf;
+        uint32_t cbPayload, cbHdrs;
+        uint32_t offPayload = PDMNetGsoCarveSegment(pGso, pbFrame, pSgBuf->cbUsed,
+                                                    iSeg, pBatch->cSegs, pbSeg, &cbHdrs, &cbPayload);
+        memcpy(pbSeg + cbHdrs, pbFrame + offPayload, cbPayload);
+        pBatch->aSegs[iSeg].cb = cbHdrs + cbPayload;
+    }
+}
+
+/**
+ * Frees a batch and everything it still holds.
+ *
+ * @param   pThis               Pointer to the NAT instance.
+ * @param   pBatch              The batch, freed.
+ * @thread  NAT
+ */
+static void drvNATTxBatchFree(PDRVNAT pThis, PDRVNATTXBATCH pBatch)
+{
+    for (uint32_t iSeg = 0; iSeg < pBatch->cMbufs; iSeg++)
+        if (pBatch->aSegs[iSeg].m)
+            slirp_ext_m_free(pThis->pNATState, pBatch->aSegs[iSeg].m, NULL);
+    drvNATFreeSgBuf(pThis, pBatch->pSgBuf);
+    RTMemFree(pBatch);
+}
+
+/**
+ * Appends a batch to the list of frames waiting for slirp.
+ *
+ * @param   pThis               Pointer to the NAT instance.
+ * @param   pBatch              The batch.
+ * @thread  NAT
+ */
+static void drvNATTxBatchAppend(PDRVNAT pThis, PDRVNATTXBATCH pBatch)
+{
+    pBatch->pNext = NULL;
+    if (pThis->pTxBatchTail)
+        pThis->pTxBatchTail->pNext = pBatch;
+    else
+        pThis->pTxBatchHead = pBatch;
+    pThis->pTxBatchTail = pBatch;
+}
+
+/**
+ * Feeds the completed batches at the head of the list into slirp.
+ *
+ * Called whenever the NAT thread wakes up, the TX workers kick it thru the
+ * control pipe after completing a batch.
+ *
+ * @param   pThis               Pointer to the NAT instance.
+ * @thread  NAT
+ */
+static void drvNATTxBatchFlush(PDRVNAT pThis)
+{
+    PDRVNATTXBATCH pBatch;
+    while (   (pBatch = pThis->pTxBatchHead) != NULL
+           && ASMAtomicReadBool(&pBatch->fReady))
+    {
+        pThis->pTxBatchHead = pBatch->pNext;
+        if (!pThis->pTxBatchHead)
+            pThis->pTxBatchTail = NULL;
+
+        if (!pBatch->cSegs)
+        {
+            drvNATSendWorker(pThis, pBatch->pSgBuf);
+            RTMemFree(pBatch);
+            continue;
+        }
+
+        if (pThis->enmLinkState == PDMNETWORKLINKSTATE_UP)
+            for (uint32_t iSeg = 0; iSeg < pBatch->cMbufs; iSeg++)
+            {
+                slirp_input(pThis->pNATState, pBatch->aSegs[iSeg].m, pBatch->aSegs[iSeg].cb);
+                pBatch->aSegs[iSeg].m = NULL;
+            }
+        drvNATTxBatchFree(pThis, pBatch);
+    }
+}
+
+/**
+ * Worker function for drvNATSend() when there are TX workers, keeps the
+ * frame behind the GSO frames which are still being carved.
+ *
+ * @param   pThis               Pointer to the NAT instance.
+ * @param   pSgBuf              The scatter/gather buffer.
+ * @thread  NAT
+ */
+static void drvNATSendOrderedWorker(PDRVNAT pThis, PPDMSCATTERGATHER pSgBuf)
+{
+    PDRVNATTXBATCH pBatch = NULL;
+    if (pThis->pTxBatchHead)
+        pBatch = (PDRVNATTXBATCH)RTMemAllocZ(sizeof(*pBatch));
+    if (!pBatch)
+    {
+        /* Nothing to wait for (or no memory, in which case it overtakes). */
+        drvNATSendWorker(pThis, pSgBuf);
+        return;
+    }
+    pBatch->pSgBuf = pSgBuf;
+    pBatch->fReady = true;
+    drvNATTxBatchAppend(pThis, pBatch);
+}
+
+/**
+ * Calculates the flow hash used for assigning a frame to a TX worker.
+ *
+ * Non-IPv4 frames all end up in the same bucket.  IP fragments don't all
+ * carry the transport header, so for those only the addresses and protocol
+ * are hashed, keeping every fragment of a datagram on the same worker.
+ *
+ * @returns The hash value.
+ * @param   pbFrame             The frame.
+ * @param   cbFrame             The frame size.
+ */
+static uint32_t drvNATTxFlowHash(uint8_t const *pbFrame, size_t cbFrame)
+{
+    if (cbFrame < sizeof(RTNETETHERHDR) + RTNETIPV4_MIN_LEN)
+        return 0;
+    PCRTNETETHERHDR pEthHdr = (PCRTNETETHERHDR)pbFrame;
+    if (pEthHdr->EtherType != RT_H2N_U16_C(RTNET_ETHERTYPE_IPV4))
+        return 0;
+
+    PCRTNETIPV4 pIpHdr = (PCRTNETIPV4)(pEthHdr + 1);
+    uint32_t    uHash  = pIpHdr->ip_src.u ^ pIpHdr->ip_dst.u ^ pIpHdr->ip_p;
+    size_t      offL4  = sizeof(RTNETETHERHDR) + pIpHdr->ip_hl * 4;
+    if (   (   pIpHdr->ip_p == RTNETIPV4_PROT_TCP
+            || pIpHdr->ip_p == RTNETIPV4_PROT_UDP)
+        && !(pIpHdr->ip_off & RT_H2N_U16_C(RTNETIPV4_FLAGS_MF | 0x1fff /* offset */))
+        && offL4 + sizeof(uint32_t) <= cbFrame)
+        uHash ^= RT_MAKE_U32_FROM_U8(pbFrame[offL4], pbFrame[offL4 + 1], pbFrame[offL4 + 2], pbFrame[offL4 + 3]);
+    uHash ^= uHash >> 16;
+    uHash ^= uHash >> 8;
+    return uHash;
+}
+
+/**
+ * Worker function for the TX worker threads, carves a GSO frame into the
+ * mbufs the NAT thread allocated for it.
+ *
+ * @param   pWorker             The TX worker.
+ * @param   pBatch              The batch.  Completed, but not freed.
+ * @thread  NATTX
+ */
+static void drvNATTxWorkerProcess(PDRVNATTXWORKER pWorker, PDRVNATTXBATCH pBatch)
+{
+    PDRVNAT pThis = pWorker->pThis;
+    STAM_PROFILE_START(&pThis->StatNATTxWorkerCarve, a);
+
+    drvNATTxBatchCarve(pBatch);
+
+    /* The NAT thread may free the batch as soon as it's marked ready. */
+    ASMAtomicDecU32(&pWorker->cPending);
+    ASMAtomicWriteBool(&pBatch->fReady, true);
+    STAM_PROFILE_STOP(&pThis->StatNATTxWorkerCarve, a);
+
+    drvNATNotifyNATThread(pThis, "drvNATTxWorkerProcess");
+}
+
+/**
+ * Allocates the mbufs for a GSO frame and hands it to a TX worker for
+ * carving.
+ *
+ * @param   pThis               Pointer to the NAT instance.
+ * @param   pBatch              The batch.
+ * @thread  NAT
+ */
+static void drvNATSendBatchWorker(PDRVNAT pThis, PDRVNATTXBATCH pBatch)
+{
+    if (pThis->enmLinkState != PDMNETWORKLINKSTATE_UP)
+    {
+        drvNATTxBatchFree(pThis, pBatch);
+        return;
+    }
+
+    PCPDMNETWORKGSO pGso = (PCPDMNETWORKGSO)pBatch->pSgBuf->pvUser;
+    uint32_t        iSeg;
+    for (iSeg = 0; iSeg < pBatch->cSegs; iSeg++)
+    {
+        size_t cbBuf;
+        pBatch->aSegs[iSeg].m = slirp_ext_m_get(pThis->pNATState, pGso->cbHdrsTotal + pGso->cbMaxSeg,
+                                                &pBatch->aSegs[iSeg].pvBuf, &cbBuf);
+        if (!pBatch->aSegs[iSeg].m)
+        {
+            STAM_COUNTER_ADD(&pThis->StatNATTxSegDropped, pBatch->cSegs - iSeg);
+            break;
+        }
+    }
+    pBatch->cMbufs = iSeg;
+    drvNATTxBatchAppend(pThis, pBatch);
+
+    /* If the worker can't take it, carve it here. */
+    PDRVNATTXWORKER pWorker = pBatch->pWorker;
+    if (pBatch->cMbufs)
+    {
+        ASMAtomicIncU32(&pWorker->cPending);
+        int rc = RTReqQueueCallEx(pWorker->hReqQueue, NULL /*ppReq*/, 0 /*cMillies*/,
+                                  RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
+                                  (PFNRT)drvNATTxWorkerProcess, 2, pWorker, pBatch);
+        if (RT_SUCCESS(rc))
+        {
+            STAM_COUNTER_INC(&pThis->StatNATTxWorkerFrames);
+            RTSemEventSignal(pWorker->hEvent);
+            return;
+        }
+        ASMAtomicDecU32(&pWorker->cPending);
+    }
+    drvNATTxBatchCarve(pBatch);
+    ASMAtomicWriteBool(&pBatch->fReady, true);
+}
+
+/**
+ * TX worker thread.
+ */
+static DECLCALLBACK(int) drvNATTxWorkerThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThread)
+{
+    PDRVNATTXWORKER pWorker = (PDRVNATTXWORKER)pThread->pvUser;
+
+    if (pThread->enmState == PDMTHREADSTATE_INITIALIZING)
+        return VINF_SUCCESS;
+
+    while (pThread->enmState == PDMTHREADSTATE_RUNNING)
+    {
+        RTReqQueueProcess(pWorker->hReqQueue, 0);
+        if (ASMAtomicReadU32(&pWorker->cPending) == 0)
+            RTSemEventWait(pWorker->hEvent, RT_INDEFINITE_WAIT);
+    }
+
+    /* The NAT thread holds back everything sent after the batches we've got
+       queued, so finish them before suspending or terminating. */
+    while (ASMAtomicReadU32(&pWorker->cPending))
+        RTReqQueueProcess(pWorker->hReqQueue, 0);
+    return VINF_SUCCESS;
+}
+
+/**
+ * Unblock a TX worker thread so it can respond to a state change.
+ */
+static DECLCALLBACK(int) drvNATTxWorkerWakeup(PPDMDRVINS pDrvIns, PPDMTHREAD pThread)
+{
+    PDRVNATTXWORKER pWorker = (PDRVNATTXWORKER)pThread->pvUser;
+    return RTSemEventSignal(pWorker->hEvent);
+}
+
 /**
  * @interface_method_impl{PDMINETWORKUP,pfnBeginXmit}
  */
@@ -571,15 +903,41 @@ static DECLCALLBACK(int) drvNATNetworkUp_SendBuf(PPDMINETWORKUP pInterface, PPDM
         PDMDrvHlpFTSetCheckpoint(pThis->pDrvIns, FTMCHECKPOINTTYPE_NETWORK);
 
 
-        RTREQQUEUE hQueue = pThis->hSlirpReqQueue;
+        /*
+         * GSO frames are carved by the TX worker owning the flow when we've
+         * got any.  The NAT thread allocates the mbufs and passes the batch
+         * on to the worker, holding back the frames sent after it until the
+         * worker is done.  Normal frames aren't worth offloading.
+         */
+        PDRVNATTXBATCH pBatch = NULL;
+        if (pThis->cTxWorkers && !pSgBuf->pvAllocator)
+        {
+            PCPDMNETWORKGSO pGso  = (PCPDMNETWORKGSO)pSgBuf->pvUser;
+            uint32_t const  cSegs = PDMNetGsoCalcSegmentCount(pGso, pSgBuf->cbUsed);  Assert(cSegs > 1);
+            pBatch = (PDRVNATTXBATCH)RTMemAllocZ(RT_OFFSETOF(DRVNATTXBATCH, aSegs[cSegs]));
+            if (pBatch)
+            {
+                uint32_t uHash     = drvNATTxFlowHash((uint8_t const *)pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed);
+                pBatch->pSgBuf     = pSgBuf;
+                pBatch->pWorker    = &pThis->aTxWorkers[uHash % pThis->cTxWorkers];
+                pBatch->cSegs      = cSegs;
+            }
+        }
 
-        rc = RTReqQueueCallEx(hQueue, NULL /*ppReq*/, 0 /*cMillies*/, RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
-                              (PFNRT)drvNATSendWorker, 2, pThis, pSgBuf);
+        RTREQQUEUE hQueue = pThis->hSlirpReqQueue;
+        if (pBatch)
+            rc = RTReqQueueCallEx(hQueue, NULL /*ppReq*/, 0 /*cMillies*/, RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
+                                  (PFNRT)drvNATSendBatchWorker, 2, pThis, pBatch);
+        else
+            rc = RTReqQueueCallEx(hQueue, NULL /*ppReq*/, 0 /*cMillies*/, RTREQFLAGS_VOID | RTREQFLAGS_NO_WAIT,
+                                  pThis->cTxWorkers ? (PFNRT)drvNATSendOrderedWorker : (PFNRT)drvNATSendWorker,
+                                  2, pThis, pSgBuf);
         if (RT_SUCCESS(rc))
         {
             drvNATNotifyNATThread(pThis, "drvNATNetworkUp_SendBuf");
             return VINF_SUCCESS;
         }
+        RTMemFree(pBatch);
 
         rc = VERR_NET_NO_BUFFER_SPACE;
     }
@@ -827,6 +1185,7 @@ static DECLCALLBACK(int) drvNATAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
         }
         /* process _all_ outstanding requests but don't wait */
         RTReqQueueProcess(pThis->hSlirpReqQueue, 0);
+        drvNATTxBatchFlush(pThis);
         RTMemFree(polls);
 
 #else /* RT_OS_WINDOWS */
@@ -854,6 +1213,7 @@ static DECLCALLBACK(int) drvNATAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
         slirp_select_poll(pThis->pNATState, /* fTimeout=*/false, /* fIcmp=*/(dwEvent == WSA_WAIT_EVENT_0));
         /* process _all_ outstanding requests but don't wait */
         RTReqQueueProcess(pThis->hSlirpReqQueue, 0);
+        drvNATTxBatchFlush(pThis);
 # ifdef VBOX_NAT_DELAY_HACK
         if (cBreak++ > 128)
         {
@@ -1312,6 +1672,25 @@ static DECLCALLBACK(void) drvNATDestruct(PPDMDRVINS pDrvIns)
     LogFlow(("drvNATDestruct:\n"));
     PDMDRV_CHECK_VERSIONS_RETURN_VOID(pDrvIns);
 
+    /*
+     * Stop the TX workers before slirp goes away, they finish the batches
+     * they've got queued on the way out.  Then drop the frames the NAT thread
+     * didn't get around to.
+     */
+    for (uint32_t iWorker = 0; iWorker < RT_ELEMENTS(pThis->aTxWorkers); iWorker++)
+        if (pThis->aTxWorkers[iWorker].pThread)
+        {
+            PDMR3ThreadDestroy(pThis->aTxWorkers[iWorker].pThread, NULL);
+            pThis->aTxWorkers[iWorker].pThread = NULL;
+        }
+    while (pThis->pTxBatchHead)
+    {
+        PDRVNATTXBATCH pBatch = pThis->pTxBatchHead;
+        pThis->pTxBatchHead = pBatch->pNext;
+        drvNATTxBatchFree(pThis, pBatch);
+    }
+    pThis->pTxBatchTail = NULL;
+
     if (pThis->pNATState)
     {
         slirp_term(pThis->pNATState);
@@ -1327,6 +1706,15 @@ static DECLCALLBACK(void) drvNATDestruct(PPDMDRVINS pDrvIns)
     RTReqQueueDestroy(pThis->hSlirpReqQueue);
     pThis->hSlirpReqQueue = NIL_RTREQQUEUE;
 
+    for (uint32_t iWorker = 0; iWorker < RT_ELEMENTS(pThis->aTxWorkers); iWorker++)
+    {
+        PDRVNATTXWORKER pWorker = &pThis->aTxWorkers[iWorker];
+        RTReqQueueDestroy(pWorker->hReqQueue);
+        pWorker->hReqQueue = NIL_RTREQQUEUE;
+        RTSemEventDestroy(pWorker->hEvent);
+        pWorker->hEvent = NIL_RTSEMEVENT;
+    }
+
     RTReqQueueDestroy(pThis->hUrgRecvReqQueue);
     pThis->hUrgRecvReqQueue = NIL_RTREQQUEUE;
 
@@ -1377,6 +1765,16 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     pThis->hUrgRecvReqQueue             = NIL_RTREQQUEUE;
     pThis->EventRecv                    = NIL_RTSEMEVENT;
     pThis->EventUrgRecv                 = NIL_RTSEMEVENT;
+    pThis->cTxWorkers                   = 0;
+    for (uint32_t iWorker = 0; iWorker < RT_ELEMENTS(pThis->aTxWorkers); iWorker++)
+    {
+        pThis->aTxWorkers[iWorker].pThis     = pThis;
+        pThis->aTxWorkers[iWorker].iWorker   = iWorker;
+        pThis->aTxWorkers[iWorker].hReqQueue = NIL_RTREQQUEUE;
+        pThis->aTxWorkers[iWorker].hEvent    = NIL_RTSEMEVENT;
+    }
+    pThis->pTxBatchHead                 = NULL;
+    pThis->pTxBatchTail                 = NULL;
 #ifdef RT_OS_DARWIN
     pThis->hRunLoopSrcDnsWatcher        = NULL;
 #endif
@@ -1406,6 +1804,7 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
                               "SockRcv\0SockSnd\0TcpRcv\0TcpSnd\0"
                               "ICMPCacheLimit\0"
                               "SoMaxConnection\0"
+                              "TxWorkerThreads\0"
 #ifdef VBOX_WITH_DNSMAPPING_IN_HOSTRESOLVER
                               "HostResolverMappings\0"
 #endif
@@ -1442,6 +1841,12 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     i32AliasMode |= (i32MainAliasMode & 0x4 ? 0x4 : 0);
     int i32SoMaxConn = 10;
     GET_S32(rc, pThis, pCfg, "SoMaxConnection", i32SoMaxConn);
+    int i32TxWorkers = 0;
+    GET_S32(rc, pThis, pCfg, "TxWorkerThreads", i32TxWorkers);
+    if (i32TxWorkers < 0 || i32TxWorkers > DRVNAT_MAX_TX_WORKERS)
+        return PDMDrvHlpVMSetError(pDrvIns, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                                   N_("NAT#%d: configuration error: \"TxWorkerThreads\" must be between 0 and %d"),
+                                   pDrvIns->iInstance, DRVNAT_MAX_TX_WORKERS);
     /*
      * Query the network port interface.
      */
@@ -1586,6 +1991,29 @@ static DECLCALLBACK(int) drvNATConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
                                        drvNATAsyncIoWakeup, 128 * _1K, RTTHREADTYPE_IO, "NAT");
             AssertRCReturn(rc, rc);
 
+            /*
+             * Create the TX worker threads if requested.
+             */
+            for (uint32_t iWorker = 0; iWorker < (uint32_t)i32TxWorkers; iWorker++)
+            {
+                PDRVNATTXWORKER pWorker = &pThis->aTxWorkers[iWorker];
+
+                rc = RTReqQueueCreate(&pWorker->hReqQueue);
+                AssertLogRelRCReturn(rc, rc);
+
+                rc = RTSemEventCreate(&pWorker->hEvent);
+                AssertRCReturn(rc, rc);
+
+                char szName[16];
+                RTStrPrintf(szName, sizeof(szName), "NATTX%u", iWorker);
+                rc = PDMDrvHlpThreadCreate(pDrvIns, &pWorker->pThread, pWorker, drvNATTxWorkerThread,
+                                           drvNATTxWorkerWakeup, 128 * _1K, RTTHREADTYPE_IO, szName);
+                AssertRCReturn(rc, rc);
+            }
+            pThis->cTxWorkers = (uint32_t)i32TxWorkers;
+            if (pThis->cTxWorkers)
+                LogRel(("NAT#%d: using %u TX worker threads\n", pDrvIns->iInstance, pThis->cTxWorkers));
+
             pThis->enmLinkState = pThis->enmLinkStateWant = PDMNETWORKLINKSTATE_UP;
 
 #ifdef RT_OS_DARWIN
@@ -167,6 +167,36 @@ PDMBOTHCBDECL(int) drvNetShaperUp_SendBuf(PPDMINETWORKUP pInterface, PPDMSCATTER
 }
 
 
+/**
+ * @interface_method_impl{PDMINETWORKUP,pfnSendSg}
+ */
+PDMBOTHCBDECL(int) drvNetShaperUp_SendSg(PPDMINETWORKUP pInterface, PPDMSCATTERGATHER pSgBuf, bool fOnWorkerThread)
+{
+    PDRVNETSHAPER pThis = RT_FROM_MEMBER(pInterface, DRVNETSHAPER, CTX_SUFF(INetworkUp));
+    if (RT_UNLIKELY(!pThis->CTX_SUFF(pIBelowNet)))
+        return VERR_NET_DOWN;
+    /* Let the caller fall back on pfnAllocBuf (and the accounting there) if
+       the driver below cannot take the frame as is. */
+    if (!pThis->CTX_SUFF(pIBelowNet)->pfnSendSg)
+        return VERR_TRY_AGAIN;
+
+    size_t const cbFrame = pSgBuf->cbUsed;
+    STAM_REL_COUNTER_ADD(&pThis->StatXmitBytesRequested, cbFrame);
+    STAM_REL_COUNTER_INC(&pThis->StatXmitPktsRequested);
+#if defined(IN_RING3) || defined(IN_RING0)
+    if (!PDMNsAllocateBandwidth(&pThis->Filter, cbFrame))
+    {
+        STAM_REL_COUNTER_ADD(&pThis->StatXmitBytesDenied, cbFrame);
+        STAM_REL_COUNTER_INC(&pThis->StatXmitPktsDenied);
+        return VERR_TRY_AGAIN;
+    }
+#endif
+    STAM_REL_COUNTER_ADD(&pThis->StatXmitBytesGranted, cbFrame);
+    STAM_REL_COUNTER_INC(&pThis->StatXmitPktsGranted);
+    return pThis->CTX_SUFF(pIBelowNet)->pfnSendSg(pThis->CTX_SUFF(pIBelowNet), pSgBuf, fOnWorkerThread);
+}
+
+
 /**
  * @interface_method_impl{PDMINETWORKUP,pfnEndXmit}
  */
@@ -426,6 +456,7 @@ static DECLCALLBACK(int) drvR3NetShaperConstruct(PPDMDRVINS pDrvIns, PCFGMNODE p
     pThis->INetworkUpR3.pfnEndXmit                  = drvNetShaperUp_EndXmit;
     pThis->INetworkUpR3.pfnSetPromiscuousMode       = drvNetShaperUp_SetPromiscuousMode;
     pThis->INetworkUpR3.pfnNotifyLinkChanged        = drvR3NetShaperUp_NotifyLinkChanged;
+    pThis->INetworkUpR3.pfnSendSg                   = drvNetShaperUp_SendSg;
     /* Resolve the ring-0 context interface addresses. */
     int rc = pDrvIns->pHlpR3->pfnLdrGetR0InterfaceSymbols(pDrvIns, &pThis->INetworkUpR0,
                                                           sizeof(pThis->INetworkUpR0),
@@ -27,6 +27,7 @@
 #include <iprt/asm.h>
 #include <iprt/assert.h>
 #include <iprt/ctype.h>
+#include <iprt/err.h>
 #include <iprt/file.h>
 #include <iprt/mem.h>
 #include <iprt/path.h>
@@ -42,6 +43,7 @@
 
 #include <sys/ioctl.h>
 #include <sys/poll.h>
+#include <sys/uio.h>
 #ifdef RT_OS_SOLARIS
 # include <sys/stat.h>
 # include <sys/ethernet.h>
@@ -64,6 +66,14 @@
 #include <unistd.h>
 
 #include "VBoxDD.h"
+#ifdef RT_OS_LINUX
+# include "VhostNet.h"
+#endif
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
 
 
 /*******************************************************************************
@@ -78,6 +88,10 @@ typedef struct DRVTAP
 {
     /** The network interface. */
     PDMINETWORKUP           INetworkUp;
+#ifdef RT_OS_LINUX
+    /** The kernel offload interface, only exported when vhost-net is usable. */
+    PDMINETWORKVHOST        INetworkVhost;
+#endif
     /** The network interface. */
     PPDMINETWORKDOWN        pIAboveNet;
     /** Pointer to the driver instance. */
@@ -106,6 +120,23 @@ typedef struct DRVTAP
     /** @todo The transmit thread. */
     /** Transmit lock used by drvTAPNetworkUp_BeginXmit. */
     RTCRITSECT              XmitLock;
+    /** Buffer for linearizing GSO frames passed to drvTAPNetworkUp_SendSg.
+     * Protected by XmitLock. */
+    uint8_t                *pbXmitScratch;
+    /** Size of the buffer pbXmitScratch points to. */
+    size_t                  cbXmitScratch;
+
+#ifdef RT_OS_LINUX
+    /** The vhost-net instance, fdVhost is -1 if not configured or unavailable. */
+    VHOSTNET                Vhost;
+    /** Set while the kernel owns the rings, the reader thread stays away from
+     * the device then. */
+    bool volatile           fVhostActive;
+    /** Reader thread: Whether it has acknowledged fVhostActive. */
+    bool                    fVhostRxParked;
+    /** Signalled by the reader thread when it has parked itself. */
+    RTSEMEVENT              hEvtVhostRxParked;
+#endif
 
 #ifdef VBOX_WITH_STATISTICS
     /** Number of sent packets. */
@@ -133,6 +164,10 @@ typedef struct DRVTAP
 
 /** Converts a pointer to TAP::INetworkUp to a PRDVTAP. */
 #define PDMINETWORKUP_2_DRVTAP(pInterface) ( (PDRVTAP)((uintptr_t)pInterface - RT_OFFSETOF(DRVTAP, INetworkUp)) )
+#ifdef RT_OS_LINUX
+/** Converts a pointer to TAP::INetworkVhost to a PRDVTAP. */
+# define PDMINETWORKVHOST_2_DRVTAP(pInterface) ( (PDRVTAP)((uintptr_t)pInterface - RT_OFFSETOF(DRVTAP, INetworkVhost)) )
+#endif
 
 
 /*******************************************************************************
@@ -223,6 +258,33 @@ static DECLCALLBACK(int) drvTAPNetworkUp_FreeBuf(PPDMINETWORKUP pInterface, PPDM
 }
 
 
+/**
+ * Segments a GSO frame and writes the segments to the TAP device.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The TAP driver instance data.
+ * @param   pbFrame         The GSO frame, the headers are modified.
+ * @param   cbFrame         The size of the GSO frame.
+ * @param   pGso            The GSO context.
+ */
+static int drvTAPSendGsoFrame(PDRVTAP pThis, uint8_t *pbFrame, size_t cbFrame, PCPDMNETWORKGSO pGso)
+{
+    uint8_t         abHdrScratch[256];
+    uint32_t const  cSegs = PDMNetGsoCalcSegmentCount(pGso, cbFrame);  Assert(cSegs > 1);
+    int             rc    = VINF_SUCCESS;
+    for (size_t iSeg = 0; iSeg < cSegs; iSeg++)
+    {
+        uint32_t cbSegFrame;
+        void *pvSegFrame = PDMNetGsoCarveSegmentQD(pGso, pbFrame, cbFrame, abHdrScratch,
+                                                   iSeg, cSegs, &cbSegFrame);
+        rc = RTFileWrite(pThis->hFileDevice, pvSegFrame, cbSegFrame, NULL);
+        if (RT_FAILURE(rc))
+            break;
+    }
+    return rc;
+}
+
+
 /**
  * @interface_method_impl{PDMINETWORKUP,pfnSendBuf}
  */
@@ -256,27 +318,90 @@ static DECLCALLBACK(int) drvTAPNetworkUp_SendBuf(PPDMINETWORKUP pInterface, PPDM
         rc = RTFileWrite(pThis->hFileDevice, pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed, NULL);
     }
     else
+        rc = drvTAPSendGsoFrame(pThis, (uint8_t *)pSgBuf->aSegs[0].pvSeg, pSgBuf->cbUsed,
+                                (PCPDMNETWORKGSO)pSgBuf->pvUser);
+
+    pSgBuf->fFlags = 0;
+    RTMemFree(pSgBuf);
+
+    STAM_PROFILE_STOP(&pThis->StatTransmit, a);
+    AssertRC(rc);
+    if (RT_FAILURE(rc))
+        rc = rc == VERR_NO_MEMORY ? VERR_NET_NO_BUFFER_SPACE : VERR_NET_DOWN;
+    return rc;
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKUP,pfnSendSg}
+ */
+static DECLCALLBACK(int) drvTAPNetworkUp_SendSg(PPDMINETWORKUP pInterface, PPDMSCATTERGATHER pSgBuf, bool fOnWorkerThread)
+{
+    PDRVTAP pThis = PDMINETWORKUP_2_DRVTAP(pInterface);
+    Assert((pSgBuf->fFlags & PDMSCATTERGATHER_FLAGS_MAGIC_MASK) == PDMSCATTERGATHER_FLAGS_MAGIC);
+    Assert(RTCritSectIsOwner(&pThis->XmitLock));
+
+    /* Set an FTM checkpoint as this operation changes the state permanently. */
+    PDMDrvHlpFTSetCheckpoint(pThis->pDrvIns, FTMCHECKPOINTTYPE_NETWORK);
+
+    int rc;
+    if (!pSgBuf->pvUser)
     {
-        uint8_t         abHdrScratch[256];
-        uint8_t const  *pbFrame = (uint8_t const *)pSgBuf->aSegs[0].pvSeg;
-        PCPDMNETWORKGSO pGso    = (PCPDMNETWORKGSO)pSgBuf->pvUser;
-        uint32_t const  cSegs   = PDMNetGsoCalcSegmentCount(pGso, pSgBuf->cbUsed);  Assert(cSegs > 1);
-        rc = VINF_SUCCESS;
-        for (size_t iSeg = 0; iSeg < cSegs; iSeg++)
+        /*
+         * Hand the segments to the kernel as they are, the TAP device turns
+         * each write into exactly one frame.
+         */
+        struct iovec aIov[64];
+        if (pSgBuf->cSegs > RT_ELEMENTS(aIov))
+            return VERR_TRY_AGAIN;
+        for (size_t iSeg = 0; iSeg < pSgBuf->cSegs; iSeg++)
         {
-            uint32_t cbSegFrame;
-            void *pvSegFrame = PDMNetGsoCarveSegmentQD(pGso, (uint8_t *)pbFrame, pSgBuf->cbUsed, abHdrScratch,
-                                                       iSeg, cSegs, &cbSegFrame);
-            rc = RTFileWrite(pThis->hFileDevice, pvSegFrame, cbSegFrame, NULL);
-            if (RT_FAILURE(rc))
-                break;
+            aIov[iSeg].iov_base = pSgBuf->aSegs[iSeg].pvSeg;
+            aIov[iSeg].iov_len  = pSgBuf->aSegs[iSeg].cbSeg;
         }
+
+        STAM_COUNTER_INC(&pThis->StatPktSent);
+        STAM_COUNTER_ADD(&pThis->StatPktSentBytes, pSgBuf->cbUsed);
+        STAM_PROFILE_START(&pThis->StatTransmit, a);
+        ssize_t cbWritten = writev((int)RTFileToNative(pThis->hFileDevice), aIov, (int)pSgBuf->cSegs);
+        if (cbWritten == (ssize_t)pSgBuf->cbUsed)
+            rc = VINF_SUCCESS;
+        else
+            rc = cbWritten < 0 ? RTErrConvertFromErrno(errno) : VERR_WRITE_ERROR;
+        STAM_PROFILE_STOP(&pThis->StatTransmit, a);
     }
+    else
+    {
+        /*
+         * GSO frames are carved up in place, which needs a linear and
+         * writable copy.  Still saves the device its own copy.
+         */
+        if (pThis->cbXmitScratch < pSgBuf->cbUsed)
+        {
+            void *pvNew = RTMemRealloc(pThis->pbXmitScratch, pSgBuf->cbUsed);
+            if (!pvNew)
+                return VERR_TRY_AGAIN;
+            pThis->pbXmitScratch = (uint8_t *)pvNew;
+            pThis->cbXmitScratch = pSgBuf->cbUsed;
+        }
 
-    pSgBuf->fFlags = 0;
-    RTMemFree(pSgBuf);
+        STAM_COUNTER_INC(&pThis->StatPktSent);
+        STAM_COUNTER_ADD(&pThis->StatPktSentBytes, pSgBuf->cbUsed);
+        STAM_PROFILE_START(&pThis->StatTransmit, a);
+
+        uint8_t *pbDst  = pThis->pbXmitScratch;
+        size_t   cbLeft = pSgBuf->cbUsed;
+        for (size_t iSeg = 0; iSeg < pSgBuf->cSegs && cbLeft; iSeg++)
+        {
+            size_t cbSeg = RT_MIN(pSgBuf->aSegs[iSeg].cbSeg, cbLeft);
+            memcpy(pbDst, pSgBuf->aSegs[iSeg].pvSeg, cbSeg);
+            pbDst  += cbSeg;
+            cbLeft -= cbSeg;
+        }
+        rc = drvTAPSendGsoFrame(pThis, pThis->pbXmitScratch, pSgBuf->cbUsed, (PCPDMNETWORKGSO)pSgBuf->pvUser);
+        STAM_PROFILE_STOP(&pThis->StatTransmit, a);
+    }
 
-    STAM_PROFILE_STOP(&pThis->StatTransmit, a);
     AssertRC(rc);
     if (RT_FAILURE(rc))
         rc = rc == VERR_NO_MEMORY ? VERR_NET_NO_BUFFER_SPACE : VERR_NET_DOWN;
@@ -318,6 +443,196 @@ static DECLCALLBACK(void) drvTAPNetworkUp_NotifyLinkChanged(PPDMINETWORKUP pInte
 }
 
 
+#ifdef RT_OS_LINUX
+/* -=-=-=-=- PDMINETWORKVHOST -=-=-=-=- */
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnGetFeatures}
+ */
+static DECLCALLBACK(int) drvTAPVhost_GetFeatures(PPDMINETWORKVHOST pInterface, uint64_t *pfFeatures)
+{
+    PDRVTAP pThis = PDMINETWORKVHOST_2_DRVTAP(pInterface);
+    return VhostNetGetFeatures(&pThis->Vhost, pfFeatures);
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnStart}
+ */
+static DECLCALLBACK(int) drvTAPVhost_Start(PPDMINETWORKVHOST pInterface, uint64_t fFeatures,
+                                           PCPDMNETVHOSTMEMREGION paRegions, uint32_t cRegions,
+                                           PCPDMNETVHOSTRING paRings, uint32_t cRings)
+{
+    PDRVTAP pThis = PDMINETWORKVHOST_2_DRVTAP(pInterface);
+    AssertReturn(cRings == VHOSTNET_RINGS, VERR_INVALID_PARAMETER);
+    AssertReturn(!pThis->fVhostActive, VERR_WRONG_ORDER);
+
+    int rc = VhostNetSetup(&pThis->Vhost, fFeatures, paRegions, cRegions, paRings, cRings);
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("TAP#%d: Configuring vhost-net failed (%Rrc)\n", pThis->pDrvIns->iInstance, rc));
+        return rc;
+    }
+
+    /*
+     * Get the reader thread out of the way before the kernel starts reading
+     * from the TAP device.  The device above has already made sure the
+     * thread isn't stuck waiting for receive buffers.
+     */
+    RTSemEventWait(pThis->hEvtVhostRxParked, 0); /* drain stale signal */
+    ASMAtomicWriteBool(&pThis->fVhostActive, true);
+    if (pThis->pThread && pThis->pThread->enmState == PDMTHREADSTATE_RUNNING)
+    {
+        size_t cbIgnored;
+        RTPipeWrite(pThis->hPipeWrite, "", 1, &cbIgnored);
+        rc = RTSemEventWait(pThis->hEvtVhostRxParked, 5000);
+        if (RT_FAILURE(rc))
+        {
+            LogRel(("TAP#%d: The reader thread didn't park (%Rrc), not starting vhost-net\n", pThis->pDrvIns->iInstance, rc));
+            ASMAtomicWriteBool(&pThis->fVhostActive, false);
+            return rc;
+        }
+    }
+
+    rc = VhostNetSetBackend(&pThis->Vhost, (int)RTFileToNative(pThis->hFileDevice));
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("TAP#%d: VHOST_NET_SET_BACKEND failed (%Rrc)\n", pThis->pDrvIns->iInstance, rc));
+        ASMAtomicWriteBool(&pThis->fVhostActive, false);
+        size_t cbIgnored;
+        RTPipeWrite(pThis->hPipeWrite, "", 1, &cbIgnored);
+        return rc;
+    }
+
+    /* Kick both rings in case the guest queued buffers before we got here. */
+    for (uint32_t i = 0; i < cRings; i++)
+        VhostNetKick(&pThis->Vhost, i);
+
+    LogRel(("TAP#%d: vhost-net data path started (features=%#RX64, %u initial translations)\n",
+            pThis->pDrvIns->iInstance, fFeatures, cRegions));
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnStop}
+ */
+static DECLCALLBACK(int) drvTAPVhost_Stop(PPDMINETWORKVHOST pInterface, uint16_t *paidxAvail, uint32_t cRings)
+{
+    PDRVTAP pThis = PDMINETWORKVHOST_2_DRVTAP(pInterface);
+    AssertReturn(cRings == VHOSTNET_RINGS, VERR_INVALID_PARAMETER);
+    if (!pThis->fVhostActive)
+        return VERR_WRONG_ORDER;
+
+    int rc = VhostNetSetBackend(&pThis->Vhost, -1);
+    if (RT_FAILURE(rc))
+        LogRel(("TAP#%d: Detaching the vhost-net backend failed (%Rrc)\n", pThis->pDrvIns->iInstance, rc));
+    rc = VhostNetGetRingBases(&pThis->Vhost, paidxAvail, cRings);
+
+    /* Let the reader thread have the device back. */
+    ASMAtomicWriteBool(&pThis->fVhostActive, false);
+    size_t cbIgnored;
+    RTPipeWrite(pThis->hPipeWrite, "", 1, &cbIgnored);
+
+    LogRel(("TAP#%d: vhost-net data path stopped (%Rrc)\n", pThis->pDrvIns->iInstance, rc));
+    return rc;
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnMap}
+ */
+static DECLCALLBACK(int) drvTAPVhost_Map(PPDMINETWORKVHOST pInterface, RTGCPHYS GCPhys, uint64_t cb, RTR3PTR pvR3)
+{
+    PDRVTAP pThis = PDMINETWORKVHOST_2_DRVTAP(pInterface);
+    return VhostNetMap(&pThis->Vhost, GCPhys, cb, pvR3);
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnUnmap}
+ */
+static DECLCALLBACK(int) drvTAPVhost_Unmap(PPDMINETWORKVHOST pInterface, RTGCPHYS GCPhys, uint64_t cb)
+{
+    PDRVTAP pThis = PDMINETWORKVHOST_2_DRVTAP(pInterface);
+    return VhostNetUnmap(&pThis->Vhost, GCPhys, cb);
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnKick}
+ */
+static DECLCALLBACK(void) drvTAPVhost_Kick(PPDMINETWORKVHOST pInterface, uint32_t iRing)
+{
+    PDRVTAP pThis = PDMINETWORKVHOST_2_DRVTAP(pInterface);
+    VhostNetKick(&pThis->Vhost, iRing);
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnWaitInterrupt}
+ */
+static DECLCALLBACK(int) drvTAPVhost_WaitInterrupt(PPDMINETWORKVHOST pInterface, RTMSINTERVAL cMillies, uint32_t *pfRings,
+                                                   PRTGCPHYS pGCPhysMiss)
+{
+    PDRVTAP pThis = PDMINETWORKVHOST_2_DRVTAP(pInterface);
+    return VhostNetWait(&pThis->Vhost, cMillies, pfRings, pGCPhysMiss);
+}
+
+
+/**
+ * @interface_method_impl{PDMINETWORKVHOST,pfnWakeupWait}
+ */
+static DECLCALLBACK(void) drvTAPVhost_WakeupWait(PPDMINETWORKVHOST pInterface)
+{
+    PDRVTAP pThis = PDMINETWORKVHOST_2_DRVTAP(pInterface);
+    VhostNetWakeup(&pThis->Vhost);
+}
+
+
+/**
+ * Opens /dev/vhost-net and creates the eventfds if requested by the
+ * configuration.
+ *
+ * Failure is not fatal, the TAP device works fine without it.
+ *
+ * @param   pThis           The instance data.
+ */
+static void drvTAPVhostInit(PDRVTAP pThis)
+{
+    int rc = RTSemEventCreate(&pThis->hEvtVhostRxParked);
+    if (RT_SUCCESS(rc))
+        rc = VhostNetOpen(&pThis->Vhost);
+    if (RT_FAILURE(rc))
+    {
+        LogRel(("TAP#%d: vhost-net with device IOTLB support is not available (%Rrc), using the user space data path\n",
+                pThis->pDrvIns->iInstance, rc));
+        return;
+    }
+    LogRel(("TAP#%d: vhost-net available\n", pThis->pDrvIns->iInstance));
+}
+
+
+/**
+ * Releases the vhost-net resources.
+ *
+ * @param   pThis           The instance data.
+ */
+static void drvTAPVhostTerm(PDRVTAP pThis)
+{
+    if (pThis->Vhost.fdVhost >= 0 && pThis->fVhostActive)
+        VhostNetSetBackend(&pThis->Vhost, -1);
+    VhostNetClose(&pThis->Vhost);
+    if (pThis->hEvtVhostRxParked != NIL_RTSEMEVENT)
+    {
+        RTSemEventDestroy(pThis->hEvtVhostRxParked);
+        pThis->hEvtVhostRxParked = NIL_RTSEMEVENT;
+    }
+}
+
+#endif /* RT_OS_LINUX */
+
+
 /**
  * Asynchronous I/O thread for handling receive.
  *
@@ -345,6 +660,20 @@ static DECLCALLBACK(int) drvTAPAsyncIoThread(PPDMDRVINS pDrvIns, PPDMTHREAD pThr
          */
         struct pollfd aFDs[2];
         aFDs[0].fd      = RTFileToNative(pThis->hFileDevice);
+#ifdef RT_OS_LINUX
+        /* The kernel owns the device while vhost-net is active, only watch the pipe. */
+        if (ASMAtomicReadBool(&pThis->fVhostActive))
+        {
+            aFDs[0].fd = -1;
+            if (!pThis->fVhostRxParked)
+            {
+                pThis->fVhostRxParked = true;
+                RTSemEventSignal(pThis->hEvtVhostRxParked);
+            }
+        }
+        else
+            pThis->fVhostRxParked = false;
+#endif
         aFDs[0].events  = POLLIN | POLLPRI;
         aFDs[0].revents = 0;
         aFDs[1].fd      = RTPipeToNative(pThis->hPipeRead);
@@ -749,6 +1078,10 @@ static DECLCALLBACK(void *) drvTAPQueryInterface(PPDMIBASE pInterface, const cha
 
     PDMIBASE_RETURN_INTERFACE(pszIID, PDMIBASE, &pDrvIns->IBase);
     PDMIBASE_RETURN_INTERFACE(pszIID, PDMINETWORKUP, &pThis->INetworkUp);
+#ifdef RT_OS_LINUX
+    if (pThis->Vhost.fdVhost >= 0)
+        PDMIBASE_RETURN_INTERFACE(pszIID, PDMINETWORKVHOST, &pThis->INetworkVhost);
+#endif
     return NULL;
 }
 
@@ -768,6 +1101,10 @@ static DECLCALLBACK(void) drvTAPDestruct(PPDMDRVINS pDrvIns)
     PDRVTAP pThis = PDMINS_2_DATA(pDrvIns, PDRVTAP);
     PDMDRV_CHECK_VERSIONS_RETURN_VOID(pDrvIns);
 
+#ifdef RT_OS_LINUX
+    drvTAPVhostTerm(pThis);
+#endif
+
     /*
      * Terminate the control pipe.
      */
@@ -819,6 +1156,8 @@ static DECLCALLBACK(void) drvTAPDestruct(PPDMDRVINS pDrvIns)
      */
     if (RTCritSectIsInitialized(&pThis->XmitLock))
         RTCritSectDelete(&pThis->XmitLock);
+    RTMemFree(pThis->pbXmitScratch);
+    pThis->pbXmitScratch = NULL;
 
 #ifdef VBOX_WITH_STATISTICS
     /*
@@ -858,6 +1197,13 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
 #endif
     pThis->pszSetupApplication          = NULL;
     pThis->pszTerminateApplication      = NULL;
+#ifdef RT_OS_LINUX
+    pThis->Vhost.fdVhost                = -1;
+    pThis->Vhost.fdWakeup               = -1;
+    for (unsigned i = 0; i < VHOSTNET_RINGS; i++)
+        pThis->Vhost.afdKick[i] = pThis->Vhost.afdCall[i] = -1;
+    pThis->hEvtVhostRxParked            = NIL_RTSEMEVENT;
+#endif
 
     /* IBase */
     pDrvIns->IBase.pfnQueryInterface    = drvTAPQueryInterface;
@@ -869,6 +1215,18 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     pThis->INetworkUp.pfnEndXmit                = drvTAPNetworkUp_EndXmit;
     pThis->INetworkUp.pfnSetPromiscuousMode     = drvTAPNetworkUp_SetPromiscuousMode;
     pThis->INetworkUp.pfnNotifyLinkChanged      = drvTAPNetworkUp_NotifyLinkChanged;
+    pThis->INetworkUp.pfnSendSg                 = drvTAPNetworkUp_SendSg;
+#ifdef RT_OS_LINUX
+    /* INetworkVhost */
+    pThis->INetworkVhost.pfnGetFeatures         = drvTAPVhost_GetFeatures;
+    pThis->INetworkVhost.pfnStart               = drvTAPVhost_Start;
+    pThis->INetworkVhost.pfnStop                = drvTAPVhost_Stop;
+    pThis->INetworkVhost.pfnMap                 = drvTAPVhost_Map;
+    pThis->INetworkVhost.pfnUnmap               = drvTAPVhost_Unmap;
+    pThis->INetworkVhost.pfnKick                = drvTAPVhost_Kick;
+    pThis->INetworkVhost.pfnWaitInterrupt       = drvTAPVhost_WaitInterrupt;
+    pThis->INetworkVhost.pfnWakeupWait          = drvTAPVhost_WakeupWait;
+#endif
 
 #ifdef VBOX_WITH_STATISTICS
     /*
@@ -885,7 +1243,7 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     /*
      * Validate the config.
      */
-    if (!CFGMR3AreValuesValid(pCfg, "Device\0InitProg\0TermProg\0FileHandle\0TAPSetupApplication\0TAPTerminateApplication\0MAC"))
+    if (!CFGMR3AreValuesValid(pCfg, "Device\0InitProg\0TermProg\0FileHandle\0TAPSetupApplication\0TAPTerminateApplication\0MAC\0VhostNet"))
         return PDMDRV_SET_ERROR(pDrvIns, VERR_PDM_DRVINS_UNKNOWN_CFG_VALUES, "");
 
     /*
@@ -980,6 +1338,18 @@ static DECLCALLBACK(int) drvTAPConstruct(PPDMDRVINS pDrvIns, PCFGMNODE pCfg, uin
     Log(("drvTAPContruct: %d (from fd)\n", pThis->hFileDevice));
     rc = VINF_SUCCESS;
 
+#ifdef RT_OS_LINUX
+    /*
+     * Optional vhost-net data path for virtio-net.
+     */
+    bool fVhostNet;
+    rc = CFGMR3QueryBoolDef(pCfg, "VhostNet", &fVhostNet, false);
+    if (RT_FAILURE(rc))
+        return PDMDRV_SET_ERROR(pDrvIns, rc, N_("Configuration error: Failed to get the value of 'VhostNet'"));
+    if (fVhostNet)
+        drvTAPVhostInit(pThis);
+#endif
+
     /*
      * Create the control pipe.
      */
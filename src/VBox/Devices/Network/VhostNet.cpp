@@ -0,0 +1,415 @@
+/* $Id: VhostNet.cpp $ */
+/** @file
+ * Helpers for driving the Linux vhost-net kernel data path.
+ *
+ * The kernel is always run with a device IOTLB (VIRTIO_F_IOMMU_PLATFORM), so
+ * ring and buffer addresses are guest physical and translated on demand.
+ * Guest RAM has no linear mapping in the VM process, it is mapped in GMM
+ * chunks, so a static memory table would need far more regions than vhost
+ * accepts.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ */
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "VhostNet.h"
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/string.h>
+
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/poll.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+/* vhost.h needs nothing from virtio_ring.h, whose inline helpers are not C++. */
+#define _LINUX_VIRTIO_RING_H
+#include <linux/vhost.h>
+#include <linux/virtio_config.h>
+
+#ifndef VIRTIO_F_IOMMU_PLATFORM
+# define VIRTIO_F_IOMMU_PLATFORM    33
+#endif
+
+
+/**
+ * Opens /dev/vhost-net and creates the eventfds.
+ *
+ * Fails if the kernel cannot translate guest addresses on demand.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance, all descriptors are set to -1 on
+ *                          failure.
+ */
+int VhostNetOpen(PVHOSTNET pThis)
+{
+    pThis->fdVhost  = -1;
+    pThis->fdWakeup = -1;
+    for (unsigned i = 0; i < VHOSTNET_RINGS; i++)
+        pThis->afdKick[i] = pThis->afdCall[i] = -1;
+
+    pThis->fdVhost = open("/dev/vhost-net", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (pThis->fdVhost < 0)
+        return RTErrConvertFromErrno(errno);
+
+    int rc = VINF_SUCCESS;
+    uint64_t fFeatures = 0;
+    if (   ioctl(pThis->fdVhost, VHOST_SET_OWNER, NULL) < 0
+        || ioctl(pThis->fdVhost, VHOST_GET_FEATURES, &fFeatures) < 0)
+        rc = RTErrConvertFromErrno(errno);
+    else if (!(fFeatures & RT_BIT_64(VIRTIO_F_IOMMU_PLATFORM)))
+        rc = VERR_NOT_SUPPORTED;
+
+    for (unsigned i = 0; i < VHOSTNET_RINGS && RT_SUCCESS(rc); i++)
+    {
+        pThis->afdKick[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        pThis->afdCall[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (pThis->afdKick[i] < 0 || pThis->afdCall[i] < 0)
+            rc = RTErrConvertFromErrno(errno);
+    }
+    if (RT_SUCCESS(rc))
+    {
+        pThis->fdWakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (pThis->fdWakeup < 0)
+            rc = RTErrConvertFromErrno(errno);
+    }
+
+    if (RT_FAILURE(rc))
+        VhostNetClose(pThis);
+    return rc;
+}
+
+
+/**
+ * Closes all descriptors, the kernel lets go of the rings and the TAP device.
+ *
+ * @param   pThis           The instance.
+ */
+void VhostNetClose(PVHOSTNET pThis)
+{
+    if (pThis->fdVhost >= 0)
+    {
+        close(pThis->fdVhost);
+        pThis->fdVhost = -1;
+    }
+    for (unsigned i = 0; i < VHOSTNET_RINGS; i++)
+    {
+        if (pThis->afdKick[i] >= 0)
+            close(pThis->afdKick[i]);
+        if (pThis->afdCall[i] >= 0)
+            close(pThis->afdCall[i]);
+        pThis->afdKick[i] = pThis->afdCall[i] = -1;
+    }
+    if (pThis->fdWakeup >= 0)
+    {
+        close(pThis->fdWakeup);
+        pThis->fdWakeup = -1;
+    }
+}
+
+
+/**
+ * Gets the virtio feature bits the kernel offers.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance.
+ * @param   pfFeatures      Where to return the feature bits.
+ */
+int VhostNetGetFeatures(PVHOSTNET pThis, uint64_t *pfFeatures)
+{
+    uint64_t fFeatures = 0;
+    if (ioctl(pThis->fdVhost, VHOST_GET_FEATURES, &fFeatures) < 0)
+        return RTErrConvertFromErrno(errno);
+    *pfFeatures = fFeatures;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Configures features, initial translations and rings.
+ *
+ * The virtio-net header is added and stripped by the kernel, the TAP device
+ * is not expected to use one.  Any previous translations are dropped.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance.
+ * @param   fFeatures       The negotiated virtio feature bits.
+ * @param   paRegions       The initial translations, must cover the rings.
+ * @param   cRegions        Number of translations.
+ * @param   paRings         The rings, receive queue first.
+ * @param   cRings          Number of rings, VHOSTNET_RINGS.
+ */
+int VhostNetSetup(PVHOSTNET pThis, uint64_t fFeatures, PCPDMNETVHOSTMEMREGION paRegions, uint32_t cRegions,
+                  PCPDMNETVHOSTRING paRings, uint32_t cRings)
+{
+    AssertReturn(cRings == VHOSTNET_RINGS, VERR_INVALID_PARAMETER);
+
+    /* Setting the IOMMU feature gives us a fresh IOTLB. */
+    fFeatures |= RT_BIT_64(VHOST_NET_F_VIRTIO_NET_HDR) | RT_BIT_64(VIRTIO_F_IOMMU_PLATFORM);
+    if (ioctl(pThis->fdVhost, VHOST_SET_FEATURES, &fFeatures) < 0)
+        return RTErrConvertFromErrno(errno);
+
+    /* The memory table is not consulted with an IOTLB, but it must exist. */
+    struct vhost_memory Mem;
+    RT_ZERO(Mem);
+    if (ioctl(pThis->fdVhost, VHOST_SET_MEM_TABLE, &Mem) < 0)
+        return RTErrConvertFromErrno(errno);
+
+    for (uint32_t i = 0; i < cRegions; i++)
+    {
+        int rc = VhostNetMap(pThis, paRegions[i].GCPhys, paRegions[i].cb, paRegions[i].pvR3);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
+
+    for (uint32_t i = 0; i < cRings; i++)
+    {
+        struct vhost_vring_state State;
+        struct vhost_vring_addr  Addr;
+        struct vhost_vring_file  File;
+
+        State.index = i;
+        State.num   = paRings[i].cEntries;
+        if (ioctl(pThis->fdVhost, VHOST_SET_VRING_NUM, &State) < 0)
+            return RTErrConvertFromErrno(errno);
+        State.num   = paRings[i].idxAvail;
+        if (ioctl(pThis->fdVhost, VHOST_SET_VRING_BASE, &State) < 0)
+            return RTErrConvertFromErrno(errno);
+
+        RT_ZERO(Addr);
+        Addr.index           = i;
+        Addr.desc_user_addr  = paRings[i].GCPhysDesc;
+        Addr.avail_user_addr = paRings[i].GCPhysAvail;
+        Addr.used_user_addr  = paRings[i].GCPhysUsed;
+        if (ioctl(pThis->fdVhost, VHOST_SET_VRING_ADDR, &Addr) < 0)
+            return RTErrConvertFromErrno(errno);
+
+        File.index = i;
+        File.fd    = pThis->afdKick[i];
+        if (ioctl(pThis->fdVhost, VHOST_SET_VRING_KICK, &File) < 0)
+            return RTErrConvertFromErrno(errno);
+        File.fd    = pThis->afdCall[i];
+        if (ioctl(pThis->fdVhost, VHOST_SET_VRING_CALL, &File) < 0)
+            return RTErrConvertFromErrno(errno);
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Attaches the TAP device to all rings or detaches it.
+ *
+ * @returns IPRT status code.  On failure all rings are detached.
+ * @param   pThis           The instance.
+ * @param   fdTap           The TAP device, -1 to detach.
+ */
+int VhostNetSetBackend(PVHOSTNET pThis, int fdTap)
+{
+    int rc = VINF_SUCCESS;
+    for (unsigned i = 0; i < VHOSTNET_RINGS; i++)
+    {
+        struct vhost_vring_file Backend;
+        Backend.index = i;
+        Backend.fd    = fdTap;
+        if (ioctl(pThis->fdVhost, VHOST_NET_SET_BACKEND, &Backend) < 0)
+        {
+            rc = RTErrConvertFromErrno(errno);
+            if (fdTap >= 0)
+            {
+                VhostNetSetBackend(pThis, -1);
+                break;
+            }
+        }
+    }
+    return rc;
+}
+
+
+/**
+ * Queries the index of the next available descriptor of each ring, call
+ * after detaching the TAP device.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance.
+ * @param   paidxAvail      Where to return the indexes.
+ * @param   cRings          Number of rings, VHOSTNET_RINGS.
+ */
+int VhostNetGetRingBases(PVHOSTNET pThis, uint16_t *paidxAvail, uint32_t cRings)
+{
+    AssertReturn(cRings == VHOSTNET_RINGS, VERR_INVALID_PARAMETER);
+    int rc = VINF_SUCCESS;
+    for (uint32_t i = 0; i < cRings; i++)
+    {
+        struct vhost_vring_state State;
+        State.index = i;
+        State.num   = 0;
+        if (ioctl(pThis->fdVhost, VHOST_GET_VRING_BASE, &State) < 0)
+            rc = RTErrConvertFromErrno(errno);
+        else
+            paidxAvail[i] = (uint16_t)State.num;
+    }
+    return rc;
+}
+
+
+/**
+ * Sends an IOTLB message to the kernel.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance.
+ * @param   bType           VHOST_IOTLB_UPDATE or VHOST_IOTLB_INVALIDATE.
+ * @param   GCPhys          The guest physical address.
+ * @param   cb              The size of the range.
+ * @param   pvR3            The mapping for updates.
+ */
+static int vhostNetIotlbMsg(PVHOSTNET pThis, uint8_t bType, RTGCPHYS GCPhys, uint64_t cb, RTR3PTR pvR3)
+{
+    struct vhost_msg Msg;
+    RT_ZERO(Msg);
+    Msg.type        = VHOST_IOTLB_MSG;
+    Msg.iotlb.iova  = GCPhys;
+    Msg.iotlb.size  = cb;
+    Msg.iotlb.uaddr = (uintptr_t)pvR3;
+    Msg.iotlb.perm  = VHOST_ACCESS_RW;
+    Msg.iotlb.type  = bType;
+    ssize_t cbWritten = write(pThis->fdVhost, &Msg, sizeof(Msg));
+    if (cbWritten == (ssize_t)sizeof(Msg))
+        return VINF_SUCCESS;
+    return cbWritten < 0 ? RTErrConvertFromErrno(errno) : VERR_WRITE_ERROR;
+}
+
+
+/**
+ * Gives the kernel a translation.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance.
+ * @param   GCPhys          The guest physical address.
+ * @param   cb              The size of the range.
+ * @param   pvR3            Where the range is mapped, must stay mapped until
+ *                          withdrawn or the instance is set up again.
+ */
+int VhostNetMap(PVHOSTNET pThis, RTGCPHYS GCPhys, uint64_t cb, RTR3PTR pvR3)
+{
+    return vhostNetIotlbMsg(pThis, VHOST_IOTLB_UPDATE, GCPhys, cb, pvR3);
+}
+
+
+/**
+ * Withdraws a translation, the kernel does not use the range any more when
+ * this returns.
+ *
+ * @returns IPRT status code.
+ * @param   pThis           The instance.
+ * @param   GCPhys          The guest physical address.
+ * @param   cb              The size of the range.
+ */
+int VhostNetUnmap(PVHOSTNET pThis, RTGCPHYS GCPhys, uint64_t cb)
+{
+    return vhostNetIotlbMsg(pThis, VHOST_IOTLB_INVALIDATE, GCPhys, cb, NIL_RTR3PTR);
+}
+
+
+/**
+ * Notifies the kernel about new buffers in a ring.
+ *
+ * @param   pThis           The instance.
+ * @param   iRing           The ring.
+ */
+void VhostNetKick(PVHOSTNET pThis, uint32_t iRing)
+{
+    AssertReturnVoid(iRing < VHOSTNET_RINGS);
+    eventfd_write(pThis->afdKick[iRing], 1);
+}
+
+
+/**
+ * Waits for used ring updates or a translation miss.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_TIMEOUT if nothing happened within the given time.
+ * @retval  VERR_INTERRUPTED if woken up by VhostNetWakeup.
+ * @param   pThis           The instance.
+ * @param   cMillies        How long to wait.
+ * @param   pfRings         Where to return the bitmap of rings the kernel
+ *                          signalled.
+ * @param   pGCPhysMiss     Where to return the guest physical address the
+ *                          kernel needs a translation for, NIL_RTGCPHYS if
+ *                          none.
+ */
+int VhostNetWait(PVHOSTNET pThis, RTMSINTERVAL cMillies, uint32_t *pfRings, PRTGCPHYS pGCPhysMiss)
+{
+    struct pollfd aFDs[VHOSTNET_RINGS + 2];
+    for (unsigned i = 0; i < VHOSTNET_RINGS; i++)
+    {
+        aFDs[i].fd      = pThis->afdCall[i];
+        aFDs[i].events  = POLLIN;
+        aFDs[i].revents = 0;
+    }
+    aFDs[VHOSTNET_RINGS].fd          = pThis->fdVhost;
+    aFDs[VHOSTNET_RINGS].events      = POLLIN;
+    aFDs[VHOSTNET_RINGS].revents     = 0;
+    aFDs[VHOSTNET_RINGS + 1].fd      = pThis->fdWakeup;
+    aFDs[VHOSTNET_RINGS + 1].events  = POLLIN;
+    aFDs[VHOSTNET_RINGS + 1].revents = 0;
+
+    *pfRings     = 0;
+    *pGCPhysMiss = NIL_RTGCPHYS;
+    int rc = poll(&aFDs[0], RT_ELEMENTS(aFDs), cMillies == RT_INDEFINITE_WAIT ? -1 : (int)cMillies);
+    if (rc < 0)
+        return errno == EINTR ? VERR_INTERRUPTED : RTErrConvertFromErrno(errno);
+    if (rc == 0)
+        return VERR_TIMEOUT;
+
+    eventfd_t uIgnored;
+    for (unsigned i = 0; i < VHOSTNET_RINGS; i++)
+        if (aFDs[i].revents & POLLIN)
+        {
+            eventfd_read(aFDs[i].fd, &uIgnored);
+            *pfRings |= RT_BIT_32(i);
+        }
+
+    /* One miss at a time, the descriptor stays readable if there are more. */
+    if (aFDs[VHOSTNET_RINGS].revents & POLLIN)
+    {
+        struct vhost_msg Msg;
+        ssize_t cbRead = read(pThis->fdVhost, &Msg, sizeof(Msg));
+        if (   cbRead == (ssize_t)sizeof(Msg)
+            && Msg.type == VHOST_IOTLB_MSG
+            && Msg.iotlb.type == VHOST_IOTLB_MISS)
+            *pGCPhysMiss = Msg.iotlb.iova;
+    }
+
+    if (aFDs[VHOSTNET_RINGS + 1].revents & POLLIN)
+    {
+        eventfd_read(pThis->fdWakeup, &uIgnored);
+        if (!*pfRings && *pGCPhysMiss == NIL_RTGCPHYS)
+            return VERR_INTERRUPTED;
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Wakes up a thread blocking in VhostNetWait.
+ *
+ * @param   pThis           The instance.
+ */
+void VhostNetWakeup(PVHOSTNET pThis)
+{
+    eventfd_write(pThis->fdWakeup, 1);
+}
@@ -0,0 +1,61 @@
+/* $Id: VhostNet.h $ */
+/** @file
+ * Helpers for driving the Linux vhost-net kernel data path.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ */
+
+#ifndef ___VBox_VhostNet_h
+#define ___VBox_VhostNet_h
+
+#include <VBox/types.h>
+#include <VBox/vmm/pdmnetifs.h>
+
+RT_C_DECLS_BEGIN
+
+/** Number of rings handled by vhost-net (receive and transmit). */
+#define VHOSTNET_RINGS      2
+
+/**
+ * A vhost-net instance with its eventfds.
+ */
+typedef struct VHOSTNET
+{
+    /** The /dev/vhost-net file descriptor, -1 if not open. */
+    int             fdVhost;
+    /** Kick eventfds (guest -> kernel), one per ring. */
+    int             afdKick[VHOSTNET_RINGS];
+    /** Call eventfds (kernel -> guest), one per ring. */
+    int             afdCall[VHOSTNET_RINGS];
+    /** Eventfd for waking up VhostNetWait. */
+    int             fdWakeup;
+} VHOSTNET;
+/** Pointer to a vhost-net instance. */
+typedef VHOSTNET *PVHOSTNET;
+
+int  VhostNetOpen(PVHOSTNET pThis);
+void VhostNetClose(PVHOSTNET pThis);
+int  VhostNetGetFeatures(PVHOSTNET pThis, uint64_t *pfFeatures);
+int  VhostNetSetup(PVHOSTNET pThis, uint64_t fFeatures, PCPDMNETVHOSTMEMREGION paRegions, uint32_t cRegions,
+                   PCPDMNETVHOSTRING paRings, uint32_t cRings);
+int  VhostNetSetBackend(PVHOSTNET pThis, int fdTap);
+int  VhostNetGetRingBases(PVHOSTNET pThis, uint16_t *paidxAvail, uint32_t cRings);
+int  VhostNetMap(PVHOSTNET pThis, RTGCPHYS GCPhys, uint64_t cb, RTR3PTR pvR3);
+int  VhostNetUnmap(PVHOSTNET pThis, RTGCPHYS GCPhys, uint64_t cb);
+void VhostNetKick(PVHOSTNET pThis, uint32_t iRing);
+int  VhostNetWait(PVHOSTNET pThis, RTMSINTERVAL cMillies, uint32_t *pfRings, PRTGCPHYS pGCPhysMiss);
+void VhostNetWakeup(PVHOSTNET pThis);
+
+RT_C_DECLS_END
+
+#endif
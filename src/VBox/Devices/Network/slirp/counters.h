@@ -119,6 +119,9 @@ DRV_PROFILE_COUNTER(NATRecvWait,"Time spent in NATRecv worker in waiting of free
 DRV_COUNTING_COUNTER(QueuePktSent, "counting packet sent via PDM Queue");
 DRV_COUNTING_COUNTER(QueuePktDropped, "counting packet drops by PDM Queue");
 DRV_COUNTING_COUNTER(ConsumerFalse, "counting consumer's reject number to process the queue's item");
+DRV_COUNTING_COUNTER(NATTxWorkerFrames, "counting frames handed to the NAT TX worker threads");
+DRV_PROFILE_COUNTER(NATTxWorkerCarve, "Time spent in the NAT TX workers carving GSO frames");
+DRV_COUNTING_COUNTER(NATTxSegDropped, "counting GSO segments dropped for lack of mbufs");
 # endif
 #endif /*!COUNTERS_INIT*/
 
@@ -0,0 +1,422 @@
+/* $Id: tstVhostNet.cpp $ */
+/** @file
+ * Testcase for the vhost-net helpers, runs frames through a TAP device in a
+ * private network namespace.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ */
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "../VhostNet.h"
+
+#include <iprt/asm.h>
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/param.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+
+#include <sys/ioctl.h>
+#include <sys/poll.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <netpacket/packet.h>
+#include <linux/if_tun.h>
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The guest physical address of the fake guest memory. */
+#define TST_GCPHYS_BASE         UINT64_C(0x100000)
+/** The number of pages of fake guest memory. */
+#define TST_PAGES               16
+/** The number of entries per ring. */
+#define TST_RING_SIZE           16
+/** The first buffer page, the pages below hold the rings. */
+#define TST_BUF_PAGE            8
+/** The EtherType of the test frames (local experimental). */
+#define TST_ETHERTYPE           0x88b5
+/** The size of the virtio-net header without mergeable buffers. */
+#define TST_NET_HDR_SIZE        10
+/** Size of the test frames. */
+#define TST_FRAME_SIZE          128
+/** vring descriptor flag: the buffer is written by the device. */
+#define TST_VRING_DESC_F_WRITE  2
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+typedef struct TSTVRINGDESC
+{
+    uint64_t    u64Addr;
+    uint32_t    cb;
+    uint16_t    fFlags;
+    uint16_t    idxNext;
+} TSTVRINGDESC;
+
+typedef struct TSTVRINGAVAIL
+{
+    uint16_t    fFlags;
+    uint16_t volatile idx;
+    uint16_t    aRing[TST_RING_SIZE];
+} TSTVRINGAVAIL;
+
+typedef struct TSTVRINGUSED
+{
+    uint16_t    fFlags;
+    uint16_t volatile idx;
+    struct
+    {
+        uint32_t    id;
+        uint32_t    cb;
+    }           aRing[TST_RING_SIZE];
+} TSTVRINGUSED;
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+static RTTEST       g_hTest;
+/** The fake guest memory. */
+static uint8_t     *g_pbMem;
+/** Number of translation misses answered. */
+static uint32_t     g_cMisses;
+
+
+static void *tstGCPhys2Ptr(RTGCPHYS GCPhys)
+{
+    return g_pbMem + (GCPhys - TST_GCPHYS_BASE);
+}
+
+
+static RTGCPHYS tstPage2GCPhys(uint32_t iPage)
+{
+    return TST_GCPHYS_BASE + (RTGCPHYS)iPage * PAGE_SIZE;
+}
+
+
+/**
+ * Moves into a private network namespace, with a private user namespace if
+ * we lack the privileges for the former.
+ */
+static bool tstEnterNetNs(void)
+{
+    if (unshare(CLONE_NEWNET) == 0)
+        return true;
+
+    uid_t uid = getuid();
+    gid_t gid = getgid();
+    if (unshare(CLONE_NEWUSER | CLONE_NEWNET) != 0)
+        return false;
+
+    static const struct { const char *pszFile; const char *pszFmt; } s_aMaps[] =
+    {
+        { "/proc/self/setgroups", "deny"     },
+        { "/proc/self/uid_map",   "0 %u 1\n" },
+        { "/proc/self/gid_map",   "0 %u 1\n" },
+    };
+    for (unsigned i = 0; i < RT_ELEMENTS(s_aMaps); i++)
+    {
+        char szBuf[64];
+        int cch = RTStrPrintf(szBuf, sizeof(szBuf), s_aMaps[i].pszFmt, i == 1 ? (unsigned)uid : (unsigned)gid);
+        int fd = open(s_aMaps[i].pszFile, O_WRONLY);
+        if (fd >= 0)
+        {
+            ssize_t cbWritten = write(fd, szBuf, cch);
+            close(fd);
+            if (cbWritten == cch)
+                continue;
+        }
+        if (i != 0) /* setgroups does not exist in older kernels */
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * Creates a TAP device and brings it up.
+ *
+ * @returns The TAP file descriptor, -1 on failure.
+ * @param   pszName         Where to return the interface name (IFNAMSIZ).
+ */
+static int tstCreateTap(char *pszName)
+{
+    int fdTap = open("/dev/net/tun", O_RDWR | O_CLOEXEC);
+    if (fdTap < 0)
+        return -1;
+
+    struct ifreq IfReq;
+    RT_ZERO(IfReq);
+    RTStrCopy(IfReq.ifr_name, sizeof(IfReq.ifr_name), "vbtst%d");
+    IfReq.ifr_flags = IFF_TAP | IFF_NO_PI;
+    if (ioctl(fdTap, TUNSETIFF, &IfReq) == 0)
+    {
+        RTStrCopy(pszName, IFNAMSIZ, IfReq.ifr_name);
+        int fdSock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fdSock >= 0)
+        {
+            if (ioctl(fdSock, SIOCGIFFLAGS, &IfReq) == 0)
+            {
+                IfReq.ifr_flags |= IFF_UP;
+                if (ioctl(fdSock, SIOCSIFFLAGS, &IfReq) == 0)
+                {
+                    close(fdSock);
+                    return fdTap;
+                }
+            }
+            close(fdSock);
+        }
+    }
+    RTTestFailed(g_hTest, "Setting up the TAP device failed, errno=%d", errno);
+    close(fdTap);
+    return -1;
+}
+
+
+/**
+ * Fills in a test frame.
+ */
+static void tstMakeFrame(uint8_t *pbFrame, uint8_t bSeed)
+{
+    memset(pbFrame, 0xff, 6);                       /* broadcast */
+    static const uint8_t s_abSrc[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    memcpy(pbFrame + 6, s_abSrc, sizeof(s_abSrc));
+    pbFrame[12] = TST_ETHERTYPE >> 8;
+    pbFrame[13] = TST_ETHERTYPE & 0xff;
+    for (unsigned off = 14; off < TST_FRAME_SIZE; off++)
+        pbFrame[off] = (uint8_t)(bSeed + off);
+}
+
+
+/**
+ * Waits for the kernel to complete buffers in a ring, answering translation
+ * misses on the way.
+ *
+ * @returns true if the used index reached @a idxUsed.
+ */
+static bool tstWaitUsed(PVHOSTNET pVhost, TSTVRINGUSED *pUsed, uint16_t idxUsed)
+{
+    for (unsigned i = 0; i < 50; i++)
+    {
+        if (ASMAtomicReadU16(&pUsed->idx) == idxUsed)
+            return true;
+
+        uint32_t fRings;
+        RTGCPHYS GCPhysMiss;
+        int rc = VhostNetWait(pVhost, 100, &fRings, &GCPhysMiss);
+        if (RT_SUCCESS(rc) && GCPhysMiss != NIL_RTGCPHYS)
+        {
+            RTGCPHYS GCPhysPage = GCPhysMiss & ~(RTGCPHYS)PAGE_OFFSET_MASK;
+            RTTESTI_CHECK_MSG_RET(   GCPhysPage >= tstPage2GCPhys(TST_BUF_PAGE)
+                                  && GCPhysPage <  tstPage2GCPhys(TST_PAGES),
+                                  ("Unexpected miss at %RGp\n", GCPhysMiss), false);
+            RTTESTI_CHECK_RC_RET(VhostNetMap(pVhost, GCPhysPage, PAGE_SIZE, tstGCPhys2Ptr(GCPhysPage)), VINF_SUCCESS, false);
+            g_cMisses++;
+        }
+        else if (RT_FAILURE(rc) && rc != VERR_TIMEOUT)
+        {
+            RTTestFailed(g_hTest, "VhostNetWait -> %Rrc", rc);
+            return false;
+        }
+    }
+    return ASMAtomicReadU16(&pUsed->idx) == idxUsed;
+}
+
+
+static void tstRun(PVHOSTNET pVhost, int fdTap, int fdPacket, int iIfIndex)
+{
+    /*
+     * Rings: descriptors, available and used ring each on their own page,
+     * receive ring in pages 0-2, transmit ring in pages 3-5.  Only these are
+     * translated up front, the buffers are left to the miss handling.
+     */
+    TSTVRINGDESC  *apDesc[VHOSTNET_RINGS];
+    TSTVRINGAVAIL *apAvail[VHOSTNET_RINGS];
+    TSTVRINGUSED  *apUsed[VHOSTNET_RINGS];
+    PDMNETVHOSTRING      aRings[VHOSTNET_RINGS];
+    PDMNETVHOSTMEMREGION aRegions[VHOSTNET_RINGS * 3];
+    for (uint32_t i = 0; i < VHOSTNET_RINGS; i++)
+    {
+        aRings[i].cEntries    = TST_RING_SIZE;
+        aRings[i].idxAvail    = 0;
+        aRings[i].u16Reserved = 0;
+        aRings[i].GCPhysDesc  = tstPage2GCPhys(i * 3);
+        aRings[i].GCPhysAvail = tstPage2GCPhys(i * 3 + 1);
+        aRings[i].GCPhysUsed  = tstPage2GCPhys(i * 3 + 2);
+        apDesc[i]  = (TSTVRINGDESC *)tstGCPhys2Ptr(aRings[i].GCPhysDesc);
+        apAvail[i] = (TSTVRINGAVAIL *)tstGCPhys2Ptr(aRings[i].GCPhysAvail);
+        apUsed[i]  = (TSTVRINGUSED *)tstGCPhys2Ptr(aRings[i].GCPhysUsed);
+    }
+    for (uint32_t i = 0; i < RT_ELEMENTS(aRegions); i++)
+    {
+        aRegions[i].GCPhys = tstPage2GCPhys(i);
+        aRegions[i].cb     = PAGE_SIZE;
+        aRegions[i].pvR3   = tstGCPhys2Ptr(aRegions[i].GCPhys);
+    }
+
+    RTTESTI_CHECK_RC_RETV(VhostNetSetup(pVhost, 0, aRegions, RT_ELEMENTS(aRegions), aRings, RT_ELEMENTS(aRings)),
+                          VINF_SUCCESS);
+    RTTESTI_CHECK_RC_RETV(VhostNetSetBackend(pVhost, fdTap), VINF_SUCCESS);
+
+    /*
+     * Transmit: one frame from buffer page 8, it must show up on the packet
+     * socket.
+     */
+    RTTestSub(g_hTest, "Transmit");
+    TSTVRINGDESC *pDesc = &apDesc[1][0];
+    pDesc->u64Addr = tstPage2GCPhys(TST_BUF_PAGE);
+    pDesc->cb      = TST_NET_HDR_SIZE + TST_FRAME_SIZE;
+    pDesc->fFlags  = 0;
+    pDesc->idxNext = 0;
+    uint8_t *pbTx = (uint8_t *)tstGCPhys2Ptr(pDesc->u64Addr);
+    memset(pbTx, 0, TST_NET_HDR_SIZE);
+    tstMakeFrame(pbTx + TST_NET_HDR_SIZE, 0x11);
+    apAvail[1]->aRing[0] = 0;
+    ASMCompilerBarrier();
+    ASMAtomicWriteU16(&apAvail[1]->idx, 1);
+    VhostNetKick(pVhost, 1);
+    RTTESTI_CHECK(tstWaitUsed(pVhost, apUsed[1], 1));
+
+    bool fFound = false;
+    uint8_t abFrame[2048];
+    for (unsigned i = 0; i < 16 && !fFound; i++)
+    {
+        struct pollfd PollFd = { fdPacket, POLLIN, 0 };
+        if (poll(&PollFd, 1, 200) <= 0)
+            break;
+        ssize_t cb = recv(fdPacket, abFrame, sizeof(abFrame), 0);
+        if (   cb == TST_FRAME_SIZE
+            && !memcmp(abFrame, pbTx + TST_NET_HDR_SIZE, TST_FRAME_SIZE))
+            fFound = true;
+    }
+    if (!fFound)
+        RTTestFailed(g_hTest, "The transmitted frame did not arrive");
+
+    /*
+     * Receive: post buffers in pages 10-13, send a frame through the packet
+     * socket and look for it, skipping whatever else the stack sends.
+     */
+    RTTestSub(g_hTest, "Receive");
+    uint16_t const cRxBufs = 4;
+    for (uint16_t i = 0; i < cRxBufs; i++)
+    {
+        pDesc = &apDesc[0][i];
+        pDesc->u64Addr = tstPage2GCPhys(TST_BUF_PAGE + 2 + i);
+        pDesc->cb      = PAGE_SIZE;
+        pDesc->fFlags  = TST_VRING_DESC_F_WRITE;
+        pDesc->idxNext = 0;
+        apAvail[0]->aRing[i] = i;
+    }
+    ASMCompilerBarrier();
+    ASMAtomicWriteU16(&apAvail[0]->idx, cRxBufs);
+    VhostNetKick(pVhost, 0);
+
+    tstMakeFrame(abFrame, 0x22);
+    struct sockaddr_ll Addr;
+    RT_ZERO(Addr);
+    Addr.sll_family   = AF_PACKET;
+    Addr.sll_protocol = htons(TST_ETHERTYPE);
+    Addr.sll_ifindex  = iIfIndex;
+    Addr.sll_halen    = 6;
+    memset(Addr.sll_addr, 0xff, 6);
+    RTTESTI_CHECK(sendto(fdPacket, abFrame, TST_FRAME_SIZE, 0, (struct sockaddr *)&Addr, sizeof(Addr)) == TST_FRAME_SIZE);
+
+    fFound = false;
+    for (uint16_t idxUsed = 1; idxUsed <= cRxBufs && !fFound; idxUsed++)
+    {
+        if (!tstWaitUsed(pVhost, apUsed[0], idxUsed))
+            break;
+        uint32_t id = apUsed[0]->aRing[idxUsed - 1].id;
+        uint32_t cb = apUsed[0]->aRing[idxUsed - 1].cb;
+        RTTESTI_CHECK_BREAK(id < cRxBufs);
+        uint8_t const *pbRx = (uint8_t const *)tstGCPhys2Ptr(apDesc[0][id].u64Addr);
+        if (   cb == TST_NET_HDR_SIZE + TST_FRAME_SIZE
+            && !memcmp(pbRx + TST_NET_HDR_SIZE, abFrame, TST_FRAME_SIZE))
+            fFound = true;
+    }
+    if (!fFound)
+        RTTestFailed(g_hTest, "The frame sent to the TAP device was not received");
+    RTTESTI_CHECK_MSG(g_cMisses > 0, ("The kernel never asked for a translation\n"));
+
+    /*
+     * Take the rings back and check where the kernel stopped.
+     */
+    RTTestSub(g_hTest, "Stop");
+    RTTESTI_CHECK_RC(VhostNetSetBackend(pVhost, -1), VINF_SUCCESS);
+    uint16_t aidxAvail[VHOSTNET_RINGS] = { 0, 0 };
+    RTTESTI_CHECK_RC(VhostNetGetRingBases(pVhost, aidxAvail, RT_ELEMENTS(aidxAvail)), VINF_SUCCESS);
+    RTTESTI_CHECK_MSG(aidxAvail[1] == 1, ("tx avail=%u\n", aidxAvail[1]));
+    RTTESTI_CHECK_MSG(aidxAvail[0] == ASMAtomicReadU16(&apUsed[0]->idx),
+                      ("rx avail=%u used=%u\n", aidxAvail[0], apUsed[0]->idx));
+    RTTESTI_CHECK_RC(VhostNetUnmap(pVhost, tstPage2GCPhys(TST_BUF_PAGE), PAGE_SIZE), VINF_SUCCESS);
+}
+
+
+int main()
+{
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstVhostNet", &g_hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(g_hTest);
+
+    if (access("/dev/vhost-net", R_OK | W_OK) != 0)
+        return RTTestSkipAndDestroy(g_hTest, "/dev/vhost-net is not accessible");
+    if (!tstEnterNetNs())
+        return RTTestSkipAndDestroy(g_hTest, "Cannot create a network namespace (errno=%d)", errno);
+
+    VHOSTNET Vhost;
+    int rc = VhostNetOpen(&Vhost);
+    if (rc == VERR_NOT_SUPPORTED)
+        return RTTestSkipAndDestroy(g_hTest, "vhost-net lacks device IOTLB support");
+    if (RT_FAILURE(rc))
+        return RTTestSkipAndDestroy(g_hTest, "VhostNetOpen -> %Rrc", rc);
+
+    g_pbMem = (uint8_t *)RTMemPageAllocZ(TST_PAGES * PAGE_SIZE);
+    RTTESTI_CHECK(g_pbMem != NULL);
+
+    char szTap[IFNAMSIZ];
+    int fdTap = g_pbMem ? tstCreateTap(szTap) : -1;
+    if (fdTap >= 0)
+    {
+        int iIfIndex = (int)if_nametoindex(szTap);
+        int fdPacket = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, htons(TST_ETHERTYPE));
+        struct sockaddr_ll Addr;
+        RT_ZERO(Addr);
+        Addr.sll_family   = AF_PACKET;
+        Addr.sll_protocol = htons(TST_ETHERTYPE);
+        Addr.sll_ifindex  = iIfIndex;
+        if (   fdPacket >= 0
+            && bind(fdPacket, (struct sockaddr *)&Addr, sizeof(Addr)) == 0)
+            tstRun(&Vhost, fdTap, fdPacket, iIfIndex);
+        else
+            RTTestFailed(g_hTest, "Creating the packet socket failed, errno=%d", errno);
+        if (fdPacket >= 0)
+            close(fdPacket);
+        close(fdTap);
+    }
+
+    VhostNetClose(&Vhost);
+    RTMemPageFree(g_pbMem, TST_PAGES * PAGE_SIZE);
+    return RTTestSummaryAndDestroy(g_hTest);
+}
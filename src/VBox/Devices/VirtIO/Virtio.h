@@ -287,6 +287,7 @@ DECLINLINE(void) vpciCsLeave(VPCISTATE *pState)
 }
 
 void vringSetNotification(PVPCISTATE pState, PVRING pVRing, bool fEnabled);
+uint16_t vringReadUsedIndex(PVPCISTATE pState, PVRING pVRing);
 
 DECLINLINE(uint16_t) vringReadAvailIndex(PVPCISTATE pState, PVRING pVRing)
 {
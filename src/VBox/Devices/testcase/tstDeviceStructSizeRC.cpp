@@ -1382,10 +1382,14 @@ int main()
     GEN_CHECK_OFF(E1KSTATE, pLUTimerR3);
     GEN_CHECK_OFF(E1KSTATE, pLUTimerR0);
     GEN_CHECK_OFF(E1KSTATE, pLUTimerRC);
+    GEN_CHECK_OFF(E1KSTATE, pRxCoalTimerR3);
+    GEN_CHECK_OFF(E1KSTATE, pbRxCoalFrameR3);
+    GEN_CHECK_OFF(E1KSTATE, pTxZcR3);
     GEN_CHECK_OFF(E1KSTATE, cs);
 # ifndef E1K_GLOBAL_MUTEX
     GEN_CHECK_OFF(E1KSTATE, csRx);
 # endif
+    GEN_CHECK_OFF(E1KSTATE, csRxCoal);
     GEN_CHECK_OFF(E1KSTATE, addrMMReg);
     GEN_CHECK_OFF(E1KSTATE, macConfigured);
     GEN_CHECK_OFF(E1KSTATE, IOPortBase);
@@ -1395,6 +1399,8 @@ int main()
     GEN_CHECK_OFF(E1KSTATE, fCableConnected);
     GEN_CHECK_OFF(E1KSTATE, fR0Enabled);
     GEN_CHECK_OFF(E1KSTATE, fRCEnabled);
+    GEN_CHECK_OFF(E1KSTATE, fRxCoalescing);
+    GEN_CHECK_OFF(E1KSTATE, fTxZeroCopy);
     GEN_CHECK_OFF(E1KSTATE, auRegs[E1K_NUM_OF_32BIT_REGS]);
     GEN_CHECK_OFF(E1KSTATE, led);
     GEN_CHECK_OFF(E1KSTATE, u32PktNo);
@@ -1429,6 +1435,12 @@ int main()
     GEN_CHECK_OFF(E1KSTATE, u16HdrRemain);
     GEN_CHECK_OFF(E1KSTATE, u16SavedFlags);
     GEN_CHECK_OFF(E1KSTATE, u32SavedCsum);
+    GEN_CHECK_OFF(E1KSTATE, RxCoalStatus);
+    GEN_CHECK_OFF(E1KSTATE, cbRxCoal);
+    GEN_CHECK_OFF(E1KSTATE, uRxCoalNextSeq);
+    GEN_CHECK_OFF(E1KSTATE, cUsRxCoalTimeout);
+    GEN_CHECK_OFF(E1KSTATE, cbRxCoalHdrs);
+    GEN_CHECK_OFF(E1KSTATE, cRxCoalSegs);
     GEN_CHECK_OFF(E1KSTATE, eeprom);
     GEN_CHECK_OFF(E1KSTATE, phy);
     GEN_CHECK_OFF(E1KSTATE, StatReceiveBytes);
@@ -1476,6 +1488,16 @@ int main()
     GEN_CHECK_OFF(VNETSTATE, pCtlQueue);
     GEN_CHECK_OFF(VNETSTATE, fMaybeOutOfSpace);
     GEN_CHECK_OFF(VNETSTATE, hEventMoreRxDescAvail);
+    GEN_CHECK_OFF(VNETSTATE, pDrvVhost);
+    GEN_CHECK_OFF(VNETSTATE, pVhostThread);
+    GEN_CHECK_OFF(VNETSTATE, paVhostPages);
+    GEN_CHECK_OFF(VNETSTATE, cVhostPages);
+    GEN_CHECK_OFF(VNETSTATE, cVhostRingPages);
+    GEN_CHECK_OFF(VNETSTATE, iVhostPageNext);
+    GEN_CHECK_OFF(VNETSTATE, idVhostRamGen);
+    GEN_CHECK_OFF(VNETSTATE, fVhostCapable);
+    GEN_CHECK_OFF(VNETSTATE, fVhostActive);
+    GEN_CHECK_OFF(VNETSTATE, fVhostFailed);
 #endif /* VBOX_WITH_VIRTIO */
 
 #ifdef VBOX_WITH_SCSI
@@ -36,11 +36,22 @@
 #include <iprt/critsect.h>
 #include <iprt/err.h>
 #include <iprt/mem.h>
+#include <iprt/mp.h>
 #include <iprt/param.h>
+#include <iprt/thread.h>
 
 #include "internal/magics.h"
 
 
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The number of objects a magazine can hold. */
+#define RTMEMCACHE_MAG_SIZE         16
+/** The max number of magazines per cache. */
+#define RTMEMCACHE_MAX_MAGS         64
+
+
 /*******************************************************************************
 *   Structures and Typedefs                                                    *
 *******************************************************************************/
@@ -99,6 +110,39 @@ typedef struct RTMEMCACHEPAGE
 AssertCompileMemberOffset(RTMEMCACHEPAGE, cFree, 64);
 
 
+/**
+ * A magazine of free objects.
+ *
+ * Threads are hashed onto a small array of these so that the common alloc and
+ * free operations only touch a cache line that is rarely shared with other
+ * threads.  A magazine is refilled from and drained to the pages in bulk.  It
+ * is owned by whichever thread manages to set fBusy; if that fails, the thread
+ * goes straight for the pages instead of waiting.
+ */
+typedef union RTMEMCACHEMAG
+{
+    struct
+    {
+        /** Set while a thread is working on the magazine. */
+        uint32_t volatile       fBusy;
+        /** The number of objects in apvObjs. */
+        uint32_t                cObjs;
+        /** The page the last refill got objects from.
+         * Pages are touched first by the thread growing the cache, so
+         * sticking to the same page keeps the memory local to the threads
+         * using the magazine as far as the OS's NUMA placement goes. */
+        PRTMEMCACHEPAGE         pPageHint;
+        /** The objects (allocated as far as the pages are concerned). */
+        void                   *apvObjs[RTMEMCACHE_MAG_SIZE];
+    } s;
+    /** Cache line padding. */
+    uint8_t                     abPadding[ARCH_BITS == 32 ? 128 : 192];
+} RTMEMCACHEMAG;
+AssertCompile(sizeof(((RTMEMCACHEMAG *)0)->s) <= sizeof(((RTMEMCACHEMAG *)0)->abPadding));
+/** Pointer to a magazine. */
+typedef RTMEMCACHEMAG *PRTMEMCACHEMAG;
+
+
 /**
  * Memory object cache instance.
  */
@@ -146,9 +190,21 @@ typedef struct RTMEMCACHEINT
      *       cache.  Also, it totally doesn't work when the objects are too
      *       small. */
     PRTMEMCACHEFREEOBJ volatile pFreeTop;
+
+    /** The number of magazines (power of two), 0 if not using magazines. */
+    uint32_t                    cMags;
+    /** The magazines (page aligned allocation). */
+    PRTMEMCACHEMAG              paMags;
 } RTMEMCACHEINT;
 
 
+/*******************************************************************************
+*   Internal Functions                                                         *
+*******************************************************************************/
+static int  rtMemCacheAllocReserved(RTMEMCACHEINT *pThis, void **ppvObj, PRTMEMCACHEPAGE *ppPageHint);
+static void rtMemCacheFreeToPages(RTMEMCACHEINT *pThis, void *pvObj);
+
+
 
 RTDECL(int) RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbAlignment, uint32_t cMaxObjects,
                              PFNMEMCACHECTOR pfnCtor, PFNMEMCACHEDTOR pfnDtor, void *pvUser, uint32_t fFlags)
@@ -160,7 +216,7 @@ RTDECL(int) RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbA
     AssertReturn(!pfnDtor || pfnCtor, VERR_INVALID_PARAMETER);
     AssertReturn(cbObject > 0, VERR_INVALID_PARAMETER);
     AssertReturn(cbObject <= PAGE_SIZE / 8, VERR_INVALID_PARAMETER);
-    AssertReturn(!fFlags, VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFlags & ~RTMEMCACHE_FLAGS_VALID_MASK), VERR_INVALID_PARAMETER);
 
     if (cbAlignment == 0)
     {
@@ -235,6 +291,24 @@ RTDECL(int) RTMemCacheCreate(PRTMEMCACHE phMemCache, size_t cbObject, size_t cbA
      * now. */
     pThis->fUseFreeList = false;
 
+    /*
+     * Magazines, two per CPU so that threads sharing a slot are rare.  No
+     * point in them if the whole cache fits in a couple of magazines.
+     */
+    pThis->cMags            = 0;
+    pThis->paMags           = NULL;
+    if (   !(fFlags & RTMEMCACHE_FLAGS_NO_MAGAZINES)
+        && cMaxObjects >= RTMEMCACHE_MAG_SIZE * 4)
+    {
+        uint32_t cMags = 1;
+        uint32_t const cCpus = RTMpGetCount();
+        while (cMags < cCpus * 2 && cMags < RTMEMCACHE_MAX_MAGS)
+            cMags *= 2;
+        pThis->paMags = (PRTMEMCACHEMAG)RTMemPageAllocZ(RT_ALIGN_Z(cMags * sizeof(RTMEMCACHEMAG), PAGE_SIZE));
+        if (pThis->paMags)
+            pThis->cMags = cMags;
+    }
+
     *phMemCache = pThis;
     return VINF_SUCCESS;
 }
@@ -261,6 +335,15 @@ RTDECL(int) RTMemCacheDestroy(RTMEMCACHE hMemCache)
     AssertReturn(ASMAtomicCmpXchgU32(&pThis->u32Magic, RTMEMCACHE_MAGIC_DEAD, RTMEMCACHE_MAGIC), VERR_INVALID_HANDLE);
     RTCritSectDelete(&pThis->CritSect);
 
+    /* The objects in the magazines are still marked allocated, which doesn't
+       matter as we're freeing whole pages. */
+    if (pThis->paMags)
+    {
+        RTMemPageFree(pThis->paMags, RT_ALIGN_Z(pThis->cMags * sizeof(RTMEMCACHEMAG), PAGE_SIZE));
+        pThis->paMags = NULL;
+        pThis->cMags  = 0;
+    }
+
     while (pThis->pPageHead)
     {
         PRTMEMCACHEPAGE pPage = pThis->pPageHead;
@@ -369,12 +452,18 @@ DECL_FORCE_INLINE(int32_t) rtMemCacheGrabObj(PRTMEMCACHEPAGE pPage)
 }
 
 
-RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
+/**
+ * Allocates an object from the pages (or the free list), bypassing the
+ * magazines.
+ *
+ * @returns IPRT status code.
+ * @param   pThis               The memory cache instance.
+ * @param   ppvObj              Where to return the object.
+ * @param   ppPageHint          Where to get and put a page hint for the caller,
+ *                              NULL if none.
+ */
+static int rtMemCacheAllocFromPages(RTMEMCACHEINT *pThis, void **ppvObj, PRTMEMCACHEPAGE *ppPageHint)
 {
-    RTMEMCACHEINT *pThis = hMemCache;
-    AssertPtrReturn(pThis, VERR_INVALID_PARAMETER);
-    AssertReturn(pThis->u32Magic == RTMEMCACHE_MAGIC, VERR_INVALID_PARAMETER);
-
     /*
      * Try grab a free object from the stack.
      */
@@ -420,12 +509,33 @@ RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
         }
     }
 
+    return rtMemCacheAllocReserved(pThis, ppvObj, ppPageHint);
+}
+
+
+/**
+ * Allocates an object at the page level after the caller has reserved it at
+ * the cache level (RTMEMCACHEINT::cFree).
+ *
+ * @returns IPRT status code.  On failure the reservation has been returned.
+ * @param   pThis               The memory cache instance.
+ * @param   ppvObj              Where to return the object.
+ * @param   ppPageHint          Where to get and put a page hint for the caller,
+ *                              NULL if none.
+ */
+static int rtMemCacheAllocReserved(RTMEMCACHEINT *pThis, void **ppvObj, PRTMEMCACHEPAGE *ppPageHint)
+{
     /*
      * Grab a free object at the page level.
      */
-    PRTMEMCACHEPAGE pPage = ASMAtomicReadPtrT(&pThis->pPageHint, PRTMEMCACHEPAGE);
+    PRTMEMCACHEPAGE pPage = ppPageHint ? *ppPageHint : NULL;
     int32_t iObj = pPage ? rtMemCacheGrabObj(pPage) : -1;
     if (iObj < 0)
+    {
+        pPage = ASMAtomicReadPtrT(&pThis->pPageHint, PRTMEMCACHEPAGE);
+        iObj = pPage ? rtMemCacheGrabObj(pPage) : -1;
+    }
+    if (iObj < 0)
     {
         for (unsigned cLoops = 0; ; cLoops++)
         {
@@ -445,6 +555,8 @@ RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
             Assert(cLoops < 10);
         }
     }
+    if (ppPageHint)
+        *ppPageHint = pPage;
     Assert(iObj >= 0);
     Assert((uint32_t)iObj < pThis->cMax);
 
@@ -477,11 +589,11 @@ RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
     if (   pThis->pfnCtor
         && !ASMAtomicBitTestAndSet(pPage->pbmCtor, iObj))
     {
-        int rc = pThis->pfnCtor(hMemCache, pvObj, pThis->pvUser);
+        int rc = pThis->pfnCtor(pThis, pvObj, pThis->pvUser);
         if (RT_FAILURE(rc))
         {
             ASMAtomicBitClear(pPage->pbmCtor, iObj);
-            RTMemCacheFree(pThis, pvObj);
+            rtMemCacheFreeToPages(pThis, pvObj);
             return rc;
         }
     }
@@ -491,6 +603,219 @@ RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
 }
 
 
+/**
+ * Allocates a bunch of objects for refilling a magazine.
+ *
+ * All the objects are reserved at the cache level in one go, which keeps
+ * RTMEMCACHEINT::cFree from becoming the hot spot when many threads are
+ * busy.  This will not grow the cache, so the caller must use
+ * rtMemCacheAllocFromPages when nothing is returned.
+ *
+ * @returns Number of objects allocated.
+ * @param   pThis               The memory cache instance.
+ * @param   papvObjs            Where to return the objects.
+ * @param   cObjs               The max number of objects to allocate.
+ * @param   ppPageHint          Where to get and put a page hint for the caller.
+ * @param   prc                 Where to return the constructor status if it
+ *                              failed.  Not touched on success.
+ */
+static uint32_t rtMemCacheAllocBulkFromPages(RTMEMCACHEINT *pThis, void **papvObjs, uint32_t cObjs,
+                                             PRTMEMCACHEPAGE *ppPageHint, int *prc)
+{
+    if (pThis->fUseFreeList)
+        return 0;
+
+    /*
+     * Reserve what we can get without growing.
+     */
+    uint32_t cReserved;
+    int32_t  cFree = ASMAtomicUoReadS32(&pThis->cFree);
+    for (;;)
+    {
+        if (cFree <= 0)
+            return 0;
+        cReserved = RT_MIN((uint32_t)cFree, cObjs);
+        if (ASMAtomicCmpXchgExS32(&pThis->cFree, cFree - (int32_t)cReserved, cFree, &cFree))
+            break;
+        ASMNopPause();
+    }
+
+    /*
+     * Get the objects from the pages.
+     */
+    for (uint32_t i = 0; i < cReserved; i++)
+    {
+        int rc = rtMemCacheAllocReserved(pThis, &papvObjs[i], ppPageHint);
+        if (RT_FAILURE(rc))
+        {
+            if (cReserved - i - 1 > 0)
+                ASMAtomicAddS32(&pThis->cFree, (int32_t)(cReserved - i - 1));
+            *prc = rc;
+            return i;
+        }
+    }
+    return cReserved;
+}
+
+
+/**
+ * Frees a bunch of objects to the pages, updating the counters in bulk.
+ *
+ * @param   pThis               The memory cache instance.
+ * @param   papvObjs            The objects.
+ * @param   cObjs               The number of objects.
+ */
+static void rtMemCacheFreeBulkToPages(RTMEMCACHEINT *pThis, void * const *papvObjs, uint32_t cObjs)
+{
+    if (pThis->fUseFreeList)
+    {
+        for (uint32_t i = 0; i < cObjs; i++)
+            rtMemCacheFreeToPages(pThis, papvObjs[i]);
+        return;
+    }
+
+    /*
+     * Clear the bitmap bits and add up the page counts, updating a page
+     * count when moving on to an object in another page.  As in
+     * rtMemCacheFreeToPages, the page counts must be updated before the
+     * cache count.
+     */
+    PRTMEMCACHEPAGE pPageCur = NULL;
+    int32_t         cPageCur = 0;
+    int32_t         cFreed   = 0;
+    for (uint32_t i = 0; i < cObjs; i++)
+    {
+        void           *pvObj  = papvObjs[i];
+        PRTMEMCACHEPAGE pPage  = (PRTMEMCACHEPAGE)(((uintptr_t)pvObj) & ~(uintptr_t)PAGE_OFFSET_MASK);
+        Assert(pPage->pCache == pThis);
+        uintptr_t       offObj = (uintptr_t)pvObj - (uintptr_t)pPage->pbObjects;
+        uintptr_t       iObj   = offObj / pThis->cbObject;
+        Assert(iObj * pThis->cbObject == offObj);
+        Assert(iObj < pThis->cPerPage);
+        if (RT_UNLIKELY(!ASMAtomicBitTestAndClear(pPage->pbmAlloc, iObj)))
+        {
+            AssertFailed();
+            continue;
+        }
+
+        if (pPage != pPageCur)
+        {
+            if (cPageCur)
+                ASMAtomicAddS32(&pPageCur->cFree, cPageCur);
+            pPageCur = pPage;
+            cPageCur = 0;
+        }
+        cPageCur++;
+        cFreed++;
+    }
+    if (cPageCur)
+        ASMAtomicAddS32(&pPageCur->cFree, cPageCur);
+    if (cFreed)
+        ASMAtomicAddS32(&pThis->cFree, cFreed);
+}
+
+
+/**
+ * Gets the magazine for the calling thread and tries to take ownership of it.
+ *
+ * @returns Pointer to the magazine on success, NULL if the cache has no
+ *          magazines or another thread is using it.
+ * @param   pThis               The memory cache instance.
+ */
+DECL_FORCE_INLINE(PRTMEMCACHEMAG) rtMemCacheMagEnter(RTMEMCACHEINT *pThis)
+{
+    uint32_t const cMags = pThis->cMags;
+    if (!cMags)
+        return NULL;
+    uint64_t const uHash = (uint64_t)(uintptr_t)RTThreadNativeSelf() * UINT64_C(0x9e3779b97f4a7c15);
+    PRTMEMCACHEMAG pMag  = &pThis->paMags[(uint32_t)(uHash >> 32) & (cMags - 1)];
+    if (ASMAtomicCmpXchgU32(&pMag->s.fBusy, 1, 0))
+        return pMag;
+    return NULL;
+}
+
+
+/**
+ * Releases a magazine taken by rtMemCacheMagEnter.
+ *
+ * @param   pMag                The magazine.
+ */
+DECL_FORCE_INLINE(void) rtMemCacheMagLeave(PRTMEMCACHEMAG pMag)
+{
+    ASMAtomicWriteU32(&pMag->s.fBusy, 0);
+}
+
+
+/**
+ * Returns the objects in all the magazines not currently in use to the pages.
+ *
+ * This is used when the cache hits its max size so that objects sitting in
+ * magazines of other threads don't cause spurious allocation failures.
+ *
+ * @returns Number of objects returned to the pages.
+ * @param   pThis               The memory cache instance.
+ */
+static uint32_t rtMemCacheMagDrainAll(RTMEMCACHEINT *pThis)
+{
+    uint32_t cDrained = 0;
+    for (uint32_t i = 0; i < pThis->cMags; i++)
+    {
+        PRTMEMCACHEMAG pMag = &pThis->paMags[i];
+        if (ASMAtomicCmpXchgU32(&pMag->s.fBusy, 1, 0))
+        {
+            cDrained += pMag->s.cObjs;
+            rtMemCacheFreeBulkToPages(pThis, &pMag->s.apvObjs[0], pMag->s.cObjs);
+            pMag->s.cObjs = 0;
+            rtMemCacheMagLeave(pMag);
+        }
+    }
+    return cDrained;
+}
+
+
+RTDECL(int) RTMemCacheAllocEx(RTMEMCACHE hMemCache, void **ppvObj)
+{
+    RTMEMCACHEINT *pThis = hMemCache;
+    AssertPtrReturn(pThis, VERR_INVALID_PARAMETER);
+    AssertReturn(pThis->u32Magic == RTMEMCACHE_MAGIC, VERR_INVALID_PARAMETER);
+
+    PRTMEMCACHEMAG pMag = rtMemCacheMagEnter(pThis);
+    if (!pMag)
+        return rtMemCacheAllocFromPages(pThis, ppvObj, NULL);
+
+    /*
+     * Refill an empty magazine with half its capacity in one go, so a thread
+     * doing alloc/free pairs doesn't bounce between the magazine and the
+     * pages.  We only fail if we don't get a single object.
+     */
+    if (!pMag->s.cObjs)
+    {
+        int rc = VINF_SUCCESS;
+        pMag->s.cObjs = rtMemCacheAllocBulkFromPages(pThis, &pMag->s.apvObjs[0], RTMEMCACHE_MAG_SIZE / 2,
+                                                     &pMag->s.pPageHint, &rc);
+        if (!pMag->s.cObjs && RT_SUCCESS(rc))
+        {
+            /* Nothing free, grow the cache (or fail trying). */
+            rc = rtMemCacheAllocFromPages(pThis, &pMag->s.apvObjs[0], &pMag->s.pPageHint);
+            if (RT_SUCCESS(rc))
+                pMag->s.cObjs = 1;
+        }
+        if (!pMag->s.cObjs)
+        {
+            rtMemCacheMagLeave(pMag);
+            if (   rc == VERR_MEM_CACHE_MAX_SIZE
+                && rtMemCacheMagDrainAll(pThis) > 0)
+                return rtMemCacheAllocFromPages(pThis, ppvObj, NULL);
+            return rc;
+        }
+    }
+
+    *ppvObj = pMag->s.apvObjs[--pMag->s.cObjs];
+    rtMemCacheMagLeave(pMag);
+    return VINF_SUCCESS;
+}
+
+
 RTDECL(void *) RTMemCacheAlloc(RTMEMCACHE hMemCache)
 {
     void *pvObj;
@@ -501,18 +826,14 @@ RTDECL(void *) RTMemCacheAlloc(RTMEMCACHE hMemCache)
 }
 
 
-RTDECL(void) RTMemCacheFree(RTMEMCACHE hMemCache, void *pvObj)
+/**
+ * Frees an object to the pages (or the free list), bypassing the magazines.
+ *
+ * @param   pThis               The memory cache instance.
+ * @param   pvObj               The object.
+ */
+static void rtMemCacheFreeToPages(RTMEMCACHEINT *pThis, void *pvObj)
 {
-    if (!pvObj)
-        return;
-
-    RTMEMCACHEINT *pThis = hMemCache;
-    AssertPtrReturnVoid(pThis);
-    AssertReturnVoid(pThis->u32Magic == RTMEMCACHE_MAGIC);
-
-    AssertPtr(pvObj);
-    Assert(RT_ALIGN_P(pvObj, pThis->cbAlignment) == pvObj);
-
     if (pThis->fUseFreeList)
     {
 # ifdef RT_STRICT
@@ -567,3 +888,44 @@ RTDECL(void) RTMemCacheFree(RTMEMCACHE hMemCache, void *pvObj)
     }
 }
 
+
+
+RTDECL(void) RTMemCacheFree(RTMEMCACHE hMemCache, void *pvObj)
+{
+    if (!pvObj)
+        return;
+
+    RTMEMCACHEINT *pThis = hMemCache;
+    AssertPtrReturnVoid(pThis);
+    AssertReturnVoid(pThis->u32Magic == RTMEMCACHE_MAGIC);
+
+    AssertPtr(pvObj);
+    Assert(RT_ALIGN_P(pvObj, pThis->cbAlignment) == pvObj);
+#ifdef RT_STRICT
+    PRTMEMCACHEPAGE pPage = (PRTMEMCACHEPAGE)(((uintptr_t)pvObj) & ~(uintptr_t)PAGE_OFFSET_MASK);
+    Assert(pPage->pCache == pThis);
+    uintptr_t offObj = (uintptr_t)pvObj - (uintptr_t)pPage->pbObjects;
+    Assert((offObj / pThis->cbObject) * pThis->cbObject == offObj);
+    AssertReturnVoid(ASMBitTest(pPage->pbmAlloc, (int32_t)(offObj / pThis->cbObject)));
+#endif
+
+    PRTMEMCACHEMAG pMag = rtMemCacheMagEnter(pThis);
+    if (!pMag)
+    {
+        rtMemCacheFreeToPages(pThis, pvObj);
+        return;
+    }
+
+    /*
+     * Drain half of a full magazine so the next few allocations and frees
+     * can both be served without going to the pages.
+     */
+    if (pMag->s.cObjs >= RTMEMCACHE_MAG_SIZE)
+    {
+        pMag->s.cObjs = RTMEMCACHE_MAG_SIZE / 2;
+        rtMemCacheFreeBulkToPages(pThis, &pMag->s.apvObjs[RTMEMCACHE_MAG_SIZE / 2], RTMEMCACHE_MAG_SIZE / 2);
+    }
+
+    pMag->s.apvObjs[pMag->s.cObjs++] = pvObj;
+    rtMemCacheMagLeave(pMag);
+}
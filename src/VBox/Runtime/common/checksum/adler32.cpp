@@ -39,6 +39,10 @@
 *   Defined Constants And Macros                                               *
 *******************************************************************************/
 #define RTCRC_ADLER_32_NUMBER       65521
+/** The max number of bytes we can process before b overflows, i.e. the
+ * largest n such that 255*n*(n+1)/2 + (n+1)*(RTCRC_ADLER_32_NUMBER-1) fits
+ * in 32 bits. */
+#define RTCRC_ADLER_32_NMAX         5552
 
 
 RTDECL(uint32_t) RTCrcAdler32(void const *pv, size_t cb)
@@ -59,105 +63,46 @@ RTDECL(uint32_t) RTCrcAdler32Process(uint32_t u32Crc, void const *pv, size_t cb)
     uint8_t const  *pbSrc = (uint8_t const *)pv;
     uint32_t        a     = u32Crc & 0xffff;
     uint32_t        b     = u32Crc >> 16;
-    if (cb < 64 /* randomly selected number */)
-    {
-        while (cb-- > 0)
-        {
-            a += *pbSrc++;
-            a %= RTCRC_ADLER_32_NUMBER;
-            b += a;
-            b %= RTCRC_ADLER_32_NUMBER;
-        }
-    }
-    else
+
+    /*
+     * Defer the modulo operations as long as b cannot overflow, i.e. for up
+     * to RTCRC_ADLER_32_NMAX bytes, and do the inner loop 16 bytes at a time.
+     */
+    while (cb > 0)
     {
-        switch (((uintptr_t)pbSrc & 0x3))
+        size_t cbChunk = RT_MIN(cb, RTCRC_ADLER_32_NMAX);
+        cb -= cbChunk;
+
+        while (cbChunk >= 16)
         {
-            case 0:
-                break;
-
-            case 1:
-                a += *pbSrc++;
-                a %= RTCRC_ADLER_32_NUMBER;
-                b += a;
-                b %= RTCRC_ADLER_32_NUMBER;
-                cb--;
-                /* fall thru */
-
-            case 2:
-                a += *pbSrc++;
-                a %= RTCRC_ADLER_32_NUMBER;
-                b += a;
-                b %= RTCRC_ADLER_32_NUMBER;
-                cb--;
-                /* fall thru */
-
-            case 3:
-                a += *pbSrc++;
-                a %= RTCRC_ADLER_32_NUMBER;
-                b += a;
-                b %= RTCRC_ADLER_32_NUMBER;
-                cb--;
-                break;
+            a += pbSrc[ 0]; b += a;
+            a += pbSrc[ 1]; b += a;
+            a += pbSrc[ 2]; b += a;
+            a += pbSrc[ 3]; b += a;
+            a += pbSrc[ 4]; b += a;
+            a += pbSrc[ 5]; b += a;
+            a += pbSrc[ 6]; b += a;
+            a += pbSrc[ 7]; b += a;
+            a += pbSrc[ 8]; b += a;
+            a += pbSrc[ 9]; b += a;
+            a += pbSrc[10]; b += a;
+            a += pbSrc[11]; b += a;
+            a += pbSrc[12]; b += a;
+            a += pbSrc[13]; b += a;
+            a += pbSrc[14]; b += a;
+            a += pbSrc[15]; b += a;
+            pbSrc   += 16;
+            cbChunk -= 16;
         }
 
-        while (cb >= 4)
+        while (cbChunk-- > 0)
         {
-            uint32_t u32 = *(uint32_t const *)pbSrc;
-            pbSrc += 4;
-
-            a += u32 & 0xff;
-            a %= RTCRC_ADLER_32_NUMBER;
-            b += a;
-            b %= RTCRC_ADLER_32_NUMBER;
-
-            a += (u32 >> 8) & 0xff;
-            a %= RTCRC_ADLER_32_NUMBER;
-            b += a;
-            b %= RTCRC_ADLER_32_NUMBER;
-
-            a += (u32 >> 16) & 0xff;
-            a %= RTCRC_ADLER_32_NUMBER;
-            b += a;
-            b %= RTCRC_ADLER_32_NUMBER;
-
-            a += (u32 >> 24) & 0xff;
-            a %= RTCRC_ADLER_32_NUMBER;
+            a += *pbSrc++;
             b += a;
-            b %= RTCRC_ADLER_32_NUMBER;
-
-            cb -= 4;
         }
 
-        switch (cb)
-        {
-            case 0:
-                break;
-
-            case 3:
-                a += *pbSrc++;
-                a %= RTCRC_ADLER_32_NUMBER;
-                b += a;
-                b %= RTCRC_ADLER_32_NUMBER;
-                cb--;
-                /* fall thru */
-
-            case 2:
-                a += *pbSrc++;
-                a %= RTCRC_ADLER_32_NUMBER;
-                b += a;
-                b %= RTCRC_ADLER_32_NUMBER;
-                cb--;
-                /* fall thru */
-
-            case 1:
-                a += *pbSrc++;
-                a %= RTCRC_ADLER_32_NUMBER;
-                b += a;
-                b %= RTCRC_ADLER_32_NUMBER;
-                cb--;
-                break;
-        }
+        a %= RTCRC_ADLER_32_NUMBER;
+        b %= RTCRC_ADLER_32_NUMBER;
     }
 
     return a | (b << 16);
@@ -0,0 +1,269 @@
+/* $Id: alt-sha-avx2.cpp $ */
+/** @file
+ * IPRT - SHA-1 and SHA-256, AVX2 multi-buffer kernels.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "internal/iprt.h"
+#include <iprt/types.h>
+#include <iprt/asm.h>
+#include "internal/sha.h"
+
+#include <immintrin.h>  /* AVX2 */
+
+
+/*
+ * Each 256-bit register holds the same 32-bit variable of eight independent
+ * streams, so the round functions are the plain C ones applied to all lanes.
+ */
+
+/** Rotate all lanes left. */
+#define RTSHA_AVX2_ROL(a_u, a_cShift) \
+    _mm256_or_si256(_mm256_slli_epi32((a_u), (a_cShift)), _mm256_srli_epi32((a_u), 32 - (a_cShift)))
+/** Rotate all lanes right. */
+#define RTSHA_AVX2_ROR(a_u, a_cShift) \
+    _mm256_or_si256(_mm256_srli_epi32((a_u), (a_cShift)), _mm256_slli_epi32((a_u), 32 - (a_cShift)))
+/** Bitwise ops. */
+#define RTSHA_AVX2_ADD(a_u1, a_u2)      _mm256_add_epi32((a_u1), (a_u2))
+#define RTSHA_AVX2_XOR(a_u1, a_u2)      _mm256_xor_si256((a_u1), (a_u2))
+#define RTSHA_AVX2_AND(a_u1, a_u2)      _mm256_and_si256((a_u1), (a_u2))
+/** Broadcasts a constant to all lanes. */
+#define RTSHA_AVX2_CONST(a_u32)         _mm256_set1_epi32((int)(a_u32))
+
+
+/**
+ * Loads message word @a iWord of all eight streams, converting it from big
+ * endian.
+ */
+DECL_FORCE_INLINE(__m256i) rtShaAvx2LoadWord(uint8_t const * const *papbData, unsigned iWord)
+{
+    return _mm256_set_epi32((int)ASMByteSwapU32(((uint32_t const *)papbData[7])[iWord]),
+                            (int)ASMByteSwapU32(((uint32_t const *)papbData[6])[iWord]),
+                            (int)ASMByteSwapU32(((uint32_t const *)papbData[5])[iWord]),
+                            (int)ASMByteSwapU32(((uint32_t const *)papbData[4])[iWord]),
+                            (int)ASMByteSwapU32(((uint32_t const *)papbData[3])[iWord]),
+                            (int)ASMByteSwapU32(((uint32_t const *)papbData[2])[iWord]),
+                            (int)ASMByteSwapU32(((uint32_t const *)papbData[1])[iWord]),
+                            (int)ASMByteSwapU32(((uint32_t const *)papbData[0])[iWord]));
+}
+
+
+/**
+ * Gathers hash word @a iWord of all eight streams.
+ */
+DECL_FORCE_INLINE(__m256i) rtShaAvx2LoadState(uint32_t * const *papauH, unsigned iWord)
+{
+    return _mm256_set_epi32((int)papauH[7][iWord], (int)papauH[6][iWord], (int)papauH[5][iWord], (int)papauH[4][iWord],
+                            (int)papauH[3][iWord], (int)papauH[2][iWord], (int)papauH[1][iWord], (int)papauH[0][iWord]);
+}
+
+
+/**
+ * Scatters hash word @a iWord of all eight streams.
+ */
+DECL_FORCE_INLINE(void) rtShaAvx2StoreState(uint32_t * const *papauH, unsigned iWord, __m256i uValue)
+{
+    uint32_t au32[RTSHA_AVX2_LANES];
+    _mm256_storeu_si256((__m256i *)&au32[0], uValue);
+    for (unsigned iLane = 0; iLane < RTSHA_AVX2_LANES; iLane++)
+        papauH[iLane][iWord] = au32[iLane];
+}
+
+
+DECLHIDDEN(void) rtSha1Avx2ProcessMulti(uint32_t * const *papauH, uint8_t const * const *papbData, size_t cBlocks)
+{
+    uint8_t const *apbData[RTSHA_AVX2_LANES];
+    for (unsigned iLane = 0; iLane < RTSHA_AVX2_LANES; iLane++)
+        apbData[iLane] = papbData[iLane];
+
+    __m256i uA = rtShaAvx2LoadState(papauH, 0);
+    __m256i uB = rtShaAvx2LoadState(papauH, 1);
+    __m256i uC = rtShaAvx2LoadState(papauH, 2);
+    __m256i uD = rtShaAvx2LoadState(papauH, 3);
+    __m256i uE = rtShaAvx2LoadState(papauH, 4);
+
+    while (cBlocks-- > 0)
+    {
+        __m256i const uASave = uA, uBSave = uB, uCSave = uC, uDSave = uD, uESave = uE;
+        __m256i       auW[16];
+
+        for (unsigned iWord = 0; iWord < 80; iWord++)
+        {
+            __m256i uW;
+            if (iWord < 16)
+                uW = rtShaAvx2LoadWord(apbData, iWord);
+            else
+            {
+                uW = RTSHA_AVX2_XOR(RTSHA_AVX2_XOR(auW[(iWord - 3) & 15], auW[(iWord - 8) & 15]),
+                                    RTSHA_AVX2_XOR(auW[(iWord - 14) & 15], auW[iWord & 15]));
+                uW = RTSHA_AVX2_ROL(uW, 1);
+            }
+            auW[iWord & 15] = uW;
+
+            __m256i uF;
+            uint32_t uK;
+            if (iWord < 20)
+            {
+                uF = RTSHA_AVX2_XOR(RTSHA_AVX2_AND(RTSHA_AVX2_XOR(uC, uD), uB), uD);
+                uK = UINT32_C(0x5a827999);
+            }
+            else if (iWord < 40)
+            {
+                uF = RTSHA_AVX2_XOR(RTSHA_AVX2_XOR(uB, uC), uD);
+                uK = UINT32_C(0x6ed9eba1);
+            }
+            else if (iWord < 60)
+            {
+                uF = RTSHA_AVX2_XOR(RTSHA_AVX2_AND(RTSHA_AVX2_XOR(uC, uD), uB), RTSHA_AVX2_AND(uC, uD));
+                uK = UINT32_C(0x8f1bbcdc);
+            }
+            else
+            {
+                uF = RTSHA_AVX2_XOR(RTSHA_AVX2_XOR(uB, uC), uD);
+                uK = UINT32_C(0xca62c1d6);
+            }
+
+            __m256i uTemp = RTSHA_AVX2_ADD(RTSHA_AVX2_ROL(uA, 5), uF);
+            uTemp = RTSHA_AVX2_ADD(uTemp, RTSHA_AVX2_ADD(uE, uW));
+            uTemp = RTSHA_AVX2_ADD(uTemp, RTSHA_AVX2_CONST(uK));
+            uE = uD;
+            uD = uC;
+            uC = RTSHA_AVX2_ROL(uB, 30);
+            uB = uA;
+            uA = uTemp;
+        }
+
+        uA = RTSHA_AVX2_ADD(uA, uASave);
+        uB = RTSHA_AVX2_ADD(uB, uBSave);
+        uC = RTSHA_AVX2_ADD(uC, uCSave);
+        uD = RTSHA_AVX2_ADD(uD, uDSave);
+        uE = RTSHA_AVX2_ADD(uE, uESave);
+
+        for (unsigned iLane = 0; iLane < RTSHA_AVX2_LANES; iLane++)
+            apbData[iLane] += 64;
+    }
+
+    rtShaAvx2StoreState(papauH, 0, uA);
+    rtShaAvx2StoreState(papauH, 1, uB);
+    rtShaAvx2StoreState(papauH, 2, uC);
+    rtShaAvx2StoreState(papauH, 3, uD);
+    rtShaAvx2StoreState(papauH, 4, uE);
+}
+
+
+/** The SHA-256 round constants. */
+static uint32_t const g_auSha256Ks[64] =
+{
+    UINT32_C(0x428a2f98), UINT32_C(0x71374491), UINT32_C(0xb5c0fbcf), UINT32_C(0xe9b5dba5),
+    UINT32_C(0x3956c25b), UINT32_C(0x59f111f1), UINT32_C(0x923f82a4), UINT32_C(0xab1c5ed5),
+    UINT32_C(0xd807aa98), UINT32_C(0x12835b01), UINT32_C(0x243185be), UINT32_C(0x550c7dc3),
+    UINT32_C(0x72be5d74), UINT32_C(0x80deb1fe), UINT32_C(0x9bdc06a7), UINT32_C(0xc19bf174),
+    UINT32_C(0xe49b69c1), UINT32_C(0xefbe4786), UINT32_C(0x0fc19dc6), UINT32_C(0x240ca1cc),
+    UINT32_C(0x2de92c6f), UINT32_C(0x4a7484aa), UINT32_C(0x5cb0a9dc), UINT32_C(0x76f988da),
+    UINT32_C(0x983e5152), UINT32_C(0xa831c66d), UINT32_C(0xb00327c8), UINT32_C(0xbf597fc7),
+    UINT32_C(0xc6e00bf3), UINT32_C(0xd5a79147), UINT32_C(0x06ca6351), UINT32_C(0x14292967),
+    UINT32_C(0x27b70a85), UINT32_C(0x2e1b2138), UINT32_C(0x4d2c6dfc), UINT32_C(0x53380d13),
+    UINT32_C(0x650a7354), UINT32_C(0x766a0abb), UINT32_C(0x81c2c92e), UINT32_C(0x92722c85),
+    UINT32_C(0xa2bfe8a1), UINT32_C(0xa81a664b), UINT32_C(0xc24b8b70), UINT32_C(0xc76c51a3),
+    UINT32_C(0xd192e819), UINT32_C(0xd6990624), UINT32_C(0xf40e3585), UINT32_C(0x106aa070),
+    UINT32_C(0x19a4c116), UINT32_C(0x1e376c08), UINT32_C(0x2748774c), UINT32_C(0x34b0bcb5),
+    UINT32_C(0x391c0cb3), UINT32_C(0x4ed8aa4a), UINT32_C(0x5b9cca4f), UINT32_C(0x682e6ff3),
+    UINT32_C(0x748f82ee), UINT32_C(0x78a5636f), UINT32_C(0x84c87814), UINT32_C(0x8cc70208),
+    UINT32_C(0x90befffa), UINT32_C(0xa4506ceb), UINT32_C(0xbef9a3f7), UINT32_C(0xc67178f2),
+};
+
+
+DECLHIDDEN(void) rtSha256Avx2ProcessMulti(uint32_t * const *papauH, uint8_t const * const *papbData, size_t cBlocks)
+{
+    uint8_t const *apbData[RTSHA_AVX2_LANES];
+    for (unsigned iLane = 0; iLane < RTSHA_AVX2_LANES; iLane++)
+        apbData[iLane] = papbData[iLane];
+
+    __m256i auState[8];
+    for (unsigned i = 0; i < 8; i++)
+        auState[i] = rtShaAvx2LoadState(papauH, i);
+
+    while (cBlocks-- > 0)
+    {
+        __m256i uA = auState[0], uB = auState[1], uC = auState[2], uD = auState[3];
+        __m256i uE = auState[4], uF = auState[5], uG = auState[6], uH = auState[7];
+        __m256i auW[16];
+
+        for (unsigned iWord = 0; iWord < 64; iWord++)
+        {
+            __m256i uW;
+            if (iWord < 16)
+                uW = rtShaAvx2LoadWord(apbData, iWord);
+            else
+            {
+                __m256i const uW15 = auW[(iWord - 15) & 15];
+                __m256i const uW2  = auW[(iWord -  2) & 15];
+                __m256i const uS0  = RTSHA_AVX2_XOR(RTSHA_AVX2_XOR(RTSHA_AVX2_ROR(uW15, 7), RTSHA_AVX2_ROR(uW15, 18)),
+                                                    _mm256_srli_epi32(uW15, 3));
+                __m256i const uS1  = RTSHA_AVX2_XOR(RTSHA_AVX2_XOR(RTSHA_AVX2_ROR(uW2, 17), RTSHA_AVX2_ROR(uW2, 19)),
+                                                    _mm256_srli_epi32(uW2, 10));
+                uW = RTSHA_AVX2_ADD(RTSHA_AVX2_ADD(auW[iWord & 15], uS0), RTSHA_AVX2_ADD(auW[(iWord - 7) & 15], uS1));
+            }
+            auW[iWord & 15] = uW;
+
+            /* T1 = H + Sigma1(E) + Ch(E,F,G) + K + W */
+            __m256i uT1 = RTSHA_AVX2_XOR(RTSHA_AVX2_XOR(RTSHA_AVX2_ROR(uE, 6), RTSHA_AVX2_ROR(uE, 11)), RTSHA_AVX2_ROR(uE, 25));
+            uT1 = RTSHA_AVX2_ADD(uT1, RTSHA_AVX2_XOR(RTSHA_AVX2_AND(RTSHA_AVX2_XOR(uF, uG), uE), uG));
+            uT1 = RTSHA_AVX2_ADD(uT1, RTSHA_AVX2_ADD(uH, uW));
+            uT1 = RTSHA_AVX2_ADD(uT1, RTSHA_AVX2_CONST(g_auSha256Ks[iWord]));
+
+            /* T2 = Sigma0(A) + Maj(A,B,C) */
+            __m256i uT2 = RTSHA_AVX2_XOR(RTSHA_AVX2_XOR(RTSHA_AVX2_ROR(uA, 2), RTSHA_AVX2_ROR(uA, 13)), RTSHA_AVX2_ROR(uA, 22));
+            uT2 = RTSHA_AVX2_ADD(uT2, RTSHA_AVX2_XOR(RTSHA_AVX2_AND(RTSHA_AVX2_XOR(uB, uC), uA), RTSHA_AVX2_AND(uB, uC)));
+
+            uH = uG;
+            uG = uF;
+            uF = uE;
+            uE = RTSHA_AVX2_ADD(uD, uT1);
+            uD = uC;
+            uC = uB;
+            uB = uA;
+            uA = RTSHA_AVX2_ADD(uT1, uT2);
+        }
+
+        auState[0] = RTSHA_AVX2_ADD(auState[0], uA);
+        auState[1] = RTSHA_AVX2_ADD(auState[1], uB);
+        auState[2] = RTSHA_AVX2_ADD(auState[2], uC);
+        auState[3] = RTSHA_AVX2_ADD(auState[3], uD);
+        auState[4] = RTSHA_AVX2_ADD(auState[4], uE);
+        auState[5] = RTSHA_AVX2_ADD(auState[5], uF);
+        auState[6] = RTSHA_AVX2_ADD(auState[6], uG);
+        auState[7] = RTSHA_AVX2_ADD(auState[7], uH);
+
+        for (unsigned iLane = 0; iLane < RTSHA_AVX2_LANES; iLane++)
+            apbData[iLane] += 64;
+    }
+
+    for (unsigned i = 0; i < 8; i++)
+        rtShaAvx2StoreState(papauH, i, auState[i]);
+}
+
@@ -0,0 +1,197 @@
+/* $Id: alt-sha-shani.cpp $ */
+/** @file
+ * IPRT - SHA-1 and SHA-256, SHA extension kernels.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ * --------------------------------------------------------------------
+ *
+ * This code is based on:
+ *
+ *  "Intel SHA Extensions: New Instructions Supporting the Secure Hash
+ *   Algorithm on Intel Architecture Processors", S. Gulley, V. Gopal,
+ *   K. Yap, W. Feghali, J. Guilford, G. Wolrich, Intel Corporation,
+ *   July 2013.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "internal/iprt.h"
+#include <iprt/types.h>
+#include "internal/sha.h"
+
+#include <emmintrin.h>  /* SSE2 */
+#include <tmmintrin.h>  /* SSSE3 */
+#include <smmintrin.h>  /* SSE4.1 */
+#include <immintrin.h>  /* SHA */
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** The SHA-256 round constants. */
+static uint32_t const g_auSha256Ks[64] =
+{
+    UINT32_C(0x428a2f98), UINT32_C(0x71374491), UINT32_C(0xb5c0fbcf), UINT32_C(0xe9b5dba5),
+    UINT32_C(0x3956c25b), UINT32_C(0x59f111f1), UINT32_C(0x923f82a4), UINT32_C(0xab1c5ed5),
+    UINT32_C(0xd807aa98), UINT32_C(0x12835b01), UINT32_C(0x243185be), UINT32_C(0x550c7dc3),
+    UINT32_C(0x72be5d74), UINT32_C(0x80deb1fe), UINT32_C(0x9bdc06a7), UINT32_C(0xc19bf174),
+    UINT32_C(0xe49b69c1), UINT32_C(0xefbe4786), UINT32_C(0x0fc19dc6), UINT32_C(0x240ca1cc),
+    UINT32_C(0x2de92c6f), UINT32_C(0x4a7484aa), UINT32_C(0x5cb0a9dc), UINT32_C(0x76f988da),
+    UINT32_C(0x983e5152), UINT32_C(0xa831c66d), UINT32_C(0xb00327c8), UINT32_C(0xbf597fc7),
+    UINT32_C(0xc6e00bf3), UINT32_C(0xd5a79147), UINT32_C(0x06ca6351), UINT32_C(0x14292967),
+    UINT32_C(0x27b70a85), UINT32_C(0x2e1b2138), UINT32_C(0x4d2c6dfc), UINT32_C(0x53380d13),
+    UINT32_C(0x650a7354), UINT32_C(0x766a0abb), UINT32_C(0x81c2c92e), UINT32_C(0x92722c85),
+    UINT32_C(0xa2bfe8a1), UINT32_C(0xa81a664b), UINT32_C(0xc24b8b70), UINT32_C(0xc76c51a3),
+    UINT32_C(0xd192e819), UINT32_C(0xd6990624), UINT32_C(0xf40e3585), UINT32_C(0x106aa070),
+    UINT32_C(0x19a4c116), UINT32_C(0x1e376c08), UINT32_C(0x2748774c), UINT32_C(0x34b0bcb5),
+    UINT32_C(0x391c0cb3), UINT32_C(0x4ed8aa4a), UINT32_C(0x5b9cca4f), UINT32_C(0x682e6ff3),
+    UINT32_C(0x748f82ee), UINT32_C(0x78a5636f), UINT32_C(0x84c87814), UINT32_C(0x8cc70208),
+    UINT32_C(0x90befffa), UINT32_C(0xa4506ceb), UINT32_C(0xbef9a3f7), UINT32_C(0xc67178f2),
+};
+
+
+DECLHIDDEN(void) rtSha1ShaNiProcess(uint32_t *pauH, uint8_t const *pbData, size_t cBlocks)
+{
+    /* Reverses the byte order of the whole 128-bit message block word. */
+    __m128i const uBSwapMask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    /* The instructions want A in the high dword and E in the high dword of
+       a separate register. */
+    __m128i uABCD = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *)pauH), 0x1b);
+    __m128i uE0   = _mm_set_epi32((int)pauH[4], 0, 0, 0);
+    __m128i uE1;
+    __m128i auMsg[4];
+
+    /*
+     * Each group of four rounds:
+     *  - computes E from the previous A and adds the message words (nexte),
+     *  - finishes message word i+4 (msg2), starts i+7 (msg1) and mixes i+6,
+     *  - does the four rounds with function a_iFn.
+     * The E registers alternate between even and odd groups.
+     */
+#define RTSHA1_NI_GROUP(a_iGroup, a_uEIn, a_uEOut) \
+    do { \
+        __m128i &uCur = auMsg[(a_iGroup) & 3]; \
+        if ((a_iGroup) < 4) \
+            uCur = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const *)&pbData[(a_iGroup) * 16]), uBSwapMask); \
+        if ((a_iGroup) == 0) \
+            a_uEIn = _mm_add_epi32(a_uEIn, uCur); \
+        else \
+            a_uEIn = _mm_sha1nexte_epu32(a_uEIn, uCur); \
+        a_uEOut = uABCD; \
+        if ((a_iGroup) >= 3 && (a_iGroup) <= 18) \
+            auMsg[((a_iGroup) + 1) & 3] = _mm_sha1msg2_epu32(auMsg[((a_iGroup) + 1) & 3], uCur); \
+        uABCD = _mm_sha1rnds4_epu32(uABCD, a_uEIn, (a_iGroup) / 5); \
+        if ((a_iGroup) >= 1 && (a_iGroup) <= 16) \
+            auMsg[((a_iGroup) + 3) & 3] = _mm_sha1msg1_epu32(auMsg[((a_iGroup) + 3) & 3], uCur); \
+        if ((a_iGroup) >= 2 && (a_iGroup) <= 17) \
+            auMsg[((a_iGroup) + 2) & 3] = _mm_xor_si128(auMsg[((a_iGroup) + 2) & 3], uCur); \
+    } while (0)
+
+    while (cBlocks-- > 0)
+    {
+        __m128i const uABCDSave = uABCD;
+        __m128i const uE0Save   = uE0;
+
+        RTSHA1_NI_GROUP( 0, uE0, uE1); RTSHA1_NI_GROUP( 1, uE1, uE0);
+        RTSHA1_NI_GROUP( 2, uE0, uE1); RTSHA1_NI_GROUP( 3, uE1, uE0);
+        RTSHA1_NI_GROUP( 4, uE0, uE1); RTSHA1_NI_GROUP( 5, uE1, uE0);
+        RTSHA1_NI_GROUP( 6, uE0, uE1); RTSHA1_NI_GROUP( 7, uE1, uE0);
+        RTSHA1_NI_GROUP( 8, uE0, uE1); RTSHA1_NI_GROUP( 9, uE1, uE0);
+        RTSHA1_NI_GROUP(10, uE0, uE1); RTSHA1_NI_GROUP(11, uE1, uE0);
+        RTSHA1_NI_GROUP(12, uE0, uE1); RTSHA1_NI_GROUP(13, uE1, uE0);
+        RTSHA1_NI_GROUP(14, uE0, uE1); RTSHA1_NI_GROUP(15, uE1, uE0);
+        RTSHA1_NI_GROUP(16, uE0, uE1); RTSHA1_NI_GROUP(17, uE1, uE0);
+        RTSHA1_NI_GROUP(18, uE0, uE1); RTSHA1_NI_GROUP(19, uE1, uE0);
+
+        uE0   = _mm_sha1nexte_epu32(uE0, uE0Save);
+        uABCD = _mm_add_epi32(uABCD, uABCDSave);
+        pbData += 64;
+    }
+#undef RTSHA1_NI_GROUP
+
+    _mm_storeu_si128((__m128i *)pauH, _mm_shuffle_epi32(uABCD, 0x1b));
+    pauH[4] = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(uE0, 12));
+}
+
+
+DECLHIDDEN(void) rtSha256ShaNiProcess(uint32_t *pauH, uint8_t const *pbData, size_t cBlocks)
+{
+    /* Byte swaps each of the four dwords. */
+    __m128i const uBSwapMask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    /* The instructions want the state as ABEF and CDGH. */
+    __m128i uTmp    = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *)&pauH[0]), 0xb1); /* CDAB */
+    __m128i uState1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i const *)&pauH[4]), 0x1b); /* EFGH */
+    __m128i uState0 = _mm_alignr_epi8(uTmp, uState1, 8);                                   /* ABEF */
+    uState1 = _mm_blend_epi16(uState1, uTmp, 0xf0);                                         /* CDGH */
+    __m128i auMsg[4];
+
+    /*
+     * Each group of four rounds adds the round constants to the current
+     * message words, does two times two rounds, finishes message word i+4
+     * (msg2) and starts i+7 (msg1).
+     */
+#define RTSHA256_NI_GROUP(a_iGroup) \
+    do { \
+        __m128i &uCur = auMsg[(a_iGroup) & 3]; \
+        if ((a_iGroup) < 4) \
+            uCur = _mm_shuffle_epi8(_mm_loadu_si128((__m128i const *)&pbData[(a_iGroup) * 16]), uBSwapMask); \
+        __m128i uMsg = _mm_add_epi32(uCur, _mm_loadu_si128((__m128i const *)&g_auSha256Ks[(a_iGroup) * 4])); \
+        uState1 = _mm_sha256rnds2_epu32(uState1, uState0, uMsg); \
+        if ((a_iGroup) >= 3 && (a_iGroup) <= 14) \
+        { \
+            __m128i &uNext = auMsg[((a_iGroup) + 1) & 3]; \
+            uNext = _mm_add_epi32(uNext, _mm_alignr_epi8(uCur, auMsg[((a_iGroup) + 3) & 3], 4)); \
+            uNext = _mm_sha256msg2_epu32(uNext, uCur); \
+        } \
+        uMsg = _mm_shuffle_epi32(uMsg, 0x0e); \
+        uState0 = _mm_sha256rnds2_epu32(uState0, uState1, uMsg); \
+        if ((a_iGroup) >= 1 && (a_iGroup) <= 12) \
+            auMsg[((a_iGroup) + 3) & 3] = _mm_sha256msg1_epu32(auMsg[((a_iGroup) + 3) & 3], uCur); \
+    } while (0)
+
+    while (cBlocks-- > 0)
+    {
+        __m128i const uState0Save = uState0;
+        __m128i const uState1Save = uState1;
+
+        RTSHA256_NI_GROUP( 0); RTSHA256_NI_GROUP( 1); RTSHA256_NI_GROUP( 2); RTSHA256_NI_GROUP( 3);
+        RTSHA256_NI_GROUP( 4); RTSHA256_NI_GROUP( 5); RTSHA256_NI_GROUP( 6); RTSHA256_NI_GROUP( 7);
+        RTSHA256_NI_GROUP( 8); RTSHA256_NI_GROUP( 9); RTSHA256_NI_GROUP(10); RTSHA256_NI_GROUP(11);
+        RTSHA256_NI_GROUP(12); RTSHA256_NI_GROUP(13); RTSHA256_NI_GROUP(14); RTSHA256_NI_GROUP(15);
+
+        uState0 = _mm_add_epi32(uState0, uState0Save);
+        uState1 = _mm_add_epi32(uState1, uState1Save);
+        pbData += 64;
+    }
+#undef RTSHA256_NI_GROUP
+
+    /* Back to ABCD and EFGH. */
+    uTmp    = _mm_shuffle_epi32(uState0, 0x1b);                                             /* FEBA */
+    uState1 = _mm_shuffle_epi32(uState1, 0xb1);                                             /* DCHG */
+    _mm_storeu_si128((__m128i *)&pauH[0], _mm_blend_epi16(uTmp, uState1, 0xf0));            /* DCBA */
+    _mm_storeu_si128((__m128i *)&pauH[4], _mm_alignr_epi8(uState1, uTmp, 8));               /* HGFE */
+}
+
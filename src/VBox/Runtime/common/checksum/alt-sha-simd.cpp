@@ -0,0 +1,105 @@
+/* $Id: alt-sha-simd.cpp $ */
+/** @file
+ * IPRT - SHA-1 and SHA-256, SIMD kernel selection.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "internal/iprt.h"
+#include <iprt/asm.h>
+#include <iprt/asm-amd64-x86.h>
+#include <iprt/env.h>
+#include <iprt/x86.h>
+#include "internal/sha.h"
+#if defined(_MSC_VER) && !RT_INLINE_ASM_GNU_STYLE
+# include <immintrin.h>
+#endif
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** The usable kernels (RTSHA_SIMD_F_XXX), UINT32_MAX if not yet determined. */
+static uint32_t volatile g_fShaSimdFeatures = UINT32_MAX;
+
+
+/**
+ * Reads XCR0, the caller must make sure CPUID.1:ECX.OSXSAVE is set.
+ */
+static uint64_t rtShaSimdGetXcr0(void)
+{
+#if RT_INLINE_ASM_GNU_STYLE
+    uint32_t uLow, uHigh;
+    __asm__ __volatile__(".byte 0x0f,0x01,0xd0\n\t" /* xgetbv */
+                         : "=a" (uLow),
+                           "=d" (uHigh)
+                         : "c" (0));
+    return RT_MAKE_U64(uLow, uHigh);
+#else
+    return _xgetbv(0);
+#endif
+}
+
+
+DECLHIDDEN(uint32_t) rtShaSimdGetFeatures(void)
+{
+    uint32_t fFeatures = ASMAtomicUoReadU32(&g_fShaSimdFeatures);
+    if (RT_LIKELY(fFeatures != UINT32_MAX))
+        return fFeatures;
+
+    fFeatures = 0;
+    if (ASMHasCpuId())
+    {
+        uint32_t uEAX, uEBX, uECX, uEDX;
+        ASMCpuId(0, &uEAX, &uEBX, &uECX, &uEDX);
+        uint32_t const uMaxLeaf = uEAX;
+        if (uMaxLeaf >= 7)
+        {
+            uint32_t uECX1, uEDX1;
+            ASMCpuId_ECX_EDX(1, &uECX1, &uEDX1);
+            ASMCpuId_Idx_ECX(7, 0, &uEAX, &uEBX, &uECX, &uEDX);
+
+            /* The SHA extension kernels use SSSE3 (pshufb) and SSE4.1 (pblendw). */
+            if (   (uEBX & X86_CPUID_STEXT_FEATURE_EBX_SHA)
+                && (uECX1 & X86_CPUID_FEATURE_ECX_SSSE3)
+                && (uECX1 & X86_CPUID_FEATURE_ECX_SSE4_1)
+                && !RTEnvExist("IPRT_SHA_NO_SHA_NI"))
+                fFeatures |= RTSHA_SIMD_F_SHA_NI;
+
+            /* AVX2 also requires the OS to save the YMM state. */
+            if (   (uEBX & X86_CPUID_STEXT_FEATURE_EBX_AVX2)
+                && (uECX1 & X86_CPUID_FEATURE_ECX_AVX)
+                && (uECX1 & X86_CPUID_FEATURE_ECX_OSXSAVE)
+                && (rtShaSimdGetXcr0() & (XSAVE_C_SSE | XSAVE_C_YMM)) == (XSAVE_C_SSE | XSAVE_C_YMM)
+                && !RTEnvExist("IPRT_SHA_NO_AVX2"))
+                fFeatures |= RTSHA_SIMD_F_AVX2;
+        }
+    }
+
+    ASMAtomicWriteU32(&g_fShaSimdFeatures, fFeatures);
+    return fFeatures;
+}
+
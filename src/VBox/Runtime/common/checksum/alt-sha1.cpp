@@ -43,6 +43,7 @@
 #include <iprt/assert.h>
 #include <iprt/asm.h>
 #include <iprt/string.h>
+#include "internal/sha.h"
 
 
 /** Our private context structure. */
@@ -397,6 +398,22 @@ RTDECL(void) RTSha1Update(PRTSHA1CONTEXT pCtx, const void *pvBuf, size_t cbBuf)
         }
     }
 
+#ifdef RTSHA_WITH_SIMD
+    if (   cbBuf >= RTSHA1_BLOCK_SIZE
+        && (rtShaSimdGetFeatures() & RTSHA_SIMD_F_SHA_NI))
+    {
+        /*
+         * Let the SHA extension kernel process all the full blocks.
+         */
+        size_t const cBlocks = cbBuf / RTSHA1_BLOCK_SIZE;
+        rtSha1ShaNiProcess(&pCtx->AltPrivate.auH[0], pbBuf, cBlocks);
+
+        pCtx->AltPrivate.cbMessage += cBlocks * RTSHA1_BLOCK_SIZE;
+        pbBuf += cBlocks * RTSHA1_BLOCK_SIZE;
+        cbBuf -= cBlocks * RTSHA1_BLOCK_SIZE;
+    }
+    else
+#endif
     if (!((uintptr_t)pbBuf & 3))
     {
         /*
@@ -441,6 +458,101 @@ RTDECL(void) RTSha1Update(PRTSHA1CONTEXT pCtx, const void *pvBuf, size_t cbBuf)
 RT_EXPORT_SYMBOL(RTSha1Update);
 
 
+RTDECL(void) RTSha1UpdateMulti(uint32_t cCtxs, PRTSHA1CONTEXT *papCtxs, void const * const *papvBufs, size_t const *pacbBufs)
+{
+#ifdef RTSHA_WITH_SIMD
+    /*
+     * Interleave the streams with the AVX2 kernel, unless the SHA extension
+     * is available as that is faster per stream.
+     */
+    if (   cCtxs > 1
+        && (rtShaSimdGetFeatures() & (RTSHA_SIMD_F_SHA_NI | RTSHA_SIMD_F_AVX2)) == RTSHA_SIMD_F_AVX2)
+    {
+        /* Lanes without data rehash the data of an active lane into a dummy state. */
+        uint32_t                auDummyH[RT_ELEMENTS(papCtxs[0]->AltPrivate.auH)];
+
+        for (uint32_t iFirst = 0; iFirst < cCtxs; iFirst += RTSHA_AVX2_LANES)
+        {
+            uint32_t const  cLanes = RT_MIN(cCtxs - iFirst, RTSHA_AVX2_LANES);
+            PRTSHA1CONTEXT   apCtxs[RTSHA_AVX2_LANES];
+            uint8_t const  *apbData[RTSHA_AVX2_LANES];
+            size_t          acbData[RTSHA_AVX2_LANES];
+            uint32_t       *papauH[RTSHA_AVX2_LANES];
+
+            /* Complete any partially buffered blocks the regular way so all
+               streams start on a block boundary. */
+            for (uint32_t iLane = 0; iLane < cLanes; iLane++)
+            {
+                PRTSHA1CONTEXT pCtx = apCtxs[iLane] = papCtxs[iFirst + iLane];
+                Assert(pCtx->AltPrivate.cbMessage < UINT64_MAX / 8);
+                apbData[iLane] = (uint8_t const *)papvBufs[iFirst + iLane];
+                acbData[iLane] = pacbBufs[iFirst + iLane];
+
+                size_t const cbBuffered = (size_t)pCtx->AltPrivate.cbMessage & (RTSHA1_BLOCK_SIZE - 1U);
+                if (cbBuffered)
+                {
+                    size_t const cbMissing = RT_MIN(RTSHA1_BLOCK_SIZE - cbBuffered, acbData[iLane]);
+                    RTSha1Update(pCtx, apbData[iLane], cbMissing);
+                    apbData[iLane] += cbMissing;
+                    acbData[iLane] -= cbMissing;
+                }
+            }
+
+            /* Process the full blocks common to two or more streams. */
+            for (;;)
+            {
+                uint32_t cActive = 0;
+                uint32_t iActive = 0;
+                size_t   cBlocks = ~(size_t)0;
+                for (uint32_t iLane = 0; iLane < cLanes; iLane++)
+                    if (acbData[iLane] >= RTSHA1_BLOCK_SIZE)
+                    {
+                        cActive++;
+                        iActive = iLane;
+                        cBlocks = RT_MIN(cBlocks, acbData[iLane] / RTSHA1_BLOCK_SIZE);
+                    }
+                if (cActive < 2)
+                    break;
+
+                uint8_t const *apbLanes[RTSHA_AVX2_LANES];
+                for (uint32_t iLane = 0; iLane < RTSHA_AVX2_LANES; iLane++)
+                    if (iLane < cLanes && acbData[iLane] >= RTSHA1_BLOCK_SIZE)
+                    {
+                        papauH[iLane]   = &apCtxs[iLane]->AltPrivate.auH[0];
+                        apbLanes[iLane] = apbData[iLane];
+                    }
+                    else
+                    {
+                        papauH[iLane]   = &auDummyH[0];
+                        apbLanes[iLane] = apbData[iActive];
+                    }
+
+                rtSha1Avx2ProcessMulti(papauH, apbLanes, cBlocks);
+
+                for (uint32_t iLane = 0; iLane < cLanes; iLane++)
+                    if (acbData[iLane] >= RTSHA1_BLOCK_SIZE)
+                    {
+                        apCtxs[iLane]->AltPrivate.cbMessage += cBlocks * RTSHA1_BLOCK_SIZE;
+                        apbData[iLane] += cBlocks * RTSHA1_BLOCK_SIZE;
+                        acbData[iLane] -= cBlocks * RTSHA1_BLOCK_SIZE;
+                    }
+            }
+
+            /* The rest. */
+            for (uint32_t iLane = 0; iLane < cLanes; iLane++)
+                if (acbData[iLane])
+                    RTSha1Update(apCtxs[iLane], apbData[iLane], acbData[iLane]);
+        }
+        return;
+    }
+#endif
+
+    for (uint32_t i = 0; i < cCtxs; i++)
+        RTSha1Update(papCtxs[i], papvBufs[i], pacbBufs[i]);
+}
+RT_EXPORT_SYMBOL(RTSha1UpdateMulti);
+
+
 RTDECL(void) RTSha1Final(PRTSHA1CONTEXT pCtx, uint8_t pabDigest[RTSHA1_HASH_SIZE])
 {
     Assert(pCtx->AltPrivate.cbMessage < UINT64_MAX / 2);
@@ -0,0 +1,162 @@
+/* $Id: crc32-pclmul.cpp $ */
+/** @file
+ * IPRT - CRC32, PCLMULQDQ folding kernel.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ * --------------------------------------------------------------------
+ *
+ * This code is based on:
+ *
+ *  "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ *   Instruction", V. Gopal, E. Ozturk, J. Guilford, G. Wolrich, W. Feghali,
+ *   M. Dixon, D. Karakoyunlu, Intel Corporation, December 2009.
+ *
+ *  The folding constants are those for the bit reflected IEEE 802.3
+ *  polynomial (0x04c11db7) and are the same as used by the Linux kernel
+ *  and zlib-ng.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/crc.h>
+#include "internal/iprt.h"
+
+#include <iprt/asm.h>
+#include <iprt/asm-amd64-x86.h>
+#include <iprt/assert.h>
+#include <iprt/env.h>
+#include <iprt/x86.h>
+#include "internal/crc.h"
+
+#include <emmintrin.h>  /* SSE2 */
+#include <wmmintrin.h>  /* PCLMULQDQ */
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** Whether the PCLMULQDQ kernel can be used: -1 = not yet determined,
+ * 0 = no, 1 = yes. */
+static int32_t volatile g_iCrc32PclMul = -1;
+
+
+DECLHIDDEN(bool) rtCrc32PclMulIsAvailable(void)
+{
+    int32_t iPclMul = ASMAtomicUoReadS32(&g_iCrc32PclMul);
+    if (RT_LIKELY(iPclMul >= 0))
+        return iPclMul != 0;
+
+    iPclMul = 0;
+    if (ASMHasCpuId())
+    {
+        uint32_t uECX, uEDX;
+        ASMCpuId_ECX_EDX(1, &uECX, &uEDX);
+        if (   (uECX & X86_CPUID_FEATURE_ECX_PCLMUL)
+            && (uEDX & X86_CPUID_FEATURE_EDX_SSE2)
+            && !RTEnvExist("IPRT_CRC32_NO_PCLMUL"))
+            iPclMul = 1;
+    }
+    ASMAtomicWriteS32(&g_iCrc32PclMul, iPclMul);
+    return iPclMul != 0;
+}
+
+
+/**
+ * Folds a 128-bit accumulator 128 or 512 bits forward and adds in the next
+ * block of data.
+ */
+DECLINLINE(__m128i) rtCrc32PclMulFold(__m128i uAcc, __m128i uConst, __m128i uData)
+{
+    __m128i uHi = _mm_clmulepi64_si128(uAcc, uConst, 0x11);
+    __m128i uLo = _mm_clmulepi64_si128(uAcc, uConst, 0x00);
+    return _mm_xor_si128(_mm_xor_si128(uLo, uHi), uData);
+}
+
+
+DECLHIDDEN(uint32_t) rtCrc32PclMulProcess(uint32_t uCRC32, uint8_t const *pb, size_t cb)
+{
+    Assert(cb >= RTCRC32_PCLMUL_MIN_SIZE);
+
+    /* x^(4*128+32) mod P and x^(4*128-32) mod P - fold by four. */
+    __m128i const uK1K2  = _mm_set_epi32(0x00000001, 0xc6e41596, 0x00000001, 0x54442bd4);
+    /* x^(128+32) mod P and x^(128-32) mod P - fold by one. */
+    __m128i const uK3K4  = _mm_set_epi32(0x00000000, 0xccaa009e, 0x00000001, 0x751997d0);
+    /* x^64 mod P. */
+    __m128i const uK5    = _mm_set_epi32(0x00000000, 0x00000000, 0x00000001, 0x63cd6124);
+    /* P' and the Barrett constant u' = floor(x^64 / P), both bit reflected. */
+    __m128i const uPoly  = _mm_set_epi32(0x00000001, 0xf7011641, 0x00000001, 0xdb710641);
+    __m128i const uMask  = _mm_set_epi32(0, 0, 0, -1);
+
+    /*
+     * Load the first 64 bytes into four accumulators, mixing in the CRC,
+     * and fold them forward 64 bytes at a time.
+     */
+    __m128i uAcc1 = _mm_xor_si128(_mm_loadu_si128((__m128i const *)pb), _mm_cvtsi32_si128((int)uCRC32));
+    __m128i uAcc2 = _mm_loadu_si128((__m128i const *)(pb + 16));
+    __m128i uAcc3 = _mm_loadu_si128((__m128i const *)(pb + 32));
+    __m128i uAcc4 = _mm_loadu_si128((__m128i const *)(pb + 48));
+    pb += 64;
+    cb -= 64;
+
+    while (cb >= 64)
+    {
+        uAcc1 = rtCrc32PclMulFold(uAcc1, uK1K2, _mm_loadu_si128((__m128i const *)pb));
+        uAcc2 = rtCrc32PclMulFold(uAcc2, uK1K2, _mm_loadu_si128((__m128i const *)(pb + 16)));
+        uAcc3 = rtCrc32PclMulFold(uAcc3, uK1K2, _mm_loadu_si128((__m128i const *)(pb + 32)));
+        uAcc4 = rtCrc32PclMulFold(uAcc4, uK1K2, _mm_loadu_si128((__m128i const *)(pb + 48)));
+        pb += 64;
+        cb -= 64;
+    }
+
+    /*
+     * Reduce the four accumulators into one and fold in any remaining
+     * whole 16 byte blocks.
+     */
+    uAcc1 = rtCrc32PclMulFold(uAcc1, uK3K4, uAcc2);
+    uAcc1 = rtCrc32PclMulFold(uAcc1, uK3K4, uAcc3);
+    uAcc1 = rtCrc32PclMulFold(uAcc1, uK3K4, uAcc4);
+    while (cb >= 16)
+    {
+        uAcc1 = rtCrc32PclMulFold(uAcc1, uK3K4, _mm_loadu_si128((__m128i const *)pb));
+        pb += 16;
+        cb -= 16;
+    }
+
+    /*
+     * Reduce 128 bits to 64, then 64 to 32, and finish with a Barrett
+     * reduction to get the remainder.
+     */
+    uAcc1 = _mm_xor_si128(_mm_srli_si128(uAcc1, 8), _mm_clmulepi64_si128(uK3K4, uAcc1, 0x01));
+
+    __m128i uTmp = _mm_srli_si128(uAcc1, 4);
+    uAcc1 = _mm_clmulepi64_si128(_mm_and_si128(uAcc1, uMask), uK5, 0x00);
+    uAcc1 = _mm_xor_si128(uAcc1, uTmp);
+
+    uTmp  = uAcc1;
+    uAcc1 = _mm_clmulepi64_si128(_mm_and_si128(uAcc1, uMask), uPoly, 0x10);
+    uAcc1 = _mm_clmulepi64_si128(_mm_and_si128(uAcc1, uMask), uPoly, 0x00);
+    uAcc1 = _mm_xor_si128(uAcc1, uTmp);
+    return (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(uAcc1, 4));
+}
+
@@ -30,6 +30,7 @@
 *******************************************************************************/
 #include "internal/iprt.h"
 #include <iprt/crc.h>
+#include "internal/crc.h"
 
 #include <zlib.h>
 
@@ -47,18 +48,39 @@ static uint32_t rtCrc32ProcessTooBig(uint32_t uCRC32, const void *pv, size_t cb)
         uCRC32 = crc32(uCRC32, pb, cbChunk);
         pb += cbChunk;
         cb -= cbChunk;
-    } while (!cb);
+    } while (cb);
     return uCRC32;
 }
 
-RTDECL(uint32_t) RTCrc32(const void *pv, register size_t cb)
+
+/**
+ * Common worker for RTCrc32 and RTCrc32Process.
+ *
+ * Large blocks are handed to the PCLMULQDQ kernel when available, the rest is
+ * left to zlib.
+ */
+static uint32_t rtCrc32ProcessWorker(uint32_t uCRC32, const void *pv, size_t cb)
 {
-    uint32_t uCrc = crc32(0, NULL, 0);
-    if (RT_UNLIKELY((uInt)cb == cb))
-        uCrc = crc32(uCrc, (const Bytef *)pv, (uInt)cb);
+#ifdef RTCRC32_WITH_PCLMUL
+    if (cb >= RTCRC32_PCLMUL_MIN_SIZE && rtCrc32PclMulIsAvailable())
+    {
+        /* zlib keeps the CRC register inverted between calls, the kernel doesn't. */
+        uCRC32 = ~rtCrc32PclMulProcess(~uCRC32, (const uint8_t *)pv, cb);
+        pv  = (const uint8_t *)pv + (cb & ~(size_t)15);
+        cb &= 15;
+    }
+#endif
+    if (RT_LIKELY((uInt)cb == cb))
+        uCRC32 = crc32(uCRC32, (const Bytef *)pv, (uInt)cb);
     else
-        uCrc = rtCrc32ProcessTooBig(uCrc, pv, cb);
-    return uCrc;
+        uCRC32 = rtCrc32ProcessTooBig(uCRC32, pv, cb);
+    return uCRC32;
+}
+
+
+RTDECL(uint32_t) RTCrc32(const void *pv, register size_t cb)
+{
+    return rtCrc32ProcessWorker(crc32(0, NULL, 0), pv, cb);
 }
 RT_EXPORT_SYMBOL(RTCrc32);
 
@@ -72,11 +94,7 @@ RT_EXPORT_SYMBOL(RTCrc32Start);
 
 RTDECL(uint32_t) RTCrc32Process(uint32_t uCRC32, const void *pv, size_t cb)
 {
-    if (RT_UNLIKELY((uInt)cb == cb))
-        uCRC32 = crc32(uCRC32, (const Bytef *)pv, (uInt)cb);
-    else
-        uCRC32 = rtCrc32ProcessTooBig(uCRC32, pv, cb);
-    return uCRC32;
+    return rtCrc32ProcessWorker(uCRC32, pv, cb);
 }
 RT_EXPORT_SYMBOL(RTCrc32Process);
 
@@ -76,6 +76,9 @@ __FBSDID("$FreeBSD: src/sys/libkern/crc32.c,v 1.2 2003/06/11 05:23:04 obrien Exp
 #else
 # include <iprt/crc.h>
 # include "internal/iprt.h"
+
+# include <iprt/asm.h>
+# include "internal/crc.h"
 #endif
 
 #if 0
@@ -150,13 +153,94 @@ crc32(const void *buf, size_t size)
 
 
 
-RTDECL(uint32_t) RTCrc32(const void *pv, size_t cb)
+/** The slicing-by-8 tables, g_aau32CRC32Slices[i][b] is the CRC of the byte
+ * b followed by i+1 zero bytes.  The table for i = -1 is g_au32CRC32.
+ * Lazily initialized by rtCrc32InitSlices. */
+static uint32_t g_aau32CRC32Slices[7][256];
+/** Set when g_aau32CRC32Slices has been initialized. */
+static bool volatile g_fCRC32SlicesInitialized = false;
+
+
+/**
+ * Calculates the slicing-by-8 tables.
+ *
+ * Racing threads will just calculate the same values, so no serialization is
+ * needed here.
+ */
+static void rtCrc32InitSlices(void)
 {
-    const uint8_t  *pu8 = (const uint8_t *)pv;
-    uint32_t        uCRC32 = ~0U;
+    for (unsigned i = 0; i < 256; i++)
+    {
+        uint32_t uCRC32 = g_au32CRC32[i];
+        for (unsigned iSlice = 0; iSlice < RT_ELEMENTS(g_aau32CRC32Slices); iSlice++)
+        {
+            uCRC32 = g_au32CRC32[uCRC32 & 0xff] ^ (uCRC32 >> 8);
+            g_aau32CRC32Slices[iSlice][i] = uCRC32;
+        }
+    }
+    ASMAtomicWriteBool(&g_fCRC32SlicesInitialized, true);
+}
+
+
+/**
+ * The CRC32 worker, processing 8 bytes per iteration once the input pointer
+ * has been aligned.
+ *
+ * @returns Updated CRC32 register value.
+ * @param   uCRC32  The current CRC32 register value.
+ * @param   pu8     The data.
+ * @param   cb      The data size.
+ */
+static uint32_t rtCrc32ProcessWorker(uint32_t uCRC32, const uint8_t *pu8, size_t cb)
+{
+    if (cb >= 16)
+    {
+#ifdef RTCRC32_WITH_PCLMUL
+        if (cb >= RTCRC32_PCLMUL_MIN_SIZE && rtCrc32PclMulIsAvailable())
+        {
+            uCRC32 = rtCrc32PclMulProcess(uCRC32, pu8, cb);
+            pu8 += cb & ~(size_t)15;
+            cb  &= 15;
+        }
+        else
+#endif
+        {
+            if (RT_UNLIKELY(!g_fCRC32SlicesInitialized))
+                rtCrc32InitSlices();
+
+            while ((uintptr_t)pu8 & 7)
+            {
+                uCRC32 = g_au32CRC32[(uCRC32 ^ *pu8++) & 0xff] ^ (uCRC32 >> 8);
+                cb--;
+            }
+
+            while (cb >= 8)
+            {
+                uint32_t const u32Lo = RT_LE2H_U32(((uint32_t const *)pu8)[0]) ^ uCRC32;
+                uint32_t const u32Hi = RT_LE2H_U32(((uint32_t const *)pu8)[1]);
+                uCRC32 = g_aau32CRC32Slices[6][ u32Lo        & 0xff]
+                       ^ g_aau32CRC32Slices[5][(u32Lo >>  8) & 0xff]
+                       ^ g_aau32CRC32Slices[4][(u32Lo >> 16) & 0xff]
+                       ^ g_aau32CRC32Slices[3][ u32Lo >> 24]
+                       ^ g_aau32CRC32Slices[2][ u32Hi        & 0xff]
+                       ^ g_aau32CRC32Slices[1][(u32Hi >>  8) & 0xff]
+                       ^ g_aau32CRC32Slices[0][(u32Hi >> 16) & 0xff]
+                       ^ g_au32CRC32          [ u32Hi >> 24];
+                pu8 += 8;
+                cb  -= 8;
+            }
+        }
+    }
+
     while (cb--)
         uCRC32 = g_au32CRC32[(uCRC32 ^ *pu8++) & 0xff] ^ (uCRC32 >> 8);
-    return uCRC32 ^ ~0U;
+    return uCRC32;
+}
+
+
+RTDECL(uint32_t) RTCrc32(const void *pv, size_t cb)
+{
+    return rtCrc32ProcessWorker(~0U, (const uint8_t *)pv, cb) ^ ~0U;
 }
 RT_EXPORT_SYMBOL(RTCrc32);
 
@@ -170,10 +254,7 @@ RT_EXPORT_SYMBOL(RTCrc32Start);
 
 RTDECL(uint32_t) RTCrc32Process(uint32_t uCRC32, const void *pv, size_t cb)
 {
-    const uint8_t  *pu8 = (const uint8_t *)pv;
-    while (cb--)
-        uCRC32 = g_au32CRC32[(uCRC32 ^ *pu8++) & 0xff] ^ (uCRC32 >> 8);
-    return uCRC32;
+    return rtCrc32ProcessWorker(uCRC32, (const uint8_t *)pv, cb);
 }
 RT_EXPORT_SYMBOL(RTCrc32Process);
 
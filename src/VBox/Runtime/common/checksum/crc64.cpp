@@ -36,6 +36,8 @@
 #include <iprt/crc.h>
 #include "internal/iprt.h"
 
+#include <iprt/asm.h>
+
 
 /*******************************************************************************
 *   Global Variables                                                           *
@@ -150,6 +152,81 @@ static const uint64_t g_au64CRC64[] =
 };
 
 
+/** The slicing-by-8 tables, g_aau64CRC64Slices[i][b] is the CRC of the byte
+ * b followed by i+1 zero bytes.  The table for i = -1 is g_au64CRC64.
+ * Lazily initialized by rtCrc64InitSlices. */
+static uint64_t g_aau64CRC64Slices[7][256];
+/** Set when g_aau64CRC64Slices has been initialized. */
+static bool volatile g_fCRC64SlicesInitialized = false;
+
+
+/**
+ * Calculates the slicing-by-8 tables.
+ *
+ * Racing threads will just calculate the same values, so no serialization is
+ * needed here.
+ */
+static void rtCrc64InitSlices(void)
+{
+    for (unsigned i = 0; i < 256; i++)
+    {
+        uint64_t uCRC64 = g_au64CRC64[i];
+        for (unsigned iSlice = 0; iSlice < RT_ELEMENTS(g_aau64CRC64Slices); iSlice++)
+        {
+            uCRC64 = g_au64CRC64[uCRC64 & 0xff] ^ (uCRC64 >> 8);
+            g_aau64CRC64Slices[iSlice][i] = uCRC64;
+        }
+    }
+    ASMAtomicWriteBool(&g_fCRC64SlicesInitialized, true);
+}
+
+
+/**
+ * The CRC64 worker, processing 8 bytes per iteration once the input pointer
+ * has been aligned.
+ *
+ * @returns Updated CRC64 value.
+ * @param   uCRC64  The current CRC64 value.
+ * @param   pu8     The data.
+ * @param   cb      The data size.
+ */
+static uint64_t rtCrc64ProcessWorker(uint64_t uCRC64, const uint8_t *pu8, size_t cb)
+{
+    if (cb >= 16)
+    {
+        if (RT_UNLIKELY(!g_fCRC64SlicesInitialized))
+            rtCrc64InitSlices();
+
+        while ((uintptr_t)pu8 & 7)
+        {
+            uCRC64 = g_au64CRC64[(uCRC64 ^ *pu8++) & 0xff] ^ (uCRC64 >> 8);
+            cb--;
+        }
+
+        while (cb >= 8)
+        {
+            uint64_t const u64 = RT_LE2H_U64(*(uint64_t const *)pu8) ^ uCRC64;
+            uint32_t const u32Lo = (uint32_t)u64;
+            uint32_t const u32Hi = (uint32_t)(u64 >> 32);
+            uCRC64 = g_aau64CRC64Slices[6][ u32Lo        & 0xff]
+                   ^ g_aau64CRC64Slices[5][(u32Lo >>  8) & 0xff]
+                   ^ g_aau64CRC64Slices[4][(u32Lo >> 16) & 0xff]
+                   ^ g_aau64CRC64Slices[3][ u32Lo >> 24]
+                   ^ g_aau64CRC64Slices[2][ u32Hi        & 0xff]
+                   ^ g_aau64CRC64Slices[1][(u32Hi >>  8) & 0xff]
+                   ^ g_aau64CRC64Slices[0][(u32Hi >> 16) & 0xff]
+                   ^ g_au64CRC64          [ u32Hi >> 24];
+            pu8 += 8;
+            cb  -= 8;
+        }
+    }
+
+    while (cb--)
+        uCRC64 = g_au64CRC64[(uCRC64 ^ *pu8++) & 0xff] ^ (uCRC64 >> 8);
+    return uCRC64;
+}
+
+
 /**
  * Calculate CRC64 for a memory block.
  *
@@ -159,11 +236,7 @@ static const uint64_t g_au64CRC64[] =
  */
 RTDECL(uint64_t) RTCrc64(const void *pv, size_t cb)
 {
-    const uint8_t  *pu8 = (const uint8_t *)pv;
-    uint64_t        uCRC64 = 0ULL;
-    while (cb--)
-        uCRC64 = g_au64CRC64[(uCRC64 ^ *pu8++) & 0xff] ^ (uCRC64 >> 8);
-    return uCRC64;
+    return rtCrc64ProcessWorker(0ULL, (const uint8_t *)pv, cb);
 }
 RT_EXPORT_SYMBOL(RTCrc64);
 
@@ -190,10 +263,7 @@ RT_EXPORT_SYMBOL(RTCrc64Start);
  */
 RTDECL(uint64_t) RTCrc64Process(uint64_t uCRC64, const void *pv, size_t cb)
 {
-    const uint8_t *pu8 = (const uint8_t *)pv;
-    while (cb--)
-        uCRC64 = g_au64CRC64[(uCRC64 ^ *pu8++) & 0xff] ^ (uCRC64 >> 8);
-    return uCRC64;
+    return rtCrc64ProcessWorker(uCRC64, (const uint8_t *)pv, cb);
 }
 RT_EXPORT_SYMBOL(RTCrc64Process);
 
@@ -64,6 +64,14 @@ RTDECL(void) RTSha1Update(PRTSHA1CONTEXT pCtx, const void *pvBuf, size_t cbBuf)
 RT_EXPORT_SYMBOL(RTSha1Update);
 
 
+RTDECL(void) RTSha1UpdateMulti(uint32_t cCtxs, PRTSHA1CONTEXT *papCtxs, void const * const *papvBufs, size_t const *pacbBufs)
+{
+    for (uint32_t i = 0; i < cCtxs; i++)
+        SHA1_Update(&papCtxs[i]->Private, papvBufs[i], pacbBufs[i]);
+}
+RT_EXPORT_SYMBOL(RTSha1UpdateMulti);
+
+
 RTDECL(void) RTSha1Final(PRTSHA1CONTEXT pCtx, uint8_t pabDigest[32])
 {
     SHA1_Final((unsigned char *)&pabDigest[0], &pCtx->Private);
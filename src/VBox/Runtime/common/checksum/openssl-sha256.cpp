@@ -64,6 +64,14 @@ RTDECL(void) RTSha256Update(PRTSHA256CONTEXT pCtx, const void *pvBuf, size_t cbB
 RT_EXPORT_SYMBOL(RTSha256Update);
 
 
+RTDECL(void) RTSha256UpdateMulti(uint32_t cCtxs, PRTSHA256CONTEXT *papCtxs, void const * const *papvBufs, size_t const *pacbBufs)
+{
+    for (uint32_t i = 0; i < cCtxs; i++)
+        SHA256_Update(&papCtxs[i]->Private, papvBufs[i], pacbBufs[i]);
+}
+RT_EXPORT_SYMBOL(RTSha256UpdateMulti);
+
+
 RTDECL(void) RTSha256Final(PRTSHA256CONTEXT pCtx, uint8_t pabDigest[32])
 {
     SHA256_Final((unsigned char *)&pabDigest[0], &pCtx->Private);
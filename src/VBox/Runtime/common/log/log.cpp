@@ -78,6 +78,164 @@ typedef struct RTLOGOUTPUTPREFIXEDARGS
     unsigned                iGroup;
 } RTLOGOUTPUTPREFIXEDARGS, *PRTLOGOUTPUTPREFIXEDARGS;
 
+#ifdef IN_RING3
+/** @name Asynchronous logging (RTLOGFLAGS_ASYNC) parameters.
+ * @{ */
+/** The number of producer rings (power of two). */
+# define RTLOG_ASYNC_RINGS          8
+/** The size of each producer ring in bytes (power of two). */
+# define RTLOG_ASYNC_RING_SIZE      _64K
+/** Messages longer than this take the synchronous path instead of being
+ * dropped for not fitting into a ring. */
+# define RTLOG_ASYNC_MAX_RECORD     (RTLOG_ASYNC_RING_SIZE / 2)
+/** @} */
+
+/**
+ * The header of a message queued for the asynchronous writer.
+ *
+ * Carries the bits of the prefix which depend on the calling thread or on
+ * the time of the call, so the writer can produce the same prefix as the
+ * synchronous path would have.  The formatted message text follows.
+ */
+typedef struct RTLOGASYNCREC
+{
+    /** The size of the record including the text, aligned on 8 bytes. */
+    uint32_t        cbRec;
+    /** The length of the message text. */
+    uint32_t        cchBody;
+    /** The sequence number, used for ordering records from different rings. */
+    uint64_t        uSeq;
+    /** The group flags of the message (RTLOGOUTPUTPREFIXEDARGS::fFlags). */
+    uint32_t        fFlags;
+    /** The group of the message (RTLOGOUTPUTPREFIXEDARGS::iGroup). */
+    uint32_t        iGroup;
+    /** The size of the header, either RTLOG_ASYNC_REC_MIN_SIZE or the full
+     * structure when the caller context was captured for the prefixes. */
+    uint32_t        cbHdr;
+    /** Reserved. */
+    uint32_t        u32Reserved;
+    /** RTLOGFLAGS_PREFIX_TS: RTTimeNanoTS. */
+    uint64_t        u64NanoTS;
+    /** RTLOGFLAGS_PREFIX_TSC: The TSC. */
+    uint64_t        u64Tsc;
+    /** RTLOGFLAGS_PREFIX_MS_PROG, RTLOGFLAGS_PREFIX_TIME_PROG: RTTimeProgramMicroTS. */
+    uint64_t        u64ProgMicroTS;
+    /** RTLOGFLAGS_PREFIX_TIME: The wall clock time. */
+    RTTIMESPEC      Now;
+    /** RTLOGFLAGS_PREFIX_TID: The native thread handle. */
+    uint64_t        u64NativeThread;
+    /** RTLOGFLAGS_PREFIX_LOCK_COUNTS: Read lock count, UINT32_MAX if unknown. */
+    uint32_t        cReadLocks;
+    /** RTLOGFLAGS_PREFIX_LOCK_COUNTS: Write lock count. */
+    uint32_t        cWriteLocks;
+    /** RTLOGFLAGS_PREFIX_CPUID: The CPU id. */
+    uint32_t        idCpu;
+    /** RTLOGFLAGS_PREFIX_CUSTOM: The length of the custom prefix. */
+    uint32_t        cchCustom;
+    /** RTLOGFLAGS_PREFIX_THREAD: The thread name. */
+    char            szThread[16];
+    /** RTLOGFLAGS_PREFIX_CUSTOM: The custom prefix. */
+    char            achCustom[32];
+} RTLOGASYNCREC;
+AssertCompileSize(RTLOGASYNCREC, 136);
+/** Pointer to a asynchronous log record header. */
+typedef RTLOGASYNCREC *PRTLOGASYNCREC;
+/** Pointer to a const asynchronous log record header. */
+typedef RTLOGASYNCREC const *PCRTLOGASYNCREC;
+/** The size of a record header without the caller context. */
+# define RTLOG_ASYNC_REC_MIN_SIZE   RT_OFFSETOF(RTLOGASYNCREC, u64NanoTS)
+
+/**
+ * A single producer, single consumer byte ring for asynchronous logging.
+ *
+ * Producers claim a ring by setting fBusy and own the write side until they
+ * clear it again.  The consumer side is owned by whoever holds the logger lock.
+ */
+typedef struct RTLOGASYNCRING
+{
+    /** Set while a producer owns the ring. */
+    bool volatile       fBusy;
+    /** Alignment padding. */
+    bool                afPadding[3];
+    /** The producer offset (free running). */
+    uint32_t volatile   offWrite;
+    /** Number of messages queued (producer statistics). */
+    uint64_t            cQueued;
+    /** Number of messages dropped because the ring was full. */
+    uint64_t            cDropped;
+    /** Pad the producer part to a cache line. */
+    uint8_t             abPadding1[64 - 24];
+    /** The consumer offset (free running). */
+    uint32_t volatile   offRead;
+    /** Pad the consumer part to a cache line. */
+    uint8_t             abPadding2[64 - 4];
+} RTLOGASYNCRING;
+AssertCompileSize(RTLOGASYNCRING, 128);
+/** Pointer to an asynchronous logging ring. */
+typedef RTLOGASYNCRING *PRTLOGASYNCRING;
+
+/**
+ * Asynchronous logging state, allocated when RTLOGFLAGS_ASYNC is first used.
+ *
+ * The ring buffers follow the structure.
+ */
+typedef struct RTLOGASYNC
+{
+    /** The producer rings. */
+    RTLOGASYNCRING      aRings[RTLOG_ASYNC_RINGS];
+    /** The next sequence number. */
+    uint64_t volatile   uSeqNext;
+    /** Number of messages taking the synchronous path (statistics). */
+    uint64_t volatile   cSynchronous;
+    /** Number of messages written out (protected by the logger lock). */
+    uint64_t            cWritten;
+    /** The drop count last reported in the log (protected by the logger lock). */
+    uint64_t            cDroppedReported;
+    /** The logger instance. */
+    PRTLOGGER           pLogger;
+    /** The writer thread. */
+    RTTHREAD            hThread;
+    /** Event semaphore the writer waits on when idle. */
+    RTSEMEVENT          hEvt;
+    /** Set when the writer is (about to go) waiting on hEvt. */
+    bool volatile       fWriterIdle;
+    /** Tells the writer to terminate. */
+    bool volatile       fShutdown;
+} RTLOGASYNC;
+/** Pointer to the asynchronous logging state. */
+typedef RTLOGASYNC *PRTLOGASYNC;
+
+/** The size of RTLOGASYNC rounded up so the rings following it are aligned. */
+# define RTLOG_ASYNC_HDR_SIZE       RT_ALIGN_Z(sizeof(RTLOGASYNC), 64)
+
+/** @name RTLOGGERINTERNAL::enmAsyncState values.
+ * @{ */
+# define RTLOGASYNCSTATE_NONE       UINT32_C(0)
+# define RTLOGASYNCSTATE_STARTING   UINT32_C(1)
+# define RTLOGASYNCSTATE_RUNNING    UINT32_C(2)
+# define RTLOGASYNCSTATE_FAILED     UINT32_C(3)
+/** @} */
+
+/**
+ * Arguments for rtlogAsyncOutput.
+ */
+typedef struct RTLOGASYNCOUTPUTARGS
+{
+    /** The ring buffer. */
+    uint8_t            *pbRing;
+    /** Where to write the next chunk (free running ring offset). */
+    uint32_t            off;
+    /** The space left in the ring. */
+    uint32_t            cbLeft;
+    /** The total length of the formatted message. */
+    size_t              cchTotal;
+    /** Set if the message didn't fit. */
+    bool                fOverflow;
+} RTLOGASYNCOUTPUTARGS;
+/** Pointer to rtlogAsyncOutput arguments. */
+typedef RTLOGASYNCOUTPUTARGS *PRTLOGASYNCOUTPUTARGS;
+#endif /* IN_RING3 */
+
 /**
  * Internal logger data.
  *
@@ -143,11 +301,22 @@ typedef struct RTLOGGERINTERNAL
     /** Pointer to filename. */
     char                    szFilename[RTPATH_MAX];
     /** @} */
+
+    /** @name Asynchronous logging (RTLOGFLAGS_ASYNC).
+     * @{ */
+    /** The asynchronous logging state, NULL until RTLOGFLAGS_ASYNC is used. */
+    PRTLOGASYNC volatile    pAsync;
+    /** The record being written out by rtlogAsyncDrainLocked, NULL otherwise.
+     * The prefix code takes the caller context from here when set. */
+    PCRTLOGASYNCREC         pAsyncRec;
+    /** RTLOGASYNCSTATE_XXX. */
+    uint32_t volatile       enmAsyncState;
+    /** @} */
 #endif /* IN_RING3 */
 } RTLOGGERINTERNAL;
 
 /** The revision of the internal logger structure. */
-#define RTLOGGERINTERNAL_REV    UINT32_C(9)
+#define RTLOGGERINTERNAL_REV    UINT32_C(10)
 
 #ifdef IN_RING3
 /** The size of the RTLOGGERINTERNAL structure in ring-0.  */
@@ -168,6 +337,10 @@ static void rtR0LogLoggerExFallback(uint32_t fDestFlags, uint32_t fFlags, const
 #ifdef IN_RING3
 static int rtlogFileOpen(PRTLOGGER pLogger, char *pszErrorMsg, size_t cchErrorMsg);
 static void rtlogRotate(PRTLOGGER pLogger, uint32_t uTimeSlot, bool fFirst);
+static bool rtlogAsyncQueue(PRTLOGGER pLogger, unsigned fFlags, unsigned iGroup, const char *pszFormat, va_list args);
+static void rtlogAsyncDrainLocked(PRTLOGGER pLogger);
+static PRTLOGASYNC rtlogAsyncStart(PRTLOGGER pLogger);
+static void rtlogAsyncStop(PRTLOGGER pLogger);
 #endif
 static void rtlogFlush(PRTLOGGER pLogger);
 static DECLCALLBACK(size_t) rtLogOutput(void *pv, const char *pachChars, size_t cbChars);
@@ -253,6 +426,7 @@ static struct
     { "writethru",    sizeof("writethru"   ) - 1,   RTLOGFLAGS_WRITE_THROUGH,       false },
     { "writethrough", sizeof("writethrough") - 1,   RTLOGFLAGS_WRITE_THROUGH,       false },
     { "flush",        sizeof("flush"       ) - 1,   RTLOGFLAGS_FLUSH,               false },
+    { "async",        sizeof("async"       ) - 1,   RTLOGFLAGS_ASYNC,               false },
     { "lockcnts",     sizeof("lockcnts"    ) - 1,   RTLOGFLAGS_PREFIX_LOCK_COUNTS,  false },
     { "cpuid",        sizeof("cpuid"       ) - 1,   RTLOGFLAGS_PREFIX_CPUID,        false },
     { "pid",          sizeof("pid"         ) - 1,   RTLOGFLAGS_PREFIX_PID,          false },
@@ -508,6 +682,9 @@ RTDECL(int) RTLogCreateExV(PRTLOGGER *ppLogger, uint32_t fFlags, const char *psz
             pLogger->pInt->cSecsHistoryTimeSlot = UINT32_MAX;
         else
             pLogger->pInt->cSecsHistoryTimeSlot = cSecsHistoryTimeSlot;
+        pLogger->pInt->pAsync                   = NULL;
+        pLogger->pInt->pAsyncRec                = NULL;
+        pLogger->pInt->enmAsyncState            = RTLOGASYNCSTATE_NONE;
 # endif  /* IN_RING3 */
         if (pszGroupSettings)
             RTLogGroupSettings(pLogger, pszGroupSettings);
@@ -648,6 +825,10 @@ RTDECL(int) RTLogCreateExV(PRTLOGGER *ppLogger, uint32_t fFlags, const char *psz
                     Assert(VALID_PTR(pLogger->pInt->pfnPhase) || pLogger->pInt->pfnPhase == NULL);
                     if (pLogger->pInt->pfnPhase)
                         pLogger->pInt->pfnPhase(pLogger, RTLOGPHASE_BEGIN, rtlogPhaseMsgNormal);
+
+                    /* Start the asynchronous writer now rather than on first use. */
+                    if (pLogger->fFlags & RTLOGFLAGS_ASYNC)
+                        rtlogAsyncStart(pLogger);
 # endif
                     *ppLogger = pLogger;
                     return VINF_SUCCESS;
@@ -734,6 +915,13 @@ RTDECL(int) RTLogDestroy(PRTLOGGER pLogger)
     AssertReturn(pLogger->u32Magic == RTLOGGER_MAGIC, VERR_INVALID_MAGIC);
     AssertPtrReturn(pLogger->pInt, VERR_INVALID_POINTER);
 
+# ifdef IN_RING3
+    /*
+     * Stop the asynchronous writer, we'll write out what's left below.
+     */
+    rtlogAsyncStop(pLogger);
+# endif
+
     /*
      * Acquire logger instance sem and disable all logging. (paranoia)
      */
@@ -748,6 +936,9 @@ RTDECL(int) RTLogDestroy(PRTLOGGER pLogger)
     /*
      * Flush it.
      */
+# ifdef IN_RING3
+    rtlogAsyncDrainLocked(pLogger);
+# endif
     rtlogFlush(pLogger);
 
 # ifdef IN_RING3
@@ -755,7 +946,8 @@ RTDECL(int) RTLogDestroy(PRTLOGGER pLogger)
      * Add end of logging message.
      */
     if (   (pLogger->fDestFlags & RTLOGDEST_FILE)
-        && pLogger->pInt->hFile != NIL_RTFILE)
+        && pLogger->pInt->hFile != NIL_RTFILE
+        && pLogger->pInt->pfnPhase)
         pLogger->pInt->pfnPhase(pLogger, RTLOGPHASE_END, rtlogPhaseMsgLocked);
 
     /*
@@ -769,6 +961,14 @@ RTDECL(int) RTLogDestroy(PRTLOGGER pLogger)
             rc = rc2;
         pLogger->pInt->hFile = NIL_RTFILE;
     }
+
+    if (pLogger->pInt->pAsync)
+    {
+        int rc2 = RTSemEventDestroy(pLogger->pInt->pAsync->hEvt);
+        AssertRC(rc2);
+        RTMemFree(pLogger->pInt->pAsync);
+        pLogger->pInt->pAsync = NULL;
+    }
 # endif
 
     /*
@@ -1726,6 +1926,14 @@ RTDECL(int) RTLogFlags(PRTLOGGER pLogger, const char *pszValue)
             pszValue++;
     } /* while more environment variable value left */
 
+#ifdef IN_RING3
+    /* Start the writer right away if the logger is fully set up, RTLogCreateExV does it otherwise. */
+    if (   (pLogger->fFlags & RTLOGFLAGS_ASYNC)
+        && pLogger->pInt->hSpinMtx != NIL_RTSEMSPINMUTEX
+        && !pLogger->pInt->pAsync)
+        rtlogAsyncStart(pLogger);
+#endif
+
     return rc;
 }
 RT_EXPORT_SYMBOL(RTLogFlags);
@@ -2114,6 +2322,57 @@ RTDECL(int) RTLogGetDestinations(PRTLOGGER pLogger, char *pszBuf, size_t cchBuf)
 }
 RT_EXPORT_SYMBOL(RTLogGetDestinations);
 
+
+/**
+ * Queries the asynchronous logging statistics of a logger.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_NOT_SUPPORTED if not in ring-3.
+ * @param   pLogger             Logger instance (NULL for default logger).
+ * @param   pStats              Where to return the statistics.
+ */
+RTDECL(int) RTLogQueryAsyncStats(PRTLOGGER pLogger, PRTLOGASYNCSTATS pStats)
+{
+    AssertPtrReturn(pStats, VERR_INVALID_POINTER);
+    pStats->cQueued      = 0;
+    pStats->cWritten     = 0;
+    pStats->cDropped     = 0;
+    pStats->cSynchronous = 0;
+
+# ifdef IN_RING3
+    /*
+     * Resolve defaults.
+     */
+    if (!pLogger)
+    {
+        pLogger = RTLogDefaultInstance();
+        if (!pLogger)
+            return VINF_SUCCESS;
+    }
+
+    /*
+     * Sum up the ring counters.  The numbers are only a snapshot while
+     * producers are active.
+     */
+    PRTLOGASYNC pAsync = ASMAtomicReadPtrT(&pLogger->pInt->pAsync, PRTLOGASYNC);
+    if (pAsync)
+    {
+        for (uint32_t iRing = 0; iRing < RTLOG_ASYNC_RINGS; iRing++)
+        {
+            pStats->cQueued  += ASMAtomicUoReadU64(&pAsync->aRings[iRing].cQueued);
+            pStats->cDropped += ASMAtomicUoReadU64(&pAsync->aRings[iRing].cDropped);
+        }
+        pStats->cWritten     = ASMAtomicUoReadU64(&pAsync->cWritten);
+        pStats->cSynchronous = ASMAtomicUoReadU64(&pAsync->cSynchronous);
+    }
+    return VINF_SUCCESS;
+# else
+    NOREF(pLogger);
+    return VERR_NOT_SUPPORTED;
+# endif
+}
+RT_EXPORT_SYMBOL(RTLogQueryAsyncStats);
+
 #endif /* !IN_RC */
 
 /**
@@ -2142,7 +2401,11 @@ RTDECL(void) RTLogFlush(PRTLOGGER pLogger)
     /*
      * Any thing to flush?
      */
-    if (pLogger->offScratch)
+    if (   pLogger->offScratch
+#ifdef IN_RING3
+        || pLogger->pInt->pAsync
+#endif
+       )
     {
 #ifndef IN_RC
         /*
@@ -2155,6 +2418,9 @@ RTDECL(void) RTLogFlush(PRTLOGGER pLogger)
         /*
          * Call worker.
          */
+#ifdef IN_RING3
+        rtlogAsyncDrainLocked(pLogger);
+#endif
         rtlogFlush(pLogger);
 
 #ifndef IN_RC
@@ -2399,6 +2665,15 @@ RTDECL(void) RTLogLoggerExV(PRTLOGGER pLogger, unsigned fFlags, unsigned iGroup,
         &&  (pLogger->afGroups[iGroup] & (fFlags | RTLOGGRPFLAGS_ENABLED)) != (fFlags | RTLOGGRPFLAGS_ENABLED))
         return;
 
+#ifdef IN_RING3
+    /*
+     * Hand it to the writer thread in asynchronous mode.
+     */
+    if (    (pLogger->fFlags & RTLOGFLAGS_ASYNC)
+        &&  rtlogAsyncQueue(pLogger, fFlags, iGroup, pszFormat, args))
+        return;
+#endif
+
     /*
      * Acquire logger instance sem.
      */
@@ -2412,6 +2687,14 @@ RTDECL(void) RTLogLoggerExV(PRTLOGGER pLogger, unsigned fFlags, unsigned iGroup,
         return;
     }
 
+#ifdef IN_RING3
+    /*
+     * Write out anything queued before, so messages from this thread stay in order.
+     */
+    if (pLogger->pInt->pAsync)
+        rtlogAsyncDrainLocked(pLogger);
+#endif
+
     /*
      * Check restrictions and call worker.
      */
@@ -2808,6 +3091,481 @@ static void rtlogRotate(PRTLOGGER pLogger, uint32_t uTimeSlot, bool fFirst)
     pLogger->fFlags          = fSavedFlags;
 }
 
+/**
+ * Gets the buffer of an asynchronous logging ring.
+ *
+ * @returns Pointer to the ring buffer.
+ * @param   pAsync      The asynchronous logging state.
+ * @param   iRing       The ring index.
+ */
+DECLINLINE(uint8_t *) rtlogAsyncRingBuf(PRTLOGASYNC pAsync, uint32_t iRing)
+{
+    return (uint8_t *)pAsync + RTLOG_ASYNC_HDR_SIZE + (size_t)iRing * RTLOG_ASYNC_RING_SIZE;
+}
+
+
+/**
+ * Copies data into a ring buffer, wrapping around at the end.
+ *
+ * @param   pbRing      The ring buffer.
+ * @param   off         The free running ring offset to write at.
+ * @param   pv          The data.
+ * @param   cb          The number of bytes to copy.
+ */
+DECLINLINE(void) rtlogAsyncRingWrite(uint8_t *pbRing, uint32_t off, const void *pv, size_t cb)
+{
+    uint32_t const offBuf  = off & (RTLOG_ASYNC_RING_SIZE - 1);
+    size_t const   cbFirst = RT_MIN(cb, RTLOG_ASYNC_RING_SIZE - offBuf);
+    memcpy(&pbRing[offBuf], pv, cbFirst);
+    if (cbFirst < cb)
+        memcpy(pbRing, (uint8_t const *)pv + cbFirst, cb - cbFirst);
+}
+
+
+/**
+ * Copies data out of a ring buffer, wrapping around at the end.
+ *
+ * @param   pbRing      The ring buffer.
+ * @param   off         The free running ring offset to read at.
+ * @param   pv          Where to put the data.
+ * @param   cb          The number of bytes to copy.
+ */
+DECLINLINE(void) rtlogAsyncRingRead(uint8_t const *pbRing, uint32_t off, void *pv, size_t cb)
+{
+    uint32_t const offBuf  = off & (RTLOG_ASYNC_RING_SIZE - 1);
+    size_t const   cbFirst = RT_MIN(cb, RTLOG_ASYNC_RING_SIZE - offBuf);
+    memcpy(pv, &pbRing[offBuf], cbFirst);
+    if (cbFirst < cb)
+        memcpy((uint8_t *)pv + cbFirst, pbRing, cb - cbFirst);
+}
+
+
+/**
+ * Checks whether any of the rings has records waiting for the writer.
+ *
+ * @returns true if there is something to write, false if not.
+ * @param   pAsync      The asynchronous logging state.
+ */
+static bool rtlogAsyncHasPending(PRTLOGASYNC pAsync)
+{
+    for (uint32_t iRing = 0; iRing < RTLOG_ASYNC_RINGS; iRing++)
+        if (ASMAtomicReadU32(&pAsync->aRings[iRing].offWrite) != pAsync->aRings[iRing].offRead)
+            return true;
+    return false;
+}
+
+
+/**
+ * Writes out the records queued by rtlogAsyncQueue.
+ *
+ * The records are merged from the rings in sequence order and fed thru the
+ * normal output callbacks with RTLOGGERINTERNAL::pAsyncRec pointing to the
+ * record header, so the prefixes come out as if the message had been logged
+ * synchronously.  The caller flushes the scratch buffer.
+ *
+ * @param   pLogger     The logger instance, caller owns the lock.
+ */
+static void rtlogAsyncDrainLocked(PRTLOGGER pLogger)
+{
+    PRTLOGASYNC pAsync = pLogger->pInt->pAsync;
+    if (!pAsync)
+        return;
+
+    /*
+     * Take a snapshot of the write offsets so busy producers cannot keep us
+     * here forever, and peek at the sequence number of each ring head.
+     */
+    uint32_t aoffEnd[RTLOG_ASYNC_RINGS];
+    uint64_t auSeqHead[RTLOG_ASYNC_RINGS];
+    for (uint32_t iRing = 0; iRing < RTLOG_ASYNC_RINGS; iRing++)
+    {
+        PRTLOGASYNCRING pRing = &pAsync->aRings[iRing];
+        aoffEnd[iRing] = ASMAtomicReadU32(&pRing->offWrite);
+        if (aoffEnd[iRing] != pRing->offRead)
+            rtlogAsyncRingRead(rtlogAsyncRingBuf(pAsync, iRing), pRing->offRead + RT_OFFSETOF(RTLOGASYNCREC, uSeq),
+                               &auSeqHead[iRing], sizeof(auSeqHead[iRing]));
+        else
+            auSeqHead[iRing] = UINT64_MAX;
+    }
+
+    for (;;)
+    {
+        /* The oldest record goes first. */
+        uint32_t iRing = UINT32_MAX;
+        uint64_t uSeq  = UINT64_MAX;
+        for (uint32_t i = 0; i < RTLOG_ASYNC_RINGS; i++)
+            if (auSeqHead[i] < uSeq)
+            {
+                uSeq  = auSeqHead[i];
+                iRing = i;
+            }
+        if (iRing == UINT32_MAX)
+            break;
+
+        PRTLOGASYNCRING pRing  = &pAsync->aRings[iRing];
+        uint8_t        *pbRing = rtlogAsyncRingBuf(pAsync, iRing);
+        uint32_t        offRead = pRing->offRead;
+        RTLOGASYNCREC   Rec;
+        RT_ZERO(Rec);
+        rtlogAsyncRingRead(pbRing, offRead, &Rec, RTLOG_ASYNC_REC_MIN_SIZE);
+        if (Rec.cbHdr > RTLOG_ASYNC_REC_MIN_SIZE)
+            rtlogAsyncRingRead(pbRing, offRead + RTLOG_ASYNC_REC_MIN_SIZE, (uint8_t *)&Rec + RTLOG_ASYNC_REC_MIN_SIZE,
+                               sizeof(Rec) - RTLOG_ASYNC_REC_MIN_SIZE);
+        Assert(Rec.cbRec >= Rec.cbHdr + Rec.cchBody && Rec.cbRec <= aoffEnd[iRing] - offRead);
+
+        /* The text may wrap around, so it's written in up to two chunks. */
+        uint32_t const offBody = (offRead + Rec.cbHdr) & (RTLOG_ASYNC_RING_SIZE - 1);
+        size_t const   cchFirst = RT_MIN(Rec.cchBody, RTLOG_ASYNC_RING_SIZE - offBody);
+        pLogger->pInt->pAsyncRec = &Rec;
+        if (pLogger->fFlags & (RTLOGFLAGS_PREFIX_MASK | RTLOGFLAGS_USECRLF))
+        {
+            RTLOGOUTPUTPREFIXEDARGS OutputArgs;
+            OutputArgs.pLogger = pLogger;
+            OutputArgs.iGroup  = Rec.iGroup;
+            OutputArgs.fFlags  = Rec.fFlags;
+            rtLogOutputPrefixed(&OutputArgs, (const char *)&pbRing[offBody], cchFirst);
+            if (cchFirst < Rec.cchBody)
+                rtLogOutputPrefixed(&OutputArgs, (const char *)pbRing, Rec.cchBody - cchFirst);
+        }
+        else
+        {
+            rtLogOutput(pLogger, (const char *)&pbRing[offBody], cchFirst);
+            if (cchFirst < Rec.cchBody)
+                rtLogOutput(pLogger, (const char *)pbRing, Rec.cchBody - cchFirst);
+        }
+        pLogger->pInt->pAsyncRec = NULL;
+        pAsync->cWritten++;
+
+        /* Hand the space back to the producers and peek at the next record. */
+        offRead += Rec.cbRec;
+        ASMAtomicWriteU32(&pRing->offRead, offRead);
+        if (offRead != aoffEnd[iRing])
+            rtlogAsyncRingRead(pbRing, offRead + RT_OFFSETOF(RTLOGASYNCREC, uSeq), &auSeqHead[iRing], sizeof(auSeqHead[iRing]));
+        else
+            auSeqHead[iRing] = UINT64_MAX;
+    }
+
+    /*
+     * Tell the reader of the log that something is missing.
+     */
+    uint64_t cDropped = 0;
+    for (uint32_t iRing = 0; iRing < RTLOG_ASYNC_RINGS; iRing++)
+        cDropped += ASMAtomicUoReadU64(&pAsync->aRings[iRing].cDropped);
+    if (cDropped != pAsync->cDroppedReported)
+    {
+        rtlogLoggerExFLocked(pLogger, 0, ~0U, "*** %RU64 log messages dropped, asynchronous logging buffer full ***\n",
+                             cDropped - pAsync->cDroppedReported);
+        pAsync->cDroppedReported = cDropped;
+    }
+}
+
+
+/**
+ * The asynchronous log writer thread.
+ *
+ * @returns VINF_SUCCESS.
+ * @param   hThreadSelf The thread handle.
+ * @param   pvUser      The asynchronous logging state.
+ */
+static DECLCALLBACK(int) rtlogAsyncWriterThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    PRTLOGASYNC pAsync  = (PRTLOGASYNC)pvUser;
+    PRTLOGGER   pLogger = pAsync->pLogger;
+    NOREF(hThreadSelf);
+
+    while (!ASMAtomicReadBool(&pAsync->fShutdown))
+    {
+        if (rtlogAsyncHasPending(pAsync))
+        {
+            /* Writing, flushing and rotating all happens here instead of on the producer threads. */
+            if (RT_SUCCESS(rtlogLock(pLogger)))
+            {
+                rtlogAsyncDrainLocked(pLogger);
+                if (!(pLogger->fFlags & RTLOGFLAGS_BUFFERED))
+                    rtlogFlush(pLogger);
+                rtlogUnlock(pLogger);
+            }
+            continue;
+        }
+
+        /*
+         * Idle.  Producers check fWriterIdle after publishing a record, so
+         * recheck the rings after setting it to not miss a wakeup.
+         */
+        ASMAtomicWriteBool(&pAsync->fWriterIdle, true);
+        if (   !rtlogAsyncHasPending(pAsync)
+            && !ASMAtomicReadBool(&pAsync->fShutdown))
+            RTSemEventWait(pAsync->hEvt, RT_INDEFINITE_WAIT);
+        ASMAtomicWriteBool(&pAsync->fWriterIdle, false);
+    }
+
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Sets up the asynchronous logging state and starts the writer thread.
+ *
+ * @returns The asynchronous logging state, NULL if not (yet) available.
+ * @param   pLogger     The logger instance.
+ */
+static PRTLOGASYNC rtlogAsyncStart(PRTLOGGER pLogger)
+{
+    PRTLOGGERINTERNAL pInt = pLogger->pInt;
+    if (!ASMAtomicCmpXchgU32(&pInt->enmAsyncState, RTLOGASYNCSTATE_STARTING, RTLOGASYNCSTATE_NONE))
+        return ASMAtomicReadPtrT(&pInt->pAsync, PRTLOGASYNC);
+
+    PRTLOGASYNC pAsync = (PRTLOGASYNC)RTMemAllocZ(RTLOG_ASYNC_HDR_SIZE + RTLOG_ASYNC_RINGS * RTLOG_ASYNC_RING_SIZE);
+    if (pAsync)
+    {
+        pAsync->pLogger = pLogger;
+        pAsync->hThread = NIL_RTTHREAD;
+        int rc = RTSemEventCreate(&pAsync->hEvt);
+        if (RT_SUCCESS(rc))
+        {
+            rc = RTThreadCreate(&pAsync->hThread, rtlogAsyncWriterThread, pAsync, 0 /*cbStack*/,
+                                RTTHREADTYPE_IO, RTTHREADFLAGS_WAITABLE, "LogWriter");
+            if (RT_SUCCESS(rc))
+            {
+                ASMAtomicWritePtr(&pInt->pAsync, pAsync);
+                ASMAtomicWriteU32(&pInt->enmAsyncState, RTLOGASYNCSTATE_RUNNING);
+                return pAsync;
+            }
+            RTSemEventDestroy(pAsync->hEvt);
+        }
+        RTMemFree(pAsync);
+    }
+    ASMAtomicWriteU32(&pInt->enmAsyncState, RTLOGASYNCSTATE_FAILED);
+    return NULL;
+}
+
+
+/**
+ * Stops the asynchronous writer thread, if running.
+ *
+ * The queued records are left for the caller to write out.
+ *
+ * @param   pLogger     The logger instance.
+ */
+static void rtlogAsyncStop(PRTLOGGER pLogger)
+{
+    PRTLOGASYNC pAsync = pLogger->pInt->pAsync;
+    if (pAsync && pAsync->hThread != NIL_RTTHREAD)
+    {
+        ASMAtomicWriteBool(&pAsync->fShutdown, true);
+        RTSemEventSignal(pAsync->hEvt);
+        int rc = RTThreadWait(pAsync->hThread, RT_INDEFINITE_WAIT, NULL);
+        AssertRC(rc);
+        pAsync->hThread = NIL_RTTHREAD;
+    }
+}
+
+
+/**
+ * Callback for RTLogFormatV which writes the message text into a ring.
+ *
+ * See PFNLOGOUTPUT() for details.
+ */
+static DECLCALLBACK(size_t) rtlogAsyncOutput(void *pv, const char *pachChars, size_t cbChars)
+{
+    PRTLOGASYNCOUTPUTARGS pArgs = (PRTLOGASYNCOUTPUTARGS)pv;
+    if (cbChars)
+    {
+        if (!pArgs->fOverflow && cbChars <= pArgs->cbLeft)
+        {
+            rtlogAsyncRingWrite(pArgs->pbRing, pArgs->off, pachChars, cbChars);
+            pArgs->off    += (uint32_t)cbChars;
+            pArgs->cbLeft -= (uint32_t)cbChars;
+        }
+        else
+            pArgs->fOverflow = true;
+        pArgs->cchTotal += cbChars;
+    }
+    return cbChars;
+}
+
+
+/**
+ * Captures the caller context needed by the prefixes currently enabled.
+ *
+ * @returns The record header size to use.
+ * @param   pLogger     The logger instance.
+ * @param   pRec        The record header to fill in.
+ * @param   hNativeSelf The native handle of the calling thread.
+ */
+static uint32_t rtlogAsyncCaptureContext(PRTLOGGER pLogger, PRTLOGASYNCREC pRec, RTNATIVETHREAD hNativeSelf)
+{
+    uint32_t const fLogFlags = pLogger->fFlags;
+    if (!(fLogFlags & RTLOGFLAGS_PREFIX_MASK))
+        return RTLOG_ASYNC_REC_MIN_SIZE;
+
+    if (fLogFlags & RTLOGFLAGS_PREFIX_TS)
+        pRec->u64NanoTS = RTTimeNanoTS();
+    if (fLogFlags & RTLOGFLAGS_PREFIX_TSC)
+#if defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)
+        pRec->u64Tsc = ASMReadTSC();
+#else
+        pRec->u64Tsc = RTTimeNanoTS();
+#endif
+    if (fLogFlags & (RTLOGFLAGS_PREFIX_MS_PROG | RTLOGFLAGS_PREFIX_TIME_PROG))
+        pRec->u64ProgMicroTS = RTTimeProgramMicroTS();
+    if (fLogFlags & RTLOGFLAGS_PREFIX_TIME)
+        RTTimeNow(&pRec->Now);
+    pRec->u64NativeThread = (uintptr_t)hNativeSelf;
+    if (fLogFlags & RTLOGFLAGS_PREFIX_THREAD)
+    {
+        const char *pszName = RTThreadSelfName();
+        if (pszName)
+            RTStrCopy(pRec->szThread, sizeof(pRec->szThread), pszName);
+    }
+    if (fLogFlags & RTLOGFLAGS_PREFIX_CPUID)
+#if defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)
+        pRec->idCpu = ASMGetApicId();
+#else
+        pRec->idCpu = RTMpCpuId();
+#endif
+    if (   (fLogFlags & RTLOGFLAGS_PREFIX_CUSTOM)
+        && pLogger->pInt->pfnPrefix)
+        pRec->cchCustom = (uint32_t)RT_MIN(pLogger->pInt->pfnPrefix(pLogger, pRec->achCustom, sizeof(pRec->achCustom) - 1,
+                                                                    pLogger->pInt->pvPrefixUserArg),
+                                           sizeof(pRec->achCustom) - 1);
+    if (fLogFlags & RTLOGFLAGS_PREFIX_LOCK_COUNTS)
+    {
+        /* The caller doesn't own the logger lock here, so no g_cLoggerLockCount adjusting. */
+        RTTHREAD hThread = RTThreadSelf();
+        if (hThread != NIL_RTTHREAD)
+        {
+            pRec->cReadLocks  = RTLockValidatorReadLockGetCount(hThread);
+            pRec->cWriteLocks = RTLockValidatorWriteLockGetCount(hThread);
+        }
+        else
+            pRec->cReadLocks  = UINT32_MAX;
+    }
+    return sizeof(*pRec);
+}
+
+
+/**
+ * Queues a message for the asynchronous writer (RTLOGFLAGS_ASYNC).
+ *
+ * The message is formatted on the calling thread straight into a ring picked
+ * by hashing the native thread handle, without taking the logger lock.  When
+ * the ring is full the message is dropped and counted.
+ *
+ * @returns true if queued or dropped, false if the caller should log the
+ *          message synchronously.
+ * @param   pLogger     The logger instance.
+ * @param   fFlags      The logging flags.
+ * @param   iGroup      The group.
+ * @param   pszFormat   Format string.
+ * @param   args        Format arguments, not consumed.
+ */
+static bool rtlogAsyncQueue(PRTLOGGER pLogger, unsigned fFlags, unsigned iGroup, const char *pszFormat, va_list args)
+{
+    PRTLOGGERINTERNAL pInt = pLogger->pInt;
+
+    /* The per group entry counters are protected by the logger lock. */
+    if (RT_UNLIKELY(   (pLogger->fFlags & RTLOGFLAGS_RESTRICT_GROUPS)
+                    && iGroup < pLogger->cGroups
+                    && (pLogger->afGroups[iGroup] & RTLOGGRPFLAGS_RESTRICT)))
+        return false;
+
+    PRTLOGASYNC pAsync = ASMAtomicReadPtrT(&pInt->pAsync, PRTLOGASYNC);
+    if (RT_UNLIKELY(!pAsync))
+    {
+        pAsync = rtlogAsyncStart(pLogger);
+        if (!pAsync)
+            return false;
+    }
+
+    /*
+     * Claim a ring, starting with the one this thread hashes to.
+     */
+    RTNATIVETHREAD const hNativeSelf = RTThreadNativeSelf();
+    uint64_t const       uHash       = (uint64_t)(uintptr_t)hNativeSelf * UINT64_C(0x9e3779b97f4a7c15);
+    uint32_t             iRing       = (uint32_t)(uHash >> 32);
+    PRTLOGASYNCRING      pRing       = NULL;
+    for (uint32_t i = 0; i < RTLOG_ASYNC_RINGS; i++, iRing++)
+    {
+        PRTLOGASYNCRING pCur = &pAsync->aRings[iRing & (RTLOG_ASYNC_RINGS - 1)];
+        if (   !ASMAtomicUoReadBool(&pCur->fBusy)
+            && ASMAtomicCmpXchgBool(&pCur->fBusy, true, false))
+        {
+            pRing = pCur;
+            break;
+        }
+    }
+    if (RT_UNLIKELY(!pRing))
+    {
+        ASMAtomicIncU64(&pAsync->cSynchronous);
+        return false;
+    }
+    iRing &= RTLOG_ASYNC_RINGS - 1;
+
+    /*
+     * Capture the context and format the text right behind the header.
+     */
+    RTLOGASYNCREC Rec;
+    RT_ZERO(Rec);
+    Rec.uSeq   = ASMAtomicIncU64(&pAsync->uSeqNext);
+    Rec.fFlags = fFlags;
+    Rec.iGroup = iGroup;
+    Rec.cbHdr  = rtlogAsyncCaptureContext(pLogger, &Rec, hNativeSelf);
+
+    uint32_t const offWrite = pRing->offWrite;
+    uint32_t const cbFree   = (RTLOG_ASYNC_RING_SIZE - (offWrite - ASMAtomicReadU32(&pRing->offRead))) & ~(uint32_t)7;
+    bool           fQueued  = false;
+    bool           fNearlyFull = true;
+    if (cbFree > Rec.cbHdr)
+    {
+        RTLOGASYNCOUTPUTARGS OutputArgs;
+        OutputArgs.pbRing    = rtlogAsyncRingBuf(pAsync, iRing);
+        OutputArgs.off       = offWrite + Rec.cbHdr;
+        OutputArgs.cbLeft    = cbFree - Rec.cbHdr;
+        OutputArgs.cchTotal  = 0;
+        OutputArgs.fOverflow = false;
+        va_list va;
+        va_copy(va, args);
+        RTLogFormatV(rtlogAsyncOutput, &OutputArgs, pszFormat, va);
+        va_end(va);
+
+        if (!OutputArgs.fOverflow)
+        {
+            Rec.cchBody = (uint32_t)OutputArgs.cchTotal;
+            Rec.cbRec   = RT_ALIGN_32(Rec.cbHdr + Rec.cchBody, 8);
+            rtlogAsyncRingWrite(OutputArgs.pbRing, offWrite, &Rec, Rec.cbHdr);
+            ASMAtomicWriteU32(&pRing->offWrite, offWrite + Rec.cbRec);
+            ASMAtomicUoWriteU64(&pRing->cQueued, pRing->cQueued + 1);
+            fQueued     = true;
+            fNearlyFull = cbFree - Rec.cbRec < RTLOG_ASYNC_RING_SIZE / 4;
+        }
+        else if (OutputArgs.cchTotal > RTLOG_ASYNC_MAX_RECORD)
+        {
+            /* Would never fit, do it the slow way. */
+            ASMAtomicWriteBool(&pRing->fBusy, false);
+            ASMAtomicIncU64(&pAsync->cSynchronous);
+            return false;
+        }
+    }
+    if (!fQueued)
+        ASMAtomicUoWriteU64(&pRing->cDropped, pRing->cDropped + 1);
+    ASMAtomicWriteBool(&pRing->fBusy, false);
+
+    /*
+     * Wake up the writer if it's waiting.  When the ring is (nearly) full,
+     * also give up the CPU so the writer gets a chance to catch up before
+     * we start dropping, this matters when there are fewer CPUs than busy
+     * producers.
+     */
+    if (   ASMAtomicReadBool(&pAsync->fWriterIdle)
+        && ASMAtomicCmpXchgBool(&pAsync->fWriterIdle, false, true))
+        RTSemEventSignal(pAsync->hEvt);
+    if (fNearlyFull)
+        RTThreadYield();
+    return true;
+}
+
+
 #endif /* IN_RING3 */
 
 /**
@@ -3034,9 +3792,16 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                  * psz is pointing to the current position.
                  */
                 psz = &pLogger->achScratch[pLogger->offScratch];
+#ifdef IN_RING3
+                /* Messages queued by rtlogAsyncQueue carry the caller context. */
+                PCRTLOGASYNCREC const pRec = pLogger->pInt->pAsyncRec;
+# define RTLOG_PREFIX_CTX(a_Member, a_Expr)     (pRec ? pRec->a_Member : (a_Expr))
+#else
+# define RTLOG_PREFIX_CTX(a_Member, a_Expr)     (a_Expr)
+#endif
                 if (pLogger->fFlags & RTLOGFLAGS_PREFIX_TS)
                 {
-                    uint64_t     u64    = RTTimeNanoTS();
+                    uint64_t     u64    = RTLOG_PREFIX_CTX(u64NanoTS, RTTimeNanoTS());
                     int          iBase  = 16;
                     unsigned int fFlags = RTSTR_F_ZEROPAD;
                     if (pLogger->fFlags & RTLOGFLAGS_DECIMAL_TS)
@@ -3063,9 +3828,9 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                 if (pLogger->fFlags & RTLOGFLAGS_PREFIX_TSC)
                 {
 #if defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)
-                    uint64_t     u64    = ASMReadTSC();
+                    uint64_t     u64    = RTLOG_PREFIX_CTX(u64Tsc, ASMReadTSC());
 #else
-                    uint64_t     u64    = RTTimeNanoTS();
+                    uint64_t     u64    = RTLOG_PREFIX_CTX(u64Tsc, RTTimeNanoTS());
 #endif
                     int          iBase  = 16;
                     unsigned int fFlags = RTSTR_F_ZEROPAD;
@@ -3093,7 +3858,7 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                 if (pLogger->fFlags & RTLOGFLAGS_PREFIX_MS_PROG)
                 {
 #if defined(IN_RING3) || defined(IN_RC)
-                    uint64_t u64 = RTTimeProgramMilliTS();
+                    uint64_t u64 = RTLOG_PREFIX_CTX(u64ProgMicroTS / RT_US_1MS, RTTimeProgramMilliTS());
 #else
                     uint64_t u64 = 0;
 #endif
@@ -3108,7 +3873,13 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
 #if defined(IN_RING3) || defined(IN_RING0)
                     RTTIMESPEC TimeSpec;
                     RTTIME Time;
-                    RTTimeExplode(&Time, RTTimeNow(&TimeSpec));
+# ifdef IN_RING3
+                    if (pRec)
+                        TimeSpec = pRec->Now;
+                    else
+# endif
+                        RTTimeNow(&TimeSpec);
+                    RTTimeExplode(&Time, &TimeSpec);
                     psz += RTStrFormatNumber(psz, Time.u8Hour, 10, 2, 0, RTSTR_F_ZEROPAD);
                     *psz++ = ':';
                     psz += RTStrFormatNumber(psz, Time.u8Minute, 10, 2, 0, RTSTR_F_ZEROPAD);
@@ -3128,7 +3899,7 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                 {
 
 #if defined(IN_RING3) || defined(IN_RC)
-                    uint64_t u64 = RTTimeProgramMicroTS();
+                    uint64_t u64 = RTLOG_PREFIX_CTX(u64ProgMicroTS, RTTimeProgramMicroTS());
                     psz += RTStrFormatNumber(psz, (uint32_t)(u64 / RT_US_1HOUR), 10, 2, 0, RTSTR_F_ZEROPAD);
                     *psz++ = ':';
                     uint32_t u32 = (uint32_t)(u64 % RT_US_1HOUR);
@@ -3178,7 +3949,7 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                 if (pLogger->fFlags & RTLOGFLAGS_PREFIX_TID)
                 {
 #ifndef IN_RC
-                    RTNATIVETHREAD Thread = RTThreadNativeSelf();
+                    RTNATIVETHREAD Thread = (RTNATIVETHREAD)RTLOG_PREFIX_CTX(u64NativeThread, RTThreadNativeSelf());
 #else
                     RTNATIVETHREAD Thread = NIL_RTNATIVETHREAD;
 #endif
@@ -3190,7 +3961,7 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                 if (pLogger->fFlags & RTLOGFLAGS_PREFIX_THREAD)
                 {
 #ifdef IN_RING3
-                    const char *pszName = RTThreadSelfName();
+                    const char *pszName = RTLOG_PREFIX_CTX(szThread, RTThreadSelfName());
 #elif defined IN_RC
                     const char *pszName = "EMT-RC";
 #else
@@ -3203,9 +3974,9 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                 if (pLogger->fFlags & RTLOGFLAGS_PREFIX_CPUID)
                 {
 #if defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)
-                    const uint8_t idCpu = ASMGetApicId();
+                    const uint8_t idCpu = (uint8_t)RTLOG_PREFIX_CTX(idCpu, ASMGetApicId());
 #else
-                    const RTCPUID idCpu = RTMpCpuId();
+                    const RTCPUID idCpu = (RTCPUID)RTLOG_PREFIX_CTX(idCpu, RTMpCpuId());
 #endif
                     psz += RTStrFormatNumber(psz, idCpu, 16, sizeof(idCpu) * 2, 0, RTSTR_F_ZEROPAD);
                     *psz++ = ' ';
@@ -3216,7 +3987,15 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                 if (    (pLogger->fFlags & RTLOGFLAGS_PREFIX_CUSTOM)
                     &&  pLogger->pInt->pfnPrefix)
                 {
-                    psz += pLogger->pInt->pfnPrefix(pLogger, psz, 31, pLogger->pInt->pvPrefixUserArg);
+# ifdef IN_RING3
+                    if (pRec)
+                    {
+                        memcpy(psz, pRec->achCustom, pRec->cchCustom);
+                        psz += pRec->cchCustom;
+                    }
+                    else
+# endif
+                        psz += pLogger->pInt->pfnPrefix(pLogger, psz, 31, pLogger->pInt->pvPrefixUserArg);
                     *psz++ = ' ';                                                               /* +32 */
                 }
 #endif
@@ -3225,11 +4004,11 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
                 if (pLogger->fFlags & RTLOGFLAGS_PREFIX_LOCK_COUNTS)
                 {
 #ifdef IN_RING3 /** @todo implement these counters in ring-0 too? */
-                    RTTHREAD Thread = RTThreadSelf();
-                    if (Thread != NIL_RTTHREAD)
+                    RTTHREAD Thread = pRec ? NIL_RTTHREAD : RTThreadSelf();
+                    if (pRec ? pRec->cReadLocks != UINT32_MAX : Thread != NIL_RTTHREAD)
                     {
-                        uint32_t cReadLocks  = RTLockValidatorReadLockGetCount(Thread);
-                        uint32_t cWriteLocks = RTLockValidatorWriteLockGetCount(Thread) - g_cLoggerLockCount;
+                        uint32_t cReadLocks  = RTLOG_PREFIX_CTX(cReadLocks,  RTLockValidatorReadLockGetCount(Thread));
+                        uint32_t cWriteLocks = RTLOG_PREFIX_CTX(cWriteLocks, RTLockValidatorWriteLockGetCount(Thread) - g_cLoggerLockCount);
                         cReadLocks  = RT_MIN(0xfff, cReadLocks);
                         cWriteLocks = RT_MIN(0xfff, cWriteLocks);
                         psz += RTStrFormatNumber(psz, cReadLocks,  16, 1, 0, RTSTR_F_ZEROPAD);
@@ -3315,6 +4094,7 @@ static DECLCALLBACK(size_t) rtLogOutputPrefixed(void *pv, const char *pachChars,
 
 #define CCH_PREFIX      ( CCH_PREFIX_16 )
                 { AssertCompile(CCH_PREFIX < 256); }
+#undef RTLOG_PREFIX_CTX
 
                 /*
                  * Done, figure what we've used and advance the buffer and free size.
@@ -0,0 +1,77 @@
+/* $Id: RTMemFirstNonZero-avx2.cpp $ */
+/** @file
+ * IPRT - RTMemFirstNonZero, AVX2 worker.
+ *
+ * This file must be compiled with AVX2 enabled (-mavx2), the caller makes sure
+ * the CPU and OS support it before calling.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "internal/iprt.h"
+#include <iprt/asm.h>
+#include "internal/mem.h"
+
+#include <immintrin.h>
+
+
+DECLHIDDEN(uint8_t const *) rtMemFirstNonZeroAvx2(uint8_t const *pb, size_t cb)
+{
+    /*
+     * Four vectors (128 bytes) per iteration, then one vector at a time.
+     */
+    __m256i const uZero = _mm256_setzero_si256();
+    while (cb >= 128)
+    {
+        __m256i const uVec0 = _mm256_loadu_si256((__m256i const *)pb);
+        __m256i const uVec1 = _mm256_loadu_si256((__m256i const *)(pb + 32));
+        __m256i const uVec2 = _mm256_loadu_si256((__m256i const *)(pb + 64));
+        __m256i const uVec3 = _mm256_loadu_si256((__m256i const *)(pb + 96));
+        __m256i const uOr   = _mm256_or_si256(_mm256_or_si256(uVec0, uVec1), _mm256_or_si256(uVec2, uVec3));
+        if (!_mm256_testz_si256(uOr, uOr))
+            break;
+        pb += 128;
+        cb -= 128;
+    }
+
+    while (cb >= 32)
+    {
+        uint32_t const fZero = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const *)pb), uZero));
+        if (fZero != UINT32_MAX)
+            return pb + ASMBitFirstSetU32(~fZero) - 1;
+        pb += 32;
+        cb -= 32;
+    }
+
+    /*
+     * The tail.
+     */
+    for (; cb > 0; cb--, pb++)
+        if (*pb)
+            return pb;
+    return NULL;
+}
+
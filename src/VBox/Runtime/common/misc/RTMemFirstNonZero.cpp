@@ -0,0 +1,210 @@
+/* $Id: RTMemFirstNonZero.cpp $ */
+/** @file
+ * IPRT - RTMemFirstNonZero and RTMemIsZero.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/mem.h>
+#include "internal/iprt.h"
+
+#include <iprt/asm.h>
+#include "internal/mem.h"
+#ifdef RTMEM_WITH_SIMD
+# include <iprt/asm-amd64-x86.h>
+# include <iprt/env.h>
+# include <iprt/x86.h>
+# if defined(_MSC_VER) && !RT_INLINE_ASM_GNU_STYLE
+#  include <immintrin.h>
+# endif
+# ifdef RT_ARCH_AMD64
+#  include <emmintrin.h>
+# endif
+#endif
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+/** Worker for RTMemFirstNonZero. */
+typedef DECLCALLBACK(uint8_t const *) FNRTMEMFIRSTNONZERO(uint8_t const *pb, size_t cb);
+/** Pointer to a RTMemFirstNonZero worker. */
+typedef FNRTMEMFIRSTNONZERO *PFNRTMEMFIRSTNONZERO;
+
+
+/*******************************************************************************
+*   Internal Functions                                                         *
+*******************************************************************************/
+#ifdef RTMEM_WITH_SIMD
+static DECLCALLBACK(uint8_t const *) rtMemFirstNonZeroResolve(uint8_t const *pb, size_t cb);
+#endif
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+#ifdef RTMEM_WITH_SIMD
+/** The worker, resolved on the first call. */
+static PFNRTMEMFIRSTNONZERO volatile g_pfnFirstNonZero = rtMemFirstNonZeroResolve;
+#endif
+
+
+/**
+ * Generic worker for RTMemFirstNonZero, checking four machine words at a time.
+ */
+static DECLCALLBACK(uint8_t const *) rtMemFirstNonZeroGeneric(uint8_t const *pb, size_t cb)
+{
+    /* Align the pointer. */
+    while (cb > 0 && ((uintptr_t)pb & (sizeof(uintptr_t) - 1)))
+    {
+        if (*pb)
+            return pb;
+        pb++;
+        cb--;
+    }
+
+    /* The bulk of the block. */
+    uintptr_t const *pu = (uintptr_t const *)pb;
+    while (cb >= sizeof(uintptr_t) * 4)
+    {
+        if (pu[0] | pu[1] | pu[2] | pu[3])
+            break;
+        pu += 4;
+        cb -= sizeof(uintptr_t) * 4;
+    }
+
+    /* Pinpoint the non-zero byte, or check the tail. */
+    pb = (uint8_t const *)pu;
+    for (; cb > 0; cb--, pb++)
+        if (*pb)
+            return pb;
+    return NULL;
+}
+
+
+#ifdef RTMEM_WITH_SIMD
+
+# ifdef RT_ARCH_AMD64
+/**
+ * SSE2 worker for RTMemFirstNonZero, SSE2 is part of the AMD64 baseline.
+ */
+static DECLCALLBACK(uint8_t const *) rtMemFirstNonZeroSse2(uint8_t const *pb, size_t cb)
+{
+    __m128i const uZero = _mm_setzero_si128();
+    while (cb >= 64)
+    {
+        __m128i uOr = _mm_or_si128(_mm_or_si128(_mm_loadu_si128((__m128i const *)pb),
+                                                _mm_loadu_si128((__m128i const *)(pb + 16))),
+                                   _mm_or_si128(_mm_loadu_si128((__m128i const *)(pb + 32)),
+                                                _mm_loadu_si128((__m128i const *)(pb + 48))));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(uOr, uZero)) != 0xffff)
+            return rtMemFirstNonZeroGeneric(pb, 64);
+        pb += 64;
+        cb -= 64;
+    }
+    return rtMemFirstNonZeroGeneric(pb, cb);
+}
+# endif
+
+
+# ifdef RTMEM_WITH_AVX2
+/**
+ * Reads XCR0, the caller must make sure CPUID.1:ECX.OSXSAVE is set.
+ */
+static uint64_t rtMemGetXcr0(void)
+{
+#  if RT_INLINE_ASM_GNU_STYLE
+    uint32_t uLow, uHigh;
+    __asm__ __volatile__(".byte 0x0f,0x01,0xd0\n\t" /* xgetbv */
+                         : "=a" (uLow),
+                           "=d" (uHigh)
+                         : "c" (0));
+    return RT_MAKE_U64(uLow, uHigh);
+#  else
+    return _xgetbv(0);
+#  endif
+}
+# endif /* RTMEM_WITH_AVX2 */
+
+
+/**
+ * Picks the best worker for this CPU on the first call.
+ *
+ * The IPRT_MEM_NO_AVX2 and IPRT_MEM_NO_SIMD environment variables can be used
+ * to force the lesser workers.
+ */
+static DECLCALLBACK(uint8_t const *) rtMemFirstNonZeroResolve(uint8_t const *pb, size_t cb)
+{
+# ifdef RT_ARCH_AMD64
+    PFNRTMEMFIRSTNONZERO pfnWorker = rtMemFirstNonZeroSse2;
+# else
+    PFNRTMEMFIRSTNONZERO pfnWorker = rtMemFirstNonZeroGeneric;
+# endif
+    if (RTEnvExist("IPRT_MEM_NO_SIMD"))
+        pfnWorker = rtMemFirstNonZeroGeneric;
+# ifdef RTMEM_WITH_AVX2
+    else if (ASMHasCpuId() && !RTEnvExist("IPRT_MEM_NO_AVX2"))
+    {
+        uint32_t uEAX, uEBX, uECX, uEDX;
+        ASMCpuId(0, &uEAX, &uEBX, &uECX, &uEDX);
+        if (uEAX >= 7)
+        {
+            uint32_t uECX1, uEDX1;
+            ASMCpuId_ECX_EDX(1, &uECX1, &uEDX1);
+            ASMCpuId_Idx_ECX(7, 0, &uEAX, &uEBX, &uECX, &uEDX);
+            if (   (uEBX & X86_CPUID_STEXT_FEATURE_EBX_AVX2)
+                && (uECX1 & X86_CPUID_FEATURE_ECX_AVX)
+                && (uECX1 & X86_CPUID_FEATURE_ECX_OSXSAVE)
+                && (rtMemGetXcr0() & (XSAVE_C_SSE | XSAVE_C_YMM)) == (XSAVE_C_SSE | XSAVE_C_YMM))
+                pfnWorker = rtMemFirstNonZeroAvx2;
+        }
+    }
+# endif
+
+    ASMAtomicWritePtr(&g_pfnFirstNonZero, pfnWorker);
+    return pfnWorker(pb, cb);
+}
+
+#endif /* RTMEM_WITH_SIMD */
+
+
+RTDECL(void *) RTMemFirstNonZero(void const *pv, size_t cb) RT_NO_THROW
+{
+#ifdef RTMEM_WITH_SIMD
+    return (void *)g_pfnFirstNonZero((uint8_t const *)pv, cb);
+#else
+    return (void *)rtMemFirstNonZeroGeneric((uint8_t const *)pv, cb);
+#endif
+}
+RT_EXPORT_SYMBOL(RTMemFirstNonZero);
+
+
+RTDECL(bool) RTMemIsZero(void const *pv, size_t cb) RT_NO_THROW
+{
+    return RTMemFirstNonZero(pv, cb) == NULL;
+}
+RT_EXPORT_SYMBOL(RTMemIsZero);
+
@@ -40,6 +40,7 @@
 #include <iprt/string.h>
 #include <iprt/time.h>
 #include <iprt/semaphore.h>
+#include <iprt/spinlock.h>
 #include <iprt/thread.h>
 
 #include "internal/req.h"
@@ -55,11 +56,83 @@
 #define RTREQPOOL_PUSH_BACK_MAX_MS      RT_MS_1MIN
 /** The max number of free requests to keep around. */
 #define RTREQPOOL_MAX_FREE_REQUESTS     (RTREQPOOL_MAX_THREADS * 2U)
+/** The max number of worker queues.  Workers beyond this share queues. */
+#define RTREQPOOL_MAX_WORK_QUEUES       UINT32_C(64)
+/** The max number of requests a worker steals from another in one go. */
+#define RTREQPOOL_MAX_STEAL             UINT32_C(32)
+/** The number of buckets in the queue latency histogram.  Bucket 0 counts
+ * latencies below 1024 ns, bucket N those below 2^(N+10) ns. */
+#define RTREQPOOL_HIST_BUCKETS          33
 
 
 /*******************************************************************************
 *   Structures and Typedefs                                                    *
 *******************************************************************************/
+/**
+ * Per worker request queue.
+ *
+ * Submitters append to the tail, the worker owning the queue takes requests
+ * from the head one at a time, while workers which have run dry steal a
+ * batch from the head of some other queue.  All queues are allocated in one
+ * array, the padding keeps them on separate cache lines.
+ */
+typedef union RTREQPOOLWORKQ
+{
+    struct
+    {
+        /** Spinlock protecting the queue. */
+        RTSPINLOCK              hSpinlock;
+        /** Head of the request FIFO. */
+        PRTREQINT               pHead;
+        /** Where to insert the next request. */
+        PRTREQINT              *ppTail;
+        /** The number of requests in the queue.  Read without the lock for
+         * quickly skipping empty queues. */
+        uint32_t volatile       cReqs;
+        /** Statistics: The max number of requests seen in the queue. */
+        uint32_t                cMaxReqs;
+        /** Statistics: The number of requests submitted to this queue. */
+        uint64_t                cReqSubmitted;
+        /** Set if a worker thread has this as its home queue.  Protected by the
+         * pool critical section. */
+        bool                    fOwned;
+    } s;
+    /** Padding to a cache line. */
+    uint8_t                     abPadding[64];
+} RTREQPOOLWORKQ;
+AssertCompile(sizeof(RTREQPOOLWORKQ) == 64);
+/** Pointer to a worker queue. */
+typedef RTREQPOOLWORKQ *PRTREQPOOLWORKQ;
+
+
+/**
+ * Request processing statistics.
+ *
+ * Kept per worker thread so the request processing path doesn't write
+ * shared cache lines, summed up by RTReqPoolGetStat.
+ */
+typedef struct RTREQPOOLSTATS
+{
+    /** The number of requests processed. */
+    uint64_t                cReqProcessed;
+    /** The number of requests stolen from other worker queues. */
+    uint64_t                cReqStolen;
+    /** Total time the requests took to process. */
+    uint64_t                cNsTotalReqProcessing;
+    /** Total time the requests had to wait in the queue before being
+     * scheduled. */
+    uint64_t                cNsTotalReqQueued;
+    /** The longest time a request took to process. */
+    uint64_t                cNsMaxReqProcessing;
+    /** The longest time a request had to wait in the queue. */
+    uint64_t                cNsMaxReqQueued;
+    /** Queue latency histogram, see RTREQPOOL_HIST_BUCKETS. */
+    uint64_t                acReqQueuedHist[RTREQPOOL_HIST_BUCKETS];
+} RTREQPOOLSTATS;
+/** Pointer to request processing statistics. */
+typedef RTREQPOOLSTATS *PRTREQPOOLSTATS;
+
+
 typedef struct RTREQPOOLTHREAD
 {
     /** Node in the  RTREQPOOLINT::IdleThreads list. */
@@ -73,16 +146,19 @@ typedef struct RTREQPOOLTHREAD
     uint64_t                uProcessingNanoTs;
     /** When this CPU went idle the last time. */
     uint64_t                uIdleNanoTs;
-    /** The number of requests processed by this thread. */
-    uint64_t                cReqProcessed;
-    /** Total time the requests processed by this thread took to process. */
-    uint64_t                cNsTotalReqProcessing;
-    /** Total time the requests processed by this thread had to wait in
-     * the queue before being scheduled. */
-    uint64_t                cNsTotalReqQueued;
+    /** Request processing statistics for this thread. */
+    RTREQPOOLSTATS          Stats;
     /** The CPU this was scheduled last time we checked. */
     RTCPUID                 idLastCpu;
 
+    /** The index of the home queue (RTREQPOOLINT::paWorkQs). */
+    uint32_t                iWorkQ;
+    /** The index of the queue we last stole from, where the next steal
+     * attempt starts. */
+    uint32_t                iVictimWorkQ;
+    /** Set if we own the home queue (RTREQPOOLWORKQ::fOwned). */
+    bool                    fOwnsWorkQ;
+
     /** The submitter will put an incoming request here when scheduling an idle
      * thread.  */
     PRTREQINT volatile      pTodoReq;
@@ -147,8 +223,9 @@ typedef struct RTREQPOOLINT
     /** The current submitter push back in milliseconds.
      * This is recalculated when worker threads come and go.  */
     uint32_t                cMsCurPushBack;
-    /** The current number of worker threads. */
-    uint32_t                cCurThreads;
+    /** The current number of worker threads.  Changed inside the critical
+     * section only, but read without it by submitters. */
+    uint32_t volatile       cCurThreads;
     /** Statistics: The total number of threads created. */
     uint32_t                cThreadsCreated;
     /** Statistics: The timestamp when the last thread was created. */
@@ -156,13 +233,9 @@ typedef struct RTREQPOOLINT
     /** Linked list of worker threads. */
     RTLISTANCHOR            WorkerThreads;
 
-    /** The number of requests processed and counted in the time totals. */
-    uint64_t                cReqProcessed;
-    /** Total time the requests processed by this thread took to process. */
-    uint64_t                cNsTotalReqProcessing;
-    /** Total time the requests processed by this thread had to wait in
-     * the queue before being scheduled. */
-    uint64_t                cNsTotalReqQueued;
+    /** Request processing statistics of worker threads that have
+     * terminated. */
+    RTREQPOOLSTATS          StatsRetired;
 
     /** Reference counter. */
     uint32_t volatile       cRefs;
@@ -173,21 +246,19 @@ typedef struct RTREQPOOLINT
     /** Linked list of idle threads. */
     RTLISTANCHOR            IdleThreads;
 
-    /** Head of the request FIFO. */
-    PRTREQINT               pPendingRequests;
-    /** Where to insert the next request. */
-    PRTREQINT              *ppPendingRequests;
-    /** The number of requests currently pending. */
-    uint32_t                cCurPendingRequests;
-    /** The number of requests currently being executed. */
-    uint32_t volatile       cCurActiveRequests;
-    /** The number of requests submitted. */
+    /** The number of worker queues. */
+    uint32_t                cWorkQs;
+    /** The worker queues (cWorkQs). */
+    PRTREQPOOLWORKQ         paWorkQs;
+    /** The number of requests handed directly to idle threads. */
     uint64_t                cReqSubmitted;
 
+    /** Spinlock protecting the request recycling LIFO. */
+    RTSPINLOCK              hFreeSpinlock;
     /** Head of the request recycling LIFO. */
     PRTREQINT               pFreeRequests;
     /** The number of requests in the recycling LIFO.  This is read without
-     * entering the critical section, thus volatile. */
+     * entering the spinlock, thus volatile. */
     uint32_t volatile       cCurFreeRequests;
 
     /** Critical section serializing access to members of this structure.  */
@@ -227,7 +298,9 @@ static void rtReqPoolRecalcPushBack(PRTREQPOOLINT pPool)
     uint32_t const iStep    = pPool->cCurThreads - pPool->cThreadsPushBackThreshold;
 
     uint32_t cMsCurPushBack;
-    if ((cMsRange >> 2) >= cSteps)
+    if (!cSteps)
+        cMsCurPushBack = 0;
+    else if ((cMsRange >> 2) >= cSteps)
         cMsCurPushBack = cMsRange / cSteps * iStep;
     else
         cMsCurPushBack = (uint32_t)( (uint64_t)cMsRange * RT_NS_1MS  / cSteps * iStep / RT_NS_1MS );
@@ -237,6 +310,197 @@ static void rtReqPoolRecalcPushBack(PRTREQPOOLINT pPool)
 }
 
 
+/**
+ * Adds one set of request statistics to another.
+ *
+ * @param   pDst                The statistics to add to.
+ * @param   pSrc                The statistics to add.
+ */
+static void rtReqPoolStatsAdd(PRTREQPOOLSTATS pDst, RTREQPOOLSTATS const *pSrc)
+{
+    pDst->cReqProcessed         += pSrc->cReqProcessed;
+    pDst->cReqStolen            += pSrc->cReqStolen;
+    pDst->cNsTotalReqProcessing += pSrc->cNsTotalReqProcessing;
+    pDst->cNsTotalReqQueued     += pSrc->cNsTotalReqQueued;
+    pDst->cNsMaxReqProcessing    = RT_MAX(pDst->cNsMaxReqProcessing, pSrc->cNsMaxReqProcessing);
+    pDst->cNsMaxReqQueued        = RT_MAX(pDst->cNsMaxReqQueued, pSrc->cNsMaxReqQueued);
+    for (unsigned i = 0; i < RT_ELEMENTS(pDst->acReqQueuedHist); i++)
+        pDst->acReqQueuedHist[i] += pSrc->acReqQueuedHist[i];
+}
+
+
+/**
+ * Calculates a queue latency percentile from the histogram.
+ *
+ * @returns The upper bound of the histogram bucket containing the percentile,
+ *          in nanoseconds.  0 if no requests have been processed.
+ * @param   pStats              The statistics.
+ * @param   uPct                The percentile (1-100).
+ */
+static uint64_t rtReqPoolStatsQueuedPercentile(RTREQPOOLSTATS const *pStats, unsigned uPct)
+{
+    uint64_t cTotal = 0;
+    for (unsigned i = 0; i < RT_ELEMENTS(pStats->acReqQueuedHist); i++)
+        cTotal += pStats->acReqQueuedHist[i];
+    if (!cTotal)
+        return 0;
+
+    uint64_t const cThreshold = (cTotal * uPct + 99) / 100;
+    uint64_t       cSeen      = 0;
+    for (unsigned i = 0; i < RT_ELEMENTS(pStats->acReqQueuedHist); i++)
+    {
+        cSeen += pStats->acReqQueuedHist[i];
+        if (cSeen >= cThreshold)
+            return RT_BIT_64(i + 10);
+    }
+    return RT_BIT_64(RTREQPOOL_HIST_BUCKETS + 9);
+}
+
+
+/**
+ * Appends a chain of requests to a worker queue.
+ *
+ * @param   pWorkQ              The worker queue.
+ * @param   pHead               The first request in the chain.
+ * @param   pTail               The last request in the chain.
+ * @param   cReqs               The number of requests in the chain.
+ * @param   fSubmit             Set if this is a submission, clear if it's
+ *                              requests being moved around by a thief.
+ */
+static void rtReqPoolWorkQAppend(PRTREQPOOLWORKQ pWorkQ, PRTREQINT pHead, PRTREQINT pTail, uint32_t cReqs, bool fSubmit)
+{
+    pTail->pNext = NULL;
+
+    RTSpinlockAcquire(pWorkQ->s.hSpinlock);
+
+    *pWorkQ->s.ppTail = pHead;
+    pWorkQ->s.ppTail  = (PRTREQINT *)&pTail->pNext;
+    uint32_t const cNewReqs = pWorkQ->s.cReqs + cReqs;
+    ASMAtomicWriteU32(&pWorkQ->s.cReqs, cNewReqs);
+    if (cNewReqs > pWorkQ->s.cMaxReqs)
+        pWorkQ->s.cMaxReqs = cNewReqs;
+    if (fSubmit)
+        pWorkQ->s.cReqSubmitted += cReqs;
+
+    RTSpinlockRelease(pWorkQ->s.hSpinlock);
+}
+
+
+/**
+ * Takes requests off the head of a worker queue.
+ *
+ * @returns Chain of requests linked by pNext, NULL if the queue is empty.
+ * @param   pWorkQ              The worker queue.
+ * @param   fSteal              Set if stealing, in which case we take up to
+ *                              half of the requests, clear to take one.
+ * @param   pcReqs              Where to return the number of requests taken.
+ */
+static PRTREQINT rtReqPoolWorkQTake(PRTREQPOOLWORKQ pWorkQ, bool fSteal, uint32_t *pcReqs)
+{
+    *pcReqs = 0;
+    if (!ASMAtomicReadU32(&pWorkQ->s.cReqs))
+        return NULL;
+
+    RTSpinlockAcquire(pWorkQ->s.hSpinlock);
+
+    PRTREQINT pHead = pWorkQ->s.pHead;
+    if (pHead)
+    {
+        uint32_t const cAvail = pWorkQ->s.cReqs;
+        uint32_t const cMax   = fSteal ? RT_MIN(RT_MAX(cAvail / 2, 1), RTREQPOOL_MAX_STEAL) : 1;
+        PRTREQINT      pTail  = pHead;
+        uint32_t       cTaken = 1;
+        while (cTaken < cMax && pTail->pNext)
+        {
+            pTail = pTail->pNext;
+            cTaken++;
+        }
+
+        pWorkQ->s.pHead = pTail->pNext;
+        if (!pWorkQ->s.pHead)
+            pWorkQ->s.ppTail = &pWorkQ->s.pHead;
+        pTail->pNext = NULL;
+        Assert(cAvail >= cTaken);
+        ASMAtomicWriteU32(&pWorkQ->s.cReqs, cAvail - cTaken);
+        *pcReqs = cTaken;
+    }
+
+    RTSpinlockRelease(pWorkQ->s.hSpinlock);
+    return pHead;
+}
+
+
+/**
+ * Picks the worker queue for a new request.
+ *
+ * Each submitter thread sticks to one of the queues of the current worker
+ * threads, which avoids a shared round robin counter.  The workers even out
+ * the load by stealing, and queues without an owner get drained that way too.
+ *
+ * @returns Pointer to the worker queue.
+ * @param   pPool               The pool.
+ * @param   iOffset             Offset from the submitter's queue, used for
+ *                              spreading batches.
+ */
+DECLINLINE(PRTREQPOOLWORKQ) rtReqPoolWorkQPick(PRTREQPOOLINT pPool, uint32_t iOffset)
+{
+    uint32_t const cWorkQs = RT_MIN(ASMAtomicReadU32(&pPool->cCurThreads), pPool->cWorkQs);
+    if (cWorkQs <= 1)
+        return &pPool->paWorkQs[0];
+    uint64_t const uHash = (uint64_t)RTThreadNativeSelf() * UINT64_C(0x9e3779b97f4a7c15);
+    return &pPool->paWorkQs[((uint32_t)(uHash >> 32) + iOffset) % cWorkQs];
+}
+
+
+/**
+ * Gets the next request for a worker thread, stealing from the other worker
+ * queues if the home queue is empty.
+ *
+ * @returns The request, NULL if all queues are empty.
+ * @param   pPool               The pool.
+ * @param   pThread             The worker thread.
+ */
+static PRTREQINT rtReqPoolWorkerGetNext(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD pThread)
+{
+    PRTREQPOOLWORKQ pHomeWorkQ = &pPool->paWorkQs[pThread->iWorkQ];
+    uint32_t        cReqs;
+    PRTREQINT       pReq = rtReqPoolWorkQTake(pHomeWorkQ, false /*fSteal*/, &cReqs);
+    if (!pReq)
+    {
+        /*
+         * Go stealing, starting with the queue we last found work in.
+         */
+        uint32_t const cWorkQs = pPool->cWorkQs;
+        uint32_t       iWorkQ  = pThread->iVictimWorkQ;
+        for (uint32_t i = 0; i < cWorkQs; i++, iWorkQ = (iWorkQ + 1) % cWorkQs)
+        {
+            if (iWorkQ == pThread->iWorkQ)
+                continue;
+            pReq = rtReqPoolWorkQTake(&pPool->paWorkQs[iWorkQ], true /*fSteal*/, &cReqs);
+            if (pReq)
+            {
+                pThread->iVictimWorkQ      = iWorkQ;
+                pThread->Stats.cReqStolen += cReqs;
+
+                /* Keep the first and move the rest to our home queue. */
+                if (cReqs > 1)
+                {
+                    PRTREQINT pTail = pReq->pNext;
+                    while (pTail->pNext)
+                        pTail = pTail->pNext;
+                    rtReqPoolWorkQAppend(pHomeWorkQ, pReq->pNext, pTail, cReqs - 1, false /*fSubmit*/);
+                }
+                break;
+            }
+        }
+    }
+
+    if (pReq)
+        pReq->pNext = NULL;
+    return pReq;
+}
+
+
 
 /**
  * Performs thread exit.
@@ -263,9 +527,14 @@ static int rtReqPoolThreadExit(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD pThread, bo
     /* Get out of the thread list. */
     RTListNodeRemove(&pThread->ListNode);
     Assert(pPool->cCurThreads > 0);
-    pPool->cCurThreads--;
+    ASMAtomicDecU32(&pPool->cCurThreads);
     rtReqPoolRecalcPushBack(pPool);
 
+    /* Give up the home queue and hand over the statistics. */
+    if (pThread->fOwnsWorkQ)
+        pPool->paWorkQs[pThread->iWorkQ].s.fOwned = false;
+    rtReqPoolStatsAdd(&pPool->StatsRetired, &pThread->Stats);
+
     /* This shouldn't happen... */
     PRTREQINT pReq = pThread->pTodoReq;
     if (pReq)
@@ -283,6 +552,7 @@ static int rtReqPoolThreadExit(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD pThread, bo
 
     RTCritSectLeave(&pPool->CritSect);
 
+    RTMemFree(pThread);
     return VINF_SUCCESS;
 }
 
@@ -297,13 +567,14 @@ static int rtReqPoolThreadExit(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD pThread, bo
  */
 static void rtReqPoolThreadProcessRequest(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD pThread, PRTREQINT pReq)
 {
+    NOREF(pPool);
+
     /*
      * Update thread state.
      */
     pThread->uProcessingNanoTs  = RTTimeNanoTS();
     pThread->uPendingNanoTs     = pReq->uSubmitNanoTs;
-    pThread->pPendingReq        = pReq;
-    ASMAtomicIncU32(&pPool->cCurActiveRequests);
+    ASMAtomicWritePtr(&pThread->pPendingReq, pReq);
     Assert(pReq->u32Magic == RTREQ_MAGIC);
 
     /*
@@ -314,12 +585,19 @@ static void rtReqPoolThreadProcessRequest(PRTREQPOOLINT pPool, PRTREQPOOLTHREAD
     /*
      * Update thread statistics and state.
      */
-    ASMAtomicDecU32(&pPool->cCurActiveRequests);
-    pThread->pPendingReq    = NULL;
-    uint64_t const uNsTsEnd = RTTimeNanoTS();
-    pThread->cNsTotalReqProcessing += uNsTsEnd - pThread->uProcessingNanoTs;
-    pThread->cNsTotalReqQueued     += pThread->uProcessingNanoTs - pThread->uPendingNanoTs;
-    pThread->cReqProcessed++;
+    ASMAtomicWriteNullPtr(&pThread->pPendingReq);
+    uint64_t const uNsTsEnd      = RTTimeNanoTS();
+    uint64_t const cNsProcessing = uNsTsEnd - pThread->uProcessingNanoTs;
+    uint64_t const cNsQueued     = pThread->uProcessingNanoTs - pThread->uPendingNanoTs;
+    pThread->Stats.cNsTotalReqProcessing += cNsProcessing;
+    pThread->Stats.cNsTotalReqQueued     += cNsQueued;
+    if (cNsProcessing > pThread->Stats.cNsMaxReqProcessing)
+        pThread->Stats.cNsMaxReqProcessing = cNsProcessing;
+    if (cNsQueued > pThread->Stats.cNsMaxReqQueued)
+        pThread->Stats.cNsMaxReqQueued = cNsQueued;
+    uint64_t const cUsQueued     = cNsQueued >> 10;
+    pThread->Stats.acReqQueuedHist[ASMBitLastSetU32(cUsQueued <= UINT32_MAX ? (uint32_t)cUsQueued : UINT32_MAX)]++;
+    pThread->Stats.cReqProcessed++;
 }
 
 
@@ -339,10 +617,8 @@ static DECLCALLBACK(int) rtReqPoolThreadProc(RTTHREAD hThreadSelf, void *pvArg)
     /*
      * The work loop.
      */
-    uint64_t cReqPrevProcessedIdle     = UINT64_MAX;
-    uint64_t cReqPrevProcessedStat     = 0;
-    uint64_t cNsPrevTotalReqProcessing = 0;
-    uint64_t cNsPrevTotalReqQueued     = 0;
+    uint64_t cReqPrevProcessedIdle = UINT64_MAX;
+    bool     fWokenUp              = false;
     while (!pPool->fDestructing)
     {
         /*
@@ -355,44 +631,44 @@ static DECLCALLBACK(int) rtReqPoolThreadProc(RTTHREAD hThreadSelf, void *pvArg)
         {
             Assert(RTListIsEmpty(&pThread->IdleNode)); /* Must not be in the idle list. */
             rtReqPoolThreadProcessRequest(pPool, pThread, pReq);
+            fWokenUp = false;
             continue;
         }
 
-        ASMAtomicIncU32(&pPool->cIdleThreads);
-        RTCritSectEnter(&pPool->CritSect);
-
-        /* Update the global statistics. */
-        if (cReqPrevProcessedStat != pThread->cReqProcessed)
+        /* Check the worker queues without entering the critical section,
+           unless we may be sitting in the idle list. */
+        if (!fWokenUp)
         {
-            pPool->cReqProcessed         += pThread->cReqProcessed         - cReqPrevProcessedStat;
-            cReqPrevProcessedStat         = pThread->cReqProcessed;
-            pPool->cNsTotalReqProcessing += pThread->cNsTotalReqProcessing - cNsPrevTotalReqProcessing;
-            cNsPrevTotalReqProcessing     = pThread->cNsTotalReqProcessing;
-            pPool->cNsTotalReqQueued     += pThread->cNsTotalReqQueued     - cNsPrevTotalReqQueued;
-            cNsPrevTotalReqQueued         = pThread->cNsTotalReqQueued;
+            pReq = rtReqPoolWorkerGetNext(pPool, pThread);
+            if (pReq)
+            {
+                rtReqPoolThreadProcessRequest(pPool, pThread, pReq);
+                continue;
+            }
         }
+        fWokenUp = false;
+
+        ASMAtomicIncU32(&pPool->cIdleThreads);
+        RTCritSectEnter(&pPool->CritSect);
 
         /* Recheck the todo request pointer after entering the critsect. */
         pReq = ASMAtomicXchgPtrT(&pThread->pTodoReq, NULL, PRTREQINT);
         if (pReq)
         {
             Assert(RTListIsEmpty(&pThread->IdleNode)); /* Must not be in the idle list. */
+            ASMAtomicDecU32(&pPool->cIdleThreads);
             RTCritSectLeave(&pPool->CritSect);
 
             rtReqPoolThreadProcessRequest(pPool, pThread, pReq);
             continue;
         }
 
-        /* Any pending requests in the queue? */
-        pReq = pPool->pPendingRequests;
+        /* Any pending requests in the queues?  Submitters bypassing the
+           critical section check cIdleThreads after queuing, so this recheck
+           makes sure nothing is left behind. */
+        pReq = rtReqPoolWorkerGetNext(pPool, pThread);
         if (pReq)
         {
-            pPool->pPendingRequests = pReq->pNext;
-            if (pReq->pNext == NULL)
-                pPool->ppPendingRequests = &pPool->pPendingRequests;
-            Assert(pPool->cCurPendingRequests > 0);
-            pPool->cCurPendingRequests--;
-
             /* Un-idle ourselves and process the request. */
             if (!RTListIsEmpty(&pThread->IdleNode))
             {
@@ -410,16 +686,21 @@ static DECLCALLBACK(int) rtReqPoolThreadProc(RTTHREAD hThreadSelf, void *pvArg)
         /*
          * Nothing to do, go idle.
          */
-        if (cReqPrevProcessedIdle != pThread->cReqProcessed)
+        if (cReqPrevProcessedIdle != pThread->Stats.cReqProcessed)
         {
-            cReqPrevProcessedIdle = pThread->cReqProcessed;
+            cReqPrevProcessedIdle = pThread->Stats.cReqProcessed;
             pThread->uIdleNanoTs  = RTTimeNanoTS();
         }
         else if (pPool->cCurThreads > pPool->cMinThreads)
         {
             uint64_t cNsIdle = RTTimeNanoTS() - pThread->uIdleNanoTs;
             if (cNsIdle >= pPool->cNsMinIdle)
+            {
+                /* Drop this round's idle count, rtReqPoolThreadExit takes care
+                   of the one for the idle list. */
+                ASMAtomicDecU32(&pPool->cIdleThreads);
                 return rtReqPoolThreadExit(pPool, pThread, true /*fLocked*/);
+            }
         }
 
         if (RTListIsEmpty(&pThread->IdleNode))
@@ -432,6 +713,7 @@ static DECLCALLBACK(int) rtReqPoolThreadProc(RTTHREAD hThreadSelf, void *pvArg)
         RTCritSectLeave(&pPool->CritSect);
 
         RTThreadUserWait(hThreadSelf, cMsSleep);
+        fWokenUp = true;
     }
 
     return rtReqPoolThreadExit(pPool, pThread, false /*fLocked*/);
@@ -455,8 +737,23 @@ static void rtReqPoolCreateNewWorker(RTREQPOOL pPool)
     pThread->idLastCpu    = NIL_RTCPUID;
     pThread->hThread      = NIL_RTTHREAD;
     RTListInit(&pThread->IdleNode);
+
+    /* Pick a home queue, preferring one without an owner. */
+    uint32_t iWorkQ = 0;
+    while (iWorkQ < pPool->cWorkQs && pPool->paWorkQs[iWorkQ].s.fOwned)
+        iWorkQ++;
+    if (iWorkQ < pPool->cWorkQs)
+    {
+        pPool->paWorkQs[iWorkQ].s.fOwned = true;
+        pThread->fOwnsWorkQ = true;
+    }
+    else
+        iWorkQ = pPool->cThreadsCreated % pPool->cWorkQs;
+    pThread->iWorkQ       = iWorkQ;
+    pThread->iVictimWorkQ = (iWorkQ + 1) % pPool->cWorkQs;
+
     RTListAppend(&pPool->WorkerThreads, &pThread->ListNode);
-    pPool->cCurThreads++;
+    ASMAtomicIncU32(&pPool->cCurThreads);
     pPool->cThreadsCreated++;
 
     int rc = RTThreadCreateF(&pThread->hThread, rtReqPoolThreadProc, pThread, 0 /*default stack size*/,
@@ -465,13 +762,56 @@ static void rtReqPoolCreateNewWorker(RTREQPOOL pPool)
         pPool->uLastThreadCreateNanoTs = pThread->uBirthNanoTs;
     else
     {
-        pPool->cCurThreads--;
+        ASMAtomicDecU32(&pPool->cCurThreads);
         RTListNodeRemove(&pThread->ListNode);
+        if (pThread->fOwnsWorkQ)
+            pPool->paWorkQs[iWorkQ].s.fOwned = false;
         RTMemFree(pThread);
     }
 }
 
 
+/**
+ * Makes sure there is a worker thread coming for newly queued requests.
+ *
+ * Wakes up idle threads, or creates a new one if none are idle or about to
+ * become idle and the limit permits it.
+ *
+ * @param   pPool               The pool.
+ * @param   cReqs               The number of requests queued.
+ * @remarks Caller owns the critical section
+ */
+static void rtReqPoolKickWorkers(PRTREQPOOLINT pPool, uint32_t cReqs)
+{
+    uint32_t cKicked = 0;
+    while (cKicked < cReqs)
+    {
+        PRTREQPOOLTHREAD pThread = RTListGetFirst(&pPool->IdleThreads, RTREQPOOLTHREAD, IdleNode);
+        if (!pThread)
+            break;
+        RTListNodeRemove(&pThread->IdleNode);
+        RTListInit(&pThread->IdleNode);
+        ASMAtomicDecU32(&pPool->cIdleThreads);
+        RTThreadUserSignal(pThread->hThread);
+        cKicked++;
+    }
+
+    if (   cKicked == 0
+        && pPool->cIdleThreads == 0)
+    {
+        /* Spawn threads freely up to the push back threshold, then one at a time. */
+        do
+        {
+            if (pPool->cCurThreads >= pPool->cMaxThreads)
+                break;
+            rtReqPoolCreateNewWorker(pPool);
+            cKicked++;
+        } while (   cKicked < cReqs
+                 && pPool->cCurThreads < pPool->cThreadsPushBackThreshold);
+    }
+}
+
+
 /**
  * Repel the submitter, giving the worker threads a chance to process the
  * incoming request.
@@ -524,9 +864,27 @@ static int rtReqPoolPushBack(PRTREQPOOLINT pPool, PRTREQINT pReq)
 
 DECLHIDDEN(void) rtReqPoolSubmit(PRTREQPOOLINT pPool, PRTREQINT pReq)
 {
-    RTCritSectEnter(&pPool->CritSect);
+    /*
+     * When all the worker threads are busy and we cannot create any more,
+     * just queue the request without going near the critical section.  Since
+     * a worker rechecks the queues after counting itself idle, rechecking the
+     * idle count after queuing ensures that the request isn't left behind.
+     */
+    if (   ASMAtomicReadU32(&pPool->cIdleThreads) == 0
+        && ASMAtomicReadU32(&pPool->cCurThreads) >= pPool->cMaxThreads)
+    {
+        rtReqPoolWorkQAppend(rtReqPoolWorkQPick(pPool, 0), pReq, pReq, 1, true /*fSubmit*/);
+        if (RT_UNLIKELY(   ASMAtomicReadU32(&pPool->cIdleThreads) > 0
+                        || ASMAtomicReadU32(&pPool->cCurThreads) < pPool->cMaxThreads))
+        {
+            RTCritSectEnter(&pPool->CritSect);
+            rtReqPoolKickWorkers(pPool, 1);
+            RTCritSectLeave(&pPool->CritSect);
+        }
+        return;
+    }
 
-    pPool->cReqSubmitted++;
+    RTCritSectEnter(&pPool->CritSect);
 
     /*
      * Try schedule the request to a thread that's currently idle.
@@ -535,6 +893,7 @@ DECLHIDDEN(void) rtReqPoolSubmit(PRTREQPOOLINT pPool, PRTREQINT pReq)
     if (pThread)
     {
         /** @todo CPU affinity??? */
+        pPool->cReqSubmitted++;
         ASMAtomicWritePtr(&pThread->pTodoReq, pReq);
 
         RTListNodeRemove(&pThread->IdleNode);
@@ -549,12 +908,9 @@ DECLHIDDEN(void) rtReqPoolSubmit(PRTREQPOOLINT pPool, PRTREQINT pReq)
     Assert(RTListIsEmpty(&pPool->IdleThreads));
 
     /*
-     * Put the request in the pending queue.
+     * Put the request in a worker queue.
      */
-    pReq->pNext = NULL;
-    *pPool->ppPendingRequests = pReq;
-    pPool->ppPendingRequests  = (PRTREQINT*)&pReq->pNext;
-    pPool->cCurPendingRequests++;
+    rtReqPoolWorkQAppend(rtReqPoolWorkQPick(pPool, 0), pReq, pReq, 1, true /*fSubmit*/);
 
     /*
      * If there is an incoming worker thread already or we've reached the
@@ -589,6 +945,49 @@ DECLHIDDEN(void) rtReqPoolSubmit(PRTREQPOOLINT pPool, PRTREQINT pReq)
 }
 
 
+/**
+ * Submits a batch of requests, spreading them over the worker queues.
+ *
+ * The requests must have been prepared like RTReqSubmit does.  Unlike
+ * rtReqPoolSubmit this does not push back on the submitter.
+ *
+ * @param   pPool               The pool.
+ * @param   papReqs             The requests.
+ * @param   cReqs               The number of requests.
+ */
+static void rtReqPoolSubmitBatch(PRTREQPOOLINT pPool, PRTREQINT *papReqs, uint32_t cReqs)
+{
+    /*
+     * Chain them up and spread them over the queues of the current workers,
+     * one lock round trip per queue.
+     */
+    uint32_t const cWorkQs   = RT_MAX(RT_MIN(ASMAtomicReadU32(&pPool->cCurThreads), pPool->cWorkQs), 1);
+    uint32_t const cPerWorkQ = (cReqs + cWorkQs - 1) / cWorkQs;
+    uint32_t       iReq      = 0;
+    for (uint32_t iWorkQ = 0; iReq < cReqs; iWorkQ++)
+    {
+        uint32_t const cChunk = RT_MIN(cPerWorkQ, cReqs - iReq);
+        for (uint32_t i = iReq; i + 1 < iReq + cChunk; i++)
+            papReqs[i]->pNext = papReqs[i + 1];
+        rtReqPoolWorkQAppend(rtReqPoolWorkQPick(pPool, iWorkQ), papReqs[iReq], papReqs[iReq + cChunk - 1], cChunk,
+                             true /*fSubmit*/);
+        iReq += cChunk;
+    }
+
+    /*
+     * Get enough workers going.  The busy ones will find the requests when
+     * they're done with their current ones.
+     */
+    if (   ASMAtomicReadU32(&pPool->cIdleThreads) > 0
+        || ASMAtomicReadU32(&pPool->cCurThreads) < pPool->cMaxThreads)
+    {
+        RTCritSectEnter(&pPool->CritSect);
+        rtReqPoolKickWorkers(pPool, cReqs);
+        RTCritSectLeave(&pPool->CritSect);
+    }
+}
+
+
 /**
  * Frees a requst.
  *
@@ -601,18 +1000,18 @@ DECLHIDDEN(bool) rtReqPoolRecycle(PRTREQPOOLINT pPool, PRTREQINT pReq)
     if (   pPool
         && ASMAtomicReadU32(&pPool->cCurFreeRequests) < pPool->cMaxFreeRequests)
     {
-        RTCritSectEnter(&pPool->CritSect);
+        RTSpinlockAcquire(pPool->hFreeSpinlock);
         if (pPool->cCurFreeRequests < pPool->cMaxFreeRequests)
         {
             pReq->pNext = pPool->pFreeRequests;
             pPool->pFreeRequests = pReq;
             ASMAtomicIncU32(&pPool->cCurFreeRequests);
 
-            RTCritSectLeave(&pPool->CritSect);
+            RTSpinlockRelease(pPool->hFreeSpinlock);
             return true;
         }
 
-        RTCritSectLeave(&pPool->CritSect);
+        RTSpinlockRelease(pPool->hFreeSpinlock);
     }
     return false;
 }
@@ -651,7 +1050,7 @@ RTDECL(int) RTReqPoolCreate(uint32_t cMaxThreads, RTMSINTERVAL cMsMinIdle,
     /*
      * Create and initialize the pool.
      */
-    PRTREQPOOLINT pPool = (PRTREQPOOLINT)RTMemAlloc(sizeof(*pPool));
+    PRTREQPOOLINT pPool = (PRTREQPOOLINT)RTMemAllocZ(sizeof(*pPool));
     if (!pPool)
         return VERR_NO_MEMORY;
 
@@ -675,31 +1074,51 @@ RTDECL(int) RTReqPoolCreate(uint32_t cMaxThreads, RTMSINTERVAL cMsMinIdle,
     pPool->cThreadsCreated      = 0;
     pPool->uLastThreadCreateNanoTs = 0;
     RTListInit(&pPool->WorkerThreads);
-    pPool->cReqProcessed        = 0;
-    pPool->cNsTotalReqProcessing= 0;
-    pPool->cNsTotalReqQueued    = 0;
     pPool->cRefs                = 1;
     pPool->cIdleThreads         = 0;
     RTListInit(&pPool->IdleThreads);
-    pPool->pPendingRequests     = NULL;
-    pPool->ppPendingRequests    = &pPool->pPendingRequests;
-    pPool->cCurPendingRequests  = 0;
-    pPool->cCurActiveRequests   = 0;
+    pPool->cWorkQs              = RT_MIN(cMaxThreads, RTREQPOOL_MAX_WORK_QUEUES);
+    pPool->paWorkQs             = NULL;
     pPool->cReqSubmitted        = 0;
+    pPool->hFreeSpinlock        = NIL_RTSPINLOCK;
     pPool->pFreeRequests        = NULL;
     pPool->cCurFreeRequests     = 0;
 
-    int rc = RTSemEventMultiCreate(&pPool->hThreadTermEvt);
-    if (RT_SUCCESS(rc))
+    int rc = VERR_NO_MEMORY;
+    pPool->paWorkQs = (PRTREQPOOLWORKQ)RTMemAllocZ(sizeof(pPool->paWorkQs[0]) * pPool->cWorkQs);
+    if (pPool->paWorkQs)
     {
-        rc = RTCritSectInit(&pPool->CritSect);
+        uint32_t iWorkQ;
+        for (iWorkQ = 0; iWorkQ < pPool->cWorkQs; iWorkQ++)
+        {
+            pPool->paWorkQs[iWorkQ].s.ppTail = &pPool->paWorkQs[iWorkQ].s.pHead;
+            rc = RTSpinlockCreate(&pPool->paWorkQs[iWorkQ].s.hSpinlock, RTSPINLOCK_FLAGS_INTERRUPT_UNSAFE, "RTReqPoolWorkQ");
+            if (RT_FAILURE(rc))
+                break;
+        }
         if (RT_SUCCESS(rc))
         {
-            *phPool = pPool;
-            return VINF_SUCCESS;
+            rc = RTSpinlockCreate(&pPool->hFreeSpinlock, RTSPINLOCK_FLAGS_INTERRUPT_UNSAFE, "RTReqPoolFree");
+            if (RT_SUCCESS(rc))
+            {
+                rc = RTSemEventMultiCreate(&pPool->hThreadTermEvt);
+                if (RT_SUCCESS(rc))
+                {
+                    rc = RTCritSectInit(&pPool->CritSect);
+                    if (RT_SUCCESS(rc))
+                    {
+                        *phPool = pPool;
+                        return VINF_SUCCESS;
+                    }
+
+                    RTSemEventMultiDestroy(pPool->hThreadTermEvt);
+                }
+                RTSpinlockDestroy(pPool->hFreeSpinlock);
+            }
         }
-
-        RTSemEventMultiDestroy(pPool->hThreadTermEvt);
+        while (iWorkQ-- > 0)
+            RTSpinlockDestroy(pPool->paWorkQs[iWorkQ].s.hSpinlock);
+        RTMemFree(pPool->paWorkQs);
     }
     pPool->u32Magic = RTREQPOOL_MAGIC_DEAD;
     RTMemFree(pPool);
@@ -830,12 +1249,25 @@ RTDECL(int) RTReqPoolSetCfgVar(RTREQPOOL hPool, RTREQPOOLCFGVAR enmVar, uint64_t
                 pPool->cMaxFreeRequests = (uint32_t)uValue;
             }
 
-            while (pPool->cCurFreeRequests > pPool->cMaxFreeRequests)
             {
-                PRTREQINT pReq = pPool->pFreeRequests;
-                pPool->pFreeRequests = pReq->pNext;
-                ASMAtomicDecU32(&pPool->cCurFreeRequests);
-                rtReqFreeIt(pReq);
+                PRTREQINT pToFree = NULL;
+                RTSpinlockAcquire(pPool->hFreeSpinlock);
+                while (pPool->cCurFreeRequests > pPool->cMaxFreeRequests)
+                {
+                    PRTREQINT pReq = pPool->pFreeRequests;
+                    pPool->pFreeRequests = pReq->pNext;
+                    ASMAtomicDecU32(&pPool->cCurFreeRequests);
+                    pReq->pNext = pToFree;
+                    pToFree = pReq;
+                }
+                RTSpinlockRelease(pPool->hFreeSpinlock);
+
+                while (pToFree)
+                {
+                    PRTREQINT pReq = pToFree;
+                    pToFree = pReq->pNext;
+                    rtReqFreeIt(pReq);
+                }
             }
             break;
 
@@ -932,20 +1364,54 @@ RTDECL(uint64_t) RTReqPoolGetStat(RTREQPOOL hPool, RTREQPOOLSTAT enmStat)
 
     RTCritSectEnter(&pPool->CritSect);
 
+    /*
+     * Sum up the statistics of the worker threads and queues.  The worker
+     * threads update theirs without any locking, so this is a snapshot.
+     */
+    RTREQPOOLSTATS Stats = pPool->StatsRetired;
+    uint32_t       cActive = 0;
+    PRTREQPOOLTHREAD pThread;
+    RTListForEach(&pPool->WorkerThreads, pThread, RTREQPOOLTHREAD, ListNode)
+    {
+        rtReqPoolStatsAdd(&Stats, &pThread->Stats);
+        if (pThread->pPendingReq)
+            cActive++;
+    }
+
+    uint64_t cReqSubmitted = pPool->cReqSubmitted;
+    uint32_t cPending      = 0;
+    uint32_t cMaxPending   = 0;
+    for (uint32_t iWorkQ = 0; iWorkQ < pPool->cWorkQs; iWorkQ++)
+    {
+        PRTREQPOOLWORKQ pWorkQ = &pPool->paWorkQs[iWorkQ];
+        RTSpinlockAcquire(pWorkQ->s.hSpinlock);
+        cReqSubmitted += pWorkQ->s.cReqSubmitted;
+        cPending      += pWorkQ->s.cReqs;
+        cMaxPending    = RT_MAX(cMaxPending, pWorkQ->s.cMaxReqs);
+        RTSpinlockRelease(pWorkQ->s.hSpinlock);
+    }
+
     uint64_t u64;
     switch (enmStat)
     {
         case RTREQPOOLSTAT_THREADS:                     u64 = pPool->cCurThreads; break;
         case RTREQPOOLSTAT_THREADS_CREATED:             u64 = pPool->cThreadsCreated; break;
-        case RTREQPOOLSTAT_REQUESTS_PROCESSED:          u64 = pPool->cReqProcessed; break;
-        case RTREQPOOLSTAT_REQUESTS_SUBMITTED:          u64 = pPool->cReqSubmitted; break;
-        case RTREQPOOLSTAT_REQUESTS_PENDING:            u64 = pPool->cCurPendingRequests; break;
-        case RTREQPOOLSTAT_REQUESTS_ACTIVE:             u64 = pPool->cCurActiveRequests; break;
+        case RTREQPOOLSTAT_REQUESTS_PROCESSED:          u64 = Stats.cReqProcessed; break;
+        case RTREQPOOLSTAT_REQUESTS_SUBMITTED:          u64 = cReqSubmitted; break;
+        case RTREQPOOLSTAT_REQUESTS_PENDING:            u64 = cPending; break;
+        case RTREQPOOLSTAT_REQUESTS_ACTIVE:             u64 = cActive; break;
         case RTREQPOOLSTAT_REQUESTS_FREE:               u64 = pPool->cCurFreeRequests; break;
-        case RTREQPOOLSTAT_NS_TOTAL_REQ_PROCESSING:     u64 = pPool->cNsTotalReqProcessing; break;
-        case RTREQPOOLSTAT_NS_TOTAL_REQ_QUEUED:         u64 = pPool->cNsTotalReqQueued; break;
-        case RTREQPOOLSTAT_NS_AVERAGE_REQ_PROCESSING:   u64 = pPool->cNsTotalReqProcessing / RT_MAX(pPool->cReqProcessed, 1); break;
-        case RTREQPOOLSTAT_NS_AVERAGE_REQ_QUEUED:       u64 = pPool->cNsTotalReqQueued / RT_MAX(pPool->cReqProcessed, 1); break;
+        case RTREQPOOLSTAT_NS_TOTAL_REQ_PROCESSING:     u64 = Stats.cNsTotalReqProcessing; break;
+        case RTREQPOOLSTAT_NS_TOTAL_REQ_QUEUED:         u64 = Stats.cNsTotalReqQueued; break;
+        case RTREQPOOLSTAT_NS_AVERAGE_REQ_PROCESSING:   u64 = Stats.cNsTotalReqProcessing / RT_MAX(Stats.cReqProcessed, 1); break;
+        case RTREQPOOLSTAT_NS_AVERAGE_REQ_QUEUED:       u64 = Stats.cNsTotalReqQueued / RT_MAX(Stats.cReqProcessed, 1); break;
+        case RTREQPOOLSTAT_REQUESTS_STOLEN:             u64 = Stats.cReqStolen; break;
+        case RTREQPOOLSTAT_REQUESTS_PENDING_MAX:        u64 = cMaxPending; break;
+        case RTREQPOOLSTAT_NS_MAX_REQ_PROCESSING:       u64 = Stats.cNsMaxReqProcessing; break;
+        case RTREQPOOLSTAT_NS_MAX_REQ_QUEUED:           u64 = Stats.cNsMaxReqQueued; break;
+        case RTREQPOOLSTAT_NS_P50_REQ_QUEUED:           u64 = rtReqPoolStatsQueuedPercentile(&Stats, 50); break;
+        case RTREQPOOLSTAT_NS_P90_REQ_QUEUED:           u64 = rtReqPoolStatsQueuedPercentile(&Stats, 90); break;
+        case RTREQPOOLSTAT_NS_P99_REQ_QUEUED:           u64 = rtReqPoolStatsQueuedPercentile(&Stats, 99); break;
         default:
             AssertFailed();
             u64 = UINT64_MAX;
@@ -1003,17 +1469,6 @@ RTDECL(uint32_t) RTReqPoolRelease(RTREQPOOL hPool)
             RTThreadUserSignal(pThread->hThread);
         }
 
-        /* Cancel pending requests. */
-        Assert(!pPool->pPendingRequests);
-        while (pPool->pPendingRequests)
-        {
-            PRTREQINT pReq = pPool->pPendingRequests;
-            pPool->pPendingRequests = pReq->pNext;
-            rtReqPoolCancelReq(pReq);
-        }
-        pPool->ppPendingRequests = NULL;
-        pPool->cCurPendingRequests = 0;
-
         /* Wait for the workers to shut down. */
         while (!RTListIsEmpty(&pPool->WorkerThreads))
         {
@@ -1023,6 +1478,24 @@ RTDECL(uint32_t) RTReqPoolRelease(RTREQPOOL hPool)
             /** @todo should we wait forever here? */
         }
 
+        /* Cancel pending requests. */
+        for (uint32_t iWorkQ = 0; iWorkQ < pPool->cWorkQs; iWorkQ++)
+        {
+            PRTREQPOOLWORKQ pWorkQ = &pPool->paWorkQs[iWorkQ];
+            Assert(!pWorkQ->s.pHead);
+            while (pWorkQ->s.pHead)
+            {
+                PRTREQINT pReq = pWorkQ->s.pHead;
+                pWorkQ->s.pHead = pReq->pNext;
+                pReq->pNext = NULL;
+                rtReqPoolCancelReq(pReq);
+            }
+            pWorkQ->s.ppTail = NULL;
+            pWorkQ->s.cReqs  = 0;
+            RTSpinlockDestroy(pWorkQ->s.hSpinlock);
+            pWorkQ->s.hSpinlock = NIL_RTSPINLOCK;
+        }
+
         /* Free recycled requests. */
         for (;;)
         {
@@ -1037,6 +1510,9 @@ RTDECL(uint32_t) RTReqPoolRelease(RTREQPOOL hPool)
         /* Finally, free the critical section and pool instance. */
         RTCritSectLeave(&pPool->CritSect);
         RTCritSectDelete(&pPool->CritSect);
+        RTSpinlockDestroy(pPool->hFreeSpinlock);
+        RTSemEventMultiDestroy(pPool->hThreadTermEvt);
+        RTMemFree(pPool->paWorkQs);
         RTMemFree(pPool);
     }
 
@@ -1056,14 +1532,14 @@ RTDECL(int) RTReqPoolAlloc(RTREQPOOL hPool, RTREQTYPE enmType, PRTREQ *phReq)
      */
     if (ASMAtomicReadU32(&pPool->cCurFreeRequests) > 0)
     {
-        RTCritSectEnter(&pPool->CritSect);
+        RTSpinlockAcquire(pPool->hFreeSpinlock);
         PRTREQINT pReq = pPool->pFreeRequests;
         if (pReq)
         {
             ASMAtomicDecU32(&pPool->cCurFreeRequests);
             pPool->pFreeRequests = pReq->pNext;
 
-            RTCritSectLeave(&pPool->CritSect);
+            RTSpinlockRelease(pPool->hFreeSpinlock);
 
             Assert(pReq->fPoolOrQueue);
             Assert(pReq->uOwner.hPool == pPool);
@@ -1077,7 +1553,7 @@ RTDECL(int) RTReqPoolAlloc(RTREQPOOL hPool, RTREQTYPE enmType, PRTREQ *phReq)
             }
         }
         else
-            RTCritSectLeave(&pPool->CritSect);
+            RTSpinlockRelease(pPool->hFreeSpinlock);
     }
 
     /*
@@ -1208,3 +1684,119 @@ RTDECL(int) RTReqPoolCallVoidNoWait(RTREQPOOL hPool, PFNRT pfnFunction, unsigned
 }
 RT_EXPORT_SYMBOL(RTReqPoolCallVoidNoWait);
 
+
+
+RTDECL(int) RTReqPoolCallBatch(RTREQPOOL hPool, RTMSINTERVAL cMillies, PRTREQ *pahReqs, uint32_t fFlags,
+                               PFNRT pfnFunction, size_t cCalls, void * const *papvArgs)
+{
+    /*
+     * Check input.
+     */
+    PRTREQPOOLINT pPool = hPool;
+    AssertPtrReturn(pPool, VERR_INVALID_HANDLE);
+    AssertReturn(pPool->u32Magic == RTREQPOOL_MAGIC, VERR_INVALID_HANDLE);
+    AssertPtrReturn(pfnFunction, VERR_INVALID_POINTER);
+    AssertMsgReturn(!((uint32_t)fFlags & ~(uint32_t)(RTREQFLAGS_NO_WAIT | RTREQFLAGS_RETURN_MASK)), ("%#x\n", (uint32_t)fFlags), VERR_INVALID_PARAMETER);
+    AssertReturn(cCalls > 0 && cCalls <= _1M, VERR_OUT_OF_RANGE);
+    AssertPtrReturn(papvArgs, VERR_INVALID_POINTER);
+    if (!(fFlags & RTREQFLAGS_NO_WAIT))
+        AssertPtrReturn(pahReqs, VERR_INVALID_POINTER);
+    if (pahReqs)
+        for (size_t i = 0; i < cCalls; i++)
+            pahReqs[i] = NIL_RTREQ;
+
+    /*
+     * Allocate, initialize and submit the requests in chunks.  With
+     * RTREQFLAGS_NO_WAIT the caller's reference is donated to the pool,
+     * otherwise we retain one for it like RTReqSubmit does.
+     */
+    int         rc = VINF_SUCCESS;
+    PRTREQINT   apReqs[64];
+    size_t      iCall = 0;
+    while (iCall < cCalls)
+    {
+        uint32_t const cChunk = (uint32_t)RT_MIN(cCalls - iCall, RT_ELEMENTS(apReqs));
+        uint32_t       cAlloced;
+        for (cAlloced = 0; cAlloced < cChunk; cAlloced++)
+        {
+            PRTREQINT pReq;
+            rc = RTReqPoolAlloc(pPool, RTREQTYPE_INTERNAL, &pReq);
+            if (RT_FAILURE(rc))
+                break;
+            pReq->fFlags              = fFlags;
+            pReq->u.Internal.pfn      = pfnFunction;
+            pReq->u.Internal.cArgs    = 1;
+            pReq->u.Internal.aArgs[0] = (uintptr_t)papvArgs[iCall + cAlloced];
+            apReqs[cAlloced] = pReq;
+        }
+        if (RT_FAILURE(rc))
+        {
+            while (cAlloced-- > 0)
+                RTReqRelease(apReqs[cAlloced]);
+            break;
+        }
+
+        uint64_t const uNanoTs = RTTimeNanoTS();
+        for (uint32_t i = 0; i < cChunk; i++)
+        {
+            PRTREQINT pReq = apReqs[i];
+            pReq->uSubmitNanoTs = uNanoTs;
+            pReq->enmState      = RTREQSTATE_QUEUED;
+            if (!(fFlags & RTREQFLAGS_NO_WAIT))
+            {
+                RTReqRetain(pReq);
+                pahReqs[iCall + i] = pReq;
+            }
+        }
+        rtReqPoolSubmitBatch(pPool, apReqs, cChunk);
+        iCall += cChunk;
+    }
+
+    /*
+     * Wait for the lot to complete.
+     */
+    if (   RT_SUCCESS(rc)
+        && !(fFlags & RTREQFLAGS_NO_WAIT))
+    {
+        uint64_t const msStart = RTTimeMilliTS();
+        for (size_t i = 0; i < cCalls; i++)
+        {
+            RTMSINTERVAL cMsLeft = cMillies;
+            if (cMillies != RT_INDEFINITE_WAIT)
+            {
+                uint64_t const cMsElapsed = RTTimeMilliTS() - msStart;
+                cMsLeft = cMsElapsed < cMillies ? cMillies - (RTMSINTERVAL)cMsElapsed : 0;
+            }
+            rc = RTReqWait(pahReqs[i], cMsLeft);
+            if (RT_FAILURE(rc))
+                break;
+        }
+    }
+
+    LogFlow(("RTReqPoolCallBatch: returns %Rrc (cCalls=%zu)\n", rc, cCalls));
+    return rc;
+}
+RT_EXPORT_SYMBOL(RTReqPoolCallBatch);
+
+
+RTDECL(int) RTReqPoolCallBatchWait(RTREQPOOL hPool, PFNRT pfnFunction, size_t cCalls, void * const *papvArgs)
+{
+    AssertReturn(cCalls > 0 && cCalls <= _1M, VERR_OUT_OF_RANGE);
+    PRTREQ *papReqs = (PRTREQ *)RTMemTmpAlloc(sizeof(papReqs[0]) * cCalls);
+    if (!papReqs)
+        return VERR_NO_TMP_MEMORY;
+
+    int rc = RTReqPoolCallBatch(hPool, RT_INDEFINITE_WAIT, papReqs, RTREQFLAGS_IPRT_STATUS,
+                                pfnFunction, cCalls, papvArgs);
+    for (size_t i = 0; i < cCalls; i++)
+        if (papReqs[i] != NIL_RTREQ)
+        {
+            if (RT_SUCCESS(rc) && RT_FAILURE(papReqs[i]->iStatusX))
+                rc = papReqs[i]->iStatusX;
+            RTReqRelease(papReqs[i]);
+        }
+
+    RTMemTmpFree(papReqs);
+    return rc;
+}
+RT_EXPORT_SYMBOL(RTReqPoolCallBatchWait);
@@ -0,0 +1,227 @@
+/* $Id: introsort.cpp $ */
+/** @file
+ * IPRT - RTSort and RTSortApv, introspective sort.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "internal/iprt.h"
+#include <iprt/sort.h>
+
+#include <iprt/assert.h>
+#include "internal/sort.h"
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** Partitions at or below this size are left to the insertion sort. */
+#define RTSORT_INSERTION_THRESHOLD  16
+
+
+/**
+ * Insertion sort, used for small partitions.
+ *
+ * @param   pState      The sorting parameters.
+ * @param   pbArray     The first element.
+ * @param   cElements   The number of elements.
+ */
+static void rtSortInsertion(PCRTSORTSTATE pState, uint8_t *pbArray, size_t cElements)
+{
+    size_t const cb = pState->cbElement;
+    for (size_t i = 1; i < cElements; i++)
+    {
+        uint8_t *pbCur = pbArray + i * cb;
+        while (   pbCur != pbArray
+               && rtSortCmp(pState, pbCur - cb, pbCur) > 0)
+        {
+            rtSortSwap(pbCur - cb, pbCur, cb);
+            pbCur -= cb;
+        }
+    }
+}
+
+
+/**
+ * Heap sort, the fallback when the quick sort recursion gets too deep.
+ *
+ * @param   pState      The sorting parameters.
+ * @param   pbArray     The first element.
+ * @param   cElements   The number of elements.
+ */
+static void rtSortHeap(PCRTSORTSTATE pState, uint8_t *pbArray, size_t cElements)
+{
+    size_t const cb = pState->cbElement;
+
+    /* Build a max-heap, then repeatedly move the top to the end. */
+    size_t iStart = cElements / 2;
+    size_t cHeap  = cElements;
+    for (;;)
+    {
+        if (iStart > 0)
+            iStart--;
+        else
+        {
+            if (cHeap <= 1)
+                break;
+            cHeap--;
+            rtSortSwap(pbArray, pbArray + cHeap * cb, cb);
+        }
+
+        /* Sift down. */
+        size_t iParent = iStart;
+        for (;;)
+        {
+            size_t iChild = iParent * 2 + 1;
+            if (iChild >= cHeap)
+                break;
+            if (   iChild + 1 < cHeap
+                && rtSortCmp(pState, pbArray + iChild * cb, pbArray + (iChild + 1) * cb) < 0)
+                iChild++;
+            if (rtSortCmp(pState, pbArray + iParent * cb, pbArray + iChild * cb) >= 0)
+                break;
+            rtSortSwap(pbArray + iParent * cb, pbArray + iChild * cb, cb);
+            iParent = iChild;
+        }
+    }
+}
+
+
+/**
+ * The introsort worker.
+ *
+ * Quick sort with median of three pivots, recursing into the smaller
+ * partition and switching to heap sort when the depth budget runs out.
+ *
+ * @param   pState      The sorting parameters.
+ * @param   pbArray     The first element.
+ * @param   cElements   The number of elements.
+ * @param   cDepth      The remaining recursion depth budget.
+ */
+static void rtSortIntro(PCRTSORTSTATE pState, uint8_t *pbArray, size_t cElements, unsigned cDepth)
+{
+    size_t const cb = pState->cbElement;
+    while (cElements > RTSORT_INSERTION_THRESHOLD)
+    {
+        if (!cDepth)
+        {
+            rtSortHeap(pState, pbArray, cElements);
+            return;
+        }
+        cDepth--;
+
+        /*
+         * Median of three, the result ends up in the first element where it
+         * stays during the partitioning.
+         */
+        uint8_t *pbMid  = pbArray + (cElements / 2) * cb;
+        uint8_t *pbLast = pbArray + (cElements - 1) * cb;
+        if (rtSortCmp(pState, pbMid, pbArray) < 0)
+            rtSortSwap(pbMid, pbArray, cb);
+        if (rtSortCmp(pState, pbLast, pbMid) < 0)
+        {
+            rtSortSwap(pbLast, pbMid, cb);
+            if (rtSortCmp(pState, pbMid, pbArray) < 0)
+                rtSortSwap(pbMid, pbArray, cb);
+        }
+        rtSortSwap(pbArray, pbMid, cb);
+
+        /*
+         * Partition.  Both scans stop on elements equal to the pivot, which
+         * keeps arrays with many duplicates balanced.  The pivot in the first
+         * element stops the right scan.
+         */
+        size_t i = 0;
+        size_t j = cElements;
+        for (;;)
+        {
+            do
+                i++;
+            while (i < cElements && rtSortCmp(pState, pbArray + i * cb, pbArray) < 0);
+            do
+                j--;
+            while (rtSortCmp(pState, pbArray + j * cb, pbArray) > 0);
+            if (i >= j)
+                break;
+            rtSortSwap(pbArray + i * cb, pbArray + j * cb, cb);
+        }
+        rtSortSwap(pbArray, pbArray + j * cb, cb);
+
+        /* Recurse on the smaller side, loop on the larger. */
+        size_t const cLeft  = j;
+        size_t const cRight = cElements - j - 1;
+        if (cLeft < cRight)
+        {
+            rtSortIntro(pState, pbArray, cLeft, cDepth);
+            pbArray  += (j + 1) * cb;
+            cElements = cRight;
+        }
+        else
+        {
+            rtSortIntro(pState, pbArray + (j + 1) * cb, cRight, cDepth);
+            cElements = cLeft;
+        }
+    }
+
+    rtSortInsertion(pState, pbArray, cElements);
+}
+
+
+/**
+ * Common worker for RTSort and RTSortApv.
+ */
+static void rtSortCommon(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser, bool fApv)
+{
+    if (cElements < 2)
+        return;
+
+    RTSORTSTATE State;
+    State.cbElement = cbElement;
+    State.pfnCmp    = pfnCmp;
+    State.pvUser    = pvUser;
+    State.fApv      = fApv;
+
+    /* 2 * log2(n) is the usual depth budget. */
+    unsigned cDepth = 0;
+    for (size_t c = cElements; c > 1; c >>= 1)
+        cDepth += 2;
+    rtSortIntro(&State, (uint8_t *)pvArray, cElements, cDepth);
+}
+
+
+RTDECL(void) RTSort(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    AssertReturnVoid(cbElement > 0);
+    rtSortCommon(pvArray, cElements, cbElement, pfnCmp, pvUser, false /*fApv*/);
+}
+RT_EXPORT_SYMBOL(RTSort);
+
+
+RTDECL(void) RTSortApv(void **papvArray, size_t cElements, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    rtSortCommon(papvArray, cElements, sizeof(void *), pfnCmp, pvUser, true /*fApv*/);
+}
+RT_EXPORT_SYMBOL(RTSortApv);
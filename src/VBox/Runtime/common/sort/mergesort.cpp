@@ -0,0 +1,429 @@
+/* $Id: mergesort.cpp $ */
+/** @file
+ * IPRT - RTSortStable and RTSortParallel, merge sort.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "internal/iprt.h"
+#include <iprt/sort.h>
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/mp.h>
+#include <iprt/req.h>
+#include <iprt/string.h>
+#include "internal/sort.h"
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The length of the runs sorted by insertion sort before merging. */
+#define RTSORT_RUN_LENGTH               16
+/** Arrays smaller than this are not worth handing to the thread pool. */
+#define RTSORT_PARALLEL_MIN_ELEMENTS    _32K
+/** The minimum number of elements per parallel task. */
+#define RTSORT_PARALLEL_MIN_PER_TASK    _8K
+/** The max number of parallel tasks per pass.  This must not exceed the
+ *  number of requests RTReqPoolCallBatch submits in one chunk, so that a
+ *  failure means that none of the tasks were started. */
+#define RTSORT_PARALLEL_MAX_TASKS       64
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+/**
+ * A parallel sort task.
+ *
+ * The task either sorts a chunk of the array (cRight is 0 and pbDst is NULL)
+ * or merges a slice of two adjacent runs into the destination buffer.
+ */
+typedef struct RTSORTTASK
+{
+    /** The sorting parameters. */
+    PCRTSORTSTATE   pState;
+    /** The left run slice, or the chunk to sort. */
+    uint8_t        *pbLeft;
+    /** Number of elements in the left slice or chunk. */
+    size_t          cLeft;
+    /** The right run slice. */
+    uint8_t const  *pbRight;
+    /** Number of elements in the right slice. */
+    size_t          cRight;
+    /** The merge destination, or NULL when sorting a chunk. */
+    uint8_t        *pbDst;
+    /** The scratch buffer for sorting a chunk, same size as the chunk. */
+    uint8_t        *pbTmp;
+} RTSORTTASK;
+/** Pointer to a parallel sort task. */
+typedef RTSORTTASK *PRTSORTTASK;
+
+
+/**
+ * Merges two sorted runs, taking from the left one on ties.
+ *
+ * @param   pState      The sorting parameters.
+ * @param   pbLeft      The left run.
+ * @param   cLeft       Number of elements in the left run.
+ * @param   pbRight     The right run.
+ * @param   cRight      Number of elements in the right run.
+ * @param   pbDst       The destination, room for cLeft + cRight elements and
+ *                      not overlapping the runs.
+ */
+static void rtSortMerge(PCRTSORTSTATE pState, uint8_t const *pbLeft, size_t cLeft,
+                        uint8_t const *pbRight, size_t cRight, uint8_t *pbDst)
+{
+    size_t const cb = pState->cbElement;
+
+    /* Already in order?  Common with partially sorted input. */
+    if (   cLeft
+        && cRight
+        && rtSortCmp(pState, pbLeft + (cLeft - 1) * cb, pbRight) > 0)
+    {
+        for (;;)
+        {
+            if (rtSortCmp(pState, pbLeft, pbRight) <= 0)
+            {
+                rtSortCopy(pbDst, pbLeft, cb);
+                pbLeft += cb;
+                pbDst  += cb;
+                if (!--cLeft)
+                    break;
+            }
+            else
+            {
+                rtSortCopy(pbDst, pbRight, cb);
+                pbRight += cb;
+                pbDst   += cb;
+                if (!--cRight)
+                    break;
+            }
+        }
+    }
+
+    memcpy(pbDst, pbLeft, cLeft * cb);
+    memcpy(pbDst + cLeft * cb, pbRight, cRight * cb);
+}
+
+
+/**
+ * Stable sort of an array using a scratch buffer of the same size.
+ *
+ * Bottom-up merge sort on insertion sorted runs, merging back and forth
+ * between the array and the scratch buffer.
+ *
+ * @param   pState      The sorting parameters.
+ * @param   pbArray     The array.
+ * @param   cElements   The number of elements.
+ * @param   pbTmp       The scratch buffer.
+ */
+static void rtSortMergeWorker(PCRTSORTSTATE pState, uint8_t *pbArray, size_t cElements, uint8_t *pbTmp)
+{
+    size_t const cb = pState->cbElement;
+
+    /* Insertion sort the runs, it's stable as long as we don't move equal elements. */
+    for (size_t iRun = 0; iRun < cElements; iRun += RTSORT_RUN_LENGTH)
+    {
+        uint8_t *pbRun = pbArray + iRun * cb;
+        size_t   cRun  = RT_MIN(RTSORT_RUN_LENGTH, cElements - iRun);
+        for (size_t i = 1; i < cRun; i++)
+        {
+            uint8_t *pbCur = pbRun + i * cb;
+            while (   pbCur != pbRun
+                   && rtSortCmp(pState, pbCur - cb, pbCur) > 0)
+            {
+                rtSortSwap(pbCur - cb, pbCur, cb);
+                pbCur -= cb;
+            }
+        }
+    }
+
+    /* Merge the runs. */
+    uint8_t *pbSrc = pbArray;
+    uint8_t *pbDst = pbTmp;
+    for (size_t cRun = RTSORT_RUN_LENGTH; cRun < cElements; cRun *= 2)
+    {
+        for (size_t i = 0; i < cElements; i += 2 * cRun)
+        {
+            size_t const cLeft  = RT_MIN(cRun, cElements - i);
+            size_t const cRight = RT_MIN(cRun, cElements - i - cLeft);
+            rtSortMerge(pState, pbSrc + i * cb, cLeft, pbSrc + (i + cLeft) * cb, cRight, pbDst + i * cb);
+        }
+        uint8_t *pbSwap = pbSrc;
+        pbSrc = pbDst;
+        pbDst = pbSwap;
+    }
+    if (pbSrc != pbArray)
+        memcpy(pbArray, pbSrc, cElements * cb);
+}
+
+
+/**
+ * Common worker for RTSortStable and RTSortApvStable.
+ */
+static int rtSortStableCommon(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser, bool fApv)
+{
+    if (cElements < 2)
+        return VINF_SUCCESS;
+
+    RTSORTSTATE State;
+    State.cbElement = cbElement;
+    State.pfnCmp    = pfnCmp;
+    State.pvUser    = pvUser;
+    State.fApv      = fApv;
+
+    /* Small arrays only need the insertion sort pass and no scratch buffer. */
+    uint8_t *pbTmp = NULL;
+    if (cElements > RTSORT_RUN_LENGTH)
+    {
+        pbTmp = (uint8_t *)RTMemTmpAlloc(cElements * cbElement);
+        if (!pbTmp)
+            return VERR_NO_TMP_MEMORY;
+    }
+    rtSortMergeWorker(&State, (uint8_t *)pvArray, cElements, pbTmp);
+    RTMemTmpFree(pbTmp);
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(int) RTSortStable(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    AssertReturn(cbElement > 0, VERR_INVALID_PARAMETER);
+    return rtSortStableCommon(pvArray, cElements, cbElement, pfnCmp, pvUser, false /*fApv*/);
+}
+RT_EXPORT_SYMBOL(RTSortStable);
+
+
+RTDECL(int) RTSortApvStable(void **papvArray, size_t cElements, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    return rtSortStableCommon(papvArray, cElements, sizeof(void *), pfnCmp, pvUser, true /*fApv*/);
+}
+RT_EXPORT_SYMBOL(RTSortApvStable);
+
+
+/**
+ * Parallel sort task worker, called on the pool threads.
+ *
+ * @returns VINF_SUCCESS.
+ * @param   pTask       The task.
+ */
+static DECLCALLBACK(int) rtSortParallelTask(PRTSORTTASK pTask)
+{
+    if (pTask->pbDst)
+        rtSortMerge(pTask->pState, pTask->pbLeft, pTask->cLeft, pTask->pbRight, pTask->cRight, pTask->pbDst);
+    else
+        rtSortMergeWorker(pTask->pState, pTask->pbLeft, pTask->cLeft, pTask->pbTmp);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Runs a batch of tasks on the pool, doing them on the calling thread if the
+ * pool cannot take them.
+ *
+ * The tasks only read their source and write their own destination range, so
+ * running them again after a partial failure is harmless.
+ *
+ * @param   hPool       The request pool.
+ * @param   paTasks     The tasks.
+ * @param   cTasks      The number of tasks.
+ */
+static void rtSortParallelRun(RTREQPOOL hPool, PRTSORTTASK paTasks, size_t cTasks)
+{
+    void *apvArgs[RTSORT_PARALLEL_MAX_TASKS];
+    Assert(cTasks <= RT_ELEMENTS(apvArgs));
+    for (size_t i = 0; i < cTasks; i++)
+        apvArgs[i] = &paTasks[i];
+
+    if (cTasks > 1)
+    {
+        int rc = RTReqPoolCallBatchWait(hPool, (PFNRT)rtSortParallelTask, cTasks, apvArgs);
+        if (RT_SUCCESS(rc))
+            return;
+    }
+    for (size_t i = 0; i < cTasks; i++)
+        rtSortParallelTask(&paTasks[i]);
+}
+
+
+/**
+ * Finds how many elements of the left run go into the first @a iOut elements
+ * of the stable merge of two runs.
+ *
+ * @returns Number of left run elements, the rest is from the right run.
+ * @param   pState      The sorting parameters.
+ * @param   pbLeft      The left run.
+ * @param   cLeft       Number of elements in the left run.
+ * @param   pbRight     The right run.
+ * @param   cRight      Number of elements in the right run.
+ * @param   iOut        The output position.
+ */
+static size_t rtSortCoRank(PCRTSORTSTATE pState, uint8_t const *pbLeft, size_t cLeft,
+                           uint8_t const *pbRight, size_t cRight, size_t iOut)
+{
+    size_t const cb = pState->cbElement;
+    size_t iLo = iOut > cRight ? iOut - cRight : 0;
+    size_t iHi = RT_MIN(iOut, cLeft);
+    while (iLo < iHi)
+    {
+        /* Too few left elements if the next left one sorts before (or ties
+           with) the last right one we'd be taking. */
+        size_t const i = iLo + (iHi - iLo) / 2;
+        size_t const j = iOut - i;
+        if (   j > 0
+            && rtSortCmp(pState, pbLeft + i * cb, pbRight + (j - 1) * cb) <= 0)
+            iLo = i + 1;
+        else
+            iHi = i;
+    }
+    return iLo;
+}
+
+
+/**
+ * Common worker for RTSortParallel and RTSortApvParallel.
+ */
+static int rtSortParallelCommon(RTREQPOOL hPool, void *pvArray, size_t cElements, size_t cbElement,
+                                PFNRTSORTCMP pfnCmp, void *pvUser, bool fApv)
+{
+    /*
+     * Figure out how many tasks to use per pass.  More tasks than CPUs
+     * evens out the load when the pool threads are competing with others.
+     */
+    size_t cTasks = 0;
+    if (   hPool != NIL_RTREQPOOL
+        && cElements >= RTSORT_PARALLEL_MIN_ELEMENTS)
+    {
+        cTasks = RT_MIN((size_t)RTMpGetOnlineCount() * 2, RTSORT_PARALLEL_MAX_TASKS);
+        cTasks = RT_MIN(cTasks, cElements / RTSORT_PARALLEL_MIN_PER_TASK);
+    }
+    if (cTasks < 2)
+        return rtSortStableCommon(pvArray, cElements, cbElement, pfnCmp, pvUser, fApv);
+
+    RTSORTSTATE State;
+    State.cbElement = cbElement;
+    State.pfnCmp    = pfnCmp;
+    State.pvUser    = pvUser;
+    State.fApv      = fApv;
+
+    size_t const cb    = cbElement;
+    uint8_t     *pbTmp = (uint8_t *)RTMemAlloc(cElements * cb);
+    if (!pbTmp)
+        return VERR_NO_MEMORY;
+    RTSORTTASK   aTasks[RTSORT_PARALLEL_MAX_TASKS];
+    size_t       aoffRuns[RTSORT_PARALLEL_MAX_TASKS + 1];
+
+    /*
+     * Sort the chunks.
+     */
+    uint8_t *pbSrc = (uint8_t *)pvArray;
+    uint8_t *pbDst = pbTmp;
+    size_t   cRuns = cTasks;
+    for (size_t i = 0; i <= cRuns; i++)
+        aoffRuns[i] = cElements * i / cRuns;
+    for (size_t i = 0; i < cRuns; i++)
+    {
+        aTasks[i].pState  = &State;
+        aTasks[i].pbLeft  = pbSrc + aoffRuns[i] * cb;
+        aTasks[i].cLeft   = aoffRuns[i + 1] - aoffRuns[i];
+        aTasks[i].pbRight = NULL;
+        aTasks[i].cRight  = 0;
+        aTasks[i].pbDst   = NULL;
+        aTasks[i].pbTmp   = pbDst + aoffRuns[i] * cb;
+    }
+    rtSortParallelRun(hPool, aTasks, cRuns);
+
+    /*
+     * Merge pairs of runs until there is only one left.  Each pair merge is
+     * split up into slices of the output so that all passes keep cTasks
+     * tasks going, the last pass included.
+     */
+    while (cRuns > 1)
+    {
+        size_t const cPairs         = (cRuns + 1) / 2;
+        size_t const cSlicesPerPair = RT_MAX(cTasks / cPairs, 1);
+        size_t       cPassTasks     = 0;
+        for (size_t iPair = 0; iPair < cPairs; iPair++)
+        {
+            size_t const   offLeft   = aoffRuns[iPair * 2];
+            size_t const   cLeft     = aoffRuns[RT_MIN(iPair * 2 + 1, cRuns)] - offLeft;
+            size_t const   cRight    = aoffRuns[RT_MIN(iPair * 2 + 2, cRuns)] - offLeft - cLeft;
+            uint8_t const *pbLeft    = pbSrc + offLeft * cb;
+            uint8_t const *pbRight   = pbLeft + cLeft * cb;
+            size_t         iLeftPrev = 0;
+            size_t         iOutPrev  = 0;
+            for (size_t iSlice = 1; iSlice <= cSlicesPerPair; iSlice++)
+            {
+                size_t const iOut  = (cLeft + cRight) * iSlice / cSlicesPerPair;
+                size_t const iLeft = iSlice < cSlicesPerPair
+                                   ? rtSortCoRank(&State, pbLeft, cLeft, pbRight, cRight, iOut)
+                                   : cLeft;
+                PRTSORTTASK pTask = &aTasks[cPassTasks++];
+                pTask->pState  = &State;
+                pTask->pbLeft  = (uint8_t *)pbLeft + iLeftPrev * cb;
+                pTask->cLeft   = iLeft - iLeftPrev;
+                pTask->pbRight = pbRight + (iOutPrev - iLeftPrev) * cb;
+                pTask->cRight  = (iOut - iLeft) - (iOutPrev - iLeftPrev);
+                pTask->pbDst   = pbDst + (offLeft + iOutPrev) * cb;
+                pTask->pbTmp   = NULL;
+                iLeftPrev = iLeft;
+                iOutPrev  = iOut;
+            }
+            aoffRuns[iPair] = offLeft;
+        }
+        rtSortParallelRun(hPool, aTasks, cPassTasks);
+
+        cRuns = cPairs;
+        aoffRuns[cRuns] = cElements;
+        uint8_t *pbSwap = pbSrc;
+        pbSrc = pbDst;
+        pbDst = pbSwap;
+    }
+
+    if (pbSrc != (uint8_t *)pvArray)
+        memcpy(pvArray, pbSrc, cElements * cb);
+    RTMemFree(pbTmp);
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(int) RTSortParallel(RTREQPOOL hPool, void *pvArray, size_t cElements, size_t cbElement,
+                           PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    AssertReturn(cbElement > 0, VERR_INVALID_PARAMETER);
+    return rtSortParallelCommon(hPool, pvArray, cElements, cbElement, pfnCmp, pvUser, false /*fApv*/);
+}
+RT_EXPORT_SYMBOL(RTSortParallel);
+
+
+RTDECL(int) RTSortApvParallel(RTREQPOOL hPool, void **papvArray, size_t cElements, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    return rtSortParallelCommon(hPool, papvArray, cElements, sizeof(void *), pfnCmp, pvUser, true /*fApv*/);
+}
+RT_EXPORT_SYMBOL(RTSortApvParallel);
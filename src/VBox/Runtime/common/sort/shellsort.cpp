@@ -31,6 +31,36 @@
 #include "internal/iprt.h"
 #include <iprt/sort.h>
 
+#include "internal/sort.h"
+
+
+RTDECL(void) RTSortShell(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    /* Anything worth sorting? */
+    if (cElements < 2)
+        return;
+
+    uint8_t *pbArray = (uint8_t *)pvArray;
+    size_t   cGap    = (cElements + 1) / 2;
+    while (cGap > 0)
+    {
+        size_t i;
+        for (i = cGap; i < cElements; i++)
+        {
+            /* Without a temporary element buffer we have to swap our way down. */
+            size_t j = i;
+            while (   j >= cGap
+                   && pfnCmp(&pbArray[(j - cGap) * cbElement], &pbArray[j * cbElement], pvUser) > 0)
+            {
+                rtSortSwap(&pbArray[(j - cGap) * cbElement], &pbArray[j * cbElement], cbElement);
+                j -= cGap;
+            }
+        }
+
+        cGap /= 2;
+    }
+}
+RT_EXPORT_SYMBOL(RTSortShell);
 
 
 RTDECL(void) RTSortApvShell(void **papvArray, size_t cElements, PFNRTSORTCMP pfnCmp, void *pvUser)
@@ -0,0 +1,742 @@
+/* $Id: btreeru64.cpp $ */
+/** @file
+ * IPRT - B+ tree, uint64_t, range, unique keys.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/btree.h>
+#include "internal/iprt.h"
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/string.h>
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The number of entries in a leaf node.
+ * 16 entries make the key and key-last arrays two cache lines each. */
+#define RTBTREE_LEAF_ENTRIES        16
+/** The number of children of an interior node. */
+#define RTBTREE_INNER_CHILDREN      16
+/** The max number of interior node levels.
+ * Splits leave nodes at least half full, so this covers 8^16 leaves.  Nodes
+ * are only freed when they become empty and the height never grows on
+ * removal, so this holds for any sequence of operations. */
+#define RTBTREE_MAX_HEIGHT          16
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+/**
+ * Leaf node.
+ *
+ * The entries are sorted by key, leaves are never empty.
+ */
+typedef struct RTBTREERU64LEAF
+{
+    /** The number of entries in use. */
+    uint32_t                    cEntries;
+    /** The previous leaf (smaller keys). */
+    struct RTBTREERU64LEAF     *pPrev;
+    /** The next leaf (larger keys). */
+    struct RTBTREERU64LEAF     *pNext;
+    /** The range starts (AVLRU64NODECORE::Key). */
+    AVLRU64KEY                  aKeys[RTBTREE_LEAF_ENTRIES];
+    /** The range ends (AVLRU64NODECORE::KeyLast). */
+    AVLRU64KEY                  aKeysLast[RTBTREE_LEAF_ENTRIES];
+    /** The user nodes. */
+    PAVLRU64NODECORE            apNodes[RTBTREE_LEAF_ENTRIES];
+} RTBTREERU64LEAF;
+/** Pointer to a leaf node. */
+typedef RTBTREERU64LEAF *PRTBTREERU64LEAF;
+
+/**
+ * Interior node.
+ *
+ * All keys in apvChildren[i] are below aKeys[i] and all keys in
+ * apvChildren[i + 1] are equal or above it.  Removals do not update the
+ * separators, so they are bounds rather than the actual smallest keys.
+ */
+typedef struct RTBTREERU64INNER
+{
+    /** The number of children. */
+    uint32_t                    cChildren;
+    /** The separator keys, cChildren - 1 of them are valid. */
+    AVLRU64KEY                  aKeys[RTBTREE_INNER_CHILDREN - 1];
+    /** The children, leaves if this is the bottom interior level. */
+    void                       *apvChildren[RTBTREE_INNER_CHILDREN];
+} RTBTREERU64INNER;
+/** Pointer to an interior node. */
+typedef RTBTREERU64INNER *PRTBTREERU64INNER;
+
+/**
+ * The path from the root to a leaf.
+ */
+typedef struct RTBTREERU64PATH
+{
+    /** The interior nodes, the root first. */
+    PRTBTREERU64INNER           apInner[RTBTREE_MAX_HEIGHT];
+    /** The index of the child taken in each of the interior nodes. */
+    uint32_t                    aidxChild[RTBTREE_MAX_HEIGHT];
+} RTBTREERU64PATH;
+/** Pointer to a B+ tree path. */
+typedef RTBTREERU64PATH *PRTBTREERU64PATH;
+
+
+/**
+ * Counts the keys less or equal to @a Key.
+ *
+ * @returns Number of keys <= Key, i.e. the index of the first key above.
+ * @param   paKeys      The sorted key array.
+ * @param   cKeys       Number of valid keys.
+ * @param   Key         The key to look for.
+ */
+DECLINLINE(uint32_t) rtBTreeRU64CountLE(AVLRU64KEY const *paKeys, uint32_t cKeys, AVLRU64KEY Key)
+{
+    /* A linear scan beats a binary search at these sizes, the branch is
+       well predicted and the arrays are only a couple of cache lines. */
+    uint32_t i = 0;
+    while (i < cKeys && paKeys[i] <= Key)
+        i++;
+    return i;
+}
+
+
+/**
+ * Walks down the tree to the leaf which would contain @a Key.
+ *
+ * @returns The leaf, NULL if the tree is empty.
+ * @param   pTree       The tree.
+ * @param   Key         The key.
+ * @param   pPath       Where to record the path, optional.
+ */
+static PRTBTREERU64LEAF rtBTreeRU64Descend(PRTBTREERU64 pTree, AVLRU64KEY Key, PRTBTREERU64PATH pPath)
+{
+    void *pv = pTree->pvRoot;
+    for (uint32_t iLevel = 0; iLevel < pTree->cHeight; iLevel++)
+    {
+        PRTBTREERU64INNER pInner = (PRTBTREERU64INNER)pv;
+        uint32_t          idx    = rtBTreeRU64CountLE(pInner->aKeys, pInner->cChildren - 1, Key);
+        if (pPath)
+        {
+            pPath->apInner[iLevel]   = pInner;
+            pPath->aidxChild[iLevel] = idx;
+        }
+        pv = pInner->apvChildren[idx];
+    }
+    return (PRTBTREERU64LEAF)pv;
+}
+
+
+/**
+ * Gets the leaf at the left or right edge of the tree.
+ *
+ * @returns The leaf, NULL if the tree is empty.
+ * @param   pTree       The tree.
+ * @param   fLeft       Whether to get the leftmost (true) or rightmost leaf.
+ */
+static PRTBTREERU64LEAF rtBTreeRU64EdgeLeaf(PRTBTREERU64 pTree, bool fLeft)
+{
+    void *pv = pTree->pvRoot;
+    for (uint32_t iLevel = 0; iLevel < pTree->cHeight; iLevel++)
+    {
+        PRTBTREERU64INNER pInner = (PRTBTREERU64INNER)pv;
+        pv = pInner->apvChildren[fLeft ? 0 : pInner->cChildren - 1];
+    }
+    return (PRTBTREERU64LEAF)pv;
+}
+
+
+/**
+ * Initializes an empty tree.
+ *
+ * @param   pTree       The tree.
+ */
+RTDECL(void) RTBTreeRU64Init(PRTBTREERU64 pTree)
+{
+    pTree->pvRoot  = NULL;
+    pTree->cHeight = 0;
+    pTree->cNodes  = 0;
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64Init);
+
+
+/**
+ * Inserts a node into the tree.
+ *
+ * @returns true if inserted.
+ * @returns false if the range intersects with a node in the tree or if we
+ *          ran out of memory for the tree nodes.
+ * @param   pTree       The tree.
+ * @param   pNode       The node to insert, Key and KeyLast must be set.  The
+ *                      other members are not used.
+ */
+RTDECL(bool) RTBTreeRU64Insert(PRTBTREERU64 pTree, PAVLRU64NODECORE pNode)
+{
+    AVLRU64KEY const Key     = pNode->Key;
+    AVLRU64KEY const KeyLast = pNode->KeyLast;
+    Assert(Key <= KeyLast);
+
+    /*
+     * Empty tree, create the root leaf.
+     */
+    if (!pTree->pvRoot)
+    {
+        PRTBTREERU64LEAF pLeaf = (PRTBTREERU64LEAF)RTMemAlloc(sizeof(*pLeaf));
+        if (!pLeaf)
+            return false;
+        pLeaf->cEntries     = 1;
+        pLeaf->pPrev        = NULL;
+        pLeaf->pNext        = NULL;
+        pLeaf->aKeys[0]     = Key;
+        pLeaf->aKeysLast[0] = KeyLast;
+        pLeaf->apNodes[0]   = pNode;
+        pTree->pvRoot  = pLeaf;
+        pTree->cNodes  = 1;
+        return true;
+    }
+
+    /*
+     * Find the spot and check that we don't intersect with our neighbours.
+     */
+    RTBTREERU64PATH  Path;
+    PRTBTREERU64LEAF pLeaf = rtBTreeRU64Descend(pTree, Key, &Path);
+    uint32_t         idx   = rtBTreeRU64CountLE(pLeaf->aKeys, pLeaf->cEntries, Key);
+
+    if (idx > 0)
+    {
+        if (pLeaf->aKeysLast[idx - 1] >= Key)
+            return false;
+    }
+    else if (pLeaf->pPrev && pLeaf->pPrev->aKeysLast[pLeaf->pPrev->cEntries - 1] >= Key)
+        return false;
+
+    if (idx < pLeaf->cEntries)
+    {
+        if (pLeaf->aKeys[idx] <= KeyLast)
+            return false;
+    }
+    else if (pLeaf->pNext && pLeaf->pNext->aKeys[0] <= KeyLast)
+        return false;
+
+    /*
+     * Simple case, there is room in the leaf.
+     */
+    if (pLeaf->cEntries < RTBTREE_LEAF_ENTRIES)
+    {
+        uint32_t const cMove = pLeaf->cEntries - idx;
+        memmove(&pLeaf->aKeys[idx + 1],     &pLeaf->aKeys[idx],     cMove * sizeof(pLeaf->aKeys[0]));
+        memmove(&pLeaf->aKeysLast[idx + 1], &pLeaf->aKeysLast[idx], cMove * sizeof(pLeaf->aKeysLast[0]));
+        memmove(&pLeaf->apNodes[idx + 1],   &pLeaf->apNodes[idx],   cMove * sizeof(pLeaf->apNodes[0]));
+        pLeaf->aKeys[idx]     = Key;
+        pLeaf->aKeysLast[idx] = KeyLast;
+        pLeaf->apNodes[idx]   = pNode;
+        pLeaf->cEntries++;
+        pTree->cNodes++;
+        return true;
+    }
+
+    /*
+     * The leaf needs splitting and that may propagate all the way up.  Allocate
+     * all the nodes we need up front so we can back out cleanly on failure.
+     */
+    uint32_t iLevel = pTree->cHeight;
+    while (iLevel > 0 && Path.apInner[iLevel - 1]->cChildren == RTBTREE_INNER_CHILDREN)
+        iLevel--;
+    uint32_t const cInnerSplits = pTree->cHeight - iLevel;
+    bool     const fNewRoot     = iLevel == 0;
+    AssertReturn(!fNewRoot || pTree->cHeight < RTBTREE_MAX_HEIGHT, false);
+
+    PRTBTREERU64INNER apNewInner[RTBTREE_MAX_HEIGHT + 1];
+    uint32_t const    cNewInner = cInnerSplits + fNewRoot;
+    PRTBTREERU64LEAF  pNewLeaf  = (PRTBTREERU64LEAF)RTMemAlloc(sizeof(*pNewLeaf));
+    uint32_t          i;
+    for (i = 0; i < cNewInner && pNewLeaf; i++)
+    {
+        apNewInner[i] = (PRTBTREERU64INNER)RTMemAlloc(sizeof(RTBTREERU64INNER));
+        if (!apNewInner[i])
+            break;
+    }
+    if (!pNewLeaf || i < cNewInner)
+    {
+        while (i-- > 0)
+            RTMemFree(apNewInner[i]);
+        RTMemFree(pNewLeaf);
+        return false;
+    }
+
+    /*
+     * Split the leaf in two halves and insert the entry into the right one.
+     */
+    uint32_t const cLeft  = RTBTREE_LEAF_ENTRIES / 2;
+    uint32_t const cRight = RTBTREE_LEAF_ENTRIES - cLeft;
+    memcpy(&pNewLeaf->aKeys[0],     &pLeaf->aKeys[cLeft],     cRight * sizeof(pLeaf->aKeys[0]));
+    memcpy(&pNewLeaf->aKeysLast[0], &pLeaf->aKeysLast[cLeft], cRight * sizeof(pLeaf->aKeysLast[0]));
+    memcpy(&pNewLeaf->apNodes[0],   &pLeaf->apNodes[cLeft],   cRight * sizeof(pLeaf->apNodes[0]));
+    pNewLeaf->cEntries = cRight;
+    pLeaf->cEntries    = cLeft;
+
+    pNewLeaf->pPrev = pLeaf;
+    pNewLeaf->pNext = pLeaf->pNext;
+    if (pLeaf->pNext)
+        pLeaf->pNext->pPrev = pNewLeaf;
+    pLeaf->pNext = pNewLeaf;
+
+    PRTBTREERU64LEAF pTarget = pLeaf;
+    if (idx > cLeft)
+    {
+        pTarget = pNewLeaf;
+        idx -= cLeft;
+    }
+    uint32_t const cMove = pTarget->cEntries - idx;
+    memmove(&pTarget->aKeys[idx + 1],     &pTarget->aKeys[idx],     cMove * sizeof(pTarget->aKeys[0]));
+    memmove(&pTarget->aKeysLast[idx + 1], &pTarget->aKeysLast[idx], cMove * sizeof(pTarget->aKeysLast[0]));
+    memmove(&pTarget->apNodes[idx + 1],   &pTarget->apNodes[idx],   cMove * sizeof(pTarget->apNodes[0]));
+    pTarget->aKeys[idx]     = Key;
+    pTarget->aKeysLast[idx] = KeyLast;
+    pTarget->apNodes[idx]   = pNode;
+    pTarget->cEntries++;
+    pTree->cNodes++;
+
+    /*
+     * Insert the new node into the parent, splitting interior nodes as we go.
+     */
+    AVLRU64KEY SepKey   = pNewLeaf->aKeys[0];
+    void      *pvNew    = pNewLeaf;
+    uint32_t   iNewNode = 0;
+    iLevel = pTree->cHeight;
+    while (iLevel > 0)
+    {
+        iLevel--;
+        PRTBTREERU64INNER pInner   = Path.apInner[iLevel];
+        uint32_t const    idxChild = Path.aidxChild[iLevel];
+        if (pInner->cChildren < RTBTREE_INNER_CHILDREN)
+        {
+            uint32_t const cMoveChildren = pInner->cChildren - idxChild - 1;
+            memmove(&pInner->aKeys[idxChild + 1],       &pInner->aKeys[idxChild],           cMoveChildren * sizeof(pInner->aKeys[0]));
+            memmove(&pInner->apvChildren[idxChild + 2], &pInner->apvChildren[idxChild + 1], cMoveChildren * sizeof(pInner->apvChildren[0]));
+            pInner->aKeys[idxChild]           = SepKey;
+            pInner->apvChildren[idxChild + 1] = pvNew;
+            pInner->cChildren++;
+            Assert(iNewNode == cNewInner);
+            return true;
+        }
+
+        /* Merge into temporary arrays and distribute them over the two nodes. */
+        AVLRU64KEY aKeys[RTBTREE_INNER_CHILDREN];
+        void      *apvChildren[RTBTREE_INNER_CHILDREN + 1];
+        memcpy(&aKeys[0], &pInner->aKeys[0], idxChild * sizeof(aKeys[0]));
+        aKeys[idxChild] = SepKey;
+        memcpy(&aKeys[idxChild + 1], &pInner->aKeys[idxChild], (RTBTREE_INNER_CHILDREN - 1 - idxChild) * sizeof(aKeys[0]));
+        memcpy(&apvChildren[0], &pInner->apvChildren[0], (idxChild + 1) * sizeof(apvChildren[0]));
+        apvChildren[idxChild + 1] = pvNew;
+        memcpy(&apvChildren[idxChild + 2], &pInner->apvChildren[idxChild + 1],
+               (RTBTREE_INNER_CHILDREN - 1 - idxChild) * sizeof(apvChildren[0]));
+
+        uint32_t const    cLeftChildren  = (RTBTREE_INNER_CHILDREN + 1) / 2;
+        uint32_t const    cRightChildren = RTBTREE_INNER_CHILDREN + 1 - cLeftChildren;
+        PRTBTREERU64INNER pNewInner      = apNewInner[iNewNode++];
+        memcpy(&pInner->aKeys[0],       &aKeys[0],       (cLeftChildren - 1) * sizeof(aKeys[0]));
+        memcpy(&pInner->apvChildren[0], &apvChildren[0], cLeftChildren * sizeof(apvChildren[0]));
+        pInner->cChildren = cLeftChildren;
+        memcpy(&pNewInner->aKeys[0],       &aKeys[cLeftChildren],       (cRightChildren - 1) * sizeof(aKeys[0]));
+        memcpy(&pNewInner->apvChildren[0], &apvChildren[cLeftChildren], cRightChildren * sizeof(apvChildren[0]));
+        pNewInner->cChildren = cRightChildren;
+
+        SepKey = aKeys[cLeftChildren - 1];
+        pvNew  = pNewInner;
+    }
+
+    /*
+     * The root was split, grow the tree.
+     */
+    Assert(fNewRoot); Assert(iNewNode + 1 == cNewInner);
+    PRTBTREERU64INNER pRoot = apNewInner[iNewNode];
+    pRoot->cChildren      = 2;
+    pRoot->aKeys[0]       = SepKey;
+    pRoot->apvChildren[0] = pTree->pvRoot;
+    pRoot->apvChildren[1] = pvNew;
+    pTree->pvRoot = pRoot;
+    pTree->cHeight++;
+    return true;
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64Insert);
+
+
+/**
+ * Removes an entry from a leaf, freeing nodes which become empty.
+ *
+ * @returns The user node of the entry.
+ * @param   pTree       The tree.
+ * @param   pLeaf       The leaf.
+ * @param   idx         The entry index.
+ * @param   pPath       The path to the leaf.
+ */
+static PAVLRU64NODECORE rtBTreeRU64RemoveEntry(PRTBTREERU64 pTree, PRTBTREERU64LEAF pLeaf, uint32_t idx,
+                                               PRTBTREERU64PATH pPath)
+{
+    PAVLRU64NODECORE pNode = pLeaf->apNodes[idx];
+    uint32_t const   cMove = pLeaf->cEntries - idx - 1;
+    memmove(&pLeaf->aKeys[idx],     &pLeaf->aKeys[idx + 1],     cMove * sizeof(pLeaf->aKeys[0]));
+    memmove(&pLeaf->aKeysLast[idx], &pLeaf->aKeysLast[idx + 1], cMove * sizeof(pLeaf->aKeysLast[0]));
+    memmove(&pLeaf->apNodes[idx],   &pLeaf->apNodes[idx + 1],   cMove * sizeof(pLeaf->apNodes[0]));
+    pLeaf->cEntries--;
+    pTree->cNodes--;
+    if (pLeaf->cEntries > 0)
+        return pNode;
+
+    /*
+     * The leaf is empty, unlink and free it.  We don't rebalance partially
+     * filled nodes, instead nodes are freed when they become empty and the
+     * separators stay behind as bounds.  This keeps removal cheap and the
+     * height bounded by what the insertions created.
+     */
+    if (pLeaf->pPrev)
+        pLeaf->pPrev->pNext = pLeaf->pNext;
+    if (pLeaf->pNext)
+        pLeaf->pNext->pPrev = pLeaf->pPrev;
+    RTMemFree(pLeaf);
+    if (pTree->cHeight == 0)
+    {
+        pTree->pvRoot = NULL;
+        return pNode;
+    }
+
+    uint32_t iLevel = pTree->cHeight;
+    while (iLevel > 0)
+    {
+        iLevel--;
+        PRTBTREERU64INNER pInner   = pPath->apInner[iLevel];
+        uint32_t const    idxChild = pPath->aidxChild[iLevel];
+        if (pInner->cChildren > 1)
+        {
+            /* Drop the child and the separator below it (or above for the first child). */
+            uint32_t const idxKey = idxChild > 0 ? idxChild - 1 : 0;
+            memmove(&pInner->aKeys[idxKey], &pInner->aKeys[idxKey + 1],
+                    (pInner->cChildren - 2 - idxKey) * sizeof(pInner->aKeys[0]));
+            memmove(&pInner->apvChildren[idxChild], &pInner->apvChildren[idxChild + 1],
+                    (pInner->cChildren - 1 - idxChild) * sizeof(pInner->apvChildren[0]));
+            pInner->cChildren--;
+            break;
+        }
+        RTMemFree(pInner);
+        if (iLevel == 0)
+        {
+            pTree->pvRoot  = NULL;
+            pTree->cHeight = 0;
+            Assert(pTree->cNodes == 0);
+            return pNode;
+        }
+    }
+
+    /*
+     * Collapse roots with a single child.
+     */
+    while (pTree->cHeight > 0)
+    {
+        PRTBTREERU64INNER pRoot = (PRTBTREERU64INNER)pTree->pvRoot;
+        if (pRoot->cChildren > 1)
+            break;
+        pTree->pvRoot = pRoot->apvChildren[0];
+        pTree->cHeight--;
+        RTMemFree(pRoot);
+    }
+    return pNode;
+}
+
+
+/**
+ * Removes the node with the given start key from the tree.
+ *
+ * @returns Pointer to the removed node, NULL if not found.
+ * @param   pTree       The tree.
+ * @param   Key         The start key of the node to remove.
+ */
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64Remove(PRTBTREERU64 pTree, AVLRU64KEY Key)
+{
+    if (!pTree->pvRoot)
+        return NULL;
+    RTBTREERU64PATH  Path;
+    PRTBTREERU64LEAF pLeaf = rtBTreeRU64Descend(pTree, Key, &Path);
+    uint32_t         idx   = rtBTreeRU64CountLE(pLeaf->aKeys, pLeaf->cEntries, Key);
+    if (idx == 0 || pLeaf->aKeys[idx - 1] != Key)
+        return NULL;
+    return rtBTreeRU64RemoveEntry(pTree, pLeaf, idx - 1, &Path);
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64Remove);
+
+
+/**
+ * Gets the node with the given start key.
+ *
+ * @returns Pointer to the node, NULL if not found.
+ * @param   pTree       The tree.
+ * @param   Key         The start key of the node to get.
+ */
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64Get(PRTBTREERU64 pTree, AVLRU64KEY Key)
+{
+    if (!pTree->pvRoot)
+        return NULL;
+    PRTBTREERU64LEAF pLeaf = rtBTreeRU64Descend(pTree, Key, NULL);
+    uint32_t         idx   = rtBTreeRU64CountLE(pLeaf->aKeys, pLeaf->cEntries, Key);
+    if (idx == 0 || pLeaf->aKeys[idx - 1] != Key)
+        return NULL;
+    return pLeaf->apNodes[idx - 1];
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64Get);
+
+
+/**
+ * Finds the entry whose range contains @a Key.
+ *
+ * @returns true if found, false if not.
+ * @param   pTree       The tree, not empty.
+ * @param   Key         The key to look for.
+ * @param   pPath       Where to record the path, optional.
+ * @param   ppLeaf      Where to return the leaf.
+ * @param   pidx        Where to return the entry index.
+ */
+static bool rtBTreeRU64RangeLookup(PRTBTREERU64 pTree, AVLRU64KEY Key, PRTBTREERU64PATH pPath,
+                                   PRTBTREERU64LEAF *ppLeaf, uint32_t *pidx)
+{
+    PRTBTREERU64LEAF pLeaf = rtBTreeRU64Descend(pTree, Key, pPath);
+    uint32_t         idx   = rtBTreeRU64CountLE(pLeaf->aKeys, pLeaf->cEntries, Key);
+    if (idx > 0 && pLeaf->aKeysLast[idx - 1] >= Key)
+    {
+        *ppLeaf = pLeaf;
+        *pidx   = idx - 1;
+        return true;
+    }
+    /* Nothing in this leaf starts at or below Key, but the separator above
+       the leaf may be stale and a range in the previous leaf may reach it. */
+    if (idx == 0 && pLeaf->pPrev && pLeaf->pPrev->aKeysLast[pLeaf->pPrev->cEntries - 1] >= Key)
+    {
+        pLeaf = pLeaf->pPrev;
+        if (pPath)
+            rtBTreeRU64Descend(pTree, pLeaf->aKeys[0], pPath);
+        *ppLeaf = pLeaf;
+        *pidx   = pLeaf->cEntries - 1;
+        return true;
+    }
+    return false;
+}
+
+
+/**
+ * Finds the node whose range contains @a Key.
+ *
+ * @returns Pointer to the node, NULL if not found.
+ * @param   pTree       The tree.
+ * @param   Key         The key to find a range for.
+ */
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64RangeGet(PRTBTREERU64 pTree, AVLRU64KEY Key)
+{
+    PRTBTREERU64LEAF pLeaf;
+    uint32_t         idx;
+    if (pTree->pvRoot && rtBTreeRU64RangeLookup(pTree, Key, NULL, &pLeaf, &idx))
+        return pLeaf->apNodes[idx];
+    return NULL;
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64RangeGet);
+
+
+/**
+ * Removes the node whose range contains @a Key.
+ *
+ * @returns Pointer to the removed node, NULL if not found.
+ * @param   pTree       The tree.
+ * @param   Key         The key to find a range for.
+ */
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64RangeRemove(PRTBTREERU64 pTree, AVLRU64KEY Key)
+{
+    RTBTREERU64PATH  Path;
+    PRTBTREERU64LEAF pLeaf;
+    uint32_t         idx;
+    if (pTree->pvRoot && rtBTreeRU64RangeLookup(pTree, Key, &Path, &pLeaf, &idx))
+        return rtBTreeRU64RemoveEntry(pTree, pLeaf, idx, &Path);
+    return NULL;
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64RangeRemove);
+
+
+/**
+ * Finds the best fitting entry for the given start key.
+ *
+ * @returns true if found, false if not.
+ * @param   pTree       The tree, not empty.
+ * @param   Key         The key.
+ * @param   fAbove      See RTBTreeRU64GetBestFit.
+ * @param   pPath       Where to record the path, optional.  Note that the
+ *                      path is for the leaf @a Key maps to, which may be a
+ *                      neighbour of the returned one.
+ * @param   ppLeaf      Where to return the leaf.
+ * @param   pidx        Where to return the entry index.
+ */
+static bool rtBTreeRU64BestFitLookup(PRTBTREERU64 pTree, AVLRU64KEY Key, bool fAbove, PRTBTREERU64PATH pPath,
+                                     PRTBTREERU64LEAF *ppLeaf, uint32_t *pidx)
+{
+    PRTBTREERU64LEAF pLeaf = rtBTreeRU64Descend(pTree, Key, pPath);
+    uint32_t         idx   = rtBTreeRU64CountLE(pLeaf->aKeys, pLeaf->cEntries, Key);
+    if (idx > 0 && (!fAbove || pLeaf->aKeys[idx - 1] == Key))
+        idx--;
+    else if (fAbove)
+    {
+        if (idx >= pLeaf->cEntries)
+        {
+            pLeaf = pLeaf->pNext;
+            if (!pLeaf)
+                return false;
+            idx = 0;
+        }
+    }
+    else
+    {
+        pLeaf = pLeaf->pPrev;
+        if (!pLeaf)
+            return false;
+        idx = pLeaf->cEntries - 1;
+    }
+    *ppLeaf = pLeaf;
+    *pidx   = idx;
+    return true;
+}
+
+
+/**
+ * Finds the best fitting node in the tree for the given start key.
+ *
+ * @returns Pointer to the best fitting node found, NULL if none.
+ * @param   pTree       The tree.
+ * @param   Key         The key to find a best fitting match for.
+ * @param   fAbove      true:  The node with the closest key from above.
+ *                      false: The node with the closest key from below.
+ *                      A node with exactly @a Key is always preferred.
+ */
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64GetBestFit(PRTBTREERU64 pTree, AVLRU64KEY Key, bool fAbove)
+{
+    PRTBTREERU64LEAF pLeaf;
+    uint32_t         idx;
+    if (pTree->pvRoot && rtBTreeRU64BestFitLookup(pTree, Key, fAbove, NULL, &pLeaf, &idx))
+        return pLeaf->apNodes[idx];
+    return NULL;
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64GetBestFit);
+
+
+/**
+ * Finds the best fitting node in the tree for the given start key and
+ * removes it.
+ *
+ * @returns Pointer to the removed node, NULL if none.
+ * @param   pTree       The tree.
+ * @param   Key         The key to find a best fitting match for.
+ * @param   fAbove      See RTBTreeRU64GetBestFit.
+ */
+RTDECL(PAVLRU64NODECORE) RTBTreeRU64RemoveBestFit(PRTBTREERU64 pTree, AVLRU64KEY Key, bool fAbove)
+{
+    PRTBTREERU64LEAF pLeaf;
+    uint32_t         idx;
+    if (pTree->pvRoot && rtBTreeRU64BestFitLookup(pTree, Key, fAbove, NULL, &pLeaf, &idx))
+        return RTBTreeRU64Remove(pTree, pLeaf->aKeys[idx]);
+    return NULL;
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64RemoveBestFit);
+
+
+/**
+ * Iterates through all nodes in the tree in key order.
+ *
+ * The callback must not modify the tree.
+ *
+ * @returns VINF_SUCCESS if the callback returned VINF_SUCCESS for all nodes,
+ *          otherwise the first status code that wasn't VINF_SUCCESS.
+ * @param   pTree       The tree.
+ * @param   fFromLeft   true:  Left to right (ascending keys).
+ *                      false: Right to left (descending keys).
+ * @param   pfnCallBack Pointer to callback function.
+ * @param   pvParam     User parameter passed on to the callback function.
+ */
+RTDECL(int) RTBTreeRU64DoWithAll(PRTBTREERU64 pTree, int fFromLeft, PAVLRU64CALLBACK pfnCallBack, void *pvParam)
+{
+    if (fFromLeft)
+    {
+        for (PRTBTREERU64LEAF pLeaf = rtBTreeRU64EdgeLeaf(pTree, true); pLeaf; pLeaf = pLeaf->pNext)
+            for (uint32_t i = 0; i < pLeaf->cEntries; i++)
+            {
+                int rc = pfnCallBack(pLeaf->apNodes[i], pvParam);
+                if (rc != VINF_SUCCESS)
+                    return rc;
+            }
+    }
+    else
+    {
+        for (PRTBTREERU64LEAF pLeaf = rtBTreeRU64EdgeLeaf(pTree, false); pLeaf; pLeaf = pLeaf->pPrev)
+            for (uint32_t i = pLeaf->cEntries; i-- > 0;)
+            {
+                int rc = pfnCallBack(pLeaf->apNodes[i], pvParam);
+                if (rc != VINF_SUCCESS)
+                    return rc;
+            }
+    }
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64DoWithAll);
+
+
+/**
+ * Destroys the tree, calling the callback for each node after it has been
+ * removed.
+ *
+ * @returns VINF_SUCCESS on success.
+ * @returns Return value from callback on failure.  The node we fail on has
+ *          already been removed, the rest of the tree is intact and further
+ *          calls can be made on it.
+ * @param   pTree       The tree.
+ * @param   pfnCallBack Pointer to callback function, optional.
+ * @param   pvParam     User parameter passed on to the callback function.
+ */
+RTDECL(int) RTBTreeRU64Destroy(PRTBTREERU64 pTree, PAVLRU64CALLBACK pfnCallBack, void *pvParam)
+{
+    while (pTree->pvRoot)
+    {
+        PRTBTREERU64LEAF pLeaf = rtBTreeRU64EdgeLeaf(pTree, true);
+        PAVLRU64NODECORE pNode = RTBTreeRU64Remove(pTree, pLeaf->aKeys[0]);
+        Assert(pNode);
+        if (pfnCallBack)
+        {
+            int rc = pfnCallBack(pNode, pvParam);
+            if (rc != VINF_SUCCESS)
+                return rc;
+        }
+    }
+    return VINF_SUCCESS;
+}
+RT_EXPORT_SYMBOL(RTBTreeRU64Destroy);
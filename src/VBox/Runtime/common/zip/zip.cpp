@@ -1748,8 +1748,7 @@ RTDECL(int) RTZipBlockCompress(RTZIPTYPE enmType, RTZIPLEVEL enmLevel, uint32_t
                 0xe0, 0x7d, 0x00
             };
             if (    cbSrc == _4K
-                &&  !((uintptr_t)pvSrc & 15)
-                &&  ASMMemIsZeroPage(pvSrc))
+                &&  RTMemIsZero(pvSrc, _4K))
             {
                 if (RT_UNLIKELY(cbDst < sizeof(s_abZero4K)))
                     return VERR_BUFFER_OVERFLOW;
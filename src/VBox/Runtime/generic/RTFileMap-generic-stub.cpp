@@ -0,0 +1,59 @@
+/* $Id: RTFileMap-generic-stub.cpp $ */
+/** @file
+ * IPRT - RTFileMap, RTFileUnmap and RTFileMapAdvise, stubs.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/file.h>
+#include "internal/iprt.h"
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+
+
+RTDECL(int) RTFileMap(RTFILE hFile, RTFOFF off, size_t cb, uint32_t fFlags, void **ppv)
+{
+    AssertPtrReturn(ppv, VERR_INVALID_POINTER);
+    *ppv = NULL;
+    NOREF(hFile); NOREF(off); NOREF(cb); NOREF(fFlags);
+    return VERR_NOT_SUPPORTED;
+}
+
+
+RTDECL(int) RTFileUnmap(void *pv, size_t cb)
+{
+    AssertReturn(!pv, VERR_INVALID_POINTER);
+    NOREF(cb);
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(int) RTFileMapAdvise(void *pv, size_t cb, RTFILEMAPADVICE enmAdvice)
+{
+    NOREF(pv); NOREF(cb); NOREF(enmAdvice);
+    return VERR_NOT_SUPPORTED;
+}
@@ -0,0 +1,79 @@
+/* $Id: crc.h $ */
+/** @file
+ * IPRT - Internal header for the CRC implementations.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+#ifndef ___internal_crc_h
+#define ___internal_crc_h
+
+#include <iprt/types.h>
+
+
+/** @def RTCRC32_WITH_PCLMUL
+ * Defined when the CRC-32 code can make use of the carry-less multiplication
+ * kernel (crc32-pclmul.cpp).  This is ring-3 only since the other contexts
+ * can't freely touch the SSE registers. */
+#if defined(IN_RING3) \
+ && (defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)) \
+ && !defined(IPRT_WITHOUT_CRC32_PCLMUL)
+# define RTCRC32_WITH_PCLMUL
+#endif
+
+/** The minimum number of bytes the PCLMULQDQ kernel accepts.  Below this the
+ * slicing-by-8 code is faster anyway. */
+#define RTCRC32_PCLMUL_MIN_SIZE     64
+
+
+RT_C_DECLS_BEGIN
+
+#ifdef RTCRC32_WITH_PCLMUL
+/**
+ * Checks whether the CPU supports the PCLMULQDQ CRC-32 kernel.
+ *
+ * The result is determined once and cached.  Setting the IPRT_CRC32_NO_PCLMUL
+ * environment variable forces the table driven code.
+ *
+ * @returns true if usable, false if not.
+ */
+DECLHIDDEN(bool)     rtCrc32PclMulIsAvailable(void);
+
+/**
+ * Processes a block using the PCLMULQDQ folding kernel.
+ *
+ * Only whole 16 byte blocks are processed, the caller must deal with the
+ * remaining @a cb % 16 bytes at @a pb + (@a cb & ~15).
+ *
+ * @returns Updated (non-inverted) CRC-32 register value.
+ * @param   uCRC32      The current CRC-32 register value (as passed to and
+ *                      returned by RTCrc32Process).
+ * @param   pb          The data, no alignment requirements.
+ * @param   cb          The data size, at least RTCRC32_PCLMUL_MIN_SIZE.
+ */
+DECLHIDDEN(uint32_t) rtCrc32PclMulProcess(uint32_t uCRC32, uint8_t const *pb, size_t cb);
+#endif
+
+RT_C_DECLS_END
+
+#endif
+
@@ -0,0 +1,248 @@
+/* $Id: iouring-linux.h $ */
+/** @file
+ * IPRT - Internal header for the Linux io_uring kernel interface.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+#ifndef ___internal_iouring_linux_h
+#define ___internal_iouring_linux_h
+
+#include <iprt/types.h>
+#include <iprt/assert.h>
+#include <iprt/err.h>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <errno.h>
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** @name io_uring syscall numbers.
+ * These are the same on all architectures we support, the build headers might
+ * just be too old to know about them.
+ * @{ */
+#ifndef __NR_io_uring_setup
+# define __NR_io_uring_setup            425
+#endif
+#ifndef __NR_io_uring_enter
+# define __NR_io_uring_enter            426
+#endif
+/** @} */
+
+/** @name Submission queue entry opcodes (IORING_OP_XXX).
+ * @{ */
+#define LNXIOURING_OP_NOP               0
+#define LNXIOURING_OP_READV             1
+#define LNXIOURING_OP_WRITEV            2
+#define LNXIOURING_OP_FSYNC             3
+/** @} */
+
+/** Submission queue entry flag: Don't start before all previous SQEs completed
+ * (IOSQE_IO_DRAIN). */
+#define LNXIOURING_SQE_F_IO_DRAIN       RT_BIT(1)
+/** io_uring_enter flag: Wait for the given number of completions
+ * (IORING_ENTER_GETEVENTS). */
+#define LNXIOURING_ENTER_F_GETEVENTS    RT_BIT_32(0)
+/** Feature flag: The SQ and CQ rings share one mapping (IORING_FEAT_SINGLE_MMAP). */
+#define LNXIOURING_FEAT_SINGLE_MMAP     RT_BIT_32(0)
+
+/** @name mmap offsets for the ring file descriptor.
+ * @{ */
+#define LNXIOURING_OFF_SQ_RING          UINT32_C(0x00000000)
+#define LNXIOURING_OFF_CQ_RING          UINT32_C(0x08000000)
+#define LNXIOURING_OFF_SQES             UINT32_C(0x10000000)
+/** @} */
+
+/** The maximum number of SQ entries all kernels accept. */
+#define LNXIOURING_MAX_ENTRIES          4096
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+/**
+ * Submission queue entry (struct io_uring_sqe).
+ */
+typedef struct LNXIOURINGSQE
+{
+    /** The opcode, LNXIOURING_OP_XXX. */
+    uint8_t     u8OpCode;
+    /** Flags, LNXIOURING_SQE_F_XXX. */
+    uint8_t     fFlags;
+    /** I/O priority. */
+    uint16_t    u16IoPrio;
+    /** The file descriptor. */
+    int32_t     iFd;
+    /** The file offset. */
+    uint64_t    off;
+    /** Buffer or I/O vector address. */
+    uint64_t    u64Addr;
+    /** Buffer size or number of I/O vector entries. */
+    uint32_t    cbLen;
+    /** Opcode specific flags (rw_flags, fsync_flags, ...). */
+    uint32_t    fOpFlags;
+    /** Opaque user data returned in the completion queue entry. */
+    uint64_t    u64UserData;
+    /** Reserved / opcode specific, must be zero. */
+    uint64_t    au64Reserved[3];
+} LNXIOURINGSQE;
+AssertCompileSize(LNXIOURINGSQE, 64);
+/** Pointer to a submission queue entry. */
+typedef LNXIOURINGSQE *PLNXIOURINGSQE;
+
+/**
+ * Completion queue entry (struct io_uring_cqe).
+ */
+typedef struct LNXIOURINGCQE
+{
+    /** The user data of the submission queue entry. */
+    uint64_t    u64UserData;
+    /** The result, negative errno on failure. */
+    int32_t     rcLnx;
+    /** Flags. */
+    uint32_t    fFlags;
+} LNXIOURINGCQE;
+AssertCompileSize(LNXIOURINGCQE, 16);
+/** Pointer to a completion queue entry. */
+typedef LNXIOURINGCQE *PLNXIOURINGCQE;
+
+/**
+ * Offsets into the SQ ring mapping (struct io_sqring_offsets).
+ */
+typedef struct LNXIOURINGSQOFFSETS
+{
+    uint32_t    offHead;
+    uint32_t    offTail;
+    uint32_t    offRingMask;
+    uint32_t    offRingEntries;
+    uint32_t    offFlags;
+    uint32_t    offDropped;
+    uint32_t    offArray;
+    uint32_t    u32Reserved;
+    uint64_t    u64Reserved;
+} LNXIOURINGSQOFFSETS;
+AssertCompileSize(LNXIOURINGSQOFFSETS, 40);
+
+/**
+ * Offsets into the CQ ring mapping (struct io_cqring_offsets).
+ */
+typedef struct LNXIOURINGCQOFFSETS
+{
+    uint32_t    offHead;
+    uint32_t    offTail;
+    uint32_t    offRingMask;
+    uint32_t    offRingEntries;
+    uint32_t    offOverflow;
+    uint32_t    offCqes;
+    uint32_t    offFlags;
+    uint32_t    u32Reserved;
+    uint64_t    u64Reserved;
+} LNXIOURINGCQOFFSETS;
+AssertCompileSize(LNXIOURINGCQOFFSETS, 40);
+
+/**
+ * Parameters passed to and returned by io_uring_setup (struct io_uring_params).
+ */
+typedef struct LNXIOURINGPARAMS
+{
+    /** Number of SQ entries (output). */
+    uint32_t            cSqEntries;
+    /** Number of CQ entries (output). */
+    uint32_t            cCqEntries;
+    /** Setup flags (input). */
+    uint32_t            fFlags;
+    /** SQ polling thread CPU (input). */
+    uint32_t            idSqThreadCpu;
+    /** SQ polling thread idle time (input). */
+    uint32_t            cMsSqThreadIdle;
+    /** Supported features, LNXIOURING_FEAT_XXX (output). */
+    uint32_t            fFeatures;
+    /** Reserved. */
+    uint32_t            au32Reserved[4];
+    /** SQ ring layout (output). */
+    LNXIOURINGSQOFFSETS SqOffsets;
+    /** CQ ring layout (output). */
+    LNXIOURINGCQOFFSETS CqOffsets;
+} LNXIOURINGPARAMS;
+AssertCompileSize(LNXIOURINGPARAMS, 120);
+/** Pointer to io_uring setup parameters. */
+typedef LNXIOURINGPARAMS *PLNXIOURINGPARAMS;
+
+
+/*******************************************************************************
+*   Internal Functions                                                         *
+*******************************************************************************/
+/**
+ * Creates a new io_uring instance.
+ *
+ * @returns IPRT status code.
+ * @param   cEntries    Number of SQ entries to ask for.
+ * @param   pParams     The parameters, zero initialized by the caller.
+ * @param   piFd        Where to return the ring file descriptor on success.
+ */
+DECLINLINE(int) rtLinuxIoUringSetup(uint32_t cEntries, PLNXIOURINGPARAMS pParams, int *piFd)
+{
+    int iFd = syscall(__NR_io_uring_setup, cEntries, pParams);
+    if (RT_UNLIKELY(iFd == -1))
+        return RTErrConvertFromErrno(errno);
+
+    *piFd = iFd;
+    return VINF_SUCCESS;
+}
+
+/**
+ * Submits queued SQEs and/or waits for completions.
+ *
+ * @returns Number of SQEs consumed (natural number w/ 0), IPRT error code (negative).
+ * @param   iFd             The ring file descriptor.
+ * @param   cToSubmit       Number of SQEs to submit.
+ * @param   cMinComplete    Number of completions to wait for, requires
+ *                          LNXIOURING_ENTER_F_GETEVENTS.
+ * @param   fFlags          LNXIOURING_ENTER_F_XXX.
+ */
+DECLINLINE(int) rtLinuxIoUringEnter(int iFd, uint32_t cToSubmit, uint32_t cMinComplete, uint32_t fFlags)
+{
+    int rc = syscall(__NR_io_uring_enter, iFd, cToSubmit, cMinComplete, fFlags, NULL, 0);
+    if (RT_UNLIKELY(rc == -1))
+        return RTErrConvertFromErrno(errno);
+
+    return rc;
+}
+
+RT_C_DECLS_BEGIN
+
+/**
+ * Checks whether the host kernel provides an io_uring implementation we can use.
+ *
+ * The result is determined once and cached.  Setting the IPRT_FILEAIO_NO_IO_URING
+ * environment variable forces the legacy code paths.
+ *
+ * @returns true if io_uring is usable, false if not.
+ */
+DECLHIDDEN(bool) rtLinuxIoUringIsAvailable(void);
+
+RT_C_DECLS_END
+
+#endif
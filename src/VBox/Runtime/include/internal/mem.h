@@ -27,7 +27,7 @@
 #ifndef ___internal_mem_h
 #define ___internal_mem_h
 
-#include <iprt/cdefs.h>
+#include <iprt/types.h>
 
 RT_C_DECLS_BEGIN
 
@@ -51,6 +51,34 @@ DECLHIDDEN(void *)  rtMemBaseAlloc(size_t cb);
  */
 DECLHIDDEN(void)    rtMemBaseFree(void *pv);
 
+/** @def RTMEM_WITH_SIMD
+ * Defined when RTMemFirstNonZero can make use of SSE2.  Ring-3 only, as the
+ * other contexts cannot freely touch the vector registers. */
+#if defined(IN_RING3) \
+ && (defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)) \
+ && !defined(IPRT_WITHOUT_MEM_SIMD)
+# define RTMEM_WITH_SIMD
+#endif
+
+/** @def RTMEM_WITH_AVX2
+ * Defined when the AVX2 kernel in RTMemFirstNonZero-avx2.cpp is built.  The
+ * makefile defines IPRT_WITHOUT_MEM_AVX2 when the compiler cannot do AVX2. */
+#if defined(RTMEM_WITH_SIMD) && !defined(IPRT_WITHOUT_MEM_AVX2)
+# define RTMEM_WITH_AVX2
+#endif
+
+#ifdef RTMEM_WITH_AVX2
+/**
+ * AVX2 worker for RTMemFirstNonZero.
+ *
+ * @returns Pointer to the first non-zero byte, NULL if all zero.
+ * @param   pb          The start of the memory block, no alignment
+ *                      requirements.
+ * @param   cb          The size of the memory block.
+ */
+DECLHIDDEN(uint8_t const *) rtMemFirstNonZeroAvx2(uint8_t const *pb, size_t cb);
+#endif
+
 
 RT_C_DECLS_END
 
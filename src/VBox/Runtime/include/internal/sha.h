@@ -0,0 +1,110 @@
+/* $Id: sha.h $ */
+/** @file
+ * IPRT - Internal header for the SHA-1 and SHA-256 implementations.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+#ifndef ___internal_sha_h
+#define ___internal_sha_h
+
+#include <iprt/types.h>
+
+
+/** @def RTSHA_WITH_SIMD
+ * Defined when the SHA-1 and SHA-256 code can make use of the SHA extension
+ * (alt-sha-shani.cpp) and AVX2 multi-buffer (alt-sha-avx2.cpp) kernels.  This
+ * is ring-3 only since the other contexts can't freely touch the SSE and AVX
+ * registers.  The build defines IPRT_WITHOUT_SHA_SIMD when it leaves out the
+ * kernels because the compiler can't produce them (VCC100, gcc < 4.9). */
+#if defined(IN_RING3) \
+ && (defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)) \
+ && !defined(IPRT_WITHOUT_SHA_SIMD)
+# define RTSHA_WITH_SIMD
+#endif
+
+/** @name RTSHA_SIMD_F_XXX - Usable SIMD kernels, see rtShaSimdGetFeatures.
+ * @{ */
+/** The SHA extension kernels for single streams (SHA-NI). */
+#define RTSHA_SIMD_F_SHA_NI         RT_BIT_32(0)
+/** The eight lane AVX2 multi-buffer kernels. */
+#define RTSHA_SIMD_F_AVX2           RT_BIT_32(1)
+/** @} */
+
+/** The number of streams the AVX2 multi-buffer kernels process at once. */
+#define RTSHA_AVX2_LANES            8
+
+
+RT_C_DECLS_BEGIN
+
+#ifdef RTSHA_WITH_SIMD
+/**
+ * Queries which SIMD kernels the CPU and OS support.
+ *
+ * The result is determined once and cached.  Setting the IPRT_SHA_NO_SHA_NI or
+ * IPRT_SHA_NO_AVX2 environment variables hides the respective kernels.
+ *
+ * @returns RTSHA_SIMD_F_XXX.
+ */
+DECLHIDDEN(uint32_t) rtShaSimdGetFeatures(void);
+
+/**
+ * Processes whole SHA-1 blocks using the SHA extension.
+ *
+ * @param   pauH        The five hash words (host endian).
+ * @param   pbData      The data, no alignment requirements.
+ * @param   cBlocks     The number of 64 byte blocks to process.
+ */
+DECLHIDDEN(void)     rtSha1ShaNiProcess(uint32_t *pauH, uint8_t const *pbData, size_t cBlocks);
+
+/**
+ * Processes whole SHA-256 blocks using the SHA extension.
+ *
+ * @param   pauH        The eight hash words (host endian).
+ * @param   pbData      The data, no alignment requirements.
+ * @param   cBlocks     The number of 64 byte blocks to process.
+ */
+DECLHIDDEN(void)     rtSha256ShaNiProcess(uint32_t *pauH, uint8_t const *pbData, size_t cBlocks);
+
+/**
+ * Processes whole SHA-1 blocks of RTSHA_AVX2_LANES independent streams.
+ *
+ * @param   papauH      Pointers to the five hash words of each stream.
+ * @param   papbData    The data of each stream, no alignment requirements.
+ * @param   cBlocks     The number of 64 byte blocks to process in each stream.
+ */
+DECLHIDDEN(void)     rtSha1Avx2ProcessMulti(uint32_t * const *papauH, uint8_t const * const *papbData, size_t cBlocks);
+
+/**
+ * Processes whole SHA-256 blocks of RTSHA_AVX2_LANES independent streams.
+ *
+ * @param   papauH      Pointers to the eight hash words of each stream.
+ * @param   papbData    The data of each stream, no alignment requirements.
+ * @param   cBlocks     The number of 64 byte blocks to process in each stream.
+ */
+DECLHIDDEN(void)     rtSha256Avx2ProcessMulti(uint32_t * const *papauH, uint8_t const * const *papbData, size_t cBlocks);
+#endif
+
+RT_C_DECLS_END
+
+#endif
+
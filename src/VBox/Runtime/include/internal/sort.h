@@ -0,0 +1,124 @@
+/* $Id: sort.h $ */
+/** @file
+ * IPRT - Internal RTSort header.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+#ifndef ___internal_sort_h
+#define ___internal_sort_h
+
+#include <iprt/sort.h>
+#include <iprt/string.h>
+
+
+/**
+ * The sorting parameters passed around by the sort workers.
+ */
+typedef struct RTSORTSTATE
+{
+    /** The element size. */
+    size_t          cbElement;
+    /** The compare callback. */
+    PFNRTSORTCMP    pfnCmp;
+    /** The user argument for the callback. */
+    void           *pvUser;
+    /** Set if the elements are pointers which are passed to the callback
+     *  instead of the element addresses (RTSortApvXxx). */
+    bool            fApv;
+} RTSORTSTATE;
+/** Pointer to constant sorting parameters. */
+typedef RTSORTSTATE const *PCRTSORTSTATE;
+
+
+/**
+ * Compares two elements.
+ *
+ * @returns The callback result.
+ * @param   pState      The sorting parameters.
+ * @param   pb1         The 1st element.
+ * @param   pb2         The 2nd element.
+ */
+DECLINLINE(int) rtSortCmp(PCRTSORTSTATE pState, uint8_t const *pb1, uint8_t const *pb2)
+{
+    if (pState->fApv)
+        return pState->pfnCmp(*(void * const *)pb1, *(void * const *)pb2, pState->pvUser);
+    return pState->pfnCmp(pb1, pb2, pState->pvUser);
+}
+
+
+/**
+ * Copies one element.
+ *
+ * @param   pbDst       The destination.
+ * @param   pbSrc       The source.
+ * @param   cb          The element size.
+ */
+DECLINLINE(void) rtSortCopy(uint8_t *pbDst, uint8_t const *pbSrc, size_t cb)
+{
+    /* Constant sizes for the common cases so the compiler can inline them. */
+    if (cb == sizeof(void *))
+        memcpy(pbDst, pbSrc, sizeof(void *));
+    else if (cb == sizeof(uint32_t))
+        memcpy(pbDst, pbSrc, sizeof(uint32_t));
+    else
+        memcpy(pbDst, pbSrc, cb);
+}
+
+
+/**
+ * Swaps two elements.
+ *
+ * @param   pb1         The 1st element.
+ * @param   pb2         The 2nd element.
+ * @param   cb          The element size.
+ */
+DECLINLINE(void) rtSortSwap(uint8_t *pb1, uint8_t *pb2, size_t cb)
+{
+    if (cb == sizeof(void *))
+    {
+        void *pvTmp;
+        memcpy(&pvTmp, pb1, sizeof(void *));
+        memcpy(pb1, pb2, sizeof(void *));
+        memcpy(pb2, &pvTmp, sizeof(void *));
+        return;
+    }
+
+    while (cb >= sizeof(size_t))
+    {
+        size_t uTmp;
+        memcpy(&uTmp, pb1, sizeof(size_t));
+        memcpy(pb1, pb2, sizeof(size_t));
+        memcpy(pb2, &uTmp, sizeof(size_t));
+        pb1 += sizeof(size_t);
+        pb2 += sizeof(size_t);
+        cb  -= sizeof(size_t);
+    }
+    while (cb-- > 0)
+    {
+        uint8_t bTmp = *pb1;
+        *pb1++ = *pb2;
+        *pb2++ = bTmp;
+    }
+}
+
+#endif
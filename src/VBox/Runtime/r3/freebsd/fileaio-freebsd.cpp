@@ -136,6 +136,7 @@ RTR3DECL(int) RTFileAioGetLimits(PRTFILEAIOLIMITS pAioLimits)
 
     pAioLimits->cReqsOutstandingMax = cReqsOutstandingMax;
     pAioLimits->cbBufferAlignment   = 0;
+    pAioLimits->fFlags              = 0;
 
     return VINF_SUCCESS;
 }
@@ -228,6 +229,28 @@ RTDECL(int) RTFileAioReqPrepareWrite(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off
                                        off, (void *)pvBuf, cbWrite, pvUser);
 }
 
+RTDECL(int) RTFileAioReqPrepareReadSg(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
+                                      PCRTSGSEG paSegs, unsigned cSegs, void *pvUser)
+{
+    /* No vectored variant in the host API, single segments only. */
+    AssertPtrReturn(paSegs, VERR_INVALID_POINTER);
+    AssertReturn(cSegs > 0, VERR_INVALID_PARAMETER);
+    if (cSegs != 1)
+        return VERR_NOT_SUPPORTED;
+    return RTFileAioReqPrepareRead(hReq, hFile, off, paSegs[0].pvSeg, paSegs[0].cbSeg, pvUser);
+}
+
+RTDECL(int) RTFileAioReqPrepareWriteSg(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
+                                       PCRTSGSEG paSegs, unsigned cSegs, void *pvUser)
+{
+    /* No vectored variant in the host API, single segments only. */
+    AssertPtrReturn(paSegs, VERR_INVALID_POINTER);
+    AssertReturn(cSegs > 0, VERR_INVALID_PARAMETER);
+    if (cSegs != 1)
+        return VERR_NOT_SUPPORTED;
+    return RTFileAioReqPrepareWrite(hReq, hFile, off, paSegs[0].pvSeg, paSegs[0].cbSeg, pvUser);
+}
+
 RTDECL(int) RTFileAioReqPrepareFlush(RTFILEAIOREQ hReq, RTFILE hFile, void *pvUser)
 {
     PRTFILEAIOREQINTERNAL pReqInt = (PRTFILEAIOREQINTERNAL)hReq;
@@ -40,6 +40,20 @@
  * compensated if the user of this API implements caching itself. The next
  * limitation is that data buffers must be aligned at a 512 byte boundary or the
  * request will fail.
+ *
+ * Kernels providing io_uring (5.4 and later) don't have these limitations, the
+ * ring is used instead of the io_* syscalls when the kernel supports it (see
+ * rtLinuxIoUringIsAvailable). Reads and writes go through IORING_OP_READV and
+ * IORING_OP_WRITEV which work for buffered files as well since the kernel
+ * punts blocking operations to its worker pool. RTFILE_O_ASYNC_IO still implies
+ * O_DIRECT, files opened without it use the host cache and are reported as
+ * working through RTFILEAIOLIMITS_F_BUFFERED. Flushes are submitted with the
+ * drain flag so they are only started once all previously submitted requests
+ * completed. The completion ring file descriptor is polled together with an
+ * eventfd which makes the wakeup from RTFileAioCtxWakeup reliable without
+ * poking the waiting thread.
+ * Should the ring setup fail for a context (RLIMIT_MEMLOCK on older kernels),
+ * that context falls back to the io_* syscalls.
  */
 /** @todo r=bird: What's this about "must be opened with O_DIRECT"? An
  *        explanation would be nice, esp. seeing what Linus is quoted saying
@@ -52,15 +66,23 @@
 #include <iprt/asm.h>
 #include <iprt/mem.h>
 #include <iprt/assert.h>
+#include <iprt/critsect.h>
 #include <iprt/string.h>
 #include <iprt/err.h>
 #include <iprt/log.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 #include "internal/fileaio.h"
+#include "internal/iouring-linux.h"
 
 #include <unistd.h>
 #include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <errno.h>
+#include <limits.h>
+#include <poll.h>
 
 #include <iprt/file.h>
 
@@ -79,7 +101,9 @@ enum
     LNXKAIO_IOCB_CMD_READ   = 0,
     LNXKAIO_IOCB_CMD_WRITE  = 1,
     LNXKAIO_IOCB_CMD_FSYNC  = 2,
-    LNXKAIO_IOCB_CMD_FDSYNC = 3
+    LNXKAIO_IOCB_CMD_FDSYNC = 3,
+    LNXKAIO_IOCB_CMD_PREADV = 7,
+    LNXKAIO_IOCB_CMD_PWRITEV = 8
 };
 
 /**
@@ -183,10 +207,53 @@ typedef struct RTFILEAIOCTXINTERNAL
     volatile bool       fWokenUp;
     /** Flag whether the thread is currently waiting in the syscall. */
     volatile bool       fWaiting;
+    /** Set if this context uses io_uring instead of the io_* syscalls. */
+    bool                fIoUring;
     /** Flags given during creation. */
     uint32_t            fFlags;
     /** Magic value (RTFILEAIOCTX_MAGIC). */
     uint32_t            u32Magic;
+    /** The io_uring state, only valid if fIoUring is set. */
+    struct
+    {
+        /** The ring file descriptor. */
+        int                 iFdRing;
+        /** The eventfd RTFileAioCtxWakeup() signals. */
+        int                 iFdEvt;
+        /** The mapping of the SQ and CQ rings. */
+        uint8_t            *pbRings;
+        /** Size of the ring mapping. */
+        size_t              cbRings;
+        /** The submission queue entries. */
+        PLNXIOURINGSQE      paSqes;
+        /** Size of the submission queue entry mapping. */
+        size_t              cbSqes;
+        /** The SQ head index, advanced by the kernel. */
+        uint32_t volatile  *pu32SqHead;
+        /** The SQ tail index, advanced by us. */
+        uint32_t volatile  *pu32SqTail;
+        /** The SQ index array. */
+        uint32_t volatile  *pau32SqArray;
+        /** SQ index mask. */
+        uint32_t            fSqMask;
+        /** Number of submission queue entries. */
+        uint32_t            cSqEntries;
+        /** The CQ head index, advanced by us. */
+        uint32_t volatile  *pu32CqHead;
+        /** The CQ tail index, advanced by the kernel. */
+        uint32_t volatile  *pu32CqTail;
+        /** The completion queue entries. */
+        PLNXIOURINGCQE      paCqes;
+        /** CQ index mask. */
+        uint32_t            fCqMask;
+        /** Number of completion queue entries, this also limits the number of
+         * requests in flight so completions can never be dropped. */
+        uint32_t            cCqEntries;
+        /** Number of SQEs queued but not yet consumed by the kernel. */
+        uint32_t volatile   cSqPending;
+        /** Serializes submitters. */
+        RTCRITSECT          CritSect;
+    } IoUring;
 } RTFILEAIOCTXINTERNAL;
 /** Pointer to an internal context structure. */
 typedef RTFILEAIOCTXINTERNAL *PRTFILEAIOCTXINTERNAL;
@@ -211,6 +278,12 @@ typedef struct RTFILEAIOREQINTERNAL
     PRTFILEAIOCTXINTERNAL pCtxInt;
     /** Magic value  (RTFILEAIOREQ_MAGIC). */
     uint32_t              u32Magic;
+    /** Number of entries allocated in paIoVecs. */
+    uint32_t              cIoVecsAlloc;
+    /** I/O vector array for S/G requests, grown on demand. */
+    struct iovec         *paIoVecs;
+    /** Single segment I/O vector for plain transfers going through io_uring. */
+    struct iovec          IoVec;
 } RTFILEAIOREQINTERNAL;
 /** Pointer to an internal request structure. */
 typedef RTFILEAIOREQINTERNAL *PRTFILEAIOREQINTERNAL;
@@ -287,6 +360,368 @@ DECLINLINE(int) rtFileAsyncIoLinuxGetEvents(LNXKAIOCONTEXT AioContext, long cReq
     return rc;
 }
 
+/**
+ * Sets up the io_uring instance of a context.
+ *
+ * @returns IPRT status code.
+ * @param   pCtxInt         The context.
+ * @param   cAioReqsMax     The maximum number of requests the caller wants to
+ *                          have in flight.
+ */
+static int rtFileAioCtxLinuxIoUringInit(PRTFILEAIOCTXINTERNAL pCtxInt, uint32_t cAioReqsMax)
+{
+    uint32_t cEntries = 1;
+    while (cEntries < cAioReqsMax && cEntries < LNXIOURING_MAX_ENTRIES)
+        cEntries <<= 1;
+
+    LNXIOURINGPARAMS Params;
+    RT_ZERO(Params);
+    int iFdRing = -1;
+    int rc = rtLinuxIoUringSetup(cEntries, &Params, &iFdRing);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    /*
+     * Map the rings (one mapping, see rtLinuxIoUringIsAvailable) and the SQEs.
+     */
+    size_t const cbSqRing = Params.SqOffsets.offArray + Params.cSqEntries * sizeof(uint32_t);
+    size_t const cbCqRing = Params.CqOffsets.offCqes  + Params.cCqEntries * sizeof(LNXIOURINGCQE);
+    size_t const cbRings  = RT_MAX(cbSqRing, cbCqRing);
+    size_t const cbSqes   = Params.cSqEntries * sizeof(LNXIOURINGSQE);
+    void *pvRings = mmap(NULL, cbRings, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         iFdRing, LNXIOURING_OFF_SQ_RING);
+    if (pvRings != MAP_FAILED)
+    {
+        void *pvSqes = mmap(NULL, cbSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            iFdRing, LNXIOURING_OFF_SQES);
+        if (pvSqes != MAP_FAILED)
+        {
+            int iFdEvt = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (iFdEvt != -1)
+            {
+                rc = RTCritSectInit(&pCtxInt->IoUring.CritSect);
+                if (RT_SUCCESS(rc))
+                {
+                    uint8_t *pbRings = (uint8_t *)pvRings;
+                    pCtxInt->IoUring.iFdRing      = iFdRing;
+                    pCtxInt->IoUring.iFdEvt       = iFdEvt;
+                    pCtxInt->IoUring.pbRings      = pbRings;
+                    pCtxInt->IoUring.cbRings      = cbRings;
+                    pCtxInt->IoUring.paSqes       = (PLNXIOURINGSQE)pvSqes;
+                    pCtxInt->IoUring.cbSqes       = cbSqes;
+                    pCtxInt->IoUring.pu32SqHead   = (uint32_t volatile *)(pbRings + Params.SqOffsets.offHead);
+                    pCtxInt->IoUring.pu32SqTail   = (uint32_t volatile *)(pbRings + Params.SqOffsets.offTail);
+                    pCtxInt->IoUring.pau32SqArray = (uint32_t volatile *)(pbRings + Params.SqOffsets.offArray);
+                    pCtxInt->IoUring.fSqMask      = *(uint32_t *)(pbRings + Params.SqOffsets.offRingMask);
+                    pCtxInt->IoUring.cSqEntries   = Params.cSqEntries;
+                    pCtxInt->IoUring.pu32CqHead   = (uint32_t volatile *)(pbRings + Params.CqOffsets.offHead);
+                    pCtxInt->IoUring.pu32CqTail   = (uint32_t volatile *)(pbRings + Params.CqOffsets.offTail);
+                    pCtxInt->IoUring.paCqes       = (PLNXIOURINGCQE)(pbRings + Params.CqOffsets.offCqes);
+                    pCtxInt->IoUring.fCqMask      = *(uint32_t *)(pbRings + Params.CqOffsets.offRingMask);
+                    pCtxInt->IoUring.cCqEntries   = Params.cCqEntries;
+                    pCtxInt->IoUring.cSqPending   = 0;
+                    return VINF_SUCCESS;
+                }
+                close(iFdEvt);
+            }
+            else
+                rc = RTErrConvertFromErrno(errno);
+            munmap(pvSqes, cbSqes);
+        }
+        else
+            rc = RTErrConvertFromErrno(errno);
+        munmap(pvRings, cbRings);
+    }
+    else
+        rc = RTErrConvertFromErrno(errno);
+    close(iFdRing);
+    return rc;
+}
+
+
+/**
+ * Tears down the io_uring instance of a context.
+ *
+ * @param   pCtxInt         The context.
+ */
+static void rtFileAioCtxLinuxIoUringTerm(PRTFILEAIOCTXINTERNAL pCtxInt)
+{
+    RTCritSectDelete(&pCtxInt->IoUring.CritSect);
+    munmap(pCtxInt->IoUring.paSqes, pCtxInt->IoUring.cbSqes);
+    munmap(pCtxInt->IoUring.pbRings, pCtxInt->IoUring.cbRings);
+    close(pCtxInt->IoUring.iFdEvt);
+    close(pCtxInt->IoUring.iFdRing);
+    pCtxInt->IoUring.iFdEvt  = -1;
+    pCtxInt->IoUring.iFdRing = -1;
+}
+
+
+/**
+ * Hands the queued SQEs to the kernel, caller owns the submission lock.
+ *
+ * @returns IPRT status code.  The SQEs stay queued on failure and are retried
+ *          by the next submit or wait call.
+ * @param   pCtxInt         The context.
+ */
+static int rtFileAioCtxLinuxIoUringFlushLocked(PRTFILEAIOCTXINTERNAL pCtxInt)
+{
+    while (pCtxInt->IoUring.cSqPending)
+    {
+        int rc = rtLinuxIoUringEnter(pCtxInt->IoUring.iFdRing, pCtxInt->IoUring.cSqPending, 0, 0);
+        if (rc > 0)
+            ASMAtomicSubU32(&pCtxInt->IoUring.cSqPending, (uint32_t)rc);
+        else if (rc != VERR_INTERRUPTED)
+        {
+            /* EAGAIN and EBUSY are transient, anything else is a bug. */
+            AssertMsg(rc == VINF_SUCCESS || rc == VERR_TRY_AGAIN || rc == VERR_RESOURCE_BUSY, ("rc=%Rrc\n", rc));
+            return rc == VINF_SUCCESS ? VERR_TRY_AGAIN : rc;
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Translates a prepared request into a submission queue entry.
+ *
+ * @param   pReqInt         The request.
+ * @param   pSqe            The submission queue entry to fill in.
+ */
+static void rtFileAioReqLinuxIoUringPrepSqe(PRTFILEAIOREQINTERNAL pReqInt, PLNXIOURINGSQE pSqe)
+{
+    RT_BZERO(pSqe, sizeof(*pSqe));
+    pSqe->iFd         = (int32_t)pReqInt->AioCB.uFileDesc;
+    pSqe->u64UserData = (uintptr_t)pReqInt;
+
+    switch (pReqInt->AioCB.u16IoOpCode)
+    {
+        case LNXKAIO_IOCB_CMD_READ:
+        case LNXKAIO_IOCB_CMD_WRITE:
+            pReqInt->IoVec.iov_base = pReqInt->AioCB.pvBuf;
+            pReqInt->IoVec.iov_len  = pReqInt->AioCB.cbTransfer;
+            pSqe->u8OpCode = pReqInt->AioCB.u16IoOpCode == LNXKAIO_IOCB_CMD_READ
+                           ? LNXIOURING_OP_READV : LNXIOURING_OP_WRITEV;
+            pSqe->off      = pReqInt->AioCB.off;
+            pSqe->u64Addr  = (uintptr_t)&pReqInt->IoVec;
+            pSqe->cbLen    = 1;
+            break;
+
+        case LNXKAIO_IOCB_CMD_PREADV:
+        case LNXKAIO_IOCB_CMD_PWRITEV:
+            /* pvBuf points to the I/O vector and cbTransfer holds the segment count. */
+            pSqe->u8OpCode = pReqInt->AioCB.u16IoOpCode == LNXKAIO_IOCB_CMD_PREADV
+                           ? LNXIOURING_OP_READV : LNXIOURING_OP_WRITEV;
+            pSqe->off      = pReqInt->AioCB.off;
+            pSqe->u64Addr  = (uintptr_t)pReqInt->AioCB.pvBuf;
+            pSqe->cbLen    = (uint32_t)pReqInt->AioCB.cbTransfer;
+            break;
+
+        case LNXKAIO_IOCB_CMD_FSYNC:
+            /* A flush must cover everything submitted before it. */
+            pSqe->u8OpCode = LNXIOURING_OP_FSYNC;
+            pSqe->fFlags   = LNXIOURING_SQE_F_IO_DRAIN;
+            break;
+
+        default:
+            AssertMsgFailed(("%u\n", pReqInt->AioCB.u16IoOpCode));
+            pSqe->u8OpCode = LNXIOURING_OP_NOP;
+            break;
+    }
+}
+
+
+/**
+ * Completes a request with the result returned by the kernel.
+ *
+ * @param   pReqInt         The request.
+ * @param   rcLnx           The result, number of bytes transferred or negative
+ *                          errno.
+ */
+DECLINLINE(void) rtFileAioReqLinuxComplete(PRTFILEAIOREQINTERNAL pReqInt, int64_t rcLnx)
+{
+    if (RT_UNLIKELY(rcLnx < 0))
+        pReqInt->Rc = RTErrConvertFromErrno((int)-rcLnx); /* Convert to positive value. */
+    else
+    {
+        pReqInt->Rc = VINF_SUCCESS;
+        pReqInt->cbTransfered = (size_t)rcLnx;
+    }
+
+    /* Mark the request as finished. */
+    RTFILEAIOREQ_SET_STATE(pReqInt, COMPLETED);
+}
+
+
+/**
+ * Queues requests on the io_uring of a context and submits them.
+ *
+ * @returns IPRT status code.
+ * @retval  VERR_FILE_AIO_INSUFFICIENT_RESSOURCES if not all requests could be
+ *          submitted, the ones left behind are back in the prepared state.
+ * @param   pCtxInt         The context.
+ * @param   pahReqs         The requests, validated and marked as submitted.
+ * @param   cReqs           Number of requests.
+ */
+static int rtFileAioCtxLinuxIoUringSubmit(PRTFILEAIOCTXINTERNAL pCtxInt, PRTFILEAIOREQ pahReqs, size_t cReqs)
+{
+    RTCritSectEnter(&pCtxInt->IoUring.CritSect);
+
+    /*
+     * Never have more requests in flight than the CQ holds, completions would be
+     * dropped (or buffered in kernel memory on newer kernels) otherwise.  Only
+     * submitters increment the counter and they are serialized by the lock.
+     */
+    uint32_t const cInFlight = RT_MIN((uint32_t)ASMAtomicReadS32(&pCtxInt->cRequests), pCtxInt->IoUring.cCqEntries);
+    size_t const   cQueue    = RT_MIN(cReqs, pCtxInt->IoUring.cCqEntries - cInFlight);
+    ASMAtomicAddS32(&pCtxInt->cRequests, (int32_t)cQueue);
+
+    uint32_t uTail = *pCtxInt->IoUring.pu32SqTail;
+    size_t   i;
+    for (i = 0; i < cQueue; i++)
+    {
+        if (uTail - ASMAtomicReadU32(pCtxInt->IoUring.pu32SqHead) >= pCtxInt->IoUring.cSqEntries)
+        {
+            /* The SQ is full, hand what we've got to the kernel. */
+            ASMAtomicWriteU32(pCtxInt->IoUring.pu32SqTail, uTail);
+            rtFileAioCtxLinuxIoUringFlushLocked(pCtxInt);
+            if (uTail - ASMAtomicReadU32(pCtxInt->IoUring.pu32SqHead) >= pCtxInt->IoUring.cSqEntries)
+                break;
+        }
+
+        uint32_t const idxSqe = uTail & pCtxInt->IoUring.fSqMask;
+        rtFileAioReqLinuxIoUringPrepSqe(pahReqs[i], &pCtxInt->IoUring.paSqes[idxSqe]);
+        pCtxInt->IoUring.pau32SqArray[idxSqe] = idxSqe;
+        uTail++;
+        ASMAtomicIncU32(&pCtxInt->IoUring.cSqPending);
+    }
+    ASMAtomicWriteU32(pCtxInt->IoUring.pu32SqTail, uTail);
+
+    /* SQEs the kernel doesn't take right now stay queued and are picked up by
+       the next submit or by RTFileAioCtxWait(), they are in flight as far as
+       the caller is concerned. */
+    rtFileAioCtxLinuxIoUringFlushLocked(pCtxInt);
+    RTCritSectLeave(&pCtxInt->IoUring.CritSect);
+
+    if (i < cReqs)
+    {
+        ASMAtomicSubS32(&pCtxInt->cRequests, (int32_t)(cQueue - i));
+        for (size_t iUndo = i; iUndo < cReqs; iUndo++)
+        {
+            PRTFILEAIOREQINTERNAL pReqInt = pahReqs[iUndo];
+            pReqInt->pCtxInt = NULL;
+            RTFILEAIOREQ_SET_STATE(pReqInt, PREPARED);
+        }
+        return VERR_FILE_AIO_INSUFFICIENT_RESSOURCES;
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Moves completed requests from the CQ into the caller's array.
+ *
+ * @returns Number of requests completed.
+ * @param   pCtxInt         The context.
+ * @param   pahReqs         Where to store the completed requests.
+ * @param   cReqs           The size of the array.
+ */
+static uint32_t rtFileAioCtxLinuxIoUringReap(PRTFILEAIOCTXINTERNAL pCtxInt, PRTFILEAIOREQ pahReqs, size_t cReqs)
+{
+    uint32_t       cDone = 0;
+    uint32_t       uHead = *pCtxInt->IoUring.pu32CqHead;
+    uint32_t const uTail = ASMAtomicReadU32(pCtxInt->IoUring.pu32CqTail);
+    while (   uHead != uTail
+           && cDone < cReqs)
+    {
+        PLNXIOURINGCQE pCqe = &pCtxInt->IoUring.paCqes[uHead & pCtxInt->IoUring.fCqMask];
+        PRTFILEAIOREQINTERNAL pReqInt = (PRTFILEAIOREQINTERNAL)(uintptr_t)pCqe->u64UserData;
+        AssertPtr(pReqInt);
+        Assert(pReqInt->u32Magic == RTFILEAIOREQ_MAGIC);
+
+        rtFileAioReqLinuxComplete(pReqInt, pCqe->rcLnx);
+        pahReqs[cDone++] = (RTFILEAIOREQ)pReqInt;
+        uHead++;
+    }
+    ASMAtomicWriteU32(pCtxInt->IoUring.pu32CqHead, uHead);
+    return cDone;
+}
+
+
+/**
+ * The io_uring part of RTFileAioCtxWait().
+ *
+ * @returns IPRT status code.
+ * @param   pCtxInt         The context.
+ * @param   cMinReqs        The minimum number of requests to wait for, at least 1.
+ * @param   cMillies        The timeout.
+ * @param   pahReqs         Where to store the completed requests.
+ * @param   cReqs           The size of the array.
+ * @param   pcReqs          Where to return the number of completed requests.
+ */
+static int rtFileAioCtxLinuxIoUringWait(PRTFILEAIOCTXINTERNAL pCtxInt, size_t cMinReqs, RTMSINTERVAL cMillies,
+                                        PRTFILEAIOREQ pahReqs, size_t cReqs, uint32_t *pcReqs)
+{
+    int            rc          = VINF_SUCCESS;
+    uint32_t       cDone       = 0;
+    uint64_t const StartNanoTS = RTTimeNanoTS();
+    while (!pCtxInt->fWokenUp)
+    {
+        /* Push SQEs a previous submit couldn't get rid of. */
+        bool fSqPending = false;
+        if (ASMAtomicReadU32(&pCtxInt->IoUring.cSqPending))
+        {
+            RTCritSectEnter(&pCtxInt->IoUring.CritSect);
+            fSqPending = RT_FAILURE(rtFileAioCtxLinuxIoUringFlushLocked(pCtxInt));
+            RTCritSectLeave(&pCtxInt->IoUring.CritSect);
+        }
+
+        cDone += rtFileAioCtxLinuxIoUringReap(pCtxInt, &pahReqs[cDone], cReqs - cDone);
+        if (cDone >= cMinReqs)
+            break;
+
+        int cMsWait = -1;
+        if (cMillies != RT_INDEFINITE_WAIT)
+        {
+            uint64_t cMilliesElapsed = (RTTimeNanoTS() - StartNanoTS) / RT_NS_1MS;
+            if (cMilliesElapsed >= cMillies)
+            {
+                rc = VERR_TIMEOUT;
+                break;
+            }
+            cMsWait = (int)RT_MIN(cMillies - cMilliesElapsed, (uint64_t)INT32_MAX);
+        }
+        if (fSqPending)
+            cMsWait = cMsWait == -1 ? 1 : RT_MIN(cMsWait, 1);
+
+        /*
+         * The ring descriptor turns readable when there are CQEs, the eventfd
+         * when RTFileAioCtxWakeup() was called.
+         */
+        struct pollfd aFds[2];
+        aFds[0].fd      = pCtxInt->IoUring.iFdRing;
+        aFds[0].events  = POLLIN;
+        aFds[0].revents = 0;
+        aFds[1].fd      = pCtxInt->IoUring.iFdEvt;
+        aFds[1].events  = POLLIN;
+        aFds[1].revents = 0;
+        int rcPoll = poll(&aFds[0], RT_ELEMENTS(aFds), cMsWait);
+        if (rcPoll > 0 && (aFds[1].revents & POLLIN))
+        {
+            uint64_t u64Ignored;
+            ssize_t cbIgnored = read(pCtxInt->IoUring.iFdEvt, &u64Ignored, sizeof(u64Ignored));
+            NOREF(cbIgnored);
+        }
+        else if (rcPoll < 0 && errno != EINTR)
+        {
+            rc = RTErrConvertFromErrno(errno);
+            break;
+        }
+    }
+
+    *pcReqs = cDone;
+    return rc;
+}
+
 RTR3DECL(int) RTFileAioGetLimits(PRTFILEAIOLIMITS pAioLimits)
 {
     int rc = VINF_SUCCESS;
@@ -294,20 +729,26 @@ RTR3DECL(int) RTFileAioGetLimits(PRTFILEAIOLIMITS pAioLimits)
 
     /*
      * Check if the API is implemented by creating a
-     * completion port.
+     * completion port, unless io_uring is there.
      */
-    LNXKAIOCONTEXT AioContext = 0;
-    rc = rtFileAsyncIoLinuxCreate(1, &AioContext);
-    if (RT_FAILURE(rc))
-        return rc;
+    if (!rtLinuxIoUringIsAvailable())
+    {
+        LNXKAIOCONTEXT AioContext = 0;
+        rc = rtFileAsyncIoLinuxCreate(1, &AioContext);
+        if (RT_FAILURE(rc))
+            return rc;
 
-    rc = rtFileAsyncIoLinuxDestroy(AioContext);
-    if (RT_FAILURE(rc))
-        return rc;
+        rc = rtFileAsyncIoLinuxDestroy(AioContext);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
 
-    /* Supported - fill in the limits. The alignment is the only restriction. */
+    /* Supported - fill in the limits. The alignment is the only restriction
+       and applies to RTFILE_O_ASYNC_IO files (O_DIRECT).  With io_uring files
+       opened without it work asynchronously as well. */
     pAioLimits->cReqsOutstandingMax = RTFILEAIO_UNLIMITED_REQS;
     pAioLimits->cbBufferAlignment   = 512;
+    pAioLimits->fFlags              = rtLinuxIoUringIsAvailable() ? RTFILEAIOLIMITS_F_BUFFERED : 0;
 
     return VINF_SUCCESS;
 }
@@ -348,6 +789,7 @@ RTDECL(int) RTFileAioReqDestroy(RTFILEAIOREQ hReq)
      * Trash the magic and free it.
      */
     ASMAtomicUoWriteU32(&pReqInt->u32Magic, ~RTFILEAIOREQ_MAGIC);
+    RTMemFree(pReqInt->paIoVecs);
     RTMemFree(pReqInt);
     return VINF_SUCCESS;
 }
@@ -409,6 +851,59 @@ RTDECL(int) RTFileAioReqPrepareWrite(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off
 }
 
 
+/**
+ * Worker setting up a S/G request.
+ *
+ * The segments are copied into an I/O vector owned by the request.  The control
+ * block takes the vector address in pvBuf and the segment count in cbTransfer,
+ * which is what the kernel expects for the vectored commands.
+ */
+static int rtFileAioReqPrepareTransferSg(RTFILEAIOREQ hReq, RTFILE hFile, uint16_t uTransferDirection,
+                                         RTFOFF off, PCRTSGSEG paSegs, unsigned cSegs, void *pvUser)
+{
+    PRTFILEAIOREQINTERNAL pReqInt = hReq;
+    RTFILEAIOREQ_VALID_RETURN(pReqInt);
+    RTFILEAIOREQ_NOT_STATE_RETURN_RC(pReqInt, SUBMITTED, VERR_FILE_AIO_IN_PROGRESS);
+    AssertPtrReturn(paSegs, VERR_INVALID_POINTER);
+    AssertReturn(cSegs > 0 && cSegs <= IOV_MAX, VERR_INVALID_PARAMETER);
+
+    if (cSegs > pReqInt->cIoVecsAlloc)
+    {
+        struct iovec *paIoVecsNew = (struct iovec *)RTMemRealloc(pReqInt->paIoVecs, cSegs * sizeof(struct iovec));
+        if (RT_UNLIKELY(!paIoVecsNew))
+            return VERR_NO_MEMORY;
+        pReqInt->paIoVecs     = paIoVecsNew;
+        pReqInt->cIoVecsAlloc = cSegs;
+    }
+
+    for (unsigned i = 0; i < cSegs; i++)
+    {
+        AssertPtr(paSegs[i].pvSeg);
+        pReqInt->paIoVecs[i].iov_base = paSegs[i].pvSeg;
+        pReqInt->paIoVecs[i].iov_len  = paSegs[i].cbSeg;
+    }
+
+    return rtFileAioReqPrepareTransfer(pReqInt, hFile, uTransferDirection,
+                                       off, pReqInt->paIoVecs, cSegs, pvUser);
+}
+
+
+RTDECL(int) RTFileAioReqPrepareReadSg(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
+                                      PCRTSGSEG paSegs, unsigned cSegs, void *pvUser)
+{
+    return rtFileAioReqPrepareTransferSg(hReq, hFile, LNXKAIO_IOCB_CMD_PREADV,
+                                         off, paSegs, cSegs, pvUser);
+}
+
+
+RTDECL(int) RTFileAioReqPrepareWriteSg(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
+                                       PCRTSGSEG paSegs, unsigned cSegs, void *pvUser)
+{
+    return rtFileAioReqPrepareTransferSg(hReq, hFile, LNXKAIO_IOCB_CMD_PWRITEV,
+                                         off, paSegs, cSegs, pvUser);
+}
+
+
 RTDECL(int) RTFileAioReqPrepareFlush(RTFILEAIOREQ hReq, RTFILE hFile, void *pvUser)
 {
     PRTFILEAIOREQINTERNAL pReqInt = hReq;
@@ -436,6 +931,14 @@ RTDECL(int) RTFileAioReqCancel(RTFILEAIOREQ hReq)
     RTFILEAIOREQ_VALID_RETURN(pReqInt);
     RTFILEAIOREQ_STATE_RETURN_RC(pReqInt, SUBMITTED, VERR_FILE_AIO_NOT_SUBMITTED);
 
+    /* Requests on the ring can't be taken back, the kernel either already
+       started them or will do so shortly.  IORING_OP_ASYNC_CANCEL only
+       succeeds for requests still waiting in the kernel which hardly ever
+       applies to file I/O, and would need its own completion handling in the
+       reaper for little gain, so it isn't used. */
+    if (pReqInt->pCtxInt->fIoUring)
+        return VERR_FILE_AIO_IN_PROGRESS;
+
     LNXKAIOIOEVENT AioEvent;
     int rc = rtFileAsyncIoLinuxCancel(pReqInt->AioContext, &pReqInt->AioCB, &AioEvent);
     if (RT_SUCCESS(rc))
@@ -489,8 +992,21 @@ RTDECL(int) RTFileAioCtxCreate(PRTFILEAIOCTX phAioCtx, uint32_t cAioReqsMax,
     if (RT_UNLIKELY(!pCtxInt))
         return VERR_NO_MEMORY;
 
-    /* Init the event handle. */
-    int rc = rtFileAsyncIoLinuxCreate(cAioReqsMax, &pCtxInt->AioContext);
+    /* Init the event handle, preferring io_uring.  The ring setup can fail
+       when the locked memory limit is exceeded on older kernels, use the
+       io_* syscalls for this context then. */
+    int rc = VERR_NOT_SUPPORTED;
+    pCtxInt->IoUring.iFdRing = -1;
+    pCtxInt->IoUring.iFdEvt  = -1;
+    if (rtLinuxIoUringIsAvailable())
+    {
+        rc = rtFileAioCtxLinuxIoUringInit(pCtxInt, cAioReqsMax);
+        pCtxInt->fIoUring = RT_SUCCESS(rc);
+        if (RT_FAILURE(rc))
+            LogRel(("RTFileAioCtxCreate: io_uring setup failed with %Rrc, using the legacy interface\n", rc));
+    }
+    if (!pCtxInt->fIoUring)
+        rc = rtFileAsyncIoLinuxCreate(cAioReqsMax, &pCtxInt->AioContext);
     if (RT_SUCCESS(rc))
     {
         pCtxInt->fWokenUp     = false;
@@ -521,9 +1037,14 @@ RTDECL(int) RTFileAioCtxDestroy(RTFILEAIOCTX hAioCtx)
         return VERR_FILE_AIO_BUSY;
 
     /* The native bit first, then mark it as dead and free it. */
-    int rc = rtFileAsyncIoLinuxDestroy(pCtxInt->AioContext);
-    if (RT_FAILURE(rc))
-        return rc;
+    if (pCtxInt->fIoUring)
+        rtFileAioCtxLinuxIoUringTerm(pCtxInt);
+    else
+    {
+        int rc = rtFileAsyncIoLinuxDestroy(pCtxInt->AioContext);
+        if (RT_FAILURE(rc))
+            return rc;
+    }
     ASMAtomicUoWriteU32(&pCtxInt->u32Magic, RTFILEAIOCTX_MAGIC_DEAD);
     RTMemFree(pCtxInt);
 
@@ -590,6 +1111,9 @@ RTDECL(int) RTFileAioCtxSubmit(RTFILEAIOCTX hAioCtx, PRTFILEAIOREQ pahReqs, size
         RTFILEAIOREQ_SET_STATE(pReqInt, SUBMITTED);
     }
 
+    if (pCtxInt->fIoUring)
+        return rtFileAioCtxLinuxIoUringSubmit(pCtxInt, pahReqs, cReqs);
+
     do
     {
         /*
@@ -695,72 +1219,72 @@ RTDECL(int) RTFileAioCtxWait(RTFILEAIOCTX hAioCtx, size_t cMinReqs, RTMSINTERVAL
      */
     int rc = VINF_SUCCESS;
     int cRequestsCompleted = 0;
-    while (!pCtxInt->fWokenUp)
+    if (pCtxInt->fIoUring)
     {
-        LNXKAIOIOEVENT  aPortEvents[AIO_MAXIMUM_REQUESTS_PER_CONTEXT];
-        int             cRequestsToWait = RT_MIN(cReqs, AIO_MAXIMUM_REQUESTS_PER_CONTEXT);
-        ASMAtomicXchgBool(&pCtxInt->fWaiting, true);
-        rc = rtFileAsyncIoLinuxGetEvents(pCtxInt->AioContext, cMinReqs, cRequestsToWait, &aPortEvents[0], pTimeout);
-        ASMAtomicXchgBool(&pCtxInt->fWaiting, false);
-        if (RT_FAILURE(rc))
-            break;
-        uint32_t const cDone = rc;
-        rc = VINF_SUCCESS;
-
-        /*
-         * Process received events / requests.
-         */
-        for (uint32_t i = 0; i < cDone; i++)
+        uint32_t cDone = 0;
+        rc = rtFileAioCtxLinuxIoUringWait(pCtxInt, cMinReqs, cMillies, pahReqs, cReqs, &cDone);
+        cRequestsCompleted = cDone;
+    }
+    else
+    {
+        while (!pCtxInt->fWokenUp)
         {
+            LNXKAIOIOEVENT  aPortEvents[AIO_MAXIMUM_REQUESTS_PER_CONTEXT];
+            int             cRequestsToWait = RT_MIN(cReqs, AIO_MAXIMUM_REQUESTS_PER_CONTEXT);
+            ASMAtomicXchgBool(&pCtxInt->fWaiting, true);
+            rc = rtFileAsyncIoLinuxGetEvents(pCtxInt->AioContext, cMinReqs, cRequestsToWait, &aPortEvents[0], pTimeout);
+            ASMAtomicXchgBool(&pCtxInt->fWaiting, false);
+            if (RT_FAILURE(rc))
+                break;
+            uint32_t const cDone = rc;
+            rc = VINF_SUCCESS;
+
             /*
-             * The iocb is the first element in our request structure.
-             * So we can safely cast it directly to the handle (see above)
+             * Process received events / requests.
              */
-            PRTFILEAIOREQINTERNAL pReqInt = (PRTFILEAIOREQINTERNAL)aPortEvents[i].pIoCB;
-            AssertPtr(pReqInt);
-            Assert(pReqInt->u32Magic == RTFILEAIOREQ_MAGIC);
-
-            /** @todo aeichner: The rc field contains the result code
-             *  like you can find in errno for the normal read/write ops.
-             *  But there is a second field called rc2. I don't know the
-             *  purpose for it yet.
-             */
-            if (RT_UNLIKELY(aPortEvents[i].rc < 0))
-                pReqInt->Rc = RTErrConvertFromErrno(-aPortEvents[i].rc); /* Convert to positive value. */
-            else
+            for (uint32_t i = 0; i < cDone; i++)
             {
-                pReqInt->Rc = VINF_SUCCESS;
-                pReqInt->cbTransfered = aPortEvents[i].rc;
+                /*
+                 * The iocb is the first element in our request structure.
+                 * So we can safely cast it directly to the handle (see above)
+                 */
+                PRTFILEAIOREQINTERNAL pReqInt = (PRTFILEAIOREQINTERNAL)aPortEvents[i].pIoCB;
+                AssertPtr(pReqInt);
+                Assert(pReqInt->u32Magic == RTFILEAIOREQ_MAGIC);
+
+                /** @todo aeichner: The rc field contains the result code
+                 *  like you can find in errno for the normal read/write ops.
+                 *  But there is a second field called rc2. I don't know the
+                 *  purpose for it yet.
+                 */
+                rtFileAioReqLinuxComplete(pReqInt, aPortEvents[i].rc);
+
+                pahReqs[cRequestsCompleted++] = (RTFILEAIOREQ)pReqInt;
             }
 
-            /* Mark the request as finished. */
-            RTFILEAIOREQ_SET_STATE(pReqInt, COMPLETED);
-
-            pahReqs[cRequestsCompleted++] = (RTFILEAIOREQ)pReqInt;
-        }
-
-        /*
-         * Done Yet? If not advance and try again.
-         */
-        if (cDone >= cMinReqs)
-            break;
-        cMinReqs -= cDone;
-        cReqs    -= cDone;
+            /*
+             * Done Yet? If not advance and try again.
+             */
+            if (cDone >= cMinReqs)
+                break;
+            cMinReqs -= cDone;
+            cReqs    -= cDone;
 
-        if (cMillies != RT_INDEFINITE_WAIT)
-        {
-            /* The API doesn't return ETIMEDOUT, so we have to fix that ourselves. */
-            uint64_t NanoTS = RTTimeNanoTS();
-            uint64_t cMilliesElapsed = (NanoTS - StartNanoTS) / 1000000;
-            if (cMilliesElapsed >= cMillies)
+            if (cMillies != RT_INDEFINITE_WAIT)
             {
-                rc = VERR_TIMEOUT;
-                break;
+                /* The API doesn't return ETIMEDOUT, so we have to fix that ourselves. */
+                uint64_t NanoTS = RTTimeNanoTS();
+                uint64_t cMilliesElapsed = (NanoTS - StartNanoTS) / 1000000;
+                if (cMilliesElapsed >= cMillies)
+                {
+                    rc = VERR_TIMEOUT;
+                    break;
+                }
+
+                /* The syscall supposedly updates it, but we're paranoid. :-) */
+                Timeout.tv_sec  = (cMillies - (RTMSINTERVAL)cMilliesElapsed) / 1000;
+                Timeout.tv_nsec = (cMillies - (RTMSINTERVAL)cMilliesElapsed) % 1000 * 1000000;
             }
-
-            /* The syscall supposedly updates it, but we're paranoid. :-) */
-            Timeout.tv_sec  = (cMillies - (RTMSINTERVAL)cMilliesElapsed) / 1000;
-            Timeout.tv_nsec = (cMillies - (RTMSINTERVAL)cMilliesElapsed) % 1000 * 1000000;
         }
     }
 
@@ -795,6 +1319,18 @@ RTDECL(int) RTFileAioCtxWakeup(RTFILEAIOCTX hAioCtx)
      *        this function. */
 
     bool fWokenUp    = ASMAtomicXchgBool(&pCtxInt->fWokenUp, true);
+    if (pCtxInt->fIoUring)
+    {
+        /* The waiter polls the eventfd, so there is no window for losing the
+           wakeup like with the signal below. */
+        if (!fWokenUp)
+        {
+            uint64_t const u64One = 1;
+            ssize_t cbWritten = write(pCtxInt->IoUring.iFdEvt, &u64One, sizeof(u64One));
+            NOREF(cbWritten);
+        }
+        return VINF_SUCCESS;
+    }
 
     /*
      * Read the thread handle before the status flag.
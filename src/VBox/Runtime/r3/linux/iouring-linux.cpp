@@ -0,0 +1,87 @@
+/* $Id: iouring-linux.cpp $ */
+/** @file
+ * IPRT - io_uring availability check, Linux.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#define LOG_GROUP RTLOGGROUP_FILE
+#include "internal/iprt.h"
+#include "internal/iouring-linux.h"
+
+#include <iprt/env.h>
+#include <iprt/log.h>
+#include <iprt/once.h>
+#include <iprt/string.h>
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** Makes sure we only probe the kernel once. */
+static RTONCE   g_IoUringOnce = RTONCE_INITIALIZER;
+/** Set if io_uring is usable. */
+static bool     g_fIoUringAvailable = false;
+
+
+/**
+ * @callback_method_impl{FNRTONCE, Probes for a usable io_uring.}
+ */
+static DECLCALLBACK(int32_t) rtLinuxIoUringProbeOnce(void *pvUser)
+{
+    NOREF(pvUser);
+
+    if (RTEnvExist("IPRT_FILEAIO_NO_IO_URING"))
+    {
+        LogRel(("IPRT: io_uring disabled by IPRT_FILEAIO_NO_IO_URING\n"));
+        return VINF_SUCCESS;
+    }
+
+    /*
+     * Create a tiny ring and check the features.  We insist on the single
+     * mmap feature (5.4+) because the earlier implementations lack the
+     * async worker pool which makes buffered I/O non-blocking.  Seccomp
+     * filters and kernel.io_uring_disabled make the setup fail as well.
+     */
+    LNXIOURINGPARAMS Params;
+    RT_ZERO(Params);
+    int iFd = -1;
+    int rc = rtLinuxIoUringSetup(2, &Params, &iFd);
+    if (RT_SUCCESS(rc))
+    {
+        g_fIoUringAvailable = RT_BOOL(Params.fFeatures & LNXIOURING_FEAT_SINGLE_MMAP);
+        close(iFd);
+    }
+    Log(("rtLinuxIoUringProbeOnce: rc=%Rrc fFeatures=%#x -> %RTbool\n", rc, Params.fFeatures, g_fIoUringAvailable));
+    return VINF_SUCCESS;
+}
+
+
+DECLHIDDEN(bool) rtLinuxIoUringIsAvailable(void)
+{
+    RTOnce(&g_IoUringOnce, rtLinuxIoUringProbeOnce, NULL);
+    return g_fIoUringAvailable;
+}
@@ -0,0 +1,140 @@
+/* $Id: RTFileMap-posix.cpp $ */
+/** @file
+ * IPRT - RTFileMap, RTFileUnmap and RTFileMapAdvise, POSIX.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#define LOG_GROUP RTLOGGROUP_FILE
+
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include <iprt/file.h>
+#include "internal/iprt.h"
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include <iprt/param.h>
+#include "internal/file.h"
+
+
+RTDECL(int) RTFileMap(RTFILE hFile, RTFOFF off, size_t cb, uint32_t fFlags, void **ppv)
+{
+    /*
+     * Validate input.
+     */
+    AssertPtrReturn(ppv, VERR_INVALID_POINTER);
+    *ppv = NULL;
+    AssertReturn(RTFileIsValid(hFile), VERR_INVALID_HANDLE);
+    AssertReturn(off >= 0, VERR_INVALID_PARAMETER);
+    AssertReturn(cb > 0, VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFlags & ~RTFILEMAP_F_VALID_MASK), VERR_INVALID_PARAMETER);
+    AssertReturn(   fFlags == RTFILEMAP_F_READ
+                 || fFlags == RTFILEMAP_F_COPY_ON_WRITE, VERR_INVALID_PARAMETER);
+
+    /*
+     * Reject ranges extending beyond the end of the file, touching those
+     * pages would get us a SIGBUS.
+     */
+    uint64_t cbFile;
+    int rc = RTFileGetSize(hFile, &cbFile);
+    if (RT_FAILURE(rc))
+        return rc;
+    if (   (uint64_t)off > cbFile
+        || cb > cbFile - (uint64_t)off)
+        return VERR_OUT_OF_RANGE;
+
+    /*
+     * Map it, starting at the page containing the offset.
+     */
+    size_t const offPage = (size_t)off & PAGE_OFFSET_MASK;
+    RTFOFF const offMap  = off - offPage;
+    if (   sizeof(off_t) < sizeof(offMap)
+        && (RTFOFF)(off_t)offMap != offMap)
+        return VERR_OUT_OF_RANGE;
+    size_t const cbMap   = cb + offPage;
+    AssertReturn(cbMap >= cb, VERR_OUT_OF_RANGE);
+
+    void *pv = mmap(NULL, cbMap,
+                    fFlags == RTFILEMAP_F_READ ? PROT_READ : PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE, (int)RTFileToNative(hFile), (off_t)offMap);
+    if (pv == MAP_FAILED)
+    {
+        if (errno == ENODEV)
+            return VERR_NOT_SUPPORTED;
+        return RTErrConvertFromErrno(errno);
+    }
+
+    *ppv = (uint8_t *)pv + offPage;
+    return VINF_SUCCESS;
+}
+
+
+RTDECL(int) RTFileUnmap(void *pv, size_t cb)
+{
+    if (!pv)
+        return VINF_SUCCESS;
+    AssertReturn(cb > 0, VERR_INVALID_PARAMETER);
+
+    size_t const offPage = (uintptr_t)pv & PAGE_OFFSET_MASK;
+    if (munmap((uint8_t *)pv - offPage, cb + offPage) == 0)
+        return VINF_SUCCESS;
+    int rc = RTErrConvertFromErrno(errno);
+    AssertMsgFailed(("pv=%p cb=%#zx rc=%Rrc\n", pv, cb, rc));
+    return rc;
+}
+
+
+RTDECL(int) RTFileMapAdvise(void *pv, size_t cb, RTFILEMAPADVICE enmAdvice)
+{
+    AssertPtrReturn(pv, VERR_INVALID_POINTER);
+    AssertReturn(cb > 0, VERR_INVALID_PARAMETER);
+
+#ifdef MADV_NORMAL
+    int iAdvice;
+    switch (enmAdvice)
+    {
+        case RTFILEMAPADVICE_NORMAL:        iAdvice = MADV_NORMAL; break;
+        case RTFILEMAPADVICE_SEQUENTIAL:    iAdvice = MADV_SEQUENTIAL; break;
+        case RTFILEMAPADVICE_RANDOM:        iAdvice = MADV_RANDOM; break;
+        case RTFILEMAPADVICE_WILL_NEED:     iAdvice = MADV_WILLNEED; break;
+        case RTFILEMAPADVICE_DONT_NEED:     iAdvice = MADV_DONTNEED; break;
+        default:
+            AssertFailedReturn(VERR_INVALID_PARAMETER);
+    }
+
+    /* madvise wants a page aligned address. */
+    size_t const offPage = (uintptr_t)pv & PAGE_OFFSET_MASK;
+    if (madvise((uint8_t *)pv - offPage, cb + offPage, iAdvice) == 0)
+        return VINF_SUCCESS;
+    return RTErrConvertFromErrno(errno);
+#else
+    AssertReturn(enmAdvice > RTFILEMAPADVICE_INVALID && enmAdvice < RTFILEMAPADVICE_END, VERR_INVALID_PARAMETER);
+    return VINF_SUCCESS;
+#endif
+}
@@ -315,6 +315,7 @@ RTR3DECL(int) RTFileAioGetLimits(PRTFILEAIOLIMITS pAioLimits)
 
     pAioLimits->cReqsOutstandingMax = cReqsOutstandingMax;
     pAioLimits->cbBufferAlignment   = 0;
+    pAioLimits->fFlags              = 0;
 #elif defined(RT_OS_FREEBSD)
     /*
      * The AIO API is implemented in a kernel module which is not
@@ -340,9 +341,11 @@ RTR3DECL(int) RTFileAioGetLimits(PRTFILEAIOLIMITS pAioLimits)
 
     pAioLimits->cReqsOutstandingMax = cReqsOutstandingMax;
     pAioLimits->cbBufferAlignment   = 0;
+    pAioLimits->fFlags              = 0;
 #else
     pAioLimits->cReqsOutstandingMax = RTFILEAIO_UNLIMITED_REQS;
     pAioLimits->cbBufferAlignment   = 0;
+    pAioLimits->fFlags              = 0;
 #endif
 
     return VINF_SUCCESS;
@@ -437,6 +440,30 @@ RTDECL(int) RTFileAioReqPrepareWrite(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off
 }
 
 
+RTDECL(int) RTFileAioReqPrepareReadSg(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
+                                      PCRTSGSEG paSegs, unsigned cSegs, void *pvUser)
+{
+    /* No vectored variant in the host API, single segments only. */
+    AssertPtrReturn(paSegs, VERR_INVALID_POINTER);
+    AssertReturn(cSegs > 0, VERR_INVALID_PARAMETER);
+    if (cSegs != 1)
+        return VERR_NOT_SUPPORTED;
+    return RTFileAioReqPrepareRead(hReq, hFile, off, paSegs[0].pvSeg, paSegs[0].cbSeg, pvUser);
+}
+
+
+RTDECL(int) RTFileAioReqPrepareWriteSg(RTFILEAIOREQ hReq, RTFILE hFile, RTFOFF off,
+                                       PCRTSGSEG paSegs, unsigned cSegs, void *pvUser)
+{
+    /* No vectored variant in the host API, single segments only. */
+    AssertPtrReturn(paSegs, VERR_INVALID_POINTER);
+    AssertReturn(cSegs > 0, VERR_INVALID_PARAMETER);
+    if (cSegs != 1)
+        return VERR_NOT_SUPPORTED;
+    return RTFileAioReqPrepareWrite(hReq, hFile, off, paSegs[0].pvSeg, paSegs[0].cbSeg, pvUser);
+}
+
+
 RTDECL(int) RTFileAioReqPrepareFlush(RTFILEAIOREQ hReq, RTFILE hFile, void *pvUser)
 {
     PRTFILEAIOREQINTERNAL pReqInt = (PRTFILEAIOREQINTERNAL)hReq;
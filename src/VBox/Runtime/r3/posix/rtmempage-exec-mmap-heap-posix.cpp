@@ -47,6 +47,18 @@
 #if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
 # define MAP_ANONYMOUS MAP_ANON
 #endif
+#ifdef RT_OS_LINUX
+/* Older headers lack these. */
+# ifndef MADV_HUGEPAGE
+#  define MADV_HUGEPAGE     14
+# endif
+# ifndef MAP_HUGETLB
+#  define MAP_HUGETLB       0x40000
+# endif
+# ifndef MAP_HUGE_SHIFT
+#  define MAP_HUGE_SHIFT    26
+# endif
+#endif
 
 
 /*******************************************************************************
@@ -622,35 +634,115 @@ static DECLCALLBACK(int) rtMemPagePosixInitOnce(void *pvUser)
 }
 
 
+#ifdef RT_OS_LINUX
+/**
+ * Maps a large page backed block.
+ *
+ * @returns Address of the mapping, NULL on failure.
+ * @param   cb                  The number of bytes to map, page aligned.
+ * @param   fProt               The protection.
+ * @param   fFlags              RTMEMPAGEALLOC_F_XXX.
+ */
+static void *rtMemPagePosixMapLarge(size_t cb, int fProt, uint32_t fFlags)
+{
+    void *pv;
+    if (fFlags & RTMEMPAGEALLOC_F_LARGE_PAGES)
+    {
+        /*
+         * Explicit hugetlbfs pages.  These come out of the pool reserved by
+         * the administrator and the size must be a multiple of the page size.
+         * The munmap in rtMemPagePosixFree has the same requirement.
+         */
+        if (cb & (RTMEMPAGEALLOC_LARGE_PAGE_SIZE - 1))
+            return NULL;
+        int fMap = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+# if defined(RT_ARCH_AMD64) || defined(RT_ARCH_X86)
+        fMap |= 21 << MAP_HUGE_SHIFT; /* 2MB, not whatever the default hugetlbfs size is. */
+# endif
+        pv = mmap(NULL, cb, fProt, fMap, -1, 0);
+        return pv != MAP_FAILED ? pv : NULL;
+    }
+
+    /*
+     * Transparent huge pages.  The kernel can only use them for the parts of
+     * the mapping that are aligned on a large page boundrary, so map a bit
+     * extra and trim the head and tail to get an aligned block of exactly
+     * the requested size.  The advice is a hint, failure is ignored.
+     */
+    size_t const cbMap = cb + RTMEMPAGEALLOC_LARGE_PAGE_SIZE - PAGE_SIZE;
+    pv = mmap(NULL, cbMap, fProt, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pv == MAP_FAILED)
+        return NULL;
+
+    uint8_t *pbMap  = (uint8_t *)pv;
+    uint8_t *pbRet  = (uint8_t *)RT_ALIGN_P(pbMap, RTMEMPAGEALLOC_LARGE_PAGE_SIZE);
+    size_t   cbHead = pbRet - pbMap;
+    size_t   cbTail = cbMap - cbHead - cb;
+    if (cbHead)
+        munmap(pbMap, cbHead);
+    if (cbTail)
+        munmap(pbRet + cb, cbTail);
+
+    madvise(pbRet, cb, MADV_HUGEPAGE);
+    return pbRet;
+}
+#endif /* RT_OS_LINUX */
+
+
 /**
  * Allocates memory from the specified heap.
  *
  * @returns Address of the allocated memory.
  * @param   cb                  The number of bytes to allocate.
  * @param   pszTag              The tag.
- * @param   fZero               Whether to zero the memory or not.
+ * @param   fFlags              RTMEMPAGEALLOC_F_XXX.
  * @param   pHeap               The heap to use.
  */
-static void *rtMemPagePosixAlloc(size_t cb, const char *pszTag, bool fZero, PRTHEAPPAGE pHeap)
+static void *rtMemPagePosixAlloc(size_t cb, const char *pszTag, uint32_t fFlags, PRTHEAPPAGE pHeap)
 {
     /*
      * Validate & adjust the input.
      */
     Assert(cb > 0);
+    Assert(!(fFlags & ~RTMEMPAGEALLOC_F_VALID_MASK));
     NOREF(pszTag);
     cb = RT_ALIGN_Z(cb, PAGE_SIZE);
+    bool const fZero = RT_BOOL(fFlags & RTMEMPAGEALLOC_F_ZERO);
 
     /*
-     * If the allocation is relatively large, we use mmap/munmap directly.
+     * Large page backed memory is always mapped directly.  Advice for blocks
+     * smaller than a large page is pointless and thus ignored, but explicit
+     * requests fail as the caller may depend on the backing.
      */
     void *pv;
+    int const fProt = PROT_READ | PROT_WRITE | (pHeap == &g_MemExecPosixHeap ? PROT_EXEC : 0);
+    if (   (fFlags & RTMEMPAGEALLOC_F_LARGE_PAGES)
+        || (   (fFlags & RTMEMPAGEALLOC_F_ADVISE_LARGE_PAGES)
+            && cb >= RTMEMPAGEALLOC_LARGE_PAGE_SIZE))
+    {
+#ifdef RT_OS_LINUX
+        pv = rtMemPagePosixMapLarge(cb, fProt, fFlags);
+        if (pv)
+        {
+            if (fZero)
+                RT_BZERO(pv, cb);
+            return pv;
+        }
+        if (fFlags & RTMEMPAGEALLOC_F_LARGE_PAGES)
+            return NULL;
+#else
+        if (fFlags & RTMEMPAGEALLOC_F_LARGE_PAGES)
+            return NULL;
+#endif
+    }
+
+    /*
+     * If the allocation is relatively large, we use mmap/munmap directly.
+     */
     if (cb >= RTMEMPAGEPOSIX_MMAP_THRESHOLD)
     {
 
-        pv = mmap(NULL, cb,
-                  PROT_READ | PROT_WRITE | (pHeap == &g_MemExecPosixHeap ? PROT_EXEC : 0),
-                  MAP_PRIVATE | MAP_ANONYMOUS,
-                  -1, 0);
+        pv = mmap(NULL, cb, fProt, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
         if (pv != MAP_FAILED)
         {
             AssertPtr(pv);
@@ -713,13 +805,20 @@ static void rtMemPagePosixFree(void *pv, size_t cb, PRTHEAPPAGE pHeap)
 
 RTDECL(void *) RTMemPageAllocTag(size_t cb, const char *pszTag) RT_NO_THROW
 {
-    return rtMemPagePosixAlloc(cb, pszTag, false /*fZero*/, &g_MemPagePosixHeap);
+    return rtMemPagePosixAlloc(cb, pszTag, 0 /*fFlags*/, &g_MemPagePosixHeap);
 }
 
 
 RTDECL(void *) RTMemPageAllocZTag(size_t cb, const char *pszTag) RT_NO_THROW
 {
-    return rtMemPagePosixAlloc(cb, pszTag, true /*fZero*/, &g_MemPagePosixHeap);
+    return rtMemPagePosixAlloc(cb, pszTag, RTMEMPAGEALLOC_F_ZERO, &g_MemPagePosixHeap);
+}
+
+
+RTDECL(void *) RTMemPageAllocExTag(size_t cb, uint32_t fFlags, const char *pszTag) RT_NO_THROW
+{
+    AssertReturn(!(fFlags & ~RTMEMPAGEALLOC_F_VALID_MASK), NULL);
+    return rtMemPagePosixAlloc(cb, pszTag, fFlags, &g_MemPagePosixHeap);
 }
 
 
@@ -734,7 +833,7 @@ RTDECL(void) RTMemPageFree(void *pv, size_t cb) RT_NO_THROW
 
 RTDECL(void *) RTMemExecAllocTag(size_t cb, const char *pszTag) RT_NO_THROW
 {
-    return rtMemPagePosixAlloc(cb, pszTag, false /*fZero*/, &g_MemExecPosixHeap);
+    return rtMemPagePosixAlloc(cb, pszTag, 0 /*fFlags*/, &g_MemExecPosixHeap);
 }
 
 
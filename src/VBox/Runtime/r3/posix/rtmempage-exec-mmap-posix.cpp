@@ -123,6 +123,15 @@ RTDECL(void *) RTMemPageAllocZTag(size_t cb, const char *pszTag) RT_NO_THROW
 }
 
 
+RTDECL(void *) RTMemPageAllocExTag(size_t cb, uint32_t fFlags, const char *pszTag) RT_NO_THROW
+{
+    AssertReturn(!(fFlags & ~RTMEMPAGEALLOC_F_VALID_MASK), NULL);
+    if (fFlags & RTMEMPAGEALLOC_F_LARGE_PAGES)
+        return NULL; /* The large page variant lives in rtmempage-exec-mmap-heap-posix.cpp. */
+    return rtMemPagePosixAlloc(cb, pszTag, RT_BOOL(fFlags & RTMEMPAGEALLOC_F_ZERO), 0);
+}
+
+
 RTDECL(void) RTMemPageFree(void *pv, size_t cb) RT_NO_THROW
 {
     return rtMemPagePosixFree(pv, cb);
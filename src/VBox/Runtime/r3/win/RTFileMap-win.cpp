@@ -0,0 +1,131 @@
+/* $Id: RTFileMap-win.cpp $ */
+/** @file
+ * IPRT - RTFileMap, RTFileUnmap and RTFileMapAdvise, Windows.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#define LOG_GROUP RTLOGGROUP_FILE
+#include <Windows.h>
+
+#include <iprt/file.h>
+#include "internal/iprt.h"
+
+#include <iprt/assert.h>
+#include <iprt/err.h>
+#include "internal/file.h"
+
+
+/**
+ * Gets the view allocation granularity (64KB on all current hosts).
+ */
+static size_t rtFileMapGetGranularity(void)
+{
+    static size_t volatile s_cbGranularity = 0;
+    size_t cbGranularity = s_cbGranularity;
+    if (!cbGranularity)
+    {
+        SYSTEM_INFO SysInfo;
+        GetSystemInfo(&SysInfo);
+        cbGranularity = SysInfo.dwAllocationGranularity;
+        Assert(RT_IS_POWER_OF_TWO(cbGranularity));
+        s_cbGranularity = cbGranularity;
+    }
+    return cbGranularity;
+}
+
+
+RTDECL(int) RTFileMap(RTFILE hFile, RTFOFF off, size_t cb, uint32_t fFlags, void **ppv)
+{
+    /*
+     * Validate input.
+     */
+    AssertPtrReturn(ppv, VERR_INVALID_POINTER);
+    *ppv = NULL;
+    AssertReturn(RTFileIsValid(hFile), VERR_INVALID_HANDLE);
+    AssertReturn(off >= 0, VERR_INVALID_PARAMETER);
+    AssertReturn(cb > 0, VERR_INVALID_PARAMETER);
+    AssertReturn(!(fFlags & ~RTFILEMAP_F_VALID_MASK), VERR_INVALID_PARAMETER);
+    AssertReturn(   fFlags == RTFILEMAP_F_READ
+                 || fFlags == RTFILEMAP_F_COPY_ON_WRITE, VERR_INVALID_PARAMETER);
+
+    uint64_t cbFile;
+    int rc = RTFileGetSize(hFile, &cbFile);
+    if (RT_FAILURE(rc))
+        return rc;
+    if (   (uint64_t)off > cbFile
+        || cb > cbFile - (uint64_t)off)
+        return VERR_OUT_OF_RANGE;
+
+    /*
+     * Views must start at the allocation granularity.  The section object
+     * can be closed right away, the view keeps it alive.
+     */
+    size_t const offView = (size_t)off & (rtFileMapGetGranularity() - 1);
+    uint64_t const offMap = (uint64_t)off - offView;
+    size_t const cbView  = cb + offView;
+    AssertReturn(cbView >= cb, VERR_OUT_OF_RANGE);
+
+    HANDLE hSection = CreateFileMappingW((HANDLE)RTFileToNative(hFile), NULL,
+                                         fFlags == RTFILEMAP_F_READ ? PAGE_READONLY : PAGE_WRITECOPY,
+                                         0, 0, NULL);
+    if (!hSection)
+        return RTErrConvertFromWin32(GetLastError());
+
+    void *pv = MapViewOfFile(hSection, fFlags == RTFILEMAP_F_READ ? FILE_MAP_READ : FILE_MAP_COPY,
+                             (DWORD)(offMap >> 32), (DWORD)offMap, cbView);
+    if (pv)
+        *ppv = (uint8_t *)pv + offView;
+    else
+        rc = RTErrConvertFromWin32(GetLastError());
+    CloseHandle(hSection);
+    return rc;
+}
+
+
+RTDECL(int) RTFileUnmap(void *pv, size_t cb)
+{
+    if (!pv)
+        return VINF_SUCCESS;
+    AssertReturn(cb > 0, VERR_INVALID_PARAMETER);
+
+    void *pvView = (void *)((uintptr_t)pv & ~(uintptr_t)(rtFileMapGetGranularity() - 1));
+    if (UnmapViewOfFile(pvView))
+        return VINF_SUCCESS;
+    int rc = RTErrConvertFromWin32(GetLastError());
+    AssertMsgFailed(("pv=%p cb=%#zx rc=%Rrc\n", pv, cb, rc));
+    return rc;
+}
+
+
+RTDECL(int) RTFileMapAdvise(void *pv, size_t cb, RTFILEMAPADVICE enmAdvice)
+{
+    /* PrefetchVirtualMemory and friends are too new, the advice is a hint anyway. */
+    AssertPtrReturn(pv, VERR_INVALID_POINTER);
+    AssertReturn(cb > 0, VERR_INVALID_PARAMETER);
+    AssertReturn(enmAdvice > RTFILEMAPADVICE_INVALID && enmAdvice < RTFILEMAPADVICE_END, VERR_INVALID_PARAMETER);
+    return VINF_SUCCESS;
+}
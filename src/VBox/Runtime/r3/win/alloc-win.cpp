@@ -106,6 +106,20 @@ RTDECL(void *) RTMemPageAllocZTag(size_t cb, const char *pszTag) RT_NO_THROW
 }
 
 
+RTDECL(void *) RTMemPageAllocExTag(size_t cb, uint32_t fFlags, const char *pszTag) RT_NO_THROW
+{
+    AssertReturn(!(fFlags & ~RTMEMPAGEALLOC_F_VALID_MASK), NULL);
+
+    /* Large pages need SeLockMemoryPrivilege and a different free path, so
+       explicit requests fail and the advice is ignored for now. */
+    if (fFlags & RTMEMPAGEALLOC_F_LARGE_PAGES)
+        return NULL;
+    if (fFlags & RTMEMPAGEALLOC_F_ZERO)
+        return RTMemPageAllocZTag(cb, pszTag);
+    return RTMemPageAllocTag(cb, pszTag);
+}
+
+
 RTDECL(void) RTMemPageFree(void *pv, size_t cb) RT_NO_THROW
 {
     if (pv)
@@ -28,6 +28,7 @@
 *   Header Files                                                               *
 *******************************************************************************/
 #include <iprt/avl.h>
+#include <iprt/btree.h>
 
 #include <iprt/asm.h>
 #include <iprt/initterm.h>
@@ -36,6 +37,7 @@
 #include <iprt/stdarg.h>
 #include <iprt/string.h>
 #include <iprt/test.h>
+#include <iprt/time.h>
 
 
 /*******************************************************************************
@@ -1022,6 +1024,314 @@ int avlul(void)
 }
 
 
+/**
+ * DoWithAll callback collecting the nodes into an array.
+ */
+static DECLCALLBACK(int) btreeru64Collect(PAVLRU64NODECORE pNode, void *pvUser)
+{
+    PAVLRU64NODECORE **pppNodes = (PAVLRU64NODECORE **)pvUser;
+    *(*pppNodes)++ = pNode;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Destroy callback freeing the node, counting the calls.
+ */
+static DECLCALLBACK(int) btreeru64Free(PAVLRU64NODECORE pNode, void *pvUser)
+{
+    (*(uint32_t *)pvUser)++;
+    RTMemFree(pNode);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Compares the content of a B+ tree with an AVL tree by enumerating both.
+ */
+static bool btreeru64Compare(PRTBTREERU64 pBTree, PAVLRU64TREE pAvlTree, uint32_t cNodes, int fFromLeft)
+{
+    PAVLRU64NODECORE *papAvl   = (PAVLRU64NODECORE *)RTMemAlloc((cNodes + 1) * sizeof(papAvl[0]));
+    PAVLRU64NODECORE *papBTree = (PAVLRU64NODECORE *)RTMemAlloc((cNodes + 1) * sizeof(papBTree[0]));
+    PAVLRU64NODECORE *ppCur    = papAvl;
+    RTAvlrU64DoWithAll(pAvlTree, fFromLeft, btreeru64Collect, &ppCur);
+    uint32_t const    cAvl     = (uint32_t)(ppCur - papAvl);
+    ppCur = papBTree;
+    RTBTreeRU64DoWithAll(pBTree, fFromLeft, btreeru64Collect, &ppCur);
+    uint32_t const    cBTree   = (uint32_t)(ppCur - papBTree);
+
+    bool fRc = true;
+    if (cAvl != cNodes || cBTree != cNodes || pBTree->cNodes != cNodes)
+    {
+        RTTestIFailed("enum count mismatch: avl=%u btree=%u cNodes=%u expected %u\n", cAvl, cBTree, pBTree->cNodes, cNodes);
+        fRc = false;
+    }
+    else if (memcmp(papAvl, papBTree, cNodes * sizeof(papAvl[0])))
+    {
+        RTTestIFailed("enum order mismatch (fFromLeft=%d)\n", fFromLeft);
+        fRc = false;
+    }
+    RTMemFree(papAvl);
+    RTMemFree(papBTree);
+    return fRc;
+}
+
+
+/**
+ * Tests the B+ tree by running the same random operations on it and on an AVL
+ * tree sharing the very same nodes.
+ */
+int btreeru64(void)
+{
+    RTTestISubF("RTBTreeRU64");
+
+    RTBTREERU64      BTree;
+    AVLRU64TREE      AvlTree = NULL;
+    PAVLRU64NODECORE pNode;
+    uint32_t         cNodes  = 0;
+    uint32_t         i;
+    RTBTreeRU64Init(&BTree);
+
+    /*
+     * Linear insert and remove, enough to get a couple of levels.
+     */
+    for (i = 0; i < _64K; i++)
+    {
+        pNode = (PAVLRU64NODECORE)RTMemAlloc(sizeof(*pNode));
+        pNode->Key     = (AVLRU64KEY)i * 4;
+        pNode->KeyLast = pNode->Key + 1;
+        if (!RTBTreeRU64Insert(&BTree, pNode))
+        {
+            RTTestIFailed("linear insert i=%u\n", i);
+            return 1;
+        }
+        /* negative. */
+        AVLRU64NODECORE Node = *pNode;
+        Node.Key = pNode->KeyLast;
+        Node.KeyLast = pNode->KeyLast + 1;
+        if (RTBTreeRU64Insert(&BTree, &Node))
+        {
+            RTTestIFailed("linear negative insert i=%u\n", i);
+            return 1;
+        }
+    }
+    for (i = 0; i < _64K * 4; i++)
+    {
+        pNode = RTBTreeRU64RangeGet(&BTree, i);
+        if ((i & 3) < 2 ? !pNode || pNode->Key != (i & ~(uint32_t)3) : pNode != NULL)
+        {
+            RTTestIFailed("linear range get i=%#x -> %p\n", i, pNode);
+            return 1;
+        }
+    }
+    for (i = 0; i < _64K; i++)
+    {
+        pNode = RTBTreeRU64RemoveBestFit(&BTree, i * 4 - (i & 1), !!(i & 1));
+        if (!pNode || pNode->Key != (AVLRU64KEY)i * 4)
+        {
+            RTTestIFailed("linear remove best fit i=%u -> %p\n", i, pNode);
+            return 1;
+        }
+        RTMemFree(pNode);
+    }
+    if (BTree.pvRoot || BTree.cNodes || BTree.cHeight)
+    {
+        RTTestIFailed("linear remove didn't remove it all!\n");
+        return 1;
+    }
+
+    /*
+     * Random operations, the nodes are in both trees at the same time since
+     * the B+ tree doesn't touch the AVL members.
+     */
+    uint32_t const cOps   = _512K;
+    uint32_t const MaxKey = _128K;
+    for (i = 0; i < cOps; i++)
+    {
+        AVLRU64KEY const Key = RTRandAdvU32Ex(g_hRand, 0, MaxKey - 1);
+        uint32_t const   uOp = RTRandAdvU32Ex(g_hRand, 0, 99);
+        if (uOp < 45)
+        {
+            pNode = (PAVLRU64NODECORE)RTMemAlloc(sizeof(*pNode));
+            pNode->Key     = Key;
+            pNode->KeyLast = Key + RTRandAdvU32Ex(g_hRand, 0, 15);
+            bool fAvl   = RTAvlrU64Insert(&AvlTree, pNode);
+            bool fBTree = RTBTreeRU64Insert(&BTree, pNode);
+            if (fAvl != fBTree)
+            {
+                RTTestIFailed("insert [%#RX64..%#RX64]: avl=%RTbool btree=%RTbool\n", pNode->Key, pNode->KeyLast, fAvl, fBTree);
+                return 1;
+            }
+            if (fAvl)
+                cNodes++;
+            else
+                RTMemFree(pNode);
+        }
+        else if (uOp < 85)
+        {
+            PAVLRU64NODECORE pAvl;
+            PAVLRU64NODECORE pBTree;
+            switch (uOp % 4)
+            {
+                case 0:
+                    pAvl   = RTAvlrU64RangeRemove(&AvlTree, Key);
+                    pBTree = RTBTreeRU64RangeRemove(&BTree, Key);
+                    break;
+                case 1:
+                    pAvl   = RTAvlrU64Remove(&AvlTree, Key);
+                    pBTree = RTBTreeRU64Remove(&BTree, Key);
+                    break;
+                default:
+                {
+                    bool const fAbove = uOp % 4 == 2;
+                    pAvl   = RTAvlrU64GetBestFit(&AvlTree, Key, fAbove);
+                    pBTree = RTBTreeRU64RemoveBestFit(&BTree, Key, fAbove);
+                    if (pAvl)
+                        RTAvlrU64Remove(&AvlTree, pAvl->Key);
+                    break;
+                }
+            }
+            if (pAvl != pBTree)
+            {
+                RTTestIFailed("remove op %u key %#RX64: avl=%p btree=%p\n", uOp % 4, Key, pAvl, pBTree);
+                return 1;
+            }
+            if (pAvl)
+            {
+                cNodes--;
+                RTMemFree(pAvl);
+            }
+        }
+        else
+        {
+            PAVLRU64NODECORE pAvl;
+            PAVLRU64NODECORE pBTree;
+            switch (uOp % 4)
+            {
+                case 0:
+                    pAvl   = RTAvlrU64RangeGet(&AvlTree, Key);
+                    pBTree = RTBTreeRU64RangeGet(&BTree, Key);
+                    break;
+                case 1:
+                    pAvl   = RTAvlrU64Get(&AvlTree, Key);
+                    pBTree = RTBTreeRU64Get(&BTree, Key);
+                    break;
+                default:
+                    pAvl   = RTAvlrU64GetBestFit(&AvlTree, Key, uOp % 4 == 2);
+                    pBTree = RTBTreeRU64GetBestFit(&BTree, Key, uOp % 4 == 2);
+                    break;
+            }
+            if (pAvl != pBTree)
+            {
+                RTTestIFailed("lookup op %u key %#RX64: avl=%p btree=%p\n", uOp % 4, Key, pAvl, pBTree);
+                return 1;
+            }
+        }
+
+        if (!(i % _64K) && !btreeru64Compare(&BTree, &AvlTree, cNodes, i & 1))
+            return 1;
+    }
+    if (!btreeru64Compare(&BTree, &AvlTree, cNodes, true))
+        return 1;
+
+    /*
+     * Destroy, the B+ tree frees the nodes.
+     */
+    AvlTree = NULL;
+    uint32_t cFreed = 0;
+    int rc = RTBTreeRU64Destroy(&BTree, btreeru64Free, &cFreed);
+    if (RT_FAILURE(rc) || cFreed != cNodes || BTree.pvRoot || BTree.cNodes)
+    {
+        RTTestIFailed("destroy: rc=%Rrc cFreed=%u cNodes=%u\n", rc, cFreed, cNodes);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * Compares the insert and lookup rates of the AVL and B+ range trees.
+ *
+ * @param   cNodes      The number of nodes to use.
+ */
+static void btreeru64Benchmark(uint32_t cNodes)
+{
+    RTTestISubF("RTBTreeRU64 vs RTAvlrU64, %u nodes", cNodes);
+
+    /* Nodes with disjoint ranges in random order and random lookup keys. */
+    PAVLRU64NODECORE  paNodes = (PAVLRU64NODECORE)RTMemAlloc(cNodes * sizeof(paNodes[0]));
+    PAVLRU64NODECORE *papNodes = (PAVLRU64NODECORE *)RTMemAlloc(cNodes * sizeof(papNodes[0]));
+    AVLRU64KEY       *paKeys  = (AVLRU64KEY *)RTMemAlloc(cNodes * sizeof(paKeys[0]));
+    if (!paNodes || !papNodes || !paKeys)
+    {
+        RTTestIFailed("out of memory\n");
+        RTMemFree(paNodes);
+        RTMemFree(papNodes);
+        RTMemFree(paKeys);
+        return;
+    }
+    uint32_t i;
+    for (i = 0; i < cNodes; i++)
+    {
+        paNodes[i].Key     = (AVLRU64KEY)i * 16;
+        paNodes[i].KeyLast = paNodes[i].Key + 7;
+        papNodes[i]        = &paNodes[i];
+        paKeys[i]          = RTRandAdvU32Ex(g_hRand, 0, cNodes * 16 - 1);
+    }
+    for (i = cNodes - 1; i > 0; i--)
+    {
+        uint32_t j = RTRandAdvU32Ex(g_hRand, 0, i);
+        PAVLRU64NODECORE pTmp = papNodes[i];
+        papNodes[i] = papNodes[j];
+        papNodes[j] = pTmp;
+    }
+
+    /* AVL. */
+    AVLRU64TREE AvlTree = NULL;
+    uint64_t    nsStart = RTTimeNanoTS();
+    for (i = 0; i < cNodes; i++)
+        RTAvlrU64Insert(&AvlTree, papNodes[i]);
+    uint64_t    cNsInsertAvl = RTTimeNanoTS() - nsStart;
+
+    uint32_t    cHits = 0;
+    nsStart = RTTimeNanoTS();
+    for (i = 0; i < cNodes; i++)
+        cHits += RTAvlrU64RangeGet(&AvlTree, paKeys[i]) != NULL;
+    uint64_t    cNsLookupAvl = RTTimeNanoTS() - nsStart;
+
+    /* B+ tree. */
+    RTBTREERU64 BTree;
+    RTBTreeRU64Init(&BTree);
+    nsStart = RTTimeNanoTS();
+    for (i = 0; i < cNodes; i++)
+        RTBTreeRU64Insert(&BTree, papNodes[i]);
+    uint64_t    cNsInsertBTree = RTTimeNanoTS() - nsStart;
+
+    uint32_t    cHits2 = 0;
+    nsStart = RTTimeNanoTS();
+    for (i = 0; i < cNodes; i++)
+        cHits2 += RTBTreeRU64RangeGet(&BTree, paKeys[i]) != NULL;
+    uint64_t    cNsLookupBTree = RTTimeNanoTS() - nsStart;
+
+    if (cHits != cHits2 || BTree.cNodes != cNodes)
+        RTTestIFailed("lookup mismatch: avl=%u btree=%u (cNodes=%u)\n", cHits, cHits2, BTree.cNodes);
+
+    RTTestValueF(g_hTest, (uint64_t)cNodes * RT_NS_1SEC / RT_MAX(cNsInsertAvl, 1),   RTTESTUNIT_CALLS_PER_SEC,
+                 "RTAvlrU64Insert, %u nodes", cNodes);
+    RTTestValueF(g_hTest, (uint64_t)cNodes * RT_NS_1SEC / RT_MAX(cNsInsertBTree, 1), RTTESTUNIT_CALLS_PER_SEC,
+                 "RTBTreeRU64Insert, %u nodes", cNodes);
+    RTTestValueF(g_hTest, (uint64_t)cNodes * RT_NS_1SEC / RT_MAX(cNsLookupAvl, 1),   RTTESTUNIT_CALLS_PER_SEC,
+                 "RTAvlrU64RangeGet, %u nodes", cNodes);
+    RTTestValueF(g_hTest, (uint64_t)cNodes * RT_NS_1SEC / RT_MAX(cNsLookupBTree, 1), RTTESTUNIT_CALLS_PER_SEC,
+                 "RTBTreeRU64RangeGet, %u nodes", cNodes);
+
+    RTBTreeRU64Destroy(&BTree, NULL, NULL);
+    RTMemFree(paNodes);
+    RTMemFree(papNodes);
+    RTMemFree(paKeys);
+}
+
+
 int main()
 {
     /*
@@ -1065,6 +1375,13 @@ int main()
     avlrogcphys();
     avlul();
 
+    if (!btreeru64())
+    {
+        btreeru64Benchmark(10000);
+        btreeru64Benchmark(100000);
+        btreeru64Benchmark(1000000);
+    }
+
     /*
      * Done.
      */
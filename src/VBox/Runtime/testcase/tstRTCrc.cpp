@@ -0,0 +1,273 @@
+/* $Id: tstRTCrc.cpp $ */
+/** @file
+ * IPRT Testcase - CRC32, CRC64 and Adler-32.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/crc.h>
+
+#include <iprt/mem.h>
+#include <iprt/rand.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+#include <iprt/time.h>
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** The test handle. */
+static RTTEST       g_hTest;
+/** Byte-at-a-time reference table for CRC32. */
+static uint32_t     g_au32RefCrc32[256];
+/** Byte-at-a-time reference table for CRC64. */
+static uint64_t     g_au64RefCrc64[256];
+
+
+/**
+ * Builds the reference tables, bit by bit.
+ */
+static void tstInitRefTables(void)
+{
+    for (unsigned i = 0; i < 256; i++)
+    {
+        uint32_t u32 = i;
+        uint64_t u64 = i;
+        for (unsigned iBit = 0; iBit < 8; iBit++)
+        {
+            u32 = u32 & 1 ? (u32 >> 1) ^ UINT32_C(0xedb88320)         : u32 >> 1;
+            u64 = u64 & 1 ? (u64 >> 1) ^ UINT64_C(0xd800000000000000) : u64 >> 1;
+        }
+        g_au32RefCrc32[i] = u32;
+        g_au64RefCrc64[i] = u64;
+    }
+}
+
+
+/** The byte-at-a-time CRC32 as it used to be implemented. */
+static uint32_t tstRefCrc32(const void *pv, size_t cb)
+{
+    const uint8_t  *pu8 = (const uint8_t *)pv;
+    uint32_t        uCRC32 = ~0U;
+    while (cb--)
+        uCRC32 = g_au32RefCrc32[(uCRC32 ^ *pu8++) & 0xff] ^ (uCRC32 >> 8);
+    return uCRC32 ^ ~0U;
+}
+
+
+/** The byte-at-a-time CRC64 as it used to be implemented. */
+static uint64_t tstRefCrc64(const void *pv, size_t cb)
+{
+    const uint8_t  *pu8 = (const uint8_t *)pv;
+    uint64_t        uCRC64 = 0;
+    while (cb--)
+        uCRC64 = g_au64RefCrc64[(uCRC64 ^ *pu8++) & 0xff] ^ (uCRC64 >> 8);
+    return uCRC64;
+}
+
+
+/** The byte-at-a-time Adler-32 with a modulo per byte. */
+static uint32_t tstRefAdler32(const void *pv, size_t cb)
+{
+    const uint8_t  *pu8 = (const uint8_t *)pv;
+    uint32_t        a = 1;
+    uint32_t        b = 0;
+    while (cb--)
+    {
+        a = (a + *pu8++) % 65521;
+        b = (b + a)      % 65521;
+    }
+    return a | (b << 16);
+}
+
+
+/**
+ * Checks the well known check values.
+ */
+static void tstCheckValues(void)
+{
+    RTTestSub(g_hTest, "Check values");
+    static const char s_szCheck[] = "123456789";
+    RTTESTI_CHECK_MSG(RTCrc32(s_szCheck, 9) == UINT32_C(0xcbf43926), ("%#x\n", RTCrc32(s_szCheck, 9)));
+    RTTESTI_CHECK_MSG(RTCrcAdler32(s_szCheck, 9) == UINT32_C(0x091e01de), ("%#x\n", RTCrcAdler32(s_szCheck, 9)));
+    RTTESTI_CHECK(RTCrc64(s_szCheck, 9) == tstRefCrc64(s_szCheck, 9));
+    RTTESTI_CHECK(RTCrc32(s_szCheck, 0) == 0);
+    RTTESTI_CHECK(RTCrc64(s_szCheck, 0) == 0);
+    RTTESTI_CHECK(RTCrcAdler32(s_szCheck, 0) == 1);
+}
+
+
+/**
+ * Compares the optimized code paths against the reference implementations
+ * for all sizes up to a few hundred bytes, all alignments and random
+ * chunking.
+ */
+static void tstCompare(uint8_t const *pbBuf, size_t cbBuf)
+{
+    RTTestSub(g_hTest, "Compare with reference");
+
+    for (size_t off = 0; off < 16; off++)
+        for (size_t cb = 0; cb <= 600 && off + cb <= cbBuf; cb++)
+        {
+            uint8_t const *pb = &pbBuf[off];
+            uint32_t u32Ref = tstRefCrc32(pb, cb);
+            uint32_t u32    = RTCrc32(pb, cb);
+            if (u32 != u32Ref)
+                RTTestFailed(g_hTest, "RTCrc32: off=%zu cb=%zu: %#x, expected %#x", off, cb, u32, u32Ref);
+
+            uint64_t u64Ref = tstRefCrc64(pb, cb);
+            uint64_t u64    = RTCrc64(pb, cb);
+            if (u64 != u64Ref)
+                RTTestFailed(g_hTest, "RTCrc64: off=%zu cb=%zu: %#llx, expected %#llx", off, cb, u64, u64Ref);
+
+            u32Ref = tstRefAdler32(pb, cb);
+            u32    = RTCrcAdler32(pb, cb);
+            if (u32 != u32Ref)
+                RTTestFailed(g_hTest, "RTCrcAdler32: off=%zu cb=%zu: %#x, expected %#x", off, cb, u32, u32Ref);
+            if (RTTestErrorCount(g_hTest) > 8)
+                return;
+        }
+
+    /* The whole buffer in random chunks. */
+    uint32_t const u32Crc32Ref = tstRefCrc32(pbBuf, cbBuf);
+    uint64_t const u64Crc64Ref = tstRefCrc64(pbBuf, cbBuf);
+    uint32_t const u32AdlerRef = tstRefAdler32(pbBuf, cbBuf);
+    RTTESTI_CHECK(RTCrc32(pbBuf, cbBuf) == u32Crc32Ref);
+    RTTESTI_CHECK(RTCrc64(pbBuf, cbBuf) == u64Crc64Ref);
+    RTTESTI_CHECK(RTCrcAdler32(pbBuf, cbBuf) == u32AdlerRef);
+    for (unsigned iRun = 0; iRun < 32; iRun++)
+    {
+        uint32_t u32Crc32 = RTCrc32Start();
+        uint64_t u64Crc64 = RTCrc64Start();
+        uint32_t u32Adler = RTCrcAdler32Start();
+        size_t   off      = 0;
+        while (off < cbBuf)
+        {
+            size_t cb = RTRandU32Ex(0, iRun & 1 ? 24 : 20000);
+            cb = RT_MIN(cb, cbBuf - off);
+            u32Crc32 = RTCrc32Process(u32Crc32, &pbBuf[off], cb);
+            u64Crc64 = RTCrc64Process(u64Crc64, &pbBuf[off], cb);
+            u32Adler = RTCrcAdler32Process(u32Adler, &pbBuf[off], cb);
+            off += cb;
+        }
+        RTTESTI_CHECK(RTCrc32Finish(u32Crc32) == u32Crc32Ref);
+        RTTESTI_CHECK(RTCrc64Finish(u64Crc64) == u64Crc64Ref);
+        RTTESTI_CHECK(RTCrcAdler32Finish(u32Adler) == u32AdlerRef);
+    }
+
+    /* All 0xff bytes stresses the deferred Adler-32 modulo. */
+    uint8_t *pbFF = (uint8_t *)RTMemAlloc(_64K);
+    RTTESTI_CHECK_RETV(pbFF);
+    memset(pbFF, 0xff, _64K);
+    RTTESTI_CHECK(RTCrcAdler32(pbFF, _64K) == tstRefAdler32(pbFF, _64K));
+    RTTESTI_CHECK(RTCrc32(pbFF, _64K) == tstRefCrc32(pbFF, _64K));
+    RTMemFree(pbFF);
+}
+
+
+/**
+ * Measures the throughput of a checksum expression for about 1/4 second,
+ * setting cMBPerSec and accumulating the results in uDummy.
+ */
+#define TST_MEASURE(a_Expr, a_cb) \
+    do { \
+        uint64_t const cNsTarget = RT_NS_1SEC / 4; \
+        uint64_t       cBytes    = 0; \
+        uint64_t const nsStart   = RTTimeNanoTS(); \
+        uint64_t       cNsElapsed; \
+        do \
+        { \
+            for (unsigned iInner = 0; iInner < 64; iInner++) \
+                uDummy += (a_Expr); \
+            cBytes += (uint64_t)(a_cb) * 64; \
+            cNsElapsed = RTTimeNanoTS() - nsStart; \
+        } while (cNsElapsed < cNsTarget); \
+        cMBPerSec = cBytes * RT_NS_1SEC / cNsElapsed / _1M; \
+    } while (0)
+
+
+/**
+ * Benchmarks the optimized code against the byte-at-a-time reference code.
+ */
+static void tstBenchmark(uint8_t const *pbBuf)
+{
+    static size_t const s_acbSizes[] = { 16, 64, 512, _4K, _64K };
+    uint64_t            uDummy = 0;
+    uint64_t            cMBPerSec;
+
+    RTTestSub(g_hTest, "Benchmark");
+    for (unsigned i = 0; i < RT_ELEMENTS(s_acbSizes); i++)
+    {
+        size_t const cb = s_acbSizes[i];
+
+        TST_MEASURE(tstRefCrc32(pbBuf, cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "CRC32 reference, %6zu bytes", cb);
+        TST_MEASURE(RTCrc32(pbBuf, cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "RTCrc32, %6zu bytes", cb);
+
+        TST_MEASURE(tstRefCrc64(pbBuf, cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "CRC64 reference, %6zu bytes", cb);
+        TST_MEASURE(RTCrc64(pbBuf, cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "RTCrc64, %6zu bytes", cb);
+
+        TST_MEASURE(tstRefAdler32(pbBuf, cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "Adler-32 reference, %6zu bytes", cb);
+        TST_MEASURE(RTCrcAdler32(pbBuf, cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "RTCrcAdler32, %6zu bytes", cb);
+    }
+    RTTestPrintf(g_hTest, RTTESTLVL_DEBUG, "uDummy=%#llx\n", uDummy);
+}
+
+
+int main()
+{
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstRTCrc", &g_hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(g_hTest);
+
+    tstInitRefTables();
+
+    size_t const cbBuf = _1M + 123;
+    uint8_t     *pbBuf = (uint8_t *)RTMemAlloc(cbBuf);
+    if (pbBuf)
+    {
+        RTRandBytes(pbBuf, cbBuf);
+
+        tstCheckValues();
+        tstCompare(pbBuf, cbBuf);
+        if (!RTTestErrorCount(g_hTest))
+            tstBenchmark(pbBuf);
+
+        RTMemFree(pbBuf);
+    }
+    else
+        RTTestFailed(g_hTest, "Out of memory");
+
+    return RTTestSummaryAndDestroy(g_hTest);
+}
+
@@ -932,6 +932,148 @@ static void testSha256(void)
 }
 
 
+/** Context union for testShaMulti. */
+typedef union TESTSHACTX
+{
+    RTSHA1CONTEXT       Sha1;
+    RTSHA256CONTEXT     Sha256;
+} TESTSHACTX;
+
+
+/**
+ * Worker for testShaMulti that feeds the streams thru the multi-buffer API.
+ */
+static void testShaMultiUpdate(bool fSha256, uint32_t cStreams, TESTSHACTX *paCtxs,
+                               uint8_t const * const *papbBufs, size_t const *pacbBufs)
+{
+    PRTSHA1CONTEXT   apSha1Ctxs[32];
+    PRTSHA256CONTEXT apSha256Ctxs[32];
+    for (uint32_t i = 0; i < cStreams; i++)
+    {
+        apSha1Ctxs[i]   = &paCtxs[i].Sha1;
+        apSha256Ctxs[i] = &paCtxs[i].Sha256;
+    }
+    if (fSha256)
+        RTSha256UpdateMulti(cStreams, apSha256Ctxs, (void const * const *)papbBufs, pacbBufs);
+    else
+        RTSha1UpdateMulti(cStreams, apSha1Ctxs, (void const * const *)papbBufs, pacbBufs);
+}
+
+
+/**
+ * Tests RTSha1UpdateMulti and RTSha256UpdateMulti against the single stream
+ * API and measures the throughput of both.
+ *
+ * @param   fSha256     Test SHA-256 if set, SHA-1 if clear.
+ */
+static void testShaMulti(bool fSha256)
+{
+    RTTestISub(fSha256 ? "SHA-256 multi-buffer" : "SHA-1 multi-buffer");
+    const char * const pszName = fSha256 ? "SHA-256" : "SHA-1";
+    unsigned const     cbHash  = fSha256 ? RTSHA256_HASH_SIZE : RTSHA1_HASH_SIZE;
+
+    static TESTSHACTX   s_aCtxs[32];
+    uint8_t const      *apbBufs[32];
+    size_t              acbBufs[32];
+    uint8_t             abExpect[RTSHA256_HASH_SIZE];
+    uint8_t             abActual[RTSHA256_HASH_SIZE];
+
+    /*
+     * Streams of differing lengths and alignments, fed in two uneven rounds
+     * so partially filled blocks get carried over between the calls.
+     */
+    for (uint32_t cStreams = 1; cStreams <= 19; cStreams++)
+        for (uint32_t iVariant = 0; iVariant < 4; iVariant++)
+        {
+            for (uint32_t i = 0; i < cStreams; i++)
+            {
+                size_t const offBuf = (i * 0x1357 + iVariant * 3) % _4K;
+                size_t       cbBuf  = (i * 4099 + cStreams * 61 + iVariant * 977) % (sizeof(g_abRandom72KB) - offBuf);
+                if (iVariant == 3)
+                    cbBuf = (i & 1) ? 64 * (i + 1) : 64 * (i + 1) + i;
+                apbBufs[i] = &g_abRandom72KB[offBuf];
+                acbBufs[i] = cbBuf;
+                if (fSha256)
+                    RTSha256Init(&s_aCtxs[i].Sha256);
+                else
+                    RTSha1Init(&s_aCtxs[i].Sha1);
+            }
+
+            size_t  acbFirst[32];
+            for (uint32_t i = 0; i < cStreams; i++)
+                acbFirst[i] = RT_MIN(acbBufs[i], (size_t)(i * 37 + iVariant * 131) % 1500);
+            testShaMultiUpdate(fSha256, cStreams, s_aCtxs, apbBufs, acbFirst);
+
+            uint8_t const *apbSecond[32];
+            size_t         acbSecond[32];
+            for (uint32_t i = 0; i < cStreams; i++)
+            {
+                apbSecond[i] = apbBufs[i] + acbFirst[i];
+                acbSecond[i] = acbBufs[i] - acbFirst[i];
+            }
+            testShaMultiUpdate(fSha256, cStreams, s_aCtxs, apbSecond, acbSecond);
+
+            for (uint32_t i = 0; i < cStreams; i++)
+            {
+                if (fSha256)
+                {
+                    RTSha256Final(&s_aCtxs[i].Sha256, abActual);
+                    RTSha256(apbBufs[i], acbBufs[i], abExpect);
+                }
+                else
+                {
+                    RTSha1Final(&s_aCtxs[i].Sha1, abActual);
+                    RTSha1(apbBufs[i], acbBufs[i], abExpect);
+                }
+                if (memcmp(abActual, abExpect, cbHash))
+                    RTTestIFailed("%s: stream %u of %u (variant %u, %zu bytes) mismatch: %.*Rhxs, expected %.*Rhxs",
+                                  pszName, i, cStreams, iVariant, acbBufs[i], cbHash, abActual, cbHash, abExpect);
+            }
+        }
+
+    /*
+     * Throughput of eight 9KB streams, sequentially and interleaved.
+     */
+    size_t const cbStream = sizeof(g_abRandom72KB) / 8;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        apbBufs[i] = &g_abRandom72KB[i * cbStream];
+        acbBufs[i] = cbStream;
+        if (fSha256)
+            RTSha256Init(&s_aCtxs[i].Sha256);
+        else
+            RTSha1Init(&s_aCtxs[i].Sha1);
+    }
+
+    for (uint32_t iMulti = 0; iMulti < 2; iMulti++)
+    {
+        uint32_t cRounds = 0;
+        RTThreadYield();
+        uint64_t const uStartTS = RTTimeNanoTS();
+        uint64_t       cNsElapsed;
+        do
+        {
+            for (uint32_t iInner = 0; iInner < 16; iInner++)
+                if (iMulti)
+                    testShaMultiUpdate(fSha256, 8, s_aCtxs, apbBufs, acbBufs);
+                else
+                    for (uint32_t i = 0; i < 8; i++)
+                    {
+                        if (fSha256)
+                            RTSha256Update(&s_aCtxs[i].Sha256, apbBufs[i], acbBufs[i]);
+                        else
+                            RTSha1Update(&s_aCtxs[i].Sha1, apbBufs[i], acbBufs[i]);
+                    }
+            cRounds += 16;
+            cNsElapsed = RTTimeNanoTS() - uStartTS;
+        } while (cNsElapsed < RT_NS_1SEC);
+
+        RTTestIValueF((uint64_t)cRounds * sizeof(g_abRandom72KB) / _1K / (0.000000001 * cNsElapsed), RTTESTUNIT_KILOBYTES_PER_SEC,
+                      "%s 8 streams %s throughput", pszName, iMulti ? "multi-buffer" : "sequential");
+    }
+}
+
+
 /**
  * Tests SHA-224
  */
@@ -1263,6 +1405,8 @@ int main()
     testMd5();
     testSha1();
     testSha256();
+    testShaMulti(false /*fSha256*/);
+    testShaMulti(true /*fSha256*/);
     testSha224();
     testSha512();
     testSha384();
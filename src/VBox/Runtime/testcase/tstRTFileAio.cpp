@@ -33,8 +33,10 @@
 #include <iprt/err.h>
 #include <iprt/mem.h>
 #include <iprt/param.h>
+#include <iprt/rand.h>
 #include <iprt/string.h>
 #include <iprt/test.h>
+#include <iprt/time.h>
 
 
 /*******************************************************************************
@@ -43,6 +45,8 @@
 /** @todo make configurable through cmd line. */
 #define TSTFILEAIO_MAX_REQS_IN_FLIGHT   64
 #define TSTFILEAIO_BUFFER_SIZE          (64*_1K)
+/** Number of requests issued by a random I/O throughput run. */
+#define TSTFILEAIO_RANDOM_REQS          8192
 
 
 /*******************************************************************************
@@ -169,6 +173,207 @@ void tstFileAioTestReadWriteBasic(RTFILE File, bool fWrite, void *pvTestBuf,
     RTTestGuardedFree(g_hTest, paReqs);
 }
 
+/**
+ * Writes the test pattern with a gather request and reads it back with a
+ * differently split scatter request.
+ */
+static void tstFileAioTestReadWriteSg(RTFILE hFile, void *pvTestBuf, size_t cbTestBuf)
+{
+    void *pvWrite, *pvRead;
+    RTTESTI_CHECK_RC_OK_RETV(RTTestGuardedAlloc(g_hTest, cbTestBuf, PAGE_SIZE, true /*fHead*/, &pvWrite));
+    RTTESTI_CHECK_RC_OK_RETV(RTTestGuardedAlloc(g_hTest, cbTestBuf, PAGE_SIZE, true /*fHead*/, &pvRead));
+    memset(pvRead, 0xff, cbTestBuf);
+
+    RTFILEAIOCTX hAioCtx;
+    RTTESTI_CHECK_RC_RETV(RTFileAioCtxCreate(&hAioCtx, 4, 0 /* fFlags */), VINF_SUCCESS);
+    RTTESTI_CHECK_RC_RETV(RTFileAioCtxAssociateWithFile(hAioCtx, hFile), VINF_SUCCESS);
+    RTFILEAIOREQ hReq;
+    RTTESTI_CHECK_RC_RETV(RTFileAioReqCreate(&hReq), VINF_SUCCESS);
+
+    /* Gather write using four equally sized segments, reversed in memory. */
+    size_t const cbSeg = cbTestBuf / 4;
+    RTSGSEG      aSegs[4];
+    for (unsigned i = 0; i < RT_ELEMENTS(aSegs); i++)
+    {
+        aSegs[i].pvSeg = (uint8_t *)pvWrite + (RT_ELEMENTS(aSegs) - 1 - i) * cbSeg;
+        aSegs[i].cbSeg = cbSeg;
+        memcpy(aSegs[i].pvSeg, (uint8_t *)pvTestBuf + i * cbSeg, cbSeg);
+    }
+    int rc = RTFileAioReqPrepareWriteSg(hReq, hFile, 0, &aSegs[0], RT_ELEMENTS(aSegs), NULL);
+    if (rc == VERR_NOT_SUPPORTED)
+        RTTestIPrintf(RTTESTLVL_ALWAYS, "Vectored requests are not supported on this host, skipping\n");
+    else
+    {
+        RTTESTI_CHECK_RC(rc, VINF_SUCCESS);
+
+        RTFILEAIOREQ hReqCompleted = NIL_RTFILEAIOREQ;
+        uint32_t     cCompleted    = 0;
+        size_t       cbTransfered  = 0;
+        RTTESTI_CHECK_RC(RTFileAioCtxSubmit(hAioCtx, &hReq, 1), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileAioCtxWait(hAioCtx, 1, RT_INDEFINITE_WAIT, &hReqCompleted, 1, &cCompleted), VINF_SUCCESS);
+        RTTESTI_CHECK(cCompleted == 1 && hReqCompleted == hReq);
+        RTTESTI_CHECK_RC(RTFileAioReqGetRC(hReq, &cbTransfered), VINF_SUCCESS);
+        RTTESTI_CHECK_MSG(cbTransfered == cbTestBuf, ("cbTransfered=%zu\n", cbTransfered));
+
+        /* Scatter read into one small and one large segment. */
+        aSegs[0].pvSeg = pvRead;
+        aSegs[0].cbSeg = cbSeg;
+        aSegs[1].pvSeg = (uint8_t *)pvRead + cbSeg;
+        aSegs[1].cbSeg = cbTestBuf - cbSeg;
+        RTTESTI_CHECK_RC(RTFileAioReqPrepareReadSg(hReq, hFile, 0, &aSegs[0], 2, NULL), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileAioCtxSubmit(hAioCtx, &hReq, 1), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileAioCtxWait(hAioCtx, 1, RT_INDEFINITE_WAIT, &hReqCompleted, 1, &cCompleted), VINF_SUCCESS);
+        RTTESTI_CHECK(cCompleted == 1 && hReqCompleted == hReq);
+        RTTESTI_CHECK_RC(RTFileAioReqGetRC(hReq, &cbTransfered), VINF_SUCCESS);
+        RTTESTI_CHECK_MSG(cbTransfered == cbTestBuf, ("cbTransfered=%zu\n", cbTransfered));
+        RTTESTI_CHECK(memcmp(pvRead, pvTestBuf, cbTestBuf) == 0);
+
+        /* A flush must complete without transferring anything. */
+        RTTESTI_CHECK_RC(RTFileAioReqPrepareFlush(hReq, hFile, NULL), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileAioCtxSubmit(hAioCtx, &hReq, 1), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileAioCtxWait(hAioCtx, 1, RT_INDEFINITE_WAIT, &hReqCompleted, 1, &cCompleted), VINF_SUCCESS);
+        RTTESTI_CHECK(cCompleted == 1 && hReqCompleted == hReq);
+        RTTESTI_CHECK_RC(RTFileAioReqGetRC(hReq, NULL), VINF_SUCCESS);
+    }
+
+    RTTESTI_CHECK_RC(RTFileAioReqDestroy(hReq), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(RTFileAioCtxDestroy(hAioCtx), VINF_SUCCESS);
+    RTTestGuardedFree(g_hTest, pvRead);
+    RTTestGuardedFree(g_hTest, pvWrite);
+}
+
+
+/**
+ * Measures the read throughput for the given request size and queue depth.
+ *
+ * Unlike tstFileAioTestReadWriteBasic the queue is refilled as soon as
+ * requests complete, so it stays at the given depth the whole time.
+ */
+static void tstFileAioTestThroughput(RTFILE hFile, bool fRandom, size_t cbReq, uint64_t cbTestFile,
+                                     uint32_t cReqsInFlight)
+{
+    uint64_t const cBlocks    = cbTestFile / cbReq;
+    uint64_t const cReqsTotal = fRandom ? RT_MIN(cBlocks, TSTFILEAIO_RANDOM_REQS) : cBlocks;
+
+    RTFILEAIOREQ *pahReqs = (PRTFILEAIOREQ)RTTestGuardedAllocHead(g_hTest, cReqsInFlight * sizeof(RTFILEAIOREQ));
+    RTTESTI_CHECK_RETV(pahReqs);
+    RTFILEAIOREQ *pahReqsCompleted = (PRTFILEAIOREQ)RTTestGuardedAllocHead(g_hTest, cReqsInFlight * sizeof(RTFILEAIOREQ));
+    RTTESTI_CHECK_RETV(pahReqsCompleted);
+    uint8_t *pbBufs;
+    RTTESTI_CHECK_RC_OK_RETV(RTTestGuardedAlloc(g_hTest, cReqsInFlight * cbReq, PAGE_SIZE, true /*fHead*/, (void **)&pbBufs));
+
+    RTFILEAIOCTX hAioCtx;
+    RTTESTI_CHECK_RC_RETV(RTFileAioCtxCreate(&hAioCtx, cReqsInFlight, 0 /* fFlags */), VINF_SUCCESS);
+    RTTESTI_CHECK_RC_RETV(RTFileAioCtxAssociateWithFile(hAioCtx, hFile), VINF_SUCCESS);
+    for (uint32_t i = 0; i < cReqsInFlight; i++)
+        RTTESTI_CHECK_RC(RTFileAioReqCreate(&pahReqs[i]), VINF_SUCCESS);
+
+    uint64_t iBlockNext  = 0;
+    uint64_t cSubmitted  = 0;
+    uint64_t cCompleted  = 0;
+    uint64_t NanoTS      = RTTimeNanoTS();
+    int      rc          = VINF_SUCCESS;
+
+    /* Fill the queue. */
+    uint32_t cReqs = 0;
+    while (cReqs < cReqsInFlight && cSubmitted < cReqsTotal)
+    {
+        uint8_t *pbBuf = pbBufs + cReqs * cbReq;
+        RTFOFF   off   = (fRandom ? RTRandU64Ex(0, cBlocks - 1) : iBlockNext++) * cbReq;
+        RTTESTI_CHECK_RC(RTFileAioReqPrepareRead(pahReqs[cReqs], hFile, off, pbBuf, cbReq, pbBuf), VINF_SUCCESS);
+        cReqs++;
+        cSubmitted++;
+    }
+    RTTESTI_CHECK_RC(rc = RTFileAioCtxSubmit(hAioCtx, pahReqs, cReqs), VINF_SUCCESS);
+
+    /* Refill it with each batch of completions. */
+    while (RT_SUCCESS(rc) && cCompleted < cReqsTotal)
+    {
+        uint32_t cDone = 0;
+        RTTESTI_CHECK_RC(rc = RTFileAioCtxWait(hAioCtx, 1, RT_INDEFINITE_WAIT, pahReqsCompleted, cReqsInFlight, &cDone),
+                         VINF_SUCCESS);
+        if (RT_FAILURE(rc))
+            break;
+
+        cReqs = 0;
+        for (uint32_t i = 0; i < cDone; i++)
+        {
+            size_t cbTransfered = 0;
+            RTTESTI_CHECK_RC(rc = RTFileAioReqGetRC(pahReqsCompleted[i], &cbTransfered), VINF_SUCCESS);
+            RTTESTI_CHECK_MSG(cbTransfered == cbReq, ("cbTransfered=%zu\n", cbTransfered));
+            cCompleted++;
+
+            if (cSubmitted < cReqsTotal)
+            {
+                uint8_t *pbBuf = (uint8_t *)RTFileAioReqGetUser(pahReqsCompleted[i]);
+                RTFOFF   off   = (fRandom ? RTRandU64Ex(0, cBlocks - 1) : iBlockNext++) * cbReq;
+                RTTESTI_CHECK_RC(RTFileAioReqPrepareRead(pahReqsCompleted[i], hFile, off, pbBuf, cbReq, pbBuf), VINF_SUCCESS);
+                pahReqsCompleted[cReqs++] = pahReqsCompleted[i];
+                cSubmitted++;
+            }
+        }
+        if (cReqs && RT_SUCCESS(rc))
+            RTTESTI_CHECK_RC(rc = RTFileAioCtxSubmit(hAioCtx, pahReqsCompleted, cReqs), VINF_SUCCESS);
+    }
+
+    /* Drain what's left in case of failure so the context can be destroyed. */
+    while (cSubmitted > cCompleted)
+    {
+        uint32_t cDone = 0;
+        if (RT_FAILURE(RTFileAioCtxWait(hAioCtx, 1, RT_INDEFINITE_WAIT, pahReqsCompleted, cReqsInFlight, &cDone)))
+            break;
+        cCompleted += cDone;
+    }
+
+    NanoTS = RTTimeNanoTS() - NanoTS;
+    if (RT_SUCCESS(rc) && NanoTS)
+    {
+        RTTestValueF(g_hTest, (uint64_t)(cReqsTotal * cbReq / (NanoTS / 1000000000.0) / 1024), RTTESTUNIT_KILOBYTES_PER_SEC,
+                     "%s %zuK QD%u", fRandom ? "Random" : "Sequential", cbReq / _1K, cReqsInFlight);
+        RTTestValueF(g_hTest, (uint64_t)(cReqsTotal / (NanoTS / 1000000000.0)), RTTESTUNIT_OCCURRENCES_PER_SEC,
+                     "%s %zuK QD%u requests", fRandom ? "Random" : "Sequential", cbReq / _1K, cReqsInFlight);
+    }
+
+    for (uint32_t i = 0; i < cReqsInFlight; i++)
+        RTTESTI_CHECK_RC(RTFileAioReqDestroy(pahReqs[i]), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(RTFileAioCtxDestroy(hAioCtx), VINF_SUCCESS);
+    RTTestGuardedFree(g_hTest, pbBufs);
+    RTTestGuardedFree(g_hTest, pahReqsCompleted);
+    RTTestGuardedFree(g_hTest, pahReqs);
+}
+
+
+/**
+ * Runs the throughput measurements for the given open mode.
+ *
+ * @param   fOpenAio    The async I/O related open flags (RTFILE_O_ASYNC_IO,
+ *                      RTFILE_O_NO_CACHE).
+ */
+static void tstFileAioTestThroughputAll(const char *pszMode, uint64_t fOpenAio, uint64_t cbTestFile, uint32_t cReqsMax)
+{
+    RTTestSubF(g_hTest, "Throughput (%s)", pszMode);
+    RTFILE hFile;
+    int rc;
+    RTTESTI_CHECK_RC(rc = RTFileOpen(&hFile, "tstFileAio#1.tst",
+                                     RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_NONE | fOpenAio),
+                     VINF_SUCCESS);
+    if (RT_FAILURE(rc))
+        return;
+
+    static const uint32_t s_acReqsInFlight[] = { 1, 4, 16, 64 };
+    for (unsigned i = 0; i < RT_ELEMENTS(s_acReqsInFlight) && RTTestErrorCount(g_hTest) == 0; i++)
+    {
+        uint32_t cReqsInFlight = RT_MIN(s_acReqsInFlight[i], cReqsMax);
+        tstFileAioTestThroughput(hFile, false /*fRandom*/, TSTFILEAIO_BUFFER_SIZE, cbTestFile, cReqsInFlight);
+        tstFileAioTestThroughput(hFile, true /*fRandom*/, _4K, cbTestFile, cReqsInFlight);
+        if (cReqsInFlight != s_acReqsInFlight[i])
+            break;
+    }
+
+    RTFileClose(hFile);
+}
+
+
 int main()
 {
     int rc = RTTestInitAndCreate("tstRTFileAio", &g_hTest);
@@ -212,10 +417,23 @@ int main()
                 if (RT_SUCCESS(rc))
                 {
                     tstFileAioTestReadWriteBasic(hFile, false /*fWrite*/, pbTestBuf, TSTFILEAIO_BUFFER_SIZE, 100*_1M, cReqsMax);
+
+                    RTTestSub(g_hTest, "Scatter/Gather");
+                    tstFileAioTestReadWriteSg(hFile, pbTestBuf, TSTFILEAIO_BUFFER_SIZE);
                     RTFileClose(hFile);
                 }
             }
 
+            /* Throughput with and without the host cache.  RTFILE_O_ASYNC_IO
+               bypasses the cache on Linux, leave it out if the host can do
+               async I/O on buffered files without it. */
+            if (RTTestErrorCount(g_hTest) == 0)
+                tstFileAioTestThroughputAll("buffered",
+                                            AioLimits.fFlags & RTFILEAIOLIMITS_F_BUFFERED ? 0 : RTFILE_O_ASYNC_IO,
+                                            100*_1M, cReqsMax);
+            if (RTTestErrorCount(g_hTest) == 0)
+                tstFileAioTestThroughputAll("uncached", RTFILE_O_ASYNC_IO | RTFILE_O_NO_CACHE, 100*_1M, cReqsMax);
+
             /* Cleanup */
             RTFileDelete("tstFileAio#1.tst");
         }
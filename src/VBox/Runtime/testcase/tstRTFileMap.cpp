@@ -0,0 +1,262 @@
+/* $Id: tstRTFileMap.cpp $ */
+/** @file
+ * IPRT Testcase - RTFileMap and RTMemPageAllocEx.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/file.h>
+
+#include <iprt/asm.h>
+#include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/param.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** The name of the test file. */
+#define TSTRTFILEMAP_NAME   "tstRTFileMap#1.tst"
+/** The size of the test file, deliberately not page aligned. */
+#define TSTRTFILEMAP_SIZE   (_256K + 123)
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+static RTTEST g_hTest = NIL_RTTEST;
+
+
+/**
+ * The byte expected at the given file offset.
+ */
+static uint8_t tstFileMapByte(size_t off)
+{
+    return (uint8_t)(off * 7 + (off >> 12));
+}
+
+
+/**
+ * Checks that the mapping matches the file pattern.
+ */
+static bool tstFileMapCheck(uint8_t const *pb, size_t off, size_t cb)
+{
+    for (size_t i = 0; i < cb; i++)
+        if (pb[i] != tstFileMapByte(off + i))
+        {
+            RTTestIFailed("offset %#zx: %#x, expected %#x", off + i, pb[i], tstFileMapByte(off + i));
+            return false;
+        }
+    return true;
+}
+
+
+static void tstFileMap(void)
+{
+    RTTestISub("RTFileMap");
+
+    /*
+     * Create the test file.
+     */
+    uint8_t *pbPattern = (uint8_t *)RTMemAlloc(TSTRTFILEMAP_SIZE);
+    RTTESTI_CHECK_RETV(pbPattern);
+    for (size_t i = 0; i < TSTRTFILEMAP_SIZE; i++)
+        pbPattern[i] = tstFileMapByte(i);
+
+    RTFILE hFile;
+    RTTESTI_CHECK_RC_RETV(RTFileOpen(&hFile, TSTRTFILEMAP_NAME,
+                                     RTFILE_O_READWRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_NONE),
+                          VINF_SUCCESS);
+    RTTESTI_CHECK_RC(RTFileWrite(hFile, pbPattern, TSTRTFILEMAP_SIZE, NULL), VINF_SUCCESS);
+
+    /*
+     * Read-only mappings, the whole file and at various unaligned offsets.
+     */
+    void *pv;
+    int rc = RTFileMap(hFile, 0, TSTRTFILEMAP_SIZE, RTFILEMAP_F_READ, &pv);
+    if (rc == VERR_NOT_SUPPORTED)
+    {
+        RTTestSkipped(g_hTest, "not supported on this host");
+        RTFileClose(hFile);
+        RTFileDelete(TSTRTFILEMAP_NAME);
+        RTMemFree(pbPattern);
+        return;
+    }
+    RTTESTI_CHECK_RC(rc, VINF_SUCCESS);
+    if (RT_SUCCESS(rc))
+    {
+        tstFileMapCheck((uint8_t const *)pv, 0, TSTRTFILEMAP_SIZE);
+        RTTESTI_CHECK_RC(RTFileMapAdvise(pv, TSTRTFILEMAP_SIZE, RTFILEMAPADVICE_SEQUENTIAL), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileMapAdvise((uint8_t *)pv + 4097, 5000, RTFILEMAPADVICE_RANDOM), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileMapAdvise(pv, TSTRTFILEMAP_SIZE, RTFILEMAPADVICE_WILL_NEED), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileMapAdvise(pv, TSTRTFILEMAP_SIZE, RTFILEMAPADVICE_DONT_NEED), VINF_SUCCESS);
+        tstFileMapCheck((uint8_t const *)pv, 0, TSTRTFILEMAP_SIZE);
+        RTTESTI_CHECK_RC(RTFileMapAdvise(pv, TSTRTFILEMAP_SIZE, RTFILEMAPADVICE_NORMAL), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileUnmap(pv, TSTRTFILEMAP_SIZE), VINF_SUCCESS);
+    }
+
+    static const struct { size_t off, cb; } s_aRanges[] =
+    {
+        { 1,                        1 },
+        { PAGE_SIZE - 1,            2 },
+        { PAGE_SIZE,                PAGE_SIZE },
+        { _64K - 3,                 _64K + 7 },
+        { _128K + 4097,             _64K },
+        { TSTRTFILEMAP_SIZE - 1,    1 },
+        { TSTRTFILEMAP_SIZE - 200,  200 },
+    };
+    for (unsigned i = 0; i < RT_ELEMENTS(s_aRanges); i++)
+    {
+        RTTESTI_CHECK_RC(rc = RTFileMap(hFile, s_aRanges[i].off, s_aRanges[i].cb, RTFILEMAP_F_READ, &pv), VINF_SUCCESS);
+        if (RT_SUCCESS(rc))
+        {
+            tstFileMapCheck((uint8_t const *)pv, s_aRanges[i].off, s_aRanges[i].cb);
+            RTTESTI_CHECK_RC(RTFileUnmap(pv, s_aRanges[i].cb), VINF_SUCCESS);
+        }
+    }
+
+    /*
+     * Ranges beyond the end of the file.
+     */
+    RTTESTI_CHECK_RC(RTFileMap(hFile, TSTRTFILEMAP_SIZE - 10, 11, RTFILEMAP_F_READ, &pv), VERR_OUT_OF_RANGE);
+    RTTESTI_CHECK(pv == NULL);
+    RTTESTI_CHECK_RC(RTFileMap(hFile, TSTRTFILEMAP_SIZE + 1, 1, RTFILEMAP_F_READ, &pv), VERR_OUT_OF_RANGE);
+    RTTESTI_CHECK_RC(RTFileMap(hFile, _1G, PAGE_SIZE, RTFILEMAP_F_READ, &pv), VERR_OUT_OF_RANGE);
+    RTTESTI_CHECK_RC(RTFileUnmap(NULL, 0), VINF_SUCCESS);
+
+    /*
+     * Copy-on-write: the changes are visible in the mapping but never make
+     * it to the file, and the mapping outlives the file handle.
+     */
+    RTTestISub("RTFileMap copy-on-write");
+    size_t const offCow = PAGE_SIZE + 42;
+    size_t const cbCow  = _64K;
+    RTTESTI_CHECK_RC(rc = RTFileMap(hFile, offCow, cbCow, RTFILEMAP_F_COPY_ON_WRITE, &pv), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(RTFileClose(hFile), VINF_SUCCESS);
+    if (RT_SUCCESS(rc))
+    {
+        uint8_t *pb = (uint8_t *)pv;
+        tstFileMapCheck(pb, offCow, cbCow);
+        for (size_t i = 0; i < cbCow; i += 97)
+            pb[i] = ~tstFileMapByte(offCow + i);
+        for (size_t i = 0; i < cbCow; i += 97)
+            if (pb[i] != (uint8_t)~tstFileMapByte(offCow + i))
+            {
+                RTTestIFailed("COW write lost at %#zx", offCow + i);
+                break;
+            }
+
+        void *pvRo;
+        RTTESTI_CHECK_RC(RTFileOpen(&hFile, TSTRTFILEMAP_NAME, RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_NONE),
+                         VINF_SUCCESS);
+        RTTESTI_CHECK_RC(rc = RTFileMap(hFile, offCow, cbCow, RTFILEMAP_F_READ, &pvRo), VINF_SUCCESS);
+        if (RT_SUCCESS(rc))
+        {
+            tstFileMapCheck((uint8_t const *)pvRo, offCow, cbCow);
+            RTTESTI_CHECK_RC(RTFileUnmap(pvRo, cbCow), VINF_SUCCESS);
+        }
+
+        uint8_t *pbRead = (uint8_t *)RTMemAlloc(cbCow);
+        if (pbRead)
+        {
+            RTTESTI_CHECK_RC(RTFileReadAt(hFile, offCow, pbRead, cbCow, NULL), VINF_SUCCESS);
+            tstFileMapCheck(pbRead, offCow, cbCow);
+            RTMemFree(pbRead);
+        }
+        RTTESTI_CHECK_RC(RTFileClose(hFile), VINF_SUCCESS);
+        RTTESTI_CHECK_RC(RTFileUnmap(pv, cbCow), VINF_SUCCESS);
+    }
+
+    RTFileDelete(TSTRTFILEMAP_NAME);
+    RTMemFree(pbPattern);
+}
+
+
+/**
+ * Allocates, touches and frees a RTMemPageAllocEx block.
+ *
+ * @returns true if the allocation succeeded.
+ */
+static bool tstMemPageAllocExOne(size_t cb, uint32_t fFlags)
+{
+    uint8_t *pb = (uint8_t *)RTMemPageAllocEx(cb, fFlags);
+    if (!pb)
+        return false;
+    RTTESTI_CHECK(!((uintptr_t)pb & PAGE_OFFSET_MASK));
+    if (fFlags & RTMEMPAGEALLOC_F_ZERO)
+        RTTESTI_CHECK_MSG(ASMMemIsAll8(pb, cb, 0) == NULL, ("cb=%#zx fFlags=%#x\n", cb, fFlags));
+    memset(pb, 0x5a, cb);
+    RTTESTI_CHECK(ASMMemIsAll8(pb, cb, 0x5a) == NULL);
+    RTMemPageFree(pb, cb);
+    return true;
+}
+
+
+static void tstMemPageAllocEx(void)
+{
+    RTTestISub("RTMemPageAllocEx");
+
+    static const size_t s_acb[] = { PAGE_SIZE, 3 * PAGE_SIZE, _128K, _1M + PAGE_SIZE, _2M, 3 * _2M + PAGE_SIZE };
+    static const uint32_t s_afFlags[] =
+    {
+        0,
+        RTMEMPAGEALLOC_F_ZERO,
+        RTMEMPAGEALLOC_F_ADVISE_LARGE_PAGES,
+        RTMEMPAGEALLOC_F_ADVISE_LARGE_PAGES | RTMEMPAGEALLOC_F_ZERO,
+    };
+    for (unsigned iFlags = 0; iFlags < RT_ELEMENTS(s_afFlags); iFlags++)
+        for (unsigned iCb = 0; iCb < RT_ELEMENTS(s_acb); iCb++)
+            RTTESTI_CHECK_MSG(tstMemPageAllocExOne(s_acb[iCb], s_afFlags[iFlags]),
+                              ("cb=%#zx fFlags=%#x\n", s_acb[iCb], s_afFlags[iFlags]));
+
+    /*
+     * Explicit large pages depend on the host configuration, but sizes that
+     * aren't a multiple of the large page size must always fail.
+     */
+    RTTESTI_CHECK(RTMemPageAllocEx(_2M + PAGE_SIZE, RTMEMPAGEALLOC_F_LARGE_PAGES) == NULL);
+    RTTESTI_CHECK(RTMemPageAllocEx(PAGE_SIZE, RTMEMPAGEALLOC_F_LARGE_PAGES) == NULL);
+    if (tstMemPageAllocExOne(RTMEMPAGEALLOC_LARGE_PAGE_SIZE, RTMEMPAGEALLOC_F_LARGE_PAGES | RTMEMPAGEALLOC_F_ZERO))
+        RTTestIPrintf(RTTESTLVL_ALWAYS, "Explicit large pages are available.\n");
+    else
+        RTTestIPrintf(RTTESTLVL_ALWAYS, "Explicit large pages are not available, skipped.\n");
+}
+
+
+int main()
+{
+    int rc = RTTestInitAndCreate("tstRTFileMap", &g_hTest);
+    if (rc)
+        return rc;
+    RTTestBanner(g_hTest);
+
+    tstFileMap();
+    tstMemPageAllocEx();
+
+    return RTTestSummaryAndDestroy(g_hTest);
+}
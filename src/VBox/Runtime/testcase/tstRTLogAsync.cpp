@@ -0,0 +1,279 @@
+/* $Id: tstRTLogAsync.cpp $ */
+/** @file
+ * IPRT Testcase - Asynchronous logging (RTLOGFLAGS_ASYNC).
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/log.h>
+
+#include <iprt/err.h>
+#include <iprt/file.h>
+#include <iprt/mem.h>
+#include <iprt/path.h>
+#include <iprt/process.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
+
+#include <stdio.h>
+
+
+/*******************************************************************************
+*   Defined Constants And Macros                                               *
+*******************************************************************************/
+/** Number of producer threads. */
+#define TSTLOGASYNC_THREADS             4
+/** Number of messages per producer thread. */
+#define TSTLOGASYNC_MSGS_PER_THREAD     5000
+/** Number of messages for the timing runs. */
+#define TSTLOGASYNC_BENCH_MSGS          20000
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+static RTTEST       g_hTest;
+/** The log file name. */
+static char         g_szLogFile[RTPATH_MAX];
+/** The logger the producers are using. */
+static PRTLOGGER    g_pLogger;
+
+
+/**
+ * Creates the test logger writing to g_szLogFile.
+ */
+static PRTLOGGER tstLogAsyncCreate(uint32_t fFlags)
+{
+    RTFileDelete(g_szLogFile);
+    PRTLOGGER pLogger = NULL;
+    int rc = RTLogCreate(&pLogger, fFlags, NULL, NULL, 0, NULL, RTLOGDEST_FILE, "%s", g_szLogFile);
+    if (RT_FAILURE(rc))
+    {
+        RTTestIFailed("RTLogCreate -> %Rrc", rc);
+        return NULL;
+    }
+    return pLogger;
+}
+
+
+/**
+ * Producer thread, logs TSTLOGASYNC_MSGS_PER_THREAD numbered lines.
+ */
+static DECLCALLBACK(int) tstLogAsyncProducer(RTTHREAD hThreadSelf, void *pvUser)
+{
+    uint32_t const iThread = (uint32_t)(uintptr_t)pvUser;
+    NOREF(hThreadSelf);
+    for (uint32_t i = 0; i < TSTLOGASYNC_MSGS_PER_THREAD; i++)
+        RTLogLoggerEx(g_pLogger, 0, ~0U, "producer %u line %u\n", iThread, i);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Checks that every line of every producer made it to the file exactly once
+ * and in order, allowing for reported drops.
+ */
+static void tstLogAsyncVerifyFile(uint64_t cDropped)
+{
+    void  *pvFile;
+    size_t cbFile;
+    int rc = RTFileReadAll(g_szLogFile, &pvFile, &cbFile);
+    if (RT_FAILURE(rc))
+    {
+        RTTestIFailed("RTFileReadAll(%s) -> %Rrc", g_szLogFile, rc);
+        return;
+    }
+
+    uint32_t acLines[TSTLOGASYNC_THREADS];
+    int32_t  aiLast[TSTLOGASYNC_THREADS];
+    for (unsigned i = 0; i < TSTLOGASYNC_THREADS; i++)
+    {
+        acLines[i] = 0;
+        aiLast[i]  = -1;
+    }
+
+    char *psz = (char *)RTMemDupEx(pvFile, cbFile, 1);
+    RTFileReadAllFree(pvFile, cbFile);
+    RTTESTI_CHECK_RETV(psz);
+
+    uint32_t cBadLines = 0;
+    bool     fDropNote = false;
+    char    *pszLine   = psz;
+    while (pszLine && *pszLine)
+    {
+        char *pszEnd = strchr(pszLine, '\n');
+        if (pszEnd)
+            *pszEnd++ = '\0';
+
+        const char *pszMsg = strstr(pszLine, "producer ");
+        unsigned iThread, iLine;
+        if (pszMsg && sscanf(pszMsg, "producer %u line %u", &iThread, &iLine) == 2)
+        {
+            if (iThread < TSTLOGASYNC_THREADS && (int32_t)iLine > aiLast[iThread])
+            {
+                aiLast[iThread] = (int32_t)iLine;
+                acLines[iThread]++;
+            }
+            else if (cBadLines++ < 8)
+                RTTestIFailed("Out of order or bogus line: '%s'", pszLine);
+
+            /* The thread name prefix must be that of the producer, not the writer. */
+            char szName[32];
+            RTStrPrintf(szName, sizeof(szName), "tst-%u", iThread);
+            if (!strstr(pszLine, szName) && cBadLines++ < 8)
+                RTTestIFailed("Wrong thread name prefix: '%s'", pszLine);
+        }
+        else if (strstr(pszLine, "log messages dropped"))
+            fDropNote = true;
+        pszLine = pszEnd;
+    }
+
+    uint64_t cTotal = 0;
+    for (unsigned i = 0; i < TSTLOGASYNC_THREADS; i++)
+        cTotal += acLines[i];
+    if (cTotal + cDropped != TSTLOGASYNC_THREADS * TSTLOGASYNC_MSGS_PER_THREAD)
+        RTTestIFailed("Found %RU64 lines + %RU64 dropped, expected %u", cTotal, cDropped,
+                      TSTLOGASYNC_THREADS * TSTLOGASYNC_MSGS_PER_THREAD);
+    if (cDropped && !fDropNote)
+        RTTestIFailed("%RU64 messages dropped without a note in the log", cDropped);
+    RTMemFree(psz);
+}
+
+
+static void tstLogAsyncProducers(void)
+{
+    RTTestSub(g_hTest, "Concurrent producers");
+    g_pLogger = tstLogAsyncCreate(RTLOGFLAGS_ASYNC | RTLOGFLAGS_PREFIX_THREAD | RTLOGFLAGS_PREFIX_TS);
+    if (!g_pLogger)
+        return;
+    RTLogLoggerEx(g_pLogger, 0, ~0U, "tstRTLogAsync: producers starting\n");
+
+    RTTHREAD ahThreads[TSTLOGASYNC_THREADS];
+    for (unsigned i = 0; i < TSTLOGASYNC_THREADS; i++)
+        RTTESTI_CHECK_RC_OK(RTThreadCreateF(&ahThreads[i], tstLogAsyncProducer, (void *)(uintptr_t)i, 0,
+                                            RTTHREADTYPE_DEFAULT, RTTHREADFLAGS_WAITABLE, "tst-%u", i));
+    for (unsigned i = 0; i < TSTLOGASYNC_THREADS; i++)
+        RTTESTI_CHECK_RC_OK(RTThreadWait(ahThreads[i], RT_INDEFINITE_WAIT, NULL));
+
+    /* A flush must write out everything queued. */
+    RTLogFlush(g_pLogger);
+    RTLOGASYNCSTATS Stats;
+    RTTESTI_CHECK_RC_OK(RTLogQueryAsyncStats(g_pLogger, &Stats));
+    RTTESTI_CHECK_MSG(Stats.cWritten == Stats.cQueued, ("cWritten=%RU64 cQueued=%RU64\n", Stats.cWritten, Stats.cQueued));
+    RTTESTI_CHECK_MSG(Stats.cQueued + Stats.cDropped + Stats.cSynchronous == TSTLOGASYNC_THREADS * TSTLOGASYNC_MSGS_PER_THREAD + 1,
+                      ("cQueued=%RU64 cDropped=%RU64 cSynchronous=%RU64\n", Stats.cQueued, Stats.cDropped, Stats.cSynchronous));
+    RTTestValue(g_hTest, "Dropped", Stats.cDropped, RTTESTUNIT_OCCURRENCES);
+    RTTestValue(g_hTest, "Synchronous", Stats.cSynchronous, RTTESTUNIT_OCCURRENCES);
+
+    RTTESTI_CHECK_RC_OK(RTLogDestroy(g_pLogger));
+    g_pLogger = NULL;
+    tstLogAsyncVerifyFile(Stats.cDropped);
+}
+
+
+static void tstLogAsyncLarge(void)
+{
+    RTTestSub(g_hTest, "Large messages");
+    PRTLOGGER pLogger = tstLogAsyncCreate(RTLOGFLAGS_ASYNC);
+    if (!pLogger)
+        return;
+
+    /* Too large for a ring, must take the synchronous path and come out after the small one. */
+    size_t const cchBig = _64K;
+    char *pszBig = (char *)RTMemAlloc(cchBig + 1);
+    RTTESTI_CHECK_RETV(pszBig);
+    memset(pszBig, 'x', cchBig);
+    pszBig[cchBig] = '\0';
+
+    RTLogLoggerEx(pLogger, 0, ~0U, "small\n");
+    RTLogLoggerEx(pLogger, 0, ~0U, "%s\n", pszBig);
+
+    RTLOGASYNCSTATS Stats;
+    RTTESTI_CHECK_RC_OK(RTLogQueryAsyncStats(pLogger, &Stats));
+    RTTESTI_CHECK(Stats.cSynchronous == 1);
+    RTTESTI_CHECK_RC_OK(RTLogDestroy(pLogger));
+
+    uint64_t cbFile = 0;
+    RTTESTI_CHECK_RC_OK(RTFileQuerySize(g_szLogFile, &cbFile));
+    RTTESTI_CHECK_MSG(cbFile == sizeof("small\n") - 1 + cchBig + 1, ("cbFile=%RU64\n", cbFile));
+    RTMemFree(pszBig);
+}
+
+
+/**
+ * Times logging a number of messages on the calling thread.
+ */
+static uint64_t tstLogAsyncTime(uint32_t fFlags)
+{
+    PRTLOGGER pLogger = tstLogAsyncCreate(fFlags);
+    if (!pLogger)
+        return 0;
+
+    uint64_t const nsStart = RTTimeNanoTS();
+    for (uint32_t i = 0; i < TSTLOGASYNC_BENCH_MSGS; i++)
+        RTLogLoggerEx(pLogger, 0, ~0U, "benchmark message %u with a bit of payload %#x %s\n", i, i * 7, "abcdefgh");
+    uint64_t const cNsElapsed = RTTimeNanoTS() - nsStart;
+
+    RTLogDestroy(pLogger);
+    return cNsElapsed / TSTLOGASYNC_BENCH_MSGS;
+}
+
+
+static void tstLogAsyncBenchmark(void)
+{
+    RTTestSub(g_hTest, "Caller latency");
+    uint32_t const fPrefixes = RTLOGFLAGS_PREFIX_TS | RTLOGFLAGS_PREFIX_THREAD;
+    RTTestValue(g_hTest, "Synchronous", tstLogAsyncTime(fPrefixes), RTTESTUNIT_NS_PER_CALL);
+    RTTestValue(g_hTest, "Asynchronous", tstLogAsyncTime(fPrefixes | RTLOGFLAGS_ASYNC), RTTESTUNIT_NS_PER_CALL);
+}
+
+
+int main()
+{
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstRTLogAsync", &g_hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(g_hTest);
+
+    int rc = RTPathTemp(g_szLogFile, sizeof(g_szLogFile));
+    if (RT_SUCCESS(rc))
+    {
+        char szName[64];
+        RTStrPrintf(szName, sizeof(szName), "tstRTLogAsync-%u.log", RTProcSelf());
+        rc = RTPathAppend(g_szLogFile, sizeof(g_szLogFile), szName);
+    }
+    if (RT_FAILURE(rc))
+        return RTTestSkipAndDestroy(g_hTest, "No temporary directory: %Rrc", rc);
+
+    tstLogAsyncProducers();
+    tstLogAsyncLarge();
+    tstLogAsyncBenchmark();
+
+    RTFileDelete(g_szLogFile);
+    return RTTestSummaryAndDestroy(g_hTest);
+}
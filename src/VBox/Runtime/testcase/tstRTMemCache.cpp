@@ -33,6 +33,7 @@
 #include <iprt/err.h>
 #include <iprt/initterm.h>
 #include <iprt/mem.h>
+#include <iprt/mp.h>
 #include <iprt/param.h>
 #include <iprt/rand.h>
 #include <iprt/string.h>
@@ -64,6 +65,8 @@ static RTTEST               g_hTest;
 static RTMEMCACHE           g_hMemCache;
 /** Stop indicator for tst3 threads.  */
 static bool volatile        g_fTst3Stop;
+/** Constructor call counter for tst4. */
+static uint32_t volatile    g_cTst4Ctors;
 
 
 /**
@@ -194,6 +197,74 @@ static void tst2(void)
 }
 
 
+/** Constructor for tst4. */
+static DECLCALLBACK(int) tst4Ctor(RTMEMCACHE hMemCache, void *pvObj, void *pvUser)
+{
+    ASMAtomicIncU32(&g_cTst4Ctors);
+    *(uint32_t *)pvObj = 0;
+    return VINF_SUCCESS;
+}
+
+
+/** Thread for tst4 that leaves a few objects in its magazine. */
+static DECLCALLBACK(int) tst4Thread(RTTHREAD hThreadSelf, void *pvArg)
+{
+    void *apv[5];
+    for (unsigned i = 0; i < RT_ELEMENTS(apv); i++)
+        RTTEST_CHECK_RC(g_hTest, RTMemCacheAllocEx(g_hMemCache, &apv[i]), VINF_SUCCESS);
+    for (unsigned i = 0; i < RT_ELEMENTS(apv); i++)
+        RTMemCacheFree(g_hMemCache, apv[i]);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Checks that objects sitting in the per-thread magazines are neither lost nor
+ * constructed twice, and that they don't count against the max size.
+ */
+static void tst4(void)
+{
+    RTTestISub("Magazines");
+
+    uint32_t const cObjects = 200;
+    g_cTst4Ctors = 0;
+    RTTESTI_CHECK_RC_RETV(RTMemCacheCreate(&g_hMemCache, 64, 0, cObjects, tst4Ctor, NULL, NULL, 0 /*fFlags*/), VINF_SUCCESS);
+
+    void **papv = (void **)RTMemAllocZ(sizeof(void *) * (cObjects + 1));
+    RTTESTI_CHECK_RETV(papv);
+    for (uint32_t iLoop = 0; iLoop < 4; iLoop++)
+    {
+        /* Leave something in the magazine of another thread. */
+        RTTHREAD hThread;
+        int rc = RTThreadCreate(&hThread, tst4Thread, NULL, 0, RTTHREADTYPE_DEFAULT, RTTHREADFLAGS_WAITABLE, "tst4");
+        RTTESTI_CHECK_RC_OK(rc);
+        if (RT_SUCCESS(rc))
+            RTTESTI_CHECK_RC_OK(RTThreadWait(hThread, RT_INDEFINITE_WAIT, NULL));
+
+        /* We should still get every single object, each exactly once. */
+        uint32_t cAllocated = 0;
+        while (   cAllocated <= cObjects
+               && RT_SUCCESS(RTMemCacheAllocEx(g_hMemCache, &papv[cAllocated])))
+        {
+            RTTESTI_CHECK(*(uint32_t *)papv[cAllocated] == 0);
+            *(uint32_t *)papv[cAllocated] = 0x42424242;
+            cAllocated++;
+        }
+        RTTESTI_CHECK_MSG(cAllocated == cObjects, ("cAllocated=%u\n", cAllocated));
+        RTTESTI_CHECK_MSG(g_cTst4Ctors == cObjects, ("g_cTst4Ctors=%u\n", g_cTst4Ctors));
+
+        while (cAllocated-- > 0)
+        {
+            *(uint32_t *)papv[cAllocated] = 0;
+            RTMemCacheFree(g_hMemCache, papv[cAllocated]);
+        }
+    }
+    RTMemFree(papv);
+
+    RTTESTI_CHECK_RC(RTMemCacheDestroy(g_hMemCache), VINF_SUCCESS);
+}
+
+
 /**
  * Thread that allocates
  * @returns
@@ -257,13 +328,15 @@ static void tst3(uint32_t cThreads, uint32_t cbObject, int iMethod, uint32_t cSe
 {
     RTTestISubF("Benchmark - %u threads, %u bytes, %u secs, %s", cThreads, cbObject, cSecs,
                 iMethod == 0 ? "RTMemCache"
+                : iMethod == 1 ? "RTMemCache w/o magazines"
                 : "RTMemAlloc");
 
     /*
      * Create a cache with unlimited space, a start semaphore and line up
      * the threads.
      */
-    RTTESTI_CHECK_RC_RETV(RTMemCacheCreate(&g_hMemCache, cbObject, 0 /*cbAlignment*/, UINT32_MAX, NULL, NULL, NULL, 0 /*fFlags*/), VINF_SUCCESS);
+    RTTESTI_CHECK_RC_RETV(RTMemCacheCreate(&g_hMemCache, cbObject, 0 /*cbAlignment*/, UINT32_MAX, NULL, NULL, NULL,
+                                           iMethod == 1 ? RTMEMCACHE_FLAGS_NO_MAGAZINES : 0), VINF_SUCCESS);
 
     RTSEMEVENTMULTI hEvt;
     RTTESTI_CHECK_RC_OK_RETV(RTSemEventMultiCreate(&hEvt));
@@ -276,7 +349,7 @@ static void tst3(uint32_t cThreads, uint32_t cbObject, int iMethod, uint32_t cSe
     {
         aThreads[i].hThread     = NIL_RTTHREAD;
         aThreads[i].cIterations = 0;
-        aThreads[i].fUseCache   = iMethod == 0;
+        aThreads[i].fUseCache   = iMethod != 2;
         aThreads[i].cbObject    = cbObject;
         aThreads[i].hEvt        = hEvt;
         RTTESTI_CHECK_RC_OK_RETV(RTThreadCreateF(&aThreads[i].hThread, tst3Thread, &aThreads[i], 0,
@@ -316,6 +389,7 @@ static void tst3AllMethods(uint32_t cThreads, uint32_t cbObject, uint32_t cSecs)
 {
     tst3(cThreads, cbObject, 0, cSecs);
     tst3(cThreads, cbObject, 1, cSecs);
+    tst3(cThreads, cbObject, 2, cSecs);
 }
 
 
@@ -330,6 +404,7 @@ int main(int argc, char **argv)
 
     tst1();
     tst2();
+    tst4();
     if (RTTestIErrorCount() == 0)
     {
         uint32_t cSecs = argc == 1 ? 5 : 2;
@@ -348,6 +423,11 @@ int main(int argc, char **argv)
         tst3AllMethods(     3,     1, cSecs);
 
         tst3AllMethods(    16,    32, cSecs);
+
+        /* Contention: one thread per CPU and then some. */
+        uint32_t const cCpus = RT_MIN(RTMpGetCount(), 31);
+        tst3AllMethods(cCpus,         64, cSecs);
+        tst3AllMethods(cCpus * 2,     64, cSecs);
     }
 
     /*
@@ -0,0 +1,204 @@
+/* $Id: tstRTMemFirstNonZero.cpp $ */
+/** @file
+ * IPRT Testcase - RTMemFirstNonZero and RTMemIsZero.
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ *
+ * The contents of this file may alternatively be used under the terms
+ * of the Common Development and Distribution License Version 1.0
+ * (CDDL) only, as it comes in the "COPYING.CDDL" file of the
+ * VirtualBox OSE distribution, in which case the provisions of the
+ * CDDL are applicable instead of those of the GPL.
+ *
+ * You may elect to license modified versions of this file under the
+ * terms and conditions of either the GPL or the CDDL or both.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/mem.h>
+
+#include <iprt/asm.h>
+#include <iprt/param.h>
+#include <iprt/rand.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+#include <iprt/time.h>
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** The test handle. */
+static RTTEST       g_hTest;
+
+
+/** The byte-at-a-time reference. */
+static void *tstRefFirstNonZero(void const *pv, size_t cb)
+{
+    uint8_t const *pb = (uint8_t const *)pv;
+    for (; cb > 0; cb--, pb++)
+        if (*pb)
+            return (void *)pb;
+    return NULL;
+}
+
+
+/**
+ * Compares RTMemFirstNonZero with the reference for all sizes up to a few
+ * hundred bytes, all alignments and each possible non-zero byte position.
+ */
+static void tstCompare(uint8_t *pbBuf, size_t cbBuf)
+{
+    RTTestSub(g_hTest, "Compare with reference");
+
+    memset(pbBuf, 0, cbBuf);
+    for (size_t off = 1; off <= 64; off++)
+        for (size_t cb = 0; cb <= 300; cb++)
+        {
+            uint8_t *pb = &pbBuf[off];
+            if (RTMemFirstNonZero(pb, cb) != NULL || !RTMemIsZero(pb, cb))
+                RTTestFailed(g_hTest, "off=%zu cb=%zu: not zero", off, cb);
+
+            /* Non-zero bytes just outside the block must be ignored. */
+            pb[-1] = 0x01;
+            pb[cb] = 0x80;
+            if (RTMemFirstNonZero(pb, cb) != NULL)
+                RTTestFailed(g_hTest, "off=%zu cb=%zu: looked outside the block", off, cb);
+
+            for (size_t iNonZero = 0; iNonZero < cb; iNonZero++)
+            {
+                pb[iNonZero] = (uint8_t)RTRandU32Ex(1, 255);
+                void *pvRet = RTMemFirstNonZero(pb, cb);
+                if (pvRet != &pb[iNonZero] || RTMemIsZero(pb, cb))
+                    RTTestFailed(g_hTest, "off=%zu cb=%zu iNonZero=%zu: %p, expected %p", off, cb, iNonZero, pvRet, &pb[iNonZero]);
+
+                /* A second non-zero byte further on must not matter. */
+                if (iNonZero + 7 < cb)
+                {
+                    pb[iNonZero + 7] = 0xff;
+                    pvRet = RTMemFirstNonZero(pb, cb);
+                    if (pvRet != &pb[iNonZero])
+                        RTTestFailed(g_hTest, "off=%zu cb=%zu iNonZero=%zu (2nd): %p, expected %p", off, cb, iNonZero, pvRet, &pb[iNonZero]);
+                    pb[iNonZero + 7] = 0;
+                }
+                pb[iNonZero] = 0;
+            }
+
+            pb[-1] = 0;
+            pb[cb] = 0;
+            if (RTTestErrorCount(g_hTest) > 8)
+                return;
+        }
+
+    /* Large blocks with random data. */
+    for (unsigned iRun = 0; iRun < 256; iRun++)
+    {
+        size_t const off = RTRandU32Ex(1, 63);
+        size_t const cb  = RTRandU32Ex(0, (uint32_t)(cbBuf - off - 1));
+        size_t const iNz = RTRandU32Ex(0, (uint32_t)cbBuf - 1);
+        pbBuf[iNz] = 0x42;
+        RTTESTI_CHECK(RTMemFirstNonZero(&pbBuf[off], cb) == tstRefFirstNonZero(&pbBuf[off], cb));
+        pbBuf[iNz] = 0;
+    }
+}
+
+
+/**
+ * Measures the throughput of an expression for about 1/4 second, setting
+ * cMBPerSec and accumulating the results in uDummy.
+ */
+#define TST_MEASURE(a_Expr, a_cb) \
+    do { \
+        uint64_t const cNsTarget = RT_NS_1SEC / 4; \
+        uint64_t       cBytes    = 0; \
+        uint64_t const nsStart   = RTTimeNanoTS(); \
+        uint64_t       cNsElapsed; \
+        do \
+        { \
+            for (unsigned iInner = 0; iInner < 64; iInner++) \
+                uDummy += (uintptr_t)(a_Expr); \
+            cBytes += (uint64_t)(a_cb) * 64; \
+            cNsElapsed = RTTimeNanoTS() - nsStart; \
+        } while (cNsElapsed < cNsTarget); \
+        cMBPerSec = cBytes * RT_NS_1SEC / cNsElapsed / _1M; \
+    } while (0)
+
+
+/**
+ * Benchmarks the zero checking alternatives on all zero blocks (worst case),
+ * with the C runtime memchr, memcmp and strlen as a point of reference.
+ */
+static void tstBenchmark(uint8_t *pbBuf, size_t cbBuf)
+{
+    static size_t const s_acbSizes[] = { 64, 512, PAGE_SIZE, _64K, _1M };
+    uint64_t            uDummy = 0;
+    uint64_t            cMBPerSec;
+
+    RTTestSub(g_hTest, "Benchmark");
+    memset(pbBuf, 0, cbBuf);
+    for (unsigned i = 0; i < RT_ELEMENTS(s_acbSizes); i++)
+    {
+        size_t const cb = s_acbSizes[i];
+
+        TST_MEASURE(RTMemIsZero(pbBuf, cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "RTMemIsZero, %7zu bytes", cb);
+        TST_MEASURE(ASMMemIsAll8(pbBuf, cb, 0), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "ASMMemIsAll8, %7zu bytes", cb);
+        TST_MEASURE(ASMBitFirstSet(pbBuf, (uint32_t)cb * 8), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "ASMBitFirstSet, %7zu bytes", cb);
+        if (cb == PAGE_SIZE)
+        {
+            TST_MEASURE(ASMMemIsZeroPage(pbBuf), cb);
+            RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "ASMMemIsZeroPage, %7zu bytes", cb);
+        }
+
+        TST_MEASURE(memchr(pbBuf, 0x01, cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "memchr, %7zu bytes", cb);
+        TST_MEASURE(memcmp(pbBuf, &pbBuf[cbBuf / 2], cb), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "memcmp, %7zu bytes", cb);
+        memset(pbBuf, 'a', cb);
+        pbBuf[cb - 1] = '\0';
+        TST_MEASURE(strlen((const char *)pbBuf), cb);
+        RTTestValueF(g_hTest, cMBPerSec, RTTESTUNIT_MEGABYTES_PER_SEC, "strlen, %7zu bytes", cb);
+        memset(pbBuf, 0, cb);
+    }
+    RTTestPrintf(g_hTest, RTTESTLVL_DEBUG, "uDummy=%#llx\n", uDummy);
+}
+
+
+int main()
+{
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstRTMemFirstNonZero", &g_hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(g_hTest);
+
+    size_t const cbBuf = _2M + PAGE_SIZE;
+    uint8_t     *pbBuf = (uint8_t *)RTMemPageAlloc(cbBuf);
+    if (pbBuf)
+    {
+        tstCompare(pbBuf, _64K);
+        if (!RTTestErrorCount(g_hTest))
+            tstBenchmark(pbBuf, cbBuf);
+
+        RTMemPageFree(pbBuf, cbBuf);
+    }
+    else
+        RTTestFailed(g_hTest, "Out of memory");
+
+    return RTTestSummaryAndDestroy(g_hTest);
+}
+
@@ -30,7 +30,9 @@
 *******************************************************************************/
 #include <iprt/req.h>
 
+#include <iprt/asm.h>
 #include <iprt/err.h>
+#include <iprt/mp.h>
 #include <iprt/test.h>
 #include <iprt/thread.h>
 #include <iprt/time.h>
@@ -41,6 +43,8 @@
 *   Global Variables                                                           *
 *******************************************************************************/
 static RTTEST g_hTest = NIL_RTTEST;
+/** Request counter for the throughput benchmark. */
+static uint32_t volatile g_cReqsDone = 0;
 
 
 static DECLCALLBACK(int) NopCallback(void)
@@ -48,6 +52,17 @@ static DECLCALLBACK(int) NopCallback(void)
     return VINF_SUCCESS;
 }
 
+static DECLCALLBACK(int) CountCallback(void *pvUser)
+{
+    ASMAtomicIncU32((uint32_t volatile *)pvUser);
+    return VINF_SUCCESS;
+}
+
+static DECLCALLBACK(int) FailOnNonZeroCallback(void *pvUser)
+{
+    return *(uint32_t *)pvUser ? VERR_INVALID_PARAMETER : VINF_SUCCESS;
+}
+
 static void test1(void)
 {
     RTTestISub("Basics");
@@ -132,6 +147,134 @@ static void test2(void)
 }
 
 
+static void test3(void)
+{
+    RTTestISub("Batch submission");
+
+    RTREQPOOL hPool;
+    RTTESTI_CHECK_RC_RETV(RTReqPoolCreate(4, RT_MS_1SEC, 2, 500, "test3", &hPool), VINF_SUCCESS);
+
+    /* Every call must be made exactly once. */
+    static uint32_t s_acCalls[1000];
+    static void    *s_apvArgs[1000];
+    for (unsigned i = 0; i < RT_ELEMENTS(s_acCalls); i++)
+    {
+        s_acCalls[i] = 0;
+        s_apvArgs[i] = &s_acCalls[i];
+    }
+    RTTESTI_CHECK_RC(RTReqPoolCallBatchWait(hPool, (PFNRT)CountCallback, RT_ELEMENTS(s_apvArgs), s_apvArgs), VINF_SUCCESS);
+    for (unsigned i = 0; i < RT_ELEMENTS(s_acCalls); i++)
+        if (s_acCalls[i] != 1)
+        {
+            RTTestIFailed("s_acCalls[%u]=%u\n", i, s_acCalls[i]);
+            break;
+        }
+    RTTESTI_CHECK(RTReqPoolGetStat(hPool, RTREQPOOLSTAT_REQUESTS_PROCESSED) == RT_ELEMENTS(s_acCalls));
+    RTTESTI_CHECK(RTReqPoolGetStat(hPool, RTREQPOOLSTAT_REQUESTS_SUBMITTED) == RT_ELEMENTS(s_acCalls));
+    RTTESTI_CHECK(RTReqPoolGetStat(hPool, RTREQPOOLSTAT_REQUESTS_PENDING) == 0);
+    RTTESTI_CHECK(RTReqPoolGetStat(hPool, RTREQPOOLSTAT_NS_P50_REQ_QUEUED) <= RTReqPoolGetStat(hPool, RTREQPOOLSTAT_NS_P99_REQ_QUEUED));
+    RTTESTI_CHECK(RTReqPoolGetStat(hPool, RTREQPOOLSTAT_NS_MAX_REQ_QUEUED) >= RTReqPoolGetStat(hPool, RTREQPOOLSTAT_NS_AVERAGE_REQ_QUEUED));
+
+    /* The first failure status is passed up. */
+    for (unsigned i = 0; i < RT_ELEMENTS(s_acCalls); i++)
+        s_acCalls[i] = i == 500;
+    RTTESTI_CHECK_RC(RTReqPoolCallBatchWait(hPool, (PFNRT)FailOnNonZeroCallback, RT_ELEMENTS(s_apvArgs), s_apvArgs),
+                     VERR_INVALID_PARAMETER);
+
+    /* Batches without waiting. */
+    uint32_t volatile cCalls = 0;
+    for (unsigned i = 0; i < RT_ELEMENTS(s_apvArgs); i++)
+        s_apvArgs[i] = (void *)&cCalls;
+    RTTESTI_CHECK_RC(RTReqPoolCallBatch(hPool, 0, NULL, RTREQFLAGS_IPRT_STATUS | RTREQFLAGS_NO_WAIT,
+                                        (PFNRT)CountCallback, RT_ELEMENTS(s_apvArgs), s_apvArgs), VINF_SUCCESS);
+    for (unsigned i = 0; i < 1000 && ASMAtomicReadU32(&cCalls) < RT_ELEMENTS(s_apvArgs); i++)
+        RTThreadSleep(10);
+    RTTESTI_CHECK(cCalls == RT_ELEMENTS(s_apvArgs));
+
+    RTTESTI_CHECK(RTReqPoolRelease(hPool) == 0);
+}
+
+
+/** Arguments for the throughput benchmark submitter threads. */
+typedef struct TST4ARGS
+{
+    RTREQPOOL   hPool;
+    uint32_t    cReqs;
+    bool        fBatch;
+} TST4ARGS;
+
+static DECLCALLBACK(int) test4Submitter(RTTHREAD hThreadSelf, void *pvUser)
+{
+    TST4ARGS const *pArgs = (TST4ARGS const *)pvUser;
+    NOREF(hThreadSelf);
+
+    if (!pArgs->fBatch)
+    {
+        for (uint32_t i = 0; i < pArgs->cReqs; i++)
+        {
+            int rc = RTReqPoolCallNoWait(pArgs->hPool, (PFNRT)CountCallback, 1, &g_cReqsDone);
+            if (RT_FAILURE(rc))
+                return rc;
+        }
+    }
+    else
+    {
+        void *apvArgs[64];
+        for (unsigned i = 0; i < RT_ELEMENTS(apvArgs); i++)
+            apvArgs[i] = (void *)&g_cReqsDone;
+        for (uint32_t i = 0; i < pArgs->cReqs; i += RT_ELEMENTS(apvArgs))
+        {
+            int rc = RTReqPoolCallBatch(pArgs->hPool, 0, NULL, RTREQFLAGS_IPRT_STATUS | RTREQFLAGS_NO_WAIT, (PFNRT)CountCallback,
+                                        RT_MIN(RT_ELEMENTS(apvArgs), pArgs->cReqs - i), apvArgs);
+            if (RT_FAILURE(rc))
+                return rc;
+        }
+    }
+    return VINF_SUCCESS;
+}
+
+static void test4(uint32_t cWorkers, uint32_t cSubmitters, bool fBatch)
+{
+    RTTestISubF("Throughput, %u workers, %u submitters%s", cWorkers, cSubmitters, fBatch ? ", batched" : "");
+
+    RTREQPOOL hPool;
+    RTTESTI_CHECK_RC_RETV(RTReqPoolCreate(cWorkers, RT_MS_1SEC, UINT32_MAX, 0, "test4", &hPool), VINF_SUCCESS);
+
+    TST4ARGS Args;
+    Args.hPool  = hPool;
+    Args.cReqs  = 200000 / cSubmitters;
+    Args.fBatch = fBatch;
+    uint32_t const cTotal = Args.cReqs * cSubmitters;
+    ASMAtomicWriteU32(&g_cReqsDone, 0);
+
+    RTTHREAD ahThreads[64];
+    uint64_t const nsStart = RTTimeNanoTS();
+    for (uint32_t i = 0; i < cSubmitters; i++)
+        RTTESTI_CHECK_RC_OK(RTThreadCreate(&ahThreads[i], test4Submitter, &Args, 0, RTTHREADTYPE_DEFAULT,
+                                           RTTHREADFLAGS_WAITABLE, "submitter"));
+    for (uint32_t i = 0; i < cSubmitters; i++)
+    {
+        int rcThread = VERR_IPE_UNINITIALIZED_STATUS;
+        RTTESTI_CHECK_RC_OK(RTThreadWait(ahThreads[i], RT_MS_1MIN, &rcThread));
+        RTTESTI_CHECK_RC_OK(rcThread);
+    }
+    while (   ASMAtomicReadU32(&g_cReqsDone) < cTotal
+           && RTTimeNanoTS() - nsStart < RT_NS_1MIN)
+        RTThreadSleep(1);
+    uint64_t const cNsElapsed = RTTimeNanoTS() - nsStart;
+    RTTESTI_CHECK(g_cReqsDone == cTotal);
+
+    RTTestIValue("throughput",          (uint64_t)cTotal * RT_NS_1SEC / RT_MAX(cNsElapsed, 1), RTTESTUNIT_CALLS_PER_SEC);
+    RTTestIValue("stolen",              RTReqPoolGetStat(hPool, RTREQPOOLSTAT_REQUESTS_STOLEN), RTTESTUNIT_CALLS);
+    RTTestIValue("max queue depth",     RTReqPoolGetStat(hPool, RTREQPOOLSTAT_REQUESTS_PENDING_MAX), RTTESTUNIT_CALLS);
+    RTTestIValue("queued p50",          RTReqPoolGetStat(hPool, RTREQPOOLSTAT_NS_P50_REQ_QUEUED), RTTESTUNIT_NS);
+    RTTestIValue("queued p99",          RTReqPoolGetStat(hPool, RTREQPOOLSTAT_NS_P99_REQ_QUEUED), RTTESTUNIT_NS);
+    RTTestIValue("queued max",          RTReqPoolGetStat(hPool, RTREQPOOLSTAT_NS_MAX_REQ_QUEUED), RTTESTUNIT_NS);
+
+    RTTESTI_CHECK(RTReqPoolRelease(hPool) == 0);
+}
+
+
 int main()
 {
     RTEXITCODE rcExit = RTTestInitAndCreate("tstRTReqPool", &g_hTest);
@@ -143,6 +286,13 @@ int main()
     if (RTTestIErrorCount() == 0)
     {
         test2();
+        test3();
+
+        uint32_t const cCpus = RT_MIN(RT_MAX(RTMpGetCount(), 1), 32);
+        test4(RT_MAX(cCpus, 2), 1, false);
+        test4(RT_MAX(cCpus, 2), 1, true);
+        test4(RT_MAX(cCpus, 2), cCpus * 2, false);
+        test4(RT_MAX(cCpus, 2), cCpus * 2, true);
     }
     return RTTestSummaryAndDestroy(g_hTest);
 }
@@ -30,9 +30,13 @@
 #include <iprt/sort.h>
 
 #include <iprt/err.h>
+#include <iprt/mem.h>
+#include <iprt/mp.h>
 #include <iprt/rand.h>
+#include <iprt/req.h>
 #include <iprt/string.h>
 #include <iprt/test.h>
+#include <iprt/time.h>
 
 
 /*******************************************************************************
@@ -45,6 +49,24 @@ typedef struct TSTRTSORTAPV
     size_t      cElements;
 } TSTRTSORTAPV;
 
+/** An odd sized element for testing the variable sized element sorters. */
+typedef struct TSTRTSORTELEM
+{
+    /** The sort key. */
+    uint32_t    uKey;
+    /** The original position, for checking stability. */
+    uint32_t    iOrg;
+    /** Padding to make it 12 bytes. */
+    uint16_t    u16Pad;
+} TSTRTSORTELEM;
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** Request pool for the parallel sorters. */
+static RTREQPOOL g_hPool = NIL_RTREQPOOL;
+
 
 static DECLCALLBACK(int) testApvCompare(void const *pvElement1, void const *pvElement2, void *pvUser)
 {
@@ -92,6 +114,212 @@ static void testApvSorter(FNRTSORTAPV pfnSorter, const char *pszName)
 }
 
 
+
+static DECLCALLBACK(void) testApvStable(void **papvArray, size_t cElements, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    RTTESTI_CHECK_RC(RTSortApvStable(papvArray, cElements, pfnCmp, pvUser), VINF_SUCCESS);
+}
+
+
+static DECLCALLBACK(void) testStable(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    RTTESTI_CHECK_RC(RTSortStable(pvArray, cElements, cbElement, pfnCmp, pvUser), VINF_SUCCESS);
+}
+
+
+static DECLCALLBACK(void) testParallel(void *pvArray, size_t cElements, size_t cbElement, PFNRTSORTCMP pfnCmp, void *pvUser)
+{
+    RTTESTI_CHECK_RC(RTSortParallel(g_hPool, pvArray, cElements, cbElement, pfnCmp, pvUser), VINF_SUCCESS);
+}
+
+
+static DECLCALLBACK(int) testElemCompare(void const *pvElement1, void const *pvElement2, void *pvUser)
+{
+    TSTRTSORTELEM const *pElem1 = (TSTRTSORTELEM const *)pvElement1;
+    TSTRTSORTELEM const *pElem2 = (TSTRTSORTELEM const *)pvElement2;
+    NOREF(pvUser);
+
+    if (pElem1->uKey < pElem2->uKey)
+        return -1;
+    if (pElem1->uKey > pElem2->uKey)
+        return 1;
+    return 0;
+}
+
+
+/**
+ * Sorts and verifies one array of odd sized elements.
+ *
+ * @returns true on success, false on failure (already reported).
+ */
+static bool testSorterOne(PFNRTSORT pfnSorter, bool fStable, TSTRTSORTELEM *paElems, uint8_t *pbSeen, size_t cElements,
+                          const char *pszPattern)
+{
+    pfnSorter(paElems, cElements, sizeof(paElems[0]), testElemCompare, NULL);
+
+    if (!RTSortIsSorted(paElems, cElements, sizeof(paElems[0]), testElemCompare, NULL))
+    {
+        RTTestIFailed("failed sorting %zu %s elements", cElements, pszPattern);
+        return false;
+    }
+
+    /* Must still be a permutation of the input, and with equal keys in the
+       original order for the stable sorters. */
+    memset(pbSeen, 0, cElements);
+    for (size_t i = 0; i < cElements; i++)
+    {
+        uint32_t const iOrg = paElems[i].iOrg;
+        if (iOrg >= cElements || pbSeen[iOrg] || paElems[i].u16Pad != (uint16_t)~iOrg)
+        {
+            RTTestIFailed("%s elements: bad element at %zu/%zu: iOrg=%u", pszPattern, i, cElements, iOrg);
+            return false;
+        }
+        pbSeen[iOrg] = 1;
+        if (   fStable
+            && i > 0
+            && paElems[i - 1].uKey == paElems[i].uKey
+            && paElems[i - 1].iOrg > iOrg)
+        {
+            RTTestIFailed("%s elements: not stable at %zu/%zu", pszPattern, i, cElements);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static void testSorter(PFNRTSORT pfnSorter, bool fStable, const char *pszName)
+{
+    RTTestISub(pszName);
+
+    RTRAND hRand;
+    RTTESTI_CHECK_RC_OK_RETV(RTRandAdvCreateParkMiller(&hRand));
+
+    static size_t const s_acLarge[] = { 4096, 16383, 16384, 65536, 65537, 100000 + 17 };
+    size_t const        cMax        = s_acLarge[RT_ELEMENTS(s_acLarge) - 1];
+    TSTRTSORTELEM      *paElems     = (TSTRTSORTELEM *)RTMemAlloc(cMax * sizeof(paElems[0]));
+    uint8_t            *pbSeen      = (uint8_t *)RTMemAlloc(cMax);
+    RTTESTI_CHECK_RETV(paElems && pbSeen);
+
+    for (size_t iSize = 0; iSize < 512 + RT_ELEMENTS(s_acLarge); iSize++)
+    {
+        size_t const cElements = iSize < 512 ? iSize : s_acLarge[iSize - 512];
+        for (unsigned iPattern = 0; iPattern < 5; iPattern++)
+        {
+            static const char * const s_apszPatterns[] = { "random", "duplicate", "sorted", "reversed", "equal" };
+            for (size_t i = 0; i < cElements; i++)
+            {
+                switch (iPattern)
+                {
+                    case 0: paElems[i].uKey = RTRandAdvU32(hRand); break;
+                    case 1: paElems[i].uKey = RTRandAdvU32Ex(hRand, 0, (uint32_t)(cElements / 8)); break;
+                    case 2: paElems[i].uKey = (uint32_t)i; break;
+                    case 3: paElems[i].uKey = (uint32_t)(cElements - i); break;
+                    case 4: paElems[i].uKey = 42; break;
+                }
+                paElems[i].iOrg   = (uint32_t)i;
+                paElems[i].u16Pad = (uint16_t)~i;
+            }
+            if (!testSorterOne(pfnSorter, fStable, paElems, pbSeen, cElements, s_apszPatterns[iPattern]))
+            {
+                iSize = ~(size_t)0 / 2;
+                break;
+            }
+        }
+    }
+
+    RTMemFree(paElems);
+    RTMemFree(pbSeen);
+    RTRandAdvDestroy(hRand);
+}
+
+
+static DECLCALLBACK(int) testU32Compare(void const *pvElement1, void const *pvElement2, void *pvUser)
+{
+    uint32_t const u1 = *(uint32_t const *)pvElement1;
+    uint32_t const u2 = *(uint32_t const *)pvElement2;
+    NOREF(pvUser);
+    return u1 < u2 ? -1 : u1 > u2 ? 1 : 0;
+}
+
+
+/**
+ * RTSortApvParallel, testApvSorter doesn't go big enough to use the pool.
+ */
+static void testApvParallel(void)
+{
+    RTTestISub("RTSortApvParallel - parallel merge sort, pointer array");
+
+    RTRAND hRand;
+    RTTESTI_CHECK_RC_OK_RETV(RTRandAdvCreateParkMiller(&hRand));
+    size_t const cElements = 100000;
+    uint32_t    *pau32     = (uint32_t *)RTMemAlloc(cElements * sizeof(uint32_t));
+    void       **papv      = (void **)RTMemAlloc(cElements * sizeof(void *));
+    RTTESTI_CHECK_RETV(pau32 && papv);
+    for (size_t i = 0; i < cElements; i++)
+    {
+        pau32[i] = RTRandAdvU32Ex(hRand, 0, 1000);
+        papv[i]  = &pau32[i];
+    }
+
+    RTTESTI_CHECK_RC(RTSortApvParallel(g_hPool, papv, cElements, testU32Compare, NULL), VINF_SUCCESS);
+    RTTESTI_CHECK(RTSortApvIsSorted(papv, cElements, testU32Compare, NULL));
+    for (size_t i = 1; i < cElements; i++)
+        if (*(uint32_t *)papv[i - 1] == *(uint32_t *)papv[i] && papv[i - 1] > papv[i])
+        {
+            RTTestIFailed("not stable at %zu", i);
+            break;
+        }
+
+    RTMemFree(pau32);
+    RTMemFree(papv);
+    RTRandAdvDestroy(hRand);
+}
+
+
+/**
+ * Compares the throughput of the sorters on random uint32_t arrays.
+ */
+static void testBenchmark(size_t cElements)
+{
+    RTTestISubF("Benchmark, %zu elements", cElements);
+
+    RTRAND hRand;
+    RTTESTI_CHECK_RC_OK_RETV(RTRandAdvCreateParkMiller(&hRand));
+    uint32_t *pau32Input = (uint32_t *)RTMemAlloc(cElements * sizeof(uint32_t));
+    uint32_t *pau32      = (uint32_t *)RTMemAlloc(cElements * sizeof(uint32_t));
+    RTTESTI_CHECK_RETV(pau32Input && pau32);
+    for (size_t i = 0; i < cElements; i++)
+        pau32Input[i] = RTRandAdvU32(hRand);
+
+    static const struct
+    {
+        PFNRTSORT   pfnSorter;
+        const char *pszName;
+    } s_aSorters[] =
+    {
+        { RTSortShell,  "RTSortShell" },
+        { RTSort,       "RTSort" },
+        { testStable,   "RTSortStable" },
+        { testParallel, "RTSortParallel" },
+    };
+    for (unsigned iSorter = 0; iSorter < RT_ELEMENTS(s_aSorters); iSorter++)
+    {
+        memcpy(pau32, pau32Input, cElements * sizeof(uint32_t));
+        uint64_t const nsStart = RTTimeNanoTS();
+        s_aSorters[iSorter].pfnSorter(pau32, cElements, sizeof(uint32_t), testU32Compare, NULL);
+        uint64_t const cNsElapsed = RTTimeNanoTS() - nsStart;
+        RTTESTI_CHECK(RTSortIsSorted(pau32, cElements, sizeof(uint32_t), testU32Compare, NULL));
+        RTTestIValueF((uint64_t)cElements * RT_NS_1SEC / RT_MAX(cNsElapsed, 1), RTTESTUNIT_OCCURRENCES_PER_SEC,
+                      "%s, %zu elements", s_aSorters[iSorter].pszName, cElements);
+    }
+
+    RTMemFree(pau32Input);
+    RTMemFree(pau32);
+    RTRandAdvDestroy(hRand);
+}
+
+
 int main()
 {
     RTTEST hTest;
@@ -104,6 +332,32 @@ int main()
      * Test the different algorithms.
      */
     testApvSorter(RTSortApvShell, "RTSortApvShell - shell sort, pointer array");
+    testApvSorter(RTSortApv, "RTSortApv - introsort, pointer array");
+    testApvSorter(testApvStable, "RTSortApvStable - merge sort, pointer array");
+
+    testSorter(RTSortShell, false /*fStable*/, "RTSortShell - shell sort");
+    testSorter(RTSort, false /*fStable*/, "RTSort - introsort");
+    testSorter(testStable, true /*fStable*/, "RTSortStable - merge sort");
+
+    /*
+     * The parallel sorters need a pool.
+     */
+    RTTestISub("RTReqPoolCreate");
+    RTTESTI_CHECK_RC(rc = RTReqPoolCreate(RT_MAX(RTMpGetOnlineCount(), 2), RT_MS_1SEC, UINT32_MAX, 0, "sort", &g_hPool),
+                     VINF_SUCCESS);
+    if (RT_SUCCESS(rc))
+    {
+        testSorter(testParallel, true /*fStable*/, "RTSortParallel - parallel merge sort");
+        testApvParallel();
+    }
+
+    /*
+     * Throughput.
+     */
+    testBenchmark(_64K);
+    testBenchmark(_1M);
+
+    RTReqPoolRelease(g_hPool);
 
     /*
      * Summary.
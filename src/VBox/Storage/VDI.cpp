@@ -1255,15 +1255,15 @@ static void *vdiAllocationBitmapCreate(void *pvData, size_t cbData)
 
     while (uSectorCur < cSectors)
     {
-        int idxSet = ASMBitFirstSet((uint8_t *)pvData + uSectorCur * 512, (uint32_t)cbData * 8);
+        uint8_t *pbCur = (uint8_t *)pvData + uSectorCur * 512;
+        uint8_t *pbSet = (uint8_t *)RTMemFirstNonZero(pbCur, cbData - uSectorCur * 512);
 
-        if (idxSet != -1)
+        if (pbSet)
         {
-            unsigned idxSectorAlloc = idxSet / 8 / 512;
+            unsigned idxSectorAlloc = (unsigned)((pbSet - pbCur) / 512);
             ASMBitSet(pbmAllocationBitmap, uSectorCur + idxSectorAlloc);
 
             uSectorCur += idxSectorAlloc + 1;
-            cbData     -= (idxSectorAlloc + 1) * 512;
         }
         else
             break;
@@ -2499,7 +2499,7 @@ static int vdiCompact(void *pBackendData, unsigned uPercentStart,
                 if (RT_FAILURE(rc))
                     break;
 
-                if (ASMBitFirstSet((volatile void *)pvTmp, (uint32_t)cbBlock * 8) == -1)
+                if (RTMemIsZero(pvTmp, cbBlock))
                 {
                     pImage->paBlocks[i] = VDI_IMAGE_BLOCK_ZERO;
                     rc = vdiUpdateBlockInfo(pImage, i);
@@ -2954,7 +2954,7 @@ static DECLCALLBACK(int) vdiDiscard(void *pBackendData, PVDIOCTX pIoCtx,
 
                 Assert(!(cbDiscard % 4));
                 Assert(getImageBlockSize(&pImage->Header) * 8 <= UINT32_MAX);
-                if (ASMBitFirstSet((volatile void *)pbBlockData, getImageBlockSize(&pImage->Header) * 8) == -1)
+                if (RTMemIsZero(pbBlockData, getImageBlockSize(&pImage->Header)))
                     rc = vdiDiscardBlockAsync(pImage, pIoCtx, uBlock, pvBlock);
                 else
                 {
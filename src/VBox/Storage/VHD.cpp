@@ -2528,7 +2528,7 @@ static int vhdCompact(void *pBackendData, unsigned uPercentStart,
                 if (RT_FAILURE(rc))
                     break;
 
-                if (ASMBitFirstSet((volatile void *)pvBuf, (uint32_t)pImage->cbDataBlock * 8) == -1)
+                if (RTMemIsZero(pvBuf, pImage->cbDataBlock))
                 {
                     paBat[i] = ~0;
                     paBlocks[idxBlock] = ~0U;
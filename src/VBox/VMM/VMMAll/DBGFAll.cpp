@@ -24,6 +24,8 @@
 #include "DBGFInternal.h"
 #include <VBox/vmm/vm.h>
 #include <VBox/err.h>
+#include <iprt/asm.h>
+#include <iprt/asm-amd64-x86.h>
 #include <iprt/assert.h>
 
 
@@ -265,3 +267,41 @@ VMM_INT_DECL(bool) DBGFIsStepping(PVMCPU pVCpu)
     return pVCpu->dbgf.s.fSingleSteppingRaw;
 }
 
+
+/**
+ * Adds an entry to the exit trace ring of a virtual CPU.
+ *
+ * Use the VMM_EXIT_TRACE_START / VMM_EXIT_TRACE_END macros rather than calling
+ * this directly.
+ *
+ * @param   pVCpu       Pointer to the VMCPU of the calling EMT.
+ * @param   enmSrc      The event source.
+ * @param   uReason     Source specific reason.
+ * @param   uRip        The guest RIP.
+ * @param   uAddr       Source specific address.
+ * @param   idHandler   The PDM tracing ID of the handling device, 0 if none.
+ * @param   u64TscStart The TSC when the handling started.
+ */
+VMM_INT_DECL(void) DBGFExitTraceAdd(PVMCPU pVCpu, DBGFEXITSRC enmSrc, uint32_t uReason, uint64_t uRip, uint64_t uAddr,
+                                    uint32_t idHandler, uint64_t u64TscStart)
+{
+    PDBGFEXITTRACERING pRing = pVCpu->dbgf.s.CTX_SUFF(pExitTrace);
+    if (!pRing)
+        return;
+    VMCPU_ASSERT_EMT(pVCpu);
+
+    uint64_t const      cAdded = pRing->cAdded;
+    PDBGFEXITTRACEENTRY pEntry = &pRing->aEntries[cAdded & pRing->fMask];
+    uint64_t const      cTicks = ASMReadTSC() - u64TscStart;
+    pEntry->u64Tsc      = u64TscStart;
+    pEntry->uRip        = uRip;
+    pEntry->uAddr       = uAddr;
+    pEntry->cTicks      = cTicks <= UINT32_MAX ? (uint32_t)cTicks : UINT32_MAX;
+    pEntry->uReason     = (uint16_t)uReason;
+    pEntry->enmSrc      = (uint8_t)enmSrc;
+    pEntry->bReserved   = 0;
+    pEntry->idHandler   = idHandler;
+    pEntry->u32Reserved = 0;
+    ASMAtomicWriteU64(&pRing->cAdded, cAdded + 1);
+}
+
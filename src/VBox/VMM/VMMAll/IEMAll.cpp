@@ -91,6 +91,7 @@
 #include <VBox/vmm/tm.h>
 #include <VBox/vmm/dbgf.h>
 #include <VBox/vmm/dbgftrace.h>
+#include "VMMTracing.h"
 #ifdef VBOX_WITH_RAW_MODE_NOT_R0
 # include <VBox/vmm/patm.h>
 # if defined(VBOX_WITH_CALL_RECORD) || defined(REM_MONITOR_CODE_PAGES)
@@ -919,19 +920,62 @@ DECLINLINE(void) iemInitDecoder(PIEMCPU pIemCpu, bool fBypassHandlers)
 }
 
 
+/**
+ * Flushes the decoded instruction cache.
+ *
+ * @param   pIemCpu             The IEM state.
+ */
+static void iemDecodeCacheFlush(PIEMCPU pIemCpu)
+{
+    for (unsigned i = 0; i < RT_ELEMENTS(pIemCpu->aDecodeCache); i++)
+        pIemCpu->aDecodeCache[i].GCPhys = NIL_RTGCPHYS;
+    pIemCpu->GCPhysDecodeFill = NIL_RTGCPHYS;
+    pIemCpu->cDecodeCacheFlushes++;
+}
+
+
+/**
+ * Adds the instruction that was just executed to the decoded instruction cache.
+ *
+ * @param   pIemCpu             The IEM state.
+ */
+static void iemDecodeCacheFill(PIEMCPU pIemCpu)
+{
+    RTGCPHYS const  GCPhys  = pIemCpu->GCPhysDecodeFill;
+    uint8_t const   cbInstr = pIemCpu->offOpcode;
+    pIemCpu->GCPhysDecodeFill = NIL_RTGCPHYS;
+
+    /* Only instructions that were read from a single page. */
+    if (   cbInstr > 0
+        && cbInstr <= pIemCpu->cbOpcode
+        && (GCPhys & PAGE_OFFSET_MASK) + cbInstr <= PAGE_SIZE)
+    {
+        PIEMDECODECACHEENTRY pEntry = &pIemCpu->aDecodeCache[IEM_DECODE_CACHE_IDX(GCPhys)];
+        pEntry->GCPhys     = GCPhys;
+        pEntry->uWriteGen  = pIemCpu->uDecodeFillWriteGen;
+        pEntry->enmCpuMode = pIemCpu->enmDecodeFillCpuMode;
+        pEntry->cbInstr    = cbInstr;
+        memcpy(pEntry->abOpcode, pIemCpu->abOpcode, cbInstr);
+    }
+}
+
+
 /**
  * Prefetch opcodes the first time when starting executing.
  *
  * @returns Strict VBox status code.
  * @param   pIemCpu             The IEM state.
  * @param   fBypassHandlers     Whether to bypass access handlers.
+ * @param   fUseDecodeCache     Whether to consult the decoded instruction cache
+ *                              and prepare for adding the instruction to it.
  */
-static VBOXSTRICTRC iemInitDecoderAndPrefetchOpcodes(PIEMCPU pIemCpu, bool fBypassHandlers)
+static VBOXSTRICTRC iemInitDecoderAndPrefetchOpcodes(PIEMCPU pIemCpu, bool fBypassHandlers, bool fUseDecodeCache)
 {
 #ifdef IEM_VERIFICATION_MODE_FULL
     uint8_t const cbOldOpcodes = pIemCpu->cbOpcode;
 #endif
     iemInitDecoder(pIemCpu, fBypassHandlers);
+    pIemCpu->GCPhysDecodeFill = NIL_RTGCPHYS;
 
     /*
      * What we're doing here is very similar to iemMemMap/iemMemBounceBufferMap.
@@ -1000,6 +1044,43 @@ static VBOXSTRICTRC iemInitDecoderAndPrefetchOpcodes(PIEMCPU pIemCpu, bool fBypa
      *        that, so do it when implementing the guest virtual address
      *        TLB... */
 
+    /*
+     * Check the decoded instruction cache.  The entry must be from the same
+     * CPU mode, the page must not have been written to since, and the whole
+     * instruction must still be within the CS limit.
+     */
+    PVM pVM = IEMCPU_TO_VM(pIemCpu);
+    if (fUseDecodeCache)
+    {
+        uint32_t const              uWriteGen = PGMPhysGetWriteGeneration(pVM, GCPhys);
+        PCIEMDECODECACHEENTRY const pEntry    = &pIemCpu->aDecodeCache[IEM_DECODE_CACHE_IDX(GCPhys)];
+        if (   uWriteGen
+            && pEntry->GCPhys     == GCPhys
+            && pEntry->uWriteGen  == uWriteGen
+            && pEntry->enmCpuMode == (uint8_t)pIemCpu->enmCpuMode
+            && pEntry->cbInstr    <= cbToTryRead)
+        {
+            memcpy(pIemCpu->abOpcode, pEntry->abOpcode, pEntry->cbInstr);
+            pIemCpu->cbOpcode = pEntry->cbInstr;
+            pIemCpu->cDecodeCacheHits++;
+            return VINF_SUCCESS;
+        }
+        pIemCpu->cDecodeCacheMisses++;
+
+        /* Only cache plain RAM without read handlers which PGM tracks writes
+           to, i.e. not while a device has it mapped for writing. */
+        if (PGMPhysIemQueryAccess(pVM, GCPhys, false /*fWritable*/, fBypassHandlers) == VINF_SUCCESS)
+        {
+            uint32_t const uFillWriteGen = PGMPhysIemTagCodePage(pVM, GCPhys);
+            if (uFillWriteGen)
+            {
+                pIemCpu->GCPhysDecodeFill     = GCPhys;
+                pIemCpu->uDecodeFillWriteGen  = uFillWriteGen;
+                pIemCpu->enmDecodeFillCpuMode = (uint8_t)pIemCpu->enmCpuMode;
+            }
+        }
+    }
+
 #ifdef IEM_VERIFICATION_MODE_FULL
     /*
      * Optimistic optimization: Use unconsumed opcode bytes from the previous
@@ -1021,7 +1102,6 @@ static VBOXSTRICTRC iemInitDecoderAndPrefetchOpcodes(PIEMCPU pIemCpu, bool fBypa
     /*
      * Read the bytes at this address.
      */
-    PVM pVM = IEMCPU_TO_VM(pIemCpu);
 #if defined(IN_RING3) && defined(VBOX_WITH_RAW_MODE_NOT_R0)
     size_t cbActual;
     if (   PATMIsEnabled(pVM)
@@ -1030,6 +1110,7 @@ static VBOXSTRICTRC iemInitDecoderAndPrefetchOpcodes(PIEMCPU pIemCpu, bool fBypa
         Log4(("decode - Read %u unpatched bytes at %RGv\n", cbActual, GCPtrPC));
         Assert(cbActual > 0);
         pIemCpu->cbOpcode = (uint8_t)cbActual;
+        pIemCpu->GCPhysDecodeFill = NIL_RTGCPHYS; /* not what's in guest memory */
     }
     else
 #endif
@@ -9644,7 +9725,7 @@ DECL_FORCE_INLINE(VBOXSTRICTRC) iemExecOneInner(PVMCPU pVCpu, PIEMCPU pIemCpu, b
         && VMCPU_FF_IS_SET(pVCpu, VMCPU_FF_INHIBIT_INTERRUPTS)
         && EMGetInhibitInterruptsPC(pVCpu) == pIemCpu->CTX_SUFF(pCtx)->rip )
     {
-        rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, pIemCpu->fBypassHandlers);
+        rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, pIemCpu->fBypassHandlers, false /*fUseDecodeCache*/);
         if (rcStrict == VINF_SUCCESS)
         {
 # ifdef LOG_ENABLED
@@ -9705,6 +9786,8 @@ DECLINLINE(VBOXSTRICTRC) iemRCRawMaybeReenter(PIEMCPU pIemCpu, PVMCPU pVCpu, PCP
 VMMDECL(VBOXSTRICTRC) IEMExecOne(PVMCPU pVCpu)
 {
     PIEMCPU  pIemCpu = &pVCpu->iem.s;
+    uint64_t const uExitTraceTsc = VMM_EXIT_TRACE_START(pVCpu);
+    uint64_t const uRipStart     = pIemCpu->CTX_SUFF(pCtx)->rip;
 
 #if defined(IEM_VERIFICATION_MODE_FULL) && defined(IN_RING3)
     iemExecVerificationModeSetup(pIemCpu);
@@ -9717,7 +9800,7 @@ VMMDECL(VBOXSTRICTRC) IEMExecOne(PVMCPU pVCpu)
     /*
      * Do the decoding and emulation.
      */
-    VBOXSTRICTRC rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, false);
+    VBOXSTRICTRC rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, false, false /*fUseDecodeCache*/);
     if (rcStrict == VINF_SUCCESS)
         rcStrict = iemExecOneInner(pVCpu, pIemCpu, true);
 
@@ -9730,6 +9813,7 @@ VMMDECL(VBOXSTRICTRC) IEMExecOne(PVMCPU pVCpu)
 #ifdef IN_RC
     rcStrict = iemRCRawMaybeReenter(pIemCpu, pVCpu, pIemCpu->CTX_SUFF(pCtx), rcStrict);
 #endif
+    VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_IEM, 1, uRipStart, 0, 0);
     if (rcStrict != VINF_SUCCESS)
         LogFlow(("IEMExecOne: cs:rip=%04x:%08RX64 ss:rsp=%04x:%08RX64 EFL=%06x - rcStrict=%Rrc\n",
                  pCtx->cs.Sel, pCtx->rip, pCtx->ss.Sel, pCtx->rsp, pCtx->eflags.u, VBOXSTRICTRC_VAL(rcStrict)));
@@ -9744,7 +9828,7 @@ VMMDECL(VBOXSTRICTRC)       IEMExecOneEx(PVMCPU pVCpu, PCPUMCTXCORE pCtxCore, ui
     AssertReturn(CPUMCTX2CORE(pCtx) == pCtxCore, VERR_IEM_IPE_3);
 
     uint32_t const cbOldWritten = pIemCpu->cbWritten;
-    VBOXSTRICTRC rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, false);
+    VBOXSTRICTRC rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, false, false /*fUseDecodeCache*/);
     if (rcStrict == VINF_SUCCESS)
     {
         rcStrict = iemExecOneInner(pVCpu, pIemCpu, true);
@@ -9776,7 +9860,7 @@ VMMDECL(VBOXSTRICTRC)       IEMExecOneWithPrefetchedByPC(PVMCPU pVCpu, PCPUMCTXC
         rcStrict = VINF_SUCCESS;
     }
     else
-        rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, false);
+        rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, false, false /*fUseDecodeCache*/);
     if (rcStrict == VINF_SUCCESS)
     {
         rcStrict = iemExecOneInner(pVCpu, pIemCpu, true);
@@ -9796,7 +9880,7 @@ VMMDECL(VBOXSTRICTRC)       IEMExecOneBypassEx(PVMCPU pVCpu, PCPUMCTXCORE pCtxCo
     AssertReturn(CPUMCTX2CORE(pCtx) == pCtxCore, VERR_IEM_IPE_3);
 
     uint32_t const cbOldWritten = pIemCpu->cbWritten;
-    VBOXSTRICTRC rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, true);
+    VBOXSTRICTRC rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, true, false /*fUseDecodeCache*/);
     if (rcStrict == VINF_SUCCESS)
     {
         rcStrict = iemExecOneInner(pVCpu, pIemCpu, false);
@@ -9828,7 +9912,7 @@ VMMDECL(VBOXSTRICTRC)       IEMExecOneBypassWithPrefetchedByPC(PVMCPU pVCpu, PCP
         rcStrict = VINF_SUCCESS;
     }
     else
-        rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, true);
+        rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, true, false /*fUseDecodeCache*/);
     if (rcStrict == VINF_SUCCESS)
         rcStrict = iemExecOneInner(pVCpu, pIemCpu, false);
 
@@ -9839,7 +9923,59 @@ VMMDECL(VBOXSTRICTRC)       IEMExecOneBypassWithPrefetchedByPC(PVMCPU pVCpu, PCP
 }
 
 
-VMMDECL(VBOXSTRICTRC) IEMExecLots(PVMCPU pVCpu)
+/** How often IEMExecLots polls for expired timers (power of two). */
+#define IEM_EXEC_LOTS_TIMER_POLL_RATE   64
+
+
+/**
+ * Checks whether IEMExecLots should stop and return to EM after executing an
+ * instruction.
+ *
+ * @returns true if EM should take over, false to continue.
+ * @param   pVCpu               The current virtual CPU.
+ * @param   pIemCpu             The IEM per CPU data.
+ * @param   pCtx                The guest CPU context.
+ * @param   cInstructions       The number of instructions executed so far.
+ */
+DECLINLINE(bool) iemExecLotsShouldStop(PVMCPU pVCpu, PIEMCPU pIemCpu, PCPUMCTX pCtx, uint32_t cInstructions)
+{
+    PVM pVM = IEMCPU_TO_VM(pIemCpu);
+
+    /* Anything EM needs to service, except interrupts that cannot be delivered yet. */
+    if (VM_FF_IS_PENDING(pVM, VM_FF_ALL_REM_MASK))
+        return true;
+    if (VMCPU_FF_IS_PENDING(pVCpu, VMCPU_FF_ALL_REM_MASK & ~(VMCPU_FF_INTERRUPT_APIC | VMCPU_FF_INTERRUPT_PIC | VMCPU_FF_INHIBIT_INTERRUPTS)))
+        return true;
+    if (   VMCPU_FF_IS_PENDING(pVCpu, VMCPU_FF_INTERRUPT_APIC | VMCPU_FF_INTERRUPT_PIC)
+        && pCtx->eflags.Bits.u1IF
+        && (   !VMCPU_FF_IS_PENDING(pVCpu, VMCPU_FF_INHIBIT_INTERRUPTS)
+            || EMGetInhibitInterruptsPC(pVCpu) != pCtx->rip))
+        return true;
+
+    /* Nobody raises the timer FF for us while we're busy here, so poll. */
+    if (   !(cInstructions & (IEM_EXEC_LOTS_TIMER_POLL_RATE - 1))
+        && TMTimerPollBool(pVM, pVCpu))
+        return true;
+    return false;
+}
+
+
+/**
+ * Executes a batch of instructions.
+ *
+ * The batch ends early when a force action flag requires EM's attention, when
+ * a timer has expired, or when the CPU mode or privilege level changes (so EM
+ * gets a chance to reschedule).
+ *
+ * @returns Strict VBox status code of the last instruction.
+ * @param   pVCpu               The current virtual CPU.
+ * @param   cMaxInstructions    The maximum number of instructions to execute.
+ *                              At least one is always executed.
+ * @param   pcInstructions      Where to return the number of instructions
+ *                              executed, including the one returning a status
+ *                              other than VINF_SUCCESS.  Optional.
+ */
+VMMDECL(VBOXSTRICTRC) IEMExecLots(PVMCPU pVCpu, uint32_t cMaxInstructions, uint32_t *pcInstructions)
 {
     PIEMCPU  pIemCpu = &pVCpu->iem.s;
 
@@ -9867,21 +10003,53 @@ VMMDECL(VBOXSTRICTRC) IEMExecLots(PVMCPU pVCpu)
 #else
     iemExecVerificationModeSetup(pIemCpu);
     PCPUMCTX pCtx = pIemCpu->CTX_SUFF(pCtx);
+    cMaxInstructions = 1; /* the verification is done per instruction */
 #endif
 
-    /*
-     * Log the state.
-     */
+    /* What EM's scheduling decision was based on. */
+    uint64_t const  uExitTraceTsc   = VMM_EXIT_TRACE_START(pVCpu);
+    uint64_t const  uRipStart       = pCtx->rip;
+    uint64_t const  uCr0Start       = pCtx->cr0;
+    uint64_t const  uEferStart      = pCtx->msrEFER;
+    uint32_t const  fCsAttrStart    = pCtx->cs.Attr.u;
+    uint32_t const  fEflVmStart     = pCtx->eflags.u & X86_EFL_VM;
+    uint32_t const  cFlushesStart   = pIemCpu->cDecodeCacheFlushes;
+    uint32_t        cInstructions   = 0;
+    VBOXSTRICTRC    rcStrict;
+    for (;;)
+    {
+        /*
+         * Log the state.
+         */
 #ifdef LOG_ENABLED
-    iemLogCurInstr(pVCpu, pCtx, true);
+        iemLogCurInstr(pVCpu, pCtx, true);
 #endif
 
-    /*
-     * Do the decoding and emulation.
-     */
-    VBOXSTRICTRC rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, false);
-    if (rcStrict == VINF_SUCCESS)
-        rcStrict = iemExecOneInner(pVCpu, pIemCpu, true);
+        /*
+         * Do the decoding and emulation.
+         */
+        rcStrict = iemInitDecoderAndPrefetchOpcodes(pIemCpu, false, true /*fUseDecodeCache*/);
+        if (rcStrict == VINF_SUCCESS)
+        {
+            rcStrict = iemExecOneInner(pVCpu, pIemCpu, true);
+            if (   rcStrict == VINF_SUCCESS
+                && pIemCpu->GCPhysDecodeFill != NIL_RTGCPHYS)
+                iemDecodeCacheFill(pIemCpu);
+        }
+        cInstructions++;
+
+        if (   rcStrict != VINF_SUCCESS
+            || cInstructions >= cMaxInstructions
+            || pCtx->cr0 != uCr0Start
+            || pCtx->msrEFER != uEferStart
+            || pCtx->cs.Attr.u != fCsAttrStart
+            || (pCtx->eflags.u & X86_EFL_VM) != fEflVmStart
+            || pIemCpu->cDecodeCacheFlushes != cFlushesStart
+            || iemExecLotsShouldStop(pVCpu, pIemCpu, pCtx, cInstructions))
+            break;
+    }
+    if (pcInstructions)
+        *pcInstructions = cInstructions;
 
 #if defined(IEM_VERIFICATION_MODE_FULL) && defined(IN_RING3)
     /*
@@ -9896,14 +10064,31 @@ VMMDECL(VBOXSTRICTRC) IEMExecLots(PVMCPU pVCpu)
 #ifdef IN_RC
     rcStrict = iemRCRawMaybeReenter(pIemCpu, pVCpu, pIemCpu->CTX_SUFF(pCtx), rcStrict);
 #endif
+    VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_IEM, cInstructions, uRipStart, 0, 0);
     if (rcStrict != VINF_SUCCESS)
-        LogFlow(("IEMExecOne: cs:rip=%04x:%08RX64 ss:rsp=%04x:%08RX64 EFL=%06x - rcStrict=%Rrc\n",
-                 pCtx->cs.Sel, pCtx->rip, pCtx->ss.Sel, pCtx->rsp, pCtx->eflags.u, VBOXSTRICTRC_VAL(rcStrict)));
+        LogFlow(("IEMExecLots: cs:rip=%04x:%08RX64 ss:rsp=%04x:%08RX64 EFL=%06x - rcStrict=%Rrc (%u instructions)\n",
+                 pCtx->cs.Sel, pCtx->rip, pCtx->ss.Sel, pCtx->rsp, pCtx->eflags.u, VBOXSTRICTRC_VAL(rcStrict), cInstructions));
     return rcStrict;
 }
 
 
 
+/**
+ * Flushes the decoded instruction cache of a virtual CPU.
+ *
+ * This must be called when the guest may have modified code behind IEM's and
+ * PGM's back, i.e. when switching to IEMExecLots after the guest has been
+ * executing natively or in the recompiler.
+ *
+ * @param   pVCpu               The current virtual CPU.
+ * @thread  EMT(pVCpu)
+ */
+VMMDECL(void) IEMDecodeCacheFlush(PVMCPU pVCpu)
+{
+    iemDecodeCacheFlush(&pVCpu->iem.s);
+}
+
+
 /**
  * Injects a trap, fault, abort, software interrupt or external interrupt.
  *
@@ -2894,6 +2894,9 @@ IEM_CIMPL_DEF_1(iemCImpl_iret_long, IEMMODE, enmEffOpSize)
  */
 IEM_CIMPL_DEF_1(iemCImpl_iret, IEMMODE, enmEffOpSize)
 {
+    /* IRET is serializing, drop cached instructions. */
+    iemDecodeCacheFlush(pIemCpu);
+
     /*
      * Call a mode specific worker.
      */
@@ -4071,6 +4074,9 @@ IEM_CIMPL_DEF_2(iemCImpl_load_CrX, uint8_t, iCrReg, uint64_t, uNewCrX)
     VBOXSTRICTRC    rcStrict;
     int             rc;
 
+    /* Control register writes are serializing and may change the paging mode. */
+    iemDecodeCacheFlush(pIemCpu);
+
     /*
      * Try store it.
      * Unfortunately, CPUM only does a tiny bit of the work.
@@ -4596,6 +4602,7 @@ IEM_CIMPL_DEF_1(iemCImpl_invlpg, uint8_t, GCPtrPage)
         return iemRaiseGeneralProtectionFault0(pIemCpu);
     Assert(!pIemCpu->CTX_SUFF(pCtx)->eflags.Bits.u1VM);
 
+    iemDecodeCacheFlush(pIemCpu);
     int rc = PGMInvalidatePage(IEMCPU_TO_VMCPU(pIemCpu), GCPtrPage);
     iemRegAddToRipAndClearRF(pIemCpu, cbInstr);
 
@@ -5123,6 +5130,9 @@ IEM_CIMPL_DEF_0(iemCImpl_cpuid)
 {
     PCPUMCTX pCtx = pIemCpu->CTX_SUFF(pCtx);
 
+    /* CPUID is the canonical serializing instruction used after modifying code. */
+    iemDecodeCacheFlush(pIemCpu);
+
     CPUMGetGuestCpuId(IEMCPU_TO_VMCPU(pIemCpu), pCtx->eax, &pCtx->eax, &pCtx->ebx, &pCtx->ecx, &pCtx->edx);
     pCtx->rax &= UINT32_C(0xffffffff);
     pCtx->rbx &= UINT32_C(0xffffffff);
@@ -33,6 +33,7 @@
 #include <VBox/vmm/pdmdev.h>
 #include <VBox/vmm/pgm.h>
 #include <VBox/vmm/cpum.h>
+#include "VMMTracing.h"
 #include <VBox/err.h>
 #include <VBox/log.h>
 #include <iprt/assert.h>
@@ -256,14 +257,7 @@ VMMDECL(VBOXSTRICTRC) IOMIOPortRead(PVM pVM, PVMCPU pVCpu, RTIOPORT Port, uint32
     /*
      * Get handler for current context.
      */
-    CTX_SUFF(PIOMIOPORTRANGE) pRange = pVCpu->iom.s.CTX_SUFF(pRangeLastRead);
-    if (    !pRange
-        ||   (unsigned)Port - (unsigned)pRange->Port >= (unsigned)pRange->cPorts)
-    {
-        pRange = iomIOPortGetRange(pVM, Port);
-        if (pRange)
-            pVCpu->iom.s.CTX_SUFF(pRangeLastRead) = pRange;
-    }
+    CTX_SUFF(PIOMIOPORTRANGE) pRange = iomIOPortGetRangeCached(pVM, pVCpu, Port, &pVCpu->iom.s.CTX_SUFF(pRangeLastRead));
     MMHYPER_RC_ASSERT_RCPTR(pVM, pRange);
     if (pRange)
     {
@@ -292,6 +286,7 @@ VMMDECL(VBOXSTRICTRC) IOMIOPortRead(PVM pVM, PVMCPU pVCpu, RTIOPORT Port, uint32
             STAM_STATS({ if (pStats) STAM_COUNTER_INC(&pStats->InRZToR3); });
             return rcStrict;
         }
+        uint64_t const uExitTraceTsc = VMM_EXIT_TRACE_START(pVCpu);
 #ifdef VBOX_WITH_STATISTICS
         if (pStats)
         {
@@ -303,6 +298,8 @@ VMMDECL(VBOXSTRICTRC) IOMIOPortRead(PVM pVM, PVMCPU pVCpu, RTIOPORT Port, uint32
 #endif
             rcStrict = pfnInCallback(pDevIns, pvUser, Port, pu32Value, (unsigned)cbValue);
         PDMCritSectLeave(pDevIns->CTX_SUFF(pCritSectRo));
+        VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_IOM_PORT_READ, (uint32_t)cbValue, CPUMGetGuestRIP(pVCpu), Port,
+                           pDevIns->idTracing);
 
 #ifdef VBOX_WITH_STATISTICS
         if (rcStrict == VINF_SUCCESS && pStats)
@@ -421,14 +418,7 @@ VMMDECL(VBOXSTRICTRC) IOMIOPortReadString(PVM pVM, PVMCPU pVCpu, RTIOPORT Port,
     /*
      * Get handler for current context.
      */
-    CTX_SUFF(PIOMIOPORTRANGE) pRange = pVCpu->iom.s.CTX_SUFF(pRangeLastRead);
-    if (    !pRange
-        ||   (unsigned)Port - (unsigned)pRange->Port >= (unsigned)pRange->cPorts)
-    {
-        pRange = iomIOPortGetRange(pVM, Port);
-        if (pRange)
-            pVCpu->iom.s.CTX_SUFF(pRangeLastRead) = pRange;
-    }
+    CTX_SUFF(PIOMIOPORTRANGE) pRange = iomIOPortGetRangeCached(pVM, pVCpu, Port, &pVCpu->iom.s.CTX_SUFF(pRangeLastRead));
     MMHYPER_RC_ASSERT_RCPTR(pVM, pRange);
     if (pRange)
     {
@@ -560,14 +550,7 @@ VMMDECL(VBOXSTRICTRC) IOMIOPortWrite(PVM pVM, PVMCPU pVCpu, RTIOPORT Port, uint3
     /*
      * Get handler for current context.
      */
-    CTX_SUFF(PIOMIOPORTRANGE) pRange = pVCpu->iom.s.CTX_SUFF(pRangeLastWrite);
-    if (    !pRange
-        ||   (unsigned)Port - (unsigned)pRange->Port >= (unsigned)pRange->cPorts)
-    {
-        pRange = iomIOPortGetRange(pVM, Port);
-        if (pRange)
-            pVCpu->iom.s.CTX_SUFF(pRangeLastWrite) = pRange;
-    }
+    CTX_SUFF(PIOMIOPORTRANGE) pRange = iomIOPortGetRangeCached(pVM, pVCpu, Port, &pVCpu->iom.s.CTX_SUFF(pRangeLastWrite));
     MMHYPER_RC_ASSERT_RCPTR(pVM, pRange);
     if (pRange)
     {
@@ -596,6 +579,7 @@ VMMDECL(VBOXSTRICTRC) IOMIOPortWrite(PVM pVM, PVMCPU pVCpu, RTIOPORT Port, uint3
             STAM_STATS({ if (pStats) STAM_COUNTER_INC(&pStats->OutRZToR3); });
             return rcStrict;
         }
+        uint64_t const uExitTraceTsc = VMM_EXIT_TRACE_START(pVCpu);
 #ifdef VBOX_WITH_STATISTICS
         if (pStats)
         {
@@ -607,6 +591,8 @@ VMMDECL(VBOXSTRICTRC) IOMIOPortWrite(PVM pVM, PVMCPU pVCpu, RTIOPORT Port, uint3
 #endif
             rcStrict = pfnOutCallback(pDevIns, pvUser, Port, u32Value, (unsigned)cbValue);
         PDMCritSectLeave(pDevIns->CTX_SUFF(pCritSectRo));
+        VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_IOM_PORT_WRITE, (uint32_t)cbValue, CPUMGetGuestRIP(pVCpu), Port,
+                           pDevIns->idTracing);
 
 #ifdef VBOX_WITH_STATISTICS
         if (rcStrict == VINF_SUCCESS && pStats)
@@ -700,14 +686,7 @@ VMMDECL(VBOXSTRICTRC) IOMIOPortWriteString(PVM pVM, PVMCPU pVCpu, RTIOPORT Port,
     /*
      * Get handler for current context.
      */
-    CTX_SUFF(PIOMIOPORTRANGE) pRange = pVCpu->iom.s.CTX_SUFF(pRangeLastWrite);
-    if (    !pRange
-        ||   (unsigned)Port - (unsigned)pRange->Port >= (unsigned)pRange->cPorts)
-    {
-        pRange = iomIOPortGetRange(pVM, Port);
-        if (pRange)
-            pVCpu->iom.s.CTX_SUFF(pRangeLastWrite) = pRange;
-    }
+    CTX_SUFF(PIOMIOPORTRANGE) pRange = iomIOPortGetRangeCached(pVM, pVCpu, Port, &pVCpu->iom.s.CTX_SUFF(pRangeLastWrite));
     MMHYPER_RC_ASSERT_RCPTR(pVM, pRange);
     if (pRange)
     {
@@ -35,6 +35,7 @@
 #include <VBox/vmm/vm.h>
 #include <VBox/vmm/vmm.h>
 #include <VBox/vmm/hm.h>
+#include "VMMTracing.h"
 #include "IOMInline.h"
 
 #include <VBox/dis.h>
@@ -292,6 +293,7 @@ static int iomMMIODoWrite(PVM pVM, PVMCPU pVCpu, PIOMMMIORANGE pRange, RTGCPHYS
     VBOXSTRICTRC rc;
     if (RT_LIKELY(pRange->CTX_SUFF(pfnWriteCallback)))
     {
+        uint64_t const uExitTraceTsc = VMM_EXIT_TRACE_START(pVCpu);
         if (   (cb == 4 && !(GCPhysFault & 3))
             || (pRange->fFlags & IOMMMIO_FLAGS_WRITE_MODE) == IOMMMIO_FLAGS_WRITE_PASSTHRU
             || (cb == 8 && !(GCPhysFault & 7) && IOMMMIO_DOES_WRITE_MODE_ALLOW_QWORD(pRange->fFlags)) )
@@ -299,6 +301,8 @@ static int iomMMIODoWrite(PVM pVM, PVMCPU pVCpu, PIOMMMIORANGE pRange, RTGCPHYS
                                                     GCPhysFault, (void *)pvData, cb); /** @todo fix const!! */
         else
             rc = iomMMIODoComplicatedWrite(pVM, pRange, GCPhysFault, pvData, cb);
+        VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_IOM_MMIO_WRITE, cb, CPUMGetGuestRIP(pVCpu), GCPhysFault,
+                           pRange->CTX_SUFF(pDevIns)->idTracing);
     }
     else
         rc = VINF_SUCCESS;
@@ -508,6 +512,7 @@ DECLINLINE(int) iomMMIODoRead(PVM pVM, PVMCPU pVCpu, PIOMMMIORANGE pRange, RTGCP
     VBOXSTRICTRC rc;
     if (RT_LIKELY(pRange->CTX_SUFF(pfnReadCallback)))
     {
+        uint64_t const uExitTraceTsc = VMM_EXIT_TRACE_START(pVCpu);
         if (   (   cbValue == 4
                 && !(GCPhys & 3))
             || (pRange->fFlags & IOMMMIO_FLAGS_READ_MODE) == IOMMMIO_FLAGS_READ_PASSTHRU
@@ -517,6 +522,8 @@ DECLINLINE(int) iomMMIODoRead(PVM pVM, PVMCPU pVCpu, PIOMMMIORANGE pRange, RTGCP
             rc = pRange->CTX_SUFF(pfnReadCallback)(pRange->CTX_SUFF(pDevIns), pRange->CTX_SUFF(pvUser), GCPhys, pvValue, cbValue);
         else
             rc = iomMMIODoComplicatedRead(pVM, pRange, GCPhys, pvValue, cbValue);
+        VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_IOM_MMIO_READ, cbValue, CPUMGetGuestRIP(pVCpu), GCPhys,
+                           pRange->CTX_SUFF(pDevIns)->idTracing);
     }
     else
         rc = VINF_IOM_MMIO_UNUSED_FF;
@@ -1492,6 +1499,91 @@ static int iomInterpretXCHG(PVM pVM, PVMCPU pVCpu, PCPUMCTXCORE pRegFrame, RTGCP
 }
 
 
+#ifndef IN_RC
+/**
+ * Tries to carry out an MMIO access using the decode cache instead of
+ * disassembling the faulting instruction.
+ *
+ * @returns VBox status code, VERR_NOT_FOUND if the cache cannot serve the
+ *          access and the instruction must be disassembled.
+ * @param   pVM         Pointer to the VM.
+ * @param   pVCpu       Pointer to the virtual CPU structure of the caller.
+ * @param   pCache      The decode cache of the calling EMT.
+ * @param   uErrorCode  CPU Error code, UINT32_MAX if not available.
+ * @param   pCtxCore    Trap register frame.
+ * @param   pRange      Pointer MMIO range.
+ * @param   GCPhysFault The GC physical address corresponding to pvFault.
+ * @param   pGCPtrInstr Where to return the flat address of the instruction
+ *                      for use when adding it to the cache.  NIL_RTGCPTR if
+ *                      the address could not be determined.
+ * @param   pcbInstr    Where to return the instruction length on success.
+ */
+static int iomMMIODecCacheExec(PVM pVM, PVMCPU pVCpu, PIOMMMIODECCACHE pCache, uint32_t uErrorCode, PCPUMCTXCORE pCtxCore,
+                               PIOMMMIORANGE pRange, RTGCPHYS GCPhysFault, PRTGCPTR pGCPtrInstr, unsigned *pcbInstr)
+{
+    RTGCPTR GCPtrInstr;
+    int rc = SELMValidateAndConvertCSAddr(pVCpu, pCtxCore->eflags, pCtxCore->ss.Sel, pCtxCore->cs.Sel, &pCtxCore->cs,
+                                          pCtxCore->rip, &GCPtrInstr);
+    if (RT_FAILURE(rc))
+    {
+        *pGCPtrInstr = NIL_RTGCPTR;
+        return VERR_NOT_FOUND;
+    }
+    *pGCPtrInstr = GCPtrInstr;
+
+    PIOMMMIODECENTRY pEntry = iomMmioDecCacheLookup(pCache, GCPtrInstr, CPUMGetGuestDisMode(pVCpu));
+    if (!pEntry)
+    {
+        STAM_COUNTER_INC(&pVM->iom.s.StatMMIODecCacheMiss);
+        return VERR_NOT_FOUND;
+    }
+
+    /*
+     * The guest may have modified or remapped the code since the entry was
+     * made, so check that the instruction bytes are still the same.  This is
+     * only a read, the decoding is what we're saving.
+     */
+    uint8_t abInstr[sizeof(pEntry->abInstr)];
+    rc = PGMPhysSimpleReadGCPtr(pVCpu, abInstr, GCPtrInstr, pEntry->cbInstr);
+    if (   RT_FAILURE(rc)
+        || memcmp(abInstr, pEntry->abInstr, pEntry->cbInstr))
+    {
+        STAM_COUNTER_INC(&pVM->iom.s.StatMMIODecCacheStale);
+        pEntry->cbInstr = 0;
+        return VERR_NOT_FOUND;
+    }
+
+    bool const fWrite = pEntry->enmKind == IOMMMIODECKIND_WRITE_REG || pEntry->enmKind == IOMMMIODECKIND_WRITE_IMM;
+    if (   uErrorCode != UINT32_MAX
+        && fWrite != RT_BOOL(uErrorCode & X86_TRAP_PF_RW))
+    {
+        STAM_COUNTER_INC(&pVM->iom.s.StatMMIODecCacheMiss);
+        return VERR_NOT_FOUND;
+    }
+    STAM_COUNTER_INC(&pVM->iom.s.StatMMIODecCacheHit);
+
+    if (fWrite)
+    {
+        Assert(pRange->CTX_SUFF(pfnWriteCallback) || !pRange->pfnWriteCallbackR3);
+        uint64_t u64Data = iomMmioDecEntryGetWriteValue(pEntry, pCtxCore);
+        rc = iomMMIODoWrite(pVM, pVCpu, pRange, GCPhysFault, &u64Data, pEntry->cbAccess);
+    }
+    else
+    {
+        Assert(pRange->CTX_SUFF(pfnReadCallback) || !pRange->pfnReadCallbackR3);
+        uint64_t u64Data = 0;
+        rc = iomMMIODoRead(pVM, pVCpu, pRange, GCPhysFault, &u64Data, pEntry->cbAccess);
+        if (rc == VINF_SUCCESS)
+            iomMmioDecEntryStoreReadValue(pEntry, pCtxCore, u64Data);
+    }
+    if (rc == VINF_SUCCESS)
+        iomMMIOStatLength(pVM, pEntry->cbAccess);
+    *pcbInstr = pEntry->cbInstr;
+    return rc;
+}
+#endif /* !IN_RC */
+
+
 /**
  * \#PF Handler callback for MMIO ranges.
  *
@@ -1580,11 +1672,35 @@ static int iomMMIOHandler(PVM pVM, PVMCPU pVCpu, uint32_t uErrorCode, PCPUMCTXCO
         return rc;
     }
 
+    unsigned        cbOp;
+#ifndef IN_RC
+    /*
+     * Driver register accessors cause the bulk of the MMIO exits, so try the
+     * decode cache before bothering the disassembler.
+     */
+    RTGCPTR          GCPtrInstr = NIL_RTGCPTR;
+    PIOMMMIODECCACHE pDecCache  = pVCpu->iom.s.CTX_SUFF(pMmioDecCache);
+    if (pDecCache)
+    {
+        rc = iomMMIODecCacheExec(pVM, pVCpu, pDecCache, uErrorCode, pCtxCore, pRange, GCPhysFault, &GCPtrInstr, &cbOp);
+        if (rc != VERR_NOT_FOUND)
+        {
+            if (rc == VINF_SUCCESS)
+                pCtxCore->rip += cbOp;
+            else
+                STAM_COUNTER_INC(&pVM->iom.s.StatRZMMIOFailures);
+            STAM_PROFILE_STOP(&pVM->iom.s.StatRZMMIOHandler, a);
+            PDMCritSectLeave(pDevIns->CTX_SUFF(pCritSectRo));
+            iomMmioReleaseRange(pVM, pRange);
+            return rc;
+        }
+    }
+#endif
+
     /*
      * Disassemble the instruction and interpret it.
      */
     PDISCPUSTATE    pDis  = &pVCpu->iom.s.DisState;
-    unsigned        cbOp;
     rc = EMInterpretDisasCurrent(pVM, pVCpu, pDis, &cbOp);
     if (RT_FAILURE(rc))
     {
@@ -1600,12 +1716,20 @@ static int iomMMIOHandler(PVM pVM, PVMCPU pVCpu, uint32_t uErrorCode, PCPUMCTXCO
         {
             STAM_PROFILE_START(&pVM->iom.s.StatRZInstMov, b);
             AssertMsg(uErrorCode == UINT32_MAX || DISUSE_IS_EFFECTIVE_ADDR(pDis->Param1.fUse) == !!(uErrorCode & X86_TRAP_PF_RW), ("flags1=%#llx/%RTbool flags2=%#llx/%RTbool ErrCd=%#x\n", pDis->Param1.fUse, DISUSE_IS_EFFECTIVE_ADDR(pDis->Param1.fUse), pDis->Param2.fUse, DISUSE_IS_EFFECTIVE_ADDR(pDis->Param2.fUse), uErrorCode));
-            if (uErrorCode != UINT32_MAX    /* EPT+MMIO optimization */
-                ? uErrorCode & X86_TRAP_PF_RW
-                : DISUSE_IS_EFFECTIVE_ADDR(pDis->Param1.fUse))
+            bool const fWrite = uErrorCode != UINT32_MAX    /* EPT+MMIO optimization */
+                              ? RT_BOOL(uErrorCode & X86_TRAP_PF_RW)
+                              : DISUSE_IS_EFFECTIVE_ADDR(pDis->Param1.fUse);
+            if (fWrite)
                 rc = iomInterpretMOVxXWrite(pVM, pVCpu, pCtxCore, pDis, pRange, GCPhysFault);
             else
                 rc = iomInterpretMOVxXRead(pVM, pVCpu, pCtxCore, pDis, pRange, GCPhysFault);
+#ifndef IN_RC
+            if (   pDecCache
+                && GCPtrInstr != NIL_RTGCPTR
+                && rc == VINF_SUCCESS
+                && iomMmioDecCacheInsert(pDecCache, pDis, GCPtrInstr, fWrite))
+                STAM_COUNTER_INC(&pVM->iom.s.StatMMIODecCacheInsert);
+#endif
             STAM_PROFILE_STOP(&pVM->iom.s.StatRZInstMov, b);
             break;
         }
@@ -1912,6 +2036,7 @@ VMMDECL(VBOXSTRICTRC) IOMMMIORead(PVM pVM, PVMCPU pVCpu, RTGCPHYS GCPhys, uint32
          * Perform the read and deal with the result.
          */
         STAM_PROFILE_START(&pStats->CTX_SUFF_Z(ProfRead), a);
+        uint64_t const uExitTraceTsc = VMM_EXIT_TRACE_START(pVCpu);
         if (   (cbValue == 4 && !(GCPhys & 3))
             || (pRange->fFlags & IOMMMIO_FLAGS_READ_MODE) == IOMMMIO_FLAGS_READ_PASSTHRU
             || (cbValue == 8 && !(GCPhys & 7)) )
@@ -1919,6 +2044,8 @@ VMMDECL(VBOXSTRICTRC) IOMMMIORead(PVM pVM, PVMCPU pVCpu, RTGCPHYS GCPhys, uint32
                                                    pu32Value, (unsigned)cbValue);
         else
             rc = iomMMIODoComplicatedRead(pVM, pRange, GCPhys, pu32Value, (unsigned)cbValue);
+        VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_IOM_MMIO_READ, (uint32_t)cbValue, CPUMGetGuestRIP(pVCpu), GCPhys,
+                           pRange->CTX_SUFF(pDevIns)->idTracing);
         STAM_PROFILE_STOP(&pStats->CTX_SUFF_Z(ProfRead), a);
         switch (VBOXSTRICTRC_VAL(rc))
         {
@@ -2044,6 +2171,7 @@ VMMDECL(VBOXSTRICTRC) IOMMMIOWrite(PVM pVM, PVMCPU pVCpu, RTGCPHYS GCPhys, uint3
          * Perform the write.
          */
         STAM_PROFILE_START(&pStats->CTX_SUFF_Z(ProfWrite), a);
+        uint64_t const uExitTraceTsc = VMM_EXIT_TRACE_START(pVCpu);
         if (   (cbValue == 4 && !(GCPhys & 3))
             || (pRange->fFlags & IOMMMIO_FLAGS_WRITE_MODE) == IOMMMIO_FLAGS_WRITE_PASSTHRU
             || (cbValue == 8 && !(GCPhys & 7)) )
@@ -2051,6 +2179,8 @@ VMMDECL(VBOXSTRICTRC) IOMMMIOWrite(PVM pVM, PVMCPU pVCpu, RTGCPHYS GCPhys, uint3
                                                     GCPhys, &u32Value, (unsigned)cbValue);
         else
             rc = iomMMIODoComplicatedWrite(pVM, pRange, GCPhys, &u32Value, (unsigned)cbValue);
+        VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_IOM_MMIO_WRITE, (uint32_t)cbValue, CPUMGetGuestRIP(pVCpu), GCPhys,
+                           pRange->CTX_SUFF(pDevIns)->idTracing);
         STAM_PROFILE_STOP(&pStats->CTX_SUFF_Z(ProfWrite), a);
 #ifndef IN_RING3
         if (    rc == VINF_IOM_R3_MMIO_WRITE
@@ -50,6 +50,14 @@
 #define PDMCRITSECT_SPIN_COUNT_R0       256
 /** The number loops to spin for in the raw-mode context. */
 #define PDMCRITSECT_SPIN_COUNT_RC       256
+/** The minimum number of loops to spin when spinning adaptively. */
+#define PDMCRITSECT_SPIN_COUNT_ADAPTIVE_MIN     4
+/** The estimated number of TSC ticks one spin loop takes. */
+#define PDMCRITSECT_ADAPTIVE_TICKS_PER_SPIN     32
+/** Average hold times above this number of TSC ticks will make the adaptive
+ * spinning fall back on PDMCRITSECT_SPIN_COUNT_ADAPTIVE_MIN as blocking is
+ * likely to be cheaper.  This also caps the spin count at 2048. */
+#define PDMCRITSECT_ADAPTIVE_MAX_SPIN_TICKS     _64K
 
 
 /* Undefine the automatic VBOX_STRICT API mappings. */
@@ -79,6 +87,96 @@ DECL_FORCE_INLINE(RTNATIVETHREAD) pdmCritSectGetNativeSelf(PCPDMCRITSECT pCritSe
 }
 
 
+/**
+ * Gets the contention profile of a critical section.
+ *
+ * @returns Pointer to the profile, NULL if not profiled.
+ * @param   pCritSect           The critical section.
+ */
+DECL_FORCE_INLINE(PPDMCRITSECTPROF) pdmCritSectGetProf(PCPDMCRITSECT pCritSect)
+{
+    uint32_t const iProf = pCritSect->s.iProf;
+    if (RT_LIKELY(!iProf))
+        return NULL;
+    return &pCritSect->s.CTX_SUFF(pVM)->pdm.s.CTX_SUFF(paCritSectProfs)[iProf - 1];
+}
+
+
+/**
+ * Gets the histogram bucket for a wait or hold time.
+ *
+ * @returns Bucket index.
+ * @param   cTicks              The time in TSC ticks.
+ */
+DECLINLINE(unsigned) pdmCritSectProfBucket(uint64_t cTicks)
+{
+    unsigned iBucket = 0;
+    cTicks >>= 10;
+    while (cTicks && iBucket < PDMCRITSECT_PROF_HIST_BUCKETS - 1)
+    {
+        cTicks >>= 2;
+        iBucket++;
+    }
+    return iBucket;
+}
+
+
+/**
+ * Attributes a contention to the call site of the current owner.
+ *
+ * @param   pProf               The contention profile.
+ */
+static void pdmCritSectProfAttribute(PPDMCRITSECTPROF pProf)
+{
+    uint64_t const uCaller = ASMAtomicUoReadU64(&pProf->uOwnerCaller);
+    if (!uCaller)
+        return;
+    for (unsigned i = 0; i < RT_ELEMENTS(pProf->aCallers); i++)
+    {
+        uint64_t uCur = ASMAtomicUoReadU64(&pProf->aCallers[i].uCaller);
+        if (!uCur)
+        {
+            if (ASMAtomicCmpXchgU64(&pProf->aCallers[i].uCaller, uCaller, 0))
+                uCur = uCaller;
+            else
+                uCur = ASMAtomicReadU64(&pProf->aCallers[i].uCaller);
+        }
+        if (uCur == uCaller)
+        {
+            ASMAtomicIncU32(&pProf->aCallers[i].cContentions);
+            return;
+        }
+    }
+    ASMAtomicIncU32(&pProf->cCallerOverflows);
+}
+
+
+/**
+ * Updates the hold time statistics and the adaptive spin count when the owner
+ * leaves the critical section.
+ *
+ * @param   pProf               The contention profile.
+ */
+DECLINLINE(void) pdmCritSectProfLeave(PPDMCRITSECTPROF pProf)
+{
+    uint64_t cTicks = ASMReadTSC() - pProf->u64EnterTsc;
+    if ((int64_t)cTicks < 0) /* different CPU */
+        cTicks = 0;
+    STAM_REL_COUNTER_INC(&pProf->aStatHold[pdmCritSectProfBucket(cTicks)]);
+
+    uint64_t const cTicksAvg = (pProf->cTicksHoldAvg * 7 + cTicks) / 8;
+    pProf->cTicksHoldAvg = cTicksAvg;
+
+    /* Spin for roughly the average hold time, so a waiter arriving while the
+       section is held is likely to get it without blocking.  Don't bother for
+       long holds. */
+    int32_t cSpins = PDMCRITSECT_SPIN_COUNT_ADAPTIVE_MIN;
+    if (cTicksAvg < PDMCRITSECT_ADAPTIVE_MAX_SPIN_TICKS)
+        cSpins = RT_MAX((int32_t)(cTicksAvg / PDMCRITSECT_ADAPTIVE_TICKS_PER_SPIN), PDMCRITSECT_SPIN_COUNT_ADAPTIVE_MIN);
+    ASMAtomicWriteS32(&pProf->cSpins, cSpins);
+}
+
+
 /**
  * Tail code called when we've won the battle for the lock.
  *
@@ -86,8 +184,13 @@ DECL_FORCE_INLINE(RTNATIVETHREAD) pdmCritSectGetNativeSelf(PCPDMCRITSECT pCritSe
  *
  * @param   pCritSect       The critical section.
  * @param   hNativeSelf     The native handle of this thread.
+ * @param   pSrcPos         The source position of the lock operation.
+ * @param   uCaller         The call site for the contention profile.
+ * @param   u64WaitStart    The TSC when we started spinning or waiting, 0 if
+ *                          uncontended.
  */
-DECL_FORCE_INLINE(int) pdmCritSectEnterFirst(PPDMCRITSECT pCritSect, RTNATIVETHREAD hNativeSelf, PCRTLOCKVALSRCPOS pSrcPos)
+DECL_FORCE_INLINE(int) pdmCritSectEnterFirst(PPDMCRITSECT pCritSect, RTNATIVETHREAD hNativeSelf, PCRTLOCKVALSRCPOS pSrcPos,
+                                             uint64_t uCaller, uint64_t u64WaitStart)
 {
     AssertMsg(pCritSect->s.Core.NativeThreadOwner == NIL_RTNATIVETHREAD, ("NativeThreadOwner=%p\n", pCritSect->s.Core.NativeThreadOwner));
     Assert(!(pCritSect->s.Core.fFlags & PDMCRITSECT_FLAGS_PENDING_UNLOCK));
@@ -102,6 +205,22 @@ DECL_FORCE_INLINE(int) pdmCritSectEnterFirst(PPDMCRITSECT pCritSect, RTNATIVETHR
     NOREF(pSrcPos);
 # endif
 
+    PPDMCRITSECTPROF pProf = pdmCritSectGetProf(pCritSect);
+    if (pProf)
+    {
+        uint64_t const u64Now = ASMReadTSC();
+        ASMAtomicWriteU64(&pProf->uOwnerCaller, uCaller);
+        ASMAtomicWriteU64(&pProf->u64EnterTsc, u64Now);
+        if (u64WaitStart)
+        {
+            uint64_t cTicks = u64Now - u64WaitStart;
+            if ((int64_t)cTicks < 0)
+                cTicks = 0;
+            STAM_REL_COUNTER_INC(&pProf->aStatWait[pdmCritSectProfBucket(cTicks)]);
+            STAM_REL_PROFILE_ADD_PERIOD(&pProf->StatWait, cTicks);
+        }
+    }
+
     STAM_PROFILE_ADV_START(&pCritSect->s.StatLocked, l);
     return VINF_SUCCESS;
 }
@@ -116,14 +235,18 @@ DECL_FORCE_INLINE(int) pdmCritSectEnterFirst(PPDMCRITSECT pCritSect, RTNATIVETHR
  *
  * @param   pCritSect           The critsect.
  * @param   hNativeSelf         The native thread handle.
+ * @param   pSrcPos             The source position of the lock operation.
+ * @param   uCaller             The call site for the contention profile.
+ * @param   u64WaitStart        The TSC when we started spinning.
  */
-static int pdmR3R0CritSectEnterContended(PPDMCRITSECT pCritSect, RTNATIVETHREAD hNativeSelf, PCRTLOCKVALSRCPOS pSrcPos)
+static int pdmR3R0CritSectEnterContended(PPDMCRITSECT pCritSect, RTNATIVETHREAD hNativeSelf, PCRTLOCKVALSRCPOS pSrcPos,
+                                         uint64_t uCaller, uint64_t u64WaitStart)
 {
     /*
      * Start waiting.
      */
     if (ASMAtomicIncS32(&pCritSect->s.Core.cLockers) == 0)
-        return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos);
+        return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos, uCaller, u64WaitStart);
 # ifdef IN_RING3
     STAM_COUNTER_INC(&pCritSect->s.StatContentionR3);
 # else
@@ -179,7 +302,7 @@ static int pdmR3R0CritSectEnterContended(PPDMCRITSECT pCritSect, RTNATIVETHREAD
         if (RT_UNLIKELY(pCritSect->s.Core.u32Magic != RTCRITSECT_MAGIC))
             return VERR_SEM_DESTROYED;
         if (rc == VINF_SUCCESS)
-            return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos);
+            return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos, uCaller, u64WaitStart);
         AssertMsg(rc == VERR_INTERRUPTED, ("rc=%Rrc\n", rc));
 
 # ifdef IN_RING0
@@ -211,8 +334,10 @@ static int pdmR3R0CritSectEnterContended(PPDMCRITSECT pCritSect, RTNATIVETHREAD
  * @param   pCritSect           The PDM critical section to enter.
  * @param   rcBusy              The status code to return when we're in GC or R0
  *                              and the section is busy.
+ * @param   pSrcPos             The source position of the lock operation.
+ * @param   uCaller             The call site for the contention profile.
  */
-DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRTLOCKVALSRCPOS pSrcPos)
+DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRTLOCKVALSRCPOS pSrcPos, uint64_t uCaller)
 {
     Assert(pCritSect->s.Core.cNestings < 8);  /* useful to catch incorrect locking */
     Assert(pCritSect->s.Core.cNestings >= 0);
@@ -234,7 +359,7 @@ DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRT
     RTNATIVETHREAD hNativeSelf = pdmCritSectGetNativeSelf(pCritSect);
     /* ... not owned ... */
     if (ASMAtomicCmpXchgS32(&pCritSect->s.Core.cLockers, 0, -1))
-        return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos);
+        return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos, uCaller, 0);
 
     /* ... or nested. */
     if (pCritSect->s.Core.NativeThreadOwner == hNativeSelf)
@@ -250,11 +375,24 @@ DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRT
      */
     /** @todo Move this to cfgm variables since it doesn't make sense to spin on UNI
      *        cpu systems. */
-    int32_t cSpinsLeft = CTX_SUFF(PDMCRITSECT_SPIN_COUNT_);
+    int32_t          cSpinsLeft   = CTX_SUFF(PDMCRITSECT_SPIN_COUNT_);
+    uint64_t         u64WaitStart = 0;
+    PPDMCRITSECTPROF pProf        = pdmCritSectGetProf(pCritSect);
+    if (pProf)
+    {
+        u64WaitStart = ASMReadTSC();
+        pdmCritSectProfAttribute(pProf);
+        if (pProf->fAdaptiveSpin && pProf->cTicksHoldAvg) /* nothing learned yet? */
+            cSpinsLeft = ASMAtomicUoReadS32(&pProf->cSpins);
+    }
     while (cSpinsLeft-- > 0)
     {
         if (ASMAtomicCmpXchgS32(&pCritSect->s.Core.cLockers, 0, -1))
-            return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos);
+        {
+            if (pProf)
+                STAM_REL_COUNTER_INC(&pProf->StatSpinHits);
+            return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos, uCaller, u64WaitStart);
+        }
         ASMNopPause();
         /** @todo Should use monitor/mwait on e.g. &cLockers here, possibly with a
            cli'ed pendingpreemption check up front using sti w/ instruction fusing
@@ -262,13 +400,15 @@ DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRT
            executing code on another CPU ... which we could keep track of if we
            wanted. */
     }
+    if (pProf)
+        STAM_REL_COUNTER_INC(&pProf->StatSpinMisses);
 
 #ifdef IN_RING3
     /*
      * Take the slow path.
      */
     NOREF(rcBusy);
-    return pdmR3R0CritSectEnterContended(pCritSect, hNativeSelf, pSrcPos);
+    return pdmR3R0CritSectEnterContended(pCritSect, hNativeSelf, pSrcPos, uCaller, u64WaitStart);
 
 #else
 # ifdef IN_RING0
@@ -290,7 +430,7 @@ DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRT
         if (RTThreadPreemptIsEnabled(NIL_RTTHREAD))
         {
             STAM_REL_COUNTER_ADD(&pCritSect->s.StatContentionRZLock,    1000000);
-            rc = pdmR3R0CritSectEnterContended(pCritSect, hNativeSelf, pSrcPos);
+            rc = pdmR3R0CritSectEnterContended(pCritSect, hNativeSelf, pSrcPos, uCaller, u64WaitStart);
         }
         else
         {
@@ -300,7 +440,7 @@ DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRT
             HMR0Leave(pVM, pVCpu);
             RTThreadPreemptRestore(NIL_RTTHREAD, ????);
 
-            rc = pdmR3R0CritSectEnterContended(pCritSect, hNativeSelf, pSrcPos);
+            rc = pdmR3R0CritSectEnterContended(pCritSect, hNativeSelf, pSrcPos, uCaller, u64WaitStart);
 
             RTThreadPreemptDisable(NIL_RTTHREAD, ????);
             HMR0Enter(pVM, pVCpu);
@@ -313,7 +453,7 @@ DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRT
      */
     if (   RTThreadPreemptIsEnabled(NIL_RTTHREAD)
         && ASMIntAreEnabled())
-        return pdmR3R0CritSectEnterContended(pCritSect, hNativeSelf, pSrcPos);
+        return pdmR3R0CritSectEnterContended(pCritSect, hNativeSelf, pSrcPos, uCaller, u64WaitStart);
 #  endif
 #endif /* IN_RING0 */
 
@@ -355,10 +495,10 @@ DECL_FORCE_INLINE(int) pdmCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy, PCRT
 VMMDECL(int) PDMCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy)
 {
 #ifndef PDMCRITSECT_STRICT
-    return pdmCritSectEnter(pCritSect, rcBusy, NULL);
+    return pdmCritSectEnter(pCritSect, rcBusy, NULL, (uintptr_t)ASMReturnAddress());
 #else
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
-    return pdmCritSectEnter(pCritSect, rcBusy, &SrcPos);
+    return pdmCritSectEnter(pCritSect, rcBusy, &SrcPos, (uintptr_t)ASMReturnAddress());
 #endif
 }
 
@@ -386,12 +526,13 @@ VMMDECL(int) PDMCritSectEnter(PPDMCRITSECT pCritSect, int rcBusy)
  */
 VMMDECL(int) PDMCritSectEnterDebug(PPDMCRITSECT pCritSect, int rcBusy, RTHCUINTPTR uId, RT_SRC_POS_DECL)
 {
+    uint64_t const uCaller = uId ? uId : (uintptr_t)ASMReturnAddress();
 #ifdef PDMCRITSECT_STRICT
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
-    return pdmCritSectEnter(pCritSect, rcBusy, &SrcPos);
+    return pdmCritSectEnter(pCritSect, rcBusy, &SrcPos, uCaller);
 #else
-    NOREF(uId); RT_SRC_POS_NOREF();
-    return pdmCritSectEnter(pCritSect, rcBusy, NULL);
+    RT_SRC_POS_NOREF();
+    return pdmCritSectEnter(pCritSect, rcBusy, NULL, uCaller);
 #endif
 }
 
@@ -406,8 +547,10 @@ VMMDECL(int) PDMCritSectEnterDebug(PPDMCRITSECT pCritSect, int rcBusy, RTHCUINTP
  *          during the operation.
  *
  * @param   pCritSect   The critical section.
+ * @param   pSrcPos     The source position of the lock operation.
+ * @param   uCaller     The call site for the contention profile.
  */
-static int pdmCritSectTryEnter(PPDMCRITSECT pCritSect, PCRTLOCKVALSRCPOS pSrcPos)
+static int pdmCritSectTryEnter(PPDMCRITSECT pCritSect, PCRTLOCKVALSRCPOS pSrcPos, uint64_t uCaller)
 {
     /*
      * If the critical section has already been destroyed, then inform the caller.
@@ -426,7 +569,7 @@ static int pdmCritSectTryEnter(PPDMCRITSECT pCritSect, PCRTLOCKVALSRCPOS pSrcPos
     RTNATIVETHREAD hNativeSelf = pdmCritSectGetNativeSelf(pCritSect);
     /* ... not owned ... */
     if (ASMAtomicCmpXchgS32(&pCritSect->s.Core.cLockers, 0, -1))
-        return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos);
+        return pdmCritSectEnterFirst(pCritSect, hNativeSelf, pSrcPos, uCaller, 0);
 
     /* ... or nested. */
     if (pCritSect->s.Core.NativeThreadOwner == hNativeSelf)
@@ -438,6 +581,9 @@ static int pdmCritSectTryEnter(PPDMCRITSECT pCritSect, PCRTLOCKVALSRCPOS pSrcPos
     }
 
     /* no spinning */
+    PPDMCRITSECTPROF pProf = pdmCritSectGetProf(pCritSect);
+    if (pProf)
+        pdmCritSectProfAttribute(pProf);
 
     /*
      * Return busy.
@@ -466,10 +612,10 @@ static int pdmCritSectTryEnter(PPDMCRITSECT pCritSect, PCRTLOCKVALSRCPOS pSrcPos
 VMMDECL(int) PDMCritSectTryEnter(PPDMCRITSECT pCritSect)
 {
 #ifndef PDMCRITSECT_STRICT
-    return pdmCritSectTryEnter(pCritSect, NULL);
+    return pdmCritSectTryEnter(pCritSect, NULL, (uintptr_t)ASMReturnAddress());
 #else
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_NORMAL_API();
-    return pdmCritSectTryEnter(pCritSect, &SrcPos);
+    return pdmCritSectTryEnter(pCritSect, &SrcPos, (uintptr_t)ASMReturnAddress());
 #endif
 }
 
@@ -494,12 +640,13 @@ VMMDECL(int) PDMCritSectTryEnter(PPDMCRITSECT pCritSect)
  */
 VMMDECL(int) PDMCritSectTryEnterDebug(PPDMCRITSECT pCritSect, RTHCUINTPTR uId, RT_SRC_POS_DECL)
 {
+    uint64_t const uCaller = uId ? uId : (uintptr_t)ASMReturnAddress();
 #ifdef PDMCRITSECT_STRICT
     RTLOCKVALSRCPOS SrcPos = RTLOCKVALSRCPOS_INIT_DEBUG_API();
-    return pdmCritSectTryEnter(pCritSect, &SrcPos);
+    return pdmCritSectTryEnter(pCritSect, &SrcPos, uCaller);
 #else
-    NOREF(uId); RT_SRC_POS_NOREF();
-    return pdmCritSectTryEnter(pCritSect, NULL);
+    RT_SRC_POS_NOREF();
+    return pdmCritSectTryEnter(pCritSect, NULL, uCaller);
 #endif
 }
 
@@ -599,6 +746,9 @@ VMMDECL(int) PDMCritSectLeave(PPDMCRITSECT pCritSect)
         Assert(pCritSect->s.Core.cNestings == 0);
 
         /* stop and decrement lockers. */
+        PPDMCRITSECTPROF pProf = pdmCritSectGetProf(pCritSect);
+        if (pProf)
+            pdmCritSectProfLeave(pProf);
         STAM_PROFILE_ADV_STOP(&pCritSect->s.StatLocked, l);
         ASMCompilerBarrier();
         if (ASMAtomicDecS32(&pCritSect->s.Core.cLockers) >= 0)
@@ -638,6 +788,9 @@ VMMDECL(int) PDMCritSectLeave(PPDMCRITSECT pCritSect)
             ASMAtomicWriteS32(&pCritSect->s.Core.cNestings, 0);
             RTNATIVETHREAD hNativeThread = pCritSect->s.Core.NativeThreadOwner;
             ASMAtomicAndU32(&pCritSect->s.Core.fFlags, ~PDMCRITSECT_FLAGS_PENDING_UNLOCK);
+            PPDMCRITSECTPROF pProf = pdmCritSectGetProf(pCritSect);
+            if (pProf)
+                pdmCritSectProfLeave(pProf);
             STAM_PROFILE_ADV_STOP(&pCritSect->s.StatLocked, l);
 
             ASMAtomicWriteHandle(&pCritSect->s.Core.NativeThreadOwner, NIL_RTNATIVETHREAD);
@@ -646,6 +799,8 @@ VMMDECL(int) PDMCritSectLeave(PPDMCRITSECT pCritSect)
 
             /* darn, someone raced in on us. */
             ASMAtomicWriteHandle(&pCritSect->s.Core.NativeThreadOwner, hNativeThread);
+            if (pProf)
+                ASMAtomicWriteU64(&pProf->u64EnterTsc, ASMReadTSC());
             STAM_PROFILE_ADV_START(&pCritSect->s.StatLocked, l);
             Assert(pCritSect->s.Core.cNestings == 0);
             ASMAtomicWriteS32(&pCritSect->s.Core.cNestings, 1);
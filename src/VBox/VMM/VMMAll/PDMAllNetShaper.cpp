@@ -21,7 +21,9 @@
 *******************************************************************************/
 #define LOG_GROUP LOG_GROUP_NET_SHAPER
 #include <VBox/vmm/pdm.h>
+#include <VBox/vmm/stam.h>
 #include <VBox/log.h>
+#include <iprt/asm.h>
 #include <iprt/time.h>
 
 #include <VBox/vmm/pdmnetshaper.h>
@@ -31,6 +33,8 @@
 /**
  * Obtain bandwidth in a bandwidth group.
  *
+ * This is lock-free, the bucket state is advanced with compare-and-exchange.
+ *
  * @returns True if bandwidth was allocated, false if not.
  * @param   pFilter         Pointer to the filter that allocates bandwidth.
  * @param   cbTransfer      Number of bytes to allocate.
@@ -41,37 +45,53 @@ VMMDECL(bool) PDMNsAllocateBandwidth(PPDMNSFILTER pFilter, size_t cbTransfer)
     if (!VALID_PTR(pFilter->CTX_SUFF(pBwGroup)))
         return true;
 
-    PPDMNSBWGROUP pBwGroup = ASMAtomicReadPtrT(&pFilter->CTX_SUFF(pBwGroup), PPDMNSBWGROUP);
-    int rc = PDMCritSectEnter(&pBwGroup->Lock, VERR_SEM_BUSY); AssertRC(rc);
-    if (RT_UNLIKELY(rc == VERR_SEM_BUSY))
+    PPDMNSBWGROUP pBwGroup    = ASMAtomicReadPtrT(&pFilter->CTX_SUFF(pBwGroup), PPDMNSBWGROUP);
+    uint64_t const u64Limit   = ASMAtomicReadU64(&pBwGroup->u64Limit);
+    uint32_t const cbPerSecMax = RT_LO_U32(u64Limit);
+    if (!cbPerSecMax)
+    {
+        Log2(("pdmNsAllocateBandwidth: BwGroup=%#p{%s} disabled fAllowed=true\n",
+              pBwGroup, R3STRING(pBwGroup->pszNameR3)));
         return true;
+    }
 
-    bool fAllowed = true;
-    if (pBwGroup->cbPerSecMax)
+    uint64_t const cNsCost  = (uint64_t)cbTransfer * RT_NS_1SEC / cbPerSecMax;
+    uint64_t const cNsBurst = pdmNsBwGroupCalcBurst(u64Limit);
+    uint64_t const tsNow    = RTTimeSystemNanoTS();
+    bool           fAllowed;
+    for (;;)
     {
-        /* Re-fill the bucket first */
-        uint64_t tsNow        = RTTimeSystemNanoTS();
-        uint32_t uTokensAdded = (tsNow - pBwGroup->tsUpdatedLast) * pBwGroup->cbPerSecMax / (1000 * 1000 * 1000);
-        uint32_t uTokens      = RT_MIN(pBwGroup->cbBucket, uTokensAdded + pBwGroup->cbTokensLast);
-
-        if (cbTransfer > uTokens)
+        uint64_t const tsTat    = ASMAtomicReadU64(&pBwGroup->tsTat);
+        uint64_t const tsTatNew = RT_MAX(tsTat, tsNow) + cNsCost;
+        if (tsTatNew - tsNow > cNsBurst)
         {
             fAllowed = false;
-            ASMAtomicWriteBool(&pFilter->fChoked, true);
+            break;
         }
-        else
+        if (ASMAtomicCmpXchgU64(&pBwGroup->tsTat, tsTatNew, tsTat))
         {
-            pBwGroup->tsUpdatedLast = tsNow;
-            pBwGroup->cbTokensLast = uTokens - (uint32_t)cbTransfer;
+            fAllowed = true;
+            break;
         }
-        Log2(("pdmNsAllocateBandwidth: BwGroup=%#p{%s} cbTransfer=%u uTokens=%u uTokensAdded=%u fAllowed=%RTbool\n",
-              pBwGroup, R3STRING(pBwGroup->pszNameR3), cbTransfer, uTokens, uTokensAdded, fAllowed));
+        STAM_REL_COUNTER_INC(&pBwGroup->StatAllocRetries);
     }
+
+    if (fAllowed)
+        STAM_REL_COUNTER_ADD(&pBwGroup->StatBytesGranted, cbTransfer);
     else
-        Log2(("pdmNsAllocateBandwidth: BwGroup=%#p{%s} disabled fAllowed=%RTbool\n",
-              pBwGroup, R3STRING(pBwGroup->pszNameR3), fAllowed));
+    {
+        ASMAtomicWriteU32(&pBwGroup->cbLastDenied, (uint32_t)RT_MIN(cbTransfer, UINT32_MAX));
+        if (!ASMAtomicXchgBool(&pFilter->fChoked, true))
+        {
+            ASMAtomicWriteU64(&pFilter->tsChoked, tsNow);
+            ASMAtomicIncU32(&pBwGroup->cFiltersChoked);
+        }
+        STAM_REL_COUNTER_INC(&pBwGroup->StatDenied);
+        STAM_REL_COUNTER_ADD(&pBwGroup->StatBytesDenied, cbTransfer);
+    }
 
-    rc = PDMCritSectLeave(&pBwGroup->Lock); AssertRC(rc);
+    Log2(("pdmNsAllocateBandwidth: BwGroup=%#p{%s} cbTransfer=%u cNsCost=%llu cNsBurst=%llu fAllowed=%RTbool\n",
+          pBwGroup, R3STRING(pBwGroup->pszNameR3), cbTransfer, cNsCost, cNsBurst, fAllowed));
     return fAllowed;
 }
 
@@ -29,9 +29,12 @@
 # include <VBox/vmm/mm.h>
 #endif
 #include <VBox/vmm/vm.h>
+#include <VBox/vmm/vmm.h>
+#include <VBox/sup.h>
 #include <VBox/err.h>
 #include <VBox/log.h>
 #include <iprt/asm.h>
+#include <iprt/asm-amd64-x86.h>
 #include <iprt/assert.h>
 
 
@@ -79,26 +82,57 @@ VMMDECL(void) PDMQueueInsert(PPDMQUEUE pQueue, PPDMQUEUEITEMCORE pItem)
 {
     Assert(VALID_PTR(pQueue) && pQueue->CTX_SUFF(pVM));
     Assert(VALID_PTR(pItem));
+    PVM pVM = pQueue->CTX_SUFF(pVM);
 
-#if 0 /* the paranoid android version: */
-    void *pvNext;
-    do
-    {
-        pvNext = ASMAtomicUoReadPtr((void * volatile *)&pQueue->CTX_SUFF(pPending));
-        ASMAtomicUoWritePtr((void * volatile *)&pItem->CTX_SUFF(pNext), pvNext);
-    } while (!ASMAtomicCmpXchgPtr(&pQueue->CTX_SUFF(pPending), pItem, pvNext));
-#else
+    /* For the latency statistics. */
+    if (!pQueue->u64FirstPendingTsc)
+        ASMAtomicCmpXchgU64(&pQueue->u64FirstPendingTsc, ASMReadTSC(), 0);
+
+    /*
+     * EMTs use the staging list of their VCPU, other threads (and raw-mode,
+     * which only has one VCPU) the shared list.
+     */
     PPDMQUEUEITEMCORE pNext;
-    do
+#ifndef IN_RC
+    PVMCPU pVCpu = VMMGetCpu(pVM);
+    if (pVCpu)
     {
-        pNext = pQueue->CTX_SUFF(pPending);
-        pItem->CTX_SUFF(pNext) = pNext;
-    } while (!ASMAtomicCmpXchgPtr(&pQueue->CTX_SUFF(pPending), pItem, pNext));
+        PPDMQUEUESTAGE pStage = &pQueue->aStages[pVCpu->idCpu % PDMQUEUE_STAGES];
+        do
+        {
+            pNext = pStage->CTX_SUFF(pPending);
+            pItem->CTX_SUFF(pNext) = pNext;
+        } while (!ASMAtomicCmpXchgPtr(&pStage->CTX_SUFF(pPending), pItem, pNext));
+        STAM_REL_COUNTER_INC(&pStage->StatInsert);
+    }
+    else
 #endif
+    {
+        do
+        {
+            pNext = pQueue->CTX_SUFF(pPending);
+            pItem->CTX_SUFF(pNext) = pNext;
+        } while (!ASMAtomicCmpXchgPtr(&pQueue->CTX_SUFF(pPending), pItem, pNext));
+        STAM_REL_COUNTER_INC(&pQueue->StatInsert);
+    }
 
+    /*
+     * Wake up the dedicated consumer thread directly if we can.
+     */
+#ifndef IN_RC
+    if (   pQueue->hEvtConsumer != NIL_SUPSEMEVENT
+# ifdef IN_RING0
+        && ASMIntAreEnabled()
+# endif
+       )
+    {
+        int rc = SUPSemEventSignal(pVM->pSession, pQueue->hEvtConsumer);
+        AssertRC(rc);
+    }
+    else
+#endif
     if (!pQueue->pTimer)
     {
-        PVM pVM = pQueue->CTX_SUFF(pVM);
         Log2(("PDMQueueInsert: VM_FF_PDM_QUEUES %d -> 1\n", VM_FF_IS_SET(pVM, VM_FF_PDM_QUEUES)));
         VM_FF_SET(pVM, VM_FF_PDM_QUEUES);
         ASMAtomicBitSet(&pVM->pdm.s.fQueueFlushing, PDM_QUEUE_FLUSH_FLAG_PENDING_BIT);
@@ -109,7 +143,6 @@ VMMDECL(void) PDMQueueInsert(PPDMQUEUE pQueue, PPDMQUEUEITEMCORE pItem)
         VMR3NotifyGlobalFFU(pVM->pUVM, VMNOTIFYFF_FLAGS_DONE_REM);
 #endif
     }
-    STAM_REL_COUNTER_INC(&pQueue->StatInsert);
     STAM_STATS({ ASMAtomicIncU32(&pQueue->cStatPending); });
 }
 
@@ -416,6 +416,10 @@ void pgmPhysInvalidatePageMapTLB(PVM pVM)
 
     /** @todo clear the RC TLB whenever we add it. */
 
+    /* The backing of any page may have changed. */
+    for (unsigned i = 0; i < RT_ELEMENTS(pVM->pgm.s.aCodePageTags); i++)
+        ASMAtomicWriteU64(&pVM->pgm.s.aCodePageTags[i].GCPhys, NIL_RTGCPHYS);
+
     pgmUnlock(pVM);
 }
 
@@ -1644,6 +1648,8 @@ VMMDECL(int) PGMPhysGCPhys2CCPtr(PVM pVM, RTGCPHYS GCPhys, void **ppv, PPGMPAGEM
     }
 
 #endif /* IN_RING3 || IN_RING0 */
+    if (RT_SUCCESS(rc))
+        PGM_PHYS_WRITE_GEN_BUMP(pVM, GCPhys);
     pgmUnlock(pVM);
     return rc;
 }
@@ -2783,6 +2789,7 @@ VMMDECL(int) PGMPhysWrite(PVM pVM, RTGCPHYS GCPhys, const void *pvBuf, size_t cb
                     || PGM_PAGE_IS_SPECIAL_ALIAS_MMIO(pPage))
                 {
                     int rc = pgmPhysWriteHandler(pVM, pPage, pRam->GCPhys + off, pvBuf, cb);
+                    PGM_PHYS_WRITE_GEN_BUMP(pVM, pRam->GCPhys + off);
                     if (RT_FAILURE(rc))
                     {
                         pgmUnlock(pVM);
@@ -2802,6 +2809,7 @@ VMMDECL(int) PGMPhysWrite(PVM pVM, RTGCPHYS GCPhys, const void *pvBuf, size_t cb
                         Assert(!PGM_PAGE_IS_BALLOONED(pPage));
                         memcpy(pvDst, pvBuf, cb);
                         pgmPhysReleaseInternalPageMappingLock(pVM, &PgMpLck);
+                        PGM_PHYS_WRITE_GEN_BUMP(pVM, pRam->GCPhys + off);
                     }
                     /* Ignore writes to ballooned pages. */
                     else if (!PGM_PAGE_IS_BALLOONED(pPage))
@@ -2953,12 +2961,14 @@ VMMDECL(int) PGMPhysSimpleWriteGCPhys(PVM pVM, RTGCPHYS GCPhysDst, const void *p
     {
         memcpy(pvDst, pvSrc, cb);
         PGMPhysReleasePageMappingLock(pVM, &Lock);
+        PGM_PHYS_WRITE_GEN_BUMP(pVM, GCPhysDst);
         return VINF_SUCCESS;
     }
 
     /* copy to the end of the page. */
     memcpy(pvDst, pvSrc, cbPage);
     PGMPhysReleasePageMappingLock(pVM, &Lock);
+    PGM_PHYS_WRITE_GEN_BUMP(pVM, GCPhysDst);
     GCPhysDst += cbPage;
     pvSrc = (const uint8_t *)pvSrc + cbPage;
     cb -= cbPage;
@@ -2978,12 +2988,14 @@ VMMDECL(int) PGMPhysSimpleWriteGCPhys(PVM pVM, RTGCPHYS GCPhysDst, const void *p
         {
             memcpy(pvDst, pvSrc, cb);
             PGMPhysReleasePageMappingLock(pVM, &Lock);
+            PGM_PHYS_WRITE_GEN_BUMP(pVM, GCPhysDst);
             return VINF_SUCCESS;
         }
 
         /* copy the entire page and advance */
         memcpy(pvDst, pvSrc, PAGE_SIZE);
         PGMPhysReleasePageMappingLock(pVM, &Lock);
+        PGM_PHYS_WRITE_GEN_BUMP(pVM, GCPhysDst);
         GCPhysDst += PAGE_SIZE;
         pvSrc = (const uint8_t *)pvSrc + PAGE_SIZE;
         cb -= PAGE_SIZE;
@@ -4127,6 +4139,8 @@ VMM_INT_DECL(int) PGMPhysIemGCPhys2Ptr(PVM pVM, PVMCPU pVCpu, RTGCPHYS GCPhys, b
             *ppv = (void *)((uintptr_t)pTlbe->pv | (uintptr_t)(GCPhys & PAGE_OFFSET_MASK));
 #endif
 
+            if (fWritable)
+                PGM_PHYS_WRITE_GEN_BUMP(pVM, GCPhys);
             Log6(("PGMPhysIemGCPhys2Ptr: GCPhys=%RGp rc=%Rrc pPage=%R[pgmpage] *ppv=%p\n", GCPhys, rc, pPage, *ppv));
         }
         else
@@ -4200,3 +4214,70 @@ VMM_INT_DECL(int) PGMPhysIemQueryAccess(PVM pVM, RTGCPHYS GCPhys, bool fWritable
     return rc;
 }
 
+
+/**
+ * Gets the write generation of a guest page tagged by PGMPhysIemTagCodePage.
+ *
+ * The value changes after the page has been written thru PGMPhysWrite,
+ * PGMPhysSimpleWriteGCPhys or PGMR3PhysWriteExternal, or mapped for writing by
+ * PGMPhysGCPhys2CCPtr, PGMR3PhysGCPhys2CCPtrExternal or PGMPhysIemGCPhys2Ptr.
+ * Writes done directly by guest code running in hardware assisted or raw mode
+ * are NOT reflected, so the caller must deal with that separately.
+ *
+ * @returns The write generation, 0 if the page is not tagged (any more).
+ * @param   pVM                 Pointer to the VM.
+ * @param   GCPhys              The guest physical address.
+ */
+VMM_INT_DECL(uint32_t) PGMPhysGetWriteGeneration(PVM pVM, RTGCPHYS GCPhys)
+{
+    /* The slot is retagged by first freeing it, so checking the address both
+       before and after reading the generation catches concurrent retagging. */
+    PPGMCODEPAGETAG pTag       = &pVM->pgm.s.aCodePageTags[PGM_CODE_PAGE_TAG_IDX(GCPhys)];
+    RTGCPHYS const  GCPhysPage = GCPhys & ~(RTGCPHYS)PAGE_OFFSET_MASK;
+    if (ASMAtomicReadU64(&pTag->GCPhys) == GCPhysPage)
+    {
+        uint32_t const uGen = ASMAtomicReadU32(&pTag->uGen);
+        if (ASMAtomicReadU64(&pTag->GCPhys) == GCPhysPage)
+            return uGen;
+    }
+    return 0;
+}
+
+
+/**
+ * Starts tracking writes to a guest page IEM wants to cache instructions
+ * from.
+ *
+ * Pages mapped for writing thru PGMPhysGCPhys2CCPtr are refused, as the
+ * mapping user can modify them at any time without PGM noticing.  Only a
+ * limited number of pages can be tagged, tagging a page may drop the tag of
+ * another.
+ *
+ * @returns The write generation of the page, to be checked against
+ *          PGMPhysGetWriteGeneration later.  0 if the page cannot be tracked.
+ * @param   pVM                 Pointer to the VM.
+ * @param   GCPhys              The guest physical address.
+ */
+VMM_INT_DECL(uint32_t) PGMPhysIemTagCodePage(PVM pVM, RTGCPHYS GCPhys)
+{
+    RTGCPHYS const GCPhysPage = GCPhys & ~(RTGCPHYS)PAGE_OFFSET_MASK;
+    uint32_t       uGen       = 0;
+
+    pgmLock(pVM);
+    PPGMPAGE pPage = pgmPhysGetPage(pVM, GCPhysPage);
+    if (   pPage
+        && !PGM_PAGE_GET_WRITE_LOCKS(pPage))
+    {
+        PPGMCODEPAGETAG pTag = &pVM->pgm.s.aCodePageTags[PGM_CODE_PAGE_TAG_IDX(GCPhysPage)];
+        if (pTag->GCPhys != GCPhysPage)
+        {
+            /* A fresh generation, writes to the page weren't tracked until now. */
+            ASMAtomicWriteU64(&pTag->GCPhys, NIL_RTGCPHYS);
+            ASMAtomicWriteU32(&pTag->uGen, pgmPhysNextCodePageGen(pVM));
+            ASMAtomicWriteU64(&pTag->GCPhys, GCPhysPage);
+        }
+        uGen = ASMAtomicReadU32(&pTag->uGen);
+    }
+    pgmUnlock(pVM);
+    return uGen;
+}
@@ -340,42 +340,46 @@ DECL_FORCE_INLINE(void) tmTimerQueueLinkActive(PTMTIMERQUEUE pQueue, PTMTIMER pT
     Assert(!pTimer->offPrev);
     Assert(pTimer->enmState == TMTIMERSTATE_ACTIVE || pTimer->enmClock != TMCLOCK_VIRTUAL_SYNC); /* (active is not a stable state) */
 
-    PTMTIMER pCur = TMTIMER_GET_HEAD(pQueue);
-    if (pCur)
+    /*
+     * Look up the last timer expiring at or before u64Expire in the index and
+     * link the new timer in right after it, i.e. behind any timers with the same
+     * expire time.  If there is no such timer, the new one becomes the head.
+     */
+    pTimer->ActiveCore.Key = u64Expire;
+    PAVLOGCPHYSNODECORE pCore = RTAvloGCPhysGetBestFit(&pQueue->ActiveTree, u64Expire, false /*fAbove*/);
+    if (pCore)
     {
-        for (;; pCur = TMTIMER_GET_NEXT(pCur))
+        const PTMTIMER pPrev = RT_FROM_MEMBER(pCore, TMTIMER, ActiveCore);
+        const PTMTIMER pNext = TMTIMER_GET_NEXT(pPrev);
+        TMTIMER_SET_NEXT(pTimer, pNext);
+        TMTIMER_SET_PREV(pTimer, pPrev);
+        TMTIMER_SET_NEXT(pPrev, pTimer);
+        if (pNext)
+            TMTIMER_SET_PREV(pNext, pTimer);
+        else
+            DBGFTRACE_U64_TAG2(pTimer->CTX_SUFF(pVM), u64Expire, "tmTimerQueueLinkActive tail", R3STRING(pTimer->pszDesc));
+
+        /* The new timer takes over as the index node for this expire time. */
+        if (pCore->Key == u64Expire)
         {
-            if (pCur->u64Expire > u64Expire)
-            {
-                const PTMTIMER pPrev = TMTIMER_GET_PREV(pCur);
-                TMTIMER_SET_NEXT(pTimer, pCur);
-                TMTIMER_SET_PREV(pTimer, pPrev);
-                if (pPrev)
-                    TMTIMER_SET_NEXT(pPrev, pTimer);
-                else
-                {
-                    TMTIMER_SET_HEAD(pQueue, pTimer);
-                    ASMAtomicWriteU64(&pQueue->u64Expire, u64Expire);
-                    DBGFTRACE_U64_TAG2(pTimer->CTX_SUFF(pVM), u64Expire, "tmTimerQueueLinkActive head", R3STRING(pTimer->pszDesc));
-                }
-                TMTIMER_SET_PREV(pCur, pTimer);
-                return;
-            }
-            if (!pCur->offNext)
-            {
-                TMTIMER_SET_NEXT(pCur, pTimer);
-                TMTIMER_SET_PREV(pTimer, pCur);
-                DBGFTRACE_U64_TAG2(pTimer->CTX_SUFF(pVM), u64Expire, "tmTimerQueueLinkActive tail", R3STRING(pTimer->pszDesc));
-                return;
-            }
+            pCore = RTAvloGCPhysRemove(&pQueue->ActiveTree, u64Expire);
+            Assert(pCore == &pPrev->ActiveCore);
         }
     }
     else
     {
+        const PTMTIMER pNext = TMTIMER_GET_HEAD(pQueue);
+        TMTIMER_SET_NEXT(pTimer, pNext);
+        if (pNext)
+            TMTIMER_SET_PREV(pNext, pTimer);
         TMTIMER_SET_HEAD(pQueue, pTimer);
         ASMAtomicWriteU64(&pQueue->u64Expire, u64Expire);
-        DBGFTRACE_U64_TAG2(pTimer->CTX_SUFF(pVM), u64Expire, "tmTimerQueueLinkActive empty", R3STRING(pTimer->pszDesc));
+        DBGFTRACE_U64_TAG2(pTimer->CTX_SUFF(pVM), u64Expire, pNext ? "tmTimerQueueLinkActive head" : "tmTimerQueueLinkActive empty",
+                           R3STRING(pTimer->pszDesc));
     }
+
+    bool fRc = RTAvloGCPhysInsert(&pQueue->ActiveTree, &pTimer->ActiveCore);
+    Assert(fRc); NOREF(fRc);
 }
 
 
@@ -543,6 +547,15 @@ void tmTimerQueuesSanityChecks(PVM pVM, const char *pszWhere)
         {
             AssertMsg((int)pCur->enmClock == i, ("%s: %d != %d\n", pszWhere, pCur->enmClock, i));
             AssertMsg(TMTIMER_GET_PREV(pCur) == pPrev, ("%s: %p != %p\n", pszWhere, TMTIMER_GET_PREV(pCur), pPrev));
+
+            /* The expire time index: sorted, with the last timer of each expire time in the tree. */
+            PTMTIMER const pNext = TMTIMER_GET_NEXT(pCur);
+            AssertMsg(!pPrev || pPrev->ActiveCore.Key <= pCur->ActiveCore.Key,
+                      ("%s: %RX64 > %RX64\n", pszWhere, pPrev->ActiveCore.Key, pCur->ActiveCore.Key));
+            AssertMsg(   (RTAvloGCPhysGet(&pQueue->ActiveTree, pCur->ActiveCore.Key) == &pCur->ActiveCore)
+                      == (!pNext || pNext->ActiveCore.Key != pCur->ActiveCore.Key),
+                      ("%s: %p (%s) index mismatch\n", pszWhere, pCur, R3STRING(pCur->pszDesc)));
+
             TMTIMERSTATE enmState = pCur->enmState;
             switch (enmState)
             {
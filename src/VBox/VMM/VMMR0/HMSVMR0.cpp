@@ -29,6 +29,7 @@
 #include <VBox/vmm/dbgf.h>
 #include <VBox/vmm/iom.h>
 #include <VBox/vmm/tm.h>
+#include "VMMTracing.h"
 
 #ifdef DEBUG_ramshankar
 # define HMSVM_SYNC_FULL_GUEST_STATE
@@ -3190,7 +3191,9 @@ VMMR0DECL(int) SVMR0RunGuestCode(PVM pVM, PVMCPU pVCpu, PCPUMCTX pCtx)
         /* Handle the #VMEXIT. */
         HMSVM_EXITCODE_STAM_COUNTER_INC(SvmTransient.u64ExitCode);
         STAM_PROFILE_ADV_STOP_START(&pVCpu->hm.s.StatExit1, &pVCpu->hm.s.StatExit2, x);
+        uint64_t const uExitTraceTsc = VMM_EXIT_TRACE_START(pVCpu);
         rc = hmR0SvmHandleExit(pVCpu, pCtx, &SvmTransient);
+        VMM_EXIT_TRACE_END(pVCpu, uExitTraceTsc, DBGFEXITSRC_HM_SVM, (uint32_t)SvmTransient.u64ExitCode, pCtx->rip, 0, 0);
         STAM_PROFILE_ADV_STOP(&pVCpu->hm.s.StatExit2, x);
         if (rc != VINF_SUCCESS)
             break;
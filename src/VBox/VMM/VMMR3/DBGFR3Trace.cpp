@@ -21,6 +21,7 @@
 *******************************************************************************/
 #define LOG_GROUP LOG_GROUP_DBGF
 #include <VBox/vmm/dbgftrace.h>
+#include <iprt/asm-amd64-x86.h> /* for SUPGetCpuHzFromGIP from sup.h  */
 #include <VBox/vmm/cfgm.h>
 #include <VBox/vmm/mm.h>
 #include <VBox/vmm/pdmapi.h>
@@ -31,9 +32,12 @@
 #include <VBox/err.h>
 #include <VBox/log.h>
 #include <VBox/param.h>
+#include <VBox/sup.h>
 
 #include <iprt/assert.h>
 #include <iprt/ctype.h>
+#include <iprt/file.h>
+#include <iprt/string.h>
 #include <iprt/trace.h>
 
 
@@ -41,6 +45,7 @@
 *   Internal Functions                                                         *
 *******************************************************************************/
 static DECLCALLBACK(void) dbgfR3TraceInfo(PVM pVM, PCDBGFINFOHLP pHlp, const char *pszArgs);
+static DECLCALLBACK(void) dbgfR3ExitTraceInfo(PVM pVM, PCDBGFINFOHLP pHlp, const char *pszArgs);
 
 
 /*******************************************************************************
@@ -62,6 +67,20 @@ static const struct
     {  RT_STR_TUPLE("em"), VMMTPGROUP_EM },
     {  RT_STR_TUPLE("hm"), VMMTPGROUP_HM },
     {  RT_STR_TUPLE("tm"), VMMTPGROUP_TM },
+    {  RT_STR_TUPLE("exit"), VMMTPGROUP_EXIT },
+};
+
+/** Exit trace source names, indexed by DBGFEXITSRC. */
+static const char * const g_apszExitSrcs[DBGFEXITSRC_END] =
+{
+    "invalid",
+    "vmx",
+    "svm",
+    "iem",
+    "port-read",
+    "port-write",
+    "mmio-read",
+    "mmio-write",
 };
 
 
@@ -129,6 +148,60 @@ static int dbgfR3TraceEnable(PVM pVM, uint32_t cbEntry, uint32_t cEntries)
 }
 
 
+/**
+ * Allocates the per virtual CPU exit trace rings and enables exit tracing if
+ * configured to do so.
+ *
+ * @returns VBox status code
+ * @param   pVM                 Pointer to the VM.
+ * @param   pDbgfNode           The DBGF CFGM node (can be NULL).
+ */
+static int dbgfR3ExitTraceInit(PVM pVM, PCFGMNODE pDbgfNode)
+{
+    PCFGMNODE pCfg = CFGMR3GetChild(pDbgfNode, "ExitTrace");
+
+    /** @cfgm{/DBGF/ExitTrace/Enabled, bool, false}
+     * Whether to allocate the per virtual CPU exit trace rings and start
+     * recording exits right away.  Recording can be toggled at runtime using the
+     * 'exit' trace point group. */
+    bool fEnabled;
+    int rc = CFGMR3QueryBoolDef(pCfg, "Enabled", &fEnabled, false);
+    AssertLogRelRCReturn(rc, rc);
+    if (!fEnabled)
+        return VINF_SUCCESS;
+
+    /** @cfgm{/DBGF/ExitTrace/Entries, uint32_t, 8192, 64, 1048576}
+     * The number of entries in each virtual CPU exit trace ring.  Must be a
+     * power of two. */
+    uint32_t cEntries;
+    rc = CFGMR3QueryU32Def(pCfg, "Entries", &cEntries, 8192);
+    AssertLogRelRCReturn(rc, rc);
+    if (   cEntries < 64
+        || cEntries > _1M
+        || !RT_IS_POWER_OF_TWO(cEntries))
+        return VMSetError(pVM, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                          N_("Configuration error: /DBGF/ExitTrace/Entries must be a power of two between 64 and 1048576"));
+
+    size_t const cbRing = RT_ALIGN_Z(RT_OFFSETOF(DBGFEXITTRACERING, aEntries[cEntries]), PAGE_SIZE);
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+    {
+        PVMCPU pVCpu = &pVM->aCpus[idCpu];
+        PDBGFEXITTRACERING pRing;
+        rc = MMR3HyperAllocOnceNoRel(pVM, cbRing, PAGE_SIZE, MM_TAG_DBGF, (void **)&pRing);
+        if (RT_FAILURE(rc))
+            return rc;
+        pRing->cAdded = 0;
+        pRing->fMask  = cEntries - 1;
+        pVCpu->dbgf.s.pExitTraceR3 = pRing;
+        pVCpu->dbgf.s.pExitTraceR0 = MMHyperR3ToR0(pVM, pRing);
+        pVCpu->dbgf.s.pExitTraceRC = MMHyperR3ToRC(pVM, pRing);
+        pVCpu->fTraceGroups |= VMMTPGROUP_EXIT;
+    }
+    LogRel(("DBGF: Exit tracing enabled, %u entries per virtual CPU\n", cEntries));
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Initializes the tracing.
  *
@@ -186,10 +259,20 @@ int dbgfR3TraceInit(PVM pVM)
     }
 
     /*
-     * Register a debug info item that will dump the trace buffer content.
+     * The exit trace rings.
+     */
+    if (RT_SUCCESS(rc))
+        rc = dbgfR3ExitTraceInit(pVM, pDbgfNode);
+
+    /*
+     * Register debug info items that will dump the trace buffer content.
      */
     if (RT_SUCCESS(rc))
         rc = DBGFR3InfoRegisterInternal(pVM, "tracebuf", "Display the trace buffer content. No arguments.", dbgfR3TraceInfo);
+    if (RT_SUCCESS(rc))
+        rc = DBGFR3InfoRegisterInternal(pVM, "exittrace",
+                                        "Display the most recent exit trace entries. Optional argument: entries per CPU.",
+                                        dbgfR3ExitTraceInfo);
 
     return rc;
 }
@@ -202,8 +285,23 @@ int dbgfR3TraceInit(PVM pVM)
  */
 void dbgfR3TraceTerm(PVM pVM)
 {
-    /* nothing to do */
-    NOREF(pVM);
+    /*
+     * Dump the exit trace rings if configured to do so.
+     */
+    if (pVM->aCpus[0].dbgf.s.pExitTraceR3)
+    {
+        /** @cfgm{/DBGF/ExitTrace/DumpFile, string, none}
+         * File to dump the exit trace rings to when the VM is destroyed. */
+        char *pszFile;
+        int rc = CFGMR3QueryStringAllocDef(CFGMR3GetChild(CFGMR3GetRoot(pVM), "DBGF/ExitTrace"), "DumpFile", &pszFile, NULL);
+        if (RT_SUCCESS(rc) && pszFile)
+        {
+            rc = DBGFR3ExitTraceDump(pVM, pszFile);
+            if (RT_FAILURE(rc))
+                LogRel(("DBGF: Failed to dump the exit trace to '%s': %Rrc\n", pszFile, rc));
+            MMR3HeapFree(pszFile);
+        }
+    }
 }
 
 
@@ -216,6 +314,9 @@ void dbgfR3TraceRelocate(PVM pVM)
 {
     if (pVM->hTraceBufR3 != NIL_RTTRACEBUF)
         pVM->hTraceBufRC = MMHyperCCToRC(pVM, pVM->hTraceBufR3);
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+        if (pVM->aCpus[idCpu].dbgf.s.pExitTraceR3)
+            pVM->aCpus[idCpu].dbgf.s.pExitTraceRC = MMHyperR3ToRC(pVM, pVM->aCpus[idCpu].dbgf.s.pExitTraceR3);
 }
 
 
@@ -445,3 +546,103 @@ static DECLCALLBACK(void) dbgfR3TraceInfo(PVM pVM, PCDBGFINFOHLP pHlp, const cha
     NOREF(pszArgs);
 }
 
+
+/**
+ * Dumps the exit trace rings to a file.
+ *
+ * The file format is described by DBGFEXITTRACEFILEHDR and can be analyzed
+ * using the VBoxExitTraceAnalyzer tool.  The entries are copied without
+ * stopping the EMTs, so the oldest entries may be inconsistent unless the VM
+ * is suspended.
+ *
+ * @returns VBox status code.
+ * @retval  VERR_DBGF_NO_TRACE_BUFFER if exit tracing isn't enabled.
+ * @param   pVM                 Pointer to the VM.
+ * @param   pszFilename         The file to write the trace to.
+ */
+VMMR3DECL(int) DBGFR3ExitTraceDump(PVM pVM, const char *pszFilename)
+{
+    VM_ASSERT_VALID_EXT_RETURN(pVM, VERR_INVALID_VM_HANDLE);
+    AssertPtrReturn(pszFilename, VERR_INVALID_POINTER);
+    if (!pVM->aCpus[0].dbgf.s.pExitTraceR3)
+        return VERR_DBGF_NO_TRACE_BUFFER;
+
+    RTFILE hFile;
+    int rc = RTFileOpen(&hFile, pszFilename, RTFILE_O_WRITE | RTFILE_O_CREATE_REPLACE | RTFILE_O_DENY_WRITE);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    DBGFEXITTRACEFILEHDR Hdr;
+    RT_ZERO(Hdr);
+    Hdr.u32Magic   = DBGFEXITTRACEFILEHDR_MAGIC;
+    Hdr.u32Version = DBGFEXITTRACEFILEHDR_VERSION;
+    Hdr.u64TscHz   = SUPGetCpuHzFromGIP(g_pSUPGlobalInfoPage);
+    Hdr.cCpus      = pVM->cCpus;
+    Hdr.cbEntry    = sizeof(DBGFEXITTRACEENTRY);
+    CFGMR3QueryString(CFGMR3GetRoot(pVM), "Name", Hdr.szName, sizeof(Hdr.szName));
+    rc = RTFileWrite(hFile, &Hdr, sizeof(Hdr), NULL);
+
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus && RT_SUCCESS(rc); idCpu++)
+    {
+        PDBGFEXITTRACERING  pRing    = pVM->aCpus[idCpu].dbgf.s.pExitTraceR3;
+        uint32_t const      cEntries = pRing->fMask + 1;
+        uint64_t const      cAdded   = ASMAtomicReadU64(&pRing->cAdded);
+
+        DBGFEXITTRACEFILECPU Cpu;
+        Cpu.idCpu    = idCpu;
+        Cpu.cEntries = (uint32_t)RT_MIN(cAdded, cEntries);
+        Cpu.cLost    = cAdded - Cpu.cEntries;
+        rc = RTFileWrite(hFile, &Cpu, sizeof(Cpu), NULL);
+        if (RT_FAILURE(rc))
+            break;
+
+        /* Oldest first, i.e. the part after the wrap point before the start. */
+        uint32_t const iFirst = (uint32_t)(cAdded - Cpu.cEntries) & pRing->fMask;
+        uint32_t const cTail  = RT_MIN(Cpu.cEntries, cEntries - iFirst);
+        rc = RTFileWrite(hFile, &pRing->aEntries[iFirst], cTail * sizeof(DBGFEXITTRACEENTRY), NULL);
+        if (RT_SUCCESS(rc) && cTail < Cpu.cEntries)
+            rc = RTFileWrite(hFile, &pRing->aEntries[0], (Cpu.cEntries - cTail) * sizeof(DBGFEXITTRACEENTRY), NULL);
+    }
+
+    int rc2 = RTFileClose(hFile);
+    if (RT_SUCCESS(rc))
+        rc = rc2;
+    if (RT_FAILURE(rc))
+        RTFileDelete(pszFilename);
+    return rc;
+}
+
+
+/**
+ * @callback_method_impl{FNDBGFHANDLERINT, Info handler for displaying the exit trace rings.}
+ */
+static DECLCALLBACK(void) dbgfR3ExitTraceInfo(PVM pVM, PCDBGFINFOHLP pHlp, const char *pszArgs)
+{
+    if (!pVM->aCpus[0].dbgf.s.pExitTraceR3)
+    {
+        pHlp->pfnPrintf(pHlp, "Exit tracing is disabled\n");
+        return;
+    }
+
+    uint32_t cMax = 32;
+    if (pszArgs && *pszArgs)
+        RTStrToUInt32Full(RTStrStripL(pszArgs), 0, &cMax);
+
+    for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+    {
+        PDBGFEXITTRACERING  pRing  = pVM->aCpus[idCpu].dbgf.s.pExitTraceR3;
+        uint64_t const      cAdded = ASMAtomicReadU64(&pRing->cAdded);
+        uint32_t const      cShow  = (uint32_t)RT_MIN(RT_MIN(cAdded, (uint64_t)pRing->fMask + 1), cMax);
+        pHlp->pfnPrintf(pHlp, "VCPU %u: %'llu entries recorded, %u slots, recording %s\n", idCpu, cAdded,
+                        pRing->fMask + 1, pVM->aCpus[idCpu].fTraceGroups & VMMTPGROUP_EXIT ? "on" : "off");
+        for (uint64_t i = cAdded - cShow; i < cAdded; i++)
+        {
+            DBGFEXITTRACEENTRY const *pEntry = &pRing->aEntries[i & pRing->fMask];
+            pHlp->pfnPrintf(pHlp, "  %016llx %-10s %#06x rip=%016llx addr=%016llx dev=%05u %'10u ticks\n",
+                            pEntry->u64Tsc,
+                            pEntry->enmSrc < RT_ELEMENTS(g_apszExitSrcs) ? g_apszExitSrcs[pEntry->enmSrc] : "???",
+                            pEntry->uReason, pEntry->uRip, pEntry->uAddr, pEntry->idHandler, pEntry->cTicks);
+        }
+    }
+}
+
@@ -135,6 +135,25 @@ VMMR3_INT_DECL(int) EMR3Init(PVM pVM)
     rc = CFGMR3QueryBoolDef(pCfgEM, "IemExecutesAll", &pVM->em.s.fIemExecutesAll, false);
     AssertLogRelRCReturn(rc, rc);
 
+    /** @cfgm{/EM/IemInsteadOfRem, boolean, false}
+     * Whether to keep code HM cannot execute in IEM rather than handing it
+     * over to the recompiler after a while.  This avoids the REM state sync
+     * on hosts without unrestricted guest execution.  The recompiler is still
+     * used for instructions IEM doesn't implement. */
+    rc = CFGMR3QueryBoolDef(pCfgEM, "IemInsteadOfRem", &pVM->em.s.fIemInsteadOfRem, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/EM/IemMaxInstructions, uint32_t, 1, 4096, 64}
+     * The max number of instructions IEM executes before returning to EM.  IEM
+     * returns earlier when force action flags are pending, timers expire or the
+     * CPU mode changes. */
+    rc = CFGMR3QueryU32Def(pCfgEM, "IemMaxInstructions", &pVM->em.s.cIemMaxInstructions, 64);
+    AssertLogRelRCReturn(rc, rc);
+    if (pVM->em.s.cIemMaxInstructions < 1 || pVM->em.s.cIemMaxInstructions > 4096)
+        return VMSetError(pVM, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                          N_("Configuration error: /EM/IemMaxInstructions must be in the range 1..4096, not %u"),
+                          pVM->em.s.cIemMaxInstructions);
+
     rc = CFGMR3QueryBoolDef(pCfgEM, "TripleFaultReset", &fEnabled, false);
     AssertLogRelRCReturn(rc, rc);
     pVM->em.s.fGuruOnTripleFault = !fEnabled;
@@ -146,6 +165,7 @@ VMMR3_INT_DECL(int) EMR3Init(PVM pVM)
 
     Log(("EMR3Init: fRecompileUser=%RTbool fRecompileSupervisor=%RTbool fRawRing1Enabled=%RTbool fIemExecutesAll=%RTbool fGuruOnTripleFault=%RTbool\n",
          pVM->fRecompileUser, pVM->fRecompileSupervisor, pVM->fRawRing1Enabled, pVM->em.s.fIemExecutesAll, pVM->em.s.fGuruOnTripleFault));
+    LogRel(("EM: fIemInsteadOfRem=%RTbool cIemMaxInstructions=%u\n", pVM->em.s.fIemInsteadOfRem, pVM->em.s.cIemMaxInstructions));
 
 #ifdef VBOX_WITH_REM
     /*
@@ -1139,7 +1159,7 @@ static int emR3RemExecute(PVM pVM, PVMCPU pVCpu, bool *pfFFDone)
 #ifdef VBOX_WITH_REM
             rc = REMR3Run(pVM, pVCpu);
 #else
-            rc = VBOXSTRICTRC_TODO(IEMExecLots(pVCpu));
+            rc = VBOXSTRICTRC_TODO(IEMExecLots(pVCpu, pVM->em.s.cIemMaxInstructions, NULL));
 #endif
             STAM_PROFILE_STOP(&pVCpu->em.s.StatREMExec, c);
         }
@@ -1262,6 +1282,8 @@ int emR3SingleStepExecRem(PVM pVM, PVMCPU pVCpu, uint32_t cIterations)
  * Try execute the problematic code in IEM first, then fall back on REM if there
  * is too much of it or if IEM doesn't implement something.
  *
+ * With /EM/IemInsteadOfRem set, only the latter causes a switch to REM.
+ *
  * @returns Strict VBox status code from IEMExecLots.
  * @param   pVM         The cross context VM structure.
  * @param   pVCpu       The cross context CPU structure for the calling EMT.
@@ -1277,21 +1299,22 @@ static VBOXSTRICTRC emR3ExecuteIemThenRem(PVM pVM, PVMCPU pVCpu, bool *pfFFDone)
     /*
      * Execute in IEM for a while.
      */
-    while (pVCpu->em.s.cIemThenRemInstructions < 1024)
+    while (   pVCpu->em.s.cIemThenRemInstructions < 1024
+           || pVM->em.s.fIemInsteadOfRem)
     {
-        VBOXSTRICTRC rcStrict = IEMExecLots(pVCpu);
+        uint32_t     cInstructions = 0;
+        VBOXSTRICTRC rcStrict = IEMExecLots(pVCpu, pVM->em.s.cIemMaxInstructions, &cInstructions);
+        pVCpu->em.s.cIemThenRemInstructions += cInstructions;
         if (rcStrict != VINF_SUCCESS)
         {
             if (   rcStrict == VERR_IEM_ASPECT_NOT_IMPLEMENTED
                 || rcStrict == VERR_IEM_INSTR_NOT_IMPLEMENTED)
                 break;
 
-            pVCpu->em.s.cIemThenRemInstructions++;
             Log(("emR3ExecuteIemThenRem: returns %Rrc after %u instructions\n",
                  VBOXSTRICTRC_VAL(rcStrict), pVCpu->em.s.cIemThenRemInstructions));
             return rcStrict;
         }
-        pVCpu->em.s.cIemThenRemInstructions++;
 
         EMSTATE enmNewState = emR3Reschedule(pVM, pVCpu, pVCpu->em.s.pCtx);
         if (enmNewState != EMSTATE_REM && enmNewState != EMSTATE_IEM_THEN_REM)
@@ -2451,6 +2474,16 @@ VMMR3_INT_DECL(int) EMR3ExecuteVM(PVM pVM, PVMCPU pVCpu)
                     LogFlow(("EMR3ExecuteVM: Clearing MWAIT\n"));
                     pVCpu->em.s.MWait.fWait &= ~(EMMWAIT_FLAG_ACTIVE | EMMWAIT_FLAG_BREAKIRQIF0);
                 }
+
+                /* The guest may have modified code while executing elsewhere,
+                   so IEM cannot trust its decoded instruction cache anymore. */
+                if (   enmNewState == EMSTATE_IEM
+                    || enmNewState == EMSTATE_IEM_THEN_REM
+#ifndef VBOX_WITH_REM
+                    || enmNewState == EMSTATE_REM
+#endif
+                   )
+                    IEMDecodeCacheFlush(pVCpu);
             }
             else
                 VBOXVMM_EM_STATE_UNCHANGED(pVCpu, enmNewState, rc);
@@ -2503,7 +2536,7 @@ VMMR3_INT_DECL(int) EMR3ExecuteVM(PVM pVM, PVMCPU pVCpu)
                         rc = VINF_SUCCESS;
                     else if (rc == VERR_EM_CANNOT_EXEC_GUEST)
 #endif
-                        rc = VBOXSTRICTRC_TODO(IEMExecLots(pVCpu));
+                        rc = VBOXSTRICTRC_TODO(IEMExecLots(pVCpu, pVM->em.s.cIemMaxInstructions, NULL));
                     if (pVM->em.s.fIemExecutesAll)
                     {
                         Assert(rc != VINF_EM_RESCHEDULE_REM);
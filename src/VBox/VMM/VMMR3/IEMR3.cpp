@@ -64,6 +64,17 @@ VMMR3DECL(int)      IEMR3Init(PVM pVM)
                         "Error statuses returned",           "/IEM/CPU%u/cRetErrStatuses", idCpu);
         STAMR3RegisterF(pVM, &pVCpu->iem.s.cbWritten,                 STAMTYPE_U32,       STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,
                         "Approx bytes written",              "/IEM/CPU%u/cbWritten", idCpu);
+        STAMR3RegisterF(pVM, &pVCpu->iem.s.cDecodeCacheHits,          STAMTYPE_U32,       STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Decoded instruction cache hits",    "/IEM/CPU%u/cDecodeCacheHits", idCpu);
+        STAMR3RegisterF(pVM, &pVCpu->iem.s.cDecodeCacheMisses,        STAMTYPE_U32,       STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Decoded instruction cache misses",  "/IEM/CPU%u/cDecodeCacheMisses", idCpu);
+        STAMR3RegisterF(pVM, &pVCpu->iem.s.cDecodeCacheFlushes,       STAMTYPE_U32,       STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,
+                        "Decoded instruction cache flushes", "/IEM/CPU%u/cDecodeCacheFlushes", idCpu);
+
+        /* The structure is zeroed, which isn't a free entry. */
+        for (unsigned i = 0; i < RT_ELEMENTS(pVCpu->iem.s.aDecodeCache); i++)
+            pVCpu->iem.s.aDecodeCache[i].GCPhys = NIL_RTGCPHYS;
+        pVCpu->iem.s.GCPhysDecodeFill = NIL_RTGCPHYS;
 
         /*
          * Host and guest CPU information.
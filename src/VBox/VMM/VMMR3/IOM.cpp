@@ -102,6 +102,7 @@
 #define LOG_GROUP LOG_GROUP_IOM
 #include <VBox/vmm/iom.h>
 #include <VBox/vmm/cpum.h>
+#include <VBox/vmm/cfgm.h>
 #include <VBox/vmm/pgm.h>
 #include <VBox/sup.h>
 #include <VBox/vmm/hm.h>
@@ -221,6 +222,39 @@ VMMR3_INT_DECL(int) IOMR3Init(PVM pVM)
         STAM_REG(pVM, &pVM->iom.s.StatInstOut,            STAMTYPE_COUNTER, "/IOM/IOWork/Out",                          STAMUNIT_OCCURENCES,     "Counter of any OUT instructions.");
         STAM_REG(pVM, &pVM->iom.s.StatInstIns,            STAMTYPE_COUNTER, "/IOM/IOWork/Ins",                          STAMUNIT_OCCURENCES,     "Counter of any INS instructions.");
         STAM_REG(pVM, &pVM->iom.s.StatInstOuts,           STAMTYPE_COUNTER, "/IOM/IOWork/Outs",                         STAMUNIT_OCCURENCES,     "Counter of any OUTS instructions.");
+        STAM_REG(pVM, &pVM->iom.s.StatMMIOLookupLastHit,  STAMTYPE_COUNTER, "/IOM/Lookup/MMIO/LastHit",                 STAMUNIT_OCCURENCES,     "MMIO range lookups satisfied by the last hit pointer.");
+        STAM_REG(pVM, &pVM->iom.s.StatMMIOLookupCacheHit, STAMTYPE_COUNTER, "/IOM/Lookup/MMIO/CacheHit",                STAMUNIT_OCCURENCES,     "MMIO range lookups satisfied by the per-VCPU lookup cache.");
+        STAM_REG(pVM, &pVM->iom.s.StatMMIOLookupTree,     STAMTYPE_COUNTER, "/IOM/Lookup/MMIO/Tree",                    STAMUNIT_OCCURENCES,     "MMIO range lookups requiring a tree walk.");
+        STAM_REG(pVM, &pVM->iom.s.StatIOPortLookupLastHit,  STAMTYPE_COUNTER, "/IOM/Lookup/IOPort/LastHit",             STAMUNIT_OCCURENCES,     "I/O port range lookups satisfied by the last hit pointer.");
+        STAM_REG(pVM, &pVM->iom.s.StatIOPortLookupCacheHit, STAMTYPE_COUNTER, "/IOM/Lookup/IOPort/CacheHit",            STAMUNIT_OCCURENCES,     "I/O port range lookups satisfied by the per-VCPU lookup cache.");
+        STAM_REG(pVM, &pVM->iom.s.StatIOPortLookupTree,     STAMTYPE_COUNTER, "/IOM/Lookup/IOPort/Tree",                STAMUNIT_OCCURENCES,     "I/O port range lookups requiring a tree walk.");
+        STAM_REG(pVM, &pVM->iom.s.StatMMIODecCacheHit,    STAMTYPE_COUNTER, "/IOM/MMIODecCache/Hit",                    STAMUNIT_OCCURENCES,     "MMIO accesses carried out without disassembling the instruction.");
+        STAM_REG(pVM, &pVM->iom.s.StatMMIODecCacheMiss,   STAMTYPE_COUNTER, "/IOM/MMIODecCache/Miss",                   STAMUNIT_OCCURENCES,     "MMIO accesses not found in the decode cache.");
+        STAM_REG(pVM, &pVM->iom.s.StatMMIODecCacheStale,  STAMTYPE_COUNTER, "/IOM/MMIODecCache/Stale",                  STAMUNIT_OCCURENCES,     "Decode cache entries dropped because the instruction bytes changed.");
+        STAM_REG(pVM, &pVM->iom.s.StatMMIODecCacheInsert, STAMTYPE_COUNTER, "/IOM/MMIODecCache/Insert",                 STAMUNIT_OCCURENCES,     "Instructions added to the decode cache.");
+
+        /*
+         * The MMIO decode cache.  Only used with HM, raw-mode has PATM to
+         * think about and can't reach the hyper heap the same way anyway.
+         */
+        /** @cfgm{/IOM/MmioDecodeCache, bool, true}
+         * Whether to remember the decoding of instructions doing MMIO so that
+         * repeated exits from the same instruction needn't disassemble it. */
+        bool fDecCache;
+        rc = CFGMR3QueryBoolDef(CFGMR3GetChild(CFGMR3GetRoot(pVM), "IOM"), "MmioDecodeCache", &fDecCache, true);
+        AssertLogRelRCReturn(rc, rc);
+        if (fDecCache && HMIsEnabled(pVM))
+        {
+            for (VMCPUID idCpu = 0; idCpu < pVM->cCpus; idCpu++)
+            {
+                PVMCPU           pVCpu = &pVM->aCpus[idCpu];
+                PIOMMMIODECCACHE pCache;
+                rc = MMR3HyperAllocOnceNoRel(pVM, sizeof(*pCache), 0, MM_TAG_IOM, (void **)&pCache);
+                AssertLogRelRCReturn(rc, rc);
+                pVCpu->iom.s.pMmioDecCacheR3 = pCache;
+                pVCpu->iom.s.pMmioDecCacheR0 = MMHyperR3ToR0(pVM, pCache);
+            }
+        }
     }
 
     /* Redundant, but just in case we change something in the future */
@@ -270,6 +304,16 @@ static void iomR3FlushCache(PVM pVM)
         pVCpu->iom.s.pStatsLastWriteRC = NIL_RTRCPTR;
         pVCpu->iom.s.pMMIORangeLastRC  = NIL_RTRCPTR;
         pVCpu->iom.s.pMMIOStatsLastRC  = NIL_RTRCPTR;
+
+        for (unsigned i = 0; i < IOM_RANGE_CACHE_SIZE; i++)
+        {
+            pVCpu->iom.s.apMMIORangeCacheR3[i]   = NULL;
+            pVCpu->iom.s.apIOPortRangeCacheR3[i] = NULL;
+            pVCpu->iom.s.apMMIORangeCacheR0[i]   = NIL_RTR0PTR;
+            pVCpu->iom.s.apIOPortRangeCacheR0[i] = NIL_RTR0PTR;
+            pVCpu->iom.s.apMMIORangeCacheRC[i]   = NIL_RTRCPTR;
+            pVCpu->iom.s.apIOPortRangeCacheRC[i] = NIL_RTRCPTR;
+        }
     }
 
     IOM_UNLOCK_EXCL(pVM);
@@ -324,6 +368,11 @@ VMMR3_INT_DECL(void) IOMR3Relocate(PVM pVM, RTGCINTPTR offDelta)
         pVCpu->iom.s.pStatsLastWriteRC = NIL_RTRCPTR;
         pVCpu->iom.s.pMMIORangeLastRC  = NIL_RTRCPTR;
         pVCpu->iom.s.pMMIOStatsLastRC  = NIL_RTRCPTR;
+        for (unsigned i = 0; i < IOM_RANGE_CACHE_SIZE; i++)
+        {
+            pVCpu->iom.s.apMMIORangeCacheRC[i]   = NIL_RTRCPTR;
+            pVCpu->iom.s.apIOPortRangeCacheRC[i] = NIL_RTRCPTR;
+        }
     }
 }
 
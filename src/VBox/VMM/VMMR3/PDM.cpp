@@ -321,7 +321,9 @@ typedef PDMNOTIFYASYNCSTATS *PPDMNOTIFYASYNCSTATS;
 *   Internal Functions                                                         *
 *******************************************************************************/
 static DECLCALLBACK(int) pdmR3LiveExec(PVM pVM, PSSMHANDLE pSSM, uint32_t uPass);
+static DECLCALLBACK(int) pdmR3SavePrep(PVM pVM, PSSMHANDLE pSSM);
 static DECLCALLBACK(int) pdmR3SaveExec(PVM pVM, PSSMHANDLE pSSM);
+static DECLCALLBACK(int) pdmR3SaveDone(PVM pVM, PSSMHANDLE pSSM);
 static DECLCALLBACK(int) pdmR3LoadExec(PVM pVM, PSSMHANDLE pSSM, uint32_t uVersion, uint32_t uPass);
 static DECLCALLBACK(int) pdmR3LoadPrep(PVM pVM, PSSMHANDLE pSSM);
 
@@ -344,6 +346,7 @@ VMMR3_INT_DECL(int) PDMR3InitUVM(PUVM pUVM)
     pUVM->pdm.s.pModules   = NULL;
     pUVM->pdm.s.pCritSects = NULL;
     pUVM->pdm.s.pRwCritSects = NULL;
+    pUVM->pdm.s.fQueueConsumerPark = PDM_QUEUE_PARK_F_STATE;
     return RTCritSectInit(&pUVM->pdm.s.ListCritSect);
 }
 
@@ -411,7 +414,7 @@ VMMR3_INT_DECL(int) PDMR3Init(PVM pVM)
          */
         rc = SSMR3RegisterInternal(pVM, "pdm", 1, PDM_SAVED_STATE_VERSION, 128,
                                    NULL, pdmR3LiveExec, NULL,
-                                   NULL, pdmR3SaveExec, NULL,
+                                   pdmR3SavePrep, pdmR3SaveExec, pdmR3SaveDone,
                                    pdmR3LoadPrep, pdmR3LoadExec, NULL);
         if (RT_SUCCESS(rc))
         {
@@ -680,6 +683,9 @@ VMMR3_INT_DECL(int) PDMR3Term(PVM pVM)
     {
         pdmR3TermLuns(pVM, pDevIns->Internal.s.pLunsR3, pDevIns->pReg->szName, pDevIns->iInstance);
 
+        /* The queue consumer threads must not call into the device any more. */
+        pdmR3QueueStopDevice(pVM, pDevIns);
+
         if (pDevIns->pReg->pfnDestruct)
         {
             LogFlow(("pdmR3DevTerm: Destroying - device '%s'/%d\n",
@@ -800,6 +806,25 @@ static DECLCALLBACK(int) pdmR3LiveExec(PVM pVM, PSSMHANDLE pSSM, uint32_t uPass)
 }
 
 
+/**
+ * Prepare state save operation.
+ *
+ * Keeps the queue consumer threads from touching device state while it is
+ * being saved.
+ *
+ * @returns VBox status code.
+ * @param   pVM             Pointer to the VM.
+ * @param   pSSM            The saved state handle.
+ */
+static DECLCALLBACK(int) pdmR3SavePrep(PVM pVM, PSSMHANDLE pSSM)
+{
+    LogFlow(("pdmR3SavePrep:\n"));
+    NOREF(pSSM);
+    pdmR3QueueParkConsumers(pVM, PDM_QUEUE_PARK_F_SAVE);
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Execute state save operation.
  *
@@ -829,6 +854,22 @@ static DECLCALLBACK(int) pdmR3SaveExec(PVM pVM, PSSMHANDLE pSSM)
 }
 
 
+/**
+ * Done state save operation.
+ *
+ * @returns VBox status code.
+ * @param   pVM             Pointer to the VM.
+ * @param   pSSM            The saved state handle.
+ */
+static DECLCALLBACK(int) pdmR3SaveDone(PVM pVM, PSSMHANDLE pSSM)
+{
+    LogFlow(("pdmR3SaveDone:\n"));
+    NOREF(pSSM);
+    pdmR3QueueUnparkConsumers(pVM, PDM_QUEUE_PARK_F_SAVE);
+    return VINF_SUCCESS;
+}
+
+
 /**
  * Prepare state load operation.
  *
@@ -1170,7 +1211,10 @@ VMMR3DECL(void) PDMR3PowerOn(PVM pVM)
      * Resume all threads.
      */
     if (RT_SUCCESS(rc))
+    {
         pdmR3ThreadResumeAll(pVM);
+        pdmR3QueueUnparkConsumers(pVM, PDM_QUEUE_PARK_F_STATE);
+    }
 
     /*
      * On failure, clean up via PDMR3Suspend.
@@ -1787,6 +1831,7 @@ VMMR3_INT_DECL(void) PDMR3Suspend(PVM pVM)
      * Suspend all threads.
      */
     pdmR3ThreadSuspendAll(pVM);
+    pdmR3QueueParkConsumers(pVM, PDM_QUEUE_PARK_F_STATE);
 
     cNsElapsed = RTTimeNanoTS() - cNsElapsed;
     LogRel(("PDMR3Suspend: %'llu ns run time\n", cNsElapsed));
@@ -1910,7 +1955,10 @@ VMMR3_INT_DECL(void) PDMR3Resume(PVM pVM)
      * Resume all threads.
      */
     if (RT_SUCCESS(rc))
+    {
         pdmR3ThreadResumeAll(pVM);
+        pdmR3QueueUnparkConsumers(pVM, PDM_QUEUE_PARK_F_STATE);
+    }
 
     /*
      * Resume the block cache.
@@ -2143,6 +2191,7 @@ VMMR3DECL(void) PDMR3PowerOff(PVM pVM)
      * Suspend all threads.
      */
     pdmR3ThreadSuspendAll(pVM);
+    pdmR3QueueParkConsumers(pVM, PDM_QUEUE_PARK_F_STATE);
 
     cNsElapsed = RTTimeNanoTS() - cNsElapsed;
     LogRel(("PDMR3PowerOff: %'llu ns run time\n", cNsElapsed));
@@ -826,6 +826,7 @@ static int pdmacFileInitialize(PPDMASYNCCOMPLETIONEPCLASS pClassGlobals, PCFGMNO
     {
         pEpClassFile->uBitmaskAlignment   = AioLimits.cbBufferAlignment ? ~((RTR3UINTPTR)AioLimits.cbBufferAlignment - 1) : RTR3UINTPTR_MAX;
         pEpClassFile->cReqsOutstandingMax = AioLimits.cReqsOutstandingMax;
+        pEpClassFile->fBufferedAsyncIo    = RT_BOOL(AioLimits.fFlags & RTFILEAIOLIMITS_F_BUFFERED);
 
         if (pCfgNode)
         {
@@ -854,7 +855,8 @@ static int pdmacFileInitialize(PPDMASYNCCOMPLETIONEPCLASS pClassGlobals, PCFGMNO
 
 #ifdef RT_OS_LINUX
             if (   pEpClassFile->enmMgrTypeOverride == PDMACEPFILEMGRTYPE_ASYNC
-                && pEpClassFile->enmEpBackendDefault == PDMACFILEEPBACKEND_BUFFERED)
+                && pEpClassFile->enmEpBackendDefault == PDMACFILEEPBACKEND_BUFFERED
+                && !pEpClassFile->fBufferedAsyncIo)
             {
                 LogRel(("AIOMgr: Linux does not support buffered async I/O, changing to non buffered\n"));
                 pEpClassFile->enmEpBackendDefault = PDMACFILEEPBACKEND_NON_BUFFERED;
@@ -919,11 +921,13 @@ static int pdmacFileEpInitialize(PPDMASYNCCOMPLETIONENDPOINT pEndpoint,
 
     /*
      * Revert to the simple manager and the buffered backend if
-     * the host cache should be enabled.
+     * the host cache should be enabled.  The async manager can be
+     * kept if the host does async I/O on buffered files.
      */
     if (fFlags & PDMACEP_FILE_FLAGS_HOST_CACHE_ENABLED)
     {
-        enmMgrType   = PDMACEPFILEMGRTYPE_SIMPLE;
+        if (!pEpClassFile->fBufferedAsyncIo)
+            enmMgrType = PDMACEPFILEMGRTYPE_SIMPLE;
         enmEpBackend = PDMACFILEEPBACKEND_BUFFERED;
     }
 
@@ -944,7 +948,13 @@ static int pdmacFileEpInitialize(PPDMASYNCCOMPLETIONENDPOINT pEndpoint,
             fFileFlags |= RTFILE_O_DENY_WRITE;
     }
 
-    if (enmMgrType == PDMACEPFILEMGRTYPE_ASYNC)
+    /* RTFILE_O_ASYNC_IO implies O_DIRECT on Linux, buffered endpoints can
+       only get here with the async manager if it isn't needed. */
+    if (   enmMgrType == PDMACEPFILEMGRTYPE_ASYNC
+#ifdef RT_OS_LINUX
+        && enmEpBackend == PDMACFILEEPBACKEND_NON_BUFFERED
+#endif
+       )
         fFileFlags |= RTFILE_O_ASYNC_IO;
 
     int rc;
@@ -975,7 +985,8 @@ static int pdmacFileEpInitialize(PPDMASYNCCOMPLETIONENDPOINT pEndpoint,
 
 #ifdef RT_OS_LINUX
                 fFileFlags &= ~RTFILE_O_ASYNC_IO;
-                enmMgrType   = PDMACEPFILEMGRTYPE_SIMPLE;
+                if (!pEpClassFile->fBufferedAsyncIo)
+                    enmMgrType = PDMACEPFILEMGRTYPE_SIMPLE;
 #endif
             }
             RTFileClose(hFile);
@@ -998,14 +1009,16 @@ static int pdmacFileEpInitialize(PPDMASYNCCOMPLETIONENDPOINT pEndpoint,
          * without blocking the whole application.
          *
          * On Linux we have the same problem with cifs.
-         * Have to disable async I/O here too because it requires O_DIRECT.
+         * Have to disable async I/O here too because it requires O_DIRECT,
+         * unless the host does async I/O on buffered files.
          */
         fFileFlags &= ~RTFILE_O_NO_CACHE;
         enmEpBackend = PDMACFILEEPBACKEND_BUFFERED;
 
 #ifdef RT_OS_LINUX
         fFileFlags &= ~RTFILE_O_ASYNC_IO;
-        enmMgrType   = PDMACEPFILEMGRTYPE_SIMPLE;
+        if (!pEpClassFile->fBufferedAsyncIo)
+            enmMgrType = PDMACEPFILEMGRTYPE_SIMPLE;
 #endif
 
         /* Open again. */
@@ -26,6 +26,8 @@
 #include <VBox/vmm/mm.h>
 #include <VBox/vmm/vm.h>
 #include <VBox/vmm/uvm.h>
+#include <VBox/vmm/cfgm.h>
+#include <VBox/vmm/dbgf.h>
 
 #include <VBox/err.h>
 #include <VBox/log.h>
@@ -42,12 +44,26 @@
 *******************************************************************************/
 static int pdmR3CritSectDeleteOne(PVM pVM, PUVM pUVM, PPDMCRITSECTINT pCritSect, PPDMCRITSECTINT pPrev, bool fFinal);
 static int pdmR3CritSectRwDeleteOne(PVM pVM, PUVM pUVM, PPDMCRITSECTRWINT pCritSect, PPDMCRITSECTRWINT pPrev, bool fFinal);
+static void pdmR3CritSectProfAssign(PVM pVM, PPDMCRITSECTINT pCritSect);
+static DECLCALLBACK(void) pdmR3CritSectInfo(PVM pVM, PCDBGFINFOHLP pHlp, const char *pszArgs);
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** The histogram bucket names, shared by the wait and hold time histograms. */
+static const char * const g_apszCritSectProfBuckets[PDMCRITSECT_PROF_HIST_BUCKETS] =
+{
+    "0-lt1K", "1-lt4K", "2-lt16K", "3-lt64K", "4-lt256K", "5-lt1M", "6-lt4M", "7-ge4M"
+};
 
 
 
 /**
  * Register statistics related to the critical sections.
  *
+ * This also sets up the contention profiling if configured.
+ *
  * @returns VBox status code.
  * @param   pVM         Pointer to the VM.
  */
@@ -55,10 +71,180 @@ int pdmR3CritSectBothInitStats(PVM pVM)
 {
     STAM_REG(pVM, &pVM->pdm.s.StatQueuedCritSectLeaves, STAMTYPE_COUNTER, "/PDM/QueuedCritSectLeaves", STAMUNIT_OCCURENCES,
              "Number of times a critical section leave request needed to be queued for ring-3 execution.");
+
+    /*
+     * Contention profiling.
+     */
+    PCFGMNODE pCfg = CFGMR3GetChild(CFGMR3GetRoot(pVM), "PDM/CritSect");
+
+    /** @cfgm{/PDM/CritSect/Profiling, boolean, false}
+     * Collects wait and hold time histograms and the contended owner call
+     * sites for each critical section (see the 'critsect' info handler). */
+    bool fProfiling;
+    int rc = CFGMR3QueryBoolDef(pCfg, "Profiling", &fProfiling, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    /** @cfgm{/PDM/CritSect/AdaptiveSpin, boolean, false}
+     * Derive the number of spins before blocking (or going to ring-3) from the
+     * recent hold times of each critical section instead of using a fixed
+     * count.  Waiters spin for about as long as the section is held on
+     * average, so longer holds get more spins up to a cap; sections held for
+     * very long get the minimum as blocking is cheaper.  Implies Profiling. */
+    rc = CFGMR3QueryBoolDef(pCfg, "AdaptiveSpin", &pVM->pdm.s.fCritSectAdaptiveSpin, false);
+    AssertLogRelRCReturn(rc, rc);
+
+    if (fProfiling || pVM->pdm.s.fCritSectAdaptiveSpin)
+    {
+        PPDMCRITSECTPROF paProfs;
+        rc = MMR3HyperAllocOnceNoRel(pVM, sizeof(PDMCRITSECTPROF) * PDMCRITSECT_PROF_MAX, 64, MM_TAG_PDM, (void **)&paProfs);
+        AssertLogRelRCReturn(rc, rc);
+        pVM->pdm.s.paCritSectProfsR3 = paProfs;
+        pVM->pdm.s.paCritSectProfsR0 = MMHyperR3ToR0(pVM, paProfs);
+        pVM->pdm.s.paCritSectProfsRC = MMHyperR3ToRC(pVM, paProfs);
+        LogRel(("PDM: Critical section profiling enabled (adaptive spinning %s)\n",
+                pVM->pdm.s.fCritSectAdaptiveSpin ? "on" : "off"));
+
+        /* Pick up the sections created before PDM was initialized. */
+        PUVM pUVM = pVM->pUVM;
+        RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
+        for (PPDMCRITSECTINT pCur = pUVM->pdm.s.pCritSects; pCur; pCur = pCur->pNext)
+            pdmR3CritSectProfAssign(pVM, pCur);
+        RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
+
+        DBGFR3InfoRegisterInternal(pVM, "critsect",
+                                   "Displays the contention profiles of the critical sections. "
+                                   "Optional argument: name substring.",
+                                   pdmR3CritSectInfo);
+    }
     return VINF_SUCCESS;
 }
 
 
+/**
+ * Hands out a contention profile to a critical section and registers its
+ * statistics.
+ *
+ * Profiles aren't recycled when critical sections are deleted, so sections
+ * created after the table is exhausted simply go unprofiled.
+ *
+ * @param   pVM         Pointer to the VM.
+ * @param   pCritSect   The critical section.
+ */
+static void pdmR3CritSectProfAssign(PVM pVM, PPDMCRITSECTINT pCritSect)
+{
+    if (   !pVM->pdm.s.paCritSectProfsR3
+        || pCritSect->iProf)
+        return;
+    uint32_t const i = pVM->pdm.s.cCritSectProfs;
+    if (i >= PDMCRITSECT_PROF_MAX)
+    {
+        LogRel(("PDM: No contention profile for critical section '%s'\n", pCritSect->pszName));
+        return;
+    }
+    pVM->pdm.s.cCritSectProfs = i + 1;
+
+    PPDMCRITSECTPROF pProf = &pVM->pdm.s.paCritSectProfsR3[i];
+    pProf->fAdaptiveSpin = pVM->pdm.s.fCritSectAdaptiveSpin;
+    STAMR3RegisterF(pVM, &pProf->StatWait,       STAMTYPE_PROFILE, STAMVISIBILITY_USED, STAMUNIT_TICKS_PER_OCCURENCE, "Time spent spinning and waiting for the section.", "/PDM/CritSects/%s/Wait", pCritSect->pszName);
+    STAMR3RegisterF(pVM, &pProf->StatSpinHits,   STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES, "Spinning got us the section.",  "/PDM/CritSects/%s/SpinHits", pCritSect->pszName);
+    STAMR3RegisterF(pVM, &pProf->StatSpinMisses, STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES, "Spun in vain.",                "/PDM/CritSects/%s/SpinMisses", pCritSect->pszName);
+    for (unsigned iBucket = 0; iBucket < PDMCRITSECT_PROF_HIST_BUCKETS; iBucket++)
+    {
+        STAMR3RegisterF(pVM, &pProf->aStatWait[iBucket], STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                        "Contended enters by TSC ticks spent getting the section.",
+                        "/PDM/CritSects/%s/WaitHist/%s", pCritSect->pszName, g_apszCritSectProfBuckets[iBucket]);
+        STAMR3RegisterF(pVM, &pProf->aStatHold[iBucket], STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_OCCURENCES,
+                        "Leaves by TSC ticks the section was held.",
+                        "/PDM/CritSects/%s/HoldHist/%s", pCritSect->pszName, g_apszCritSectProfBuckets[iBucket]);
+    }
+
+    ASMAtomicWriteU16(&pCritSect->iProf, (uint16_t)(i + 1));
+}
+
+
+/**
+ * Prints a contended owner call site for the 'critsect' info handler.
+ *
+ * Ring-0 and raw-mode return addresses are symbolized thru DBGF.  Anything DBGF
+ * doesn't know, like ring-3 return addresses and the uId values passed to the
+ * debug enter APIs, is printed as a raw value.
+ *
+ * @param   pVM             Pointer to the VM.
+ * @param   pHlp            The output helpers.
+ * @param   uCaller         The call site.
+ * @param   cContentions    The number of contentions attributed to it.
+ */
+static void pdmR3CritSectInfoCaller(PVM pVM, PCDBGFINFOHLP pHlp, uint64_t uCaller, uint32_t cContentions)
+{
+    static RTDBGAS const s_ahDbgAs[] = { DBGF_AS_R0, DBGF_AS_RC };
+    for (unsigned i = 0; i < RT_ELEMENTS(s_ahDbgAs); i++)
+    {
+        DBGFADDRESS Addr;
+        RTGCINTPTR  offDisp;
+        RTDBGSYMBOL Sym;
+        int rc = DBGFR3AsSymbolByAddr(pVM->pUVM, s_ahDbgAs[i], DBGFR3AddrFromFlat(pVM->pUVM, &Addr, uCaller),
+                                      RTDBGSYMADDR_FLAGS_LESS_OR_EQUAL, &offDisp, &Sym, NULL /*phMod*/);
+        if (RT_SUCCESS(rc))
+        {
+            if (offDisp)
+                pHlp->pfnPrintf(pHlp, "    owner %s+%#RX64: %u contentions\n", Sym.szName, (uint64_t)offDisp, cContentions);
+            else
+                pHlp->pfnPrintf(pHlp, "    owner %s: %u contentions\n", Sym.szName, cContentions);
+            return;
+        }
+    }
+    pHlp->pfnPrintf(pHlp, "    owner %RX64 (raw): %u contentions\n", uCaller, cContentions);
+}
+
+
+/**
+ * Info handler for 'critsect'.
+ *
+ * @param   pVM         Pointer to the VM.
+ * @param   pHlp        The output helpers.
+ * @param   pszArgs     Optional name substring to filter on.
+ */
+static DECLCALLBACK(void) pdmR3CritSectInfo(PVM pVM, PCDBGFINFOHLP pHlp, const char *pszArgs)
+{
+    if (pszArgs && !*pszArgs)
+        pszArgs = NULL;
+
+    PUVM pUVM = pVM->pUVM;
+    RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
+    for (PPDMCRITSECTINT pCur = pUVM->pdm.s.pCritSects; pCur; pCur = pCur->pNext)
+    {
+        if (!pCur->iProf)
+            continue;
+        if (pszArgs && !strstr(pCur->pszName, pszArgs))
+            continue;
+        PPDMCRITSECTPROF pProf = &pVM->pdm.s.paCritSectProfsR3[pCur->iProf - 1];
+        if (!pProf->StatWait.cPeriods && !pProf->cTicksHoldAvg)
+            continue;
+
+        pHlp->pfnPrintf(pHlp,
+                        "%s: waits=%RU64 avg-wait=%RU64 ticks, avg-hold=%RU64 ticks, spins=%d%s, spin hits=%RU64 misses=%RU64\n",
+                        pCur->pszName,
+                        pProf->StatWait.cPeriods,
+                        pProf->StatWait.cPeriods ? pProf->StatWait.cTicks / pProf->StatWait.cPeriods : 0,
+                        pProf->cTicksHoldAvg,
+                        pProf->cSpins,
+                        pProf->fAdaptiveSpin ? " (adaptive)" : "",
+                        pProf->StatSpinHits.c,
+                        pProf->StatSpinMisses.c);
+        pHlp->pfnPrintf(pHlp, "    %-10s %12s %12s\n", "ticks", "wait", "hold");
+        for (unsigned iBucket = 0; iBucket < PDMCRITSECT_PROF_HIST_BUCKETS; iBucket++)
+            pHlp->pfnPrintf(pHlp, "    %-10s %12RU64 %12RU64\n", g_apszCritSectProfBuckets[iBucket] + 2,
+                            pProf->aStatWait[iBucket].c, pProf->aStatHold[iBucket].c);
+        for (unsigned i = 0; i < RT_ELEMENTS(pProf->aCallers); i++)
+            if (pProf->aCallers[i].uCaller)
+                pdmR3CritSectInfoCaller(pVM, pHlp, pProf->aCallers[i].uCaller, pProf->aCallers[i].cContentions);
+        if (pProf->cCallerOverflows)
+            pHlp->pfnPrintf(pHlp, "    other owners: %u contentions\n", pProf->cCallerOverflows);
+    }
+    RTCritSectLeave(&pUVM->pdm.s.ListCritSect);
+}
+
+
 /**
  * Relocates all the critical sections.
  *
@@ -73,6 +259,8 @@ void pdmR3CritSectBothRelocate(PVM pVM)
          pCur;
          pCur = pCur->pNext)
         pCur->pVMRC = pVM->pVMRC;
+    if (pVM->pdm.s.paCritSectProfsR3)
+        pVM->pdm.s.paCritSectProfsRC = MMHyperR3ToRC(pVM, pVM->pdm.s.paCritSectProfsR3);
 
     for (PPDMCRITSECTRWINT pCur = pUVM->pdm.s.pRwCritSects;
          pCur;
@@ -182,6 +370,7 @@ static int pdmR3CritSectInitOne(PVM pVM, PPDMCRITSECTINT pCritSect, void *pvKey,
                 pCritSect->pvKey                     = pvKey;
                 pCritSect->fAutomaticDefaultCritsect = false;
                 pCritSect->fUsedByTimerOrSimilar     = false;
+                pCritSect->iProf                     = 0;
                 pCritSect->EventToSignal             = NIL_RTSEMEVENT;
                 pCritSect->pszName                   = pszName;
 
@@ -191,6 +380,7 @@ static int pdmR3CritSectInitOne(PVM pVM, PPDMCRITSECTINT pCritSect, void *pvKey,
 #ifdef VBOX_WITH_STATISTICS
                 STAMR3RegisterF(pVM, &pCritSect->StatLocked,        STAMTYPE_PROFILE_ADV, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_OCCURENCE, NULL, "/PDM/CritSects/%s/Locked", pCritSect->pszName);
 #endif
+                pdmR3CritSectProfAssign(pVM, pCritSect);
 
                 PUVM pUVM = pVM->pUVM;
                 RTCritSectEnter(&pUVM->pdm.s.ListCritSect);
@@ -524,6 +714,7 @@ static int pdmR3CritSectDeleteOne(PVM pVM, PUVM pUVM, PPDMCRITSECTINT pCritSect,
     pCritSect->pVMR3   = NULL;
     pCritSect->pVMR0   = NIL_RTR0PTR;
     pCritSect->pVMRC   = NIL_RTRCPTR;
+    pCritSect->iProf   = 0;
     if (!fFinal)
         STAMR3DeregisterF(pVM->pUVM, "/PDM/CritSects/%s/*", pCritSect->pszName);
     RTStrFree((char *)pCritSect->pszName);
@@ -934,6 +934,7 @@ void pdmR3DrvDestroyChain(PPDMDRVINS pDrvIns, uint32_t fFlags)
          * Call destructor.
          */
         pCur->pUpBase = NULL;
+        pdmR3QueueStopDriver(pVM, pCur);
         if (pCur->pReg->pfnDestruct)
             pCur->pReg->pfnDestruct(pCur);
         pCur->Internal.s.pDrv->cInstances--;
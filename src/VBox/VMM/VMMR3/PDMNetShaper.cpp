@@ -28,6 +28,7 @@
 #endif
 #include <VBox/vmm/vm.h>
 #include <VBox/vmm/uvm.h>
+#include <VBox/vmm/stam.h>
 #include <VBox/err.h>
 
 #include <VBox/log.h>
@@ -39,6 +40,7 @@
 #include <iprt/tcp.h>
 #include <iprt/path.h>
 #include <iprt/string.h>
+#include <iprt/time.h>
 
 #include <VBox/vmm/pdmnetshaper.h>
 #include "PDMNetShaperInternal.h"
@@ -136,16 +138,42 @@ static void pdmNsBwGroupUnlink(PPDMNSBWGROUP pBwGroup)
 
 static void pdmNsBwGroupSetLimit(PPDMNSBWGROUP pBwGroup, uint64_t cbPerSecMax)
 {
+    /* Rates beyond 4GB/s are as good as unlimited and the packed value only
+       has room for 32 bits. */
+    uint32_t const cbPerSec = (uint32_t)RT_MIN(cbPerSecMax, UINT32_MAX);
+    uint32_t cbBucket = pBwGroup->cbBurstCfg;
+    if (!cbBucket)
+        cbBucket = (uint32_t)RT_MIN(RT_MAX(PDM_NETSHAPER_MIN_BUCKET_SIZE, cbPerSecMax * PDM_NETSHAPER_MAX_LATENCY / 1000),
+                                    UINT32_MAX);
     pBwGroup->cbPerSecMax = cbPerSecMax;
-    pBwGroup->cbBucket    = RT_MAX(PDM_NETSHAPER_MIN_BUCKET_SIZE, cbPerSecMax * PDM_NETSHAPER_MAX_LATENCY / 1000);
+    ASMAtomicWriteU64(&pBwGroup->u64Limit, RT_MAKE_U64(cbPerSec, cbBucket));
     LogFlow(("pdmNsBwGroupSetLimit: New rate limit is %llu bytes per second, adjusted bucket size to %u bytes\n",
-             pBwGroup->cbPerSecMax, pBwGroup->cbBucket));
+             cbPerSecMax, cbBucket));
 }
 
 
-static int pdmNsBwGroupCreate(PPDMNETSHAPER pShaper, const char *pszBwGroup, uint64_t cbPerSecMax)
+static void pdmNsBwGroupRegisterStats(PPDMNSBWGROUP pBwGroup)
 {
-    LogFlow(("pdmNsBwGroupCreate: pShaper=%#p pszBwGroup=%#p{%s} cbPerSecMax=%llu\n", pShaper, pszBwGroup, pszBwGroup, cbPerSecMax));
+    PVM         pVM     = pBwGroup->pShaperR3->pVM;
+    const char *pszName = pBwGroup->pszNameR3;
+
+    STAMR3RegisterF(pVM, &pBwGroup->StatBytesGranted, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,
+                    "Number of bytes granted.", "/PDM/NetShaper/%s/BytesGranted", pszName);
+    STAMR3RegisterF(pVM, &pBwGroup->StatBytesDenied, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,
+                    "Number of bytes refused.", "/PDM/NetShaper/%s/BytesDenied", pszName);
+    STAMR3RegisterF(pVM, &pBwGroup->StatDenied, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                    "Number of refused allocations (frames held back in the device).", "/PDM/NetShaper/%s/Denied", pszName);
+    STAMR3RegisterF(pVM, &pBwGroup->StatAllocRetries, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,
+                    "Number of bucket update retries caused by concurrent allocations.", "/PDM/NetShaper/%s/AllocRetries", pszName);
+    STAMR3RegisterF(pVM, &pBwGroup->StatChokedLatency, STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL,
+                    "Time from a filter being choked until it is told to retry.", "/PDM/NetShaper/%s/ChokedLatency", pszName);
+}
+
+
+static int pdmNsBwGroupCreate(PPDMNETSHAPER pShaper, const char *pszBwGroup, uint64_t cbPerSecMax, uint32_t cbBurst)
+{
+    LogFlow(("pdmNsBwGroupCreate: pShaper=%#p pszBwGroup=%#p{%s} cbPerSecMax=%llu cbBurst=%u\n",
+             pShaper, pszBwGroup, pszBwGroup, cbPerSecMax, cbBurst));
 
     AssertPtrReturn(pShaper, VERR_INVALID_POINTER);
     AssertPtrReturn(pszBwGroup, VERR_INVALID_POINTER);
@@ -167,14 +195,17 @@ static int pdmNsBwGroupCreate(PPDMNETSHAPER pShaper, const char *pszBwGroup, uin
                 {
                     pBwGroup->pShaperR3             = pShaper;
                     pBwGroup->cRefs                 = 0;
+                    pBwGroup->cFiltersChoked        = 0;
+                    pBwGroup->cbBurstCfg            = cbBurst;
 
                     pdmNsBwGroupSetLimit(pBwGroup, cbPerSecMax);
 
-                    pBwGroup->cbTokensLast          = pBwGroup->cbBucket;
-                    pBwGroup->tsUpdatedLast         = RTTimeSystemNanoTS();
+                    /* Start out with a full bucket. */
+                    pBwGroup->tsTat                 = RTTimeSystemNanoTS();
 
                     LogFlowFunc(("pszBwGroup={%s} cbBucket=%u\n",
-                                 pszBwGroup, pBwGroup->cbBucket));
+                                 pszBwGroup, RT_HI_U32(pBwGroup->u64Limit)));
+                    pdmNsBwGroupRegisterStats(pBwGroup);
                     pdmNsBwGroupLink(pBwGroup);
                     return VINF_SUCCESS;
                 }
@@ -196,6 +227,7 @@ static int pdmNsBwGroupCreate(PPDMNETSHAPER pShaper, const char *pszBwGroup, uin
 static void pdmNsBwGroupTerminate(PPDMNSBWGROUP pBwGroup)
 {
     Assert(pBwGroup->cRefs == 0);
+    STAMR3DeregisterF(pBwGroup->pShaperR3->pVM->pUVM, "/PDM/NetShaper/%s/*", pBwGroup->pszNameR3);
     if (PDMCritSectIsInitialized(&pBwGroup->Lock))
         PDMR3CritSectDelete(&pBwGroup->Lock);
 }
@@ -214,7 +246,41 @@ DECLINLINE(void) pdmNsBwGroupUnref(PPDMNSBWGROUP pBwGroup)
 }
 
 
-static void pdmNsBwGroupXmitPending(PPDMNSBWGROUP pBwGroup)
+/**
+ * Calculates how long it takes until the bucket of a group with choked
+ * filters can satisfy the last refused request.
+ *
+ * @returns Number of nanoseconds, 0 if the group has no choked filters or
+ *          the tokens are already there.
+ * @param   pBwGroup        The bandwidth group.
+ * @param   tsNow           The current RTTimeSystemNanoTS value.
+ */
+static uint64_t pdmNsBwGroupCalcWait(PPDMNSBWGROUP pBwGroup, uint64_t tsNow)
+{
+    uint64_t const u64Limit    = ASMAtomicReadU64(&pBwGroup->u64Limit);
+    uint32_t const cbPerSecMax = RT_LO_U32(u64Limit);
+    if (   !cbPerSecMax
+        || !ASMAtomicReadU32(&pBwGroup->cFiltersChoked))
+        return 0;
+
+    uint64_t const tsReady = ASMAtomicReadU64(&pBwGroup->tsTat)
+                           + (uint64_t)ASMAtomicReadU32(&pBwGroup->cbLastDenied) * RT_NS_1SEC / cbPerSecMax
+                           - pdmNsBwGroupCalcBurst(u64Limit);
+    return tsReady > tsNow ? tsReady - tsNow : 0;
+}
+
+
+/**
+ * Tells the choked filters of a group to retry transmitting.
+ *
+ * The filters are visited round-robin, each pass starting with the filter
+ * following the one which was served first in the previous pass, so a filter
+ * early in the list cannot consume all the tokens of the group all the time.
+ *
+ * @param   pBwGroup        The bandwidth group.
+ * @param   tsNow           The current RTTimeSystemNanoTS value.
+ */
+static void pdmNsBwGroupXmitPending(PPDMNSBWGROUP pBwGroup, uint64_t tsNow)
 {
     /*
      * We don't need to hold the bandwidth group lock to iterate over the list
@@ -224,27 +290,40 @@ static void pdmNsBwGroupXmitPending(PPDMNSBWGROUP pBwGroup)
     AssertPtr(pBwGroup);
     AssertPtr(pBwGroup->pShaperR3);
     Assert(RTCritSectIsOwner(&pBwGroup->pShaperR3->Lock));
-    //LOCK_NETSHAPER(pShaper);
 
-    /* Check if the group is disabled. */
-    if (pBwGroup->cbPerSecMax == 0)
+    /* Check if the group is disabled or nobody is waiting. */
+    if (   RT_LO_U32(ASMAtomicReadU64(&pBwGroup->u64Limit)) == 0
+        || !ASMAtomicReadU32(&pBwGroup->cFiltersChoked))
         return;
 
-    PPDMNSFILTER pFilter = pBwGroup->pFiltersHeadR3;
+    PPDMNSFILTER pFilterStart = pBwGroup->pFilterNextR3 ? pBwGroup->pFilterNextR3 : pBwGroup->pFiltersHeadR3;
+    PPDMNSFILTER pFilter      = pFilterStart;
+    bool         fFirst       = true;
     while (pFilter)
     {
         bool fChoked = ASMAtomicXchgBool(&pFilter->fChoked, false);
         Log3((LOG_FN_FMT ": pFilter=%#p fChoked=%RTbool\n", __PRETTY_FUNCTION__, pFilter, fChoked));
-        if (fChoked && pFilter->pIDrvNetR3)
+        if (fChoked)
         {
-            LogFlowFunc(("Calling pfnXmitPending for pFilter=%#p\n", pFilter));
-            pFilter->pIDrvNetR3->pfnXmitPending(pFilter->pIDrvNetR3);
+            ASMAtomicDecU32(&pBwGroup->cFiltersChoked);
+            uint64_t const tsChoked = ASMAtomicReadU64(&pFilter->tsChoked);
+            STAM_REL_PROFILE_ADD_PERIOD(&pBwGroup->StatChokedLatency, tsNow > tsChoked ? tsNow - tsChoked : 0);
+            if (fFirst)
+            {
+                pBwGroup->pFilterNextR3 = pFilter->pNextR3;
+                fFirst = false;
+            }
+            if (pFilter->pIDrvNetR3)
+            {
+                LogFlowFunc(("Calling pfnXmitPending for pFilter=%#p\n", pFilter));
+                pFilter->pIDrvNetR3->pfnXmitPending(pFilter->pIDrvNetR3);
+            }
         }
 
-        pFilter = pFilter->pNextR3;
+        pFilter = pFilter->pNextR3 ? pFilter->pNextR3 : pBwGroup->pFiltersHeadR3;
+        if (pFilter == pFilterStart)
+            break;
     }
-
-    //UNLOCK_NETSHAPER(pShaper);
 }
 
 
@@ -273,6 +352,11 @@ static void pdmNsFilterUnlink(PPDMNSFILTER pFilter)
     Assert(RTCritSectIsOwner(&pBwGroup->pShaperR3->Lock));
     int rc = PDMCritSectEnter(&pBwGroup->Lock, VERR_SEM_BUSY); AssertRC(rc);
 
+    if (pBwGroup->pFilterNextR3 == pFilter)
+        pBwGroup->pFilterNextR3 = pFilter->pNextR3;
+    if (ASMAtomicXchgBool(&pFilter->fChoked, false))
+        ASMAtomicDecU32(&pBwGroup->cFiltersChoked);
+
     if (pFilter == pBwGroup->pFiltersHeadR3)
         pBwGroup->pFiltersHeadR3 = pFilter->pNextR3;
     else
@@ -387,9 +471,13 @@ VMMR3DECL(int) PDMR3NsBwGroupSetLimit(PUVM pUVM, const char *pszBwGroup, uint64_
         {
             pdmNsBwGroupSetLimit(pBwGroup, cbPerSecMax);
 
-            /* Drop extra tokens */
-            if (pBwGroup->cbTokensLast > pBwGroup->cbBucket)
-                pBwGroup->cbTokensLast = pBwGroup->cbBucket;
+            /* Drop extra tokens, i.e. don't let the bucket start out fuller than allowed now. */
+            uint64_t const tsNow = RTTimeSystemNanoTS();
+            uint64_t const tsMin = tsNow - RT_MIN(tsNow, pdmNsBwGroupCalcBurst(pBwGroup->u64Limit));
+            uint64_t       tsTat = ASMAtomicReadU64(&pBwGroup->tsTat);
+            while (   tsTat < tsMin
+                   && !ASMAtomicCmpXchgExU64(&pBwGroup->tsTat, tsMin, tsTat, &tsTat))
+                ;
 
             int rc2 = PDMCritSectLeave(&pBwGroup->Lock); AssertRC(rc2);
         }
@@ -413,19 +501,32 @@ static DECLCALLBACK(int) pdmR3NsTxThread(PVM pVM, PPDMTHREAD pThread)
 {
     PPDMNETSHAPER pShaper = (PPDMNETSHAPER)pThread->pvUser;
     LogFlow(("pdmR3NsTxThread: pShaper=%p\n", pShaper));
+    RTMSINTERVAL cMsSleep = PDM_NETSHAPER_MAX_LATENCY;
     while (pThread->enmState == PDMTHREADSTATE_RUNNING)
     {
-        RTThreadSleep(PDM_NETSHAPER_MAX_LATENCY);
-
-        /* Go over all bandwidth groups/filters calling pfnXmitPending */
+        PDMR3ThreadSleep(pThread, cMsSleep);
+
+        /*
+         * Go over all bandwidth groups with choked filters calling
+         * pfnXmitPending, then figure out when the next group will have
+         * enough tokens again.  Choking may happen in ring-0 where we can't
+         * wake up this thread, so never sleep longer than the max latency.
+         */
+        uint64_t cNsWait = RT_NS_1MS * PDM_NETSHAPER_MAX_LATENCY;
         LOCK_NETSHAPER(pShaper);
+        uint64_t const tsNow = RTTimeSystemNanoTS();
         PPDMNSBWGROUP pBwGroup = pShaper->pBwGroupsHead;
         while (pBwGroup)
         {
-            pdmNsBwGroupXmitPending(pBwGroup);
+            pdmNsBwGroupXmitPending(pBwGroup, tsNow);
+
+            uint64_t cNsGroup = pdmNsBwGroupCalcWait(pBwGroup, RTTimeSystemNanoTS());
+            if (cNsGroup && cNsGroup < cNsWait)
+                cNsWait = cNsGroup;
             pBwGroup = pBwGroup->pNextR3;
         }
         UNLOCK_NETSHAPER(pShaper);
+        cMsSleep = (RTMSINTERVAL)RT_MAX(cNsWait / RT_NS_1MS, 1);
     }
     return VINF_SUCCESS;
 }
@@ -438,7 +539,7 @@ static DECLCALLBACK(int) pdmR3NsTxWakeUp(PVM pVM, PPDMTHREAD pThread)
 {
     PPDMNETSHAPER pShaper = (PPDMNETSHAPER)pThread->pvUser;
     LogFlow(("pdmR3NsTxWakeUp: pShaper=%p\n", pShaper));
-    /* Nothing to do */
+    /* Nothing to do, PDMR3ThreadSleep is interrupted by the state change. */
     return VINF_SUCCESS;
 }
 
@@ -504,6 +605,7 @@ int pdmR3NetShaperInit(PVM pVM)
                 for (PCFGMNODE pCur = CFGMR3GetFirstChild(pCfgBwGrp); pCur; pCur = CFGMR3GetNextChild(pCur))
                 {
                     uint64_t cbMax;
+                    uint32_t cbBurst = 0;
                     size_t cbName = CFGMR3GetNameLen(pCur) + 1;
                     char *pszBwGrpId = (char *)RTMemAllocZ(cbName);
 
@@ -519,7 +621,9 @@ int pdmR3NetShaperInit(PVM pVM)
                     if (RT_SUCCESS(rc))
                         rc = CFGMR3QueryU64(pCur, "Max", &cbMax);
                     if (RT_SUCCESS(rc))
-                        rc = pdmNsBwGroupCreate(pShaper, pszBwGrpId, cbMax);
+                        rc = CFGMR3QueryU32Def(pCur, "Burst", &cbBurst, 0);
+                    if (RT_SUCCESS(rc))
+                        rc = pdmNsBwGroupCreate(pShaper, pszBwGrpId, cbMax, cbBurst);
 
                     RTMemFree(pszBwGrpId);
 
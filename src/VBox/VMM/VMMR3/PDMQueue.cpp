@@ -28,10 +28,12 @@
 #endif
 #include <VBox/vmm/vm.h>
 #include <VBox/vmm/uvm.h>
+#include <VBox/sup.h>
 #include <VBox/err.h>
 
 #include <VBox/log.h>
 #include <iprt/asm.h>
+#include <iprt/asm-amd64-x86.h>
 #include <iprt/assert.h>
 #include <iprt/thread.h>
 
@@ -42,6 +44,28 @@
 DECLINLINE(void)            pdmR3QueueFreeItem(PPDMQUEUE pQueue, PPDMQUEUEITEMCORE pItem);
 static bool                 pdmR3QueueFlush(PPDMQUEUE pQueue);
 static DECLCALLBACK(void)   pdmR3QueueTimer(PVM pVM, PTMTIMER pTimer, void *pvUser);
+static DECLCALLBACK(int)    pdmR3QueueConsumerThread(RTTHREAD hThreadSelf, void *pvUser);
+static void                 pdmR3QueueStopConsumer(PVM pVM, PPDMQUEUE pQueue);
+
+
+/**
+ * Checks whether a queue has pending items in any of its lists.
+ *
+ * @returns true if it has, false if not.
+ * @param   pQueue  The queue.
+ */
+DECLINLINE(bool) pdmR3QueueHasPending(PPDMQUEUE pQueue)
+{
+    if (   pQueue->pPendingR3
+        || pQueue->pPendingR0
+        || pQueue->pPendingRC)
+        return true;
+    for (unsigned i = 0; i < RT_ELEMENTS(pQueue->aStages); i++)
+        if (   pQueue->aStages[i].pPendingR3
+            || pQueue->aStages[i].pPendingR0)
+            return true;
+    return false;
+}
 
 
 
@@ -77,7 +101,7 @@ static int pdmR3QueueCreate(PVM pVM, size_t cbItem, uint32_t cItems, uint32_t cM
     PPDMQUEUE pQueue;
     int rc;
     if (fRZEnabled)
-        rc = MMHyperAlloc(pVM, cb, 0, MM_TAG_PDM_QUEUE, (void **)&pQueue );
+        rc = MMHyperAlloc(pVM, cb, 64, MM_TAG_PDM_QUEUE, (void **)&pQueue );
     else
         rc = MMR3HeapAllocZEx(pVM, MM_TAG_PDM_QUEUE, cb, (void **)&pQueue);
     if (RT_FAILURE(rc))
@@ -99,6 +123,8 @@ static int pdmR3QueueCreate(PVM pVM, size_t cbItem, uint32_t cItems, uint32_t cM
     //pQueue->pPendingRC = NULL;
     pQueue->iFreeHead = cItems;
     //pQueue->iFreeTail = 0;
+    pQueue->hEvtConsumer = NIL_SUPSEMEVENT;
+    pQueue->hConsumerThread = NIL_RTTHREAD;
     PPDMQUEUEITEMCORE pItem = (PPDMQUEUEITEMCORE)((char *)pQueue + RT_ALIGN_Z(RT_OFFSETOF(PDMQUEUE, aFreeItems[cItems + PDMQUEUE_FREE_SLACK]), 16));
     for (unsigned i = 0; i < cItems; i++, pItem = (PPDMQUEUEITEMCORE)((char *)pItem + cbItem))
     {
@@ -146,6 +172,27 @@ static int pdmR3QueueCreate(PVM pVM, size_t cbItem, uint32_t cItems, uint32_t cM
     }
     else
     {
+        /** @cfgm{/PDM/Queues/<name>/ConsumerThread, boolean, false}
+         * Whether to flush the queue on a dedicated thread that is woken up
+         * directly by PDMQueueInsert rather than on EMT via VM_FF_PDM_QUEUES.
+         * The consumer callback must be safe to call outside EMT.  The thread
+         * does not call it while the VM isn't running or is being saved. */
+        bool fConsumerThread = false;
+        PCFGMNODE pCfgQueue = CFGMR3GetChildF(CFGMR3GetRoot(pVM), "PDM/Queues/%s", pszName);
+        if (pCfgQueue)
+        {
+            rc = CFGMR3QueryBoolDef(pCfgQueue, "ConsumerThread", &fConsumerThread, false);
+            if (RT_FAILURE(rc))
+            {
+                AssertLogRelMsgFailed(("%s: %Rrc\n", pszName, rc));
+                if (fRZEnabled)
+                    MMHyperFree(pVM, pQueue);
+                else
+                    MMR3HeapFree(pQueue);
+                return rc;
+            }
+        }
+
         /*
          * Insert into the queue list for forced action driven queues.
          * This is a FIFO, so insert at the end.
@@ -167,6 +214,28 @@ static int pdmR3QueueCreate(PVM pVM, size_t cbItem, uint32_t cItems, uint32_t cM
             pPrev->pNext = pQueue;
         }
         pdmUnlock(pVM);
+
+        /*
+         * Dedicated consumer thread?
+         */
+        if (fConsumerThread)
+        {
+            rc = SUPSemEventCreate(pVM->pSession, &pQueue->hEvtConsumer);
+            if (RT_SUCCESS(rc))
+            {
+                rc = RTThreadCreateF(&pQueue->hConsumerThread, pdmR3QueueConsumerThread, pQueue, 0, RTTHREADTYPE_IO,
+                                     RTTHREADFLAGS_WAITABLE, "Q-%s", pszName);
+                if (RT_FAILURE(rc))
+                {
+                    SUPSemEventClose(pVM->pSession, pQueue->hEvtConsumer);
+                    pQueue->hEvtConsumer = NIL_SUPSEMEVENT;
+                }
+            }
+            if (RT_FAILURE(rc))
+                LogRel(("PDMQueue: Failed to create consumer thread for '%s': %Rrc, using EMT\n", pszName, rc));
+            else
+                LogRel(("PDMQueue: Queue '%s' is flushed by a dedicated thread\n", pszName));
+        }
     }
 
     /*
@@ -175,9 +244,15 @@ static int pdmR3QueueCreate(PVM pVM, size_t cbItem, uint32_t cItems, uint32_t cM
     STAMR3RegisterF(pVM, &pQueue->cbItem,               STAMTYPE_U32,     STAMVISIBILITY_ALWAYS, STAMUNIT_BYTES,        "Item size.",                       "/PDM/Queue/%s/cbItem",         pQueue->pszName);
     STAMR3RegisterF(pVM, &pQueue->cItems,               STAMTYPE_U32,     STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,        "Queue size.",                      "/PDM/Queue/%s/cItems",         pQueue->pszName);
     STAMR3RegisterF(pVM, &pQueue->StatAllocFailures,    STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,   "PDMQueueAlloc failures.",          "/PDM/Queue/%s/AllocFailures",  pQueue->pszName);
-    STAMR3RegisterF(pVM, &pQueue->StatInsert,           STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_CALLS,        "Calls to PDMQueueInsert.",         "/PDM/Queue/%s/Insert",         pQueue->pszName);
+    STAMR3RegisterF(pVM, &pQueue->StatInsert,           STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_CALLS,        "Calls to PDMQueueInsert on non-EMTs.", "/PDM/Queue/%s/Insert",     pQueue->pszName);
+    for (unsigned i = 0; i < RT_ELEMENTS(pQueue->aStages); i++)
+        STAMR3RegisterF(pVM, &pQueue->aStages[i].StatInsert, STAMTYPE_COUNTER, STAMVISIBILITY_USED, STAMUNIT_CALLS,     "Calls to PDMQueueInsert on EMTs.", "/PDM/Queue/%s/InsertStage%u",  pQueue->pszName, i);
     STAMR3RegisterF(pVM, &pQueue->StatFlush,            STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_CALLS,        "Calls to pdmR3QueueFlush.",        "/PDM/Queue/%s/Flush",          pQueue->pszName);
     STAMR3RegisterF(pVM, &pQueue->StatFlushLeftovers,   STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,   "Left over items after flush.",     "/PDM/Queue/%s/FlushLeftovers", pQueue->pszName);
+    STAMR3RegisterF(pVM, &pQueue->StatFlushItems,       STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES,   "Items handed to the consumer.",    "/PDM/Queue/%s/FlushItems",     pQueue->pszName);
+    STAMR3RegisterF(pVM, &pQueue->StatLatency,          STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_TICKS_PER_OCCURENCE, "Time from the first insert until the flush.", "/PDM/Queue/%s/Latency", pQueue->pszName);
+    if (pQueue->hConsumerThread != NIL_RTTHREAD)
+        STAMR3RegisterF(pVM, &pQueue->StatConsumerWakeups, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, STAMUNIT_OCCURENCES, "Consumer thread wake-ups.",     "/PDM/Queue/%s/ConsumerWakeups", pQueue->pszName);
 #ifdef VBOX_WITH_STATISTICS
     STAMR3RegisterF(pVM, &pQueue->StatFlushPrf,         STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_CALLS,        "Profiling pdmR3QueueFlush.",       "/PDM/Queue/%s/FlushPrf",       pQueue->pszName);
     STAMR3RegisterF(pVM, (void *)&pQueue->cStatPending, STAMTYPE_U32,     STAMVISIBILITY_ALWAYS, STAMUNIT_COUNT,        "Pending items.",                   "/PDM/Queue/%s/Pending",        pQueue->pszName);
@@ -447,6 +522,11 @@ VMMR3_INT_DECL(int) PDMR3QueueDestroy(PPDMQUEUE pQueue)
      */
     STAMR3DeregisterF(pVM->pUVM, "/PDM/Queue/%s/cbItem", pQueue->pszName);
 
+    /*
+     * Stop the consumer thread.
+     */
+    pdmR3QueueStopConsumer(pVM, pQueue);
+
     /*
      * Destroy the timer and free it.
      */
@@ -653,10 +733,17 @@ VMMR3_INT_DECL(void) PDMR3QueueFlushAll(PVM pVM)
         ASMAtomicBitClear(&pVM->pdm.s.fQueueFlushing, PDM_QUEUE_FLUSH_FLAG_PENDING_BIT);
 
         for (PPDMQUEUE pCur = pVM->pUVM->pdm.s.pQueuesForced; pCur; pCur = pCur->pNext)
-            if (    pCur->pPendingR3
-                ||  pCur->pPendingR0
-                ||  pCur->pPendingRC)
-                pdmR3QueueFlush(pCur);
+            if (pdmR3QueueHasPending(pCur))
+            {
+                /* Inserts that couldn't wake up the consumer thread end up here. */
+                if (pCur->hConsumerThread != NIL_RTTHREAD)
+                {
+                    int rc = SUPSemEventSignal(pVM->pSession, pCur->hEvtConsumer);
+                    AssertRC(rc);
+                }
+                else
+                    pdmR3QueueFlush(pCur);
+            }
 
         ASMAtomicBitClear(&pVM->pdm.s.fQueueFlushing, PDM_QUEUE_FLUSH_FLAG_ACTIVE_BIT);
 
@@ -686,12 +773,32 @@ static bool pdmR3QueueFlush(PPDMQUEUE pQueue)
     PPDMQUEUEITEMCORE pItems   = ASMAtomicXchgPtrT(&pQueue->pPendingR3, NULL, PPDMQUEUEITEMCORE);
     RTRCPTR           pItemsRC = ASMAtomicXchgRCPtr(&pQueue->pPendingRC, NIL_RTRCPTR);
     RTR0PTR           pItemsR0 = ASMAtomicXchgR0Ptr(&pQueue->pPendingR0, NIL_RTR0PTR);
+    PPDMQUEUEITEMCORE apStagedR3[PDMQUEUE_STAGES];
+    RTR0PTR           apStagedR0[PDMQUEUE_STAGES];
+    bool              fStaged = false;
+    for (unsigned i = 0; i < PDMQUEUE_STAGES; i++)
+    {
+        apStagedR3[i] = ASMAtomicXchgPtrT(&pQueue->aStages[i].pPendingR3, NULL, PPDMQUEUEITEMCORE);
+        apStagedR0[i] = ASMAtomicXchgR0Ptr(&pQueue->aStages[i].pPendingR0, NIL_RTR0PTR);
+        fStaged |= apStagedR3[i] || apStagedR0[i];
+    }
+
+    /* Leftovers from an earlier flush don't count. */
+    uint64_t const u64FirstPendingTsc = ASMAtomicXchgU64(&pQueue->u64FirstPendingTsc, 0);
+    if (u64FirstPendingTsc)
+        STAM_REL_PROFILE_ADD_PERIOD(&pQueue->StatLatency, ASMReadTSC() - u64FirstPendingTsc);
 
-    AssertMsgReturn(   pItemsR0
-                    || pItemsRC
-                    || pItems,
-                    ("Someone is racing us? This shouldn't happen!\n"),
-                    true);
+    if (   !pItemsR0
+        && !pItemsRC
+        && !pItems
+        && !fStaged)
+    {
+        /* The consumer thread may find the lists empty after an earlier wake-up
+           already picked up the items. */
+        AssertMsg(pQueue->hConsumerThread != NIL_RTTHREAD, ("Someone is racing us? This shouldn't happen!\n"));
+        STAM_PROFILE_STOP(&pQueue->StatFlushPrf,p);
+        return true;
+    }
 
     /*
      * Reverse the list (it's inserted in LIFO order to avoid semaphores, remember).
@@ -706,6 +813,29 @@ static bool pdmR3QueueFlush(PPDMQUEUE pQueue)
         pItems = pInsert;
     }
 
+    /*
+     * Do the same for the staging lists.
+     */
+    for (unsigned i = 0; i < PDMQUEUE_STAGES; i++)
+    {
+        pCur = apStagedR3[i];
+        while (pCur)
+        {
+            PPDMQUEUEITEMCORE pInsert = pCur;
+            pCur = pCur->pNextR3;
+            pInsert->pNextR3 = pItems;
+            pItems = pInsert;
+        }
+        while (apStagedR0[i])
+        {
+            PPDMQUEUEITEMCORE pInsert = (PPDMQUEUEITEMCORE)MMHyperR0ToR3(pQueue->pVMR3, apStagedR0[i]);
+            apStagedR0[i] = pInsert->pNextR0;
+            pInsert->pNextR0 = NIL_RTR0PTR;
+            pInsert->pNextR3 = pItems;
+            pItems = pInsert;
+        }
+    }
+
     /*
      * Do the same for any pending RC items.
      */
@@ -839,7 +969,7 @@ static bool pdmR3QueueFlush(PPDMQUEUE pQueue)
  */
 DECLINLINE(void) pdmR3QueueFreeItem(PPDMQUEUE pQueue, PPDMQUEUEITEMCORE pItem)
 {
-    VM_ASSERT_EMT(pQueue->pVMR3);
+    Assert(VM_IS_EMT(pQueue->pVMR3) || RTThreadSelf() == pQueue->hConsumerThread);
 
     int i = pQueue->iFreeHead;
     int iNext = (i + 1) % (pQueue->cItems + PDMQUEUE_FREE_SLACK);
@@ -854,6 +984,7 @@ DECLINLINE(void) pdmR3QueueFreeItem(PPDMQUEUE pQueue, PPDMQUEUEITEMCORE pItem)
     if (!ASMAtomicCmpXchgU32(&pQueue->iFreeHead, iNext, i))
         AssertMsgFailed(("huh? i=%d iNext=%d iFreeHead=%d iFreeTail=%d\n", i, iNext, pQueue->iFreeHead, pQueue->iFreeTail));
     STAM_STATS({ ASMAtomicDecU32(&pQueue->cStatPending); });
+    STAM_REL_COUNTER_INC(&pQueue->StatFlushItems);
 }
 
 
@@ -870,11 +1001,185 @@ static DECLCALLBACK(void) pdmR3QueueTimer(PVM pVM, PTMTIMER pTimer, void *pvUser
     PPDMQUEUE pQueue = (PPDMQUEUE)pvUser;
     Assert(pTimer == pQueue->pTimer); NOREF(pTimer); NOREF(pVM);
 
-    if (   pQueue->pPendingR3
-        || pQueue->pPendingR0
-        || pQueue->pPendingRC)
+    if (pdmR3QueueHasPending(pQueue))
         pdmR3QueueFlush(pQueue);
     int rc = TMTimerSetMillies(pQueue->pTimer, pQueue->cMilliesInterval);
     AssertRC(rc);
 }
 
+
+/**
+ * Dedicated consumer thread for queues configured with ConsumerThread=true.
+ *
+ * PDMQueueInsert signals the event directly, so this avoids the round trip
+ * through VM_FF_PDM_QUEUES and the EMT.  Items the consumer refuses are left
+ * on the pending list and retried on the next wake-up.
+ *
+ * @returns VINF_SUCCESS.
+ * @param   hThreadSelf     The thread handle.
+ * @param   pvUser          Pointer to the queue.
+ */
+static DECLCALLBACK(int) pdmR3QueueConsumerThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    PPDMQUEUE pQueue = (PPDMQUEUE)pvUser;
+    PVM       pVM    = pQueue->pVMR3;
+    NOREF(hThreadSelf);
+
+    while (!ASMAtomicReadBool(&pQueue->fConsumerTerminate))
+    {
+        int rc = SUPSemEventWaitNoResume(pVM->pSession, pQueue->hEvtConsumer, RT_INDEFINITE_WAIT);
+        if (RT_FAILURE(rc) && rc != VERR_INTERRUPTED)
+        {
+            AssertLogRelMsgFailed(("%s: %Rrc\n", pQueue->pszName, rc));
+            break;
+        }
+        if (ASMAtomicReadBool(&pQueue->fConsumerTerminate))
+            break;
+        STAM_REL_COUNTER_INC(&pQueue->StatConsumerWakeups);
+
+        /* Announce ourselves before checking the park flags, pairs with
+           pdmR3QueueParkConsumers.  Parked items are picked up on unpark. */
+        ASMAtomicWriteBool(&pQueue->fConsumerBusy, true);
+        if (   !ASMAtomicReadU32(&pVM->pUVM->pdm.s.fQueueConsumerPark)
+            && pdmR3QueueHasPending(pQueue))
+            pdmR3QueueFlush(pQueue);
+        ASMAtomicWriteBool(&pQueue->fConsumerBusy, false);
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Stops the consumer thread of a queue, if it has one.
+ *
+ * @param   pVM             Pointer to the VM.
+ * @param   pQueue          The queue.
+ */
+static void pdmR3QueueStopConsumer(PVM pVM, PPDMQUEUE pQueue)
+{
+    if (pQueue->hConsumerThread != NIL_RTTHREAD)
+    {
+        ASMAtomicWriteBool(&pQueue->fConsumerTerminate, true);
+        int rc = SUPSemEventSignal(pVM->pSession, pQueue->hEvtConsumer);
+        AssertRC(rc);
+        rc = RTThreadWait(pQueue->hConsumerThread, 30000, NULL);
+        AssertLogRelRC(rc);
+        pQueue->hConsumerThread = NIL_RTTHREAD;
+    }
+    if (pQueue->hEvtConsumer != NIL_SUPSEMEVENT)
+    {
+        SUPSEMEVENT hEvt = pQueue->hEvtConsumer;
+        pQueue->hEvtConsumer = NIL_SUPSEMEVENT;
+        SUPSemEventClose(pVM->pSession, hEvt);
+    }
+}
+
+
+/**
+ * Stops the consumer threads of the queues owned by a device or driver and
+ * flushes what they left behind on the calling EMT.
+ *
+ * @param   pVM             Pointer to the VM.
+ * @param   enmType         PDMQUEUETYPE_DEV or PDMQUEUETYPE_DRV.
+ * @param   pvOwner         The device or driver instance.
+ */
+static void pdmR3QueueStopOwner(PVM pVM, PDMQUEUETYPE enmType, void *pvOwner)
+{
+    VM_ASSERT_EMT(pVM);
+
+    /* Not holding the PDM lock here as the consumer callbacks may need it. */
+    for (PPDMQUEUE pQueue = pVM->pUVM->pdm.s.pQueuesForced; pQueue; pQueue = pQueue->pNext)
+        if (   pQueue->enmType == enmType
+            && pQueue->hConsumerThread != NIL_RTTHREAD
+            && (  enmType == PDMQUEUETYPE_DEV
+                ? pQueue->u.Dev.pDevIns == (PPDMDEVINS)pvOwner
+                : pQueue->u.Drv.pDrvIns == (PPDMDRVINS)pvOwner))
+        {
+            pdmR3QueueStopConsumer(pVM, pQueue);
+            if (pdmR3QueueHasPending(pQueue))
+                pdmR3QueueFlush(pQueue);
+        }
+}
+
+
+/**
+ * Stops the consumer threads of the queues owned by a device.
+ *
+ * Called before the device destructor so the consumer callbacks don't run
+ * after it.  Pending items are flushed on the calling EMT.
+ *
+ * @param   pVM             Pointer to the VM.
+ * @param   pDevIns         The device instance.
+ * @thread  EMT
+ */
+void pdmR3QueueStopDevice(PVM pVM, PPDMDEVINS pDevIns)
+{
+    pdmR3QueueStopOwner(pVM, PDMQUEUETYPE_DEV, pDevIns);
+}
+
+
+/**
+ * Stops the consumer threads of the queues owned by a driver.
+ *
+ * Called before the driver destructor so the consumer callbacks don't run
+ * after it.  Pending items are flushed on the calling EMT.
+ *
+ * @param   pVM             Pointer to the VM.
+ * @param   pDrvIns         The driver instance.
+ * @thread  EMT
+ */
+void pdmR3QueueStopDriver(PVM pVM, PPDMDRVINS pDrvIns)
+{
+    pdmR3QueueStopOwner(pVM, PDMQUEUETYPE_DRV, pDrvIns);
+}
+
+
+/**
+ * Keeps the queue consumer threads from calling the consumer callbacks.
+ *
+ * Returns after any callback in progress has completed.  Items inserted in the
+ * mean time stay pending until the last park reason has been removed.
+ *
+ * @param   pVM             Pointer to the VM.
+ * @param   fPark           The park reason, PDM_QUEUE_PARK_F_XXX.
+ * @thread  EMT
+ */
+void pdmR3QueueParkConsumers(PVM pVM, uint32_t fPark)
+{
+    PUVM pUVM = pVM->pUVM;
+    VM_ASSERT_EMT(pVM);
+    ASMAtomicOrU32(&pUVM->pdm.s.fQueueConsumerPark, fPark);
+
+    /* Not holding the PDM lock here as the consumer callbacks may need it. */
+    for (PPDMQUEUE pQueue = pUVM->pdm.s.pQueuesForced; pQueue; pQueue = pQueue->pNext)
+        if (pQueue->hConsumerThread != NIL_RTTHREAD)
+            while (ASMAtomicReadBool(&pQueue->fConsumerBusy))
+                RTThreadSleep(1);
+}
+
+
+/**
+ * Removes a park reason set by pdmR3QueueParkConsumers, waking up the consumer
+ * threads to process what's pending when it was the last one.
+ *
+ * @param   pVM             Pointer to the VM.
+ * @param   fPark           The park reason, PDM_QUEUE_PARK_F_XXX.
+ * @thread  EMT
+ */
+void pdmR3QueueUnparkConsumers(PVM pVM, uint32_t fPark)
+{
+    PUVM pUVM = pVM->pUVM;
+    VM_ASSERT_EMT(pVM);
+    ASMAtomicAndU32(&pUVM->pdm.s.fQueueConsumerPark, ~fPark);
+    if (ASMAtomicReadU32(&pUVM->pdm.s.fQueueConsumerPark))
+        return;
+
+    for (PPDMQUEUE pQueue = pUVM->pdm.s.pQueuesForced; pQueue; pQueue = pQueue->pNext)
+        if (   pQueue->hConsumerThread != NIL_RTTHREAD
+            && pdmR3QueueHasPending(pQueue))
+        {
+            int rc = SUPSemEventSignal(pVM->pSession, pQueue->hEvtConsumer);
+            AssertRC(rc);
+        }
+}
+
@@ -1292,6 +1292,8 @@ VMMR3DECL(int) PGMR3Init(PVM pVM)
     pVM->pgm.s.enmHostMode      = SUPPAGINGMODE_INVALID;
     pVM->pgm.s.GCPhys4MBPSEMask = RT_BIT_64(32) - 1; /* default; checked later */
     pVM->pgm.s.GCPtrPrevRamRangeMapping = MM_HYPER_AREA_ADDRESS;
+    for (unsigned i = 0; i < RT_ELEMENTS(pVM->pgm.s.aCodePageTags); i++)
+        pVM->pgm.s.aCodePageTags[i].GCPhys = NIL_RTGCPHYS;
 
     rc = CFGMR3QueryBoolDef(CFGMR3GetRoot(pVM), "RamPreAlloc", &pVM->pgm.s.fRamPreAlloc,
 #ifdef VBOX_WITH_PREALLOC_RAM_BY_DEFAULT
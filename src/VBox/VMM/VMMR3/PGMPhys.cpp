@@ -311,6 +311,7 @@ VMMDECL(int) PGMR3PhysWriteExternal(PVM pVM, RTGCPHYS GCPhys, const void *pvBuf,
                 {
                     memcpy(pvDst, pvBuf, cb);
                     pgmPhysReleaseInternalPageMappingLock(pVM, &PgMpLck);
+                    PGM_PHYS_WRITE_GEN_BUMP(pVM, GCPhys);
                 }
                 else
                     AssertLogRelMsgFailed(("pgmPhysGCPhys2CCPtrInternal failed on %RGp / %R[pgmpage] -> %Rrc\n",
@@ -508,6 +509,9 @@ VMMR3DECL(int) PGMR3PhysGCPhys2CCPtrExternal(PVM pVM, RTGCPHYS GCPhys, void **pp
             *ppv = (void *)((uintptr_t)pTlbe->pv | (uintptr_t)(GCPhys & PAGE_OFFSET_MASK));
             pLock->uPageAndType = (uintptr_t)pPage | PGMPAGEMAPLOCK_TYPE_WRITE;
             pLock->pvMap = pMap;
+
+            /* The caller can write to the page from now on. */
+            PGM_PHYS_WRITE_GEN_BUMP(pVM, GCPhys);
         }
     }
 
@@ -1320,6 +1324,22 @@ VMMR3DECL(uint32_t) PGMR3PhysGetRamRangeCount(PVM pVM)
 }
 
 
+/**
+ * Gets the RAM range generation.
+ *
+ * The generation changes whenever a RAM range is linked or unlinked, which is
+ * what users keeping page mappings across longer periods need to know.
+ *
+ * @returns The generation.  Returns UINT32_MAX if @a pVM is invalid.
+ * @param   pVM             Pointer to the VM.
+ */
+VMMR3DECL(uint32_t) PGMR3PhysGetRamRangeGeneration(PVM pVM)
+{
+    VM_ASSERT_VALID_EXT_RETURN(pVM, UINT32_MAX);
+    return ASMAtomicReadU32(&pVM->pgm.s.idRamRangesGen);
+}
+
+
 /**
  * Get information about a range.
  *
@@ -798,7 +798,7 @@ DECLINLINE(bool) pgmR3ScanMmio2Page(PVM pVM, uint8_t const *pbPage, PPGMLIVESAVE
     bool const fZero = pLSPage->fZero;
     if (fZero)
     {
-        if (ASMMemIsZeroPage(pbPage))
+        if (RTMemIsZero(pbPage, PAGE_SIZE))
         {
             /* Not modified. */
             if (pLSPage->fDirty)
@@ -833,7 +833,7 @@ DECLINLINE(bool) pgmR3ScanMmio2Page(PVM pVM, uint8_t const *pbPage, PPGMLIVESAVE
         {
             pLSPage->u32CrcH1 = u32CrcH1;
             if (    u32CrcH1 == PGM_STATE_CRC32_ZERO_HALF_PAGE
-                &&  ASMMemIsZeroPage(pbPage))
+                &&  RTMemIsZero(pbPage, PAGE_SIZE))
             {
                 pLSPage->u32CrcH2 = PGM_STATE_CRC32_ZERO_HALF_PAGE;
                 pLSPage->fZero    = true;
@@ -924,7 +924,7 @@ static int pgmR3SaveMmio2Pages(PVM pVM, PSSMHANDLE pSSM, bool fLiveSave, uint32_
             {
                 uint8_t u8Type;
                 if (!fLiveSave)
-                    u8Type = ASMMemIsZeroPage(pbPage) ? PGM_STATE_REC_MMIO2_ZERO : PGM_STATE_REC_MMIO2_RAW;
+                    u8Type = RTMemIsZero(pbPage, PAGE_SIZE) ? PGM_STATE_REC_MMIO2_ZERO : PGM_STATE_REC_MMIO2_RAW;
                 else
                 {
                     /* Try figure if it's a clean page, compare the SHA-1 to be really sure. */
@@ -1656,7 +1656,7 @@ static int pgmR3SaveRamPages(PVM pVM, PSSMHANDLE pSSM, bool fLiveSave, uint32_t
                         AssertLogRelMsgRCReturn(rc, ("rc=%Rrc GCPhys=%RGp\n", rc, GCPhys), rc);
 
                         /* Try save some memory when restoring. */
-                        if (!ASMMemIsZeroPage(pvPage))
+                        if (!RTMemIsZero(pvPage, PAGE_SIZE))
                         {
                             if (fFTMDeltaSaveActive)
                             {
@@ -367,7 +367,7 @@ DECLCALLBACK(int) pgmR3CmdCheckDuplicatePages(PCDBGCCMD pCmd, PDBGCCMDHLP pCmdHl
                         const void    *pvPage;
                         int rc = pgmPhysGCPhys2CCPtrInternalReadOnly(pVM, pPage, GCPhys, &pvPage, &PgMpLck);
                         if (    RT_SUCCESS(rc)
-                            &&  ASMMemIsZeroPage(pvPage))
+                            &&  RTMemIsZero(pvPage, PAGE_SIZE))
                             cAllocZero++;
                         else if (GMMR3IsDuplicatePage(pVM, PGM_PAGE_GET_PAGEID(pPage)))
                             cDuplicate++;
@@ -52,15 +52,22 @@
 #include "STAMInternal.h"
 #include <VBox/vmm/vm.h>
 #include <VBox/vmm/uvm.h>
+#include <VBox/vmm/cfgm.h>
+#include <VBox/vmm/mm.h>
 #include <VBox/err.h>
 #include <VBox/dbg.h>
 #include <VBox/log.h>
 
 #include <iprt/assert.h>
 #include <iprt/asm.h>
+#include <iprt/file.h>
 #include <iprt/mem.h>
+#include <iprt/semaphore.h>
 #include <iprt/stream.h>
 #include <iprt/string.h>
+#include <iprt/tcp.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
 
 
 /*******************************************************************************
@@ -118,6 +125,85 @@ typedef struct STAMR3SNAPSHOTONE
 } STAMR3SNAPSHOTONE, *PSTAMR3SNAPSHOTONE;
 
 
+/**
+ * Binary snapshot (STAMR3BinSnapshotCreate).
+ */
+typedef struct STAMBINSNAPSHOT
+{
+    /** STAMBINSNAPSHOT_MAGIC. */
+    uint32_t            u32Magic;
+    /** The layout generation handed to the caller. */
+    uint32_t            uLayout;
+    /** The STAMUSERPERVM::cLayoutGen value the layout was made for. */
+    uint32_t            uLayoutGen;
+    /** Number of samples. */
+    uint32_t            cSamples;
+    /** Number of allocated sample entries. */
+    uint32_t            cSamplesAlloc;
+    /** Number of values. */
+    uint32_t            cValues;
+    /** Number of allocated values. */
+    uint32_t            cValuesAlloc;
+    /** The user mode VM handle. */
+    PUVM                pUVM;
+    /** The sample pattern. */
+    char               *pszPat;
+    /** The sample layout. */
+    STAMBINSAMPLE      *paSamples;
+    /** The sample data pointers (parallel to paSamples). */
+    void              **papvSamples;
+    /** The values. */
+    uint64_t           *pau64Values;
+    /** RTTimeNanoTS() of the last snapshot. */
+    uint64_t            u64NanoTS;
+    /** Sample name copies. */
+    char               *pchNames;
+    /** Used bytes in pchNames. */
+    size_t              offNames;
+    /** Size of pchNames. */
+    size_t              cbNamesAlloc;
+} STAMBINSNAPSHOT;
+
+/** STAMBINSNAPSHOT::u32Magic value (Edsger Wybe Dijkstra). */
+#define STAMBINSNAPSHOT_MAGIC       UINT32_C(0x19300511)
+
+
+/**
+ * Statistics exporter (STAMR3ExportStart).
+ */
+typedef struct STAMEXPORTER
+{
+    /** The user mode VM handle. */
+    PUVM                pUVM;
+    /** The snapshot. */
+    PSTAMBINSNAPSHOT    pSnapshot;
+    /** The values of the previous snapshot. */
+    uint64_t           *pau64Prev;
+    /** The snapshot layout generation of pau64Prev. */
+    uint32_t            uLayout;
+    /** The record sequence number. */
+    uint32_t            uSeq;
+    /** The snapshot interval. */
+    uint32_t            cMsInterval;
+    /** Set by STAMR3ExportStop. */
+    bool volatile       fTerminate;
+    /** The output file, NIL_RTFILE if using a socket. */
+    RTFILE              hFile;
+    /** The output socket, NIL_RTSOCKET if using a file. */
+    RTSOCKET            hSocket;
+    /** The exporter thread. */
+    RTTHREAD            hThread;
+    /** Event for waking up the thread when terminating. */
+    RTSEMEVENT          hEvtTerminate;
+    /** The record buffer. */
+    uint8_t            *pbBuf;
+    /** The size of the record buffer. */
+    size_t              cbBuf;
+} STAMEXPORTER;
+/** Pointer to a statistics exporter. */
+typedef STAMEXPORTER *PSTAMEXPORTER;
+
+
 /**
  * Init record for a ring-0 statistic sample.
  */
@@ -158,6 +244,8 @@ static int                  stamR3EnumU(PUVM pUVM, const char *pszPat, bool fUpd
 static void                 stamR3Ring0StatsRegisterU(PUVM pUVM);
 static void                 stamR3Ring0StatsUpdateU(PUVM pUVM, const char *pszPat);
 static void                 stamR3Ring0StatsUpdateMultiU(PUVM pUVM, const char * const *papszExpressions, unsigned cExpressions);
+static int                  stamR3BinSnapshotLayout(PSTAMBINSNAPSHOT pThis);
+static void                 stamR3ExportDestroy(PSTAMEXPORTER pExp);
 
 #ifdef VBOX_WITH_DEBUGGER
 static FNDBGCCMD            stamR3CmdStats;
@@ -342,6 +430,11 @@ VMMR3DECL(int) STAMR3InitUVM(PUVM pUVM)
  */
 VMMR3DECL(void) STAMR3TermUVM(PUVM pUVM)
 {
+    /*
+     * Stop exporting (normally done by vmR3Destroy already).
+     */
+    STAMR3ExportStop(pUVM);
+
     /*
      * Free used memory and the RWLock.
      */
@@ -1430,6 +1523,7 @@ static int stamR3RegisterU(PUVM pUVM, void *pvSample, PFNSTAMR3CALLBACKRESET pfn
 #endif
 
         stamR3ResetOne(pNew, pUVM->pVM);
+        ASMAtomicIncU32(&pUVM->stam.s.cLayoutGen);
         rc = VINF_SUCCESS;
     }
     else
@@ -1449,6 +1543,7 @@ static int stamR3RegisterU(PUVM pUVM, void *pvSample, PFNSTAMR3CALLBACKRESET pfn
  */
 static int stamR3DestroyDesc(PUVM pUVM, PSTAMDESC pCur)
 {
+    ASMAtomicIncU32(&pUVM->stam.s.cLayoutGen);
     RTListNodeRemove(&pCur->ListEntry);
 #ifdef STAM_WITH_LOOKUP_TREE
     pCur->pLookup->pDesc = NULL; /** @todo free lookup nodes once it's working. */
@@ -2085,6 +2180,678 @@ VMMR3DECL(int)  STAMR3SnapshotFree(PUVM pUVM, char *pszSnapshot)
 }
 
 
+/**
+ * Creates a binary snapshot handle for the samples matching a pattern.
+ *
+ * The layout is established here, the values are first copied by
+ * STAMR3BinSnapshotTake.
+ *
+ * @returns VBox status code.
+ * @param   pUVM            The user mode VM handle.
+ * @param   pszPat          The name matching pattern, NULL or "*" for all.
+ * @param   ppSnapshot      Where to return the snapshot handle.
+ */
+VMMR3DECL(int) STAMR3BinSnapshotCreate(PUVM pUVM, const char *pszPat, PSTAMBINSNAPSHOT *ppSnapshot)
+{
+    UVM_ASSERT_VALID_EXT_RETURN(pUVM, VERR_INVALID_VM_HANDLE);
+    AssertPtrReturn(ppSnapshot, VERR_INVALID_POINTER);
+    *ppSnapshot = NULL;
+
+    PSTAMBINSNAPSHOT pThis = (PSTAMBINSNAPSHOT)RTMemAllocZ(sizeof(*pThis));
+    if (!pThis)
+        return VERR_NO_MEMORY;
+    pThis->u32Magic    = STAMBINSNAPSHOT_MAGIC;
+    pThis->pUVM        = pUVM;
+    pThis->uLayoutGen  = UINT32_MAX;
+    pThis->pszPat      = RTStrDup(pszPat && *pszPat ? pszPat : "*");
+    int rc = VERR_NO_STR_MEMORY;
+    if (pThis->pszPat)
+    {
+        rc = stamR3BinSnapshotLayout(pThis);
+        if (RT_SUCCESS(rc))
+        {
+            *ppSnapshot = pThis;
+            return VINF_SUCCESS;
+        }
+    }
+    STAMR3BinSnapshotDestroy(pThis);
+    return rc;
+}
+
+
+/**
+ * Destroys a binary snapshot handle.
+ *
+ * @returns VBox status code.
+ * @param   pSnapshot       The snapshot handle. NULL is ignored.
+ */
+VMMR3DECL(int) STAMR3BinSnapshotDestroy(PSTAMBINSNAPSHOT pSnapshot)
+{
+    if (!pSnapshot)
+        return VINF_SUCCESS;
+    AssertPtrReturn(pSnapshot, VERR_INVALID_HANDLE);
+    AssertReturn(pSnapshot->u32Magic == STAMBINSNAPSHOT_MAGIC, VERR_INVALID_HANDLE);
+    pSnapshot->u32Magic = ~STAMBINSNAPSHOT_MAGIC;
+    RTMemFree(pSnapshot->paSamples);
+    RTMemFree(pSnapshot->papvSamples);
+    RTMemFree(pSnapshot->pau64Values);
+    RTMemFree(pSnapshot->pchNames);
+    RTStrFree(pSnapshot->pszPat);
+    RTMemFree(pSnapshot);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Gets the number of 64-bit values a sample type takes up in a binary
+ * snapshot.
+ *
+ * @returns Number of values, 0 if not included.
+ * @param   enmType         The sample type.
+ */
+static uint32_t stamR3BinSnapshotValueCount(STAMTYPE enmType)
+{
+    switch (enmType)
+    {
+        case STAMTYPE_PROFILE:
+        case STAMTYPE_PROFILE_ADV:
+            return 4;
+        case STAMTYPE_RATIO_U32:
+        case STAMTYPE_RATIO_U32_RESET:
+            return 2;
+        case STAMTYPE_CALLBACK:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+
+/**
+ * stamR3EnumU callback employed by stamR3BinSnapshotLayout.
+ *
+ * @returns VBox status code, but it's interpreted as 0 == success / !0 == failure by enmR3Enum.
+ * @param   pDesc       The sample.
+ * @param   pvArg       The snapshot.
+ */
+static int stamR3BinSnapshotLayoutOne(PSTAMDESC pDesc, void *pvArg)
+{
+    PSTAMBINSNAPSHOT pThis = (PSTAMBINSNAPSHOT)pvArg;
+    uint32_t const cValues = stamR3BinSnapshotValueCount(pDesc->enmType);
+    if (!cValues)
+        return VINF_SUCCESS;
+
+    /* Grow the arrays. */
+    if (pThis->cSamples >= pThis->cSamplesAlloc)
+    {
+        uint32_t const cNew = pThis->cSamplesAlloc ? pThis->cSamplesAlloc * 2 : 256;
+        void *pvNew = RTMemRealloc(pThis->paSamples, cNew * sizeof(pThis->paSamples[0]));
+        if (!pvNew)
+            return VERR_NO_MEMORY;
+        pThis->paSamples = (STAMBINSAMPLE *)pvNew;
+        pvNew = RTMemRealloc(pThis->papvSamples, cNew * sizeof(pThis->papvSamples[0]));
+        if (!pvNew)
+            return VERR_NO_MEMORY;
+        pThis->papvSamples = (void **)pvNew;
+        pThis->cSamplesAlloc = cNew;
+    }
+    size_t const cbName = strlen(pDesc->pszName) + 1;
+    if (pThis->offNames + cbName > pThis->cbNamesAlloc)
+    {
+        size_t const cbNew = RT_MAX(pThis->cbNamesAlloc * 2, _16K) + cbName;
+        char *pchNew = (char *)RTMemRealloc(pThis->pchNames, cbNew);
+        if (!pchNew)
+            return VERR_NO_MEMORY;
+        pThis->pchNames     = pchNew;
+        pThis->cbNamesAlloc = cbNew;
+    }
+
+    /* Names are stored as offsets until the layout is complete as the
+       string block may move. */
+    memcpy(&pThis->pchNames[pThis->offNames], pDesc->pszName, cbName);
+    STAMBINSAMPLE *pSample = &pThis->paSamples[pThis->cSamples];
+    pSample->pszName     = (const char *)(uintptr_t)pThis->offNames;
+    pSample->enmType     = pDesc->enmType;
+    pSample->enmUnit     = pDesc->enmUnit;
+    pSample->iFirstValue = pThis->cValues;
+    pSample->cValues     = cValues;
+    pThis->papvSamples[pThis->cSamples] = pDesc->u.pv;
+    pThis->offNames += cbName;
+    pThis->cValues  += cValues;
+    pThis->cSamples++;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * (Re-)establishes the layout of a binary snapshot.
+ *
+ * @returns VBox status code.
+ * @param   pThis           The snapshot.
+ */
+static int stamR3BinSnapshotLayout(PSTAMBINSNAPSHOT pThis)
+{
+    PUVM pUVM = pThis->pUVM;
+    pThis->cSamples = 0;
+    pThis->cValues  = 0;
+    pThis->offNames = 0;
+    pThis->uLayoutGen = ASMAtomicReadU32(&pUVM->stam.s.cLayoutGen);
+    int rc = stamR3EnumU(pUVM, pThis->pszPat, false /* fUpdateRing0 */, stamR3BinSnapshotLayoutOne, pThis);
+    if (RT_FAILURE(rc))
+    {
+        pThis->cSamples = 0;
+        pThis->cValues  = 0;
+        pThis->uLayoutGen = UINT32_MAX;
+        return rc;
+    }
+
+    for (uint32_t i = 0; i < pThis->cSamples; i++)
+        pThis->paSamples[i].pszName = &pThis->pchNames[(uintptr_t)pThis->paSamples[i].pszName];
+
+    if (pThis->cValues > pThis->cValuesAlloc)
+    {
+        RTMemFree(pThis->pau64Values);
+        pThis->cValuesAlloc = 0;
+        pThis->pau64Values  = (uint64_t *)RTMemAllocZ(pThis->cValues * sizeof(uint64_t));
+        if (!pThis->pau64Values)
+        {
+            pThis->cSamples = 0;
+            pThis->cValues  = 0;
+            pThis->uLayoutGen = UINT32_MAX;
+            return VERR_NO_MEMORY;
+        }
+        pThis->cValuesAlloc = pThis->cValues;
+    }
+    pThis->uLayout++;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Takes a binary snapshot, i.e. copies the current sample values into the
+ * value array.
+ *
+ * The STAM lock is only held for reading while copying the values, no
+ * formatting is done.
+ *
+ * @returns VBox status code.
+ * @param   pSnapshot       The snapshot handle.
+ * @param   fUpdateRing0    Whether to refresh the GVMM/GMM statistics first.
+ *                          This involves a ring-0 call.
+ */
+VMMR3DECL(int) STAMR3BinSnapshotTake(PSTAMBINSNAPSHOT pSnapshot, bool fUpdateRing0)
+{
+    AssertPtrReturn(pSnapshot, VERR_INVALID_HANDLE);
+    AssertReturn(pSnapshot->u32Magic == STAMBINSNAPSHOT_MAGIC, VERR_INVALID_HANDLE);
+    PUVM pUVM = pSnapshot->pUVM;
+
+    if (fUpdateRing0)
+        stamR3Ring0StatsUpdateU(pUVM, strchr(pSnapshot->pszPat, '|') ? "*" : pSnapshot->pszPat);
+
+    for (unsigned cTries = 0; ; cTries++)
+    {
+        if (pSnapshot->uLayoutGen != ASMAtomicReadU32(&pUVM->stam.s.cLayoutGen))
+        {
+            int rc = stamR3BinSnapshotLayout(pSnapshot);
+            if (RT_FAILURE(rc))
+                return rc;
+        }
+
+        STAM_LOCK_RD(pUVM);
+        if (   pSnapshot->uLayoutGen == pUVM->stam.s.cLayoutGen
+            || cTries >= 16)
+            break;
+        STAM_UNLOCK_RD(pUVM);
+    }
+    /* We may get here with a stale layout after too many retries, don't
+       touch the samples in that case. */
+    if (pSnapshot->uLayoutGen == pUVM->stam.s.cLayoutGen)
+    {
+        uint64_t *pu64 = pSnapshot->pau64Values;
+        for (uint32_t i = 0; i < pSnapshot->cSamples; i++)
+        {
+            void const *pvSample = pSnapshot->papvSamples[i];
+            switch (pSnapshot->paSamples[i].enmType)
+            {
+                case STAMTYPE_COUNTER:
+                    *pu64++ = ((PCSTAMCOUNTER)pvSample)->c;
+                    break;
+                case STAMTYPE_PROFILE:
+                case STAMTYPE_PROFILE_ADV:
+                    *pu64++ = ((PCSTAMPROFILE)pvSample)->cPeriods;
+                    *pu64++ = ((PCSTAMPROFILE)pvSample)->cTicks;
+                    *pu64++ = ((PCSTAMPROFILE)pvSample)->cTicksMin;
+                    *pu64++ = ((PCSTAMPROFILE)pvSample)->cTicksMax;
+                    break;
+                case STAMTYPE_RATIO_U32:
+                case STAMTYPE_RATIO_U32_RESET:
+                    *pu64++ = ((PCSTAMRATIOU32)pvSample)->u32A;
+                    *pu64++ = ((PCSTAMRATIOU32)pvSample)->u32B;
+                    break;
+                case STAMTYPE_U8:
+                case STAMTYPE_U8_RESET:
+                case STAMTYPE_X8:
+                case STAMTYPE_X8_RESET:
+                    *pu64++ = *(uint8_t const *)pvSample;
+                    break;
+                case STAMTYPE_U16:
+                case STAMTYPE_U16_RESET:
+                case STAMTYPE_X16:
+                case STAMTYPE_X16_RESET:
+                    *pu64++ = *(uint16_t const *)pvSample;
+                    break;
+                case STAMTYPE_U32:
+                case STAMTYPE_U32_RESET:
+                case STAMTYPE_X32:
+                case STAMTYPE_X32_RESET:
+                    *pu64++ = *(uint32_t const *)pvSample;
+                    break;
+                case STAMTYPE_U64:
+                case STAMTYPE_U64_RESET:
+                case STAMTYPE_X64:
+                case STAMTYPE_X64_RESET:
+                    *pu64++ = *(uint64_t const *)pvSample;
+                    break;
+                case STAMTYPE_BOOL:
+                case STAMTYPE_BOOL_RESET:
+                    *pu64++ = *(bool const *)pvSample;
+                    break;
+                default:
+                    AssertMsgFailed(("%d\n", pSnapshot->paSamples[i].enmType));
+                    *pu64++ = 0;
+                    break;
+            }
+        }
+        Assert(pu64 == &pSnapshot->pau64Values[pSnapshot->cValues]);
+    }
+    STAM_UNLOCK_RD(pUVM);
+
+    pSnapshot->u64NanoTS = RTTimeNanoTS();
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Gets the sample layout of a binary snapshot.
+ *
+ * The layout entries are valid until the next STAMR3BinSnapshotTake call
+ * which changes the layout generation.
+ *
+ * @returns The layout generation, changes whenever the layout is redone.
+ * @param   pSnapshot       The snapshot handle.
+ * @param   ppaSamples      Where to return the sample array.
+ * @param   pcSamples       Where to return the number of samples.
+ */
+VMMR3DECL(uint32_t) STAMR3BinSnapshotGetLayout(PSTAMBINSNAPSHOT pSnapshot, PCSTAMBINSAMPLE *ppaSamples, uint32_t *pcSamples)
+{
+    AssertPtrReturn(pSnapshot, 0);
+    AssertReturn(pSnapshot->u32Magic == STAMBINSNAPSHOT_MAGIC, 0);
+    *ppaSamples = pSnapshot->paSamples;
+    *pcSamples  = pSnapshot->cSamples;
+    return pSnapshot->uLayout;
+}
+
+
+/**
+ * Gets the values copied by the last STAMR3BinSnapshotTake call.
+ *
+ * @returns Pointer to the value array, NULL on invalid handle.
+ * @param   pSnapshot       The snapshot handle.
+ * @param   pcValues        Where to return the number of values.
+ * @param   pu64NanoTS      Where to return the RTTimeNanoTS() of the snapshot.
+ *                          Optional.
+ */
+VMMR3DECL(uint64_t const *) STAMR3BinSnapshotGetValues(PSTAMBINSNAPSHOT pSnapshot, uint32_t *pcValues, uint64_t *pu64NanoTS)
+{
+    AssertPtrReturn(pSnapshot, NULL);
+    AssertReturn(pSnapshot->u32Magic == STAMBINSNAPSHOT_MAGIC, NULL);
+    *pcValues = pSnapshot->cValues;
+    if (pu64NanoTS)
+        *pu64NanoTS = pSnapshot->u64NanoTS;
+    return pSnapshot->pau64Values;
+}
+
+
+/**
+ * Writes a chunk of data to the export destination.
+ *
+ * @returns VBox status code.
+ * @param   pExp            The exporter.
+ * @param   pvBuf           The data.
+ * @param   cbBuf           The number of bytes to write.
+ */
+static int stamR3ExportWrite(PSTAMEXPORTER pExp, const void *pvBuf, size_t cbBuf)
+{
+    if (pExp->hSocket != NIL_RTSOCKET)
+        return RTTcpWrite(pExp->hSocket, pvBuf, cbBuf);
+    return RTFileWrite(pExp->hFile, pvBuf, cbBuf, NULL);
+}
+
+
+/**
+ * Makes sure the export record buffer can hold a record of the given size.
+ *
+ * @returns Pointer to the buffer, NULL if out of memory.
+ * @param   pExp            The exporter.
+ * @param   cb              The required size.
+ */
+static uint8_t *stamR3ExportEnsureBuf(PSTAMEXPORTER pExp, size_t cb)
+{
+    if (cb > pExp->cbBuf)
+    {
+        uint8_t *pbNew = (uint8_t *)RTMemRealloc(pExp->pbBuf, cb);
+        if (!pbNew)
+            return NULL;
+        pExp->pbBuf = pbNew;
+        pExp->cbBuf = cb;
+    }
+    return pExp->pbBuf;
+}
+
+
+/**
+ * Fills in an export record header.
+ *
+ * @param   pExp            The exporter.
+ * @param   pb              The record buffer.
+ * @param   enmType         The record type.
+ * @param   cbRecord        The record size.
+ */
+static void stamR3ExportInitHdr(PSTAMEXPORTER pExp, uint8_t *pb, STAMEXPORTREC enmType, size_t cbRecord)
+{
+    STAMEXPORTHDR Hdr;
+    Hdr.u32Magic  = STAMEXPORT_MAGIC;
+    Hdr.uVersion  = STAMEXPORT_VERSION;
+    Hdr.uType     = (uint16_t)enmType;
+    Hdr.cbRecord  = (uint32_t)cbRecord;
+    Hdr.uSeq      = pExp->uSeq++;
+    Hdr.u64NanoTS = pExp->pSnapshot->u64NanoTS;
+    memcpy(pb, &Hdr, sizeof(Hdr));
+}
+
+
+/**
+ * Writes a layout record for the current snapshot layout.
+ *
+ * @returns VBox status code.
+ * @param   pExp            The exporter.
+ */
+static int stamR3ExportLayout(PSTAMEXPORTER pExp)
+{
+    PCSTAMBINSAMPLE paSamples;
+    uint32_t        cSamples;
+    STAMR3BinSnapshotGetLayout(pExp->pSnapshot, &paSamples, &cSamples);
+
+    size_t cbRecord = sizeof(STAMEXPORTHDR) + 2 * sizeof(uint32_t);
+    for (uint32_t i = 0; i < cSamples; i++)
+        cbRecord += 3 * sizeof(uint16_t) + strlen(paSamples[i].pszName);
+    uint8_t *pb = stamR3ExportEnsureBuf(pExp, cbRecord);
+    if (!pb)
+        return VERR_NO_MEMORY;
+
+    stamR3ExportInitHdr(pExp, pb, STAMEXPORTREC_LAYOUT, cbRecord);
+    size_t off = sizeof(STAMEXPORTHDR);
+    uint32_t u32 = cSamples;
+    memcpy(&pb[off], &u32, sizeof(u32)); off += sizeof(u32);
+    u32 = pExp->pSnapshot->cValues;
+    memcpy(&pb[off], &u32, sizeof(u32)); off += sizeof(u32);
+    for (uint32_t i = 0; i < cSamples; i++)
+    {
+        uint16_t const cchName = (uint16_t)strlen(paSamples[i].pszName);
+        uint16_t const cValues = (uint16_t)paSamples[i].cValues;
+        pb[off++] = (uint8_t)paSamples[i].enmType;
+        pb[off++] = (uint8_t)paSamples[i].enmUnit;
+        memcpy(&pb[off], &cValues, sizeof(cValues)); off += sizeof(cValues);
+        memcpy(&pb[off], &cchName, sizeof(cchName)); off += sizeof(cchName);
+        memcpy(&pb[off], paSamples[i].pszName, cchName); off += cchName;
+    }
+    Assert(off == cbRecord);
+    return stamR3ExportWrite(pExp, pb, cbRecord);
+}
+
+
+/**
+ * Takes a snapshot and writes the changed values (and the layout if it
+ * changed) to the export destination.
+ *
+ * @returns VBox status code.
+ * @param   pExp            The exporter.
+ */
+static int stamR3ExportOne(PSTAMEXPORTER pExp)
+{
+    int rc = STAMR3BinSnapshotTake(pExp->pSnapshot, true /* fUpdateRing0 */);
+    if (RT_FAILURE(rc))
+        return rc;
+
+    /*
+     * New layout?  Then write it and start over with a full values record.
+     */
+    uint32_t        cValues;
+    uint64_t const *pau64Values = STAMR3BinSnapshotGetValues(pExp->pSnapshot, &cValues, NULL);
+    PCSTAMBINSAMPLE paSamples;
+    uint32_t        cSamples;
+    uint32_t const  uLayout     = STAMR3BinSnapshotGetLayout(pExp->pSnapshot, &paSamples, &cSamples);
+    bool const      fFull       = uLayout != pExp->uLayout;
+    if (fFull)
+    {
+        rc = stamR3ExportLayout(pExp);
+        if (RT_FAILURE(rc))
+            return rc;
+        RTMemFree(pExp->pau64Prev);
+        pExp->pau64Prev = (uint64_t *)RTMemAllocZ(RT_MAX(cValues, 1) * sizeof(uint64_t));
+        if (!pExp->pau64Prev)
+            return VERR_NO_MEMORY;
+        pExp->uLayout = uLayout;
+    }
+
+    /*
+     * Values record.
+     */
+    size_t const cbEntry = sizeof(uint32_t) + sizeof(uint64_t);
+    uint8_t *pb = stamR3ExportEnsureBuf(pExp, sizeof(STAMEXPORTHDR) + sizeof(uint32_t) + cValues * cbEntry);
+    if (!pb)
+        return VERR_NO_MEMORY;
+    size_t   off      = sizeof(STAMEXPORTHDR) + sizeof(uint32_t);
+    uint32_t cChanged = 0;
+    for (uint32_t i = 0; i < cValues; i++)
+        if (fFull || pau64Values[i] != pExp->pau64Prev[i])
+        {
+            memcpy(&pb[off], &i, sizeof(i));
+            memcpy(&pb[off + sizeof(i)], &pau64Values[i], sizeof(uint64_t));
+            off += cbEntry;
+            cChanged++;
+        }
+    memcpy(pExp->pau64Prev, pau64Values, cValues * sizeof(uint64_t));
+
+    stamR3ExportInitHdr(pExp, pb, STAMEXPORTREC_VALUES, off);
+    memcpy(&pb[sizeof(STAMEXPORTHDR)], &cChanged, sizeof(cChanged));
+    return stamR3ExportWrite(pExp, pb, off);
+}
+
+
+/**
+ * The exporter thread.
+ *
+ * @returns VINF_SUCCESS.
+ * @param   hThreadSelf     The thread handle.
+ * @param   pvUser          The exporter.
+ */
+static DECLCALLBACK(int) stamR3ExportThread(RTTHREAD hThreadSelf, void *pvUser)
+{
+    PSTAMEXPORTER pExp = (PSTAMEXPORTER)pvUser;
+    NOREF(hThreadSelf);
+
+    while (!ASMAtomicReadBool(&pExp->fTerminate))
+    {
+        int rc = stamR3ExportOne(pExp);
+        if (RT_FAILURE(rc))
+        {
+            LogRel(("STAM: Statistics export failed (%Rrc), stopping\n", rc));
+            break;
+        }
+        RTSemEventWait(pExp->hEvtTerminate, pExp->cMsInterval);
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Starts streaming statistics to a file or a local TCP port.
+ *
+ * A snapshot of the samples matching @a pszPat is taken every @a cMsInterval
+ * milliseconds and written as STAMEXPORTREC_VALUES records containing the
+ * values which changed since the last one.  Layout changes are announced by
+ * STAMEXPORTREC_LAYOUT records.
+ *
+ * @returns VBox status code.
+ * @param   pUVM            The user mode VM handle.
+ * @param   pszDest         The destination: "tcp:<port>" to connect to a port
+ *                          on localhost, otherwise a file name (which can be a
+ *                          named pipe).
+ * @param   pszPat          The name matching pattern, NULL or "*" for all.
+ * @param   cMsInterval     The snapshot interval in milliseconds.
+ */
+VMMR3DECL(int) STAMR3ExportStart(PUVM pUVM, const char *pszDest, const char *pszPat, uint32_t cMsInterval)
+{
+    UVM_ASSERT_VALID_EXT_RETURN(pUVM, VERR_INVALID_VM_HANDLE);
+    AssertPtrReturn(pszDest, VERR_INVALID_POINTER);
+    AssertReturn(cMsInterval >= 10, VERR_OUT_OF_RANGE);
+    if (pUVM->stam.s.pExporter)
+        return VERR_ALREADY_EXISTS;
+
+    PSTAMEXPORTER pExp = (PSTAMEXPORTER)RTMemAllocZ(sizeof(*pExp));
+    if (!pExp)
+        return VERR_NO_MEMORY;
+    pExp->pUVM          = pUVM;
+    pExp->hFile         = NIL_RTFILE;
+    pExp->hSocket       = NIL_RTSOCKET;
+    pExp->hThread       = NIL_RTTHREAD;
+    pExp->hEvtTerminate = NIL_RTSEMEVENT;
+    pExp->cMsInterval   = cMsInterval;
+    pExp->uLayout       = UINT32_MAX;
+
+    int rc;
+    if (!strncmp(pszDest, RT_STR_TUPLE("tcp:")))
+    {
+        uint32_t uPort;
+        rc = RTStrToUInt32Full(pszDest + sizeof("tcp:") - 1, 10, &uPort);
+        if (rc == VINF_SUCCESS && uPort > 0 && uPort <= 65535)
+            rc = RTTcpClientConnect("localhost", uPort, &pExp->hSocket);
+        else
+            rc = VERR_INVALID_PARAMETER;
+    }
+    else
+        rc = RTFileOpen(&pExp->hFile, pszDest, RTFILE_O_WRITE | RTFILE_O_OPEN_CREATE | RTFILE_O_TRUNCATE | RTFILE_O_DENY_NONE);
+    if (RT_SUCCESS(rc))
+        rc = STAMR3BinSnapshotCreate(pUVM, pszPat, &pExp->pSnapshot);
+    if (RT_SUCCESS(rc))
+        rc = RTSemEventCreate(&pExp->hEvtTerminate);
+    if (RT_SUCCESS(rc))
+    {
+        rc = RTThreadCreate(&pExp->hThread, stamR3ExportThread, pExp, 0, RTTHREADTYPE_DEFAULT, RTTHREADFLAGS_WAITABLE, "StamExport");
+        if (RT_SUCCESS(rc))
+        {
+            pUVM->stam.s.pExporter = pExp;
+            LogRel(("STAM: Exporting '%s' to '%s' every %u ms\n", pszPat ? pszPat : "*", pszDest, cMsInterval));
+            return VINF_SUCCESS;
+        }
+    }
+    LogRel(("STAM: Failed to start exporting to '%s': %Rrc\n", pszDest, rc));
+    stamR3ExportDestroy(pExp);
+    return rc;
+}
+
+
+/**
+ * Releases the exporter resources, the thread must not be running.
+ *
+ * @param   pExp            The exporter.
+ */
+static void stamR3ExportDestroy(PSTAMEXPORTER pExp)
+{
+    if (pExp->hEvtTerminate != NIL_RTSEMEVENT)
+        RTSemEventDestroy(pExp->hEvtTerminate);
+    STAMR3BinSnapshotDestroy(pExp->pSnapshot);
+    if (pExp->hSocket != NIL_RTSOCKET)
+        RTTcpClientClose(pExp->hSocket);
+    if (pExp->hFile != NIL_RTFILE)
+        RTFileClose(pExp->hFile);
+    RTMemFree(pExp->pau64Prev);
+    RTMemFree(pExp->pbBuf);
+    RTMemFree(pExp);
+}
+
+
+/**
+ * Stops the statistics export started by STAMR3ExportStart.
+ *
+ * @returns VBox status code.
+ * @retval  VWRN_NOT_FOUND if not exporting.
+ * @param   pUVM            The user mode VM handle.
+ */
+VMMR3DECL(int) STAMR3ExportStop(PUVM pUVM)
+{
+    UVM_ASSERT_VALID_EXT_RETURN(pUVM, VERR_INVALID_VM_HANDLE);
+    PSTAMEXPORTER pExp = ASMAtomicXchgPtrT(&pUVM->stam.s.pExporter, NULL, PSTAMEXPORTER);
+    if (!pExp)
+        return VWRN_NOT_FOUND;
+
+    ASMAtomicWriteBool(&pExp->fTerminate, true);
+    RTSemEventSignal(pExp->hEvtTerminate);
+    int rc = RTThreadWait(pExp->hThread, 30000, NULL);
+    AssertLogRelRCReturn(rc, rc); /* leak it rather than pulling the rug from under the thread */
+    stamR3ExportDestroy(pExp);
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Called when ring-3 init has completed, starts the configured statistics
+ * export.
+ *
+ * @returns VBox status code.
+ * @param   pVM             Pointer to the VM.
+ */
+VMMR3_INT_DECL(int) STAMR3InitCompleted(PVM pVM)
+{
+    PCFGMNODE pCfg = CFGMR3GetChild(CFGMR3GetRoot(pVM), "STAM/Export");
+    if (!pCfg)
+        return VINF_SUCCESS;
+
+    /** @cfgm{/STAM/Export/Destination, string, none}
+     * Where to stream the statistics to: "tcp:<port>" for a port on localhost
+     * or a file name.  See STAMR3ExportStart. */
+    char *pszDest;
+    int rc = CFGMR3QueryStringAllocDef(pCfg, "Destination", &pszDest, NULL);
+    AssertLogRelRCReturn(rc, rc);
+    if (!pszDest)
+        return VINF_SUCCESS;
+
+    /** @cfgm{/STAM/Export/Pattern, string, *}
+     * The sample name pattern to export. */
+    char *pszPat;
+    rc = CFGMR3QueryStringAllocDef(pCfg, "Pattern", &pszPat, "*");
+    if (RT_SUCCESS(rc))
+    {
+        /** @cfgm{/STAM/Export/IntervalMs, uint32_t, 1000, 10, 3600000}
+         * The snapshot interval in milliseconds. */
+        uint32_t cMsInterval;
+        rc = CFGMR3QueryU32Def(pCfg, "IntervalMs", &cMsInterval, 1000);
+        if (RT_SUCCESS(rc) && (cMsInterval < 10 || cMsInterval > 3600000))
+            rc = VMSetError(pVM, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                            N_("Configuration error: /STAM/Export/IntervalMs must be between 10 and 3600000"));
+        else if (RT_SUCCESS(rc))
+        {
+            /* Failing to connect to the monitoring shouldn't prevent the VM from starting. */
+            STAMR3ExportStart(pVM->pUVM, pszDest, pszPat, cMsInterval);
+        }
+        MMR3HeapFree(pszPat);
+    }
+    MMR3HeapFree(pszDest);
+    return rc;
+}
+
+
 /**
  * Dumps the selected statistics to the log.
  *
@@ -1343,6 +1343,7 @@ static int tmr3TimerCreate(PVM pVM, TMCLOCK enmClock, const char *pszDesc, PPTMT
     pTimer->offScheduleNext = 0;
     pTimer->offNext         = 0;
     pTimer->offPrev         = 0;
+    RT_ZERO(pTimer->ActiveCore);
     pTimer->pvUser          = NULL;
     pTimer->pCritSect       = NULL;
     pTimer->pszDesc         = pszDesc;
@@ -1658,6 +1659,7 @@ VMMR3DECL(int) TMR3TimerDestroy(PTMTIMER pTimer)
     {
         const PTMTIMER pPrev = TMTIMER_GET_PREV(pTimer);
         const PTMTIMER pNext = TMTIMER_GET_NEXT(pTimer);
+        tmTimerQueueIndexRemove(pQueue, pTimer, pPrev, pNext);
         if (pPrev)
             TMTIMER_SET_NEXT(pPrev, pNext);
         else
@@ -2053,6 +2055,7 @@ static void tmR3TimerQueueRun(PVM pVM, PTMTIMERQUEUE pQueue)
 
             /* unlink */
             const PTMTIMER pPrev = TMTIMER_GET_PREV(pTimer);
+            tmTimerQueueIndexRemove(pQueue, pTimer, pPrev, pNext);
             if (pPrev)
                 TMTIMER_SET_NEXT(pPrev, pNext);
             else
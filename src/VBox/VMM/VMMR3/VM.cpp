@@ -915,6 +915,30 @@ static int vmR3InitRing3(PVM pVM, PUVM pUVM)
         AssertRC(rc);
         rc = STAMR3RegisterF(pVM, &pUVM->aCpus[idCpu].vm.s.StatHaltTimers,          STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, STAMUNIT_NS_PER_CALL, "Profiling halted state timer tasks.", "/PROF/CPU%d/VM/Halt/Timers", idCpu);
         AssertRC(rc);
+        rc = STAMR3RegisterF(pVM, &pUVM->aCpus[idCpu].vm.s.StatHaltPoll,            STAMTYPE_PROFILE, STAMVISIBILITY_USED,   STAMUNIT_NS_PER_CALL, "Profiling halted state polling.",   "/PROF/CPU%d/VM/Halt/Poll", idCpu);
+        AssertRC(rc);
+        rc = STAMR3RegisterF(pVM, &pUVM->aCpus[idCpu].vm.s.StatHaltPollHits,        STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,  "Halts ended while polling.",        "/PROF/CPU%d/VM/Halt/PollHits", idCpu);
+        AssertRC(rc);
+        rc = STAMR3RegisterF(pVM, &pUVM->aCpus[idCpu].vm.s.StatHaltPollMisses,      STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,  "Polls running out the poll window.", "/PROF/CPU%d/VM/Halt/PollMisses", idCpu);
+        AssertRC(rc);
+        rc = STAMR3RegisterF(pVM, &pUVM->aCpus[idCpu].vm.s.StatHaltPollGrow,        STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,  "Poll window increases.",            "/PROF/CPU%d/VM/Halt/PollGrow", idCpu);
+        AssertRC(rc);
+        rc = STAMR3RegisterF(pVM, &pUVM->aCpus[idCpu].vm.s.StatHaltPollShrink,      STAMTYPE_COUNTER, STAMVISIBILITY_USED,   STAMUNIT_OCCURENCES,  "Poll window decreases.",            "/PROF/CPU%d/VM/Halt/PollShrink", idCpu);
+        AssertRC(rc);
+        for (unsigned iBucket = 0; iBucket < VM_HALT_HIST_BUCKETS; iBucket++)
+        {
+            static const char * const s_apszBuckets[VM_HALT_HIST_BUCKETS] =
+            { "00-lt1us",   "01-lt4us",   "02-lt16us",   "03-lt64us",   "04-lt256us",
+              "05-lt1ms",   "06-lt4ms",   "07-lt16ms",   "08-lt64ms",   "09-ge64ms" };
+            rc = STAMR3RegisterF(pVM, &pUVM->aCpus[idCpu].vm.s.aStatHaltDuration[iBucket],      STAMTYPE_COUNTER, STAMVISIBILITY_USED,
+                                 STAMUNIT_OCCURENCES, "Halt duration histogram (adaptive method).",
+                                 "/PROF/CPU%d/VM/Halt/Duration/%s", idCpu, s_apszBuckets[iBucket]);
+            AssertRC(rc);
+            rc = STAMR3RegisterF(pVM, &pUVM->aCpus[idCpu].vm.s.aStatHaltWakeupLatency[iBucket], STAMTYPE_COUNTER, STAMVISIBILITY_USED,
+                                 STAMUNIT_OCCURENCES, "Wake-up latency histogram (adaptive method).",
+                                 "/PROF/CPU%d/VM/Halt/WakeupLatency/%s", idCpu, s_apszBuckets[iBucket]);
+            AssertRC(rc);
+        }
     }
 
     STAM_REG(pVM, &pUVM->vm.s.StatReqAllocNew,   STAMTYPE_COUNTER,     "/VM/Req/AllocNew",       STAMUNIT_OCCURENCES,        "Number of VMR3ReqAlloc returning a new packet.");
@@ -1165,6 +1189,8 @@ static int vmR3InitDoCompleted(PVM pVM, VMINITCOMPLETED enmWhat)
         rc = HMR3InitCompleted(pVM, enmWhat);
     if (RT_SUCCESS(rc))
         rc = PGMR3InitCompleted(pVM, enmWhat);
+    if (RT_SUCCESS(rc) && enmWhat == VMINITCOMPLETED_RING3)
+        rc = STAMR3InitCompleted(pVM);
 #ifndef VBOX_WITH_RAW_MODE
     if (enmWhat == VMINITCOMPLETED_RING3)
     {
@@ -2474,6 +2500,11 @@ DECLCALLBACK(int) vmR3Destroy(PVM pVM)
      */
     if (pVCpu->idCpu == 0)
     {
+        /*
+         * Stop any statistics export before the samples start going away.
+         */
+        STAMR3ExportStop(pUVM);
+
         /*
          * Dump statistics to the log.
          */
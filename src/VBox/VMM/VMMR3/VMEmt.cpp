@@ -286,6 +286,7 @@ static const char *vmR3GetHaltMethodName(VMHALTMETHOD enmMethod)
         case VMHALTMETHOD_1:            return "method1";
         //case VMHALTMETHOD_2:            return "method2";
         case VMHALTMETHOD_GLOBAL_1:     return "global1";
+        case VMHALTMETHOD_ADAPTIVE:     return "adaptive";
         default:                        return "unknown";
     }
 }
@@ -833,6 +834,292 @@ static DECLCALLBACK(void) vmR3HaltGlobal1NotifyCpuFF(PUVMCPU pUVCpu, uint32_t fF
 }
 
 
+/**
+ * Gets the histogram bucket for a halt duration or wake-up latency.
+ *
+ * @returns Index into the VM_HALT_HIST_BUCKETS sized histogram arrays.
+ * @param   cNs             The time in nanoseconds.
+ */
+DECLINLINE(unsigned) vmR3HaltHistBucket(uint64_t cNs)
+{
+    unsigned i        = 0;
+    uint64_t cNsLimit = RT_NS_1US;
+    while (i < VM_HALT_HIST_BUCKETS - 1 && cNs >= cNsLimit)
+    {
+        i++;
+        cNsLimit *= 4;
+    }
+    return i;
+}
+
+
+/**
+ * Initialize the adaptive halt method.
+ *
+ * @return VBox status code.
+ * @param   pUVM            Pointer to the user mode VM structure.
+ */
+static DECLCALLBACK(int) vmR3HaltAdaptiveInit(PUVM pUVM)
+{
+    /*
+     * The defaults.  The spin/block threshold is the same as for global 1.
+     */
+    uint32_t cNsResolution = SUPSemEventMultiGetResolution(pUVM->vm.s.pSession);
+    if (cNsResolution > 5*RT_NS_100US)
+        pUVM->vm.s.Halt.Adaptive.cNsSpinBlockThresholdCfg = 50000;
+    else if (cNsResolution > RT_NS_100US)
+        pUVM->vm.s.Halt.Adaptive.cNsSpinBlockThresholdCfg = cNsResolution / 4;
+    else
+        pUVM->vm.s.Halt.Adaptive.cNsSpinBlockThresholdCfg = 2000;
+    pUVM->vm.s.Halt.Adaptive.cNsPollStartCfg          = 10000;
+    pUVM->vm.s.Halt.Adaptive.cNsPollMaxCfg            = 200000;
+    pUVM->vm.s.Halt.Adaptive.uPollGrowCfg             = 2;
+    pUVM->vm.s.Halt.Adaptive.uPollShrinkCfg           = 2;
+
+    /*
+     * Query overrides.
+     */
+    PCFGMNODE pCfg = CFGMR3GetChild(CFGMR3GetRoot(pUVM->pVM), "/VMM/HaltedAdaptive");
+    if (pCfg)
+    {
+        uint32_t u32;
+        if (RT_SUCCESS(CFGMR3QueryU32(pCfg, "SpinBlockThreshold", &u32)))
+            pUVM->vm.s.Halt.Adaptive.cNsSpinBlockThresholdCfg = u32;
+        if (RT_SUCCESS(CFGMR3QueryU32(pCfg, "PollStart", &u32)))
+            pUVM->vm.s.Halt.Adaptive.cNsPollStartCfg = u32;
+        if (RT_SUCCESS(CFGMR3QueryU32(pCfg, "PollMax", &u32)))
+            pUVM->vm.s.Halt.Adaptive.cNsPollMaxCfg = u32;
+        if (RT_SUCCESS(CFGMR3QueryU32(pCfg, "PollGrow", &u32)))
+            pUVM->vm.s.Halt.Adaptive.uPollGrowCfg = u32;
+        if (RT_SUCCESS(CFGMR3QueryU32(pCfg, "PollShrink", &u32)))
+            pUVM->vm.s.Halt.Adaptive.uPollShrinkCfg = u32;
+    }
+    if (   pUVM->vm.s.Halt.Adaptive.cNsPollStartCfg > pUVM->vm.s.Halt.Adaptive.cNsPollMaxCfg
+        || pUVM->vm.s.Halt.Adaptive.uPollGrowCfg < 2
+        || pUVM->vm.s.Halt.Adaptive.uPollShrinkCfg < 2)
+        return VMSetError(pUVM->pVM, VERR_INVALID_PARAMETER, RT_SRC_POS,
+                          N_("Configuration error: Invalid /VMM/HaltedAdaptive values (PollStart=%u PollMax=%u PollGrow=%u PollShrink=%u)"),
+                          pUVM->vm.s.Halt.Adaptive.cNsPollStartCfg, pUVM->vm.s.Halt.Adaptive.cNsPollMaxCfg,
+                          pUVM->vm.s.Halt.Adaptive.uPollGrowCfg, pUVM->vm.s.Halt.Adaptive.uPollShrinkCfg);
+    LogRel(("HaltedAdaptive config: cNsSpinBlockThresholdCfg=%u cNsPollStartCfg=%u cNsPollMaxCfg=%u uPollGrowCfg=%u uPollShrinkCfg=%u\n",
+            pUVM->vm.s.Halt.Adaptive.cNsSpinBlockThresholdCfg, pUVM->vm.s.Halt.Adaptive.cNsPollStartCfg,
+            pUVM->vm.s.Halt.Adaptive.cNsPollMaxCfg, pUVM->vm.s.Halt.Adaptive.uPollGrowCfg,
+            pUVM->vm.s.Halt.Adaptive.uPollShrinkCfg));
+
+    for (VMCPUID idCpu = 0; idCpu < pUVM->cCpus; idCpu++)
+    {
+        pUVM->aCpus[idCpu].vm.s.Halt.Adaptive.cNsPollWindow = 0;
+        pUVM->aCpus[idCpu].vm.s.Halt.Adaptive.fPolling      = false;
+        pUVM->aCpus[idCpu].vm.s.Halt.Adaptive.u64WakeupTS   = 0;
+    }
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * The adaptive halt method - Poll the FFs for a while, then block in GVMM
+ * like the global 1 method.
+ *
+ * The poll window grows when the EMT gets woken up shortly after blocking and
+ * shrinks when polling doesn't pay off.
+ */
+static DECLCALLBACK(int) vmR3HaltAdaptiveHalt(PUVMCPU pUVCpu, const uint32_t fMask, uint64_t u64Now)
+{
+    PUVM    pUVM  = pUVCpu->pUVM;
+    PVMCPU  pVCpu = pUVCpu->pVCpu;
+    PVM     pVM   = pUVCpu->pVM;
+    Assert(VMMGetCpu(pVM) == pVCpu);
+    NOREF(u64Now);
+
+    uint32_t const cNsPollWindow = pUVCpu->vm.s.Halt.Adaptive.cNsPollWindow;
+    bool           fPolled       = false;
+    bool           fWokenByPoll  = false;
+    bool           fWokenEarly   = false;
+    uint64_t const u64StartHalt  = RTTimeNanoTS();
+
+    /*
+     * Halt loop.
+     */
+    int rc = VINF_SUCCESS;
+    ASMAtomicWriteU64(&pUVCpu->vm.s.Halt.Adaptive.u64WakeupTS, 0);
+    ASMAtomicWriteBool(&pUVCpu->vm.s.fWait, true);
+    unsigned cLoops = 0;
+    for (;; cLoops++)
+    {
+        /*
+         * Work the timers and check if we can exit.
+         */
+        uint64_t const u64StartTimers   = RTTimeNanoTS();
+        TMR3TimerQueuesDo(pVM);
+        uint64_t const cNsElapsedTimers = RTTimeNanoTS() - u64StartTimers;
+        STAM_REL_PROFILE_ADD_PERIOD(&pUVCpu->vm.s.StatHaltTimers, cNsElapsedTimers);
+        if (    VM_FF_IS_PENDING(pVM, VM_FF_EXTERNAL_HALTED_MASK)
+            ||  VMCPU_FF_IS_PENDING(pVCpu, fMask))
+            break;
+
+        /*
+         * Estimate time left to the next event.
+         */
+        uint64_t u64Delta;
+        uint64_t u64GipTime = TMTimerPollGIP(pVM, pVCpu, &u64Delta);
+        if (    VM_FF_IS_PENDING(pVM, VM_FF_EXTERNAL_HALTED_MASK)
+            ||  VMCPU_FF_IS_PENDING(pVCpu, fMask))
+            break;
+
+        /*
+         * Poll the FFs before blocking, once per halt.  The notifier skips the
+         * ring-0 wake-up call while we're at it.
+         */
+        if (   !fPolled
+            && cNsPollWindow
+            && u64Delta >= pUVM->vm.s.Halt.Adaptive.cNsSpinBlockThresholdCfg)
+        {
+            fPolled = true;
+            uint64_t const cNsPoll      = RT_MIN(cNsPollWindow, u64Delta);
+            uint64_t const u64StartPoll = RTTimeNanoTS();
+            uint64_t       cNsPolled;
+            ASMAtomicWriteBool(&pUVCpu->vm.s.Halt.Adaptive.fPolling, true);
+            for (;;)
+            {
+                if (    VM_FF_IS_PENDING(pVM, VM_FF_EXTERNAL_HALTED_MASK)
+                    ||  VMCPU_FF_IS_PENDING(pVCpu, fMask))
+                {
+                    fWokenByPoll = true;
+                    break;
+                }
+                cNsPolled = RTTimeNanoTS() - u64StartPoll;
+                if (cNsPolled >= cNsPoll)
+                    break;
+                ASMNopPause();
+            }
+            /* Clearing the flag is a full barrier, so a notifier that saw it
+               set must have set its FF before we check them again. */
+            ASMAtomicWriteBool(&pUVCpu->vm.s.Halt.Adaptive.fPolling, false);
+            STAM_REL_PROFILE_ADD_PERIOD(&pUVCpu->vm.s.StatHaltPoll, RTTimeNanoTS() - u64StartPoll);
+            if (fWokenByPoll)
+                break;
+            continue;
+        }
+
+        /*
+         * Block if we're not spinning and the interval isn't all that small.
+         */
+        if (u64Delta >= pUVM->vm.s.Halt.Adaptive.cNsSpinBlockThresholdCfg)
+        {
+            VMMR3YieldStop(pVM);
+            if (    VM_FF_IS_PENDING(pVM, VM_FF_EXTERNAL_HALTED_MASK)
+                ||  VMCPU_FF_IS_PENDING(pVCpu, fMask))
+                break;
+
+            uint64_t const u64StartSchedHalt   = RTTimeNanoTS();
+            rc = SUPR3CallVMMR0Ex(pVM->pVMR0, pVCpu->idCpu, VMMR0_DO_GVMM_SCHED_HALT, u64GipTime, NULL);
+            uint64_t const u64EndSchedHalt     = RTTimeNanoTS();
+            uint64_t const cNsElapsedSchedHalt = u64EndSchedHalt - u64StartSchedHalt;
+            STAM_REL_PROFILE_ADD_PERIOD(&pUVCpu->vm.s.StatHaltBlock, cNsElapsedSchedHalt);
+
+            if (rc == VERR_INTERRUPTED)
+                rc = VINF_SUCCESS;
+            else if (RT_FAILURE(rc))
+            {
+                rc = vmR3FatalWaitError(pUVCpu, "VMMR0_DO_GVMM_SCHED_HALT->%Rrc\n", rc);
+                break;
+            }
+            else
+            {
+                int64_t const cNsOverslept = u64EndSchedHalt - u64GipTime;
+                if (cNsOverslept > 50000)
+                    STAM_PROFILE_ADD_PERIOD(&pUVCpu->vm.s.StatHaltBlockOverslept, cNsOverslept);
+                else if (cNsOverslept < -50000)
+                {
+                    STAM_PROFILE_ADD_PERIOD(&pUVCpu->vm.s.StatHaltBlockInsomnia,  cNsElapsedSchedHalt);
+                    fWokenEarly = true;
+                }
+                else
+                    STAM_PROFILE_ADD_PERIOD(&pUVCpu->vm.s.StatHaltBlockOnTime,    cNsElapsedSchedHalt);
+            }
+        }
+        /*
+         * When spinning call upon the GVMM and do some wakups once
+         * in a while, it's not like we're actually busy or anything.
+         */
+        else if (!(cLoops & 0x1fff))
+        {
+            uint64_t const u64StartSchedYield   = RTTimeNanoTS();
+            rc = SUPR3CallVMMR0Ex(pVM->pVMR0, pVCpu->idCpu, VMMR0_DO_GVMM_SCHED_POLL, false /* don't yield */, NULL);
+            uint64_t const cNsElapsedSchedYield = RTTimeNanoTS() - u64StartSchedYield;
+            STAM_REL_PROFILE_ADD_PERIOD(&pUVCpu->vm.s.StatHaltYield, cNsElapsedSchedYield);
+        }
+    }
+
+    ASMAtomicUoWriteBool(&pUVCpu->vm.s.fWait, false);
+
+    /*
+     * Update the histograms.
+     */
+    uint64_t const u64EndHalt  = RTTimeNanoTS();
+    uint64_t const cNsHalted   = u64EndHalt - u64StartHalt;
+    uint64_t const u64WakeupTS = ASMAtomicXchgU64(&pUVCpu->vm.s.Halt.Adaptive.u64WakeupTS, 0);
+    STAM_REL_COUNTER_INC(&pUVCpu->vm.s.aStatHaltDuration[vmR3HaltHistBucket(cNsHalted)]);
+    if (u64WakeupTS - u64StartHalt <= cNsHalted) /* (also skips zero and stale timestamps) */
+        STAM_REL_COUNTER_INC(&pUVCpu->vm.s.aStatHaltWakeupLatency[vmR3HaltHistBucket(u64EndHalt - u64WakeupTS)]);
+
+    /*
+     * Adjust the poll window.  An FF arriving within the max poll window
+     * after we blocked means polling would have saved the wake-up, while
+     * running out the window or halting for long means it was wasted.
+     */
+    if (fWokenByPoll)
+        STAM_REL_COUNTER_INC(&pUVCpu->vm.s.StatHaltPollHits);
+    else
+    {
+        if (fPolled)
+            STAM_REL_COUNTER_INC(&pUVCpu->vm.s.StatHaltPollMisses);
+        if (   fWokenEarly
+            && cNsHalted <= pUVM->vm.s.Halt.Adaptive.cNsPollMaxCfg)
+        {
+            uint64_t cNsNew = cNsPollWindow
+                            ? (uint64_t)cNsPollWindow * pUVM->vm.s.Halt.Adaptive.uPollGrowCfg
+                            : pUVM->vm.s.Halt.Adaptive.cNsPollStartCfg;
+            cNsNew = RT_MIN(cNsNew, pUVM->vm.s.Halt.Adaptive.cNsPollMaxCfg);
+            if (cNsNew != cNsPollWindow)
+            {
+                pUVCpu->vm.s.Halt.Adaptive.cNsPollWindow = (uint32_t)cNsNew;
+                STAM_REL_COUNTER_INC(&pUVCpu->vm.s.StatHaltPollGrow);
+            }
+        }
+        else if (   cNsPollWindow
+                 && (fPolled || cNsHalted > pUVM->vm.s.Halt.Adaptive.cNsPollMaxCfg))
+        {
+            uint32_t cNsNew = cNsPollWindow / pUVM->vm.s.Halt.Adaptive.uPollShrinkCfg;
+            if (cNsNew < pUVM->vm.s.Halt.Adaptive.cNsPollStartCfg)
+                cNsNew = 0;
+            pUVCpu->vm.s.Halt.Adaptive.cNsPollWindow = cNsNew;
+            STAM_REL_COUNTER_INC(&pUVCpu->vm.s.StatHaltPollShrink);
+        }
+    }
+    return rc;
+}
+
+
+/**
+ * The adaptive halt method - VMR3NotifyFF() worker.
+ *
+ * @param   pUVCpu          Pointer to the user mode VMCPU structure.
+ * @param   fFlags          Notification flags, VMNOTIFYFF_FLAGS_*.
+ */
+static DECLCALLBACK(void) vmR3HaltAdaptiveNotifyCpuFF(PUVMCPU pUVCpu, uint32_t fFlags)
+{
+    if (pUVCpu->vm.s.fWait)
+    {
+        /* Only the first notification counts for the wake-up latency. */
+        ASMAtomicCmpXchgU64(&pUVCpu->vm.s.Halt.Adaptive.u64WakeupTS, RTTimeNanoTS(), 0);
+        if (ASMAtomicReadBool(&pUVCpu->vm.s.Halt.Adaptive.fPolling))
+            return;
+    }
+    vmR3HaltGlobal1NotifyCpuFF(pUVCpu, fFlags);
+}
+
+
 /**
  * Bootstrap VMR3Wait() worker.
  *
@@ -990,6 +1277,7 @@ static const struct VMHALTMETHODDESC
     { VMHALTMETHOD_OLD,       NULL,                NULL,   vmR3HaltOldDoHalt,   vmR3DefaultWait,     vmR3DefaultNotifyCpuFF,     NULL },
     { VMHALTMETHOD_1,         vmR3HaltMethod1Init, NULL,   vmR3HaltMethod1Halt, vmR3DefaultWait,     vmR3DefaultNotifyCpuFF,     NULL },
     { VMHALTMETHOD_GLOBAL_1,  vmR3HaltGlobal1Init, NULL,   vmR3HaltGlobal1Halt, vmR3HaltGlobal1Wait, vmR3HaltGlobal1NotifyCpuFF, NULL },
+    { VMHALTMETHOD_ADAPTIVE,  vmR3HaltAdaptiveInit, NULL,  vmR3HaltAdaptiveHalt, vmR3HaltGlobal1Wait, vmR3HaltAdaptiveNotifyCpuFF, NULL },
 };
 
 
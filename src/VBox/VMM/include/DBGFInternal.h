@@ -26,6 +26,7 @@
 #include <iprt/avl.h>
 #include <iprt/dbg.h>
 #include <VBox/vmm/dbgf.h>
+#include <VBox/vmm/dbgftrace.h>
 
 
 
@@ -248,6 +249,30 @@ typedef struct DBGF
 typedef DBGF *PDBGF;
 
 
+/**
+ * Per virtual CPU exit trace ring buffer.
+ *
+ * Only the EMT owning it adds entries, so no locking is required.  Readers
+ * (the dump code) may see the oldest entries being overwritten unless the VM
+ * is suspended.
+ */
+typedef struct DBGFEXITTRACERING
+{
+    /** The number of entries added so far; the next one goes into
+     *  aEntries[cAdded & fMask]. */
+    uint64_t volatile           cAdded;
+    /** The index mask (number of entries - 1). */
+    uint32_t                    fMask;
+    /** Padding the header to 64 bytes. */
+    uint32_t                    au32Padding[13];
+    /** The entries (variable size). */
+    DBGFEXITTRACEENTRY          aEntries[1];
+} DBGFEXITTRACERING;
+AssertCompileMemberOffset(DBGFEXITTRACERING, aEntries, 64);
+/** Pointer to an exit trace ring buffer. */
+typedef DBGFEXITTRACERING *PDBGFEXITTRACERING;
+
+
 /** Converts a DBGFCPU pointer into a VM pointer. */
 #define DBGFCPU_2_VM(pDbgfCpu) ((PVM)((uint8_t *)(pDbgfCpu) + (pDbgfCpu)->offVM))
 
@@ -270,8 +295,15 @@ typedef struct DBGFCPU
      * This is checked and cleared in the \#DB handler. */
     bool                    fSingleSteppingRaw;
 
-    /** Padding the structure to 16 bytes. */
+    /** Explicit alignment padding for the exit trace pointers. */
     bool                    afReserved[7];
+
+    /** The exit trace ring buffer - R3 pointer, NULL if not enabled. */
+    R3PTRTYPE(PDBGFEXITTRACERING)   pExitTraceR3;
+    /** The exit trace ring buffer - R0 pointer, NULL if not enabled. */
+    R0PTRTYPE(PDBGFEXITTRACERING)   pExitTraceR0;
+    /** The exit trace ring buffer - RC pointer, NULL if not enabled. */
+    RCPTRTYPE(PDBGFEXITTRACERING)   pExitTraceRC;
 } DBGFCPU;
 /** Pointer to DBGFCPU data. */
 typedef DBGFCPU *PDBGFCPU;
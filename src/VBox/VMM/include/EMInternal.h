@@ -316,8 +316,13 @@ typedef struct EM
     bool                    fIemExecutesAll;
     /** Whether a triple fault triggers a guru. */
     bool                    fGuruOnTripleFault;
+    /** Whether EMSTATE_IEM_THEN_REM keeps executing in IEM instead of switching
+     * to the recompiler after a while. */
+    bool                    fIemInsteadOfRem;
     /** Alignment padding. */
-    bool                    afPadding[6];
+    bool                    afPadding[1];
+    /** The max number of instructions IEMExecLots executes per call. */
+    uint32_t                cIemMaxInstructions;
 
     /** Id of the VCPU that last executed code in the recompiler. */
     VMCPUID                 idLastRemCpu;
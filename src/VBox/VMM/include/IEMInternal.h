@@ -184,6 +184,45 @@ typedef IEMVERIFYEVTREC *PIEMVERIFYEVTREC;
 #endif /* IEM_VERIFICATION_MODE_FULL */
 
 
+/** The number of entries in the decoded instruction cache (power of two). */
+#define IEM_DECODE_CACHE_ENTRIES    32
+/** Calculates the decoded instruction cache index for a physical address. */
+#define IEM_DECODE_CACHE_IDX(a_GCPhys) \
+    ( (uint32_t)((a_GCPhys) ^ ((a_GCPhys) >> 5)) & (IEM_DECODE_CACHE_ENTRIES - 1) )
+
+/**
+ * Decoded instruction cache entry.
+ *
+ * Caches the opcode bytes of an instruction that has been successfully decoded
+ * and executed, so that IEMExecLots can skip fetching them from guest memory
+ * when it encounters the same instruction again.  The page is tagged with
+ * PGMPhysIemTagCodePage when filling the entry, and the entry is valid as long
+ * as the page stays tagged and its write generation hasn't changed
+ * (PGMPhysGetWriteGeneration).
+ */
+typedef struct IEMDECODECACHEENTRY
+{
+    /** The guest physical address of the first opcode byte.
+     * NIL_RTGCPHYS if the entry is free. */
+    RTGCPHYS                GCPhys;
+    /** The PGM write generation of the page when the bytes were read. */
+    uint32_t                uWriteGen;
+    /** The CPU mode (IEMMODE) the instruction was decoded in. */
+    uint8_t                 enmCpuMode;
+    /** The instruction length. */
+    uint8_t                 cbInstr;
+    /** The opcode bytes. */
+    uint8_t                 abOpcode[15];
+    /** Explicit alignment padding. */
+    uint8_t                 abAlignment[3];
+} IEMDECODECACHEENTRY;
+AssertCompileSize(IEMDECODECACHEENTRY, 32);
+/** Pointer to a decoded instruction cache entry. */
+typedef IEMDECODECACHEENTRY *PIEMDECODECACHEENTRY;
+/** Pointer to a const decoded instruction cache entry. */
+typedef IEMDECODECACHEENTRY const *PCIEMDECODECACHEENTRY;
+
+
 /**
  * The per-CPU IEM state.
  */
@@ -246,6 +285,14 @@ typedef struct IEMCPU
     uint32_t                cRetErrStatuses;
     /** Number of times rcPassUp has been used. */
     uint32_t                cRetPassUpStatus;
+    /** Number of decoded instruction cache hits. */
+    uint32_t                cDecodeCacheHits;
+    /** Number of decoded instruction cache misses. */
+    uint32_t                cDecodeCacheMisses;
+    /** Number of decoded instruction cache flushes. */
+    uint32_t                cDecodeCacheFlushes;
+    /** Explicit alignment padding. */
+    uint32_t                u32Alignment6;
 #ifdef IEM_VERIFICATION_MODE_FULL
     /** The Number of I/O port reads that has been performed. */
     uint32_t                cIOReads;
@@ -312,11 +359,21 @@ typedef struct IEMCPU
      * Only set by the FPU escape opcodes (0xd8-0xdf) and used later on when the
      * instruction result is committed. */
     uint8_t                 offFpuOpcode;
+    /** The CPU mode (IEMMODE) at GCPhysDecodeFill. */
+    uint8_t                 enmDecodeFillCpuMode;
+    /** Explicit alignment padding. */
+    uint8_t                 abAlignment7[1];
+
+    /** The write generation of the page at GCPhysDecodeFill. */
+    uint32_t                uDecodeFillWriteGen;
+    /** The physical address of the instruction to add to the decoded instruction
+     * cache when it has been executed successfully, NIL_RTGCPHYS if none. */
+    RTGCPHYS                GCPhysDecodeFill;
 
     /** @}*/
 
     /** Alignment padding for aMemMappings. */
-    uint8_t                 abAlignment2[4];
+    uint8_t                 abAlignment2[6];
 
     /** The number of active guest memory mappings. */
     uint8_t                 cActiveMappings;
@@ -370,6 +427,9 @@ typedef struct IEMCPU
         uint8_t             ab[512];
     } aBounceBuffers[3];
 
+    /** The decoded instruction cache (IEMExecLots only). */
+    IEMDECODECACHEENTRY     aDecodeCache[IEM_DECODE_CACHE_ENTRIES];
+
     /** @name Target CPU information.
      * @{ */
     /** EDX value of CPUID(1).
@@ -18,6 +18,10 @@
 #ifndef ___IOMInline_h
 #define ___IOMInline_h
 
+#include <VBox/dis.h>
+#include <VBox/disopcode.h>
+#include <iprt/string.h>
+
 /** @addtogroup grp_iom_int   Internals
  * @internal
  * @{
@@ -39,6 +43,49 @@ DECLINLINE(CTX_SUFF(PIOMIOPORTRANGE)) iomIOPortGetRange(PVM pVM, RTIOPORT Port)
 }
 
 
+/**
+ * Gets the I/O port range for the specified I/O port in the current context,
+ * consulting the last hit and range lookup caches of the calling EMT first.
+ *
+ * @returns Pointer to I/O port range.
+ * @returns NULL if no port registered.
+ *
+ * @param   pVM     Pointer to the VM.
+ * @param   pVCpu   Pointer to the virtual CPU structure of the caller.
+ * @param   Port    The I/O port lookup.
+ * @param   ppLast  The last hit pointer to check and update
+ *                  (IOMCPU::pRangeLastRead or IOMCPU::pRangeLastWrite).
+ */
+DECLINLINE(CTX_SUFF(PIOMIOPORTRANGE)) iomIOPortGetRangeCached(PVM pVM, PVMCPU pVCpu, RTIOPORT Port,
+                                                              CTX_SUFF(PIOMIOPORTRANGE) *ppLast)
+{
+    Assert(IOM_IS_SHARED_LOCK_OWNER(pVM));
+    CTX_SUFF(PIOMIOPORTRANGE) pRange = *ppLast;
+    if (RT_LIKELY(   pRange
+                  && (unsigned)Port - (unsigned)pRange->Port < (unsigned)pRange->cPorts))
+    {
+        STAM_COUNTER_INC(&pVM->iom.s.StatIOPortLookupLastHit);
+        return pRange;
+    }
+
+    unsigned const idx = IOM_IOPORT_CACHE_IDX(Port);
+    pRange = pVCpu->iom.s.CTX_SUFF(apIOPortRangeCache)[idx];
+    if (   pRange
+        && (unsigned)Port - (unsigned)pRange->Port < (unsigned)pRange->cPorts)
+        STAM_COUNTER_INC(&pVM->iom.s.StatIOPortLookupCacheHit);
+    else
+    {
+        STAM_COUNTER_INC(&pVM->iom.s.StatIOPortLookupTree);
+        pRange = iomIOPortGetRange(pVM, Port);
+        if (!pRange)
+            return NULL;
+        pVCpu->iom.s.CTX_SUFF(apIOPortRangeCache)[idx] = pRange;
+    }
+    *ppLast = pRange;
+    return pRange;
+}
+
+
 /**
  * Gets the I/O port range for the specified I/O port in the HC.
  *
@@ -69,10 +116,27 @@ DECLINLINE(PIOMMMIORANGE) iomMmioGetRange(PVM pVM, PVMCPU pVCpu, RTGCPHYS GCPhys
 {
     Assert(IOM_IS_SHARED_LOCK_OWNER(pVM));
     PIOMMMIORANGE pRange = pVCpu->iom.s.CTX_SUFF(pMMIORangeLast);
-    if (    !pRange
-        ||  GCPhys - pRange->GCPhys >= pRange->cb)
-        pVCpu->iom.s.CTX_SUFF(pMMIORangeLast) = pRange
-            = (PIOMMMIORANGE)RTAvlroGCPhysRangeGet(&pVM->iom.s.CTX_SUFF(pTrees)->MMIOTree, GCPhys);
+    if (RT_LIKELY(   pRange
+                  && GCPhys - pRange->GCPhys < pRange->cb))
+    {
+        STAM_COUNTER_INC(&pVM->iom.s.StatMMIOLookupLastHit);
+        return pRange;
+    }
+
+    unsigned const idx = IOM_MMIO_CACHE_IDX(GCPhys);
+    pRange = pVCpu->iom.s.CTX_SUFF(apMMIORangeCache)[idx];
+    if (   pRange
+        && GCPhys - pRange->GCPhys < pRange->cb)
+        STAM_COUNTER_INC(&pVM->iom.s.StatMMIOLookupCacheHit);
+    else
+    {
+        STAM_COUNTER_INC(&pVM->iom.s.StatMMIOLookupTree);
+        pRange = (PIOMMMIORANGE)RTAvlroGCPhysRangeGet(&pVM->iom.s.CTX_SUFF(pTrees)->MMIOTree, GCPhys);
+        if (!pRange)
+            return NULL;
+        pVCpu->iom.s.CTX_SUFF(apMMIORangeCache)[idx] = pRange;
+    }
+    pVCpu->iom.s.CTX_SUFF(pMMIORangeLast) = pRange;
     return pRange;
 }
 
@@ -106,11 +170,7 @@ DECLINLINE(PIOMMMIORANGE) iomMmioGetRangeWithRef(PVM pVM, PVMCPU pVCpu, RTGCPHYS
     int rc = IOM_LOCK_SHARED_EX(pVM, VINF_SUCCESS);
     AssertRCReturn(rc, NULL);
 
-    PIOMMMIORANGE pRange = pVCpu->iom.s.CTX_SUFF(pMMIORangeLast);
-    if (   !pRange
-        || GCPhys - pRange->GCPhys >= pRange->cb)
-        pVCpu->iom.s.CTX_SUFF(pMMIORangeLast) = pRange
-            = (PIOMMMIORANGE)RTAvlroGCPhysRangeGet(&pVM->iom.s.CTX_SUFF(pTrees)->MMIOTree, GCPhys);
+    PIOMMMIORANGE pRange = iomMmioGetRange(pVM, pVCpu, GCPhys);
     if (pRange)
         iomMmioRetainRange(pRange);
 
@@ -133,6 +193,196 @@ DECLINLINE(void) iomMmioReleaseRange(PVM pVM, PIOMMMIORANGE pRange)
 }
 
 
+/**
+ * Initializes an MMIO decode cache entry from a disassembled instruction.
+ *
+ * Only MOV, MOVZX and MOVSX between memory and a general register, and MOV of
+ * an immediate to memory, are cached; everything else is rare enough to be
+ * left to the disassembler.
+ *
+ * @returns true if the instruction can be cached, false if not.
+ * @param   pEntry      The entry to initialize.
+ * @param   pDis        The disassembler state of the instruction.
+ * @param   GCPtrInstr  The flat address of the instruction.
+ * @param   fWrite      Whether the instruction writes to MMIO (true) or reads
+ *                      from it (false).
+ */
+DECLINLINE(bool) iomMmioDecEntryInit(PIOMMMIODECENTRY pEntry, PCDISCPUSTATE pDis, RTGCPTR GCPtrInstr, bool fWrite)
+{
+    uint16_t const uOpcode = pDis->pCurInstr->uOpcode;
+    if (   (uOpcode != OP_MOV && uOpcode != OP_MOVZX && uOpcode != OP_MOVSX)
+        || pDis->cbInstr > sizeof(pEntry->abInstr))
+        return false;
+
+    /* The register or immediate operand, which must not involve memory. */
+    PCDISOPPARAM pParam = fWrite ? &pDis->Param2 : &pDis->Param1;
+    if (   DISUSE_IS_EFFECTIVE_ADDR(pParam->fUse)
+        || (pParam->fUse & (DISUSE_SCALE | DISUSE_IMMEDIATE_ADDR_0_32 | DISUSE_IMMEDIATE_ADDR_16_32
+                            | DISUSE_IMMEDIATE_ADDR_0_16 | DISUSE_IMMEDIATE_ADDR_16_16)))
+        return false;
+
+    /* Same order of evaluation as iomGetRegImmData and iomSaveDataToReg. */
+    unsigned cbReg;
+    if (pParam->fUse & DISUSE_REG_GEN32)
+        cbReg = 4;
+    else if (pParam->fUse & DISUSE_REG_GEN64)
+        cbReg = 8;
+    else if (pParam->fUse & DISUSE_REG_GEN16)
+        cbReg = 2;
+    else if (pParam->fUse & DISUSE_REG_GEN8)
+        cbReg = 1;
+    else
+        cbReg = 0;
+
+    pEntry->u64Imm = 0;
+    if (fWrite)
+    {
+        if (cbReg)
+        {
+            pEntry->enmKind  = IOMMMIODECKIND_WRITE_REG;
+            pEntry->cbAccess = cbReg;
+        }
+        else
+        {
+            pEntry->enmKind  = IOMMMIODECKIND_WRITE_IMM;
+            if (pParam->fUse & (DISUSE_IMMEDIATE64 | DISUSE_IMMEDIATE64_SX8))
+            {
+                pEntry->cbAccess = 8;
+                pEntry->u64Imm   = pParam->uValue;
+            }
+            else if (pParam->fUse & (DISUSE_IMMEDIATE32 | DISUSE_IMMEDIATE32_SX8))
+            {
+                pEntry->cbAccess = 4;
+                pEntry->u64Imm   = (uint32_t)pParam->uValue;
+            }
+            else if (pParam->fUse & (DISUSE_IMMEDIATE16 | DISUSE_IMMEDIATE16_SX8))
+            {
+                pEntry->cbAccess = 2;
+                pEntry->u64Imm   = (uint16_t)pParam->uValue;
+            }
+            else if (pParam->fUse & DISUSE_IMMEDIATE8)
+            {
+                pEntry->cbAccess = 1;
+                pEntry->u64Imm   = (uint8_t)pParam->uValue;
+            }
+            else
+                return false; /* segment register */
+        }
+    }
+    else
+    {
+        if (!cbReg)
+            return false;
+        int cbAccess = DISGetParamSize(pDis, &pDis->Param2);
+        if (cbAccess <= 0 || cbAccess > 8)
+            return false;
+        pEntry->enmKind  = uOpcode == OP_MOVSX ? IOMMMIODECKIND_READ_SX : IOMMMIODECKIND_READ;
+        pEntry->cbAccess = (uint8_t)cbAccess;
+    }
+
+    pEntry->GCPtrInstr = GCPtrInstr;
+    pEntry->cbInstr    = pDis->cbInstr;
+    pEntry->enmCpuMode = pDis->uCpuMode;
+    pEntry->iReg       = cbReg ? pParam->Base.idxGenReg : 0;
+    pEntry->cbReg      = (uint8_t)cbReg;
+    memcpy(pEntry->abInstr, pDis->abInstr, pDis->cbInstr);
+    return true;
+}
+
+
+/**
+ * Looks up an instruction in the MMIO decode cache.
+ *
+ * The caller must check that the guest instruction bytes still match
+ * IOMMMIODECENTRY::abInstr before using the entry.
+ *
+ * @returns Pointer to the entry on hit, NULL on miss.
+ * @param   pCache      The MMIO decode cache.
+ * @param   GCPtrInstr  The flat address of the instruction.
+ * @param   enmCpuMode  The current disassembler CPU mode.
+ */
+DECLINLINE(PIOMMMIODECENTRY) iomMmioDecCacheLookup(PIOMMMIODECCACHE pCache, RTGCPTR GCPtrInstr, DISCPUMODE enmCpuMode)
+{
+    PIOMMMIODECENTRY pEntry = &pCache->aEntries[IOM_MMIO_DEC_CACHE_IDX(GCPtrInstr)];
+    if (   pEntry->GCPtrInstr == GCPtrInstr
+        && pEntry->cbInstr
+        && pEntry->enmCpuMode == (uint8_t)enmCpuMode)
+        return pEntry;
+    return NULL;
+}
+
+
+/**
+ * Adds a disassembled instruction to the MMIO decode cache, evicting whatever
+ * occupies its slot.
+ *
+ * @returns true if added, false if the instruction cannot be cached.
+ * @param   pCache      The MMIO decode cache.
+ * @param   pDis        The disassembler state of the instruction.
+ * @param   GCPtrInstr  The flat address of the instruction.
+ * @param   fWrite      Whether the instruction writes to MMIO.
+ */
+DECLINLINE(bool) iomMmioDecCacheInsert(PIOMMMIODECCACHE pCache, PCDISCPUSTATE pDis, RTGCPTR GCPtrInstr, bool fWrite)
+{
+    IOMMMIODECENTRY Entry;
+    if (!iomMmioDecEntryInit(&Entry, pDis, GCPtrInstr, fWrite))
+        return false;
+    pCache->aEntries[IOM_MMIO_DEC_CACHE_IDX(GCPtrInstr)] = Entry;
+    return true;
+}
+
+
+/**
+ * Gets the value an IOMMMIODECKIND_WRITE_XXX entry writes to MMIO.
+ *
+ * @returns The value (IOMMMIODECENTRY::cbAccess bytes of it are significant).
+ * @param   pEntry      The decode cache entry.
+ * @param   pCtxCore    The guest register frame.
+ */
+DECLINLINE(uint64_t) iomMmioDecEntryGetWriteValue(PCIOMMMIODECENTRY pEntry, PCCPUMCTXCORE pCtxCore)
+{
+    Assert(pEntry->enmKind == IOMMMIODECKIND_WRITE_REG || pEntry->enmKind == IOMMMIODECKIND_WRITE_IMM);
+    if (pEntry->enmKind == IOMMMIODECKIND_WRITE_IMM)
+        return pEntry->u64Imm;
+    switch (pEntry->cbReg)
+    {
+        case 1: { uint8_t  u8;  DISFetchReg8(pCtxCore, pEntry->iReg, &u8);   return u8; }
+        case 2: { uint16_t u16; DISFetchReg16(pCtxCore, pEntry->iReg, &u16); return u16; }
+        case 4: { uint32_t u32; DISFetchReg32(pCtxCore, pEntry->iReg, &u32); return u32; }
+        default:
+        {
+            Assert(pEntry->cbReg == 8);
+            uint64_t u64;
+            DISFetchReg64(pCtxCore, pEntry->iReg, &u64);
+            return u64;
+        }
+    }
+}
+
+
+/**
+ * Stores the value read from MMIO by an IOMMMIODECKIND_READ_XXX entry in its
+ * destination register.
+ *
+ * @param   pEntry      The decode cache entry.
+ * @param   pCtxCore    The guest register frame.
+ * @param   u64Data     The value read (zero extended).
+ */
+DECLINLINE(void) iomMmioDecEntryStoreReadValue(PCIOMMMIODECENTRY pEntry, PCPUMCTXCORE pCtxCore, uint64_t u64Data)
+{
+    Assert(pEntry->enmKind == IOMMMIODECKIND_READ || pEntry->enmKind == IOMMMIODECKIND_READ_SX);
+    if (pEntry->enmKind == IOMMMIODECKIND_READ_SX)
+        u64Data = pEntry->cbAccess == 1 ? (uint64_t)(int64_t)(int8_t)u64Data : (uint64_t)(int64_t)(int16_t)u64Data;
+    switch (pEntry->cbReg)
+    {
+        case 1:  DISWriteReg8(pCtxCore, pEntry->iReg, (uint8_t)u64Data); break;
+        case 2:  DISWriteReg16(pCtxCore, pEntry->iReg, (uint16_t)u64Data); break;
+        case 4:  DISWriteReg32(pCtxCore, pEntry->iReg, (uint32_t)u64Data); break;
+        default: Assert(pEntry->cbReg == 8); DISWriteReg64(pCtxCore, pEntry->iReg, u64Data); break;
+    }
+}
+
+
 #ifdef VBOX_STRICT
 /**
  * Gets the MMIO range for the specified physical address in the current context.
@@ -375,11 +375,108 @@ typedef struct IOM
     RTUINT                          cMovsMaxBytes;
     RTUINT                          cStosMaxBytes;
     /** @} */
+
+    /** @name Range lookup statistics (see IOMCPU::apMMIORangeCacheR3).
+     * @{ */
+    STAMCOUNTER                     StatMMIOLookupLastHit;
+    STAMCOUNTER                     StatMMIOLookupCacheHit;
+    STAMCOUNTER                     StatMMIOLookupTree;
+    STAMCOUNTER                     StatIOPortLookupLastHit;
+    STAMCOUNTER                     StatIOPortLookupCacheHit;
+    STAMCOUNTER                     StatIOPortLookupTree;
+    /** @} */
+
+    /** @name MMIO decode cache statistics (see IOMMMIODECCACHE).
+     * @{ */
+    STAMCOUNTER                     StatMMIODecCacheHit;
+    STAMCOUNTER                     StatMMIODecCacheMiss;
+    STAMCOUNTER                     StatMMIODecCacheStale;
+    STAMCOUNTER                     StatMMIODecCacheInsert;
+    /** @} */
 } IOM;
 /** Pointer to IOM instance data. */
 typedef IOM *PIOM;
 
 
+/**
+ * The kind of access described by an MMIO decode cache entry.
+ */
+typedef enum IOMMMIODECKIND
+{
+    /** Free entry. */
+    IOMMMIODECKIND_FREE = 0,
+    /** MOV/MOVZX reg, mem. */
+    IOMMMIODECKIND_READ,
+    /** MOVSX reg, mem. */
+    IOMMMIODECKIND_READ_SX,
+    /** MOV mem, reg. */
+    IOMMMIODECKIND_WRITE_REG,
+    /** MOV mem, imm. */
+    IOMMMIODECKIND_WRITE_IMM
+} IOMMMIODECKIND;
+
+/**
+ * MMIO decode cache entry.
+ *
+ * Describes the MMIO access done by a MOV instruction at a given flat guest
+ * address well enough to carry it out without disassembling the instruction
+ * again.  The instruction bytes are kept so that a hit can be validated
+ * against the current guest code.
+ */
+typedef struct IOMMMIODECENTRY
+{
+    /** The flat address of the instruction (CS base + RIP). */
+    RTGCPTR                         GCPtrInstr;
+    /** The value written by IOMMMIODECKIND_WRITE_IMM. */
+    uint64_t                        u64Imm;
+    /** The instruction bytes. */
+    uint8_t                         abInstr[16];
+    /** The instruction length, 0 if the entry is free. */
+    uint8_t                         cbInstr;
+    /** The disassembler CPU mode (DISCPUMODE) the entry was decoded in. */
+    uint8_t                         enmCpuMode;
+    /** The access kind (IOMMMIODECKIND). */
+    uint8_t                         enmKind;
+    /** The size of the MMIO access. */
+    uint8_t                         cbAccess;
+    /** The general register operand (DISGREG_XXX), IOMMMIODECKIND_WRITE_IMM excepted. */
+    uint8_t                         iReg;
+    /** The size of the general register operand. */
+    uint8_t                         cbReg;
+    uint8_t                         abPadding[2];
+} IOMMMIODECENTRY;
+AssertCompileSize(IOMMMIODECENTRY, 40);
+/** Pointer to an MMIO decode cache entry. */
+typedef IOMMMIODECENTRY *PIOMMMIODECENTRY;
+/** Pointer to a const MMIO decode cache entry. */
+typedef IOMMMIODECENTRY const *PCIOMMMIODECENTRY;
+
+/** The number of entries in the per-VCPU MMIO decode cache. */
+#define IOM_MMIO_DEC_CACHE_SIZE         16
+/** Calculates the IOMMMIODECCACHE::aEntries index for an instruction address. */
+#define IOM_MMIO_DEC_CACHE_IDX(a_GCPtr) ( (unsigned)((a_GCPtr) ^ ((a_GCPtr) >> 6)) & (IOM_MMIO_DEC_CACHE_SIZE - 1) )
+
+/**
+ * Per-VCPU MMIO decode cache.
+ *
+ * Direct mapped on the flat instruction address.  Lives in the hyper heap so
+ * ring-0 can get at it; only allocated when HM is used.
+ */
+typedef struct IOMMMIODECCACHE
+{
+    IOMMMIODECENTRY                 aEntries[IOM_MMIO_DEC_CACHE_SIZE];
+} IOMMMIODECCACHE;
+/** Pointer to an MMIO decode cache. */
+typedef IOMMMIODECCACHE *PIOMMMIODECCACHE;
+
+
+/** The number of entries in each of the IOMCPU range lookup caches. */
+#define IOM_RANGE_CACHE_SIZE            4
+/** Calculates the IOMCPU::apMMIORangeCacheR3 index for an address. */
+#define IOM_MMIO_CACHE_IDX(a_GCPhys)    ( (unsigned)((a_GCPhys) >> PAGE_SHIFT) & (IOM_RANGE_CACHE_SIZE - 1) )
+/** Calculates the IOMCPU::apIOPortRangeCacheR3 index for a port. */
+#define IOM_IOPORT_CACHE_IDX(a_Port)    ( ((unsigned)(a_Port) >> 3) & (IOM_RANGE_CACHE_SIZE - 1) )
+
 /**
  * IOM per virtual CPU instance data.
  */
@@ -413,6 +510,26 @@ typedef struct IOMCPU
     RCPTRTYPE(PIOMMMIORANGE)        pMMIORangeLastRC;
     RCPTRTYPE(PIOMMMIOSTATS)        pMMIOStatsLastRC;
     /** @} */
+
+    /** @name Small direct mapped range lookup caches.
+     * Consulted when the last hit pointers above miss and before walking the
+     * AVL trees, so that a few devices hammered in turn (disk doorbells, NIC
+     * tail registers, VGA) don't each evict the others.  Indexed by
+     * IOM_MMIO_CACHE_IDX and IOM_IOPORT_CACHE_IDX, flushed along with the last
+     * hit pointers.
+     * @{ */
+    R3PTRTYPE(PIOMMMIORANGE)        apMMIORangeCacheR3[IOM_RANGE_CACHE_SIZE];
+    R3PTRTYPE(PIOMIOPORTRANGER3)    apIOPortRangeCacheR3[IOM_RANGE_CACHE_SIZE];
+    R0PTRTYPE(PIOMMMIORANGE)        apMMIORangeCacheR0[IOM_RANGE_CACHE_SIZE];
+    R0PTRTYPE(PIOMIOPORTRANGER0)    apIOPortRangeCacheR0[IOM_RANGE_CACHE_SIZE];
+    RCPTRTYPE(PIOMMMIORANGE)        apMMIORangeCacheRC[IOM_RANGE_CACHE_SIZE];
+    RCPTRTYPE(PIOMIOPORTRANGERC)    apIOPortRangeCacheRC[IOM_RANGE_CACHE_SIZE];
+    /** @} */
+
+    /** The MMIO decode cache - R3 Ptr. NULL if disabled. */
+    R3PTRTYPE(PIOMMMIODECCACHE)     pMmioDecCacheR3;
+    /** The MMIO decode cache - R0 Ptr. NIL_RTR0PTR if disabled. */
+    R0PTRTYPE(PIOMMMIODECCACHE)     pMmioDecCacheR0;
 } IOMCPU;
 /** Pointer to IOM per virtual CPU instance data. */
 typedef IOMCPU *PIOMCPU;
@@ -271,6 +271,9 @@ typedef struct PDMASYNCCOMPLETIONEPCLASSFILE
     RTR3UINTPTR                         uBitmaskAlignment;
     /** Flag whether the out of resources warning was printed already. */
     bool                                fOutOfResourcesWarningPrinted;
+    /** Flag whether the host does async I/O on buffered files opened without
+     * RTFILE_O_ASYNC_IO (RTFILEAIOLIMITS_F_BUFFERED). */
+    bool                                fBufferedAsyncIo;
 #ifdef PDM_ASYNC_COMPLETION_FILE_WITH_DELAY
     /** Timer for delayed request completion. */
     PTMTIMERR3                          pTimer;
@@ -267,6 +267,73 @@ typedef struct PDMDRVINSINT
 } PDMDRVINSINT;
 
 
+/** Number of buckets in the critical section wait and hold time histograms.
+ * Bucket 0 is below 1K TSC ticks, each following bucket is 4 times wider and
+ * the last one catches everything above. */
+#define PDMCRITSECT_PROF_HIST_BUCKETS   8
+/** Number of distinct owner call sites tracked per critical section. */
+#define PDMCRITSECT_PROF_CALLERS        8
+/** Max number of critical sections which can be profiled. */
+#define PDMCRITSECT_PROF_MAX            128
+
+/**
+ * Contention attributed to an owner call site.
+ */
+typedef struct PDMCRITSECTPROFCALLER
+{
+    /** The return address of the owner's enter call (context specific).
+     * 0 if the entry is free. */
+    uint64_t volatile               uCaller;
+    /** Number of times someone had to spin or wait while this call site owned
+     * the section. */
+    uint32_t volatile               cContentions;
+    /** Alignment padding. */
+    uint32_t                        u32Padding;
+} PDMCRITSECTPROFCALLER;
+
+/**
+ * Critical section contention profile.
+ *
+ * These live in a hyper heap table (PDM::paCritSectProfsR3) so the
+ * PDMCRITSECT size stays unchanged; PDMCRITSECTINT::iProf selects the entry.
+ */
+typedef struct PDMCRITSECTPROF
+{
+    /** TSC when the current owner got the section. */
+    uint64_t volatile               u64EnterTsc;
+    /** The return address of the current owner's enter call. */
+    uint64_t volatile               uOwnerCaller;
+    /** Running average of the hold time in TSC ticks (1/8 weight). */
+    uint64_t                        cTicksHoldAvg;
+    /** The spin count derived from cTicksHoldAvg. */
+    int32_t volatile                cSpins;
+    /** Whether to use cSpins instead of the fixed per context spin count. */
+    bool                            fAdaptiveSpin;
+    /** Alignment padding. */
+    bool                            afPadding[3];
+    /** Contended acquisitions by time spent spinning and waiting. */
+    STAMCOUNTER                     aStatWait[PDMCRITSECT_PROF_HIST_BUCKETS];
+    /** Hold time histogram. */
+    STAMCOUNTER                     aStatHold[PDMCRITSECT_PROF_HIST_BUCKETS];
+    /** Total time spent spinning and waiting for the section. */
+    STAMPROFILE                     StatWait;
+    /** Number of times spinning got us the section. */
+    STAMCOUNTER                     StatSpinHits;
+    /** Number of times we spun in vain. */
+    STAMCOUNTER                     StatSpinMisses;
+    /** Contended owner call sites. */
+    PDMCRITSECTPROFCALLER           aCallers[PDMCRITSECT_PROF_CALLERS];
+    /** Contentions that didn't fit into aCallers. */
+    uint32_t volatile               cCallerOverflows;
+    /** Alignment padding. */
+    uint32_t                        u32Padding;
+} PDMCRITSECTPROF;
+AssertCompileMemberAlignment(PDMCRITSECTPROF, aStatWait, 8);
+AssertCompileSizeAlignment(PDMCRITSECTPROF, 8);
+/** Pointer to a critical section profile. */
+typedef PDMCRITSECTPROF *PPDMCRITSECTPROF;
+
+
 /**
  * Private critical section data.
  */
@@ -294,8 +361,9 @@ typedef struct PDMCRITSECTINT
     /** Set if the critical section is used by a timer or similar.
      * See PDMR3DevGetCritSect.  */
     bool                            fUsedByTimerOrSimilar;
-    /** Alignment padding. */
-    bool                            afPadding[2];
+    /** Index + 1 of the contention profile (PDM::paCritSectProfsR3), 0 if not
+     * profiled. */
+    uint16_t                        iProf;
     /** Event semaphore that is scheduled to be signaled upon leaving the
      * critical section. This is Ring-3 only of course. */
     RTSEMEVENT                      EventToSignal;
@@ -780,6 +848,37 @@ typedef PDMMOD *PPDMMOD;
 
 /** Extra space in the free array. */
 #define PDMQUEUE_FREE_SLACK         16
+/** Number of per-VCPU staging lists in a queue (VCPUs share them modulo this). */
+#define PDMQUEUE_STAGES             4
+
+/**
+ * Per-VCPU staging list of a PDM queue.
+ *
+ * EMTs push items onto the staging list of their VCPU instead of the shared
+ * pending list, so busy devices don't bounce the queue's cache line between
+ * CPUs.  The lists are drained together with the shared ones when the queue
+ * is flushed.
+ */
+typedef struct PDMQUEUESTAGE
+{
+    /** LIFO of pending items - R3. */
+    R3PTRTYPE(PPDMQUEUEITEMCORE) volatile pPendingR3;
+#if HC_ARCH_BITS == 32
+    RTR3PTR                         Alignment0;
+#endif
+    /** LIFO of pending items - R0. */
+    R0PTRTYPE(PPDMQUEUEITEMCORE) volatile pPendingR0;
+#if HC_ARCH_BITS == 32
+    RTR0PTR                         Alignment1;
+#endif
+    /** Stat: PDMQueueInsert calls using this staging list. */
+    STAMCOUNTER                     StatInsert;
+    /** Pad the structure to a cache line. */
+    uint8_t                         abPadding[64 - 24];
+} PDMQUEUESTAGE;
+AssertCompileSize(PDMQUEUESTAGE, 64);
+/** Pointer to a PDM queue staging list. */
+typedef PDMQUEUESTAGE *PPDMQUEUESTAGE;
 
 /**
  * Queue type.
@@ -877,14 +976,36 @@ typedef struct PDMQUEUE
 #if HC_ARCH_BITS == 32
     RTR3PTR                         Alignment1;
 #endif
+    /** Event semaphore of the dedicated consumer thread, NIL_SUPSEMEVENT if
+     * the queue is flushed by EMT. */
+    SUPSEMEVENT                     hEvtConsumer;
+    /** The dedicated consumer thread, NIL_RTTHREAD if none. */
+    R3PTRTYPE(RTTHREAD)             hConsumerThread;
+#if HC_ARCH_BITS == 32
+    RTR3PTR                         Alignment2;
+#endif
+    /** Tells the consumer thread to terminate. */
+    bool volatile                   fConsumerTerminate;
+    /** Set while the consumer thread may be calling the consumer callback, see
+     * pdmR3QueueParkConsumers. */
+    bool volatile                   fConsumerBusy;
+    bool                            afAlignment3[6];
+    /** TSC of the first insert since the last flush, 0 if none. */
+    uint64_t volatile               u64FirstPendingTsc;
     /** Stat: Times PDMQueueAlloc fails. */
     STAMCOUNTER                     StatAllocFailures;
-    /** Stat: PDMQueueInsert calls. */
+    /** Stat: PDMQueueInsert calls not using a staging list. */
     STAMCOUNTER                     StatInsert;
     /** Stat: Queue flushes. */
     STAMCOUNTER                     StatFlush;
     /** Stat: Queue flushes with pending items left over. */
     STAMCOUNTER                     StatFlushLeftovers;
+    /** Stat: Items handed to the consumer. */
+    STAMCOUNTER                     StatFlushItems;
+    /** Stat: Time from the first insert to the flush picking it up (TSC). */
+    STAMPROFILE                     StatLatency;
+    /** Stat: Consumer thread wake-ups. */
+    STAMCOUNTER                     StatConsumerWakeups;
 #ifdef VBOX_WITH_STATISTICS
     /** State: Profiling the flushing. */
     STAMPROFILE                     StatFlushPrf;
@@ -893,6 +1014,9 @@ typedef struct PDMQUEUE
     uint32_t volatile               cAlignment;
 #endif
 
+    /** Per-VCPU staging lists. */
+    PDMQUEUESTAGE                   aStages[PDMQUEUE_STAGES];
+
     /** Array of pointers to free items. Variable size. */
     struct PDMQUEUEFREEITEM
     {
@@ -920,6 +1044,14 @@ typedef struct PDMQUEUE
 #define PDM_QUEUE_FLUSH_FLAG_PENDING_BIT    1
 /** }@  */
 
+/** @name PDMUSERPERVM::fQueueConsumerPark
+ * @{ */
+/** The VM isn't running (not yet powered on, suspended or powered off). */
+#define PDM_QUEUE_PARK_F_STATE              RT_BIT_32(0)
+/** The VM state is being saved. */
+#define PDM_QUEUE_PARK_F_SAVE               RT_BIT_32(1)
+/** }@  */
+
 
 /**
  * Queue device helper task operation.
@@ -1131,6 +1263,22 @@ typedef struct PDM
     RTGCPHYS                        GCPhysVMMDevHeap;
     /** @} */
 
+    /** @name   Critical section contention profiling
+     * @{ */
+    /** The profile table - R3 Ptr. NULL if profiling is disabled. */
+    R3PTRTYPE(PPDMCRITSECTPROF)     paCritSectProfsR3;
+    /** The profile table - R0 Ptr. */
+    R0PTRTYPE(PPDMCRITSECTPROF)     paCritSectProfsR0;
+    /** The profile table - RC Ptr. */
+    RCPTRTYPE(PPDMCRITSECTPROF)     paCritSectProfsRC;
+    /** Number of table entries handed out. */
+    uint32_t                        cCritSectProfs;
+    /** Whether new profiles should use adaptive spinning. */
+    bool                            fCritSectAdaptiveSpin;
+    /** Alignment padding. */
+    bool                            afCritSectPadding[7];
+    /** @} */
+
     /** Number of times a critical section leave request needed to be queued for ring-3 execution. */
     STAMCOUNTER                     StatQueuedCritSectLeaves;
 } PDM;
@@ -1155,6 +1303,9 @@ typedef struct PDMUSERPERVM
     /** Linked list of force action driven PDM queues.
      * Currently serialized by PDM::CritSect. */
     R3PTRTYPE(struct PDMQUEUE *)    pQueuesForced;
+    /** Reasons for keeping the queue consumer threads from calling the consumer
+     * callbacks, PDM_QUEUE_PARK_F_XXX.  Items stay pending while this is set. */
+    uint32_t volatile               fQueueConsumerPark;
 
     /** Lock protecting the lists below it. */
     RTCRITSECT                      ListCritSect;
@@ -1288,6 +1439,10 @@ char       *pdmR3FileR3(const char *pszFile, bool fShared);
 int         pdmR3LoadR3U(PUVM pUVM, const char *pszFilename, const char *pszName);
 
 void        pdmR3QueueRelocate(PVM pVM, RTGCINTPTR offDelta);
+void        pdmR3QueueParkConsumers(PVM pVM, uint32_t fPark);
+void        pdmR3QueueUnparkConsumers(PVM pVM, uint32_t fPark);
+void        pdmR3QueueStopDevice(PVM pVM, PPDMDEVINS pDevIns);
+void        pdmR3QueueStopDriver(PVM pVM, PPDMDRVINS pDrvIns);
 
 int         pdmR3ThreadCreateDevice(PVM pVM, PPDMDEVINS pDevIns, PPPDMTHREAD ppThread, void *pvUser, PFNPDMTHREADDEV pfnThread,
                                     PFNPDMTHREADWAKEUPDEV pfnWakeup, size_t cbStack, RTTHREADTYPE enmType, const char *pszName);
@@ -17,6 +17,13 @@
 
 /**
  * Bandwidth group instance data
+ *
+ * The token bucket is implemented as a virtual scheduling clock (GCRA): the
+ * group keeps the nanosecond timestamp at which the bucket would be full
+ * again (tsTat), a transfer advances it by its cost and is allowed as long as
+ * the clock doesn't get further ahead of the current time than the burst
+ * allowance.  This reduces the bucket state to a single 64-bit value which is
+ * updated with compare-and-exchange, so allocations never take a lock.
  */
 typedef struct PDMNSBWGROUP
 {
@@ -24,23 +31,56 @@ typedef struct PDMNSBWGROUP
     R3PTRTYPE(struct PDMNSBWGROUP *)            pNextR3;
     /** Pointer to the shared UVM structure. */
     R3PTRTYPE(struct PDMNETSHAPER *)            pShaperR3;
-    /** Critical section protecting all members below. */
+    /** Critical section serializing filter list and limit changes.
+     * Not taken when allocating bandwidth. */
     PDMCRITSECT                                 Lock;
     /** Pointer to the first filter attached to this group. */
     R3PTRTYPE(struct PDMNSFILTER *)             pFiltersHeadR3;
+    /** The filter the next round-robin wake-up pass starts with. */
+    R3PTRTYPE(struct PDMNSFILTER *)             pFilterNextR3;
     /** Bandwidth group name. */
     R3PTRTYPE(char *)                           pszNameR3;
-    /** Maximum number of bytes filters are allowed to transfer. */
-    volatile uint64_t                           cbPerSecMax;
-    /** Number of bytes we are allowed to transfer in one burst. */
-    volatile uint32_t                           cbBucket;
-    /** Number of bytes we were allowed to transfer at the last update. */
-    volatile uint32_t                           cbTokensLast;
-    /** Timestamp of the last update */
-    volatile uint64_t                           tsUpdatedLast;
+    /** Maximum number of bytes filters are allowed to transfer, as configured. */
+    uint64_t                                    cbPerSecMax;
+    /** The effective rate limit in bytes per second (low half) and the bucket
+     * size in bytes (high half).  Packed so the allocator, which doesn't take
+     * the lock, always sees a matching pair.  See pdmNsBwGroupCalcBurst. */
+    volatile uint64_t                           u64Limit;
+    /** Theoretical arrival time: the timestamp at which the bucket is full. */
+    volatile uint64_t                           tsTat;
+    /** Configured burst size in bytes, 0 for deriving it from the rate. */
+    uint32_t                                    cbBurstCfg;
+    /** Size of the last transfer that was refused. */
+    volatile uint32_t                           cbLastDenied;
+    /** Number of filters currently choked. */
+    volatile uint32_t                           cFiltersChoked;
     /** Reference counter - How many filters are associated with this group. */
     volatile uint32_t                           cRefs;
+    /** Number of bytes granted. */
+    STAMCOUNTER                                 StatBytesGranted;
+    /** Number of transfers refused. */
+    STAMCOUNTER                                 StatDenied;
+    /** Number of bytes refused. */
+    STAMCOUNTER                                 StatBytesDenied;
+    /** Number of compare-and-exchange retries due to concurrent allocations. */
+    STAMCOUNTER                                 StatAllocRetries;
+    /** Time between a filter getting choked and being told to retry. */
+    STAMPROFILE                                 StatChokedLatency;
 } PDMNSBWGROUP;
 /** Pointer to a bandwidth group. */
 typedef PDMNSBWGROUP *PPDMNSBWGROUP;
 
+
+/**
+ * Calculates the burst allowance in nanoseconds from a packed
+ * PDMNSBWGROUP::u64Limit value.
+ *
+ * @returns Nanoseconds, 0 if the group is disabled.
+ * @param   u64Limit        The packed rate limit and bucket size.
+ */
+DECLINLINE(uint64_t) pdmNsBwGroupCalcBurst(uint64_t u64Limit)
+{
+    uint32_t const cbPerSec = RT_LO_U32(u64Limit);
+    return cbPerSec ? (uint64_t)RT_HI_U32(u64Limit) * RT_NS_1SEC / cbPerSec : 0;
+}
+
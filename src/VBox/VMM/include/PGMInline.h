@@ -193,6 +193,21 @@ DECLINLINE(int) pgmPhysGetPageAndRangeEx(PVM pVM, RTGCPHYS GCPhys, PPPGMPAGE ppP
 }
 
 
+/**
+ * Hands out a new code page write generation.
+ *
+ * @returns The generation, never zero.
+ * @param   pVM         Pointer to the VM.
+ */
+DECLINLINE(uint32_t) pgmPhysNextCodePageGen(PVM pVM)
+{
+    uint32_t uGen = ASMAtomicIncU32(&pVM->pgm.s.uCodePageGenLast);
+    while (RT_UNLIKELY(!uGen))
+        uGen = ASMAtomicIncU32(&pVM->pgm.s.uCodePageGenLast);
+    return uGen;
+}
+
+
 /**
  * Convert GC Phys to HC Phys.
  *
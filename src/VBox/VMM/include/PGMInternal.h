@@ -3095,6 +3095,38 @@ typedef struct PGMSTATS
  */
 #define PGM2VM(pPGM)  ( (PVM)((char*)pPGM - pPGM->offVM) )
 
+
+/** @name Code page write generations.
+ * @{ */
+/** The number of code pages that can be tagged at a time (power of two). */
+#define PGM_CODE_PAGE_TAGS                  64
+/** Calculates the tag slot index for a guest physical address. */
+#define PGM_CODE_PAGE_TAG_IDX(a_GCPhys)     ( (uint32_t)((a_GCPhys) >> PAGE_SHIFT) & (PGM_CODE_PAGE_TAGS - 1) )
+/** Gives the page @a a_GCPhys belongs to a new write generation if it is
+ * tagged.  Call after writing to the page or mapping it for writing. */
+#define PGM_PHYS_WRITE_GEN_BUMP(a_pVM, a_GCPhys) \
+    do { \
+        PPGMCODEPAGETAG pTagMacro = &(a_pVM)->pgm.s.aCodePageTags[PGM_CODE_PAGE_TAG_IDX(a_GCPhys)]; \
+        if (ASMAtomicReadU64(&pTagMacro->GCPhys) == ((a_GCPhys) & ~(RTGCPHYS)PAGE_OFFSET_MASK)) \
+            ASMAtomicWriteU32(&pTagMacro->uGen, pgmPhysNextCodePageGen(a_pVM)); \
+    } while (0)
+/** @} */
+
+/**
+ * A guest page IEM has cached instructions from, see PGMPhysIemTagCodePage.
+ */
+typedef struct PGMCODEPAGETAG
+{
+    /** The guest physical address of the page, NIL_RTGCPHYS if the slot is free. */
+    RTGCPHYS volatile               GCPhys;
+    /** The write generation of the page, never zero. */
+    uint32_t volatile               uGen;
+    /** Explicit alignment padding. */
+    uint32_t                        u32Padding;
+} PGMCODEPAGETAG;
+/** Pointer to a code page tag. */
+typedef PGMCODEPAGETAG *PPGMCODEPAGETAG;
+
 /**
  * PGM Data (part of VM)
  */
@@ -3439,6 +3471,16 @@ typedef struct PGM
     bool                            afReserved[3];
     /** @} */
 
+    /** The last code page write generation handed out. */
+    uint32_t volatile               uCodePageGenLast;
+    /** The pages IEM has cached instructions from, indexed by
+     * PGM_CODE_PAGE_TAG_IDX.  A tagged page gets a new generation after it has
+     * been written thru PGMPhysWrite or PGMPhysSimpleWriteGCPhys, or mapped for
+     * writing, and all tags are dropped when page mappings change.  This lets
+     * IEM validate its decoded instruction cache, see
+     * PGMPhysGetWriteGeneration. */
+    PGMCODEPAGETAG                  aCodePageTags[PGM_CODE_PAGE_TAGS];
+
     /** @name Release Statistics
      * @{ */
     uint32_t                        cAllPages;              /**< The total number of pages. (Should be Private + Shared + Zero + Pure MMIO.) */
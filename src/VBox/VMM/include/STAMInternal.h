@@ -146,10 +146,14 @@ typedef struct STAMUSERPERVM
     /** The number of registered host CPU leaves. */
     uint32_t                cRegisteredHostCpus;
 
-    /** Explicit alignment padding. */
-    uint32_t                uAlignment;
+    /** Incremented (while owning RWSem for writing) whenever a sample is
+     * registered or deregistered.  Used by binary snapshots to detect layout
+     * changes. */
+    uint32_t volatile       cLayoutGen;
     /** The copy of the GMM statistics. */
     GMMSTATS                GMMStats;
+    /** The statistics exporter, NULL if not active. */
+    struct STAMEXPORTER    *pExporter;
 } STAMUSERPERVM;
 #ifdef IN_RING3
 AssertCompileMemberAlignment(STAMUSERPERVM, GMMStats, 8);
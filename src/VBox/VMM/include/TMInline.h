@@ -19,6 +19,36 @@
 #define ___TMInline_h
 
 
+/**
+ * Drops a timer that is about to be unlinked from the active list from the
+ * expire time index of the queue.
+ *
+ * If the timer is the index node for its expire time, the previous timer takes
+ * over that role when it has the same expire time.
+ *
+ * @param   pQueue      The timer queue.
+ * @param   pTimer      The timer that is being unlinked.
+ * @param   pPrev       The previous timer in the active list, NULL if head.
+ * @param   pNext       The next timer in the active list, NULL if tail.
+ *
+ * @remarks Called while owning the relevant queue lock.
+ */
+DECL_FORCE_INLINE(void) tmTimerQueueIndexRemove(PTMTIMERQUEUE pQueue, PTMTIMER pTimer, PTMTIMER pPrev, PTMTIMER pNext)
+{
+    RTGCPHYS const Key = pTimer->ActiveCore.Key;
+    if (!pNext || pNext->ActiveCore.Key != Key)
+    {
+        PAVLOGCPHYSNODECORE pCore = RTAvloGCPhysRemove(&pQueue->ActiveTree, Key);
+        Assert(pCore == &pTimer->ActiveCore); NOREF(pCore);
+        if (pPrev && pPrev->ActiveCore.Key == Key)
+        {
+            bool fRc = RTAvloGCPhysInsert(&pQueue->ActiveTree, &pPrev->ActiveCore);
+            Assert(fRc); NOREF(fRc);
+        }
+    }
+}
+
+
 /**
  * Used to unlink a timer from the active list.
  *
@@ -38,6 +68,7 @@ DECL_FORCE_INLINE(void) tmTimerQueueUnlinkActive(PTMTIMERQUEUE pQueue, PTMTIMER
 
     const PTMTIMER pPrev = TMTIMER_GET_PREV(pTimer);
     const PTMTIMER pNext = TMTIMER_GET_NEXT(pTimer);
+    tmTimerQueueIndexRemove(pQueue, pTimer, pPrev, pNext);
     if (pPrev)
         TMTIMER_SET_NEXT(pPrev, pNext);
     else
@@ -23,6 +23,7 @@
 #include <iprt/time.h>
 #include <iprt/timer.h>
 #include <iprt/assert.h>
+#include <iprt/avl.h>
 #include <VBox/vmm/stam.h>
 #include <VBox/vmm/pdmcritsect.h>
 
@@ -178,6 +179,11 @@ typedef struct TMTIMER
     int32_t                 offNext;
     /** Timer relative offset to the previous timer in the chain. */
     int32_t                 offPrev;
+    /** Node in the expire time index of the active list (TMTIMERQUEUE::ActiveTree).
+     * The key is the expire time the timer was linked into the active list with,
+     * which may differ from u64Expire while a reschedule is pending.  Only the
+     * last timer of a run of timers with the same expire time is in the tree. */
+    AVLOGCPHYSNODECORE      ActiveCore;
 
     /** Pointer to the VM the timer belongs to - R3 Ptr. */
     PVMR3                   pVMR3;
@@ -204,6 +210,7 @@ typedef struct TMTIMER
 #endif
 } TMTIMER;
 AssertCompileMemberSize(TMTIMER, enmState, sizeof(uint32_t));
+AssertCompileMemberAlignment(TMTIMER, ActiveCore, 8);
 
 
 /**
@@ -275,9 +282,19 @@ typedef struct TMTIMERQUEUE
     int32_t volatile        offSchedule;
     /** The clock for this queue. */
     TMCLOCK                 enmClock;
+    /** Expire time index of the active list.
+     *
+     * This makes inserting into and unlinking from the active list O(log n)
+     * instead of walking the list.  There is one node per distinct expire time,
+     * the last timer in the list with that time, so a new timer with an
+     * existing expire time goes after its peers like it always did.
+     *
+     * The offset is relative to this member, see AVLOGCPHYSTREE. */
+    AVLOGCPHYSTREE          ActiveTree;
     /** Pad the structure up to 32 bytes. */
-    uint32_t                au32Padding[3];
+    uint32_t                au32Padding[2];
 } TMTIMERQUEUE;
+AssertCompileSize(TMTIMERQUEUE, 32);
 
 /** Pointer to a timer queue. */
 typedef TMTIMERQUEUE *PTMTIMERQUEUE;
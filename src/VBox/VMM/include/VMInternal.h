@@ -126,6 +126,11 @@ typedef struct VMRUNTIMEERROR
     uint32_t                        fFlags;
 } VMRUNTIMEERROR, *PVMRUNTIMEERROR;
 
+/** Number of buckets in the halt duration and wake-up latency histograms.
+ * The first bucket is below 1us and each following covers 4 times as much
+ * time, so the last one is 64ms and above. */
+#define VM_HALT_HIST_BUCKETS    10
+
 /** The halt method. */
 typedef enum
 {
@@ -141,6 +146,8 @@ typedef enum
     VMHALTMETHOD_1,
     /** The first go at a more global approach. */
     VMHALTMETHOD_GLOBAL_1,
+    /** The global approach with adaptive polling before blocking. */
+    VMHALTMETHOD_ADAPTIVE,
     /** The end of valid methods. (not inclusive of course) */
     VMHALTMETHOD_END,
     /** The usual 32-bit max value. */
@@ -300,6 +307,25 @@ typedef struct VMINTUSERPERVM
             /** The threshold between spinning and blocking. */
             uint32_t                cNsSpinBlockThresholdCfg;
         }                           Global1;
+
+       /**
+        * Same as global 1, except that each EMT polls the force action flags
+        * for a while before blocking.  The poll window is adjusted per VCPU
+        * depending on whether wake-ups arrive shortly after halting.
+        */
+        struct
+        {
+            /** The threshold between spinning and blocking. */
+            uint32_t                cNsSpinBlockThresholdCfg;
+            /** The initial poll window when growing it from zero. */
+            uint32_t                cNsPollStartCfg;
+            /** The max poll window.  Wake-ups later than this don't grow it. */
+            uint32_t                cNsPollMaxCfg;
+            /** The factor to grow the poll window by. */
+            uint32_t                uPollGrowCfg;
+            /** The divisor to shrink the poll window by. */
+            uint32_t                uPollShrinkCfg;
+        }                           Adaptive;
     }                               Halt;
 
     /** Pointer to the DBGC instance data. */
@@ -391,6 +417,23 @@ typedef struct VMINTUSERPERVMCPU
             uint64_t                u64StartSpinTS;
         }                           Method12;
 
+       /**
+        * Adaptive halt polling.
+        */
+        struct
+        {
+            /** The current poll window (ns), zero if not polling. */
+            uint32_t                cNsPollWindow;
+            /** Set while the EMT is polling the FFs, the notifier then doesn't
+             * need to wake it up. */
+            bool volatile           fPolling;
+            /** Align the next member. */
+            bool                    afAlignment[3];
+            /** When the first notification for the current halt arrived
+             * (RTTimeNanoTS), zero if none. */
+            uint64_t volatile       u64WakeupTS;
+        }                           Adaptive;
+
 # if 0
        /**
         * Method 3 & 4 - Same as method 1 & 2 respectivly, except that we
@@ -436,10 +479,27 @@ typedef struct VMINTUSERPERVMCPU
     STAMPROFILE                     StatHaltTimers;
     STAMPROFILE                     StatHaltPoll;
     /** @} */
+
+    /** Adaptive halt method statistics.
+     * @{ */
+    /** Halts ended by an FF while polling. */
+    STAMCOUNTER                     StatHaltPollHits;
+    /** Polls that ran out the poll window. */
+    STAMCOUNTER                     StatHaltPollMisses;
+    /** Poll window increases. */
+    STAMCOUNTER                     StatHaltPollGrow;
+    /** Poll window decreases. */
+    STAMCOUNTER                     StatHaltPollShrink;
+    /** Halt duration histogram, see vmR3HaltHistBucket. */
+    STAMCOUNTER                     aStatHaltDuration[VM_HALT_HIST_BUCKETS];
+    /** Wake-up latency histogram (notification to EMT running again). */
+    STAMCOUNTER                     aStatHaltWakeupLatency[VM_HALT_HIST_BUCKETS];
+    /** @} */
 } VMINTUSERPERVMCPU;
 AssertCompileMemberAlignment(VMINTUSERPERVMCPU, u64HaltsStartTS, 8);
 AssertCompileMemberAlignment(VMINTUSERPERVMCPU, Halt.Method12.cNSBlockedTooLongAvg, 8);
 AssertCompileMemberAlignment(VMINTUSERPERVMCPU, StatHaltYield, 8);
+AssertCompileMemberAlignment(VMINTUSERPERVMCPU, Halt.Adaptive.u64WakeupTS, 8);
 
 /** Pointer to the VM internal data kept in the UVM. */
 typedef VMINTUSERPERVMCPU *PVMINTUSERPERVMCPU;
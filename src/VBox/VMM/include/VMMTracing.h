@@ -31,6 +31,7 @@
 # define DBGFTRACE_ENABLED
 #endif
 #include <VBox/vmm/dbgftrace.h>
+#include <iprt/asm-amd64-x86.h>
 
 
 /*******************************************************************************
@@ -57,6 +58,23 @@
 #define VMMTPGROUP_EM       RT_BIT(0)
 #define VMMTPGROUP_HM       RT_BIT(1)
 #define VMMTPGROUP_TM       RT_BIT(2)
+/** Binary exit tracing (DBGFExitTraceAdd). */
+#define VMMTPGROUP_EXIT     RT_BIT(3)
+/** @}  */
+
+/** @name Exit tracing.
+ * @{ */
+/** Gets the start timestamp for an exit trace entry, 0 if exit tracing is
+ * disabled for the virtual CPU. */
+#define VMM_EXIT_TRACE_START(a_pVCpu) \
+    ( RT_UNLIKELY((a_pVCpu)->fTraceGroups & VMMTPGROUP_EXIT) ? ASMReadTSC() : UINT64_C(0) )
+/** Adds an exit trace entry if VMM_EXIT_TRACE_START returned a timestamp.
+ * a_idHandler is the PDM tracing ID of the device handling it, 0 if none. */
+#define VMM_EXIT_TRACE_END(a_pVCpu, a_u64TscStart, a_enmSrc, a_uReason, a_uRip, a_uAddr, a_idHandler) \
+    do { \
+        if (RT_UNLIKELY(a_u64TscStart)) \
+            DBGFExitTraceAdd(a_pVCpu, a_enmSrc, a_uReason, a_uRip, a_uAddr, a_idHandler, a_u64TscStart); \
+    } while (0)
 /** @}  */
 
 
@@ -0,0 +1,281 @@
+/* $Id: tstIOMMmioDecCache.cpp $ */
+/** @file
+ * IOM Testcase - MMIO decode cache entries.
+ */
+
+/*
+ * Copyright (C) 2014 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ */
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include "IOMInternal.h"
+#include <VBox/vmm/vm.h>
+#include <VBox/vmm/cpum.h>
+#include <VBox/dis.h>
+#include <VBox/err.h>
+#include "IOMInline.h"
+
+#include <iprt/string.h>
+#include <iprt/test.h>
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+/**
+ * A decode cache test instruction.
+ */
+typedef struct TSTDECINSTR
+{
+    /** Description. */
+    const char     *pszName;
+    /** The CPU mode to decode it in. */
+    DISCPUMODE      enmCpuMode;
+    /** Whether the instruction writes to MMIO. */
+    bool            fWrite;
+    /** The instruction bytes. */
+    uint8_t         abInstr[15];
+    /** Whether it should be cacheable. */
+    bool            fCacheable;
+    /** The expected access kind. */
+    IOMMMIODECKIND  enmKind;
+    /** The expected access size. */
+    uint8_t         cbAccess;
+    /** The expected register operand size. */
+    uint8_t         cbReg;
+    /** Reads: the value returned by the device.
+     *  Writes: the value expected to be written (masked by cbAccess). */
+    uint64_t        u64Value;
+    /** Reads: the expected RAX..R15 value of the destination register (iReg).  */
+    uint64_t        u64RegAfter;
+} TSTDECINSTR;
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** The test handle. */
+static RTTEST g_hTest;
+
+/** The initial register values, rax=0x1111111111111111 ... r15=0xffffffffffffffff. */
+#define TST_REG_INIT(a_iReg)    ( UINT64_C(0x1111111111111111) * ((a_iReg) + 1) )
+
+static const TSTDECINSTR g_aInstrs[] =
+{
+    /* Reads. */
+    { "mov eax, [rbx]",         DISCPUMODE_64BIT, false, { 0x8b, 0x03 },
+      true,  IOMMMIODECKIND_READ,      4, 4, UINT64_C(0xdeadbeef),          UINT64_C(0x00000000deadbeef) },
+    { "mov rax, [rbx]",         DISCPUMODE_64BIT, false, { 0x48, 0x8b, 0x03 },
+      true,  IOMMMIODECKIND_READ,      8, 8, UINT64_C(0x0123456789abcdef),  UINT64_C(0x0123456789abcdef) },
+    { "mov cx, [esi]",          DISCPUMODE_32BIT, false, { 0x66, 0x8b, 0x0e },
+      true,  IOMMMIODECKIND_READ,      2, 2, UINT64_C(0xcafe),              TST_REG_INIT(1) & ~UINT64_C(0xffff) | 0xcafe },
+    { "mov dl, [edi]",          DISCPUMODE_32BIT, false, { 0x8a, 0x17 },
+      true,  IOMMMIODECKIND_READ,      1, 1, UINT64_C(0x5a),                TST_REG_INIT(2) & ~UINT64_C(0xff) | 0x5a },
+    { "movzx ecx, byte [rsi]",  DISCPUMODE_64BIT, false, { 0x0f, 0xb6, 0x0e },
+      true,  IOMMMIODECKIND_READ,      1, 4, UINT64_C(0x80),                UINT64_C(0x80) },
+    { "movsx rdx, word [rdi]",  DISCPUMODE_64BIT, false, { 0x48, 0x0f, 0xbf, 0x17 },
+      true,  IOMMMIODECKIND_READ_SX,   2, 8, UINT64_C(0x8001),              UINT64_C(0xffffffffffff8001) },
+    { "movsx ebx, byte [eax]",  DISCPUMODE_32BIT, false, { 0x0f, 0xbe, 0x18 },
+      true,  IOMMMIODECKIND_READ_SX,   1, 4, UINT64_C(0x7f),                UINT64_C(0x7f) },
+    { "mov r10d, [rax+8]",      DISCPUMODE_64BIT, false, { 0x44, 0x8b, 0x50, 0x08 },
+      true,  IOMMMIODECKIND_READ,      4, 4, UINT64_C(0x42),                UINT64_C(0x42) },
+
+    /* Writes. */
+    { "mov [rax], ecx",         DISCPUMODE_64BIT, true,  { 0x89, 0x08 },
+      true,  IOMMMIODECKIND_WRITE_REG, 4, 4, TST_REG_INIT(1) & UINT32_MAX,  0 },
+    { "mov [rax], r9",          DISCPUMODE_64BIT, true,  { 0x4c, 0x89, 0x08 },
+      true,  IOMMMIODECKIND_WRITE_REG, 8, 8, TST_REG_INIT(9),               0 },
+    { "mov [eax], ah",          DISCPUMODE_32BIT, true,  { 0x88, 0x20 },
+      true,  IOMMMIODECKIND_WRITE_REG, 1, 1, TST_REG_INIT(0) >> 8 & 0xff,   0 },
+    { "mov [eax], dx",          DISCPUMODE_32BIT, true,  { 0x66, 0x89, 0x10 },
+      true,  IOMMMIODECKIND_WRITE_REG, 2, 2, TST_REG_INIT(2) & 0xffff,      0 },
+    { "mov dword [rax], imm32", DISCPUMODE_64BIT, true,  { 0xc7, 0x00, 0x78, 0x56, 0x34, 0x12 },
+      true,  IOMMMIODECKIND_WRITE_IMM, 4, 0, UINT64_C(0x12345678),          0 },
+    { "mov byte [eax+4], imm8", DISCPUMODE_32BIT, true,  { 0xc6, 0x40, 0x04, 0x99 },
+      true,  IOMMMIODECKIND_WRITE_IMM, 1, 0, UINT64_C(0x99),                0 },
+
+    /* Not cacheable. */
+    { "mov [eax], ds",          DISCPUMODE_32BIT, true,  { 0x8c, 0x18 },
+      false, IOMMMIODECKIND_FREE,      0, 0, 0,                             0 },
+    { "and [eax], ecx",         DISCPUMODE_32BIT, true,  { 0x21, 0x08 },
+      false, IOMMMIODECKIND_FREE,      0, 0, 0,                             0 },
+    { "stosd",                  DISCPUMODE_32BIT, true,  { 0xab },
+      false, IOMMMIODECKIND_FREE,      0, 0, 0,                             0 },
+};
+
+
+/**
+ * Fills in a register frame with easily recognizable values.
+ */
+static void tstInitCtx(PCPUMCTX pCtx)
+{
+    RT_ZERO(*pCtx);
+    uint64_t *pau64 = &pCtx->rax;
+    for (unsigned iReg = 0; iReg < 16; iReg++)
+        pau64[iReg] = TST_REG_INIT(iReg);
+    AssertCompileMemberOffset(CPUMCTX, r15, RT_OFFSETOF(CPUMCTX, rax) + 15 * 8);
+}
+
+
+/**
+ * Checks the entry initialization and the read/write helpers.
+ */
+static void tstEntries(void)
+{
+    RTTestSub(g_hTest, "Entries");
+
+    for (unsigned i = 0; i < RT_ELEMENTS(g_aInstrs); i++)
+    {
+        TSTDECINSTR const *pTst = &g_aInstrs[i];
+        DISCPUSTATE Dis;
+        uint32_t    cbInstr;
+        int rc = DISInstr(pTst->abInstr, pTst->enmCpuMode, &Dis, &cbInstr);
+        RTTESTI_CHECK_MSG_RETV(RT_SUCCESS(rc), ("%s: DISInstr -> %Rrc\n", pTst->pszName, rc));
+
+        IOMMMIODECENTRY Entry;
+        RT_ZERO(Entry);
+        RTGCPTR const GCPtrInstr = UINT64_C(0xffffffff80001000) + i * 16;
+        bool fRc = iomMmioDecEntryInit(&Entry, &Dis, GCPtrInstr, pTst->fWrite);
+        if (fRc != pTst->fCacheable)
+        {
+            RTTestFailed(g_hTest, "%s: iomMmioDecEntryInit -> %RTbool, expected %RTbool\n", pTst->pszName, fRc, pTst->fCacheable);
+            continue;
+        }
+        if (!fRc)
+            continue;
+
+        if (   Entry.enmKind  != (uint8_t)pTst->enmKind
+            || Entry.cbAccess != pTst->cbAccess
+            || Entry.cbReg    != pTst->cbReg
+            || Entry.cbInstr  != cbInstr
+            || Entry.enmCpuMode != (uint8_t)pTst->enmCpuMode
+            || Entry.GCPtrInstr != GCPtrInstr
+            || memcmp(Entry.abInstr, pTst->abInstr, cbInstr))
+        {
+            RTTestFailed(g_hTest, "%s: enmKind=%u cbAccess=%u cbReg=%u cbInstr=%u/%u enmCpuMode=%u\n", pTst->pszName,
+                         Entry.enmKind, Entry.cbAccess, Entry.cbReg, Entry.cbInstr, cbInstr, Entry.enmCpuMode);
+            continue;
+        }
+
+        CPUMCTX Ctx;
+        tstInitCtx(&Ctx);
+        PCPUMCTXCORE pCtxCore = CPUMCTX2CORE(&Ctx);
+        if (pTst->fWrite)
+        {
+            uint64_t u64 = iomMmioDecEntryGetWriteValue(&Entry, pCtxCore);
+            uint64_t const fMask = Entry.cbAccess == 8 ? UINT64_MAX : RT_BIT_64(Entry.cbAccess * 8) - 1;
+            if ((u64 & fMask) != pTst->u64Value)
+                RTTestFailed(g_hTest, "%s: write value %#RX64, expected %#RX64\n", pTst->pszName, u64 & fMask, pTst->u64Value);
+        }
+        else
+        {
+            iomMmioDecEntryStoreReadValue(&Entry, pCtxCore, pTst->u64Value);
+            uint64_t const u64Reg = (&Ctx.rax)[Entry.iReg];
+            uint64_t const fMask  = pTst->enmCpuMode == DISCPUMODE_64BIT || Entry.cbReg < 4 ? UINT64_MAX : UINT32_MAX;
+            if ((u64Reg & fMask) != (pTst->u64RegAfter & fMask))
+                RTTestFailed(g_hTest, "%s: register %u is %#RX64, expected %#RX64\n",
+                             pTst->pszName, Entry.iReg, u64Reg, pTst->u64RegAfter);
+
+            /* No other register may be touched. */
+            for (unsigned iReg = 0; iReg < 16; iReg++)
+                if (iReg != Entry.iReg && (&Ctx.rax)[iReg] != TST_REG_INIT(iReg))
+                    RTTestFailed(g_hTest, "%s: register %u was modified: %#RX64\n", pTst->pszName, iReg, (&Ctx.rax)[iReg]);
+        }
+    }
+}
+
+
+/**
+ * Checks lookup, insertion and eviction.
+ */
+static void tstLookup(void)
+{
+    RTTestSub(g_hTest, "Lookup");
+
+    IOMMMIODECCACHE Cache;
+    RT_ZERO(Cache);
+
+    static const uint8_t s_abMovRead[]  = { 0x8b, 0x03 };   /* mov eax, [rbx] */
+    static const uint8_t s_abMovWrite[] = { 0x89, 0x08 };   /* mov [rax], ecx */
+    static const uint8_t s_abAnd[]      = { 0x21, 0x08 };   /* and [rax], ecx */
+
+    DISCPUSTATE Dis;
+    uint32_t    cbInstr;
+    RTTESTI_CHECK_RC_RETV(DISInstr(s_abMovRead, DISCPUMODE_64BIT, &Dis, &cbInstr), VINF_SUCCESS);
+
+    RTGCPTR const GCPtr1 = UINT64_C(0xfffff80000123450);
+    RTTESTI_CHECK(iomMmioDecCacheLookup(&Cache, GCPtr1, DISCPUMODE_64BIT) == NULL);
+    RTTESTI_CHECK(iomMmioDecCacheLookup(&Cache, 0, DISCPUMODE_16BIT) == NULL); /* zeroed entries are free */
+    RTTESTI_CHECK(iomMmioDecCacheInsert(&Cache, &Dis, GCPtr1, false));
+
+    PIOMMMIODECENTRY pEntry = iomMmioDecCacheLookup(&Cache, GCPtr1, DISCPUMODE_64BIT);
+    RTTESTI_CHECK_RETV(pEntry != NULL);
+    RTTESTI_CHECK(pEntry->enmKind == IOMMMIODECKIND_READ);
+    RTTESTI_CHECK(iomMmioDecCacheLookup(&Cache, GCPtr1, DISCPUMODE_32BIT) == NULL);
+    RTTESTI_CHECK(iomMmioDecCacheLookup(&Cache, GCPtr1 + 1, DISCPUMODE_64BIT) == NULL);
+
+    /* Something mapping to the same slot replaces the entry. */
+    RTGCPTR GCPtr2 = GCPtr1 + 1;
+    while (IOM_MMIO_DEC_CACHE_IDX(GCPtr2) != IOM_MMIO_DEC_CACHE_IDX(GCPtr1))
+        GCPtr2++;
+    RTTESTI_CHECK_RC_RETV(DISInstr(s_abMovWrite, DISCPUMODE_64BIT, &Dis, &cbInstr), VINF_SUCCESS);
+    RTTESTI_CHECK(iomMmioDecCacheInsert(&Cache, &Dis, GCPtr2, true));
+    RTTESTI_CHECK(iomMmioDecCacheLookup(&Cache, GCPtr1, DISCPUMODE_64BIT) == NULL);
+    pEntry = iomMmioDecCacheLookup(&Cache, GCPtr2, DISCPUMODE_64BIT);
+    RTTESTI_CHECK_RETV(pEntry != NULL);
+    RTTESTI_CHECK(pEntry->enmKind == IOMMMIODECKIND_WRITE_REG);
+
+    /* An uncacheable instruction leaves the slot alone. */
+    RTTESTI_CHECK_RC_RETV(DISInstr(s_abAnd, DISCPUMODE_64BIT, &Dis, &cbInstr), VINF_SUCCESS);
+    RTTESTI_CHECK(!iomMmioDecCacheInsert(&Cache, &Dis, GCPtr1, true));
+    RTTESTI_CHECK(iomMmioDecCacheLookup(&Cache, GCPtr2, DISCPUMODE_64BIT) == pEntry);
+
+    /* Invalidation the way the handler does it when the code changed. */
+    pEntry->cbInstr = 0;
+    RTTESTI_CHECK(iomMmioDecCacheLookup(&Cache, GCPtr2, DISCPUMODE_64BIT) == NULL);
+
+    /* Fill all the slots and check that they're all found. */
+    RT_ZERO(Cache);
+    RTTESTI_CHECK_RC_RETV(DISInstr(s_abMovRead, DISCPUMODE_32BIT, &Dis, &cbInstr), VINF_SUCCESS);
+    RTGCPTR  aGCPtrs[IOM_MMIO_DEC_CACHE_SIZE];
+    uint32_t fUsed = 0;
+    for (RTGCPTR GCPtr = 0x1000; fUsed != RT_BIT_32(IOM_MMIO_DEC_CACHE_SIZE) - 1; GCPtr += 3)
+    {
+        unsigned idx = IOM_MMIO_DEC_CACHE_IDX(GCPtr);
+        if (!(fUsed & RT_BIT_32(idx)))
+        {
+            fUsed |= RT_BIT_32(idx);
+            aGCPtrs[idx] = GCPtr;
+            RTTESTI_CHECK(iomMmioDecCacheInsert(&Cache, &Dis, GCPtr, false));
+        }
+    }
+    for (unsigned idx = 0; idx < IOM_MMIO_DEC_CACHE_SIZE; idx++)
+    {
+        pEntry = iomMmioDecCacheLookup(&Cache, aGCPtrs[idx], DISCPUMODE_32BIT);
+        RTTESTI_CHECK(pEntry == &Cache.aEntries[idx]);
+    }
+}
+
+
+int main()
+{
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstIOMMmioDecCache", &g_hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(g_hTest);
+
+    tstEntries();
+    tstLookup();
+
+    return RTTestSummaryAndDestroy(g_hTest);
+}
@@ -0,0 +1,367 @@
+/* $Id: tstSTAMExport.cpp $ */
+/** @file
+ * STAM Testcase - binary snapshots and the export stream format.
+ */
+
+/*
+ * Copyright (C) 2014 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ */
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <VBox/vmm/stam.h>
+#include <VBox/vmm/uvm.h>
+#include <VBox/err.h>
+#include <VBox/param.h>
+
+#include <iprt/file.h>
+#include <iprt/mem.h>
+#include <iprt/path.h>
+#include <iprt/process.h>
+#include <iprt/string.h>
+#include <iprt/test.h>
+#include <iprt/thread.h>
+#include <iprt/time.h>
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+/**
+ * A sample as reconstructed from the export stream.
+ */
+typedef struct TSTSAMPLE
+{
+    /** The sample name. */
+    char            szName[64];
+    /** The sample type. */
+    uint8_t         enmType;
+    /** Index of the first value. */
+    uint32_t        iFirstValue;
+    /** Number of values. */
+    uint32_t        cValues;
+} TSTSAMPLE;
+
+/**
+ * The export stream reader state.
+ */
+typedef struct TSTREADER
+{
+    /** The samples of the current layout. */
+    TSTSAMPLE       aSamples[16];
+    /** Number of samples. */
+    uint32_t        cSamples;
+    /** The current values. */
+    uint64_t        au64Values[64];
+    /** Number of values. */
+    uint32_t        cValues;
+    /** Number of layout records seen. */
+    uint32_t        cLayouts;
+    /** Number of values records seen. */
+    uint32_t        cValueRecords;
+} TSTREADER;
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+static STAMCOUNTER  g_Counter;
+static STAMPROFILE  g_Profile;
+static uint32_t     g_u32;
+static STAMRATIOU32 g_Ratio;
+static uint64_t     g_u64Late;
+
+
+/**
+ * Parses one export stream, applying the records to the reader state.
+ *
+ * A truncated record at the end is ignored as the exporter may be in the
+ * middle of writing it.
+ *
+ * @param   pReader     The reader state.
+ * @param   pb          The stream.
+ * @param   cb          The stream size.
+ */
+static void tstReadStream(TSTREADER *pReader, uint8_t const *pb, size_t cb)
+{
+    uint32_t uSeqExpected = 0;
+    size_t   off          = 0;
+    while (cb - off >= sizeof(STAMEXPORTHDR))
+    {
+        STAMEXPORTHDR Hdr;
+        memcpy(&Hdr, &pb[off], sizeof(Hdr));
+        RTTESTI_CHECK_MSG_RETV(Hdr.u32Magic == STAMEXPORT_MAGIC, ("off=%#zx u32Magic=%#x\n", off, Hdr.u32Magic));
+        RTTESTI_CHECK_RETV(Hdr.uVersion == STAMEXPORT_VERSION);
+        RTTESTI_CHECK_MSG_RETV(Hdr.uSeq == uSeqExpected, ("uSeq=%u expected %u\n", Hdr.uSeq, uSeqExpected));
+        RTTESTI_CHECK_RETV(Hdr.cbRecord >= sizeof(Hdr) + sizeof(uint32_t));
+        if (Hdr.cbRecord > cb - off)
+            break;
+        uSeqExpected++;
+
+        uint8_t const *pbRec = &pb[off + sizeof(Hdr)];
+        size_t const   cbRec = Hdr.cbRecord - sizeof(Hdr);
+        size_t         offRec;
+        if (Hdr.uType == STAMEXPORTREC_LAYOUT)
+        {
+            uint32_t cSamples, cValues;
+            memcpy(&cSamples, &pbRec[0], sizeof(cSamples));
+            memcpy(&cValues,  &pbRec[4], sizeof(cValues));
+            RTTESTI_CHECK_RETV(cSamples <= RT_ELEMENTS(pReader->aSamples));
+            RTTESTI_CHECK_RETV(cValues  <= RT_ELEMENTS(pReader->au64Values));
+            offRec = 8;
+            uint32_t iValue = 0;
+            for (uint32_t i = 0; i < cSamples; i++)
+            {
+                RTTESTI_CHECK_RETV(offRec + 6 <= cbRec);
+                uint16_t cValuesSample, cchName;
+                pReader->aSamples[i].enmType = pbRec[offRec];
+                memcpy(&cValuesSample, &pbRec[offRec + 2], sizeof(cValuesSample));
+                memcpy(&cchName,       &pbRec[offRec + 4], sizeof(cchName));
+                offRec += 6;
+                RTTESTI_CHECK_RETV(offRec + cchName <= cbRec);
+                RTTESTI_CHECK_RETV(cchName < sizeof(pReader->aSamples[i].szName));
+                memcpy(pReader->aSamples[i].szName, &pbRec[offRec], cchName);
+                pReader->aSamples[i].szName[cchName] = '\0';
+                pReader->aSamples[i].iFirstValue = iValue;
+                pReader->aSamples[i].cValues     = cValuesSample;
+                iValue += cValuesSample;
+                offRec += cchName;
+            }
+            RTTESTI_CHECK_RETV(offRec == cbRec);
+            RTTESTI_CHECK_RETV(iValue == cValues);
+            pReader->cSamples = cSamples;
+            pReader->cValues  = cValues;
+            RT_ZERO(pReader->au64Values);
+            pReader->cLayouts++;
+        }
+        else if (Hdr.uType == STAMEXPORTREC_VALUES)
+        {
+            RTTESTI_CHECK_RETV(pReader->cLayouts > 0);
+            uint32_t cChanged;
+            memcpy(&cChanged, &pbRec[0], sizeof(cChanged));
+            RTTESTI_CHECK_RETV(cbRec == sizeof(uint32_t) + cChanged * (sizeof(uint32_t) + sizeof(uint64_t)));
+            offRec = sizeof(uint32_t);
+            for (uint32_t i = 0; i < cChanged; i++)
+            {
+                uint32_t iValue;
+                memcpy(&iValue, &pbRec[offRec], sizeof(iValue));
+                RTTESTI_CHECK_RETV(iValue < pReader->cValues);
+                memcpy(&pReader->au64Values[iValue], &pbRec[offRec + sizeof(iValue)], sizeof(uint64_t));
+                offRec += sizeof(uint32_t) + sizeof(uint64_t);
+            }
+            pReader->cValueRecords++;
+        }
+        else
+            RTTestIFailed("Unknown record type %u at %#zx\n", Hdr.uType, off);
+        off += Hdr.cbRecord;
+    }
+}
+
+
+/**
+ * Looks up a sample value in the reconstructed state.
+ *
+ * @returns The value, UINT64_MAX if not found.
+ * @param   pReader     The reader state.
+ * @param   pszName     The sample name.
+ * @param   iValue      The value index within the sample.
+ */
+static uint64_t tstReaderGetValue(TSTREADER const *pReader, const char *pszName, uint32_t iValue)
+{
+    for (uint32_t i = 0; i < pReader->cSamples; i++)
+        if (!strcmp(pReader->aSamples[i].szName, pszName))
+            return iValue < pReader->aSamples[i].cValues ? pReader->au64Values[pReader->aSamples[i].iFirstValue + iValue] : UINT64_MAX;
+    return UINT64_MAX;
+}
+
+
+/**
+ * Waits for the export file to grow @a cRecords times, so that the last
+ * growth is from a snapshot taken after the caller changed something.
+ *
+ * A layout record and the values record following it may show up as two
+ * separate growths, so callers wait for three after changing the layout.
+ *
+ * @param   pszFile     The export file.
+ * @param   cRecords    The number of times to see the file grow.
+ */
+static void tstWaitForRecords(const char *pszFile, unsigned cRecords)
+{
+    uint64_t       cbLast  = UINT64_MAX;
+    uint64_t const msStart = RTTimeMilliTS();
+    while (cRecords > 0 && RTTimeMilliTS() - msStart < 10000)
+    {
+        RTFILE hFile;
+        uint64_t cb = 0;
+        if (RT_SUCCESS(RTFileOpen(&hFile, pszFile, RTFILE_O_READ | RTFILE_O_OPEN | RTFILE_O_DENY_NONE)))
+        {
+            RTFileGetSize(hFile, &cb);
+            RTFileClose(hFile);
+        }
+        if (cbLast != UINT64_MAX && cb > cbLast)
+            cRecords--;
+        cbLast = cb;
+        RTThreadSleep(5);
+    }
+    RTTESTI_CHECK_MSG(cRecords == 0, ("Timed out waiting for the exporter\n"));
+}
+
+
+static void tstBinSnapshot(PUVM pUVM)
+{
+    RTTestISub("Binary snapshot");
+
+    PSTAMBINSNAPSHOT pSnapshot;
+    RTTESTI_CHECK_RC_RETV(STAMR3BinSnapshotCreate(pUVM, "/tst/*", &pSnapshot), VINF_SUCCESS);
+
+    g_Counter.c        = 42;
+    g_Profile.cPeriods = 2;
+    g_Profile.cTicks   = 300;
+    g_Profile.cTicksMin = 100;
+    g_Profile.cTicksMax = 200;
+    g_u32              = 0x12345678;
+    g_Ratio.u32A       = 3;
+    g_Ratio.u32B       = 4;
+    RTTESTI_CHECK_RC(STAMR3BinSnapshotTake(pSnapshot, false /*fUpdateRing0*/), VINF_SUCCESS);
+
+    PCSTAMBINSAMPLE paSamples;
+    uint32_t        cSamples;
+    uint32_t const  uLayout = STAMR3BinSnapshotGetLayout(pSnapshot, &paSamples, &cSamples);
+    RTTESTI_CHECK(cSamples == 4);
+    uint32_t        cValues;
+    uint64_t const *pau64 = STAMR3BinSnapshotGetValues(pSnapshot, &cValues, NULL);
+    RTTESTI_CHECK_RETV(cValues == 1 + 4 + 1 + 2);
+    for (uint32_t i = 0; i < cSamples; i++)
+    {
+        uint64_t const *pu64 = &pau64[paSamples[i].iFirstValue];
+        if (!strcmp(paSamples[i].pszName, "/tst/Counter"))
+            RTTESTI_CHECK(paSamples[i].cValues == 1 && pu64[0] == 42);
+        else if (!strcmp(paSamples[i].pszName, "/tst/Profile"))
+            RTTESTI_CHECK(   paSamples[i].cValues == 4
+                          && pu64[0] == 2 && pu64[1] == 300 && pu64[2] == 100 && pu64[3] == 200);
+        else if (!strcmp(paSamples[i].pszName, "/tst/U32"))
+            RTTESTI_CHECK(paSamples[i].cValues == 1 && pu64[0] == 0x12345678);
+        else if (!strcmp(paSamples[i].pszName, "/tst/Ratio"))
+            RTTESTI_CHECK(paSamples[i].cValues == 2 && pu64[0] == 3 && pu64[1] == 4);
+        else
+            RTTestIFailed("Unexpected sample '%s'\n", paSamples[i].pszName);
+    }
+
+    /* Values are only copied when taking the snapshot, the layout stays. */
+    RTTESTI_CHECK_RETV(!strcmp(paSamples[0].pszName, "/tst/Counter"));
+    g_Counter.c = 43;
+    RTTESTI_CHECK(pau64[paSamples[0].iFirstValue] == 42);
+    RTTESTI_CHECK_RC(STAMR3BinSnapshotTake(pSnapshot, false /*fUpdateRing0*/), VINF_SUCCESS);
+    RTTESTI_CHECK(STAMR3BinSnapshotGetLayout(pSnapshot, &paSamples, &cSamples) == uLayout);
+    pau64 = STAMR3BinSnapshotGetValues(pSnapshot, &cValues, NULL);
+    RTTESTI_CHECK(pau64[paSamples[0].iFirstValue] == 43);
+
+    RTTESTI_CHECK_RC(STAMR3BinSnapshotDestroy(pSnapshot), VINF_SUCCESS);
+}
+
+
+static void tstExport(PUVM pUVM)
+{
+    RTTestISub("Export round trip");
+
+    char szFile[RTPATH_MAX];
+    RTTESTI_CHECK_RC_RETV(RTPathTemp(szFile, sizeof(szFile)), VINF_SUCCESS);
+    char szName[64];
+    RTStrPrintf(szName, sizeof(szName), "tstSTAMExport-%u.bin", RTProcSelf());
+    RTTESTI_CHECK_RC_RETV(RTPathAppend(szFile, sizeof(szFile), szName), VINF_SUCCESS);
+
+    g_Counter.c = 1000;
+    RTTESTI_CHECK_RC_RETV(STAMR3ExportStart(pUVM, szFile, "/tst/*", 10), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(STAMR3ExportStart(pUVM, szFile, "/tst/*", 10), VERR_ALREADY_EXISTS);
+    tstWaitForRecords(szFile, 2);
+
+    /* Value changes only. */
+    g_Counter.c   = 1001;
+    g_Ratio.u32B  = 40;
+    tstWaitForRecords(szFile, 2);
+
+    /* Layout change. */
+    g_u64Late = UINT64_C(0xfedcba9876543210);
+    RTTESTI_CHECK_RC(STAMR3RegisterU(pUVM, &g_u64Late, STAMTYPE_U64, STAMVISIBILITY_ALWAYS, "/tst/Late", STAMUNIT_BYTES, "Late."),
+                     VINF_SUCCESS);
+    tstWaitForRecords(szFile, 3);
+    g_Profile.cTicksMax = 250;
+    tstWaitForRecords(szFile, 2);
+
+    RTTESTI_CHECK_RC(STAMR3ExportStop(pUVM), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(STAMR3ExportStop(pUVM), VWRN_NOT_FOUND);
+
+    /*
+     * Read it back and compare with the current values.
+     */
+    void  *pvFile;
+    size_t cbFile;
+    RTTESTI_CHECK_RC_RETV(RTFileReadAll(szFile, &pvFile, &cbFile), VINF_SUCCESS);
+    TSTREADER Reader;
+    RT_ZERO(Reader);
+    tstReadStream(&Reader, (uint8_t const *)pvFile, cbFile);
+    RTFileReadAllFree(pvFile, cbFile);
+    RTFileDelete(szFile);
+
+    RTTESTI_CHECK(Reader.cLayouts == 2);
+    RTTESTI_CHECK(Reader.cValueRecords >= 4);
+    RTTESTI_CHECK(Reader.cSamples == 5);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/Counter", 0) == 1001);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/Profile", 0) == 2);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/Profile", 1) == 300);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/Profile", 2) == 100);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/Profile", 3) == 250);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/U32", 0) == 0x12345678);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/Ratio", 0) == 3);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/Ratio", 1) == 40);
+    RTTESTI_CHECK(tstReaderGetValue(&Reader, "/tst/Late", 0) == UINT64_C(0xfedcba9876543210));
+}
+
+
+int main()
+{
+    /*
+     * Init runtime.
+     */
+    RTTEST hTest;
+    RTEXITCODE rcExit = RTTestInitAndCreate("tstSTAMExport", &hTest);
+    if (rcExit != RTEXITCODE_SUCCESS)
+        return rcExit;
+    RTTestBanner(hTest);
+
+    /*
+     * A bare user mode VM structure is all STAM needs.
+     */
+    PUVM pUVM = (PUVM)RTMemPageAllocZ(RT_ALIGN_Z(sizeof(*pUVM), PAGE_SIZE));
+    RTTESTI_CHECK_RET(pUVM, RTTestSummaryAndDestroy(hTest));
+    pUVM->u32Magic = UVM_MAGIC;
+    RTTESTI_CHECK_RC_RET(STAMR3InitUVM(pUVM), VINF_SUCCESS, RTTestSummaryAndDestroy(hTest));
+
+    RTTESTI_CHECK_RC(STAMR3RegisterU(pUVM, &g_Counter, STAMTYPE_COUNTER, STAMVISIBILITY_ALWAYS, "/tst/Counter", STAMUNIT_OCCURENCES, "Counter."), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(STAMR3RegisterU(pUVM, &g_Profile, STAMTYPE_PROFILE, STAMVISIBILITY_ALWAYS, "/tst/Profile", STAMUNIT_TICKS_PER_CALL, "Profile."), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(STAMR3RegisterU(pUVM, &g_u32,     STAMTYPE_U32,     STAMVISIBILITY_ALWAYS, "/tst/U32",     STAMUNIT_COUNT, "U32."), VINF_SUCCESS);
+    RTTESTI_CHECK_RC(STAMR3RegisterU(pUVM, &g_Ratio,   STAMTYPE_RATIO_U32, STAMVISIBILITY_ALWAYS, "/tst/Ratio", STAMUNIT_PCT, "Ratio."), VINF_SUCCESS);
+
+    if (!RTTestErrorCount(hTest))
+    {
+        tstBinSnapshot(pUVM);
+        tstExport(pUVM);
+    }
+
+    STAMR3TermUVM(pUVM);
+    RTMemPageFree(pUVM, RT_ALIGN_Z(sizeof(*pUVM), PAGE_SIZE));
+
+    /*
+     * Summary.
+     */
+    return RTTestSummaryAndDestroy(hTest);
+}
@@ -22,6 +22,8 @@
 #include <VBox/vmm/vm.h>
 #include <VBox/vmm/vmm.h>
 #include <VBox/vmm/cpum.h>
+#include <VBox/vmm/iem.h>
+#include <VBox/vmm/pgm.h>
 #include <VBox/vmm/tm.h>
 #include <VBox/vmm/pdmapi.h>
 #include <VBox/err.h>
@@ -30,12 +32,15 @@
 #include <iprt/ctype.h>
 #include <iprt/getopt.h>
 #include <iprt/initterm.h>
+#include <iprt/mem.h>
 #include <iprt/message.h>
+#include <iprt/rand.h>
 #include <iprt/semaphore.h>
 #include <iprt/stream.h>
 #include <iprt/string.h>
 #include <iprt/test.h>
 #include <iprt/thread.h>
+#include <iprt/time.h>
 
 
 /*******************************************************************************
@@ -138,6 +143,271 @@ DECLCALLBACK(int) tstTMWorker(PVM pVM, RTTEST hTest)
 }
 
 
+/**
+ * Measures the set, stop and expire rates of TM timer queues of various
+ * sizes.
+ *
+ * This is called on EMT(0).
+ *
+ * @returns VINF_SUCCESS, test failure is reported via RTTEST.
+ * @param   pVM         Pointer to the VM.
+ * @param   hTest       The test handle.
+ */
+DECLCALLBACK(int) tstTMBenchWorker(PVM pVM, RTTEST hTest)
+{
+    static const uint32_t s_acTimers[] = { 16, 256, 1024, 4096 };
+    for (size_t iSize = 0; iSize < RT_ELEMENTS(s_acTimers); iSize++)
+    {
+        uint32_t const cTimers = s_acTimers[iSize];
+        uint32_t const cRounds = RT_MAX(65536 / cTimers, 4);
+        PTMTIMER *papTimers = (PTMTIMER *)RTMemAllocZ(sizeof(papTimers[0]) * cTimers);
+        RTTEST_CHECK_RET(hTest, papTimers != NULL, VERR_NO_MEMORY);
+
+        uint32_t i;
+        int      rc = VINF_SUCCESS;
+        for (i = 0; i < cTimers && RT_SUCCESS(rc); i++)
+            rc = TMR3TimerCreateInternal(pVM, TMCLOCK_VIRTUAL, tstTMDummyCallback, NULL, "bench timer", &papTimers[i]);
+        RTTEST_CHECK_MSG(hTest, RT_SUCCESS(rc), (hTest, "TMR3TimerCreateInternal: %Rrc\n", rc));
+
+        if (RT_SUCCESS(rc))
+        {
+            char szName[64];
+
+            /*
+             * Arm all timers (far enough out not to fire) in random order, then
+             * re-arm the active ones which moves them around in the queue.
+             */
+            uint64_t cNsSet = 0;
+            uint64_t cNsStop = 0;
+            for (uint32_t iRound = 0; iRound < cRounds; iRound++)
+            {
+                uint64_t cNsStart = RTTimeNanoTS();
+                for (i = 0; i < cTimers; i++)
+                    TMTimerSetMillies(papTimers[i], RTRandU32Ex(60000, 120000));
+                for (i = 0; i < cTimers; i++)
+                    TMTimerSetMillies(papTimers[i], RTRandU32Ex(60000, 120000));
+                cNsSet += RTTimeNanoTS() - cNsStart;
+
+                cNsStart = RTTimeNanoTS();
+                for (i = 0; i < cTimers; i++)
+                    TMTimerStop(papTimers[i]);
+                cNsStop += RTTimeNanoTS() - cNsStart;
+            }
+            RTStrPrintf(szName, sizeof(szName), "set, %u timers", cTimers);
+            RTTestValue(hTest, szName, cNsSet / ((uint64_t)cRounds * cTimers * 2), RTTESTUNIT_NS_PER_CALL);
+            RTStrPrintf(szName, sizeof(szName), "stop, %u timers", cTimers);
+            RTTestValue(hTest, szName, cNsStop / ((uint64_t)cRounds * cTimers), RTTESTUNIT_NS_PER_CALL);
+
+            /*
+             * Arm all timers so that they have expired already and let the queue
+             * run deliver them.
+             */
+            uint64_t cNsExpire = 0;
+            for (uint32_t iRound = 0; iRound < cRounds; iRound++)
+            {
+                uint64_t const u64Now = TMTimerGet(papTimers[0]);
+                for (i = 0; i < cTimers; i++)
+                    TMTimerSet(papTimers[i], u64Now - RTRandU32Ex(0, (uint32_t)RT_MIN(u64Now, 1000000)));
+
+                uint64_t const cNsStart = RTTimeNanoTS();
+                TMR3TimerQueuesDo(pVM);
+                cNsExpire += RTTimeNanoTS() - cNsStart;
+
+                for (i = 0; i < cTimers; i++)
+                    if (TMTimerIsActive(papTimers[i]))
+                    {
+                        RTTestFailed(hTest, "timer #%u of %u did not expire\n", i, cTimers);
+                        TMTimerStop(papTimers[i]);
+                    }
+            }
+            RTStrPrintf(szName, sizeof(szName), "expire, %u timers", cTimers);
+            RTTestValue(hTest, szName, cNsExpire / ((uint64_t)cRounds * cTimers), RTTESTUNIT_NS_PER_OCCURRENCE);
+        }
+
+        for (i = 0; i < cTimers; i++)
+            if (papTimers[i])
+                TMR3TimerDestroy(papTimers[i]);
+        RTMemFree(papTimers);
+    }
+
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Benchmarks IEMExecLots on a small real mode loop, with and without the
+ * decoded instruction cache.
+ *
+ * @returns VINF_SUCCESS, test failure is reported via RTTEST.
+ * @param   pVM         Pointer to the VM.
+ * @param   hTest       The test handle.
+ */
+DECLCALLBACK(int) tstIEMBenchWorker(PVM pVM, RTTEST hTest)
+{
+    /* 0000: inc ax; add bx, ax; xor cx, bx; dec dx; jmp 0000 */
+    static const uint8_t s_abLoop[] = { 0x40, 0x01, 0xc3, 0x31, 0xd9, 0x4a, 0xeb, 0xf8 };
+    uint32_t const  cInstrPerLoop = 5;
+    uint32_t const  cLoops        = 200000;
+    RTGCPHYS const  GCPhysCode    = 0x10000;
+
+    int rc = PGMPhysSimpleWriteGCPhys(pVM, GCPhysCode, s_abLoop, sizeof(s_abLoop));
+    RTTEST_CHECK_RC_OK_RET(hTest, rc, rc);
+
+    PVMCPU   pVCpu = VMMGetCpu(pVM);
+    PCPUMCTX pCtx  = CPUMQueryGuestCtxPtr(pVCpu);
+    for (unsigned iPass = 0; iPass < 2; iPass++)
+    {
+        bool const fFlush = iPass == 1;
+        pCtx->cs.Sel      = (RTSEL)(GCPhysCode >> 4);
+        pCtx->cs.ValidSel = pCtx->cs.Sel;
+        pCtx->cs.fFlags   = CPUMSELREG_FLAGS_VALID;
+        pCtx->cs.u64Base  = GCPhysCode;
+        pCtx->cs.u32Limit = 0xffff;
+        pCtx->rip         = 0;
+        IEMDecodeCacheFlush(pVCpu);
+
+        uint64_t const cNsStart = RTTimeNanoTS();
+        for (uint32_t i = 0; i < cLoops * cInstrPerLoop; i++)
+        {
+            if (fFlush)
+                IEMDecodeCacheFlush(pVCpu);
+            VBOXSTRICTRC rcStrict = IEMExecLots(pVCpu, 1, NULL);
+            if (rcStrict != VINF_SUCCESS)
+            {
+                RTTestFailed(hTest, "IEMExecLots returned %Rrc at %04x:%04RX64\n",
+                             VBOXSTRICTRC_VAL(rcStrict), pCtx->cs.Sel, pCtx->rip);
+                return VINF_SUCCESS;
+            }
+        }
+        uint64_t const cNsElapsed = RTTimeNanoTS() - cNsStart;
+        RTTEST_CHECK(hTest, pCtx->rip == 0);
+
+        RTTestValue(hTest, fFlush ? "IEMExecLots, no decode cache" : "IEMExecLots, decode cache",
+                    cNsElapsed / ((uint64_t)cLoops * cInstrPerLoop), RTTESTUNIT_NS_PER_OCCURRENCE);
+    }
+
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Runs the IEM external write test code on EMT(0).
+ *
+ * The code is a two instruction real mode loop at 1000:0000 which increments
+ * AX (opcode 0x40), the test replaces the first byte by a DEC AX (0x48) and
+ * back.
+ *
+ * @returns VINF_SUCCESS, test failure is reported via RTTEST.
+ * @param   pVM         Pointer to the VM.
+ * @param   hTest       The test handle.
+ * @param   fReset      Whether to load the code and reset the registers first.
+ * @param   cInstrs     The number of instructions to execute.
+ * @param   uExpectAx   The expected value of AX afterwards.
+ */
+DECLCALLBACK(int) tstIEMExtWriteWorker(PVM pVM, RTTEST hTest, bool fReset, uint32_t cInstrs, uint32_t uExpectAx)
+{
+    PVMCPU   pVCpu = VMMGetCpu(pVM);
+    PCPUMCTX pCtx  = CPUMQueryGuestCtxPtr(pVCpu);
+    if (fReset)
+    {
+        /* 0000: inc ax; jmp 0000 */
+        static const uint8_t s_abLoop[] = { 0x40, 0xeb, 0xfd };
+        int rc = PGMPhysSimpleWriteGCPhys(pVM, 0x10000, s_abLoop, sizeof(s_abLoop));
+        RTTEST_CHECK_RC_OK_RET(hTest, rc, rc);
+
+        pCtx->cs.Sel      = 0x1000;
+        pCtx->cs.ValidSel = pCtx->cs.Sel;
+        pCtx->cs.fFlags   = CPUMSELREG_FLAGS_VALID;
+        pCtx->cs.u64Base  = 0x10000;
+        pCtx->cs.u32Limit = 0xffff;
+        pCtx->rip         = 0;
+        pCtx->rax         = 0;
+        IEMDecodeCacheFlush(pVCpu);
+    }
+
+    for (uint32_t i = 0; i < cInstrs; i++)
+    {
+        VBOXSTRICTRC rcStrict = IEMExecLots(pVCpu, 1, NULL);
+        if (rcStrict != VINF_SUCCESS)
+        {
+            RTTestFailed(hTest, "IEMExecLots returned %Rrc at %04x:%04RX64\n",
+                         VBOXSTRICTRC_VAL(rcStrict), pCtx->cs.Sel, pCtx->rip);
+            return VINF_SUCCESS;
+        }
+    }
+    RTTEST_CHECK_MSG(hTest, pCtx->ax == uExpectAx, (hTest, "ax=%#x, expected %#x\n", pCtx->ax, uExpectAx));
+    return VINF_SUCCESS;
+}
+
+
+/** STAMR3Enum callback that fetches a STAMTYPE_U32 sample, see FNSTAMR3ENUM. */
+static DECLCALLBACK(int) tstVMMGetU32Enum(const char *pszName, STAMTYPE enmType, void *pvSample, STAMUNIT enmUnit,
+                                          STAMVISIBILITY enmVisiblity, const char *pszDesc, void *pvUser)
+{
+    NOREF(pszName); NOREF(enmUnit); NOREF(enmVisiblity); NOREF(pszDesc);
+    if (enmType == STAMTYPE_U32)
+        *(uint32_t *)pvUser = *(uint32_t volatile *)pvSample;
+    return VINF_SUCCESS;
+}
+
+
+/**
+ * Gets the decoded instruction cache misses of EMT(0).
+ */
+static uint32_t tstIEMGetCacheMisses(PUVM pUVM)
+{
+    uint32_t cMisses = 0;
+    STAMR3Enum(pUVM, "/IEM/CPU0/cDecodeCacheMisses", tstVMMGetU32Enum, &cMisses);
+    return cMisses;
+}
+
+
+/**
+ * Checks that code modified thru the external PGM APIs devices use for DMA
+ * isn't executed from stale IEM decoded instruction cache entries.
+ *
+ * Must be called on a thread other than the EMTs.
+ *
+ * @param   pUVM        The user mode VM handle.
+ * @param   pVM         Pointer to the VM.
+ * @param   hTest       The test handle.
+ */
+static void tstIEMExtWrite(PUVM pUVM, PVM pVM, RTTEST hTest)
+{
+    /* Warm up the cache, the second round must be served from it. */
+    int rc = VMR3ReqCallWaitU(pUVM, 0 /*idDstCpu*/, (PFNRT)tstIEMExtWriteWorker, 5, pVM, hTest, true, 4, 2);
+    RTTEST_CHECK_RC_OK_RETV(hTest, rc);
+    uint32_t cMisses = tstIEMGetCacheMisses(pUVM);
+    rc = VMR3ReqCallWaitU(pUVM, 0 /*idDstCpu*/, (PFNRT)tstIEMExtWriteWorker, 5, pVM, hTest, false, 2, 3);
+    RTTEST_CHECK_RC_OK_RETV(hTest, rc);
+    RTTEST_CHECK_MSG(hTest, tstIEMGetCacheMisses(pUVM) == cMisses,
+                     (hTest, "unmodified code missed the cache: %u -> %u\n", cMisses, tstIEMGetCacheMisses(pUVM)));
+
+    /* PGMR3PhysWriteExternal: inc ax -> dec ax. */
+    static uint8_t const s_bDecAx = 0x48;
+    cMisses = tstIEMGetCacheMisses(pUVM);
+    rc = PGMR3PhysWriteExternal(pVM, 0x10000, &s_bDecAx, sizeof(s_bDecAx), "tstVMM");
+    RTTEST_CHECK_RC_OK_RETV(hTest, rc);
+    rc = VMR3ReqCallWaitU(pUVM, 0 /*idDstCpu*/, (PFNRT)tstIEMExtWriteWorker, 5, pVM, hTest, false, 2, 2);
+    RTTEST_CHECK_RC_OK_RETV(hTest, rc);
+    RTTEST_CHECK_MSG(hTest, tstIEMGetCacheMisses(pUVM) > cMisses,
+                     (hTest, "PGMR3PhysWriteExternal: no decode cache miss\n"));
+
+    /* PGMR3PhysGCPhys2CCPtrExternal: dec ax -> inc ax. */
+    cMisses = tstIEMGetCacheMisses(pUVM);
+    PGMPAGEMAPLOCK Lock;
+    void          *pv;
+    rc = PGMR3PhysGCPhys2CCPtrExternal(pVM, 0x10000, &pv, &Lock);
+    RTTEST_CHECK_RC_OK_RETV(hTest, rc);
+    *(uint8_t volatile *)pv = 0x40;
+    PGMPhysReleasePageMappingLock(pVM, &Lock);
+    rc = VMR3ReqCallWaitU(pUVM, 0 /*idDstCpu*/, (PFNRT)tstIEMExtWriteWorker, 5, pVM, hTest, false, 2, 3);
+    RTTEST_CHECK_RC_OK_RETV(hTest, rc);
+    RTTEST_CHECK_MSG(hTest, tstIEMGetCacheMisses(pUVM) > cMisses,
+                     (hTest, "PGMR3PhysGCPhys2CCPtrExternal: no decode cache miss\n"));
+}
+
+
 /** PDMR3LdrEnumModules callback, see FNPDMR3ENUM. */
 static DECLCALLBACK(int)
 tstVMMLdrEnum(PVM pVM, const char *pszFilename, const char *pszName, RTUINTPTR ImageBase, size_t cbImage,
@@ -213,7 +483,7 @@ extern "C" DECLEXPORT(int) TrustedMain(int argc, char **argv, char **envp)
     };
     enum
     {
-        kTstVMMTest_VMM,  kTstVMMTest_TM, kTstVMMTest_MSRs
+        kTstVMMTest_VMM,  kTstVMMTest_TM, kTstVMMTest_TMBench, kTstVMMTest_IEMBench, kTstVMMTest_IEMExtWrite, kTstVMMTest_MSRs
     } enmTestOpt = kTstVMMTest_VMM;
 
     int ch;
@@ -233,6 +503,12 @@ extern "C" DECLEXPORT(int) TrustedMain(int argc, char **argv, char **envp)
                     enmTestOpt = kTstVMMTest_VMM;
                 else if (!strcmp("tm", ValueUnion.psz))
                     enmTestOpt = kTstVMMTest_TM;
+                else if (!strcmp("tm-bench", ValueUnion.psz))
+                    enmTestOpt = kTstVMMTest_TMBench;
+                else if (!strcmp("iem-bench", ValueUnion.psz))
+                    enmTestOpt = kTstVMMTest_IEMBench;
+                else if (!strcmp("iem-extwrite", ValueUnion.psz))
+                    enmTestOpt = kTstVMMTest_IEMExtWrite;
                 else if (!strcmp("msr", ValueUnion.psz) || !strcmp("msrs", ValueUnion.psz))
                     enmTestOpt = kTstVMMTest_MSRs;
                 else
@@ -243,7 +519,7 @@ extern "C" DECLEXPORT(int) TrustedMain(int argc, char **argv, char **envp)
                 break;
 
             case 'h':
-                RTPrintf("usage: tstVMM [--cpus|-c cpus] [--test <vmm|tm|msr>]\n");
+                RTPrintf("usage: tstVMM [--cpus|-c cpus] [--test <vmm|tm|tm-bench|iem-bench|iem-extwrite|msr>]\n");
                 return 1;
 
             case 'V':
@@ -300,6 +576,31 @@ extern "C" DECLEXPORT(int) TrustedMain(int argc, char **argv, char **envp)
                 break;
             }
 
+            case kTstVMMTest_TMBench:
+            {
+                RTTestSub(hTest, "TM benchmark");
+                rc = VMR3ReqCallWaitU(pUVM, 0 /*idDstCpu*/, (PFNRT)tstTMBenchWorker, 2, pVM, hTest);
+                if (RT_FAILURE(rc))
+                    RTTestFailed(hTest, "tstTMBenchWorker failed: rc=%Rrc\n", rc);
+                break;
+            }
+
+            case kTstVMMTest_IEMBench:
+            {
+                RTTestSub(hTest, "IEM benchmark");
+                rc = VMR3ReqCallWaitU(pUVM, 0 /*idDstCpu*/, (PFNRT)tstIEMBenchWorker, 2, pVM, hTest);
+                if (RT_FAILURE(rc))
+                    RTTestFailed(hTest, "tstIEMBenchWorker failed: rc=%Rrc\n", rc);
+                break;
+            }
+
+            case kTstVMMTest_IEMExtWrite:
+            {
+                RTTestSub(hTest, "IEM external writes");
+                tstIEMExtWrite(pUVM, pVM, hTest);
+                break;
+            }
+
             case kTstVMMTest_MSRs:
             {
                 RTTestSub(hTest, "MSRs");
@@ -231,6 +231,9 @@
     GEN_CHECK_SIZE(DBGFCPU);
     GEN_CHECK_OFF(DBGFCPU, iActiveBp);
     GEN_CHECK_OFF(DBGFCPU, fSingleSteppingRaw);
+    GEN_CHECK_OFF(DBGFCPU, pExitTraceR3);
+    GEN_CHECK_OFF(DBGFCPU, pExitTraceR0);
+    GEN_CHECK_OFF(DBGFCPU, pExitTraceRC);
     //GEN_CHECK_OFF(DBGFCPU, pGuestRegSet);
     //GEN_CHECK_OFF(DBGFCPU, pHyperRegSet);
 
@@ -265,6 +268,9 @@
     GEN_CHECK_OFF(IEMCPU, aBounceBuffers[1]);
     GEN_CHECK_OFF(IEMCPU, aMemBbMappings);
     GEN_CHECK_OFF(IEMCPU, aMemBbMappings[1]);
+    GEN_CHECK_OFF(IEMCPU, GCPhysDecodeFill);
+    GEN_CHECK_OFF(IEMCPU, aDecodeCache);
+    GEN_CHECK_OFF(IEMCPU, aDecodeCache[1]);
 
     GEN_CHECK_SIZE(IOM);
     GEN_CHECK_OFF(IOM, pTreesRC);
@@ -278,6 +284,14 @@
     GEN_CHECK_OFF(IOMCPU, pMMIORangeLastR0);
     GEN_CHECK_OFF(IOMCPU, pMMIOStatsLastR0);
     GEN_CHECK_OFF(IOMCPU, pMMIORangeLastRC);
+    GEN_CHECK_OFF(IOMCPU, apMMIORangeCacheR3);
+    GEN_CHECK_OFF(IOMCPU, apIOPortRangeCacheR3);
+    GEN_CHECK_OFF(IOMCPU, apMMIORangeCacheR0);
+    GEN_CHECK_OFF(IOMCPU, apIOPortRangeCacheR0);
+    GEN_CHECK_OFF(IOMCPU, apMMIORangeCacheRC);
+    GEN_CHECK_OFF(IOMCPU, apIOPortRangeCacheRC);
+    GEN_CHECK_OFF(IOMCPU, pMmioDecCacheR3);
+    GEN_CHECK_OFF(IOMCPU, pMmioDecCacheR0);
     GEN_CHECK_OFF(IOMCPU, pMMIOStatsLastRC);
     GEN_CHECK_OFF(IOMCPU, pRangeLastReadR0);
     GEN_CHECK_OFF(IOMCPU, pRangeLastReadRC);
@@ -464,6 +478,9 @@
     GEN_CHECK_OFF(PDMCPU, apQueuedCritSectRwShrdLeaves);
     GEN_CHECK_OFF(PDM, pQueueFlushR0);
     GEN_CHECK_OFF(PDM, pQueueFlushRC);
+    GEN_CHECK_OFF(PDM, paCritSectProfsR3);
+    GEN_CHECK_OFF(PDM, paCritSectProfsR0);
+    GEN_CHECK_OFF(PDM, paCritSectProfsRC);
     GEN_CHECK_OFF(PDM, StatQueuedCritSectLeaves);
 
     GEN_CHECK_SIZE(PDMDEVINSINT);
@@ -747,6 +764,8 @@
     GEN_CHECK_OFF(PGM, cWriteLockedPages);
     GEN_CHECK_OFF(PGM, cReadLockedPages);
     GEN_CHECK_OFF(PGM, cRelocations);
+    GEN_CHECK_OFF(PGM, uCodePageGenLast);
+    GEN_CHECK_OFF(PGM, aCodePageTags);
 #ifdef VBOX_WITH_STATISTICS
     GEN_CHECK_OFF(PGMCPU, pStatsR0);
     GEN_CHECK_OFF(PGMCPU, pStatsRC);
@@ -1090,6 +1109,7 @@
     GEN_CHECK_OFF(TMTIMER, offScheduleNext);
     GEN_CHECK_OFF(TMTIMER, offNext);
     GEN_CHECK_OFF(TMTIMER, offPrev);
+    GEN_CHECK_OFF(TMTIMER, ActiveCore);
     GEN_CHECK_OFF(TMTIMER, pVMR0);
     GEN_CHECK_OFF(TMTIMER, pVMR3);
     GEN_CHECK_OFF(TMTIMER, pVMRC);
@@ -1103,6 +1123,7 @@
     GEN_CHECK_OFF(TMTIMERQUEUE, offActive);
     GEN_CHECK_OFF(TMTIMERQUEUE, offSchedule);
     GEN_CHECK_OFF(TMTIMERQUEUE, enmClock);
+    GEN_CHECK_OFF(TMTIMERQUEUE, ActiveTree);
 
     GEN_CHECK_SIZE(TRPM); // has .mac
     GEN_CHECK_SIZE(TRPMCPU); // has .mac
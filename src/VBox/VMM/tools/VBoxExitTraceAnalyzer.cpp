@@ -0,0 +1,446 @@
+/* $Id: VBoxExitTraceAnalyzer.cpp $ */
+/** @file
+ * VBoxExitTraceAnalyzer - Summarizes exit trace dumps (DBGFR3ExitTraceDump).
+ */
+
+/*
+ * Copyright (C) 2013 Oracle Corporation
+ *
+ * This file is part of VirtualBox Open Source Edition (OSE), as
+ * available from http://www.virtualbox.org. This file is free software;
+ * you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License (GPL) as published by the Free Software
+ * Foundation, in version 2 as it comes in the "COPYING" file of the
+ * VirtualBox OSE distribution. VirtualBox OSE is distributed in the
+ * hope that it will be useful, but WITHOUT ANY WARRANTY of any kind.
+ */
+
+
+/*******************************************************************************
+*   Header Files                                                               *
+*******************************************************************************/
+#include <iprt/buildconfig.h>
+#include <iprt/file.h>
+#include <iprt/getopt.h>
+#include <iprt/initterm.h>
+#include <iprt/message.h>
+#include <iprt/mem.h>
+#include <iprt/sort.h>
+#include <iprt/string.h>
+#include <iprt/stream.h>
+
+#include <VBox/err.h>
+#include <VBox/vmm/dbgftrace.h>
+
+
+/*******************************************************************************
+*   Structures and Typedefs                                                    *
+*******************************************************************************/
+/**
+ * Aggregated statistics for one key (exit reason, address or handler).
+ */
+typedef struct EXITSTAT
+{
+    /** The key, see exitAnalyzeEntries. */
+    uint64_t        uKey;
+    /** Number of events. */
+    uint64_t        cEvents;
+    /** Number of write events (addresses and handlers only). */
+    uint64_t        cWrites;
+    /** Total ticks spent, including nested events. */
+    uint64_t        cTicksTotal;
+    /** Ticks spent excluding nested events. */
+    uint64_t        cTicksSelf;
+    /** Max ticks spent on a single event, including nested events. */
+    uint32_t        cTicksMax;
+    /** The handler (PDM tracing ID) of the first event (addresses only). */
+    uint32_t        idHandler;
+} EXITSTAT;
+/** Pointer to aggregated statistics. */
+typedef EXITSTAT *PEXITSTAT;
+
+
+/*******************************************************************************
+*   Global Variables                                                           *
+*******************************************************************************/
+/** Source names, indexed by DBGFEXITSRC. */
+static const char * const g_apszSrcs[DBGFEXITSRC_END] =
+{
+    "invalid", "vmx", "svm", "iem", "port-read", "port-write", "mmio-read", "mmio-write"
+};
+/** The number of hot addresses to list. */
+static uint32_t g_cTop = 16;
+/** The number of histogram rows to list (0 = all). */
+static uint32_t g_cMaxReasons = 0;
+
+
+/**
+ * @callback_method_impl{FNRTSORTCMP, Sorts EXITSTAT by key.}
+ */
+static DECLCALLBACK(int) exitAnalyzeCmpKey(void const *pvElement1, void const *pvElement2, void *pvUser)
+{
+    uint64_t const uKey1 = ((EXITSTAT const *)pvElement1)->uKey;
+    uint64_t const uKey2 = ((EXITSTAT const *)pvElement2)->uKey;
+    NOREF(pvUser);
+    return uKey1 < uKey2 ? -1 : uKey1 > uKey2 ? 1 : 0;
+}
+
+
+/**
+ * @callback_method_impl{FNRTSORTCMP, Sorts EXITSTAT by descending self time.}
+ */
+static DECLCALLBACK(int) exitAnalyzeCmpTicks(void const *pvElement1, void const *pvElement2, void *pvUser)
+{
+    uint64_t const cTicks1 = ((EXITSTAT const *)pvElement1)->cTicksSelf;
+    uint64_t const cTicks2 = ((EXITSTAT const *)pvElement2)->cTicksSelf;
+    NOREF(pvUser);
+    return cTicks1 > cTicks2 ? -1 : cTicks1 < cTicks2 ? 1 : 0;
+}
+
+
+/**
+ * Aggregates an array of single event records (cEvents == 1) in place.
+ *
+ * @returns The number of unique keys.
+ * @param   paStats     The records.
+ * @param   cStats      The number of records.
+ */
+static size_t exitAnalyzeAggregate(PEXITSTAT paStats, size_t cStats)
+{
+    if (!cStats)
+        return 0;
+    RTSort(paStats, cStats, sizeof(paStats[0]), exitAnalyzeCmpKey, NULL);
+
+    size_t iDst = 0;
+    for (size_t iSrc = 1; iSrc < cStats; iSrc++)
+    {
+        if (paStats[iSrc].uKey == paStats[iDst].uKey)
+        {
+            paStats[iDst].cEvents     += paStats[iSrc].cEvents;
+            paStats[iDst].cWrites     += paStats[iSrc].cWrites;
+            paStats[iDst].cTicksTotal += paStats[iSrc].cTicksTotal;
+            paStats[iDst].cTicksSelf  += paStats[iSrc].cTicksSelf;
+            paStats[iDst].cTicksMax    = RT_MAX(paStats[iDst].cTicksMax, paStats[iSrc].cTicksMax);
+        }
+        else
+            paStats[++iDst] = paStats[iSrc];
+    }
+    cStats = iDst + 1;
+
+    RTSort(paStats, cStats, sizeof(paStats[0]), exitAnalyzeCmpTicks, NULL);
+    return cStats;
+}
+
+
+/**
+ * Converts TSC ticks to nanoseconds.
+ */
+static uint64_t exitAnalyzeTicksToNs(uint64_t cTicks, uint64_t u64TscHz)
+{
+    if (!u64TscHz || u64TscHz == UINT64_MAX)
+        return 0;
+    return (uint64_t)((long double)cTicks * 1000000000 / u64TscHz);
+}
+
+
+/**
+ * Calculates the self time of the entries of one virtual CPU, i.e. the ticks
+ * not spent in events nested within them.
+ *
+ * The entries are recorded when the handling completes, so the events nested
+ * in an entry are the ones preceding it that started after it did.  Each of
+ * those has already claimed its own nested events, so popping them off a
+ * stack of unclaimed entries and subtracting their total time works out.
+ *
+ * @param   paEntries   The entries of the virtual CPU, in recording order.
+ * @param   cEntries    The number of entries.
+ * @param   pacSelf     Where to return the self ticks of each entry.
+ * @param   paiStack    Scratch buffer with room for @a cEntries indexes.
+ */
+static void exitAnalyzeSelfTicks(PCDBGFEXITTRACEENTRY paEntries, size_t cEntries, uint32_t *pacSelf, size_t *paiStack)
+{
+    size_t cStack = 0;
+    for (size_t i = 0; i < cEntries; i++)
+    {
+        uint32_t cSelf = paEntries[i].cTicks;
+        while (   cStack > 0
+               && paEntries[paiStack[cStack - 1]].u64Tsc >= paEntries[i].u64Tsc)
+        {
+            uint32_t const cChild = paEntries[paiStack[--cStack]].cTicks;
+            cSelf -= RT_MIN(cChild, cSelf);
+        }
+        pacSelf[i] = cSelf;
+        paiStack[cStack++] = i;
+    }
+}
+
+
+/**
+ * Analyzes the entries of one trace file and prints the reports.
+ *
+ * @returns RTEXITCODE.
+ * @param   pHdr        The file header.
+ * @param   paEntries   All the entries in the file.
+ * @param   pacSelf     The self ticks of each entry, see exitAnalyzeSelfTicks.
+ * @param   cEntries    The number of entries.
+ */
+static RTEXITCODE exitAnalyzeEntries(DBGFEXITTRACEFILEHDR const *pHdr, PCDBGFEXITTRACEENTRY paEntries,
+                                     uint32_t const *pacSelf, size_t cEntries)
+{
+    PEXITSTAT paReasons  = (PEXITSTAT)RTMemAllocZ(RT_MAX(cEntries, 1) * sizeof(EXITSTAT));
+    PEXITSTAT paAddrs    = (PEXITSTAT)RTMemAllocZ(RT_MAX(cEntries, 1) * sizeof(EXITSTAT));
+    PEXITSTAT paHandlers = (PEXITSTAT)RTMemAllocZ(RT_MAX(cEntries, 1) * sizeof(EXITSTAT));
+    if (!paReasons || !paAddrs || !paHandlers)
+    {
+        RTMemFree(paReasons);
+        RTMemFree(paAddrs);
+        RTMemFree(paHandlers);
+        return RTMsgErrorExit(RTEXITCODE_FAILURE, "Out of memory");
+    }
+
+    /*
+     * Collect.  The reason key is the source in the upper and the reason in the
+     * lower 32 bits, the address key is the address with bit 63 set for MMIO and
+     * the handler key is the PDM tracing ID of the device.
+     *
+     * The time percentages use the self time so that IOM accesses aren't
+     * counted a second time in the HM exit or IEM execution they happen in.
+     */
+    uint64_t cTicksAll  = 0;
+    size_t   cAddrs     = 0;
+    size_t   cHandlers  = 0;
+    for (size_t i = 0; i < cEntries; i++)
+    {
+        PCDBGFEXITTRACEENTRY pEntry = &paEntries[i];
+        uint8_t const        enmSrc = pEntry->enmSrc;
+        paReasons[i].uKey        = ((uint64_t)enmSrc << 32) | pEntry->uReason;
+        paReasons[i].cEvents     = 1;
+        paReasons[i].cTicksTotal = pEntry->cTicks;
+        paReasons[i].cTicksSelf  = pacSelf[i];
+        paReasons[i].cTicksMax   = pEntry->cTicks;
+        cTicksAll += pacSelf[i];
+
+        if (enmSrc >= DBGFEXITSRC_IOM_PORT_READ && enmSrc <= DBGFEXITSRC_IOM_MMIO_WRITE)
+        {
+            bool const fMmio  = enmSrc >= DBGFEXITSRC_IOM_MMIO_READ;
+            bool const fWrite = enmSrc == DBGFEXITSRC_IOM_PORT_WRITE || enmSrc == DBGFEXITSRC_IOM_MMIO_WRITE;
+            paAddrs[cAddrs].uKey        = (fMmio ? RT_BIT_64(63) : 0) | (pEntry->uAddr & ~RT_BIT_64(63));
+            paAddrs[cAddrs].cEvents     = 1;
+            paAddrs[cAddrs].cWrites     = fWrite;
+            paAddrs[cAddrs].cTicksTotal = pEntry->cTicks;
+            paAddrs[cAddrs].cTicksSelf  = pacSelf[i];
+            paAddrs[cAddrs].cTicksMax   = pEntry->cTicks;
+            paAddrs[cAddrs].idHandler   = pEntry->idHandler;
+            cAddrs++;
+
+            paHandlers[cHandlers].uKey        = pEntry->idHandler;
+            paHandlers[cHandlers].cEvents     = 1;
+            paHandlers[cHandlers].cWrites     = fWrite;
+            paHandlers[cHandlers].cTicksTotal = pEntry->cTicks;
+            paHandlers[cHandlers].cTicksSelf  = pacSelf[i];
+            paHandlers[cHandlers].cTicksMax   = pEntry->cTicks;
+            cHandlers++;
+        }
+    }
+    size_t const cReasons = exitAnalyzeAggregate(paReasons, cEntries);
+    cAddrs    = exitAnalyzeAggregate(paAddrs, cAddrs);
+    cHandlers = exitAnalyzeAggregate(paHandlers, cHandlers);
+
+    /*
+     * Exit histogram.  time% excludes nested events, avg and max include them.
+     */
+    RTPrintf("\nExit histogram (%zu events, %'llu ns total):\n", cEntries, exitAnalyzeTicksToNs(cTicksAll, pHdr->u64TscHz));
+    RTPrintf("  %-10s %8s %12s %6s %12s %12s %12s\n", "source", "reason", "count", "time%", "self-ns", "avg-ns", "max-ns");
+    for (size_t i = 0; i < cReasons && (!g_cMaxReasons || i < g_cMaxReasons); i++)
+    {
+        uint32_t const enmSrc = (uint32_t)(paReasons[i].uKey >> 32);
+        RTPrintf("  %-10s %#8x %'12llu %5u%% %'12llu %'12llu %'12llu\n",
+                 enmSrc < RT_ELEMENTS(g_apszSrcs) ? g_apszSrcs[enmSrc] : "???",
+                 (uint32_t)paReasons[i].uKey,
+                 paReasons[i].cEvents,
+                 cTicksAll ? (unsigned)(paReasons[i].cTicksSelf * 100 / cTicksAll) : 0,
+                 exitAnalyzeTicksToNs(paReasons[i].cTicksSelf, pHdr->u64TscHz),
+                 exitAnalyzeTicksToNs(paReasons[i].cTicksTotal / paReasons[i].cEvents, pHdr->u64TscHz),
+                 exitAnalyzeTicksToNs(paReasons[i].cTicksMax, pHdr->u64TscHz));
+    }
+
+    /*
+     * Hot MMIO and I/O port addresses.
+     */
+    for (unsigned iPass = 0; iPass < 2; iPass++)
+    {
+        bool const fMmio = iPass == 0;
+        RTPrintf("\nTop %u %s addresses:\n", g_cTop, fMmio ? "MMIO" : "I/O port");
+        RTPrintf("  %-18s %5s %12s %12s %12s %12s\n", "address", "dev", "count", "writes", "total-ns", "avg-ns");
+        uint32_t cPrinted = 0;
+        for (size_t i = 0; i < cAddrs && cPrinted < g_cTop; i++)
+            if (RT_BOOL(paAddrs[i].uKey & RT_BIT_64(63)) == fMmio)
+            {
+                RTPrintf("  %#018llx %05u %'12llu %'12llu %'12llu %'12llu\n",
+                         paAddrs[i].uKey & ~RT_BIT_64(63),
+                         paAddrs[i].idHandler,
+                         paAddrs[i].cEvents,
+                         paAddrs[i].cWrites,
+                         exitAnalyzeTicksToNs(paAddrs[i].cTicksTotal, pHdr->u64TscHz),
+                         exitAnalyzeTicksToNs(paAddrs[i].cTicksTotal / paAddrs[i].cEvents, pHdr->u64TscHz));
+                cPrinted++;
+            }
+        if (!cPrinted)
+            RTPrintf("  none\n");
+    }
+
+    /*
+     * Devices handling the accesses.
+     */
+    RTPrintf("\nTop %u devices (PDM tracing IDs, see 'info pdmtracingids'):\n", g_cTop);
+    RTPrintf("  %-5s %12s %12s %12s %12s\n", "dev", "count", "writes", "total-ns", "avg-ns");
+    for (size_t i = 0; i < cHandlers && i < g_cTop; i++)
+        RTPrintf("  %05u %'12llu %'12llu %'12llu %'12llu\n",
+                 (uint32_t)paHandlers[i].uKey,
+                 paHandlers[i].cEvents,
+                 paHandlers[i].cWrites,
+                 exitAnalyzeTicksToNs(paHandlers[i].cTicksTotal, pHdr->u64TscHz),
+                 exitAnalyzeTicksToNs(paHandlers[i].cTicksTotal / paHandlers[i].cEvents, pHdr->u64TscHz));
+    if (!cHandlers)
+        RTPrintf("  none\n");
+
+    RTMemFree(paReasons);
+    RTMemFree(paAddrs);
+    RTMemFree(paHandlers);
+    return RTEXITCODE_SUCCESS;
+}
+
+
+/**
+ * Loads and analyzes one exit trace file.
+ *
+ * @returns RTEXITCODE.
+ * @param   pszFilename     The file.
+ */
+static RTEXITCODE exitAnalyzeFile(const char *pszFilename)
+{
+    void   *pvFile;
+    size_t  cbFile;
+    int rc = RTFileReadAll(pszFilename, &pvFile, &cbFile);
+    if (RT_FAILURE(rc))
+        return RTMsgErrorExit(RTEXITCODE_FAILURE, "Failed to read '%s': %Rrc", pszFilename, rc);
+
+    /*
+     * Validate the header and CPU records and gather the entries into one
+     * contiguous array (they're stored that way apart from the CPU records).
+     * The self time is worked out per CPU as nesting doesn't cross CPUs.
+     */
+    RTEXITCODE rcExit = RTEXITCODE_SUCCESS;
+    DBGFEXITTRACEFILEHDR const *pHdr = (DBGFEXITTRACEFILEHDR const *)pvFile;
+    if (   cbFile < sizeof(*pHdr)
+        || pHdr->u32Magic   != DBGFEXITTRACEFILEHDR_MAGIC
+        || pHdr->u32Version != DBGFEXITTRACEFILEHDR_VERSION
+        || pHdr->cbEntry    != sizeof(DBGFEXITTRACEENTRY))
+        rcExit = RTMsgErrorExit(RTEXITCODE_FAILURE, "'%s' is not a supported exit trace file", pszFilename);
+    else
+    {
+        RTPrintf("%s: VM '%.*s', %u CPUs, TSC %'llu Hz\n", pszFilename, (int)sizeof(pHdr->szName), pHdr->szName,
+                 pHdr->cCpus, pHdr->u64TscHz);
+
+        size_t const        cMaxEntries = cbFile / sizeof(DBGFEXITTRACEENTRY) + 1;
+        size_t              cEntries    = 0;
+        PDBGFEXITTRACEENTRY paEntries   = (PDBGFEXITTRACEENTRY)RTMemAlloc(cMaxEntries * sizeof(DBGFEXITTRACEENTRY));
+        uint32_t           *pacSelf     = (uint32_t *)RTMemAlloc(cMaxEntries * sizeof(uint32_t));
+        size_t             *paiStack    = (size_t *)RTMemAlloc(cMaxEntries * sizeof(size_t));
+        size_t              off         = sizeof(*pHdr);
+        if (!paEntries || !pacSelf || !paiStack)
+        {
+            RTMemFree(paEntries);
+            paEntries = NULL;
+        }
+        for (uint32_t iCpu = 0; iCpu < pHdr->cCpus && paEntries; iCpu++)
+        {
+            DBGFEXITTRACEFILECPU const *pCpu = (DBGFEXITTRACEFILECPU const *)((uint8_t const *)pvFile + off);
+            if (   off + sizeof(*pCpu) > cbFile
+                || (cbFile - off - sizeof(*pCpu)) / sizeof(DBGFEXITTRACEENTRY) < pCpu->cEntries)
+            {
+                rcExit = RTMsgErrorExit(RTEXITCODE_FAILURE, "'%s' is truncated", pszFilename);
+                break;
+            }
+            RTPrintf("  VCPU %u: %'u entries, %'llu lost\n", pCpu->idCpu, pCpu->cEntries, pCpu->cLost);
+            off += sizeof(*pCpu);
+            memcpy(&paEntries[cEntries], (uint8_t const *)pvFile + off, pCpu->cEntries * sizeof(DBGFEXITTRACEENTRY));
+            exitAnalyzeSelfTicks(&paEntries[cEntries], pCpu->cEntries, &pacSelf[cEntries], paiStack);
+            cEntries += pCpu->cEntries;
+            off += pCpu->cEntries * sizeof(DBGFEXITTRACEENTRY);
+        }
+        if (!paEntries)
+            rcExit = RTMsgErrorExit(RTEXITCODE_FAILURE, "Out of memory");
+        else if (rcExit == RTEXITCODE_SUCCESS)
+            rcExit = exitAnalyzeEntries(pHdr, paEntries, pacSelf, cEntries);
+        RTMemFree(paEntries);
+        RTMemFree(pacSelf);
+        RTMemFree(paiStack);
+    }
+
+    RTFileReadAllFree(pvFile, cbFile);
+    return rcExit;
+}
+
+
+int main(int argc, char **argv)
+{
+    int rc = RTR3InitExe(argc, &argv, 0 /*fFlags*/);
+    if (RT_FAILURE(rc))
+        return RTMsgInitFailure(rc);
+
+    static const RTGETOPTDEF s_aOptions[] =
+    {
+        { "--top",      't', RTGETOPT_REQ_UINT32 },
+        { "--reasons",  'r', RTGETOPT_REQ_UINT32 },
+    };
+    RTGETOPTSTATE State;
+    RTGetOptInit(&State, argc, argv, &s_aOptions[0], RT_ELEMENTS(s_aOptions), 1, 0 /*fFlags*/);
+
+    RTEXITCODE      rcExit = RTEXITCODE_SUCCESS;
+    unsigned        cFiles = 0;
+    int             iOpt;
+    RTGETOPTUNION   ValueUnion;
+    while ((iOpt = RTGetOpt(&State, &ValueUnion)) != 0)
+    {
+        switch (iOpt)
+        {
+            case 't':
+                g_cTop = ValueUnion.u32;
+                break;
+
+            case 'r':
+                g_cMaxReasons = ValueUnion.u32;
+                break;
+
+            case VINF_GETOPT_NOT_OPTION:
+            {
+                if (cFiles++)
+                    RTPrintf("\n");
+                RTEXITCODE rcExit2 = exitAnalyzeFile(ValueUnion.psz);
+                if (rcExit2 != RTEXITCODE_SUCCESS)
+                    rcExit = rcExit2;
+                break;
+            }
+
+            case 'h':
+                RTPrintf("Usage: VBoxExitTraceAnalyzer [-t|--top <n>] [-r|--reasons <n>] <trace-file> [..]\n"
+                         "Summarizes exit trace dumps: exit histograms and the hottest MMIO and I/O port\n"
+                         "addresses and devices per VM.  The time%% column excludes the time spent in\n"
+                         "nested events, e.g. the MMIO accesses made while handling a VM exit.  The dumps\n"
+                         "are produced by DBGFR3ExitTraceDump, see the /DBGF/ExitTrace/DumpFile setting.\n");
+                return RTEXITCODE_SUCCESS;
+
+            case 'V':
+                RTPrintf("%sr%s\n", RTBldCfgVersion(), RTBldCfgRevisionStr());
+                return RTEXITCODE_SUCCESS;
+
+            default:
+                return RTGetOptPrintError(iOpt, &ValueUnion);
+        }
+    }
+    if (!cFiles)
+        return RTMsgErrorExit(RTEXITCODE_SYNTAX, "No trace files given, try --help");
+    return rcExit;
+}
+